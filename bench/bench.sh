@@ -4,6 +4,7 @@
 # Usage: sh bench/bench.sh
 #        RUNTIME=lua sh bench/bench.sh   # benchmark Lua only
 #        RUNTIME=js  sh bench/bench.sh   # benchmark JS only
+#        HULL_ALLOC=pool sh bench/bench.sh  # size-class pool allocator
 #
 # Requires: build/hull already built, wrk and curl available
 #
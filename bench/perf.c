@@ -0,0 +1,1198 @@
+/*
+ * perf.c — Micro-benchmark regression suite (make perf)
+ *
+ * Runs a fixed set of deterministic hot-path benchmarks, reports
+ * instructions and wall time per iteration, and compares them against
+ * a checked-in baseline (bench/perf_baseline.json). Exits 1 when a
+ * benchmark got slower than the threshold allows.
+ *
+ * Instruction counts come from perf_event_open (user space only) and
+ * are the gated metric: they are stable across runs on one toolchain,
+ * unlike wall time. Where the counter is unavailable (non-Linux,
+ * perf_event_paranoid > 2, some containers) only wall time is compared,
+ * and it gates only when --wall-threshold is given: wall time moves
+ * with the machine and its load. A baseline recorded with a different
+ * compiler or architecture is reported but not enforced.
+ *
+ * The Lua and JS benchmarks load bench/perf/app.{lua,js} the way
+ * hull bench does: migrated :memory: database, routes wired into a
+ * standalone KlRouter, requests dispatched in-process.
+ *
+ * Usage: build/perf [--baseline FILE] [--write FILE] [--threshold PCT]
+ *                   [--wall-threshold PCT] [--only NAME] [app_dir]
+ *
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#include "hull/cap/audit.h"
+#include "hull/cap/crypto.h"
+#include "hull/cap/db.h"
+#include "hull/cap/test.h"
+#include "hull/log_sink.h"
+#include "hull/migrate.h"
+#include "hull/signature.h"
+#include "hull/vfs.h"
+
+#ifdef HL_ENABLE_LUA
+#include "hull/alloc.h"
+#include "hull/runtime/lua.h"
+#include "lauxlib.h"
+#include "lua.h"
+#include "lualib.h"
+#endif
+
+#ifdef HL_ENABLE_JS
+#include "hull/runtime/js.h"
+#include "quickjs.h"
+#endif
+
+#include <keel/allocator.h>
+#include <keel/router.h>
+
+#include <log.h>
+#include <sh_arena.h>
+#include <sh_json.h>
+#include <sqlite3.h>
+
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/utsname.h>
+#include <time.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#endif
+
+#define PERF_REPS          5
+#define PERF_MAX_BENCH     32
+
+#ifndef __VERSION__
+#define __VERSION__ "unknown"
+#endif
+
+/* ── Instruction counter ───────────────────────────────────────────── */
+
+static int counter_fd = -1;
+static uint64_t counter_base;
+
+static void counter_open(void)
+{
+#ifdef __linux__
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.size = sizeof(attr);
+    attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.inherit = 1;   /* count worker threads (sha256_many) too */
+    counter_fd = (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+#endif
+}
+
+/* RESET does not clear counts folded in from exited threads, so
+ * counter_stop() reports the delta from a read taken here. */
+static void counter_start(void)
+{
+#ifdef __linux__
+    if (counter_fd >= 0) {
+        ioctl(counter_fd, PERF_EVENT_IOC_RESET, 0);
+        if (read(counter_fd, &counter_base, sizeof(counter_base)) !=
+            (ssize_t)sizeof(counter_base))
+            counter_base = 0;
+        ioctl(counter_fd, PERF_EVENT_IOC_ENABLE, 0);
+    }
+#endif
+}
+
+/* Instructions since counter_start(), 0 without a counter */
+static uint64_t counter_stop(void)
+{
+    uint64_t n = 0;
+#ifdef __linux__
+    if (counter_fd >= 0) {
+        ioctl(counter_fd, PERF_EVENT_IOC_DISABLE, 0);
+        if (read(counter_fd, &n, sizeof(n)) != (ssize_t)sizeof(n) ||
+            n < counter_base)
+            n = 0;
+        else
+            n -= counter_base;
+    }
+#endif
+    return n;
+}
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+/* ── Benchmark table ───────────────────────────────────────────────── */
+
+typedef int (*PerfFn)(void *ctx);
+
+typedef struct {
+    const char *name;
+    PerfFn      fn;
+    void       *ctx;
+    int         iters;
+    double      instructions;   /* per iteration, best of PERF_REPS */
+    double      ns;             /* per iteration, best of PERF_REPS */
+    int         failed;
+} PerfBench;
+
+static PerfBench benches[PERF_MAX_BENCH];
+static int num_benches;
+static const char *only;
+
+static void add_bench(const char *name, PerfFn fn, void *ctx, int iters)
+{
+    if (num_benches >= PERF_MAX_BENCH)
+        return;
+    if (only && strcmp(only, name) != 0)
+        return;
+    PerfBench *b = &benches[num_benches++];
+    memset(b, 0, sizeof(*b));
+    b->name = name;
+    b->fn = fn;
+    b->ctx = ctx;
+    b->iters = iters;
+}
+
+/* One warmup pass, then PERF_REPS measured passes; keep the minimum */
+static void run_bench(PerfBench *b)
+{
+    int warm = b->iters / 10 > 0 ? b->iters / 10 : 1;
+    for (int i = 0; i < warm; i++) {
+        if (b->fn(b->ctx) != 0) {
+            b->failed = 1;
+            return;
+        }
+    }
+
+    for (int r = 0; r < PERF_REPS; r++) {
+        uint64_t t0 = now_ns();
+        counter_start();
+        for (int i = 0; i < b->iters; i++)
+            b->fn(b->ctx);
+        uint64_t instr = counter_stop();
+        uint64_t t1 = now_ns();
+
+        double ins = (double)instr / b->iters;
+        double ns = (double)(t1 - t0) / b->iters;
+        if (r == 0 || ins < b->instructions)
+            b->instructions = ins;
+        if (r == 0 || ns < b->ns)
+            b->ns = ns;
+    }
+}
+
+/* ── Native benchmarks ─────────────────────────────────────────────── */
+
+static void noop_handler(KlRequest *req, KlResponse *res, void *user_data)
+{
+    (void)req;
+    (void)res;
+    (void)user_data;
+}
+
+static const char *const route_patterns[] = {
+    "/", "/health", "/login", "/logout", "/signup", "/dashboard",
+    "/api/items", "/api/items/:id", "/api/items/:id/tags",
+    "/api/items/:id/tags/:tag", "/api/users", "/api/users/:id",
+    "/api/users/:id/orders", "/api/orders/:id", "/api/search",
+    "/static/app.css", "/static/app.js", "/webhooks/:provider",
+    "/admin", "/admin/users/:id",
+};
+
+static const char *const route_probes[] = {
+    "/health", "/api/items/42", "/api/items/42/tags/red",
+    "/api/users/7/orders", "/webhooks/stripe", "/missing/path",
+};
+
+typedef struct {
+    KlAllocator alloc;
+    KlRouter    router;
+    size_t      next;
+} RouterCtx;
+
+static int bench_router_match(void *ctx)
+{
+    RouterCtx *rc = ctx;
+    const char *path = route_probes[rc->next++ % (sizeof(route_probes) /
+                                                  sizeof(route_probes[0]))];
+    KlRoute *matched = NULL;
+    KlParam params[KL_MAX_PARAMS];
+    int num_params = 0;
+    kl_router_match(&rc->router, "GET", 3, path, strlen(path),
+                    &matched, params, &num_params);
+    return 0;
+}
+
+static int bench_hmac(void *ctx)
+{
+    static const uint8_t key[32] = { 1, 2, 3, 4, 5, 6, 7, 8 };
+    uint8_t mac[32];
+    return hl_cap_crypto_hmac_sha256(key, sizeof(key), ctx, 1024, mac);
+}
+
+typedef struct {
+    HlVfs       vfs;
+    const char *names[4];
+    size_t      next;
+} StaticCtx;
+
+static int bench_static_lookup(void *ctx)
+{
+    StaticCtx *sc = ctx;
+    return hl_vfs_find(&sc->vfs, sc->names[sc->next++ % 4]) ? 0 : -1;
+}
+
+/* PBKDF2-HMAC-SHA256, one 32-byte block, 100,000 iterations (the floor) */
+enum { PBKDF2_ITERS = 100000 };
+
+static const uint8_t pbkdf2_salt[16] = { 1, 2, 3, 4 };
+
+static int bench_pbkdf2(void *ctx)
+{
+    uint8_t *out = ctx;
+    return hl_cap_crypto_pbkdf2("hunter2", 7, pbkdf2_salt,
+                                sizeof(pbkdf2_salt), PBKDF2_ITERS, out, 32);
+}
+
+/* The pre-midstate loop: a full HMAC (both pads rehashed) per iteration */
+static int pbkdf2_hmac_loop(uint8_t out[32])
+{
+    const uint8_t *pw = (const uint8_t *)"hunter2";
+    uint8_t msg[sizeof(pbkdf2_salt) + 4];
+    uint8_t u[32], next[32];
+    memcpy(msg, pbkdf2_salt, sizeof(pbkdf2_salt));
+    memcpy(msg + sizeof(pbkdf2_salt), "\0\0\0\1", 4);
+    if (hl_cap_crypto_hmac_sha256(pw, 7, msg, sizeof(msg), u) != 0)
+        return -1;
+    memcpy(out, u, 32);
+    for (int i = 1; i < PBKDF2_ITERS; i++) {
+        if (hl_cap_crypto_hmac_sha256(pw, 7, u, 32, next) != 0)
+            return -1;
+        memcpy(u, next, 32);
+        for (int j = 0; j < 32; j++)
+            out[j] ^= u[j];
+    }
+    return 0;
+}
+
+static int bench_pbkdf2_hmac_loop(void *ctx)
+{
+    return pbkdf2_hmac_loop(ctx);
+}
+
+/*
+ * Audit events as the request path sees them, AUDIT_BATCH db.query
+ * events per iteration. Output goes to /dev/null so only Hull's own
+ * cost is measured. audit_sync must run before audit_ring: once the
+ * ring is started, events no longer take the synchronous path.
+ */
+enum { AUDIT_BATCH = 100 };
+
+typedef struct {
+    int devnull;
+    int saved_stderr;
+    int ring_started;
+} AuditCtx;
+
+static void audit_emit_batch(void)
+{
+    static const char sql[] = "SELECT id, name, email FROM users WHERE id = ?";
+    hl_audit_enabled = 1;
+    for (int i = 0; i < AUDIT_BATCH; i++) {
+        ShJsonWriter w = hl_audit_begin("db.query");
+        sh_json_write_key(&w, "sql");
+        sh_json_write_string_n(&w, sql, sizeof(sql) - 1);
+        sh_json_write_kv_int(&w, "nparams", 1);
+        sh_json_write_kv_int(&w, "result", i);
+        hl_audit_end(&w);
+    }
+    hl_audit_enabled = 0;
+}
+
+/* Formatted and written to stderr, one write per event */
+static int bench_audit_sync(void *ctx)
+{
+    AuditCtx *ac = ctx;
+    if (ac->ring_started)
+        return -1;
+    dup2(ac->devnull, STDERR_FILENO);
+    audit_emit_batch();
+    fflush(stderr);
+    dup2(ac->saved_stderr, STDERR_FILENO);
+    return 0;
+}
+
+/* Claimed in the lock-free ring and written out by the drain thread */
+static int bench_audit_ring(void *ctx)
+{
+    AuditCtx *ac = ctx;
+    if (!ac->ring_started) {
+        if (hl_audit_start("/dev/null", 0) != 0)
+            return -1;
+        ac->ring_started = 1;
+    }
+    audit_emit_batch();
+    return 0;
+}
+
+/*
+ * One access-log-shaped log_info() line per iteration, to /dev/null:
+ * the previous main.c callback (vsnprintf + strftime + fprintf) vs. the
+ * buffered sink and its flusher thread. log.c keeps callbacks forever,
+ * so one is registered and switched per benchmark; off otherwise.
+ */
+typedef enum { LOG_BENCH_OFF = 0, LOG_BENCH_FPRINTF, LOG_BENCH_SINK } LogBenchMode;
+
+typedef struct {
+    LogBenchMode mode;
+    FILE        *fp;
+    int          devnull;
+    int          sink_started;
+} LogCtx;
+
+static LogCtx log_ctx;
+
+static void perf_log_callback(log_Event *ev)
+{
+    if (log_ctx.mode == LOG_BENCH_SINK) {
+        hl_log_sink_callback(ev);
+    } else if (log_ctx.mode == LOG_BENCH_FPRINTF) {
+        char ts[16];
+        ts[strftime(ts, sizeof(ts), "%H:%M:%S", ev->time)] = '\0';
+        char msg[1024];
+        vsnprintf(msg, sizeof(msg), ev->fmt, ev->ap);
+        fprintf(log_ctx.fp, "%s %-5s %s\n",
+                ts, log_level_string(ev->level), msg);
+    }
+}
+
+static void log_bench_line(LogBenchMode mode)
+{
+    static int n;
+    log_ctx.mode = mode;
+    log_info("[app] req method=GET path=/tasks/%d req_id=%x body_in=0", n, n);
+    log_ctx.mode = LOG_BENCH_OFF;
+    n++;
+}
+
+static int bench_log_fprintf(void *ctx)
+{
+    (void)ctx;
+    log_bench_line(LOG_BENCH_FPRINTF);
+    return 0;
+}
+
+static int bench_log_sink(void *ctx)
+{
+    (void)ctx;
+    if (!log_ctx.sink_started) {
+        if (hl_log_sink_start(log_ctx.devnull, HL_LOG_BLOCK) != 0)
+            return -1;
+        log_ctx.sink_started = 1;
+    }
+    log_bench_line(LOG_BENCH_SINK);
+    return 0;
+}
+
+/* A 5,000-file app (1-16 KB per file, ~43 MB) held in memory */
+enum { SIG_FILES = 5000 };
+
+typedef struct {
+    HlSignature    sig;
+    HlVfs          vfs;
+    HlEntry       *entries;
+    unsigned char *bodies;
+    char         (*names)[32];
+    char         (*hashes)[65];
+} SigCtx;
+
+static void sig_teardown(SigCtx *sc)
+{
+    free(sc->sig.entries);
+    free(sc->hashes);
+    free(sc->names);
+    free(sc->entries);
+    free(sc->bodies);
+}
+
+static int sig_setup(SigCtx *sc)
+{
+    memset(sc, 0, sizeof(*sc));
+    sc->bodies = malloc((size_t)SIG_FILES * 16 * 1024);
+    sc->entries = calloc(SIG_FILES + 1, sizeof(HlEntry));
+    sc->names = malloc(SIG_FILES * sizeof(*sc->names));
+    sc->hashes = malloc(SIG_FILES * sizeof(*sc->hashes));
+    sc->sig.entries = calloc(SIG_FILES, sizeof(HlSigFileEntry));
+    if (!sc->bodies || !sc->entries || !sc->names || !sc->hashes ||
+        !sc->sig.entries) {
+        sig_teardown(sc);
+        return -1;
+    }
+
+    for (int i = 0; i < SIG_FILES; i++) {
+        unsigned char *body = sc->bodies + (size_t)i * 16 * 1024;
+        size_t len = 1024 + (size_t)(i * 7919) % (15 * 1024);
+        for (size_t j = 0; j < len; j++)
+            body[j] = (unsigned char)(i + j * 31);
+
+        uint8_t hash[32];
+        hl_cap_crypto_sha256(body, len, hash);
+        for (int j = 0; j < 32; j++)
+            snprintf(sc->hashes[i] + j * 2, 3, "%02x", hash[j]);
+
+        /* VFS name "./static/f00000.css"; the signature drops the "./" */
+        snprintf(sc->names[i], sizeof(sc->names[i]), "./static/f%05d.css", i);
+        sc->entries[i].name = sc->names[i];
+        sc->entries[i].data = body;
+        sc->entries[i].len = (unsigned int)len;
+        sc->sig.entries[i].name = sc->names[i] + 2;
+        sc->sig.entries[i].hash_hex = sc->hashes[i];
+    }
+    sc->sig.entry_count = SIG_FILES;
+    hl_vfs_init(&sc->vfs, sc->entries, NULL);
+    return 0;
+}
+
+static int bench_sig_verify(void *ctx)
+{
+    SigCtx *sc = ctx;
+    return hl_sig_verify_files_embedded(&sc->sig, &sc->vfs);
+}
+
+/* ── Runtime environment ───────────────────────────────────────────── */
+
+typedef struct {
+    sqlite3     *db;
+    HlStmtCache  stmt_cache;
+    HlVfs        app_vfs;
+    HlVfs        platform_vfs;
+    KlAllocator  alloc;
+    KlRouter     router;
+} PerfEnv;
+
+extern const HlEntry hl_app_entries[];
+extern const HlEntry hl_stdlib_entries[];
+
+static int env_open(PerfEnv *env, const char *app_dir)
+{
+    memset(env, 0, sizeof(*env));
+    if (sqlite3_open(":memory:", &env->db) != SQLITE_OK) {
+        fprintf(stderr, "perf: cannot open :memory: database\n");
+        sqlite3_close(env->db);
+        return -1;
+    }
+    hl_cap_db_init(env->db);
+    hl_vfs_init(&env->app_vfs, hl_app_entries, app_dir);
+    hl_vfs_init(&env->platform_vfs, hl_stdlib_entries, NULL);
+    hl_migrate_run(env->db, &env->app_vfs);
+    hl_stmt_cache_init(&env->stmt_cache, env->db);
+    env->alloc = kl_allocator_default();
+    kl_router_init(&env->router, &env->alloc);
+    return 0;
+}
+
+static void env_close(PerfEnv *env)
+{
+    kl_router_free(&env->router);
+    hl_stmt_cache_destroy(&env->stmt_cache);
+    hl_cap_db_shutdown(env->db);
+    sqlite3_close(env->db);
+}
+
+static const char *const req_header_names[] = { "X-Request-Id", "Accept" };
+static const char *const req_header_values[] = { "perf-0001", "*/*" };
+
+static int dispatch(KlRouter *router, const char *path)
+{
+    HlTestResult r;
+    memset(&r, 0, sizeof(r));
+    if (hl_cap_test_dispatch(router, "GET", path, NULL, 0,
+                             req_header_names, req_header_values, 2, &r) != 0)
+        return -1;
+    free((void *)r.body);
+    return r.status == 200 ? 0 : -1;
+}
+
+/* ── Lua benchmarks ────────────────────────────────────────────────── */
+
+#ifdef HL_ENABLE_LUA
+
+static PerfEnv lua_env;
+static HlLua lua_rt;
+
+static int bench_lua_request(void *ctx)
+{
+    (void)ctx;
+    return dispatch(&lua_env.router, "/items/42?q=abc&page=2");
+}
+
+static int bench_lua_res_json(void *ctx)
+{
+    (void)ctx;
+    return dispatch(&lua_env.router, "/json");
+}
+
+/* Call a perf_* global and end the request as the Keel bridge does */
+static int lua_call_global(void *ctx)
+{
+    lua_State *L = lua_rt.L;
+    lua_getglobal(L, (const char *)ctx);
+    int rc = 0;
+    if (lua_pcall(L, 0, 1, 0) != LUA_OK) {
+        fprintf(stderr, "perf: %s: %s\n", (const char *)ctx,
+                lua_tostring(L, -1));
+        rc = -1;
+    }
+    lua_pop(L, 1);
+    hl_lua_request_end(&lua_rt);
+    return rc;
+}
+
+static int setup_lua(const char *app_dir)
+{
+    char entry[4096];
+    snprintf(entry, sizeof(entry), "%s/app.lua", app_dir);
+    if (env_open(&lua_env, app_dir) != 0)
+        return -1;
+
+    HlLuaConfig cfg = HL_LUA_CONFIG_DEFAULT;
+    cfg.sandbox = 1;
+    memset(&lua_rt, 0, sizeof(lua_rt));
+    lua_rt.base.db = lua_env.db;
+    lua_rt.base.stmt_cache = &lua_env.stmt_cache;
+    lua_rt.base.app_vfs = &lua_env.app_vfs;
+    lua_rt.base.platform_vfs = &lua_env.platform_vfs;
+
+    if (hl_lua_init(&lua_rt, &cfg) != 0) {
+        fprintf(stderr, "perf: Lua init failed\n");
+        env_close(&lua_env);
+        return -1;
+    }
+    if (hl_lua_load_app(&lua_rt, entry) != 0 ||
+        hl_lua_wire_routes(&lua_rt, &lua_env.router) != 0) {
+        fprintf(stderr, "perf: failed to load %s\n", entry);
+        hl_lua_free(&lua_rt);
+        env_close(&lua_env);
+        return -1;
+    }
+
+    add_bench("lua_request", bench_lua_request, NULL, 5000);
+    add_bench("lua_res_json", bench_lua_res_json, NULL, 5000);
+    add_bench("lua_db_query", lua_call_global, (void *)"perf_db_query", 2000);
+    add_bench("lua_template", lua_call_global, (void *)"perf_template", 5000);
+    return 0;
+}
+
+static void teardown_lua(void)
+{
+    hl_lua_free(&lua_rt);
+    env_close(&lua_env);
+}
+
+/*
+ * The allocator under a bare lua_State: one request's worth of short
+ * strings and small tables per iteration, all garbage afterwards, on
+ * the libc backend vs. the size-class pool.
+ */
+typedef struct {
+    HlAllocator alloc;
+    lua_State  *L;
+} AllocCtx;
+
+static AllocCtx alloc_libc, alloc_pool;
+
+/* Same routing as the Lua runtime's allocator */
+static void *perf_lua_alloc(void *ud, void *ptr, size_t osize, size_t nsize)
+{
+    HlAllocator *a = ud;
+    if (nsize == 0) {
+        hl_alloc_free(a, ptr, osize);
+        return NULL;
+    }
+    if (!ptr)
+        return hl_alloc_malloc(a, nsize);
+    return hl_alloc_realloc(a, ptr, osize, nsize);
+}
+
+static const char *const churn_src =
+    "local r = ...\n"
+    "local headers = {}\n"
+    "for i = 1, 12 do headers['x-h' .. i] = 'value-' .. (r * i) end\n"
+    "local rows = {}\n"
+    "for i = 1, 20 do\n"
+    "  rows[i] = { id = i, name = 'user' .. i, email = 'u' .. i .. '@x.io' }\n"
+    "end\n"
+    "local parts = {}\n"
+    "for i, row in ipairs(rows) do\n"
+    "  parts[#parts + 1] = string.format('{\"id\":%d,\"name\":\"%s\"}',\n"
+    "                                    row.id, row.name)\n"
+    "end\n"
+    "return #table.concat(parts, ',')\n";
+
+/* The compiled chunk stays at stack index 1 */
+static int alloc_setup(AllocCtx *ac, int pool)
+{
+    hl_alloc_init(&ac->alloc, 0);
+    if (pool)
+        hl_alloc_use_pool(&ac->alloc);
+    ac->L = lua_newstate(perf_lua_alloc, &ac->alloc);
+    if (!ac->L) {
+        hl_alloc_destroy(&ac->alloc);
+        return -1;
+    }
+    luaL_openlibs(ac->L);
+    if (luaL_loadstring(ac->L, churn_src) != LUA_OK) {
+        lua_close(ac->L);
+        hl_alloc_destroy(&ac->alloc);
+        ac->L = NULL;
+        return -1;
+    }
+    return 0;
+}
+
+static void alloc_teardown(AllocCtx *ac)
+{
+    if (!ac->L)
+        return;
+    lua_close(ac->L);
+    hl_alloc_destroy(&ac->alloc);
+    ac->L = NULL;
+}
+
+static int bench_lua_alloc(void *ctx)
+{
+    AllocCtx *ac = ctx;
+    static lua_Integer r;
+    lua_pushvalue(ac->L, 1);
+    lua_pushinteger(ac->L, ++r);
+    if (lua_pcall(ac->L, 1, 0, 0) != LUA_OK) {
+        lua_pop(ac->L, 1);
+        return -1;
+    }
+    return 0;
+}
+
+static int setup_lua_alloc(void)
+{
+    if (alloc_setup(&alloc_libc, 0) != 0 || alloc_setup(&alloc_pool, 1) != 0) {
+        fprintf(stderr, "perf: cannot create the allocator Lua states\n");
+        alloc_teardown(&alloc_libc);
+        return -1;
+    }
+    add_bench("lua_alloc_libc", bench_lua_alloc, &alloc_libc, 2000);
+    add_bench("lua_alloc_pool", bench_lua_alloc, &alloc_pool, 2000);
+    return 0;
+}
+
+static void teardown_lua_alloc(void)
+{
+    alloc_teardown(&alloc_pool);
+    alloc_teardown(&alloc_libc);
+}
+
+/*
+ * Request latency including the boundary collection: handle(r) from
+ * bench/perf/gc.lua plus hl_lua_request_end(), with a young collection
+ * per request (--gc request) vs. paced incremental slices.
+ */
+typedef struct {
+    HlLua lua;
+    int   loaded;
+    int   r;
+} GcCtx;
+
+static HlVfs gc_platform_vfs;
+static GcCtx gc_request, gc_incr;
+
+static int gc_setup(GcCtx *gc, int mode, const char *entry)
+{
+    HlLuaConfig cfg = HL_LUA_CONFIG_DEFAULT;
+    cfg.gc_mode = mode;
+    memset(gc, 0, sizeof(*gc));
+    gc->lua.base.platform_vfs = &gc_platform_vfs;
+    if (hl_lua_init(&gc->lua, &cfg) != 0)
+        return -1;
+    if (hl_lua_load_app(&gc->lua, entry) != 0) {
+        hl_lua_free(&gc->lua);
+        return -1;
+    }
+    gc->loaded = 1;
+    return 0;
+}
+
+static void gc_teardown(GcCtx *gc)
+{
+    if (gc->loaded)
+        hl_lua_free(&gc->lua);
+    gc->loaded = 0;
+}
+
+static int bench_lua_gc(void *ctx)
+{
+    GcCtx *gc = ctx;
+    lua_State *L = gc->lua.L;
+    lua_getglobal(L, "handle");
+    lua_pushinteger(L, ++gc->r);
+    int rc = 0;
+    if (lua_pcall(L, 1, 0, 0) != LUA_OK) {
+        lua_pop(L, 1);
+        rc = -1;
+    }
+    hl_lua_request_end(&gc->lua);
+    return rc;
+}
+
+static int setup_lua_gc(const char *app_dir)
+{
+    char entry[4096];
+    snprintf(entry, sizeof(entry), "%s/gc.lua", app_dir);
+    hl_vfs_init(&gc_platform_vfs, hl_stdlib_entries, NULL);
+    if (gc_setup(&gc_request, HL_GC_REQUEST, entry) != 0 ||
+        gc_setup(&gc_incr, HL_GC_INCREMENTAL, entry) != 0) {
+        fprintf(stderr, "perf: failed to load %s\n", entry);
+        gc_teardown(&gc_request);
+        return -1;
+    }
+    add_bench("lua_gc_request", bench_lua_gc, &gc_request, 5000);
+    add_bench("lua_gc_incr", bench_lua_gc, &gc_incr, 5000);
+    return 0;
+}
+
+static void teardown_lua_gc(void)
+{
+    gc_teardown(&gc_incr);
+    gc_teardown(&gc_request);
+}
+
+#endif /* HL_ENABLE_LUA */
+
+/* ── JS benchmarks ─────────────────────────────────────────────────── */
+
+#ifdef HL_ENABLE_JS
+
+static PerfEnv js_env;
+static HlJS js_rt;
+static JSValue js_db_query_fn;
+static JSValue js_template_fn;
+
+static int bench_js_request(void *ctx)
+{
+    (void)ctx;
+    return dispatch(&js_env.router, "/items/42?q=abc&page=2");
+}
+
+static int bench_js_res_json(void *ctx)
+{
+    (void)ctx;
+    return dispatch(&js_env.router, "/json");
+}
+
+static int js_call_global(void *ctx)
+{
+    JSValue ret = JS_Call(js_rt.ctx, *(JSValue *)ctx, JS_UNDEFINED, 0, NULL);
+    int rc = 0;
+    if (JS_IsException(ret)) {
+        JSValue exc = JS_GetException(js_rt.ctx);
+        const char *msg = JS_ToCString(js_rt.ctx, exc);
+        fprintf(stderr, "perf: %s\n", msg ? msg : "exception");
+        JS_FreeCString(js_rt.ctx, msg);
+        JS_FreeValue(js_rt.ctx, exc);
+        rc = -1;
+    }
+    JS_FreeValue(js_rt.ctx, ret);
+    hl_js_request_end(&js_rt);
+    return rc;
+}
+
+static int setup_js(const char *app_dir)
+{
+    char entry[4096];
+    snprintf(entry, sizeof(entry), "%s/app.js", app_dir);
+    if (env_open(&js_env, app_dir) != 0)
+        return -1;
+
+    HlJSConfig cfg = HL_JS_CONFIG_DEFAULT;
+    memset(&js_rt, 0, sizeof(js_rt));
+    js_rt.base.db = js_env.db;
+    js_rt.base.stmt_cache = &js_env.stmt_cache;
+    js_rt.base.app_vfs = &js_env.app_vfs;
+    js_rt.base.platform_vfs = &js_env.platform_vfs;
+
+    if (hl_js_init(&js_rt, &cfg) != 0) {
+        fprintf(stderr, "perf: QuickJS init failed\n");
+        env_close(&js_env);
+        return -1;
+    }
+    if (hl_js_load_app(&js_rt, entry) != 0 ||
+        hl_js_wire_routes(&js_rt, &js_env.router) != 0) {
+        fprintf(stderr, "perf: failed to load %s\n", entry);
+        hl_js_free(&js_rt);
+        env_close(&js_env);
+        return -1;
+    }
+
+    JSValue global = JS_GetGlobalObject(js_rt.ctx);
+    js_db_query_fn = JS_GetPropertyStr(js_rt.ctx, global, "perf_db_query");
+    js_template_fn = JS_GetPropertyStr(js_rt.ctx, global, "perf_template");
+    JS_FreeValue(js_rt.ctx, global);
+
+    add_bench("js_request", bench_js_request, NULL, 5000);
+    add_bench("js_res_json", bench_js_res_json, NULL, 5000);
+    add_bench("js_db_query", js_call_global, &js_db_query_fn, 2000);
+    add_bench("js_template", js_call_global, &js_template_fn, 5000);
+    return 0;
+}
+
+static void teardown_js(void)
+{
+    JS_FreeValue(js_rt.ctx, js_db_query_fn);
+    JS_FreeValue(js_rt.ctx, js_template_fn);
+    hl_js_free(&js_rt);
+    env_close(&js_env);
+}
+
+#endif /* HL_ENABLE_JS */
+
+/* ── Baseline ──────────────────────────────────────────────────────── */
+
+typedef struct {
+    SHArena           *arena;
+    const ShJsonValue *root;
+    const char        *arch;
+    const char        *compiler;
+} PerfBaseline;
+
+static int baseline_load(PerfBaseline *bl, const char *path)
+{
+    memset(bl, 0, sizeof(*bl));
+    FILE *f = fopen(path, "rb");
+    if (!f)
+        return -1;
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    if (size <= 0 || size > 1024 * 1024) {
+        fclose(f);
+        return -1;
+    }
+    char *data = malloc((size_t)size);
+    size_t n = data ? fread(data, 1, (size_t)size, f) : 0;
+    fclose(f);
+
+    bl->arena = sh_arena_create((size_t)size * 8 + 4096);
+    ShJsonValue *root = NULL;
+    if (!data || !bl->arena ||
+        sh_json_parse(data, n, bl->arena, &root) != SH_JSON_OK ||
+        sh_json_type(root) != SH_JSON_OBJECT) {
+        free(data);
+        if (bl->arena)
+            sh_arena_free(bl->arena);
+        bl->arena = NULL;
+        return -1;
+    }
+    free(data);
+
+    bl->root = root;
+    bl->arch = sh_json_as_string(sh_json_get_path(root, "meta.arch"), "");
+    bl->compiler = sh_json_as_string(sh_json_get_path(root, "meta.compiler"),
+                                     "");
+    return 0;
+}
+
+static const ShJsonValue *baseline_entry(const PerfBaseline *bl,
+                                         const char *name)
+{
+    const ShJsonValue *list = bl->root ? sh_json_get(bl->root, "benchmarks")
+                                       : NULL;
+    return list ? sh_json_get(list, name) : NULL;
+}
+
+static int baseline_write(const char *path, const char *arch)
+{
+    FILE *f = fopen(path, "w");
+    if (!f) {
+        fprintf(stderr, "perf: cannot write %s\n", path);
+        return -1;
+    }
+    fprintf(f, "{\n  \"meta\": {\n");
+    fprintf(f, "    \"arch\": \"%s\",\n", arch);
+    fprintf(f, "    \"compiler\": \"%s\",\n", __VERSION__);
+    fprintf(f, "    \"counter\": \"%s\"\n",
+            counter_fd >= 0 ? "instructions" : "none");
+    fprintf(f, "  },\n  \"benchmarks\": {\n");
+    int written = 0;
+    for (int i = 0; i < num_benches; i++) {
+        const PerfBench *b = &benches[i];
+        if (b->failed)
+            continue;
+        fprintf(f, "%s    \"%s\": { ", written ? ",\n" : "", b->name);
+        if (counter_fd >= 0)
+            fprintf(f, "\"instructions\": %.0f, ", b->instructions);
+        fprintf(f, "\"ns\": %.1f }", b->ns);
+        written++;
+    }
+    fprintf(f, "\n  }\n}\n");
+    return fclose(f) == 0 ? 0 : -1;
+}
+
+/* ── Entry point ───────────────────────────────────────────────────── */
+
+static void usage(void)
+{
+    fprintf(stderr,
+            "Usage: perf [options] [app_dir]\n"
+            "\n"
+            "Options:\n"
+            "  --baseline FILE       Compare against FILE, exit 1 on regression\n"
+            "  --write FILE          Record the results as a new baseline\n"
+            "  --threshold PCT       Allowed instruction increase (default: 5)\n"
+            "  --wall-threshold PCT  Gate on wall time when no instruction\n"
+            "                        counter is available (default: report only)\n"
+            "  --only NAME           Run a single benchmark\n");
+}
+
+int main(int argc, char **argv)
+{
+    const char *app_dir = "bench/perf";
+    const char *baseline_path = NULL;
+    const char *write_path = NULL;
+    double threshold = 5.0;
+    double wall_threshold = 0;     /* 0 = report only */
+
+    for (int i = 1; i < argc; i++) {
+        const char *a = argv[i];
+        const char *val = (i + 1 < argc) ? argv[i + 1] : NULL;
+        if (strcmp(a, "--baseline") == 0 && val) {
+            baseline_path = val;
+        } else if (strcmp(a, "--write") == 0 && val) {
+            write_path = val;
+        } else if (strcmp(a, "--threshold") == 0 && val && atof(val) > 0) {
+            threshold = atof(val);
+        } else if (strcmp(a, "--wall-threshold") == 0 && val && atof(val) > 0) {
+            wall_threshold = atof(val);
+        } else if (strcmp(a, "--only") == 0 && val) {
+            only = val;
+        } else if (a[0] != '-') {
+            app_dir = a;
+            continue;
+        } else {
+            usage();
+            return 2;
+        }
+        i++;
+    }
+
+    struct utsname un;
+    const char *arch = uname(&un) == 0 ? un.machine : "unknown";
+
+    log_set_level(LOG_WARN);   /* keep migration chatter out of the table */
+    counter_open();
+    if (counter_fd < 0 && wall_threshold <= 0)
+        fprintf(stderr, "perf: instruction counter unavailable, wall time "
+                "is reported but not gated (see --wall-threshold)\n");
+    else if (counter_fd < 0)
+        fprintf(stderr, "perf: instruction counter unavailable, gating "
+                "wall time at +%.0f%%\n", wall_threshold);
+
+    /* Native fixtures */
+    RouterCtx router_ctx;
+    memset(&router_ctx, 0, sizeof(router_ctx));
+    router_ctx.alloc = kl_allocator_default();
+    kl_router_init(&router_ctx.router, &router_ctx.alloc);
+    for (size_t i = 0; i < sizeof(route_patterns) / sizeof(route_patterns[0]); i++)
+        kl_router_add(&router_ctx.router, "GET", route_patterns[i],
+                      noop_handler, NULL, NULL);
+
+    static uint8_t hmac_msg[1024];
+    for (size_t i = 0; i < sizeof(hmac_msg); i++)
+        hmac_msg[i] = (uint8_t)(i * 31);
+
+    StaticCtx static_ctx;
+    memset(&static_ctx, 0, sizeof(static_ctx));
+    hl_vfs_init(&static_ctx.vfs, hl_stdlib_entries, NULL);
+    for (size_t i = 0; i < 4; i++)
+        static_ctx.names[i] =
+            hl_stdlib_entries[static_ctx.vfs.count * (2 * i + 1) / 8].name;
+
+    add_bench("router_match", bench_router_match, &router_ctx, 200000);
+    add_bench("hmac_sha256", bench_hmac, hmac_msg, 20000);
+    add_bench("static_lookup", bench_static_lookup, &static_ctx, 200000);
+
+    /* Both PBKDF2 variants must agree before their timings mean anything */
+    static uint8_t pbkdf2_out[32], pbkdf2_ref[32];
+    int pbkdf2_ok = bench_pbkdf2(pbkdf2_out) == 0 &&
+                    pbkdf2_hmac_loop(pbkdf2_ref) == 0 &&
+                    memcmp(pbkdf2_out, pbkdf2_ref, 32) == 0;
+    if (pbkdf2_ok) {
+        add_bench("pbkdf2", bench_pbkdf2, pbkdf2_out, 3);
+        add_bench("pbkdf2_hmac_loop", bench_pbkdf2_hmac_loop, pbkdf2_ref, 3);
+    } else {
+        fprintf(stderr, "perf: pbkdf2 and the HMAC-loop reference disagree\n");
+    }
+
+    AuditCtx audit_ctx;
+    memset(&audit_ctx, 0, sizeof(audit_ctx));
+    audit_ctx.devnull = open("/dev/null", O_WRONLY);
+    audit_ctx.saved_stderr = dup(STDERR_FILENO);
+    if (audit_ctx.devnull >= 0 && audit_ctx.saved_stderr >= 0) {
+        add_bench("audit_sync", bench_audit_sync, &audit_ctx, 2000);
+        add_bench("audit_ring", bench_audit_ring, &audit_ctx, 2000);
+    }
+
+    log_ctx.fp = fopen("/dev/null", "w");
+    log_ctx.devnull = open("/dev/null", O_WRONLY);
+    if (log_ctx.fp && log_ctx.devnull >= 0) {
+        log_add_callback(perf_log_callback, NULL, LOG_INFO);
+        add_bench("log_fprintf", bench_log_fprintf, NULL, 50000);
+        add_bench("log_sink", bench_log_sink, NULL, 50000);
+    }
+
+    /* ~43 MB fixture: only built when the benchmark will run */
+    SigCtx sig_ctx;
+    int sig_ok = 0;
+    if (!only || strcmp(only, "sig_verify_files") == 0) {
+        sig_ok = sig_setup(&sig_ctx) == 0;
+        if (sig_ok)
+            add_bench("sig_verify_files", bench_sig_verify, &sig_ctx, 5);
+        else
+            fprintf(stderr, "perf: cannot allocate the signature fixture\n");
+    }
+
+    int rc = pbkdf2_ok ? 0 : 1;
+#ifdef HL_ENABLE_LUA
+    int lua_ok = setup_lua(app_dir) == 0;
+    if (!lua_ok)
+        rc = 1;
+    if (setup_lua_alloc() != 0)
+        rc = 1;
+    if (setup_lua_gc(app_dir) != 0)
+        rc = 1;
+#endif
+#ifdef HL_ENABLE_JS
+    int js_ok = setup_js(app_dir) == 0;
+    if (!js_ok)
+        rc = 1;
+#endif
+
+    for (int i = 0; i < num_benches; i++)
+        run_bench(&benches[i]);
+
+    /* Compare */
+    PerfBaseline bl;
+    memset(&bl, 0, sizeof(bl));
+    int enforce = 0;
+    if (baseline_path) {
+        if (baseline_load(&bl, baseline_path) != 0) {
+            fprintf(stderr, "perf: cannot read baseline %s\n", baseline_path);
+            rc = 1;
+        } else if (strcmp(bl.arch, arch) != 0 ||
+                   strcmp(bl.compiler, __VERSION__) != 0) {
+            fprintf(stderr, "perf: baseline recorded on %s with \"%s\"; "
+                    "reporting only (run make perf-baseline to re-record)\n",
+                    bl.arch, bl.compiler);
+        } else {
+            enforce = 1;
+        }
+    }
+
+    printf("%-16s %14s %12s %10s\n", "benchmark", "instr/iter",
+           "ns/iter", "change");
+    int regressions = 0;
+    for (int i = 0; i < num_benches; i++) {
+        PerfBench *b = &benches[i];
+        if (b->failed) {
+            printf("%-16s %14s %12s %10s\n", b->name, "-", "-", "FAILED");
+            rc = 1;
+            continue;
+        }
+
+        char instr[32] = "-";
+        if (counter_fd >= 0)
+            snprintf(instr, sizeof(instr), "%.0f", b->instructions);
+
+        char change[32] = "";
+        const char *verdict = "";
+        const ShJsonValue *e = baseline_entry(&bl, b->name);
+        if (baseline_path && !e) {
+            snprintf(change, sizeof(change), "new");
+        } else if (e) {
+            double base_ins = sh_json_as_double(sh_json_get(e, "instructions"), 0);
+            double base_ns = sh_json_as_double(sh_json_get(e, "ns"), 0);
+            double pct, limit;
+            if (counter_fd >= 0 && base_ins > 0) {
+                pct = (b->instructions - base_ins) * 100.0 / base_ins;
+                limit = threshold;
+            } else {
+                pct = base_ns > 0 ? (b->ns - base_ns) * 100.0 / base_ns : 0;
+                limit = wall_threshold;
+                /* Wall time is noisy: confirm with a second run and keep
+                 * the better time before calling it a regression */
+                if (enforce && limit > 0 && pct > limit) {
+                    double first_ns = b->ns;
+                    run_bench(b);
+                    if (b->failed || first_ns < b->ns)
+                        b->ns = first_ns;
+                    b->failed = 0;
+                    pct = (b->ns - base_ns) * 100.0 / base_ns;
+                }
+            }
+            snprintf(change, sizeof(change), "%+.1f%%", pct);
+            if (enforce && limit > 0 && pct > limit) {
+                verdict = "  REGRESSION";
+                regressions++;
+            }
+        }
+        printf("%-16s %14s %12.1f %10s%s\n", b->name, instr, b->ns,
+               change, verdict);
+    }
+
+    if (regressions > 0) {
+        fprintf(stderr, "perf: %d benchmark%s regressed beyond the threshold\n",
+                regressions, regressions == 1 ? "" : "s");
+        rc = 1;
+    }
+    if (write_path && baseline_write(write_path, arch) != 0)
+        rc = 1;
+
+    if (bl.arena)
+        sh_arena_free(bl.arena);
+#ifdef HL_ENABLE_JS
+    if (js_ok)
+        teardown_js();
+#endif
+#ifdef HL_ENABLE_LUA
+    if (lua_ok)
+        teardown_lua();
+    teardown_lua_alloc();
+    teardown_lua_gc();
+#endif
+    hl_audit_stop();
+    hl_log_sink_stop();
+    if (log_ctx.fp)
+        fclose(log_ctx.fp);
+    if (log_ctx.devnull >= 0)
+        close(log_ctx.devnull);
+    if (audit_ctx.saved_stderr >= 0)
+        close(audit_ctx.saved_stderr);
+    if (audit_ctx.devnull >= 0)
+        close(audit_ctx.devnull);
+    if (sig_ok)
+        sig_teardown(&sig_ctx);
+    kl_router_free(&router_ctx.router);
+    return rc;
+}
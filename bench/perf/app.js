@@ -0,0 +1,38 @@
+// perf — fixture app for `make perf` (bench/perf.c)
+//
+// Routes are dispatched in-process through the router; the perf_*
+// globals are called directly so they measure only the binding work.
+// Keep this file stable: every change shifts the recorded baseline.
+
+import { app } from "hull:app";
+import { db } from "hull:db";
+import { template } from "hull:template";
+
+app.manifest({});
+
+const payload = { id: 42, name: "widget", tags: ["a", "b", "c"] };
+for (let i = 1; i <= 16; i++) {
+    payload[`field_${i}`] = i * 3;
+}
+
+const items = [];
+for (let i = 1; i <= 20; i++) {
+    items.push({ id: i, name: `Item ${i}`, active: (i % 3 !== 0) });
+}
+
+// Request marshaling: params, query and headers in, short text out
+app.get("/items/:id", (req, res) => {
+    void [req.params.id, req.query.q, req.headers["x-request-id"]];
+    res.text("ok");
+});
+
+// Response serialization
+app.get("/json", (_req, res) => {
+    res.json(payload);
+});
+
+globalThis.perf_db_query = () =>
+    db.query("SELECT id, name, price, active FROM items ORDER BY id");
+
+globalThis.perf_template = () =>
+    template.render("items.html", { title: "Items", items });
@@ -0,0 +1,38 @@
+-- perf — fixture app for `make perf` (bench/perf.c)
+--
+-- Routes are dispatched in-process through the router; the perf_*
+-- globals are called directly so they measure only the binding work.
+-- Keep this file stable: every change shifts the recorded baseline.
+
+local template = require("hull.template")
+
+app.manifest({})
+
+local payload = { id = 42, name = "widget", tags = { "a", "b", "c" } }
+for i = 1, 16 do
+    payload["field_" .. i] = i * 3
+end
+
+local items = {}
+for i = 1, 20 do
+    items[i] = { id = i, name = "Item " .. i, active = (i % 3 ~= 0) }
+end
+
+-- Request marshaling: params, query and headers in, short text out
+app.get("/items/:id", function(req, res)
+    local _ = req.params.id, req.query.q, req.headers["x-request-id"]
+    res:text("ok")
+end)
+
+-- Response serialization
+app.get("/json", function(_req, res)
+    res:json(payload)
+end)
+
+function perf_db_query()
+    return db.query("SELECT id, name, price, active FROM items ORDER BY id")
+end
+
+function perf_template()
+    return template.render("items.html", { title = "Items", items = items })
+end
@@ -0,0 +1,16 @@
+-- perf — GC fixture for `make perf` (bench/perf.c, lua_gc_*)
+--
+-- Each request leaves 50 tables of garbage and lets one object escape
+-- into a global every 100 requests, next to a long-lived cache the
+-- collector has to keep marking.
+-- Keep this file stable: every change shifts the recorded baseline.
+
+cache = {}
+for i = 1, 20000 do cache[i] = { id = i, name = 'n' .. i } end
+kept = {}
+
+function handle(r)
+  local t = {}
+  for i = 1, 50 do t[i] = { id = i, s = 'x' .. (r * i) } end
+  if r % 100 == 0 then kept[#kept + 1] = t[1] end
+end
@@ -0,0 +1,11 @@
+-- 100 fixed rows for the db_query micro-benchmark
+CREATE TABLE items (
+    id INTEGER PRIMARY KEY,
+    name TEXT NOT NULL,
+    price REAL NOT NULL,
+    active INTEGER NOT NULL
+);
+
+WITH RECURSIVE seq(n) AS (SELECT 1 UNION ALL SELECT n + 1 FROM seq WHERE n < 100)
+INSERT INTO items (id, name, price, active)
+SELECT n, 'item-' || n, n * 1.25, n % 2 FROM seq;
@@ -0,0 +1,97 @@
+#!/bin/sh
+# Hull startup benchmark — time from exec to first HTTP response
+#
+# Runs every examples/*/app.{lua,js} in source mode (build/hull <app>) and,
+# when a C compiler is available, as a `hull build` binary with the app
+# and its precompiled bytecode embedded. Reports the median of RUNS starts.
+#
+# Usage: sh bench/startup.sh
+#        RUNTIME=lua sh bench/startup.sh   # Lua apps only
+#        RUNTIME=js  sh bench/startup.sh   # JS apps only
+#        RUNS=20 BUILD_CC=gcc sh bench/startup.sh
+#
+# Requires: build/hull already built, curl and perl available
+#
+# SPDX-License-Identifier: AGPL-3.0-or-later
+
+set -e
+
+cd "$(dirname "$0")/.."
+
+HULL=./build/hull
+RUNS=${RUNS:-10}
+RUNTIME=${RUNTIME:-all}
+BUILD_CC=${BUILD_CC:-cc}
+PORT=${PORT:-19870}
+
+if [ ! -x "$HULL" ]; then
+    echo "startup: hull binary not found at $HULL — run 'make' first"
+    exit 1
+fi
+
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+
+now_ms() {
+    perl -MTime::HiRes=time -e 'printf "%d\n", time() * 1000'
+}
+
+# Start binary $1 (optionally with app path $2), poll until it answers
+# any HTTP request, print elapsed ms.
+time_start() {
+    DB="$WORK/startup.db"
+    rm -f "$DB" "$DB-wal" "$DB-shm"
+    T0=$(now_ms)
+    "$1" -p "$PORT" -d "$DB" ${2:+"$2"} >/dev/null 2>&1 &
+    PID=$!
+    while ! curl -s -o /dev/null "http://127.0.0.1:$PORT/" 2>/dev/null; do
+        if ! kill -0 "$PID" 2>/dev/null; then
+            echo "fail"
+            return
+        fi
+        sleep 0.005
+    done
+    T1=$(now_ms)
+    kill "$PID" 2>/dev/null || true
+    wait "$PID" 2>/dev/null || true
+    echo $((T1 - T0))
+}
+
+# Median of RUNS samples; "fail" if any run fails.
+median_start() {
+    SAMPLES=""
+    i=0
+    while [ "$i" -lt "$RUNS" ]; do
+        MS=$(time_start "$@")
+        if [ "$MS" = "fail" ]; then
+            echo "fail"
+            return
+        fi
+        SAMPLES="$SAMPLES$MS
+"
+        i=$((i + 1))
+    done
+    printf '%s' "$SAMPLES" | sort -n | awk '{ v[NR] = $1 } END { print v[int((NR + 1) / 2)] }'
+}
+
+printf '%-20s %-4s %12s %12s\n' "app" "rt" "source (ms)" "built (ms)"
+
+for APP_DIR in examples/*/; do
+    APP_DIR=${APP_DIR%/}
+    NAME=$(basename "$APP_DIR")
+    for RT in lua js; do
+        [ "$RUNTIME" != "all" ] && [ "$RUNTIME" != "$RT" ] && continue
+        [ -f "$APP_DIR/app.$RT" ] || continue
+
+        SRC=$(median_start "$HULL" "$APP_DIR/app.$RT")
+
+        BUILT="-"
+        BIN="$WORK/$NAME-$RT"
+        if command -v "$BUILD_CC" >/dev/null 2>&1 &&
+           "$HULL" build --runtime "$RT" --cc "$BUILD_CC" -o "$BIN" "$APP_DIR" >/dev/null 2>&1; then
+            BUILT=$(median_start "$BIN")
+        fi
+
+        printf '%-20s %-4s %12s %12s\n' "$NAME" "$RT" "$SRC" "$BUILT"
+    done
+done
@@ -0,0 +1,45 @@
+/*
+ * access_log.h — Native per-request access log
+ *
+ * One line per request with request ID, method, path, status, bytes
+ * and duration in microseconds, written through the log sink in its
+ * configured format. Replaces hull.middleware.logger without entering
+ * the script runtime.
+ *
+ * Keel has no after-response hook, so the log is split in two: a
+ * pre-body middleware stamps the start time and request ID, and the
+ * code that produces the response (the runtime handler trampolines,
+ * script middleware that short-circuits, static files) calls
+ * hl_access_log_finish() once status and size are known. Both run on
+ * the event loop thread; no locking.
+ *
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#ifndef HL_ACCESS_LOG_H
+#define HL_ACCESS_LOG_H
+
+#include <keel/request.h>
+#include <keel/response.h>
+#include <stddef.h>
+#include <stdint.h>
+
+extern int hl_access_log_enabled;
+
+/**
+ * @brief Keel pre-body middleware: record the start time and assign
+ * a request ID, echoed as X-Request-ID. Always returns 0.
+ */
+int hl_access_log_middleware(KlRequest *req, KlResponse *res, void *user_data);
+
+/**
+ * @brief Emit the access line for req. Single branch when disabled.
+ * @param status HTTP status sent.
+ * @param bytes  Response body size (file size for file responses).
+ */
+void hl_access_log_finish(const KlRequest *req, int status, size_t bytes);
+
+/* Lines emitted so far */
+uint64_t hl_access_log_count(void);
+
+#endif /* HL_ACCESS_LOG_H */
@@ -9,6 +9,14 @@
  * When the allocator pointer is NULL, all functions fall back to
  * raw malloc/realloc/free with no tracking (backward compatible).
  *
+ * Backends: libc malloc (default), or a size-class pool selected with
+ * hl_alloc_use_pool(). The pool carves small blocks (<= HL_POOL_MAX_SIZE)
+ * from 64 KB slabs with one free list per class and passes larger
+ * requests through to malloc. Accounting and limits are identical for
+ * both: `used` counts requested bytes, not slab capacity. An allocator
+ * (and its pool) belongs to one thread — the counters were never
+ * atomic — so its free lists are effectively thread-local.
+ *
  * SPDX-License-Identifier: AGPL-3.0-or-later
  */
 
@@ -20,11 +28,13 @@
 
 /* Forward declarations */
 typedef struct SHArena SHArena;
+typedef struct HlPool HlPool;
 
 typedef struct HlAllocator {
-    size_t used;
-    size_t limit;   /* 0 = unlimited (tracking only) */
-    size_t peak;
+    size_t  used;
+    size_t  limit;   /* 0 = unlimited (tracking only) */
+    size_t  peak;
+    HlPool *pool;    /* NULL = libc malloc */
 } HlAllocator;
 
 /* Initialize allocator. limit=0 means tracking only, no cap. */
@@ -33,8 +43,23 @@ static inline void hl_alloc_init(HlAllocator *a, size_t limit)
     a->used = 0;
     a->limit = limit;
     a->peak = 0;
+    a->pool = NULL;
 }
 
+/* Switch to the size-class pool. Call before the first allocation.
+ * Returns 0, or -1 if the pool could not be created (stays on libc). */
+int  hl_alloc_use_pool(HlAllocator *a);
+
+/* Release the pool's slabs. Every pooled block must already be freed
+ * (or be abandoned at exit). No-op for the libc backend. */
+void hl_alloc_destroy(HlAllocator *a);
+
+/* "pool" or "libc" */
+const char *hl_alloc_backend(const HlAllocator *a);
+
+/* Bytes held in pool slabs (0 for libc) — capacity, not usage */
+size_t hl_alloc_pool_reserved(const HlAllocator *a);
+
 /* Tracked allocation functions.
  * If 'a' is NULL, falls back to raw malloc/realloc/free. */
 void *hl_alloc_malloc(HlAllocator *a, size_t size);
@@ -0,0 +1,162 @@
+/*
+ * bench.h — Request-mix load generator for hull bench
+ *
+ * A script is a weighted list of request templates:
+ *
+ *   { "requests": [
+ *       { "method": "GET",  "path": "/items/{{rand:1000}}", "weight": 8 },
+ *       { "method": "POST", "path": "/items", "weight": 2,
+ *         "headers": { "Content-Type": "application/json" },
+ *         "body": "{\"name\":\"item-{{seq}}\"}" } ] }
+ *
+ * Paths, header values and bodies may use {{seq}} (request number),
+ * {{conn}} (connection index), {{rand}} and {{rand:N}} (0..N-1). Other
+ * {{...}} text is sent as is. Expansion is driven by a seeded PRNG, so a
+ * given seed replays the same request sequence.
+ *
+ * Requests are replayed either in-process through a dispatch callback
+ * (one at a time, no TCP) or over loopback with N keep-alive
+ * connections. Latencies go into per-entry and overall HDR histograms.
+ *
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#ifndef HL_BENCH_H
+#define HL_BENCH_H
+
+#include "hull/hdr.h"
+#include "hull/limits.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+typedef struct SHArena SHArena;
+
+/* ── Script ────────────────────────────────────────────────────────── */
+
+typedef struct {
+    const char *method;
+    const char *path;                                  /* template */
+    const char *body;                                  /* template or NULL */
+    const char *header_names[HL_BENCH_MAX_HEADERS];
+    const char *header_values[HL_BENCH_MAX_HEADERS];   /* templates */
+    int         num_headers;
+    unsigned    weight;
+} HlBenchRequest;
+
+typedef struct {
+    HlBenchRequest reqs[HL_BENCH_MAX_REQUESTS];
+    int            count;
+    unsigned       total_weight;
+    SHArena       *arena;        /* owns the parsed strings */
+} HlBenchScript;
+
+/* Parse a JSON script. On error returns -1 with a message in err. */
+int hl_bench_script_parse(HlBenchScript *s, const char *json, size_t len,
+                          char *err, size_t err_size);
+
+/* Read and parse a script file. */
+int hl_bench_script_load(HlBenchScript *s, const char *path,
+                         char *err, size_t err_size);
+
+/* One-entry script (method, path; no body) for runs without -s.
+ * The strings must outlive the script. */
+void hl_bench_script_single(HlBenchScript *s, const char *method,
+                            const char *path);
+
+void hl_bench_script_free(HlBenchScript *s);
+
+/* ── Expansion ─────────────────────────────────────────────────────── */
+
+/* xorshift64* step; state must be non-zero */
+uint64_t hl_bench_rand(uint64_t *state);
+
+/* Weighted pick of a script entry */
+int hl_bench_pick(const HlBenchScript *s, uint64_t *rng);
+
+/*
+ * Expand tmpl into buf (NUL-terminated). Returns the expanded length,
+ * or -1 if it does not fit.
+ */
+int hl_bench_expand(const char *tmpl, uint64_t seq, int conn, uint64_t *rng,
+                    char *buf, size_t size);
+
+/* A picked and expanded request; strings point into buf */
+typedef struct {
+    int         index;           /* script entry */
+    const char *method;
+    const char *path;
+    const char *body;            /* NULL when the entry has none */
+    size_t      body_len;
+    const char *header_names[HL_BENCH_MAX_HEADERS];
+    const char *header_values[HL_BENCH_MAX_HEADERS];
+    int         num_headers;
+    char        buf[HL_BENCH_MAX_REQ_SIZE];
+} HlBenchPrepared;
+
+/* Pick and expand the next request. Returns 0, or -1 if it is too large. */
+int hl_bench_prepare(const HlBenchScript *s, uint64_t seq, int conn,
+                     uint64_t *rng, HlBenchPrepared *out);
+
+/*
+ * Serialize as an HTTP/1.1 keep-alive request for host:port. Returns the
+ * length written to buf, or -1 if it does not fit.
+ */
+int hl_bench_format_http(const HlBenchPrepared *req, const char *host,
+                         int port, char *buf, size_t size);
+
+/* ── Runs ──────────────────────────────────────────────────────────── */
+
+typedef struct {
+    uint64_t requests;       /* measured requests (when duration_ms is 0) */
+    int      duration_ms;    /* run for this long instead */
+    uint64_t warmup;         /* requests sent first and not recorded */
+    int      connections;    /* loopback only */
+    uint64_t seed;
+} HlBenchConfig;
+
+typedef struct {
+    HlHdr    latency;        /* ns, every measured request */
+    HlHdr   *by_entry;       /* ns, per script entry */
+    uint64_t *count_by_entry;
+    int      entries;
+    uint64_t requests;       /* measured responses */
+    uint64_t errors;         /* transport / parse failures */
+    uint64_t bytes;          /* response bytes (body in-process, wire on loopback) */
+    uint64_t status[6];      /* by status / 100; [0] counts anything else */
+    int64_t  elapsed_ns;
+} HlBenchStats;
+
+int  hl_bench_stats_init(HlBenchStats *st, int entries);
+void hl_bench_stats_free(HlBenchStats *st);
+
+/*
+ * In-process dispatch: handle one request and return its HTTP status
+ * (or -1 on failure), adding the response size to *bytes.
+ */
+typedef int (*HlBenchDispatchFn)(void *ctx, const HlBenchPrepared *req,
+                                 size_t *bytes);
+
+/* Replay the script one request at a time through fn. */
+int hl_bench_run_inprocess(const HlBenchScript *s, const HlBenchConfig *cfg,
+                           HlBenchDispatchFn fn, void *ctx,
+                           HlBenchStats *st);
+
+/*
+ * Replay the script against host:port over cfg->connections keep-alive
+ * connections, each with one request in flight. Returns 0, or -1 with a
+ * message in err if the server could not be reached or stopped
+ * responding.
+ */
+int hl_bench_run_loopback(const HlBenchScript *s, const HlBenchConfig *cfg,
+                          const char *host, int port, HlBenchStats *st,
+                          char *err, size_t err_size);
+
+/* ── Report ────────────────────────────────────────────────────────── */
+
+/* Write the JSON report (one object, trailing newline). Latencies in µs. */
+int hl_bench_report(FILE *out, const HlBenchScript *s, const HlBenchStats *st,
+                    const char *mode, const char *target, int connections);
+
+#endif /* HL_BENCH_H */
@@ -1,10 +1,19 @@
 /*
  * audit.h — Capability audit logging
  *
- * Structured JSON audit lines to stderr, gated by hl_audit_enabled.
+ * Structured JSON audit lines, gated by hl_audit_enabled.
  * Zero overhead when disabled — writer returned with error=1 makes
  * all subsequent sh_json_write_* calls no-ops.
  *
+ * Once hl_audit_start() has run, hl_audit_begin() claims a fixed-size
+ * record in a lock-free ring and the writer fills it in memory;
+ * hl_audit_end() publishes it. A drain thread adds the timestamp,
+ * finishes each line and writes them out in large batches. When the
+ * ring is full the event is dropped and counted rather than blocking
+ * the request. Fields that overflow a record are cut and the line is
+ * marked "truncated":true. Before start (and after stop) every event
+ * is formatted and written to stderr synchronously.
+ *
  * SPDX-License-Identifier: AGPL-3.0-or-later
  */
 
@@ -12,10 +21,29 @@
 #define HL_CAP_AUDIT_H
 
 #include <sh_json.h>
+#include <stddef.h>
+#include <stdint.h>
 
 extern int hl_audit_enabled;
 
 ShJsonWriter hl_audit_begin(const char *cap);
 void hl_audit_end(ShJsonWriter *w);
 
+/*
+ * Start the drain thread. path NULL writes to stderr; otherwise lines
+ * are appended to path, which is renamed to "<path>.1" once it reaches
+ * rotate_bytes (0 = never rotate). Returns 0 or -1.
+ */
+int hl_audit_start(const char *path, size_t rotate_bytes);
+
+/* Write out everything published so far and join the drain thread.
+ * Safe to call when not started. */
+void hl_audit_stop(void);
+
+/* Events dropped because the ring was full */
+uint64_t hl_audit_dropped(void);
+
+/* Events written by the drain thread */
+uint64_t hl_audit_written(void);
+
 #endif /* HL_CAP_AUDIT_H */
@@ -1,6 +1,18 @@
 /*
  * cap/body.h — Body reader factory and extraction
  *
+ * Routes buffer the request body in memory by default (HL_BODY_MAX_SIZE).
+ * A route can instead declare one of the upload modes below, which
+ * never hold more than a chunk of the body at a time:
+ *
+ *   stream — each chunk is handed to a callback as it arrives
+ *   spool  — chunks are written to a temporary file in a directory the
+ *            manifest grants fs.write on; the handler gets the file
+ *   blob   — chunks are written into a zeroblob() row with
+ *            sqlite3_blob_write; the handler gets the rowid. The row
+ *            (Content-Length bytes) is inserted once the first
+ *            HL_BODY_BLOB_FLUSH bytes have arrived, not on headers alone.
+ *
  * SPDX-License-Identifier: AGPL-3.0-or-later
  */
 
@@ -8,11 +20,128 @@
 #define HL_CAP_BODY_H
 
 #include <stddef.h>
+#include <stdint.h>
 #include <keel/body_reader.h>
 
+#include "hull/limits.h"
+
+typedef struct sqlite3 sqlite3;
+typedef struct HlManifest HlManifest;
+
 KlBodyReader *hl_cap_body_factory(KlAllocator *alloc, const KlRequest *req,
                                   void *user_data);
 
+/* Buffered body; 0 bytes (and NULL) for upload-mode readers */
 size_t hl_cap_body_data(const KlBodyReader *reader, const char **out_data);
 
+/* ── Upload modes ──────────────────────────────────────────────────── */
+
+typedef enum {
+    HL_BODY_BUFFER = 0,     /* whole body in memory (default) */
+    HL_BODY_STREAM,
+    HL_BODY_SPOOL,
+    HL_BODY_BLOB,
+} HlBodyMode;
+
+/* Per-route body declaration, checked by hl_cap_body_check() */
+typedef struct {
+    HlBodyMode mode;
+    int64_t    max_size;                    /* 0 = mode default */
+    char       dir[HL_BODY_DIR_MAX];        /* spool */
+    char       root[HL_BODY_DIR_MAX];       /* spool: the fs.write entry dir is under */
+    char       table[HL_BODY_IDENT_MAX];    /* blob */
+    char       column[HL_BODY_IDENT_MAX];   /* blob */
+} HlBodySpec;
+
+typedef struct HlBodyUpload HlBodyUpload;
+
+/*
+ * Stream callback: one call per chunk, in order. Returning non-zero
+ * aborts the request.
+ */
+typedef int (*HlBodyChunkFn)(HlBodyUpload *up, const char *data, size_t len,
+                             void *ctx);
+
+struct HlBodyUpload {
+    KlBodyReader     base;          /* must be first */
+    KlAllocator     *alloc;
+    const KlRequest *req;
+    HlBodyMode       mode;
+    int64_t          max_size;
+    int64_t          size;          /* bytes received so far */
+    int              complete;      /* on_complete ran and succeeded */
+
+    /* stream */
+    HlBodyChunkFn    on_chunk;
+    void            *chunk_ctx;
+    char            *state;         /* runtime-owned data kept across chunks */
+    size_t           state_len;
+
+    /* spool */
+    int              fd;
+    int              kept;          /* hl_cap_body_keep() moved the file */
+    char             path[HL_BODY_DIR_MAX + HL_BODY_NAME_MAX];
+
+    /* blob */
+    sqlite3         *db;
+    int64_t          rowid;
+    const char      *table;
+    const char      *column;
+    char            *pending;       /* staged bytes, HL_BODY_BLOB_FLUSH */
+    size_t           pending_len;
+    int64_t          written;
+};
+
+/*
+ * Parse a mode name ("buffer", "stream", "spool", "blob").
+ * Returns the mode, or -1 for anything else.
+ */
+int hl_cap_body_mode(const char *name);
+
+/* Name of a mode, for the runtimes' req.upload.mode */
+const char *hl_cap_body_mode_name(HlBodyMode mode);
+
+/*
+ * Validate a spec and fill in its default max_size. Blob table and
+ * column must be plain identifiers outside _hull_*, the spool directory
+ * a relative or absolute path without ".." that lies inside one of the
+ * manifest's fs.write entries (recorded in spec->root), and max_size
+ * within the mode's ceiling. Returns 0, or -1 with the reason logged.
+ */
+int hl_cap_body_check(HlBodySpec *spec, const HlManifest *manifest);
+
+/*
+ * Create the reader for one request under `spec` (already checked).
+ * Buffer mode returns Keel's buffer reader; the others an HlBodyUpload.
+ * `db` is needed for blob, `on_chunk` for stream. A spool directory is
+ * resolved with realpath() first and refused unless it still lies
+ * inside spec->root, so a symlink cannot lead the file elsewhere.
+ * Returns NULL on error.
+ */
+KlBodyReader *hl_cap_body_open(KlAllocator *alloc, const KlRequest *req,
+                               const HlBodySpec *spec, sqlite3 *db,
+                               HlBodyChunkFn on_chunk, void *chunk_ctx);
+
+/*
+ * Replace a stream upload's carried state (the runtimes keep req.ctx
+ * there as JSON between on_chunk calls). Returns 0 or -1.
+ */
+int hl_cap_body_set_state(HlBodyUpload *up, const char *data, size_t len);
+
+/* The upload behind a reader, or NULL for buffered bodies */
+HlBodyUpload *hl_cap_body_upload(KlBodyReader *reader);
+
+/*
+ * Read from a completed spool upload's file. Returns bytes read
+ * (0 at end), or -1 on error.
+ */
+int64_t hl_cap_body_read(HlBodyUpload *up, char *buf, size_t len);
+
+/*
+ * Keep a completed spool upload as `name` (a plain file name) in its
+ * directory instead of deleting it when the request ends. Fails rather
+ * than replace an existing file. Returns 0 or -1.
+ */
+int hl_cap_body_keep(HlBodyUpload *up, const char *name);
+
 #endif /* HL_CAP_BODY_H */
@@ -13,12 +13,36 @@
 int hl_cap_crypto_sha256(const void *data, size_t len, uint8_t out[32]);
 int hl_cap_crypto_random(void *buf, size_t len);
 
+/* SHA-256 block kernel selected at startup from CPUID / hwcaps:
+ * "sha-ni", "armv8-sha2" or "portable". */
+const char *hl_cap_crypto_sha256_backend(void);
+
+/* Pin the portable kernel (on = 1) or re-run CPU detection (on = 0).
+ * For tests and benchmarks comparing backends; not thread-safe. */
+void hl_cap_crypto_sha256_force_portable(int on);
+
+typedef struct {
+    const void *data;     /* may be NULL when len == 0 */
+    size_t      len;
+    uint8_t     hash[32]; /* out */
+} HlSha256Item;
+
+/* Hash n independent buffers. Batches of at least
+ * HL_SHA256_MANY_MIN_BYTES are spread across up to
+ * HL_SHA256_MANY_MAX_THREADS threads (the caller's included).
+ * Returns 0, or -1 if an item has NULL data and a non-zero length. */
+int hl_cap_crypto_sha256_many(HlSha256Item *items, size_t n);
+
 /* ── HMAC-SHA256 ─────────────────────────────────────────────────────── */
 
 int hl_cap_crypto_hmac_sha256(const uint8_t *key, size_t key_len,
                               const uint8_t *msg, size_t msg_len,
                               uint8_t out[32]);
 
+/* Compare two len-byte buffers in time that depends only on len, for
+ * secrets and tokens. Returns 1 if equal, 0 otherwise. */
+int hl_cap_crypto_equal(const void *a, const void *b, size_t len);
+
 /* Constant-time HMAC-SHA256 verify. Returns 0 on match, -1 on mismatch. */
 int hl_cap_crypto_hmac_sha256_verify(const uint8_t *key, size_t key_len,
                                       const uint8_t *msg, size_t msg_len,
@@ -38,6 +62,21 @@ int hl_cap_crypto_pbkdf2(const char *password, size_t pw_len,
                            int iterations,
                            uint8_t *out, size_t out_len);
 
+/* ── Password hashing ────────────────────────────────────────────────── */
+
+/* "pbkdf2:<iterations>:<salt_hex>:<hash_hex>" plus NUL */
+#define HL_PASSWORD_HASH_MAX 128
+
+/* Hash with a fresh 16-byte salt and HL_PBKDF2_ITERATIONS into `out`
+ * (at least HL_PASSWORD_HASH_MAX bytes). Returns 0 or -1. */
+int hl_cap_crypto_password_hash(const char *password, size_t pw_len,
+                                char *out, size_t out_size);
+
+/* Constant-time check against a stored hash string.
+ * Returns 1 on match, 0 on mismatch or malformed input. */
+int hl_cap_crypto_password_verify(const char *password, size_t pw_len,
+                                  const char *stored);
+
 int hl_cap_crypto_ed25519_verify(const uint8_t *msg, size_t msg_len,
                                    const uint8_t sig[64],
                                    const uint8_t pubkey[32]);
@@ -41,6 +41,17 @@ int hl_cap_db_query(HlStmtCache *cache, const char *sql,
                     HlRowCallback cb, void *ctx,
                     HlAllocator *alloc);
 
+/*
+ * Like hl_cap_db_query, but for cursors whose callback runs more queries
+ * (db.each): the statement is prepared for this call only, and rows are
+ * handed over one at a time. cb returning non-zero stops early (not an
+ * error).
+ */
+int hl_cap_db_each(HlStmtCache *cache, const char *sql,
+                   const HlValue *params, int nparams,
+                   HlRowCallback cb, void *ctx,
+                   HlAllocator *alloc);
+
 int hl_cap_db_exec(HlStmtCache *cache, const char *sql,
                    const HlValue *params, int nparams);
 
@@ -5,6 +5,11 @@
  * host allowlists, timeouts, response size limits, and optional
  * TLS support via Keel's KlTls vtable.
  *
+ * HlHttpPool keeps connections open between requests, keyed by
+ * (scheme, host, port), so consecutive requests to one origin skip the
+ * connect and TLS handshake. Without a pool every request opens its own
+ * connection and sends "Connection: close".
+ *
  * SPDX-License-Identifier: AGPL-3.0-or-later
  */
 
@@ -13,6 +18,8 @@
 
 #include <stddef.h>
 
+typedef struct HlHttpPool HlHttpPool;
+
 /* Forward declaration — avoid pulling in keel/tls.h */
 typedef struct {
     void    *ctx;
@@ -37,6 +44,7 @@ typedef struct HlHttpConfig {
     int              timeout_ms;       /**< Connect/send/recv timeout (default: 30000) */
     size_t           max_response_size;/**< Max response body bytes (default: 4 MB) */
     void            *tls;             /**< KlTlsConfig* for HTTPS — NULL = no HTTPS */
+    HlHttpPool      *pool;            /**< Keep-alive pool — NULL = no reuse */
 } HlHttpConfig;
 
 /**
@@ -76,6 +84,28 @@ int hl_cap_http_request(const HlHttpConfig *cfg,
  */
 void hl_cap_http_free(HlHttpResponse *resp);
 
+/* ── Connection pool ───────────────────────────────────────────── */
+
+/**
+ * @brief Create a pool that keeps up to HL_HTTP_POOL_SIZE idle
+ * connections open for idle_ms after their last response.
+ *
+ * A connection goes back to the pool only after a response framed by
+ * Content-Length or chunked encoding without "Connection: close". A
+ * pooled connection the server has closed is replaced before the request
+ * is sent; one that fails before any response byte is retried once on a
+ * fresh connection (for POST/PATCH only when the send itself failed).
+ * Thread-safe.
+ *
+ * @return New pool, or NULL on allocation failure.
+ */
+HlHttpPool *hl_http_pool_create(int idle_ms);
+
+/**
+ * @brief Close every pooled connection and free the pool. NULL-safe.
+ */
+void hl_http_pool_destroy(HlHttpPool *pool);
+
 /* ── Internal helpers (exposed for unit testing) ─────────────────── */
 
 /**
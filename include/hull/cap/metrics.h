@@ -0,0 +1,92 @@
+/*
+ * metrics.h — Runtime metrics registry and Prometheus endpoint
+ *
+ * Opt-in counters and latency histograms, updated with relaxed atomic
+ * adds on the request path and read by a listener thread that serves
+ * them in the Prometheus text exposition format on its own address.
+ *
+ * Histograms use power-of-two microsecond buckets (1us .. ~16.8s, then
+ * +Inf): one count-leading-zeros per observation, resolution within 2x.
+ * Series: per-route request counts by status class and latency, per
+ * capability (db/http/smtp) latency and errors, statement cache hits,
+ * runtime heap and request-boundary GC, background job runs, audit/log
+ * drops.
+ *
+ * When disabled every hook is a single branch on hl_metrics_enabled.
+ *
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#ifndef HL_CAP_METRICS_H
+#define HL_CAP_METRICS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct HlRuntime HlRuntime;
+
+extern int hl_metrics_enabled;
+
+typedef enum {
+    HL_METRIC_DB = 0,
+    HL_METRIC_HTTP,
+    HL_METRIC_SMTP,
+    HL_METRIC_CAP_COUNT,
+} HlMetricCap;
+
+/*
+ * Register a route series at wiring time. Returns its id, or -1 when
+ * metrics are off or the table is full (the route is then not tracked).
+ */
+int hl_metrics_route(const char *method, const char *pattern);
+
+/* Monotonic start stamp; 0 when metrics are off */
+uint64_t hl_metrics_start(void);
+
+/* Record a finished handler: latency since start, status class */
+void hl_metrics_route_end(int route_id, int status, uint64_t start);
+
+/* Record a capability call; rc < 0 counts as an error */
+void hl_metrics_cap_end(HlMetricCap cap, uint64_t start, int rc);
+
+/*
+ * Register a background job series (app.every / app.at). Returns its
+ * id, or -1 when metrics are off or the table is full.
+ */
+int hl_metrics_job(const char *name);
+
+/* Record a finished job run: duration since start; rc < 0 is an error */
+void hl_metrics_job_end(int job_id, uint64_t start, int rc);
+
+/* Record fires dropped because the previous run was still going */
+void hl_metrics_job_skipped(int job_id, uint64_t n);
+
+/* Prepared statement cache lookup */
+void hl_metrics_stmt_cache(int hit);
+
+/* Snapshot heap and GC gauges of rt (after the request boundary) */
+void hl_metrics_runtime(const HlRuntime *rt);
+
+/*
+ * Render every series in the text exposition format. Returns a malloc'd
+ * NUL-terminated buffer (caller frees) and its length, or NULL.
+ */
+char *hl_metrics_render(size_t *len);
+
+/*
+ * Bind addr:port and start the listener thread; GET /metrics returns
+ * hl_metrics_render(), anything else 404. Returns 0 or -1.
+ */
+int hl_metrics_serve(const char *addr, int port);
+
+/* Start the listener thread on an already listening socket (taken over
+ * on a binary upgrade). Returns 0 or -1; fd is closed by hl_metrics_stop. */
+int hl_metrics_serve_fd(int fd);
+
+/* The listening socket, or -1 when not serving */
+int hl_metrics_fd(void);
+
+/* Stop and join the listener. Safe to call when not started. */
+void hl_metrics_stop(void);
+
+#endif /* HL_CAP_METRICS_H */
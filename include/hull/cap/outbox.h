@@ -0,0 +1,85 @@
+/*
+ * cap/outbox.h — Native outbox dispatcher
+ *
+ * Delivers the "webhook" and "http" rows hull.middleware.outbox writes
+ * to _hull_outbox, off the request path. A dispatcher thread with its
+ * own SQLite connection claims due rows in batches, hands them to a
+ * fixed set of worker threads that POST them over keep-alive
+ * connections, and records the outcomes in one transaction per batch, with
+ * the same backoff as outbox.flush(): 2^attempts * 10 s, capped at an
+ * hour, until max_attempts.
+ *
+ * Claiming moves a row's next_attempt_at HL_OUTBOX_LEASE_S ahead inside
+ * a BEGIN IMMEDIATE transaction, so outbox.flush() and other processes
+ * on the same database (an --upgrade handoff) skip it. A process that
+ * dies mid-batch leaves its rows to be retried when the lease runs out:
+ * delivery is at least once, as with flush().
+ *
+ * Other kinds ("smtp", whose credentials live in the app) stay with
+ * outbox.flush(), which skips the kinds above while the dispatcher runs.
+ *
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#ifndef HL_CAP_OUTBOX_H
+#define HL_CAP_OUTBOX_H
+
+#include <stdint.h>
+
+#include "hull/limits.h"
+
+typedef struct HlHttpConfig HlHttpConfig;
+typedef struct HlOutbox HlOutbox;
+
+typedef struct {
+    const char         *db_path;   /* same file as the app's database */
+    const HlHttpConfig *http;      /* allowlist and timeouts (copied); tls set = HTTPS */
+    const char         *ca_bundle; /* for the workers' TLS contexts, NULL = no verification */
+    int                 workers;   /* concurrent deliveries, 1..HL_OUTBOX_MAX_WORKERS */
+    int                 batch;     /* rows claimed per round (0 = default) */
+    int                 poll_ms;   /* idle re-check interval (0 = default) */
+} HlOutboxConfig;
+
+/* Delivery outcome counters since start */
+typedef struct {
+    uint64_t delivered;
+    uint64_t retried;
+    uint64_t failed;
+} HlOutboxStats;
+
+/*
+ * Open the dispatcher's database connection, and each worker's
+ * keep-alive pool and TLS client context (reading the CA bundle). No
+ * thread runs yet, so this can happen before the sandbox is applied.
+ * Returns NULL on error (logged).
+ */
+HlOutbox *hl_outbox_create(const HlOutboxConfig *cfg);
+
+/* Start the dispatcher and worker threads. Returns 0 or -1. */
+int hl_outbox_start(HlOutbox *ob);
+
+/*
+ * Check for due rows now instead of at the next poll, e.g. after a
+ * transaction that enqueued some committed. Cheap; NULL-safe.
+ */
+void hl_outbox_wake(HlOutbox *ob);
+
+/* Counters so far; zeroes for NULL */
+HlOutboxStats hl_outbox_stats(HlOutbox *ob);
+
+/*
+ * Finish the batch in flight and record it, stop and join the threads
+ * and log the totals. Wakes after this are no-ops. Idempotent; NULL is
+ * a no-op.
+ */
+void hl_outbox_stop(HlOutbox *ob);
+
+/*
+ * hl_outbox_stop(), then close the connection and free. NULL is a no-op.
+ */
+void hl_outbox_destroy(HlOutbox *ob);
+
+/* Seconds before retry `attempts` (1-based), as outbox.flush() uses */
+int64_t hl_outbox_backoff(int attempts);
+
+#endif /* HL_CAP_OUTBOX_H */
@@ -0,0 +1,174 @@
+/*
+ * cap/sched.h — Background jobs: app.every() / app.at()
+ *
+ * Jobs registered by the app are kept on a hierarchical timer wheel
+ * (HL_WHEEL_LEVELS x HL_WHEEL_SLOTS slots of HL_SCHED_TICK_MS; adding,
+ * cancelling and expiring a timer are O(1), a higher level cascades
+ * into the one below once per revolution of it) owned by a scheduler
+ * thread.
+ *
+ * Keel owns the event loop and offers no timer hook, and the runtimes
+ * are single-threaded. So the scheduler does not call into Lua or JS
+ * itself: when a job is due it sends POST HL_SCHED_PATH to the server's
+ * own listening socket (interim: under --tls every run pays for a TLS
+ * handshake, until Keel can run timers on its loop). A middleware
+ * registered ahead of the app's runs
+ * the callback on the event loop thread, between requests, with the
+ * request path's guards (stale transaction rollback, instruction limit,
+ * heap limit, request-boundary GC). The scheduler waits for that
+ * response before it arms the job again, so runs of one job never
+ * overlap; fires missed while a run was in progress are skipped and
+ * counted, not queued.
+ *
+ * app.every() intervals run on the monotonic clock; app.at() takes a
+ * five-field cron expression evaluated in UTC.
+ *
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#ifndef HL_CAP_SCHED_H
+#define HL_CAP_SCHED_H
+
+#include <keel/request.h>
+#include <keel/response.h>
+#include <stdint.h>
+
+#include "hull/limits.h"
+
+typedef struct HlRuntime HlRuntime;
+typedef struct HlSched HlSched;
+
+#define HL_SCHED_PATH      "/__hull/job"
+#define HL_SCHED_HEADER    "X-Hull-Job"
+#define HL_SCHED_ID_HEADER "X-Hull-Job-Id"
+
+/* ── Timer wheel ───────────────────────────────────────────────────── */
+
+#define HL_WHEEL_BITS   6
+#define HL_WHEEL_SLOTS  (1 << HL_WHEEL_BITS)
+#define HL_WHEEL_LEVELS 4
+
+typedef struct HlTimer {
+    struct HlTimer  *next;
+    struct HlTimer **pprev;     /* NULL when not on the wheel */
+    uint64_t         expires;   /* tick */
+} HlTimer;
+
+typedef struct {
+    uint64_t now;               /* last tick processed */
+    HlTimer *slots[HL_WHEEL_LEVELS][HL_WHEEL_SLOTS];
+} HlWheel;
+
+void hl_wheel_init(HlWheel *w, uint64_t now);
+
+/*
+ * Arm t to expire at tick `expires`; a tick not after w->now fires on
+ * the next one. Deadlines past the wheel's span (64^4 ticks) are clamped
+ * to it: the timer fires early and the caller re-arms it.
+ */
+void hl_wheel_add(HlWheel *w, HlTimer *t, uint64_t expires);
+
+/* Disarm t; no-op when it is not on the wheel */
+void hl_wheel_del(HlTimer *t);
+
+/*
+ * Process ticks up to and including `now`. Returns the expired timers as
+ * a list linked through ->next (NULL if none), already off the wheel.
+ */
+HlTimer *hl_wheel_advance(HlWheel *w, uint64_t now);
+
+/*
+ * Earliest tick at which hl_wheel_advance() may have work: the next
+ * expiry or higher-level cascade. UINT64_MAX when the wheel is empty.
+ */
+uint64_t hl_wheel_next(const HlWheel *w);
+
+/* ── Schedules ─────────────────────────────────────────────────────── */
+
+/* Cron fields as bitmasks; *_any is set when the field starts with '*' */
+typedef struct {
+    uint64_t minute;            /* bits 0-59 */
+    uint32_t hour;              /* bits 0-23 */
+    uint32_t dom;               /* bits 1-31 */
+    uint16_t month;             /* bits 1-12 */
+    uint8_t  dow;               /* bits 0-6, Sunday = 0 (7 is accepted) */
+    uint8_t  dom_any;
+    uint8_t  dow_any;
+} HlCron;
+
+/*
+ * Parse "min hour dom month dow": each field a list of *, N or N-M,
+ * each optionally /STEP. When both day fields are restricted a day
+ * matching either one matches (as in cron). Also accepts @hourly,
+ * @daily, @midnight, @weekly, @monthly, @yearly and @annually.
+ * Returns 0 or -1.
+ */
+int hl_cron_parse(const char *expr, HlCron *out);
+
+/*
+ * First matching minute strictly after `after` (UTC seconds since the
+ * epoch), as seconds. -1 when nothing matches within eight years
+ * (e.g. "0 0 30 2 *").
+ */
+int64_t hl_cron_next(const HlCron *c, int64_t after);
+
+/* Reject intervals outside [HL_SCHED_MIN_INTERVAL_MS, HL_SCHED_MAX_INTERVAL_MS] */
+int hl_sched_interval_check(int64_t ms);
+
+/*
+ * Parse an interval: a whole number with an optional unit, "ms", "s",
+ * "m", "h" or "d" (no unit = seconds), e.g. "500ms", "30s", "5m".
+ * Returns 0 or -1 (malformed or out of range).
+ */
+int hl_sched_interval_parse(const char *s, int64_t *ms);
+
+/* ── Jobs ──────────────────────────────────────────────────────────── */
+
+typedef struct HlJobDef {
+    char    name[HL_SCHED_NAME_MAX];  /* logs and metrics label */
+    int     handler_id;               /* index into the runtime's handlers */
+    int64_t every_ms;                 /* app.every: interval; 0 for app.at */
+    HlCron  cron;                     /* app.at schedule */
+    int64_t jitter_ms;                /* each run is delayed by [0, jitter] */
+} HlJobDef;
+
+/*
+ * Fill a job definition from the fields the runtimes record at
+ * registration: kind "every" (spec = interval in ms) or "at" (spec =
+ * cron expression). Returns 0 or -1.
+ */
+int hl_sched_job_def(HlJobDef *def, const char *kind, const char *spec,
+                     const char *name, int64_t jitter_ms, int handler_id);
+
+/*
+ * Create a scheduler for `count` jobs. Runs go to the runtime *rtp
+ * points at when they start (hull dev may swap it). Returns NULL on
+ * allocation failure.
+ */
+HlSched *hl_sched_create(const HlJobDef *jobs, int count, HlRuntime **rtp);
+
+/*
+ * Start the scheduler thread. Jobs are sent to the socket listen_fd is
+ * bound to (a wildcard address is reached via loopback); tls is the
+ * KlTlsConfig* of a client context when the server speaks TLS, else
+ * NULL. Returns 0 or -1.
+ */
+int hl_sched_start(HlSched *s, int listen_fd, void *tls);
+
+/*
+ * Keel middleware for HL_SCHED_PATH, registered before the app's own:
+ * runs the job named by HL_SCHED_ID_HEADER and answers 200 or 500,
+ * always short-circuiting. Answers 404 unless the request carries the
+ * scheduler's token, no proxy forwarding header, and the id of the job
+ * the scheduler is triggering at that moment (each trigger runs once).
+ * Finishes the access log line.
+ */
+int hl_sched_middleware(KlRequest *req, KlResponse *res, void *user_data);
+
+/* Route for HL_SCHED_PATH so the router knows the path; same reply */
+void hl_sched_handler(KlRequest *req, KlResponse *res, void *user_data);
+
+/* Stop and join the thread, log per-job totals, free. NULL is a no-op. */
+void hl_sched_destroy(HlSched *s);
+
+#endif /* HL_CAP_SCHED_H */
@@ -8,12 +8,20 @@
  * port, credentials, TLS mode) and the RFC 5322 envelope (from, to, cc,
  * reply-to, subject, body).
  *
+ * HlSmtpPool keeps authenticated sessions open between sends, keyed by
+ * (host, port, TLS mode, credentials), so consecutive messages skip the
+ * connect/EHLO/STARTTLS/AUTH round trips. Without a pool every send
+ * opens its own connection; hl_cap_smtp_send_many() still shares one
+ * connection across its batch.
+ *
  * SPDX-License-Identifier: AGPL-3.0-or-later
  */
 
 #ifndef HL_CAP_SMTP_H
 #define HL_CAP_SMTP_H
 
+typedef struct HlSmtpPool HlSmtpPool;
+
 /* ── Runtime configuration (per-app, set once) ───────────────────── */
 
 typedef struct HlSmtpConfig {
@@ -21,6 +29,7 @@ typedef struct HlSmtpConfig {
     int          host_count;      /* Number of entries in allowed_hosts */
     int          timeout_ms;      /* Connect/send/recv timeout (0 = default) */
     void        *tls;             /* KlTlsConfig* — opaque to callers */
+    HlSmtpPool  *pool;            /* Idle session pool (NULL = no reuse) */
 } HlSmtpConfig;
 
 /* ── Per-message envelope + connection params ────────────────────── */
@@ -58,6 +67,28 @@ typedef struct {
  */
 int hl_cap_smtp_send(const HlSmtpConfig *cfg, const HlSmtpMessage *msg);
 
+/**
+ * Send a batch of emails. Consecutive messages for the same server and
+ * credentials share one session; a rejected message is reset with RSET
+ * and does not end the session. results[i] receives 0 or -1 for msgs[i].
+ *
+ * Returns the number of messages delivered, -1 on invalid arguments.
+ */
+int hl_cap_smtp_send_many(const HlSmtpConfig *cfg, const HlSmtpMessage *msgs,
+                          int count, int *results);
+
+/* ── Session pool ────────────────────────────────────────────────── */
+
+/**
+ * Create a pool that keeps up to HL_SMTP_POOL_SIZE sessions open for
+ * idle_ms after their last message. Expired sessions are closed lazily,
+ * on the next send. Thread-safe. Returns NULL on allocation failure.
+ */
+HlSmtpPool *hl_smtp_pool_create(int idle_ms);
+
+/** QUIT and close every pooled session, then free the pool. NULL-safe. */
+void hl_smtp_pool_destroy(HlSmtpPool *pool);
+
 /* ── Internal helpers (exposed for unit testing) ─────────────────── */
 
 /** Base64-encode src into dst. Returns output length or -1 on error. */
@@ -73,4 +104,11 @@ int hl_smtp_parse_response(const char *line, int len);
 /** Format an RFC 5322 message into buf with dot-stuffing. Returns length or -1. */
 int hl_smtp_format_message(const HlSmtpMessage *msg, char *buf, int size);
 
+/* EHLO extensions the client acts on */
+#define HL_SMTP_EXT_PIPELINING 0x01   /* RFC 2920 command pipelining */
+#define HL_SMTP_EXT_STARTTLS   0x02   /* RFC 3207 */
+
+/** Parse a (multi-line) EHLO response into HL_SMTP_EXT_* bits. */
+unsigned hl_smtp_parse_ehlo(const char *resp);
+
 #endif /* HL_CAP_SMTP_H */
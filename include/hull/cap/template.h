@@ -0,0 +1,134 @@
+/*
+ * cap/template.h — Native template renderer
+ *
+ * hull.template (Lua) and hull:template (JS) lex, parse and flatten
+ * templates (inheritance + includes), then emit a compact bytecode
+ * program instead of runtime source. The program is executed here and
+ * shared by both runtimes: each runtime supplies an HlTplOps vtable that
+ * reads its own values (Lua tables, JS objects) into a small register
+ * file, and output is appended — HTML-escaped with a vectorized scan —
+ * into a single growable buffer.
+ *
+ * Bytecode layout (multi-byte operands little-endian, jump targets are
+ * absolute offsets into the program):
+ *
+ *   header  "HTPL" u8 version, u8 nregs, u16 reserved
+ *   TEXT    u32 len, bytes            append literal text
+ *   GET     dst, obj, u16 len, bytes  r[dst] = r[obj][key]  (nil-safe)
+ *   STR     dst, u32 len, bytes       r[dst] = string literal
+ *   NIL     dst                       r[dst] = nil
+ *   FILTER  id, dst, src, arg         r[dst] = filter(r[src][, r[arg]])
+ *   OUT     src, escape               append r[src] (escape: 0 or 1)
+ *   JMPF    src, u32 target           jump if r[src] is falsy
+ *   JMPT    src, u32 target           jump if r[src] is truthy
+ *   JMP     u32 target
+ *   NEXT    coll, state, key, val, u8 kv, u32 exit
+ *                                     next element of r[coll] into r[key]
+ *                                     / r[val]; iterator state lives in
+ *                                     r[state] and r[state + 1] (both nil
+ *                                     before the first NEXT); jump to exit
+ *                                     when exhausted
+ *   END
+ *
+ * Register operands are u8; register 0 holds the data argument.
+ * HL_TPL_NO_REG marks an absent FILTER argument or NEXT key.
+ *
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#ifndef HL_CAP_TEMPLATE_H
+#define HL_CAP_TEMPLATE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct HlAllocator HlAllocator;
+
+#define HL_TPL_MAGIC        "HTPL"
+#define HL_TPL_VERSION      1
+#define HL_TPL_HEADER_SIZE  8
+#define HL_TPL_NO_REG       0xFF
+
+enum {
+    HL_TPL_OP_END    = 0,
+    HL_TPL_OP_TEXT   = 1,
+    HL_TPL_OP_GET    = 2,
+    HL_TPL_OP_STR    = 3,
+    HL_TPL_OP_NIL    = 4,
+    HL_TPL_OP_FILTER = 5,
+    HL_TPL_OP_OUT    = 6,
+    HL_TPL_OP_JMPF   = 7,
+    HL_TPL_OP_JMPT   = 8,
+    HL_TPL_OP_JMP    = 9,
+    HL_TPL_OP_NEXT   = 10,
+};
+
+/* Filter ids — `raw` is resolved at compile time (OUT escape = 0) */
+enum {
+    HL_TPL_F_UPPER   = 1,
+    HL_TPL_F_LOWER   = 2,
+    HL_TPL_F_TRIM    = 3,
+    HL_TPL_F_LENGTH  = 4,
+    HL_TPL_F_DEFAULT = 5,
+    HL_TPL_F_JSON    = 6,
+    HL_TPL_F_COUNT
+};
+
+/* Filter name for an id ("upper", ...), NULL if unknown */
+const char *hl_tpl_filter_name(int id);
+
+/* ── Output buffer ──────────────────────────────────────────────────── */
+
+typedef struct {
+    char        *data;
+    size_t       len;
+    size_t       cap;
+    HlAllocator *alloc;    /* NULL = raw malloc */
+    int          oom;      /* set when the buffer failed to grow */
+} HlTplBuf;
+
+void hl_tpl_buf_init(HlTplBuf *b, HlAllocator *alloc);
+void hl_tpl_buf_free(HlTplBuf *b);
+
+/* Append bytes / HTML-escaped bytes (& < > " ' `). 0 or -1 on OOM. */
+int hl_tpl_buf_append(HlTplBuf *b, const char *s, size_t n);
+int hl_tpl_buf_escape(HlTplBuf *b, const char *s, size_t n);
+
+/* ── Runtime value access ───────────────────────────────────────────── */
+
+/*
+ * Implemented by each runtime over its own register file. Every op
+ * returns 0 on success or -1 with an error pending in the runtime
+ * (truthy/next return 1/0 on success). An absent FILTER argument or
+ * NEXT key is passed as -1.
+ */
+typedef struct {
+    int (*get)(void *ud, int dst, int obj, const char *key, size_t len);
+    int (*set_str)(void *ud, int dst, const char *s, size_t len);
+    int (*set_nil)(void *ud, int dst);
+    int (*truthy)(void *ud, int src);
+    int (*next)(void *ud, int coll, int state, int key, int val, int kv);
+    int (*filter)(void *ud, int id, int dst, int src, int arg);
+    int (*out)(void *ud, int src, int escape, HlTplBuf *buf);
+} HlTplOps;
+
+/* ── Programs ───────────────────────────────────────────────────────── */
+
+/*
+ * Validate a program: header, operand bounds, register indices and jump
+ * targets (must land on an instruction). Programs come from embedded
+ * entries or the stdlib emitters, so this runs once at load time and
+ * hl_tpl_render does no further checking.
+ * Returns the register count (>= 1), or -1 if malformed.
+ */
+int hl_tpl_check(const uint8_t *code, size_t len);
+
+/*
+ * Execute a validated program. The caller sets up `nregs` registers
+ * with the data argument in register 0. Returns 0, or -1 if an op
+ * failed or the output buffer could not grow (out->oom is then set).
+ */
+int hl_tpl_render(const uint8_t *code, const HlTplOps *ops, void *ud,
+                  HlTplBuf *out);
+
+#endif /* HL_CAP_TEMPLATE_H */
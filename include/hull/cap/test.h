@@ -30,6 +30,28 @@ typedef struct {
     char error[1024];  /* error message if failed, empty if passed */
 } HlTestCaseResult;
 
+/* ── In-process dispatch ───────────────────────────────────────────── */
+
+typedef struct {
+    int status;
+    const char *body;       /* malloc'd copy (caller frees), NULL if empty */
+    size_t body_len;
+    const char *hdr_buf;
+    size_t hdr_len;
+} HlTestResult;
+
+/*
+ * Build a KlRequest on the stack, match a route, call its handler and
+ * return the response. No TCP and no middleware. Used by the Lua and JS
+ * test bindings and by hull bench. Returns 0 (result->status is 404/405
+ * when nothing matched), -1 on bad arguments or allocation failure.
+ */
+int hl_cap_test_dispatch(KlRouter *router, const char *method,
+                         const char *path, const char *body_data,
+                         size_t body_len, const char *const *header_names,
+                         const char *const *header_values, int num_headers,
+                         HlTestResult *result);
+
 /* ── Lua bindings ──────────────────────────────────────────────────── */
 
 #ifdef HL_ENABLE_LUA
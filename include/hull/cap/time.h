@@ -13,6 +13,7 @@
 int64_t hl_cap_time_now(void);
 int64_t hl_cap_time_now_ms(void);
 int64_t hl_cap_time_clock(void);
+int64_t hl_cap_time_clock_ns(void);   /* monotonic, for measuring durations */
 int hl_cap_time_date(char *buf, size_t buf_size);
 int hl_cap_time_datetime(char *buf, size_t buf_size);
 
@@ -142,6 +142,8 @@ int hl_tool_rmdir(const char *path, const HlToolUnveilCtx *ctx);
  *   tool.file_exists(path)        — check existence, return bool
  *   tool.stderr(msg)              — write to stderr
  *   tool.loadfile(path)           — load Lua chunk, return function or nil+err
+ *   tool.compile_lua(src, name)   — precompile to bytecode, return string or nil+err
+ *   tool.compile_js(src, name)    — QuickJS module bytecode (JS builds only)
  *   tool.extract_platform(dir)    — extract embedded platform .a, return bool
  *   tool.extract_platform_cosmo(dir) — extract multi-arch + .aarch64/ layout
  *   tool.platform_archs()         — return table of embedded arch names or nil
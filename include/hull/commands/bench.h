@@ -0,0 +1,12 @@
+/*
+ * commands/bench.h — hull bench subcommand
+ *
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#ifndef HL_COMMANDS_BENCH_H
+#define HL_COMMANDS_BENCH_H
+
+int hl_cmd_bench(int argc, char **argv, const char *hull_exe);
+
+#endif /* HL_COMMANDS_BENCH_H */
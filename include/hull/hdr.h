@@ -0,0 +1,43 @@
+/*
+ * hdr.h — Log-linear latency histogram (HDR style)
+ *
+ * Values are bucketed by their power of two, and each power of two is
+ * split into 2^HL_HDR_SUB_BITS linear sub-buckets, so every recorded
+ * value is kept to within 1/128 (< 0.8%) of its true value across the
+ * whole uint64 range, in fixed memory and O(1) per record. Percentile
+ * queries return the highest value equivalent to the bucket they land
+ * in, as HdrHistogram does.
+ *
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#ifndef HL_HDR_H
+#define HL_HDR_H
+
+#include <stdint.h>
+
+#define HL_HDR_SUB_BITS  7
+#define HL_HDR_BUCKETS   ((64 - HL_HDR_SUB_BITS + 1) << HL_HDR_SUB_BITS)
+
+typedef struct {
+    uint64_t counts[HL_HDR_BUCKETS];
+    uint64_t total;
+    uint64_t min;
+    uint64_t max;
+    double   sum;
+} HlHdr;
+
+void hl_hdr_init(HlHdr *h);
+
+void hl_hdr_record(HlHdr *h, uint64_t value);
+
+/* Add every sample of src to dst. */
+void hl_hdr_merge(HlHdr *dst, const HlHdr *src);
+
+/* Value at percentile pct (0-100). 0 when empty; pct 100 is the max. */
+uint64_t hl_hdr_percentile(const HlHdr *h, double pct);
+
+/* Arithmetic mean of the recorded values (exact). 0 when empty. */
+double hl_hdr_mean(const HlHdr *h);
+
+#endif /* HL_HDR_H */
@@ -14,10 +14,21 @@
 
 #define HL_MODULE_PATH_MAX    4096              /* Max resolved module path length */
 #define HL_MODULE_MAX_SIZE    (10 * 1024 * 1024) /* 10 MB max module file */
+#define HL_LUA_BYTECODE_SUFFIX ".luac"          /* Precompiled chunk entry: "<name>.luac" */
+#define HL_JS_BYTECODE_SUFFIX  ".jsc"           /* Precompiled module entry: "<name>.jsc" (".js" stripped) */
+#define HL_TPL_BYTECODE_SUFFIX ".tplc"          /* Precompiled template program: "templates/<name>.tplc" */
 
 /* ── HTTP / body ────────────────────────────────────────────────────── */
 
 #define HL_BODY_MAX_SIZE      (1024 * 1024)     /* 1 MB request body */
+#define HL_BODY_MAX_BUFFER    (64 * 1024 * 1024) /* Largest max_body of a buffered route */
+#define HL_BODY_STREAM_SIZE   (1024LL * 1024 * 1024) /* 1 GB default for stream/spool routes */
+#define HL_BODY_BLOB_SIZE     (64LL * 1024 * 1024) /* Default for blob routes (reserved up front) */
+#define HL_BODY_MAX_BLOB      1000000000LL      /* SQLite's default SQLITE_MAX_LENGTH */
+#define HL_BODY_BLOB_FLUSH    (256 * 1024)      /* Bytes staged per sqlite3_blob_write */
+#define HL_BODY_DIR_MAX       256               /* Spool directory path */
+#define HL_BODY_IDENT_MAX     64                /* Blob table/column name */
+#define HL_BODY_NAME_MAX      128               /* Name a spooled upload is kept under */
 #define HL_QUERY_BUF_SIZE     4096              /* Query string parse buffer */
 #define HL_PARAM_NAME_MAX     256               /* Route param name buffer */
 
@@ -28,11 +39,16 @@
 #define HL_DEFAULT_MAX_CONN   256
 #define HL_DEFAULT_READ_TIMEOUT_MS 30000
 #define HL_DEFAULT_DRAIN_TIMEOUT_MS 5000        /* 5s graceful shutdown */
+#define HL_UPGRADE_READY_TIMEOUT_MS 120000      /* SIGUSR2: new binary must be ready in 2 min */
 
 /* ── Crypto ─────────────────────────────────────────────────────────── */
 
 #define HL_RANDOM_MAX_BYTES   65536             /* crypto.random() max */
 #define HL_PBKDF2_ITERATIONS  100000
+#define HL_SHA256_MANY_MAX_THREADS 8            /* sha256_many() workers */
+#define HL_SHA256_MANY_MIN_BYTES   (256 * 1024) /* Smaller batches stay serial */
+#define HL_SIG_HASH_BATCH          256          /* Files per --verify-sig batch */
+#define HL_SIG_HASH_BATCH_BYTES    (32 * 1024 * 1024)
 
 /* ── HTTP client ────────────────────────────────────────────────────── */
 
@@ -41,6 +57,8 @@
 #define HL_HTTP_DEFAULT_TIMEOUT_MS 30000               /* Connect/send/recv timeout */
 #define HL_HTTP_DEFAULT_MAX_RESP   (4 * 1024 * 1024)   /* 4 MB max response body */
 #define HL_HTTP_RECV_BUF_SIZE      8192                /* Response recv buffer */
+#define HL_HTTP_POOL_SIZE          16                  /* Idle keep-alive connections kept */
+#define HL_HTTP_DEFAULT_IDLE_MS    30000               /* Close pooled connections idle this long */
 
 /* ── SMTP client ───────────────────────────────────────────────────── */
 
@@ -48,6 +66,10 @@
 #define HL_SMTP_SEND_BUF_SIZE      1024                /* SMTP command buffer */
 #define HL_SMTP_DEFAULT_TIMEOUT_MS 30000               /* Connect/send/recv timeout */
 #define HL_SMTP_MAX_MSG_SIZE       (10 * 1024 * 1024)  /* 10 MB max formatted message */
+#define HL_SMTP_DEFAULT_IDLE_MS    30000               /* Keep pooled sessions open */
+#define HL_SMTP_POOL_SIZE          4                   /* Pooled sessions per process */
+#define HL_SMTP_SESSION_MAX_MSGS   100                 /* Messages before reconnecting */
+#define HL_SMTP_MAX_BATCH          1000                /* Messages per smtp.send_many */
 
 /* ── Runtime memory ─────────────────────────────────────────────────── */
 
@@ -56,6 +78,76 @@
 #define HL_JS_DEFAULT_HEAP    (64 * 1024 * 1024)  /* 64 MB */
 #define HL_JS_DEFAULT_STACK   (1 * 1024 * 1024)   /* 1 MB */
 #define HL_JS_GC_THRESHOLD    (256 * 1024)         /* 256 KB */
+#define HL_JS_GC_HEADROOM     (8 * 1024 * 1024)    /* request mode: mid-handler GC backstop */
+#define HL_LUA_GC_MINOR_MUL   20                   /* generational: young collection at +20% */
+#define HL_LUA_GC_MAJOR_MUL   100                  /* generational: major collection at +100% */
+#define HL_LUA_GC_PAUSE       200                  /* incremental: Hull starts a cycle at 2x heap */
+#define HL_LUA_GC_BACKSTOP    1000                 /* incremental: Lua's own pause, backstop only */
+#define HL_GC_BUDGET_US       1000                 /* per-request boundary GC pause budget */
+#define HL_POOL_CHUNK_SIZE    (64 * 1024)          /* size-class pool slab */
+#define HL_POOL_MAX_SIZE      1024                 /* larger requests go to malloc */
+
+/* ── Application log ────────────────────────────────────────────────── */
+
+#define HL_LOG_LINE_MAX       2048                 /* One formatted line, longer is cut */
+#define HL_LOG_BUF_SIZE       (64 * 1024)          /* Each half of the flusher's double buffer */
+#define HL_LOG_FLUSH_MS       50                   /* Flusher idle interval */
+
+/* ── Access log ─────────────────────────────────────────────────────── */
+
+#define HL_ACCESS_LOG_SLOTS   1024                 /* In-flight requests tracked (power of 2) */
+#define HL_ACCESS_LOG_PATH_MAX 512                 /* Longer paths are cut in the line */
+
+/* ── Metrics ────────────────────────────────────────────────────────── */
+
+#define HL_METRICS_MAX_ROUTES 256                  /* Routes with their own series */
+#define HL_METRICS_LABEL_MAX  128                  /* Route pattern kept for the label */
+#define HL_METRICS_BUCKETS    26                   /* le = 1us * 2^i for i < 25, then +Inf */
+#define HL_METRICS_POLL_MS    250                  /* Listener checks for shutdown this often */
+
+/* ── Audit log ──────────────────────────────────────────────────────── */
+
+#define HL_AUDIT_RING_SLOTS   4096                 /* Records in flight (power of two) */
+#define HL_AUDIT_RECORD_SIZE  1024                 /* Fixed record size, header included */
+#define HL_AUDIT_BATCH_SIZE   (64 * 1024)          /* Drain thread write() batch */
+#define HL_AUDIT_FLUSH_MS     10                   /* Drain thread idle poll */
+#define HL_AUDIT_ROTATE_BYTES (64 * 1024 * 1024)   /* --audit-file rotation size */
+
+/* ── Background jobs ────────────────────────────────────────────────── */
+
+#define HL_SCHED_MAX_JOBS     64                   /* app.every / app.at registrations */
+#define HL_SCHED_NAME_MAX     64                   /* Job name kept for logs and metrics */
+#define HL_SCHED_TICK_MS      10                   /* Timer wheel resolution */
+#define HL_SCHED_MIN_INTERVAL_MS 100               /* Shortest app.every interval */
+#define HL_SCHED_MAX_INTERVAL_MS (366LL * 86400000) /* Longest interval or jitter */
+#define HL_SCHED_MAX_SLEEP_MS 1000                 /* Scheduler re-reads the clocks this often */
+#define HL_SCHED_TIMEOUT_MS   60000                /* Scheduler waits this long for a run */
+
+/* ── Outbox dispatcher ──────────────────────────────────────────────── */
+
+#define HL_OUTBOX_MAX_WORKERS 64                   /* --outbox-workers upper bound */
+#define HL_OUTBOX_BATCH       64                   /* Rows claimed per round */
+#define HL_OUTBOX_POLL_MS     1000                 /* Idle re-check without a wake-up */
+#define HL_OUTBOX_LEASE_S     600                  /* Claimed rows are retried after this */
+#define HL_OUTBOX_ERROR_MAX   256                  /* last_error kept per delivery */
+
+/* ── Dev server ─────────────────────────────────────────────────────── */
+
+#define HL_WATCH_DEBOUNCE_MS  100                  /* Quiet time before a change is reported */
+#define HL_WATCH_POLL_MS      1000                 /* mtime scan interval without inotify/kqueue */
+#define HL_DEV_RELOAD_TIMEOUT_MS 30000             /* hull dev waits this long for a reload */
+
+/* ── hull test ──────────────────────────────────────────────────────── */
+
+#define HL_TEST_MAX_JOBS      64                   /* hull test -j upper bound */
+
+/* ── hull bench ─────────────────────────────────────────────────────── */
+
+#define HL_BENCH_MAX_REQUESTS 64                   /* entries in a request mix */
+#define HL_BENCH_MAX_HEADERS  16                   /* headers per scripted request */
+#define HL_BENCH_MAX_CONNS    1024                 /* loopback keep-alive connections */
+#define HL_BENCH_MAX_REQ_SIZE (64 * 1024)          /* expanded request (line + headers + body) */
+#define HL_BENCH_IO_TIMEOUT_MS 10000               /* loopback: abort after this long without progress */
 
 /* ── Instruction limits ────────────────────────────────────────────── */
 
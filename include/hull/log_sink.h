@@ -0,0 +1,71 @@
+/*
+ * log_sink.h — Buffered log backend for rxi/log.c
+ *
+ * hl_log_sink_callback() is registered with log_add_callback(). Each
+ * line is formatted into a per-thread buffer (timestamp cached per
+ * second) and appended to a shared double buffer; a flusher thread
+ * writes whole buffers to the output fd. When the buffer is full the
+ * policy decides: HL_LOG_BLOCK waits for the flusher, HL_LOG_DROP
+ * discards the line and counts it.
+ *
+ * Until hl_log_sink_start() (and after hl_log_sink_stop()) lines are
+ * written to stderr synchronously, one write(2) per line.
+ *
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#ifndef HL_LOG_SINK_H
+#define HL_LOG_SINK_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "log.h"
+
+typedef enum {
+    HL_LOG_TEXT = 0,     /* "12:00:01 INFO  msg" */
+    HL_LOG_JSON,         /* {"ts":"...","level":"info","msg":"..."} */
+    HL_LOG_LOGFMT,       /* ts=... level=info msg="..." */
+} HlLogFormat;
+
+typedef enum {
+    HL_LOG_BLOCK = 0,    /* wait for the flusher when the buffer is full */
+    HL_LOG_DROP,         /* discard and count */
+} HlLogPolicy;
+
+/* Parse "text"|"json"|"logfmt" / "block"|"drop". Returns -1 if unknown. */
+int hl_log_sink_parse_format(const char *s);
+int hl_log_sink_parse_policy(const char *s);
+
+/* Output format; applies to synchronous writes too */
+void hl_log_sink_set_format(HlLogFormat format);
+
+/* Start the flusher thread writing to fd. Returns 0 or -1. */
+int hl_log_sink_start(int fd, HlLogPolicy policy);
+
+/* Flush buffered lines and join the flusher. Safe when not started. */
+void hl_log_sink_stop(void);
+
+/* log_LogFn for log_add_callback(); udata is unused */
+void hl_log_sink_callback(log_Event *ev);
+
+/* One key/value of a structured line: a string, or num when str is NULL */
+typedef struct {
+    const char *key;
+    const char *str;
+    size_t      str_len;
+    uint64_t    num;
+} HlLogField;
+
+/*
+ * Write "msg k=v ..." in the sink's format (JSON: extra members, numbers
+ * bare). Bypasses log.c and its level filter; for native emitters such
+ * as the access log that already have their fields apart.
+ */
+void hl_log_sink_fields(int level, const char *msg,
+                        const HlLogField *fields, int count);
+
+/* Lines discarded under HL_LOG_DROP */
+uint64_t hl_log_sink_dropped(void);
+
+#endif /* HL_LOG_SINK_H */
@@ -43,12 +43,21 @@ typedef struct HlManifest {
     const char *csp;        /* Custom CSP string (NULL if not set or disabled) */
     int         csp_set;    /* 1 if app explicitly set csp key in manifest */
 
+    /* Native access log (access_log = true) */
+    int         access_log;
+
     /* Whether app.manifest() was called */
     int         present;
 } HlManifest;
 
 /* ── API ───────────────────────────────────────────────────────────── */
 
+/*
+ * Compare two extracted manifests by content (all capability lists,
+ * CSP and flags). Returns 1 if equal, 0 otherwise.
+ */
+int hl_manifest_equal(const HlManifest *a, const HlManifest *b);
+
 /*
  * Extract manifest from Lua registry key "__hull_manifest".
  * Populates `out` with string pointers into the Lua state
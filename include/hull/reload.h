@@ -0,0 +1,58 @@
+/*
+ * reload.h — In-process app reload for hull dev
+ *
+ * The dev server registers POST /__hull/reload. When `hull dev` sees a
+ * source change it calls that endpoint with the token it passed in
+ * HULL_DEV_RELOAD; the server builds a fresh runtime, loads the app into
+ * it and, if the routes, middleware and manifest are unchanged, points
+ * the contexts already wired into Keel at the new runtime. The listening
+ * socket, database, statement cache and sandbox stay as they are.
+ *
+ * The handler runs on the event loop thread, so the swap happens
+ * between requests and needs no locking. Anything that changes what was
+ * wired into Keel or the sandbox (a new route, a different manifest)
+ * answers 409 and `hull dev` falls back to restarting the process.
+ *
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#ifndef HL_RELOAD_H
+#define HL_RELOAD_H
+
+#include <keel/request.h>
+#include <keel/response.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "hull/manifest.h"
+#include "hull/runtime.h"
+
+#define HL_RELOAD_PATH   "/__hull/reload"
+#define HL_RELOAD_HEADER "X-Hull-Reload"
+#define HL_RELOAD_ENV    "HULL_DEV_RELOAD"
+
+typedef struct {
+    HlRuntime   *rt;            /* serving runtime */
+    size_t       rt_size;       /* size of the concrete runtime struct */
+    const void  *rt_cfg;        /* config passed to vt->init */
+    const char  *entry_point;
+    HlManifest  *manifest;      /* startup manifest; strings follow rt */
+    const char  *token;         /* expected HL_RELOAD_HEADER value */
+    int          owned;         /* rt was allocated by hl_reload_run */
+    uint64_t     count;         /* successful reloads */
+} HlReload;
+
+/*
+ * Load the app into a new runtime and swap it in. Returns 0 on success,
+ * 1 if a restart is needed (routes, middleware or manifest changed),
+ * -1 if the app failed to load (the old runtime keeps serving).
+ */
+int hl_reload_run(HlReload *r);
+
+/*
+ * Keel handler for HL_RELOAD_PATH: 200 reloaded, 409 restart needed,
+ * 500 load failed; 404 without the right token.
+ */
+void hl_reload_handler(KlRequest *req, KlResponse *res, void *user_data);
+
+#endif /* HL_RELOAD_H */
@@ -11,6 +11,7 @@
 #define HL_RUNTIME_H
 
 #include <stddef.h>
+#include <stdint.h>
 
 /* Forward declarations */
 typedef struct HlAllocator HlAllocator;
@@ -19,6 +20,8 @@ typedef struct HlEnvConfig HlEnvConfig;
 typedef struct HlHttpConfig HlHttpConfig;
 typedef struct HlSmtpConfig HlSmtpConfig;
 typedef struct HlManifest HlManifest;
+typedef struct HlOutbox HlOutbox;
+typedef struct HlJobDef HlJobDef;
 typedef struct HlStmtCache HlStmtCache;
 typedef struct HlVfs HlVfs;
 typedef struct sqlite3 sqlite3;
@@ -26,6 +29,46 @@ typedef struct KlServer KlServer;
 
 typedef struct HlRuntime HlRuntime;
 
+/*
+ * Garbage collection pacing. In request mode the short-lived objects of
+ * a request are collected together once the handler returns: Lua runs
+ * in generational mode with one young collection per request (objects
+ * that escape into globals/upvalues survive it and are promoted to the
+ * old generation); QuickJS, whose refcounting already frees acyclic
+ * request objects, runs its cycle collector at the request boundary
+ * when the heap grew by gc_threshold instead of mid-handler.
+ */
+typedef enum {
+    HL_GC_REQUEST     = 0,  /* collect at request boundaries (default) */
+    HL_GC_INCREMENTAL = 1,  /* engine's own allocation-driven pacing */
+} HlGcMode;
+
+/*
+ * Collector work done at request boundaries. A pause longer than the
+ * runtime's gc_budget_us counts as over budget.
+ */
+typedef struct {
+    uint64_t runs;          /* boundary collections that did work */
+    uint64_t total_ns;      /* time spent in them */
+    uint64_t max_ns;        /* longest single pause */
+    uint64_t over_budget;   /* pauses longer than the budget */
+    uint64_t bytes_freed;   /* heap shrinkage across them */
+} HlGcStats;
+
+static inline void hl_gc_stats_record(HlGcStats *s, uint64_t ns,
+                                      uint64_t budget_ns,
+                                      size_t heap_before, size_t heap_after)
+{
+    s->runs++;
+    s->total_ns += ns;
+    if (ns > s->max_ns)
+        s->max_ns = ns;
+    if (ns > budget_ns)
+        s->over_budget++;
+    if (heap_before > heap_after)
+        s->bytes_freed += heap_before - heap_after;
+}
+
 typedef struct HlRuntimeVtable {
     int   (*init)(HlRuntime *rt, const void *config);
     int   (*load_app)(HlRuntime *rt, const char *filename);
@@ -33,6 +76,24 @@ typedef struct HlRuntimeVtable {
                                 void *(*alloc_fn)(size_t));
     int   (*extract_manifest)(HlRuntime *rt, HlManifest *out);
     void  (*free_manifest_strings)(HlRuntime *rt, HlManifest *m);
+    /*
+     * Take over the route and middleware contexts `from` wired into
+     * Keel, so they dispatch into rt. Both must be the same runtime with
+     * the app loaded; returns 0 when they registered identical routes
+     * and middleware, 1 when the tables differ (nothing changed).
+     */
+    int   (*adopt_routes)(HlRuntime *rt, HlRuntime *from);
+    /*
+     * Background jobs registered with app.every() / app.at(): fill up
+     * to max definitions and return how many (-1 on a malformed entry).
+     */
+    int   (*extract_jobs)(HlRuntime *rt, HlJobDef *out, int max);
+    /*
+     * Run job callback handler_id between requests, as a request would:
+     * stale transaction rollback, fresh instruction budget and scratch,
+     * then the request boundary. Returns 0, or -1 if it raised.
+     */
+    int   (*run_job)(HlRuntime *rt, int handler_id);
     void  (*destroy)(HlRuntime *rt);
     const char *name;
 } HlRuntimeVtable;
@@ -46,9 +107,12 @@ struct HlRuntime {
     HlEnvConfig  *env_cfg;
     HlHttpConfig *http_cfg;
     HlSmtpConfig *smtp_cfg;
+    HlOutbox     *outbox;      /* native outbox dispatcher (NULL = flush() delivers all) */
     const char   *csp_policy;  /* CSP header value for HTML responses (NULL = none) */
+    const HlManifest *manifest; /* declared capabilities, checked at wiring (NULL = none) */
     const HlVfs  *app_vfs;       /* app entries (embedded + dev fallback) */
     const HlVfs  *platform_vfs;  /* stdlib entries (always embedded) */
+    HlGcStats     gc_stats;      /* request-boundary collection metrics */
 };
 
 #endif /* HL_RUNTIME_H */
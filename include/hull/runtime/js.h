@@ -14,6 +14,7 @@
 #include <stdint.h>
 #include "hull/limits.h"
 #include "hull/runtime.h"
+#include "hull/cap/body.h"
 
 /* Forward declarations */
 typedef struct JSRuntime JSRuntime;
@@ -22,6 +23,7 @@ typedef struct KlRequest KlRequest;
 typedef struct KlResponse KlResponse;
 typedef struct KlRouter KlRouter;
 typedef struct SHArena SHArena;
+typedef struct JSMallocState JSMallocState;
 
 /* ── Configuration ──────────────────────────────────────────────────── */
 
@@ -30,6 +32,8 @@ typedef struct {
     size_t  max_stack_bytes;      /* JS stack limit (default: 1 MB) */
     int64_t max_instructions;     /* 0 = unlimited */
     size_t  gc_threshold;         /* bytes before cycle GC (default: 256 KB) */
+    int     gc_mode;              /* HlGcMode (default: HL_GC_REQUEST) */
+    int     gc_budget_us;         /* boundary GC pause budget (default: 1 ms) */
 } HlJSConfig;
 
 /* Sensible defaults */
@@ -38,6 +42,8 @@ typedef struct {
     .max_stack_bytes  = HL_JS_DEFAULT_STACK,      \
     .max_instructions = HL_DEFAULT_INSTRUCTIONS,  \
     .gc_threshold     = HL_JS_GC_THRESHOLD,       \
+    .gc_mode          = HL_GC_REQUEST,            \
+    .gc_budget_us     = HL_GC_BUDGET_US,          \
 }
 
 /* ── Runtime context ────────────────────────────────────────────────── */
@@ -52,6 +58,15 @@ typedef struct HlJS {
     int64_t         instruction_count;
     int64_t         max_instructions;
 
+    /* GC pacing (see HlGcMode) */
+    int             gc_mode;
+    size_t          gc_threshold;
+    size_t          gc_growth;       /* current trigger: gc_threshold, stretched
+                                      * while collections overrun the budget */
+    size_t          gc_baseline;     /* heap size after the last boundary GC */
+    int64_t         gc_budget_ns;
+    JSMallocState  *malloc_state;    /* QuickJS heap accounting (set by allocator) */
+
     /* Module search paths */
     const char     *app_dir;         /* application root directory */
     size_t          app_dir_size;    /* allocation size for tracked free */
@@ -63,6 +78,9 @@ typedef struct HlJS {
     char           *response_body;
     size_t          response_body_size;
 
+    /* Upload behind the request being dispatched or streamed (else NULL) */
+    HlBodyUpload   *upload;
+
     /* Per-runtime response class (avoids global statics) */
     uint32_t        response_class_id;
     int             response_class_registered;
@@ -122,6 +140,16 @@ int hl_js_run_jobs(HlJS *js);
  */
 void hl_js_gc(HlJS *js);
 
+/*
+ * Request boundary: in HL_GC_REQUEST mode, run the cycle collector if
+ * the heap grew by gc_growth since the last one, then re-arm the
+ * mid-handler backstop. JS_RunGC cannot be split, so the budget is met
+ * by pacing instead: a collection that overruns it doubles gc_growth
+ * (fewer pauses, up to a quarter of the heap limit), one well under it
+ * halves gc_growth back toward gc_threshold. No-op otherwise.
+ */
+void hl_js_request_end(HlJS *js);
+
 /*
  * Reset per-request state (instruction counter, etc.).
  * Call before each request dispatch.
@@ -164,6 +192,9 @@ void hl_js_dump_error(HlJS *js);
 typedef struct {
     HlJS *js;
     int    handler_id;
+    int    metrics_id;  /* hl_metrics_route() series, -1 if untracked */
+    int    chunk_id;    /* onChunk callback of a stream route, 0 if none */
+    HlBodySpec body;    /* body mode from the route's options */
 } HlJSRoute;
 
 /*
@@ -185,6 +216,27 @@ int hl_js_wire_routes(HlJS *js, KlRouter *router);
 int hl_js_wire_routes_server(HlJS *js, KlServer *server,
                               void *(*alloc_fn)(size_t));
 
+/*
+ * Hot reload: point the route contexts that `from` wired into Keel at
+ * `js` and hand them over (freed by hl_js_free(js) from now on). Returns
+ * 0 on success, 1 if the two apps registered different routes,
+ * middleware or background jobs (every field and the order must match).
+ */
+int hl_js_adopt_routes(HlJS *js, HlJS *from);
+
+/*
+ * Background jobs from app.every() / app.at(): fill up to max
+ * definitions, return the count (-1 on a malformed entry).
+ */
+int hl_js_extract_jobs(HlJS *js, HlJobDef *out, int max);
+
+/*
+ * Run job callback handler_id with no arguments, between requests: the
+ * same stale transaction guard, instruction budget and scratch reset as
+ * a request, then hl_js_request_end(). Returns 0, or -1 if it raised.
+ */
+int hl_js_run_job(HlJS *js, int handler_id);
+
 /*
  * Dispatch a middleware call to the JS handler.
  * Returns 0 (continue), positive (short-circuit), or -1 (error).
@@ -13,6 +13,7 @@
 #include <stdint.h>
 #include "hull/limits.h"
 #include "hull/runtime.h"
+#include "hull/cap/body.h"
 
 /* Forward declarations */
 typedef struct lua_State lua_State;
@@ -28,6 +29,8 @@ typedef struct {
     size_t  max_heap_bytes;       /* Lua heap limit (default: 64 MB) */
     int     sandbox;              /* 1 = sandbox (default), 0 = full access */
     int64_t max_instructions;     /* 0 = unlimited (default: 100M) */
+    int     gc_mode;              /* HlGcMode (default: HL_GC_REQUEST) */
+    int     gc_budget_us;         /* boundary GC pause budget (default: 1 ms) */
 } HlLuaConfig;
 
 /* Sensible defaults */
@@ -35,6 +38,8 @@ typedef struct {
     .max_heap_bytes   = HL_LUA_DEFAULT_HEAP,         \
     .sandbox          = 1,                           \
     .max_instructions = HL_DEFAULT_INSTRUCTIONS,     \
+    .gc_mode          = HL_GC_REQUEST,               \
+    .gc_budget_us     = HL_GC_BUDGET_US,             \
 }
 
 /* ── Runtime context ────────────────────────────────────────────────── */
@@ -48,6 +53,11 @@ typedef struct HlLua {
     size_t          mem_used;
     size_t          mem_limit;
     int64_t         max_instructions;  /* 0 = no limit */
+    int             gc_mode;           /* HlGcMode */
+    int64_t         gc_budget_ns;
+    size_t          alloc_since_gc;    /* bytes allocated since the last boundary */
+    size_t          gc_trigger;        /* incremental: heap size that starts a cycle */
+    int             gc_cycle;          /* incremental: Hull-driven cycle in progress */
 
     /* Module search paths */
     const char     *app_dir;         /* application root directory */
@@ -60,6 +70,9 @@ typedef struct HlLua {
     char           *response_body;
     size_t          response_body_size;
 
+    /* Upload behind the request being dispatched or streamed (else NULL) */
+    HlBodyUpload   *upload;
+
     /* Tracked route allocations (freed in hl_lua_free) */
     void          **routes;
     size_t          route_count;
@@ -103,6 +116,16 @@ int hl_lua_load_app(HlLua *lua, const char *filename);
 int hl_lua_dispatch(HlLua *lua, int handler_id,
                        KlRequest *req, KlResponse *res);
 
+/*
+ * Request boundary, called by the Keel handler bridge after dispatch.
+ * HL_GC_REQUEST: one young collection. HL_GC_INCREMENTAL: once the heap
+ * doubles, Hull runs the incremental cycle in basic steps here until the
+ * pause budget is spent, resuming at the next boundary; Lua's own pacing
+ * is pushed out to HL_LUA_GC_BACKSTOP. Timing and bytes freed go to
+ * base.gc_stats.
+ */
+void hl_lua_request_end(HlLua *lua);
+
 /*
  * Destroy the Lua runtime and free all resources.
  */
@@ -150,6 +173,9 @@ void hl_lua_make_response(lua_State *L, KlResponse *res);
 typedef struct {
     HlLua *lua;
     int     handler_id;
+    int     metrics_id;  /* hl_metrics_route() series, -1 if untracked */
+    int     chunk_id;    /* on_chunk callback of a stream route, 0 if none */
+    HlBodySpec body;     /* body mode from the route's options */
 } HlLuaRoute;
 
 /*
@@ -175,6 +201,27 @@ int hl_lua_wire_routes(HlLua *lua, KlRouter *router);
 int hl_lua_wire_routes_server(HlLua *lua, KlServer *server,
                                void *(*alloc_fn)(size_t));
 
+/*
+ * Hot reload: point the route contexts that `from` wired into Keel at
+ * `lua` and hand them over (freed by hl_lua_free(lua) from now on). Returns
+ * 0 on success, 1 if the two apps registered different routes,
+ * middleware or background jobs (every field and the order must match).
+ */
+int hl_lua_adopt_routes(HlLua *lua, HlLua *from);
+
+/*
+ * Background jobs from app.every() / app.at(): fill up to max
+ * definitions, return the count (-1 on a malformed entry).
+ */
+int hl_lua_extract_jobs(HlLua *lua, HlJobDef *out, int max);
+
+/*
+ * Run job callback handler_id with no arguments, between requests: the
+ * same stale transaction guard, instruction budget and scratch reset as
+ * a request, then hl_lua_request_end(). Returns 0, or -1 if it raised.
+ */
+int hl_lua_run_job(HlLua *lua, int handler_id);
+
 /*
  * Dispatch a middleware call to the Lua handler.
  * Returns 0 (continue), positive (short-circuit), or -1 (error).
@@ -0,0 +1,50 @@
+/*
+ * upgrade.h — Zero-downtime binary upgrade on SIGUSR2
+ *
+ * With --upgrade the server forks a small helper right after binding,
+ * before the sandbox is applied (the sandboxed server can no longer fork
+ * or exec). On SIGUSR2 the helper re-executes the binary named by the
+ * original argv[0] — typically a freshly deployed `hull build` output —
+ * and hands it the listening socket(s) over a Unix socketpair
+ * (SCM_RIGHTS). The new process runs migrations, loads the app and wires
+ * routes against the inherited socket, then reports ready. Only then does
+ * the helper send SIGTERM to the old server, which drains in-flight
+ * requests (--drain-timeout) while the new one is already accepting.
+ * Both processes share one listen queue throughout, so no connection is
+ * refused.
+ *
+ * If the new binary exits or is not ready within the timeout it is
+ * killed and the old server keeps serving; SIGUSR2 can be sent again.
+ *
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#ifndef HL_UPGRADE_H
+#define HL_UPGRADE_H
+
+#define HL_UPGRADE_ENV      "HULL_UPGRADE_FD"  /* socketpair end in the new process */
+#define HL_UPGRADE_MAX_FDS  2                   /* HTTP listener, metrics listener */
+
+/*
+ * Old process: fork the helper and install the SIGUSR2 handler. argv is
+ * re-executed as is; fds are the listening sockets to hand over, fds[0]
+ * the HTTP listener. Returns 0, or -1 if the helper could not be started.
+ */
+int hl_upgrade_arm(char *const *argv, const int *fds, int nfds,
+                   int ready_timeout_ms);
+
+/* Restore SIGUSR2 and let the helper exit. Safe when not armed. */
+void hl_upgrade_disarm(void);
+
+/*
+ * New process: if started by an upgrade, receive the listening sockets
+ * into fds (at most max). Returns how many were received, 0 when this is
+ * not an upgrade, -1 if the handoff failed.
+ */
+int hl_upgrade_receive(int *fds, int max);
+
+/* New process: tell the helper to retire the old server. No-op when
+ * this is not an upgrade. */
+void hl_upgrade_ready(void);
+
+#endif /* HL_UPGRADE_H */
@@ -34,6 +34,14 @@ void hl_vfs_init(HlVfs *vfs, const HlEntry *entries, const char *root_dir);
  */
 const HlEntry *hl_vfs_find(const HlVfs *vfs, const char *name);
 
+/*
+ * O(log n) lookup of a companion entry named `name` + `suffix`
+ * (e.g. "hull.json" + ".luac" for a precompiled bytecode entry).
+ * Returns NULL if not found or the combined name is too long.
+ */
+const HlEntry *hl_vfs_find_suffixed(const HlVfs *vfs, const char *name,
+                                    const char *suffix);
+
 /*
  * O(log n) prefix query.
  * Sets *first to the first matching entry and returns the count of
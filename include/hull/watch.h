@@ -0,0 +1,60 @@
+/*
+ * watch.h — App directory change notification for hull dev
+ *
+ * inotify on Linux, kqueue on macOS/BSD, mtime polling elsewhere or
+ * when the kernel watch could not be set up (e.g. the inotify watch
+ * limit). Changes are debounced: a burst of writes from an editor save
+ * or a `git checkout` is reported once, after the tree has been quiet
+ * for the debounce interval.
+ *
+ * Watched: .lua, .js and .html files (HL_WATCH_CODE) and .sql files
+ * (HL_WATCH_RESTART — migrations only run at startup). Dot directories,
+ * node_modules, vendor and build are skipped.
+ *
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#ifndef HL_WATCH_H
+#define HL_WATCH_H
+
+#include <stddef.h>
+#include <time.h>
+
+#define HL_WATCH_NONE     0   /* timed out, nothing changed */
+#define HL_WATCH_CODE     1   /* app code or templates changed */
+#define HL_WATCH_RESTART  2   /* migrations or directory layout changed */
+
+typedef struct {
+    int     wd;         /* inotify watch descriptor / kqueue fd */
+    char   *path;
+    int     is_dir;
+} HlWatchEntry;
+
+typedef struct {
+    int           fd;           /* inotify / kqueue fd, -1 when polling */
+    const char   *backend;      /* "inotify", "kqueue" or "poll" */
+    char         *root;
+    HlWatchEntry *entries;
+    int           count;
+    int           cap;
+    time_t        poll_code;    /* poll: newest code mtime */
+    time_t        poll_sql;     /* poll: newest .sql mtime */
+} HlWatch;
+
+/*
+ * Start watching dir recursively. Falls back to polling if the kernel
+ * watch cannot be set up. Returns 0 or -1 (out of memory).
+ */
+int hl_watch_open(HlWatch *w, const char *dir);
+
+/*
+ * Wait up to timeout_ms for a change, then until nothing has changed
+ * for debounce_ms. Returns the strongest change seen (HL_WATCH_CODE or
+ * HL_WATCH_RESTART), HL_WATCH_NONE on timeout, -1 on error. EINTR
+ * returns HL_WATCH_NONE so callers can check their signal flags.
+ */
+int hl_watch_wait(HlWatch *w, int timeout_ms, int debounce_ms);
+
+void hl_watch_close(HlWatch *w);
+
+#endif /* HL_WATCH_H */
@@ -0,0 +1,57 @@
+/*
+ * zygote.h — Fork-from-warm runtime instances
+ *
+ * A zygote is a process that has already paid the startup cost: runtime
+ * init, stdlib + app load, manifest extraction, route wiring. Instead of
+ * repeating that work, callers fork() the zygote and run one unit of work
+ * (a test file, a worker) in the child. The child shares the zygote's
+ * heap copy-on-write, so spawning is cheap and any state the work mutates
+ * — runtime globals, a :memory: database — is discarded when it exits.
+ *
+ * The child reports a fixed-size result struct back over a pipe.
+ *
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#ifndef HL_ZYGOTE_H
+#define HL_ZYGOTE_H
+
+#include <stddef.h>
+#include <sys/types.h>
+
+/*
+ * Work run in the forked child. `result` points to `result_size` zeroed
+ * bytes that are sent back to the parent when fn returns. The return
+ * value becomes the child's exit status (0..255).
+ */
+typedef int (*HlZygoteFn)(void *ctx, void *result, size_t result_size);
+
+typedef struct {
+    pid_t pid;
+    int   fd;         /* read end of the result pipe */
+} HlZygoteChild;
+
+/*
+ * Fork a child from the calling (warm) process and run fn in it.
+ * stdio is flushed before forking so buffered output is not duplicated.
+ * Returns 0 on success (parent side), -1 if pipe() or fork() failed.
+ */
+int hl_zygote_spawn(HlZygoteChild *child, HlZygoteFn fn, void *ctx,
+                    size_t result_size);
+
+/*
+ * Collect a child's result and reap it. Blocks until the child exits.
+ * Returns the child's exit status, or -1 if it was killed by a signal or
+ * exited without delivering a full result (contents of `result` are then
+ * unspecified).
+ */
+int hl_zygote_wait(HlZygoteChild *child, void *result, size_t result_size);
+
+/*
+ * Spawn + wait. Returns the child's exit status, -1 on abnormal child
+ * exit, or -2 if the child could not be forked (caller may then run fn
+ * in-process).
+ */
+int hl_zygote_run(HlZygoteFn fn, void *ctx, void *result, size_t result_size);
+
+#endif /* HL_ZYGOTE_H */
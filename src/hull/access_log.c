@@ -0,0 +1,105 @@
+/*
+ * access_log.c — Native per-request access log
+ *
+ * The middleware stores {request, start, id} in a direct-mapped table
+ * keyed by the KlRequest pointer; finish looks it up again. A slot
+ * taken over by another in-flight request (or a request that never
+ * went through the middleware) still gets its line, with a fresh ID
+ * and the time spent in the producing code only.
+ *
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#include "hull/access_log.h"
+#include "hull/limits.h"
+#include "hull/log_sink.h"
+
+#include <stdio.h>
+#include <time.h>
+
+int hl_access_log_enabled = 0;
+
+typedef struct {
+    const KlRequest *req;
+    uint64_t         start_ns;
+    uint64_t         id;
+} AccessSlot;
+
+static AccessSlot slots[HL_ACCESS_LOG_SLOTS];
+static uint64_t   next_id;
+static uint64_t   emitted;
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static AccessSlot *slot_for(const KlRequest *req)
+{
+    /* Fibonacci hash of the pointer; low bits are alignment */
+    uint64_t h = (uint64_t)(uintptr_t)req * 0x9E3779B97F4A7C15ULL;
+    return &slots[(h >> 32) & (HL_ACCESS_LOG_SLOTS - 1)];
+}
+
+/* ── Middleware ────────────────────────────────────────────────────── */
+
+int hl_access_log_middleware(KlRequest *req, KlResponse *res, void *user_data)
+{
+    (void)user_data;
+    if (!hl_access_log_enabled)
+        return 0;
+
+    AccessSlot *s = slot_for(req);
+    s->req = req;
+    s->id = ++next_id;
+    s->start_ns = now_ns();
+
+    char id[20];
+    snprintf(id, sizeof(id), "%llx", (unsigned long long)s->id);
+    kl_response_header(res, "X-Request-ID", id);
+    return 0;
+}
+
+/* ── Completion ────────────────────────────────────────────────────── */
+
+void hl_access_log_finish(const KlRequest *req, int status, size_t bytes)
+{
+    if (!hl_access_log_enabled)
+        return;
+
+    uint64_t end = now_ns();
+    uint64_t id, start;
+    AccessSlot *s = slot_for(req);
+    if (s->req == req) {
+        id = s->id;
+        start = s->start_ns;
+        s->req = NULL;
+    } else {
+        id = ++next_id;
+        start = end;
+    }
+
+    char id_str[20];
+    int id_len = snprintf(id_str, sizeof(id_str), "%llx", (unsigned long long)id);
+    size_t path_len = req->path_len < HL_ACCESS_LOG_PATH_MAX
+                    ? req->path_len : HL_ACCESS_LOG_PATH_MAX;
+
+    HlLogField fields[] = {
+        { "req_id", id_str, (size_t)id_len, 0 },
+        { "method", req->method, req->method_len, 0 },
+        { "path", req->path, path_len, 0 },
+        { "status", NULL, 0, (uint64_t)(status > 0 ? status : 0) },
+        { "bytes", NULL, 0, (uint64_t)bytes },
+        { "dur_us", NULL, 0, (end - start) / 1000 },
+    };
+    hl_log_sink_fields(LOG_INFO, "access", fields,
+                       (int)(sizeof(fields) / sizeof(fields[0])));
+    emitted++;
+}
+
+uint64_t hl_access_log_count(void)
+{
+    return emitted;
+}
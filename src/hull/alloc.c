@@ -5,9 +5,231 @@
  */
 
 #include "hull/alloc.h"
+#include "hull/limits.h"
 #include <sh_arena.h>
 #include <stdint.h>
 #include <stdlib.h>
+#include <string.h>
+
+/* ── Size-class pool ───────────────────────────────────────────────── */
+
+/*
+ * Slabs are HL_POOL_CHUNK_SIZE bytes aligned to their own size, so the
+ * slab owning a block is found by masking the pointer. Every slab base
+ * is recorded in an open-addressing set; a pointer whose masked base is
+ * not in the set came from malloc. Ownership is therefore decided
+ * without trusting the caller's size argument, and the slab header is
+ * only read once the base is known to be ours.
+ *
+ * Each slab serves one size class. Freed blocks go on the class's free
+ * list; fresh blocks are bumped from the class's newest slab. Slabs are
+ * never returned to the system before hl_alloc_destroy().
+ */
+
+#define POOL_HDR_SIZE   64      /* keeps objects 64-byte aligned in the slab */
+#define POOL_NCLASSES   20
+
+static const uint16_t pool_class_size[POOL_NCLASSES] = {
+    16, 32, 48, 64, 80, 96, 112, 128,
+    160, 192, 224, 256, 320, 384, 448, 512,
+    640, 768, 896, 1024,
+};
+
+typedef struct {
+    uint32_t cls;
+    uint32_t obj_size;
+} PoolChunk;
+
+typedef struct PoolFree {
+    struct PoolFree *next;
+} PoolFree;
+
+typedef struct {
+    PoolFree *free_list;
+    char     *bump;
+    char     *bump_end;
+} PoolClass;
+
+struct HlPool {
+    PoolClass  classes[POOL_NCLASSES];
+    uint8_t    class_of[HL_POOL_MAX_SIZE / 16 + 1]; /* (size + 15) / 16 -> class */
+    uintptr_t *chunks;      /* open-addressing set of slab bases, 0 = empty */
+    size_t     chunk_cap;   /* power of two */
+    size_t     nchunks;
+};
+
+static size_t pool_hash(uintptr_t base, size_t mask)
+{
+    return (size_t)(((uint64_t)base / HL_POOL_CHUNK_SIZE)
+                    * 0x9E3779B97F4A7C15ULL >> 17) & mask;
+}
+
+static int pool_owns(const HlPool *pool, const void *ptr)
+{
+    uintptr_t base = (uintptr_t)ptr & ~(uintptr_t)(HL_POOL_CHUNK_SIZE - 1);
+    size_t mask = pool->chunk_cap - 1;
+    for (size_t i = pool_hash(base, mask); pool->chunks[i]; i = (i + 1) & mask) {
+        if (pool->chunks[i] == base)
+            return 1;
+    }
+    return 0;
+}
+
+static void pool_set_insert(uintptr_t *set, size_t cap, uintptr_t base)
+{
+    size_t mask = cap - 1;
+    size_t i = pool_hash(base, mask);
+    while (set[i])
+        i = (i + 1) & mask;
+    set[i] = base;
+}
+
+static int pool_add_chunk(HlPool *pool, int cls)
+{
+    /* Keep the set at most half full */
+    if ((pool->nchunks + 1) * 2 > pool->chunk_cap) {
+        size_t cap = pool->chunk_cap * 2;
+        uintptr_t *set = calloc(cap, sizeof(*set));
+        if (!set)
+            return -1;
+        for (size_t i = 0; i < pool->chunk_cap; i++) {
+            if (pool->chunks[i])
+                pool_set_insert(set, cap, pool->chunks[i]);
+        }
+        free(pool->chunks);
+        pool->chunks = set;
+        pool->chunk_cap = cap;
+    }
+
+    void *mem = NULL;
+    if (posix_memalign(&mem, HL_POOL_CHUNK_SIZE, HL_POOL_CHUNK_SIZE) != 0)
+        return -1;
+
+    PoolChunk *chunk = mem;
+    chunk->cls = (uint32_t)cls;
+    chunk->obj_size = pool_class_size[cls];
+    pool_set_insert(pool->chunks, pool->chunk_cap, (uintptr_t)mem);
+    pool->nchunks++;
+
+    PoolClass *c = &pool->classes[cls];
+    c->bump = (char *)mem + POOL_HDR_SIZE;
+    c->bump_end = (char *)mem + HL_POOL_CHUNK_SIZE;
+    return 0;
+}
+
+static void *pool_malloc(HlPool *pool, size_t size)
+{
+    if (size == 0 || size > HL_POOL_MAX_SIZE)
+        return malloc(size);
+
+    int cls = pool->class_of[(size + 15) >> 4];
+    PoolClass *c = &pool->classes[cls];
+
+    if (c->free_list) {
+        PoolFree *f = c->free_list;
+        c->free_list = f->next;
+        return f;
+    }
+
+    size_t obj = pool_class_size[cls];
+    if ((size_t)(c->bump_end - c->bump) < obj && pool_add_chunk(pool, cls) != 0)
+        return malloc(size);
+
+    void *p = c->bump;
+    c->bump += obj;
+    return p;
+}
+
+static void pool_free(HlPool *pool, void *ptr)
+{
+    if (!pool_owns(pool, ptr)) {
+        free(ptr);
+        return;
+    }
+    PoolChunk *chunk = (PoolChunk *)((uintptr_t)ptr &
+                                     ~(uintptr_t)(HL_POOL_CHUNK_SIZE - 1));
+    PoolFree *f = ptr;
+    f->next = pool->classes[chunk->cls].free_list;
+    pool->classes[chunk->cls].free_list = f;
+}
+
+static void *pool_realloc(HlPool *pool, void *ptr,
+                          size_t old_size, size_t new_size)
+{
+    if (!ptr)
+        return pool_malloc(pool, new_size);
+    if (!pool_owns(pool, ptr))
+        return realloc(ptr, new_size);
+
+    const PoolChunk *chunk = (const PoolChunk *)((uintptr_t)ptr &
+                                     ~(uintptr_t)(HL_POOL_CHUNK_SIZE - 1));
+    size_t obj = chunk->obj_size;
+
+    /* Still fits the block: shrink or grow in place */
+    if (new_size > 0 && new_size <= obj)
+        return ptr;
+
+    void *p = pool_malloc(pool, new_size);
+    if (!p)
+        return NULL;
+    size_t n = old_size < new_size ? old_size : new_size;
+    memcpy(p, ptr, n < obj ? n : obj);
+    pool_free(pool, ptr);
+    return p;
+}
+
+int hl_alloc_use_pool(HlAllocator *a)
+{
+    if (!a)
+        return -1;
+    if (a->pool)
+        return 0;
+
+    HlPool *pool = calloc(1, sizeof(*pool));
+    if (!pool)
+        return -1;
+    pool->chunk_cap = 64;
+    pool->chunks = calloc(pool->chunk_cap, sizeof(*pool->chunks));
+    if (!pool->chunks) {
+        free(pool);
+        return -1;
+    }
+
+    int cls = 0;
+    for (size_t i = 0; i <= HL_POOL_MAX_SIZE / 16; i++) {
+        while (pool_class_size[cls] < i * 16)
+            cls++;
+        pool->class_of[i] = (uint8_t)cls;
+    }
+
+    a->pool = pool;
+    return 0;
+}
+
+void hl_alloc_destroy(HlAllocator *a)
+{
+    if (!a || !a->pool)
+        return;
+
+    HlPool *pool = a->pool;
+    for (size_t i = 0; i < pool->chunk_cap; i++) {
+        if (pool->chunks[i])
+            free((void *)pool->chunks[i]);
+    }
+    free(pool->chunks);
+    free(pool);
+    a->pool = NULL;
+}
+
+const char *hl_alloc_backend(const HlAllocator *a)
+{
+    return (a && a->pool) ? "pool" : "libc";
+}
+
+size_t hl_alloc_pool_reserved(const HlAllocator *a)
+{
+    return (a && a->pool) ? a->pool->nchunks * (size_t)HL_POOL_CHUNK_SIZE : 0;
+}
 
 /* ── Tracked allocation functions ──────────────────────────────────── */
 
@@ -19,7 +241,7 @@ void *hl_alloc_malloc(HlAllocator *a, size_t size)
     if (a->limit > 0 && (size > a->limit || a->used > a->limit - size))
         return NULL;
 
-    void *p = malloc(size);
+    void *p = a->pool ? pool_malloc(a->pool, size) : malloc(size);
     if (p) {
         a->used += size;
         if (a->used > a->peak)
@@ -40,7 +262,8 @@ void *hl_alloc_realloc(HlAllocator *a, void *ptr,
             return NULL;
     }
 
-    void *p = realloc(ptr, new_size);
+    void *p = a->pool ? pool_realloc(a->pool, ptr, old_size, new_size)
+                      : realloc(ptr, new_size);
     if (p) {
         if (new_size > old_size) {
             a->used += new_size - old_size;
@@ -58,9 +281,15 @@ void hl_alloc_free(HlAllocator *a, void *ptr, size_t size)
 {
     if (!ptr)
         return;
-    if (a)
-        a->used = (a->used >= size) ? a->used - size : 0;
-    free(ptr);
+    if (!a) {
+        free(ptr);
+        return;
+    }
+    a->used = (a->used >= size) ? a->used - size : 0;
+    if (a->pool)
+        pool_free(a->pool, ptr);
+    else
+        free(ptr);
 }
 
 /* ── KlAllocator vtable ───────────────────────────────────────────── */
@@ -0,0 +1,1038 @@
+/*
+ * bench.c — Request-mix load generator for hull bench
+ *
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#include "hull/bench.h"
+
+#include <sh_json.h>
+#include <sh_arena.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+/* ── Helpers ───────────────────────────────────────────────────────── */
+
+static int64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static void set_err(char *err, size_t err_size, const char *msg, const char *arg)
+{
+    if (err && err_size > 0)
+        snprintf(err, err_size, "%s%s", msg, arg ? arg : "");
+}
+
+static int lower_eq(const char *a, size_t a_len, const char *b)
+{
+    size_t b_len = strlen(b);
+    if (a_len != b_len)
+        return 0;
+    for (size_t i = 0; i < a_len; i++) {
+        char c = a[i];
+        if (c >= 'A' && c <= 'Z')
+            c = (char)(c + 32);
+        if (c != b[i])
+            return 0;
+    }
+    return 1;
+}
+
+/* ── Script ────────────────────────────────────────────────────────── */
+
+static const char *json_str(const ShJsonValue *v)
+{
+    return v && sh_json_type(v) == SH_JSON_STRING
+        ? sh_json_as_string(v, NULL) : NULL;
+}
+
+static int parse_entry(HlBenchRequest *r, const ShJsonValue *v, int index,
+                       char *err, size_t err_size)
+{
+    char what[32];
+    snprintf(what, sizeof(what), "requests[%d]", index);
+
+    if (!v || sh_json_type(v) != SH_JSON_OBJECT) {
+        set_err(err, err_size, "expected an object at ", what);
+        return -1;
+    }
+
+    memset(r, 0, sizeof(*r));
+    const ShJsonValue *m = sh_json_get(v, "method");
+    r->method = m ? json_str(m) : "GET";
+    r->path = json_str(sh_json_get(v, "path"));
+    if (!r->method || !r->method[0] || !r->path || r->path[0] != '/') {
+        set_err(err, err_size, "method and an absolute path required at ", what);
+        return -1;
+    }
+
+    const ShJsonValue *b = sh_json_get(v, "body");
+    if (b) {
+        r->body = json_str(b);
+        if (!r->body) {
+            set_err(err, err_size, "body must be a string at ", what);
+            return -1;
+        }
+    }
+
+    const ShJsonValue *w = sh_json_get(v, "weight");
+    int weight = w ? sh_json_as_int(w, -1) : 1;
+    if (weight < 1 || weight > 1000000) {
+        set_err(err, err_size, "weight must be 1-1000000 at ", what);
+        return -1;
+    }
+    r->weight = (unsigned)weight;
+
+    const ShJsonValue *h = sh_json_get(v, "headers");
+    if (h) {
+        if (sh_json_type(h) != SH_JSON_OBJECT ||
+            h->u.object_val.count > HL_BENCH_MAX_HEADERS) {
+            set_err(err, err_size, "headers must be an object of at most "
+                    "16 strings at ", what);
+            return -1;
+        }
+        for (size_t i = 0; i < h->u.object_val.count; i++) {
+            const ShJsonMember *mb = &h->u.object_val.members[i];
+            const char *val = json_str(mb->value);
+            if (!val) {
+                set_err(err, err_size, "header values must be strings at ", what);
+                return -1;
+            }
+            r->header_names[r->num_headers] = mb->key;
+            r->header_values[r->num_headers] = val;
+            r->num_headers++;
+        }
+    }
+    return 0;
+}
+
+int hl_bench_script_parse(HlBenchScript *s, const char *json, size_t len,
+                          char *err, size_t err_size)
+{
+    memset(s, 0, sizeof(*s));
+
+    size_t arena_size = len * 8;
+    if (arena_size < 4096)
+        arena_size = 4096;
+    s->arena = sh_arena_create(arena_size);
+    if (!s->arena) {
+        set_err(err, err_size, "out of memory", NULL);
+        return -1;
+    }
+
+    ShJsonValue *root;
+    ShJsonStatus rc = sh_json_parse(json, len, s->arena, &root);
+    if (rc != SH_JSON_OK) {
+        set_err(err, err_size, "invalid JSON: ", sh_json_status_str(rc));
+        goto fail;
+    }
+
+    /* Either { "requests": [...] } or the bare array */
+    const ShJsonValue *list = root;
+    if (sh_json_type(root) == SH_JSON_OBJECT)
+        list = sh_json_get(root, "requests");
+    if (!list || sh_json_type(list) != SH_JSON_ARRAY ||
+        sh_json_array_len(list) == 0) {
+        set_err(err, err_size, "expected a non-empty \"requests\" array", NULL);
+        goto fail;
+    }
+    if (sh_json_array_len(list) > HL_BENCH_MAX_REQUESTS) {
+        set_err(err, err_size, "too many requests in the mix (max 64)", NULL);
+        goto fail;
+    }
+
+    for (size_t i = 0; i < sh_json_array_len(list); i++) {
+        HlBenchRequest *r = &s->reqs[s->count];
+        if (parse_entry(r, sh_json_array_get(list, i), (int)i,
+                        err, err_size) != 0)
+            goto fail;
+        s->total_weight += r->weight;
+        s->count++;
+    }
+    return 0;
+
+fail:
+    hl_bench_script_free(s);
+    return -1;
+}
+
+int hl_bench_script_load(HlBenchScript *s, const char *path,
+                         char *err, size_t err_size)
+{
+    FILE *f = fopen(path, "rb");
+    if (!f) {
+        set_err(err, err_size, "cannot open ", path);
+        return -1;
+    }
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    if (size < 0 || size > 16L * 1024 * 1024) {
+        fclose(f);
+        set_err(err, err_size, "cannot read ", path);
+        return -1;
+    }
+
+    char *data = malloc((size_t)size + 1);
+    if (!data) {
+        fclose(f);
+        set_err(err, err_size, "out of memory", NULL);
+        return -1;
+    }
+    size_t n = fread(data, 1, (size_t)size, f);
+    fclose(f);
+    data[n] = '\0';
+
+    int rc = hl_bench_script_parse(s, data, n, err, err_size);
+    free(data);
+    return rc;
+}
+
+void hl_bench_script_single(HlBenchScript *s, const char *method,
+                            const char *path)
+{
+    memset(s, 0, sizeof(*s));
+    s->reqs[0].method = method;
+    s->reqs[0].path = path;
+    s->reqs[0].weight = 1;
+    s->count = 1;
+    s->total_weight = 1;
+}
+
+void hl_bench_script_free(HlBenchScript *s)
+{
+    if (s->arena)
+        sh_arena_free(s->arena);
+    memset(s, 0, sizeof(*s));
+}
+
+/* ── Expansion ─────────────────────────────────────────────────────── */
+
+uint64_t hl_bench_rand(uint64_t *state)
+{
+    uint64_t x = *state;
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    *state = x;
+    return x * 0x2545F4914F6CDD1DULL;
+}
+
+int hl_bench_pick(const HlBenchScript *s, uint64_t *rng)
+{
+    if (s->count <= 1)
+        return 0;
+    unsigned r = (unsigned)(hl_bench_rand(rng) % s->total_weight);
+    for (int i = 0; i < s->count; i++) {
+        if (r < s->reqs[i].weight)
+            return i;
+        r -= s->reqs[i].weight;
+    }
+    return s->count - 1;
+}
+
+/* Value of the placeholder name[0..len), or -1 if it is not one of ours */
+static int placeholder(const char *name, size_t len, uint64_t seq, int conn,
+                       uint64_t *rng, uint64_t *out)
+{
+    if (len == 3 && memcmp(name, "seq", 3) == 0) {
+        *out = seq;
+        return 0;
+    }
+    if (len == 4 && memcmp(name, "conn", 4) == 0) {
+        *out = (uint64_t)conn;
+        return 0;
+    }
+    if (len == 4 && memcmp(name, "rand", 4) == 0) {
+        *out = hl_bench_rand(rng) >> 32;
+        return 0;
+    }
+    if (len > 5 && memcmp(name, "rand:", 5) == 0) {
+        uint64_t n = 0;
+        for (size_t i = 5; i < len; i++) {
+            if (name[i] < '0' || name[i] > '9' || n > UINT32_MAX)
+                return -1;
+            n = n * 10 + (uint64_t)(name[i] - '0');
+        }
+        if (n == 0)
+            return -1;
+        *out = hl_bench_rand(rng) % n;
+        return 0;
+    }
+    return -1;
+}
+
+int hl_bench_expand(const char *tmpl, uint64_t seq, int conn, uint64_t *rng,
+                    char *buf, size_t size)
+{
+    size_t o = 0;
+    const char *p = tmpl;
+
+    while (*p) {
+        if (p[0] == '{' && p[1] == '{') {
+            const char *end = strstr(p + 2, "}}");
+            uint64_t v;
+            if (end && placeholder(p + 2, (size_t)(end - p - 2),
+                                   seq, conn, rng, &v) == 0) {
+                int n = snprintf(buf + o, size - o, "%llu",
+                                 (unsigned long long)v);
+                if (n < 0 || (size_t)n >= size - o)
+                    return -1;
+                o += (size_t)n;
+                p = end + 2;
+                continue;
+            }
+        }
+        if (o + 1 >= size)
+            return -1;
+        buf[o++] = *p++;
+    }
+    if (o >= size)
+        return -1;
+    buf[o] = '\0';
+    return (int)o;
+}
+
+int hl_bench_prepare(const HlBenchScript *s, uint64_t seq, int conn,
+                     uint64_t *rng, HlBenchPrepared *out)
+{
+    int idx = hl_bench_pick(s, rng);
+    const HlBenchRequest *r = &s->reqs[idx];
+    size_t used = 0;
+    int n;
+
+    out->index = idx;
+    out->method = r->method;
+
+    n = hl_bench_expand(r->path, seq, conn, rng, out->buf, sizeof(out->buf));
+    if (n < 0)
+        return -1;
+    out->path = out->buf;
+    used = (size_t)n + 1;
+
+    out->num_headers = r->num_headers;
+    for (int i = 0; i < r->num_headers; i++) {
+        n = hl_bench_expand(r->header_values[i], seq, conn, rng,
+                            out->buf + used, sizeof(out->buf) - used);
+        if (n < 0)
+            return -1;
+        out->header_names[i] = r->header_names[i];
+        out->header_values[i] = out->buf + used;
+        used += (size_t)n + 1;
+    }
+
+    out->body = NULL;
+    out->body_len = 0;
+    if (r->body) {
+        n = hl_bench_expand(r->body, seq, conn, rng,
+                            out->buf + used, sizeof(out->buf) - used);
+        if (n < 0)
+            return -1;
+        out->body = out->buf + used;
+        out->body_len = (size_t)n;
+    }
+    return 0;
+}
+
+int hl_bench_format_http(const HlBenchPrepared *req, const char *host,
+                         int port, char *buf, size_t size)
+{
+    int has_ct = 0;
+    int n = snprintf(buf, size, "%s %s HTTP/1.1\r\nHost: %s:%d\r\n",
+                     req->method, req->path, host, port);
+    if (n < 0 || (size_t)n >= size)
+        return -1;
+    size_t o = (size_t)n;
+
+    for (int i = 0; i < req->num_headers; i++) {
+        const char *name = req->header_names[i];
+        if (lower_eq(name, strlen(name), "content-type"))
+            has_ct = 1;
+        n = snprintf(buf + o, size - o, "%s: %s\r\n", name,
+                     req->header_values[i]);
+        if (n < 0 || (size_t)n >= size - o)
+            return -1;
+        o += (size_t)n;
+    }
+
+    if (req->body) {
+        n = snprintf(buf + o, size - o, "%sContent-Length: %zu\r\n\r\n",
+                     has_ct ? "" : "Content-Type: application/octet-stream\r\n",
+                     req->body_len);
+        if (n < 0 || (size_t)n >= size - o || req->body_len >= size - o - (size_t)n)
+            return -1;
+        o += (size_t)n;
+        memcpy(buf + o, req->body, req->body_len);
+        o += req->body_len;
+    } else {
+        if (o + 2 >= size)
+            return -1;
+        buf[o++] = '\r';
+        buf[o++] = '\n';
+    }
+    return (int)o;
+}
+
+/* ── Stats ─────────────────────────────────────────────────────────── */
+
+int hl_bench_stats_init(HlBenchStats *st, int entries)
+{
+    memset(st, 0, sizeof(*st));
+    hl_hdr_init(&st->latency);
+    st->by_entry = malloc(sizeof(HlHdr) * (size_t)entries);
+    st->count_by_entry = calloc((size_t)entries, sizeof(uint64_t));
+    if (!st->by_entry || !st->count_by_entry) {
+        hl_bench_stats_free(st);
+        return -1;
+    }
+    for (int i = 0; i < entries; i++)
+        hl_hdr_init(&st->by_entry[i]);
+    st->entries = entries;
+    return 0;
+}
+
+void hl_bench_stats_free(HlBenchStats *st)
+{
+    free(st->by_entry);
+    free(st->count_by_entry);
+    st->by_entry = NULL;
+    st->count_by_entry = NULL;
+    st->entries = 0;
+}
+
+static void record(HlBenchStats *st, int entry, int status, size_t bytes,
+                   int64_t ns)
+{
+    uint64_t v = ns > 0 ? (uint64_t)ns : 0;
+    hl_hdr_record(&st->latency, v);
+    hl_hdr_record(&st->by_entry[entry], v);
+    st->count_by_entry[entry]++;
+    st->requests++;
+    st->bytes += bytes;
+    st->status[status >= 100 && status < 600 ? status / 100 : 0]++;
+}
+
+/* Measurement window bookkeeping shared by both runners */
+typedef struct {
+    const HlBenchConfig *cfg;
+    uint64_t issued;
+    int64_t  start;          /* first measured request, 0 until then */
+} BenchClock;
+
+/* Whether another request should be issued, and whether it is measured */
+static int bench_next(BenchClock *c, int *measured)
+{
+    const HlBenchConfig *cfg = c->cfg;
+    *measured = c->issued >= cfg->warmup;
+    if (*measured && c->start == 0)
+        c->start = now_ns();
+    if (cfg->duration_ms > 0) {
+        if (*measured &&
+            now_ns() - c->start >= (int64_t)cfg->duration_ms * 1000000)
+            return 0;
+    } else if (c->issued >= cfg->warmup + cfg->requests) {
+        return 0;
+    }
+    c->issued++;
+    return 1;
+}
+
+/* ── In-process ────────────────────────────────────────────────────── */
+
+int hl_bench_run_inprocess(const HlBenchScript *s, const HlBenchConfig *cfg,
+                           HlBenchDispatchFn fn, void *ctx,
+                           HlBenchStats *st)
+{
+    HlBenchPrepared *req = malloc(sizeof(*req));
+    if (!req)
+        return -1;
+
+    uint64_t rng = cfg->seed ? cfg->seed : 1;
+    BenchClock clk = { .cfg = cfg };
+    int measured;
+
+    while (bench_next(&clk, &measured)) {
+        if (hl_bench_prepare(s, clk.issued - 1, 0, &rng, req) != 0) {
+            st->errors += (uint64_t)measured;
+            continue;
+        }
+        size_t bytes = 0;
+        int64_t t0 = now_ns();
+        int status = fn(ctx, req, &bytes);
+        int64_t t1 = now_ns();
+        if (!measured)
+            continue;
+        if (status < 0)
+            st->errors++;
+        else
+            record(st, req->index, status, bytes, t1 - t0);
+    }
+
+    st->elapsed_ns = clk.start ? now_ns() - clk.start : 0;
+    free(req);
+    return 0;
+}
+
+/* ── Loopback client ───────────────────────────────────────────────── */
+
+enum { CONN_IDLE, CONN_CONNECTING, CONN_SENDING, CONN_RECEIVING, CONN_DONE };
+
+typedef struct {
+    int      fd;
+    int      state;
+    int      index;          /* connection number, for {{conn}} */
+    int      entry;          /* script entry in flight */
+    int      measured;
+    int      is_head;
+    int      served;         /* responses on the current socket */
+    int      retried;
+    int64_t  start;
+    char    *out;
+    size_t   out_len;
+    size_t   out_off;
+    char    *in;
+    size_t   in_len;
+    size_t   in_cap;
+} BenchConn;
+
+typedef struct {
+    const HlBenchScript *s;
+    HlBenchStats        *st;
+    BenchClock           clk;
+    struct sockaddr_storage addr;
+    socklen_t            addr_len;
+    const char          *host;
+    int                  port;
+    uint64_t             rng;
+    HlBenchPrepared     *req;
+    uint64_t             completed;     /* including warmup */
+    uint64_t             failures;      /* consecutive, without a response */
+    int                  last_errno;
+} BenchLoop;
+
+static void conn_close(BenchConn *c)
+{
+    if (c->fd >= 0)
+        close(c->fd);
+    c->fd = -1;
+    c->served = 0;
+}
+
+static int conn_open(BenchLoop *lp, BenchConn *c)
+{
+    c->fd = socket(lp->addr.ss_family, SOCK_STREAM, 0);
+    if (c->fd < 0) {
+        lp->last_errno = errno;
+        return -1;
+    }
+    fcntl(c->fd, F_SETFL, fcntl(c->fd, F_GETFL) | O_NONBLOCK);
+    fcntl(c->fd, F_SETFD, FD_CLOEXEC);
+    int one = 1;
+    setsockopt(c->fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+    if (connect(c->fd, (struct sockaddr *)&lp->addr, lp->addr_len) == 0) {
+        c->state = CONN_SENDING;
+        return 0;
+    }
+    if (errno == EINPROGRESS) {
+        c->state = CONN_CONNECTING;
+        return 0;
+    }
+    lp->last_errno = errno;
+    conn_close(c);
+    return -1;
+}
+
+/* (Re)send the request in c->out, connecting first if needed */
+static int conn_send(BenchLoop *lp, BenchConn *c)
+{
+    c->out_off = 0;
+    c->in_len = 0;
+    c->start = now_ns();
+    if (c->fd >= 0) {
+        c->state = CONN_SENDING;
+        return 0;
+    }
+    return conn_open(lp, c);
+}
+
+/* Start the next request on c, or park it when the run is over */
+static void conn_issue(BenchLoop *lp, BenchConn *c)
+{
+    int measured;
+    for (;;) {
+        if (!bench_next(&lp->clk, &measured)) {
+            conn_close(c);
+            c->state = CONN_DONE;
+            return;
+        }
+        uint64_t seq = lp->clk.issued - 1;
+        int n = -1;
+        if (hl_bench_prepare(lp->s, seq, c->index, &lp->rng, lp->req) == 0)
+            n = hl_bench_format_http(lp->req, lp->host, lp->port,
+                                     c->out, HL_BENCH_MAX_REQ_SIZE);
+        if (n < 0) {
+            lp->st->errors += (uint64_t)measured;
+            continue;
+        }
+        c->out_len = (size_t)n;
+        c->entry = lp->req->index;
+        c->measured = measured;
+        c->is_head = strcmp(lp->req->method, "HEAD") == 0;
+        c->retried = 0;
+        if (conn_send(lp, c) == 0)
+            return;
+        /* Connect failed outright */
+        lp->failures++;
+        lp->st->errors += (uint64_t)measured;
+        c->state = CONN_IDLE;
+        return;
+    }
+}
+
+static void conn_fail(BenchLoop *lp, BenchConn *c)
+{
+    lp->failures++;
+    lp->st->errors += (uint64_t)c->measured;
+    conn_close(c);
+    c->state = CONN_IDLE;
+}
+
+/*
+ * Parse one response at the start of buf. Returns 1 when complete
+ * (*total = its length), 0 when more bytes are needed, -1 if malformed.
+ * eof: the peer closed, which ends a body without a length.
+ */
+static int parse_response(const char *buf, size_t len, int is_head, int eof,
+                          int *status, size_t *total, int *close_conn)
+{
+    size_t hdr_end = 0;
+    for (size_t i = 3; i < len; i++) {
+        if (buf[i] == '\n' && buf[i - 1] == '\r' &&
+            buf[i - 2] == '\n' && buf[i - 3] == '\r') {
+            hdr_end = i + 1;
+            break;
+        }
+    }
+    if (hdr_end == 0)
+        return len > HL_BENCH_MAX_REQ_SIZE ? -1 : 0;
+
+    if (len < 12 || memcmp(buf, "HTTP/1.", 7) != 0)
+        return -1;
+    int code = 0;
+    for (int i = 9; i < 12; i++) {
+        if (buf[i] < '0' || buf[i] > '9')
+            return -1;
+        code = code * 10 + (buf[i] - '0');
+    }
+    *status = code;
+    *close_conn = (buf[7] == '0');
+
+    long long content_length = -1;
+    int chunked = 0;
+    const char *p = (const char *)memchr(buf, '\n', hdr_end) + 1;
+    while (p < buf + hdr_end - 2) {
+        const char *eol = memchr(p, '\n', (size_t)(buf + hdr_end - p));
+        const char *colon = memchr(p, ':', (size_t)(eol - p));
+        if (colon) {
+            const char *v = colon + 1;
+            while (*v == ' ' || *v == '\t')
+                v++;
+            size_t vlen = (size_t)(eol - v);
+            while (vlen > 0 && (v[vlen - 1] == '\r' || v[vlen - 1] == ' '))
+                vlen--;
+            size_t nlen = (size_t)(colon - p);
+            if (lower_eq(p, nlen, "content-length")) {
+                content_length = strtoll(v, NULL, 10);
+            } else if (lower_eq(p, nlen, "transfer-encoding")) {
+                chunked = lower_eq(v, vlen, "chunked");
+            } else if (lower_eq(p, nlen, "connection")) {
+                if (lower_eq(v, vlen, "close"))
+                    *close_conn = 1;
+                else if (lower_eq(v, vlen, "keep-alive"))
+                    *close_conn = 0;
+            }
+        }
+        p = eol + 1;
+    }
+
+    if (is_head || code == 204 || code == 304 || code < 200) {
+        *total = hdr_end;
+        return 1;
+    }
+
+    if (chunked) {
+        size_t o = hdr_end;
+        for (;;) {
+            const char *eol = memchr(buf + o, '\n', len - o);
+            if (!eol)
+                return 0;
+            char *end;
+            unsigned long long size = strtoull(buf + o, &end, 16);
+            if (end == buf + o)
+                return -1;
+            o = (size_t)(eol - buf) + 1;
+            if (size == 0)
+                break;
+            if (size > (unsigned long long)(len - o) ||
+                len - o - (size_t)size < 2)
+                return 0;
+            o += (size_t)size + 2;
+        }
+        /* Trailers, then the empty line */
+        for (;;) {
+            const char *eol = memchr(buf + o, '\n', len - o);
+            if (!eol)
+                return 0;
+            size_t line = (size_t)(eol - (buf + o));
+            o = (size_t)(eol - buf) + 1;
+            if (line <= 1)
+                break;
+        }
+        *total = o;
+        return 1;
+    }
+
+    if (content_length >= 0) {
+        if ((unsigned long long)(len - hdr_end) < (unsigned long long)content_length)
+            return 0;
+        *total = hdr_end + (size_t)content_length;
+        return 1;
+    }
+
+    /* Body runs to EOF */
+    *close_conn = 1;
+    if (!eof)
+        return 0;
+    *total = len;
+    return 1;
+}
+
+/* Consume a complete response (if any). 1 handled, 0 wait, -1 failed. */
+static int conn_try_complete(BenchLoop *lp, BenchConn *c, int eof)
+{
+    int status = 0, close_conn = 0;
+    size_t total = 0;
+    int rc = parse_response(c->in, c->in_len, c->is_head, eof,
+                            &status, &total, &close_conn);
+    if (rc <= 0)
+        return rc;
+
+    int64_t t = now_ns();
+    if (c->measured)
+        record(lp->st, c->entry, status, total, t - c->start);
+    lp->completed++;
+    lp->failures = 0;
+    c->served++;
+
+    if (close_conn || eof)
+        conn_close(c);
+    conn_issue(lp, c);
+    return 1;
+}
+
+static void conn_on_event(BenchLoop *lp, BenchConn *c, short revents)
+{
+    if (c->state == CONN_CONNECTING) {
+        int soerr = 0;
+        socklen_t sl = sizeof(soerr);
+        getsockopt(c->fd, SOL_SOCKET, SO_ERROR, &soerr, &sl);
+        if (soerr != 0) {
+            lp->last_errno = soerr;
+            conn_fail(lp, c);
+            return;
+        }
+        c->state = CONN_SENDING;
+    }
+
+    if (c->state == CONN_SENDING) {
+        while (c->out_off < c->out_len) {
+            ssize_t n = send(c->fd, c->out + c->out_off,
+                             c->out_len - c->out_off, MSG_NOSIGNAL);
+            if (n < 0 && errno == EINTR)
+                continue;
+            if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+                return;
+            if (n <= 0) {
+                /* Keep-alive socket closed under us: retry once fresh */
+                if (c->served > 0 && !c->retried) {
+                    c->retried = 1;
+                    conn_close(c);
+                    if (conn_send(lp, c) == 0)
+                        return;
+                }
+                lp->last_errno = errno;
+                conn_fail(lp, c);
+                return;
+            }
+            c->out_off += (size_t)n;
+        }
+        c->state = CONN_RECEIVING;
+        return;
+    }
+
+    if (c->state != CONN_RECEIVING || !(revents & (POLLIN | POLLHUP | POLLERR)))
+        return;
+
+    for (;;) {
+        if (c->in_cap - c->in_len < 4096) {
+            size_t cap = c->in_cap * 2;
+            char *in = realloc(c->in, cap);
+            if (!in) {
+                conn_fail(lp, c);
+                return;
+            }
+            c->in = in;
+            c->in_cap = cap;
+        }
+        ssize_t n = recv(c->fd, c->in + c->in_len, c->in_cap - c->in_len, 0);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+            break;
+        if (n <= 0) {
+            if (c->in_len == 0 && c->served > 0 && !c->retried) {
+                /* Idle keep-alive closed by the server: not an error */
+                c->retried = 1;
+                conn_close(c);
+                if (conn_send(lp, c) != 0)
+                    conn_fail(lp, c);
+                return;
+            }
+            if (conn_try_complete(lp, c, 1) != 1) {
+                lp->last_errno = n < 0 ? errno : ECONNRESET;
+                conn_fail(lp, c);
+            }
+            return;
+        }
+        c->in_len += (size_t)n;
+    }
+
+    if (conn_try_complete(lp, c, 0) < 0)
+        conn_fail(lp, c);
+}
+
+static int resolve(BenchLoop *lp, const char *host, int port,
+                   char *err, size_t err_size)
+{
+    char port_str[16];
+    snprintf(port_str, sizeof(port_str), "%d", port);
+    struct addrinfo hints, *res = NULL;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    if (getaddrinfo(host, port_str, &hints, &res) != 0 || !res) {
+        set_err(err, err_size, "cannot resolve ", host);
+        return -1;
+    }
+    memcpy(&lp->addr, res->ai_addr, res->ai_addrlen);
+    lp->addr_len = res->ai_addrlen;
+    freeaddrinfo(res);
+    return 0;
+}
+
+int hl_bench_run_loopback(const HlBenchScript *s, const HlBenchConfig *cfg,
+                          const char *host, int port, HlBenchStats *st,
+                          char *err, size_t err_size)
+{
+    int nconns = cfg->connections;
+    if (nconns < 1)
+        nconns = 1;
+    if (nconns > HL_BENCH_MAX_CONNS)
+        nconns = HL_BENCH_MAX_CONNS;
+
+    BenchLoop lp;
+    memset(&lp, 0, sizeof(lp));
+    lp.s = s;
+    lp.st = st;
+    lp.clk.cfg = cfg;
+    lp.host = host;
+    lp.port = port;
+    lp.rng = cfg->seed ? cfg->seed : 1;
+    if (resolve(&lp, host, port, err, err_size) != 0)
+        return -1;
+
+    int rc = -1;
+    BenchConn *conns = calloc((size_t)nconns, sizeof(*conns));
+    struct pollfd *pfds = calloc((size_t)nconns, sizeof(*pfds));
+    int *slot = calloc((size_t)nconns, sizeof(*slot));
+    lp.req = malloc(sizeof(*lp.req));
+    if (!conns || !pfds || !slot || !lp.req) {
+        set_err(err, err_size, "out of memory", NULL);
+        goto done;
+    }
+    for (int i = 0; i < nconns; i++) {
+        conns[i].fd = -1;
+        conns[i].index = i;
+        conns[i].in_cap = 16 * 1024;
+        conns[i].in = malloc(conns[i].in_cap);
+        conns[i].out = malloc(HL_BENCH_MAX_REQ_SIZE);
+        if (!conns[i].in || !conns[i].out) {
+            set_err(err, err_size, "out of memory", NULL);
+            goto done;
+        }
+    }
+
+    for (int i = 0; i < nconns; i++)
+        conn_issue(&lp, &conns[i]);
+
+    int64_t last_progress = now_ns();
+    uint64_t last_completed = 0;
+    for (;;) {
+        int n = 0;
+        for (int i = 0; i < nconns; i++) {
+            BenchConn *c = &conns[i];
+            if (c->state == CONN_IDLE)
+                conn_issue(&lp, c);
+            if (c->state == CONN_DONE || c->state == CONN_IDLE || c->fd < 0)
+                continue;
+            pfds[n].fd = c->fd;
+            pfds[n].events = c->state == CONN_RECEIVING ? POLLIN : POLLOUT;
+            pfds[n].revents = 0;
+            slot[n++] = i;
+        }
+        if (n == 0) {
+            int parked = 0;
+            for (int i = 0; i < nconns; i++)
+                parked += conns[i].state == CONN_IDLE;
+            if (parked == 0)
+                break;              /* every connection is done */
+        }
+
+        /* Nothing has ever answered: the server is not there */
+        if (lp.completed == 0 && lp.failures >= (uint64_t)nconns * 4) {
+            set_err(err, err_size, "cannot connect: ",
+                    strerror(lp.last_errno ? lp.last_errno : ECONNREFUSED));
+            goto done;
+        }
+
+        int ready = n ? poll(pfds, (nfds_t)n, 100) : 0;
+        if (ready < 0 && errno != EINTR) {
+            set_err(err, err_size, "poll: ", strerror(errno));
+            goto done;
+        }
+        for (int k = 0; ready > 0 && k < n; k++) {
+            if (pfds[k].revents)
+                conn_on_event(&lp, &conns[slot[k]], pfds[k].revents);
+        }
+
+        int64_t t = now_ns();
+        if (lp.completed != last_completed) {
+            last_completed = lp.completed;
+            last_progress = t;
+        } else if (t - last_progress > (int64_t)HL_BENCH_IO_TIMEOUT_MS * 1000000) {
+            set_err(err, err_size, "no response for 10s", NULL);
+            goto done;
+        }
+    }
+    rc = 0;
+
+done:
+    st->elapsed_ns = lp.clk.start ? now_ns() - lp.clk.start : 0;
+    if (conns) {
+        for (int i = 0; i < nconns; i++) {
+            conn_close(&conns[i]);
+            free(conns[i].in);
+            free(conns[i].out);
+        }
+    }
+    free(conns);
+    free(pfds);
+    free(slot);
+    free(lp.req);
+    return rc;
+}
+
+/* ── Report ────────────────────────────────────────────────────────── */
+
+static int file_write(void *ctx, const char *data, size_t len)
+{
+    return fwrite(data, 1, len, (FILE *)ctx) == len ? 0 : -1;
+}
+
+/* %g-style writer with the value rounded to `places` decimals first */
+static void write_fixed(ShJsonWriter *w, const char *key, double v, int places)
+{
+    double scale = 1.0;
+    for (int i = 0; i < places; i++)
+        scale *= 10.0;
+    v = (double)(int64_t)(v * scale + 0.5) / scale;
+    sh_json_write_kv_double_fmt(w, key, v, 15);
+}
+
+static void write_latency(ShJsonWriter *w, const HlHdr *h)
+{
+    static const struct { const char *key; double pct; } pcts[] = {
+        { "p50", 50.0 }, { "p90", 90.0 }, { "p99", 99.0 }, { "p99_9", 99.9 },
+    };
+
+    sh_json_write_key(w, "latency_us");
+    sh_json_write_object_start(w);
+    write_fixed(w, "min", h->total ? (double)h->min / 1000.0 : 0.0, 2);
+    write_fixed(w, "mean", hl_hdr_mean(h) / 1000.0, 2);
+    for (size_t i = 0; i < sizeof(pcts) / sizeof(pcts[0]); i++)
+        write_fixed(w, pcts[i].key,
+                    (double)hl_hdr_percentile(h, pcts[i].pct) / 1000.0, 2);
+    write_fixed(w, "max", (double)h->max / 1000.0, 2);
+    sh_json_write_object_end(w);
+}
+
+int hl_bench_report(FILE *out, const HlBenchScript *s, const HlBenchStats *st,
+                    const char *mode, const char *target, int connections)
+{
+    double secs = (double)st->elapsed_ns / 1e9;
+    ShJsonWriter w;
+    sh_json_writer_init(&w, file_write, out);
+
+    sh_json_write_object_start(&w);
+    sh_json_write_kv_string(&w, "mode", mode);
+    sh_json_write_kv_string(&w, "target", target);
+    sh_json_write_kv_int(&w, "connections", connections);
+    sh_json_write_kv_int(&w, "requests", (int64_t)st->requests);
+    sh_json_write_kv_int(&w, "errors", (int64_t)st->errors);
+    write_fixed(&w, "duration_s", secs, 3);
+    write_fixed(&w, "rps", secs > 0 ? (double)st->requests / secs : 0.0, 1);
+    sh_json_write_kv_int(&w, "bytes", (int64_t)st->bytes);
+
+    sh_json_write_key(&w, "status");
+    sh_json_write_object_start(&w);
+    static const char *classes[] = { "other", "1xx", "2xx", "3xx", "4xx", "5xx" };
+    for (int i = 1; i < 6; i++)
+        sh_json_write_kv_int(&w, classes[i], (int64_t)st->status[i]);
+    sh_json_write_kv_int(&w, classes[0], (int64_t)st->status[0]);
+    sh_json_write_object_end(&w);
+
+    write_latency(&w, &st->latency);
+
+    sh_json_write_key(&w, "mix");
+    sh_json_write_array_start(&w);
+    for (int i = 0; i < s->count && i < st->entries; i++) {
+        const HlBenchRequest *r = &s->reqs[i];
+        sh_json_write_object_start(&w);
+        sh_json_write_kv_string(&w, "method", r->method);
+        sh_json_write_kv_string(&w, "path", r->path);
+        sh_json_write_kv_int(&w, "weight", r->weight);
+        sh_json_write_kv_int(&w, "requests", (int64_t)st->count_by_entry[i]);
+        write_latency(&w, &st->by_entry[i]);
+        sh_json_write_object_end(&w);
+    }
+    sh_json_write_array_end(&w);
+    sh_json_write_object_end(&w);
+
+    fputc('\n', out);
+    fflush(out);
+    return sh_json_writer_error(&w) ? -1 : 0;
+}
@@ -1,7 +1,13 @@
 /*
  * audit.c — Capability audit logging
  *
- * Streams structured JSON lines to stderr via ShJsonWriter.
+ * Events are built with ShJsonWriter straight into a fixed-size record.
+ * With the drain thread running, records live in a bounded MPSC ring
+ * (per-slot sequence numbers, one CAS per claim); the drain thread
+ * formats the timestamp and writes whole batches with one write(2).
+ * Without it, the record is thread-local and written to stderr at
+ * hl_audit_end().
+ *
  * When hl_audit_enabled == 0, hl_audit_begin returns a writer with
  * error=1 — all subsequent writes become no-ops.  Zero overhead.
  *
@@ -9,53 +15,412 @@
  */
 
 #include "hull/cap/audit.h"
+#include "hull/limits.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdatomic.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
 #include <time.h>
+#include <unistd.h>
 
 int hl_audit_enabled = 0;
 
-static int audit_stderr_write(void *ctx, const char *data, size_t len)
+/* ── Records ───────────────────────────────────────────────────────── */
+
+/*
+ * body holds the object without its opening brace, starting at the
+ * "cap" member; cap_len marks where the caller's fields begin so a
+ * truncated record can still be emitted as valid JSON.
+ */
+typedef struct {
+    _Atomic uint64_t seq;       /* ring: pos = free, pos + 1 = published */
+    uint64_t         pos;       /* ring position claimed by the writer */
+    int64_t          ts;        /* CLOCK_REALTIME seconds */
+    uint16_t         len;
+    uint16_t         cap_len;
+    uint8_t          truncated;
+    char             body[HL_AUDIT_RECORD_SIZE - 32];
+} AuditRecord;
+
+_Static_assert(sizeof(AuditRecord) == HL_AUDIT_RECORD_SIZE,
+               "audit record header must stay 32 bytes");
+_Static_assert((HL_AUDIT_RING_SLOTS & (HL_AUDIT_RING_SLOTS - 1)) == 0,
+               "audit ring size must be a power of two");
+
+/* One '}' is always left room for at hl_audit_end() */
+static int audit_record_write(void *ctx, const char *data, size_t len)
+{
+    AuditRecord *rec = ctx;
+    if (rec->truncated || len > sizeof(rec->body) - 1 - rec->len) {
+        rec->truncated = 1;
+        return -1;
+    }
+    memcpy(rec->body + rec->len, data, len);
+    rec->len += (uint16_t)len;
+    return 0;
+}
+
+/* Cached per second: the drain thread formats thousands per timestamp */
+typedef struct {
+    int64_t sec;
+    char    str[32];
+    size_t  len;
+} AuditTs;
+
+/* Format one record as a JSON line into out (>= HL_AUDIT_RECORD_SIZE + 64) */
+static size_t audit_format(const AuditRecord *rec, AuditTs *tc, char *out)
+{
+    if (tc->sec != rec->ts || tc->len == 0) {
+        time_t t = (time_t)rec->ts;
+        struct tm tm;
+        gmtime_r(&t, &tm);
+        tc->len = strftime(tc->str, sizeof(tc->str), "%Y-%m-%dT%H:%M:%SZ", &tm);
+        tc->sec = rec->ts;
+    }
+
+    size_t n = 0;
+    memcpy(out + n, "{\"ts\":\"", 7);
+    n += 7;
+    memcpy(out + n, tc->str, tc->len);
+    n += tc->len;
+    memcpy(out + n, "\",", 2);
+    n += 2;
+    if (rec->truncated) {
+        memcpy(out + n, rec->body, rec->cap_len);
+        n += rec->cap_len;
+        memcpy(out + n, ",\"truncated\":true}", 18);
+        n += 18;
+    } else {
+        memcpy(out + n, rec->body, rec->len);
+        n += rec->len;
+    }
+    out[n++] = '\n';
+    return n;
+}
+
+/* ── Ring ──────────────────────────────────────────────────────────── */
+
+/* Producer- and drain-side counters sit on separate cache lines */
+static struct {
+    AuditRecord      *ring;
+    _Atomic int       running;      /* producers may claim slots */
+    _Atomic int       sleeping;     /* drain thread is waiting on cond */
+    _Alignas(64) _Atomic uint64_t enq;
+    _Atomic uint64_t  dropped;
+    _Alignas(64) _Atomic uint64_t deq; /* written by the drain thread only */
+    _Atomic uint64_t  written;
+    _Atomic int       stopping;
+    pthread_t         thread;
+    pthread_mutex_t   mu;
+    pthread_cond_t    cond;
+    int               fd;
+    const char       *path;         /* NULL = stderr */
+    size_t            rotate_bytes;
+    size_t            file_bytes;
+    int               rotate_failed;
+} audit = { .fd = -1 };
+
+static _Thread_local AuditRecord audit_sync_rec;
+
+static AuditRecord *ring_claim(void)
+{
+    uint64_t pos = atomic_load_explicit(&audit.enq, memory_order_relaxed);
+    for (;;) {
+        AuditRecord *rec = &audit.ring[pos & (HL_AUDIT_RING_SLOTS - 1)];
+        uint64_t seq = atomic_load_explicit(&rec->seq, memory_order_acquire);
+        int64_t dif = (int64_t)(seq - pos);
+        if (dif == 0) {
+            if (atomic_compare_exchange_weak_explicit(&audit.enq, &pos, pos + 1,
+                                                      memory_order_relaxed,
+                                                      memory_order_relaxed)) {
+                rec->pos = pos;
+                return rec;
+            }
+        } else if (dif < 0) {
+            return NULL; /* full: the drain thread is a lap behind */
+        } else {
+            pos = atomic_load_explicit(&audit.enq, memory_order_relaxed);
+        }
+    }
+}
+
+static void ring_publish(AuditRecord *rec)
+{
+    atomic_store_explicit(&rec->seq, rec->pos + 1, memory_order_release);
+
+    /* Wake the drain thread early once a quarter of the ring is queued */
+    if (atomic_load_explicit(&audit.sleeping, memory_order_relaxed) &&
+        rec->pos - atomic_load_explicit(&audit.deq, memory_order_relaxed)
+            >= HL_AUDIT_RING_SLOTS / 4) {
+        pthread_mutex_lock(&audit.mu);
+        pthread_cond_signal(&audit.cond);
+        pthread_mutex_unlock(&audit.mu);
+    }
+}
+
+/* ── Output ────────────────────────────────────────────────────────── */
+
+static int write_all(int fd, const char *data, size_t len)
+{
+    while (len > 0) {
+        ssize_t w = write(fd, data, len);
+        if (w < 0) {
+            if (errno == EINTR)
+                continue;
+            return -1;
+        }
+        data += w;
+        len -= (size_t)w;
+    }
+    return 0;
+}
+
+static int audit_open_file(void)
+{
+    audit.fd = open(audit.path, O_WRONLY | O_APPEND | O_CREAT | O_CLOEXEC, 0640);
+    if (audit.fd < 0)
+        return -1;
+    struct stat st;
+    audit.file_bytes = fstat(audit.fd, &st) == 0 ? (size_t)st.st_size : 0;
+    return 0;
+}
+
+static void audit_rotate(void)
+{
+    char old[4096];
+    if (snprintf(old, sizeof(old), "%s.1", audit.path) >= (int)sizeof(old))
+        return;
+    /* Keep appending to the current file if rotation is not permitted
+     * (e.g. the sandbox did not unveil the audit directory) */
+    if (rename(audit.path, old) != 0) {
+        if (!audit.rotate_failed)
+            fprintf(stderr, "[hull:c] audit: cannot rotate %s: %s\n",
+                    audit.path, strerror(errno));
+        audit.rotate_failed = 1;
+        audit.file_bytes = 0;
+        return;
+    }
+    close(audit.fd);
+    if (audit_open_file() != 0) {
+        fprintf(stderr, "[hull:c] audit: cannot reopen %s: %s\n",
+                audit.path, strerror(errno));
+        audit.fd = -1;
+    }
+}
+
+static void audit_flush(const char *buf, size_t len)
+{
+    if (len == 0)
+        return;
+    if (!audit.path) {
+        write_all(STDERR_FILENO, buf, len);
+        return;
+    }
+    if (audit.fd < 0)
+        return;
+    write_all(audit.fd, buf, len);
+    audit.file_bytes += len;
+    if (audit.rotate_bytes > 0 && audit.file_bytes >= audit.rotate_bytes)
+        audit_rotate();
+}
+
+/* Drain everything published so far. Returns the number of records. */
+static size_t audit_drain(char *buf, AuditTs *tc)
+{
+    uint64_t pos = atomic_load_explicit(&audit.deq, memory_order_relaxed);
+    size_t used = 0, count = 0;
+
+    for (;;) {
+        AuditRecord *rec = &audit.ring[pos & (HL_AUDIT_RING_SLOTS - 1)];
+        if (atomic_load_explicit(&rec->seq, memory_order_acquire) != pos + 1)
+            break;
+
+        if (HL_AUDIT_BATCH_SIZE - used < HL_AUDIT_RECORD_SIZE + 64) {
+            audit_flush(buf, used);
+            used = 0;
+        }
+        used += audit_format(rec, tc, buf + used);
+
+        atomic_store_explicit(&rec->seq, pos + HL_AUDIT_RING_SLOTS,
+                              memory_order_release);
+        pos++;
+        atomic_store_explicit(&audit.deq, pos, memory_order_relaxed);
+        count++;
+    }
+
+    audit_flush(buf, used);
+    atomic_fetch_add_explicit(&audit.written, count, memory_order_relaxed);
+    return count;
+}
+
+static void *audit_drain_main(void *arg)
+{
+    (void)arg;
+    char *buf = malloc(HL_AUDIT_BATCH_SIZE);
+    if (!buf)
+        return NULL;
+    AuditTs tc = {0};
+
+    for (;;) {
+        int stopping = atomic_load(&audit.stopping);
+        if (audit_drain(buf, &tc) > 0)
+            continue;
+        if (stopping)
+            break;
+
+        struct timespec until;
+        clock_gettime(CLOCK_REALTIME, &until);
+        until.tv_nsec += HL_AUDIT_FLUSH_MS * 1000000L;
+        if (until.tv_nsec >= 1000000000L) {
+            until.tv_sec++;
+            until.tv_nsec -= 1000000000L;
+        }
+        pthread_mutex_lock(&audit.mu);
+        atomic_store(&audit.sleeping, 1);
+        if (!atomic_load(&audit.stopping))
+            pthread_cond_timedwait(&audit.cond, &audit.mu, &until);
+        atomic_store(&audit.sleeping, 0);
+        pthread_mutex_unlock(&audit.mu);
+    }
+
+    free(buf);
+    return NULL;
+}
+
+int hl_audit_start(const char *path, size_t rotate_bytes)
+{
+    if (atomic_load(&audit.running))
+        return -1;
+
+    audit.ring = calloc(HL_AUDIT_RING_SLOTS, sizeof(AuditRecord));
+    if (!audit.ring)
+        return -1;
+    for (uint64_t i = 0; i < HL_AUDIT_RING_SLOTS; i++)
+        atomic_init(&audit.ring[i].seq, i);
+    atomic_store(&audit.enq, 0);
+    atomic_store(&audit.deq, 0);
+    atomic_store(&audit.stopping, 0);
+    atomic_store(&audit.dropped, 0);
+    atomic_store(&audit.written, 0);
+
+    audit.path = path;
+    audit.rotate_bytes = rotate_bytes;
+    audit.rotate_failed = 0;
+    audit.fd = -1;
+    if (path && audit_open_file() != 0) {
+        free(audit.ring);
+        audit.ring = NULL;
+        return -1;
+    }
+
+    pthread_mutex_init(&audit.mu, NULL);
+    pthread_cond_init(&audit.cond, NULL);
+    if (pthread_create(&audit.thread, NULL, audit_drain_main, NULL) != 0) {
+        pthread_cond_destroy(&audit.cond);
+        pthread_mutex_destroy(&audit.mu);
+        if (audit.fd >= 0)
+            close(audit.fd);
+        audit.fd = -1;
+        free(audit.ring);
+        audit.ring = NULL;
+        return -1;
+    }
+
+    atomic_store_explicit(&audit.running, 1, memory_order_release);
+    return 0;
+}
+
+void hl_audit_stop(void)
+{
+    if (!atomic_exchange(&audit.running, 0))
+        return;
+
+    pthread_mutex_lock(&audit.mu);
+    atomic_store(&audit.stopping, 1);
+    pthread_cond_signal(&audit.cond);
+    pthread_mutex_unlock(&audit.mu);
+    pthread_join(audit.thread, NULL);
+
+    pthread_cond_destroy(&audit.cond);
+    pthread_mutex_destroy(&audit.mu);
+    if (audit.fd >= 0)
+        close(audit.fd);
+    audit.fd = -1;
+    free(audit.ring);
+    audit.ring = NULL;
+}
+
+uint64_t hl_audit_dropped(void)
+{
+    return atomic_load_explicit(&audit.dropped, memory_order_relaxed);
+}
+
+uint64_t hl_audit_written(void)
 {
-    (void)ctx;
-    size_t w = fwrite(data, 1, len, stderr);
-    return w == len ? 0 : -1;
+    return atomic_load_explicit(&audit.written, memory_order_relaxed);
 }
 
+/* ── Producer API ──────────────────────────────────────────────────── */
+
 ShJsonWriter hl_audit_begin(const char *cap)
 {
     ShJsonWriter w;
 
     if (!hl_audit_enabled) {
         /* Return a writer with error=1 — all writes become no-ops */
-        sh_json_writer_init(&w, audit_stderr_write, NULL);
+        sh_json_writer_init(&w, audit_record_write, NULL);
         w.error = 1;
         return w;
     }
 
-    sh_json_writer_init(&w, audit_stderr_write, NULL);
-    sh_json_write_object_start(&w);
-
-    /* Timestamp: ISO 8601 UTC */
-    {
-        time_t now = time(NULL);
-        struct tm tm;
-        gmtime_r(&now, &tm);
-        char ts[32];
-        strftime(ts, sizeof(ts), "%Y-%m-%dT%H:%M:%SZ", &tm);
-        sh_json_write_kv_string(&w, "ts", ts);
+    AuditRecord *rec;
+    if (atomic_load_explicit(&audit.running, memory_order_acquire)) {
+        rec = ring_claim();
+        if (!rec) {
+            atomic_fetch_add_explicit(&audit.dropped, 1, memory_order_relaxed);
+            sh_json_writer_init(&w, audit_record_write, NULL);
+            w.error = 1;
+            return w;
+        }
+    } else {
+        rec = &audit_sync_rec;
     }
 
+    rec->ts = (int64_t)time(NULL);
+    rec->len = 0;
+    rec->truncated = 0;
+
+    sh_json_writer_init(&w, audit_record_write, rec);
+    sh_json_write_object_start(&w);
+    rec->len = 0; /* the brace is written with the timestamp */
     sh_json_write_kv_string(&w, "cap", cap);
+    rec->cap_len = rec->len;
 
     return w;
 }
 
 void hl_audit_end(ShJsonWriter *w)
 {
-    if (!w || w->error)
+    if (!w || !w->ctx)
+        return;
+
+    AuditRecord *rec = w->ctx;
+    w->ctx = NULL;
+    w->error = 1;
+    rec->body[rec->len++] = '}';
+
+    if (rec != &audit_sync_rec) {
+        ring_publish(rec);
         return;
+    }
 
-    sh_json_write_object_end(w);
-    /* Write newline directly to stderr (not through JSON writer) */
-    fputc('\n', stderr);
+    char line[HL_AUDIT_RECORD_SIZE + 64];
+    AuditTs tc = {0};
+    size_t n = audit_format(rec, &tc, line);
+    fwrite(line, 1, n, stderr);
 }
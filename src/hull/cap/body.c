@@ -1,16 +1,33 @@
 /*
  * hull_cap_body.c — Body reader factory and extraction for Hull runtimes
  *
- * Wraps Keel's kl_body_reader_buffer with a 1 MB limit.
+ * Buffered routes wrap Keel's kl_body_reader_buffer (1 MB by default).
  * Both JS and Lua bindings use hl_cap_body_data() to extract
  * the buffered body after on_complete fires.
  *
+ * Routes declared with an upload mode get an HlBodyUpload reader
+ * instead, which passes each chunk on (stream), appends it to a
+ * temporary file (spool) or writes it into a SQLite blob (blob), so
+ * the body is never held in memory as a whole.
+ *
  * SPDX-License-Identifier: AGPL-3.0-or-later
  */
 
 #include "hull/cap/body.h"
 #include "hull/limits.h"
+#include "hull/manifest.h"
+
+#include "log.h"
+
+#include <errno.h>
+#include <limits.h>
+#include <sqlite3.h>
 #include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <unistd.h>
 
 KlBodyReader *hl_cap_body_factory(KlAllocator *alloc, const KlRequest *req,
                                   void *user_data)
@@ -24,7 +41,7 @@ size_t hl_cap_body_data(const KlBodyReader *reader, const char **out_data)
 {
     if (!out_data)
         return 0;
-    if (!reader) {
+    if (!reader || hl_cap_body_upload((KlBodyReader *)reader)) {
         *out_data = NULL;
         return 0;
     }
@@ -32,3 +49,482 @@ size_t hl_cap_body_data(const KlBodyReader *reader, const char **out_data)
     *out_data = br->data;
     return br->len;
 }
+
+/* ── Spec validation ───────────────────────────────────────────────── */
+
+static const char *mode_names[] = { "buffer", "stream", "spool", "blob" };
+
+int hl_cap_body_mode(const char *name)
+{
+    if (!name)
+        return -1;
+    for (int i = 0; i < (int)(sizeof(mode_names) / sizeof(mode_names[0])); i++) {
+        if (strcmp(name, mode_names[i]) == 0)
+            return i;
+    }
+    return -1;
+}
+
+const char *hl_cap_body_mode_name(HlBodyMode mode)
+{
+    if ((int)mode < 0 || (size_t)mode >= sizeof(mode_names) / sizeof(mode_names[0]))
+        return "buffer";
+    return mode_names[mode];
+}
+
+/* Plain SQL identifier, not one of Hull's own tables/columns */
+static int body_ident_ok(const char *s)
+{
+    if (!s[0] || !(s[0] == '_' || (s[0] >= 'a' && s[0] <= 'z') ||
+                   (s[0] >= 'A' && s[0] <= 'Z')))
+        return 0;
+    for (const char *p = s + 1; *p; p++) {
+        if (!(*p == '_' || (*p >= 'a' && *p <= 'z') ||
+              (*p >= 'A' && *p <= 'Z') || (*p >= '0' && *p <= '9')))
+            return 0;
+    }
+    return strncasecmp(s, "_hull_", 6) != 0;
+}
+
+/* Length of `s` without trailing slashes (a lone "/" keeps its slash) */
+static size_t body_path_len(const char *s)
+{
+    size_t n = strlen(s);
+    while (n > 1 && s[n - 1] == '/')
+        n--;
+    return n;
+}
+
+static int body_has_dotdot(const char *s)
+{
+    for (const char *p = s; *p; ) {
+        const char *seg = p;
+        while (*p && *p != '/')
+            p++;
+        if (p - seg == 2 && seg[0] == '.' && seg[1] == '.')
+            return 1;
+        while (*p == '/')
+            p++;
+    }
+    return 0;
+}
+
+/* dir is fs.write entry `w` or a path below it, compared lexically */
+static int body_dir_within(const char *dir, const char *w)
+{
+    if (strncmp(dir, "./", 2) == 0)
+        dir += 2;
+    if (strncmp(w, "./", 2) == 0)
+        w += 2;
+    size_t dn = body_path_len(dir);
+    size_t wn = body_path_len(w);
+    if (wn == 1 && w[0] == '/')
+        return dir[0] == '/';
+    if (dn < wn || strncmp(dir, w, wn) != 0)
+        return 0;
+    return dn == wn || dir[wn] == '/';
+}
+
+int hl_cap_body_check(HlBodySpec *spec, const HlManifest *manifest)
+{
+    if (!spec)
+        return -1;
+
+    int64_t ceiling;
+    switch (spec->mode) {
+    case HL_BODY_BUFFER:
+        ceiling = HL_BODY_MAX_BUFFER;
+        if (spec->max_size == 0)
+            spec->max_size = HL_BODY_MAX_SIZE;
+        break;
+    case HL_BODY_STREAM:
+    case HL_BODY_SPOOL:
+        ceiling = INT64_MAX;
+        if (spec->max_size == 0)
+            spec->max_size = HL_BODY_STREAM_SIZE;
+        break;
+    case HL_BODY_BLOB:
+        /* The whole row is reserved before the handler (or its
+         * middleware) runs: keep the default well below the ceiling */
+        ceiling = HL_BODY_MAX_BLOB;
+        if (spec->max_size == 0)
+            spec->max_size = HL_BODY_BLOB_SIZE;
+        break;
+    default:
+        log_error("[hull:c] body: unknown mode %d", (int)spec->mode);
+        return -1;
+    }
+    if (spec->max_size < 0 || spec->max_size > ceiling) {
+        log_error("[hull:c] body: max_body for a %s route must be 1..%lld",
+                  hl_cap_body_mode_name(spec->mode), (long long)ceiling);
+        return -1;
+    }
+
+    if (spec->mode == HL_BODY_BLOB &&
+        (!body_ident_ok(spec->table) || !body_ident_ok(spec->column))) {
+        log_error("[hull:c] body: blob routes need a table and column "
+                  "(plain identifiers, not _hull_*)");
+        return -1;
+    }
+
+    if (spec->mode == HL_BODY_SPOOL) {
+        if (!spec->dir[0] || body_has_dotdot(spec->dir)) {
+            log_error("[hull:c] body: spool routes need a dir without '..'");
+            return -1;
+        }
+        int allowed = 0;
+        for (int i = 0; manifest && i < manifest->fs_write_count; i++) {
+            if (manifest->fs_write[i] &&
+                body_dir_within(spec->dir, manifest->fs_write[i]) &&
+                strlen(manifest->fs_write[i]) < sizeof(spec->root)) {
+                memcpy(spec->root, manifest->fs_write[i],
+                       strlen(manifest->fs_write[i]) + 1);
+                allowed = 1;
+                break;
+            }
+        }
+        if (!allowed) {
+            log_error("[hull:c] body: spool dir '%s' is not under a manifest "
+                      "fs.write path", spec->dir);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+/* ── Upload reader ─────────────────────────────────────────────────── */
+
+/* Reserve the row: zeroblob(Content-Length) */
+static int blob_insert(HlBodyUpload *up)
+{
+    char sql[64 + 2 * HL_BODY_IDENT_MAX];
+    sqlite3_stmt *stmt = NULL;
+    snprintf(sql, sizeof(sql),
+             "INSERT INTO \"%s\" (\"%s\") VALUES (zeroblob(?))",
+             up->table, up->column);
+    if (sqlite3_prepare_v2(up->db, sql, -1, &stmt, NULL) != SQLITE_OK) {
+        log_error("[hull:c] body: %s", sqlite3_errmsg(up->db));
+        return -1;
+    }
+    sqlite3_bind_int64(stmt, 1, (sqlite3_int64)up->req->content_length);
+    int rc = sqlite3_step(stmt);
+    sqlite3_finalize(stmt);
+    if (rc != SQLITE_DONE) {
+        log_error("[hull:c] body: %s", sqlite3_errmsg(up->db));
+        return -1;
+    }
+    up->rowid = (int64_t)sqlite3_last_insert_rowid(up->db);
+    return 0;
+}
+
+static int blob_flush(HlBodyUpload *up)
+{
+    if (up->pending_len == 0)
+        return 0;
+    /* Nothing is reserved until a first batch has actually arrived */
+    if (up->rowid <= 0 && blob_insert(up) != 0)
+        return -1;
+    sqlite3_blob *blob = NULL;
+    /* Opened per flush: no statement or transaction stays open while
+     * the rest of the body is on the wire */
+    if (sqlite3_blob_open(up->db, "main", up->table, up->column, up->rowid,
+                          1, &blob) != SQLITE_OK) {
+        log_error("[hull:c] body: blob open failed: %s",
+                  sqlite3_errmsg(up->db));
+        return -1;
+    }
+    int rc = sqlite3_blob_write(blob, up->pending, (int)up->pending_len,
+                                (int)up->written);
+    sqlite3_blob_close(blob);
+    if (rc != SQLITE_OK) {
+        log_error("[hull:c] body: blob write failed: %s",
+                  sqlite3_errstr(rc));
+        return -1;
+    }
+    up->written += (int64_t)up->pending_len;
+    up->pending_len = 0;
+    return 0;
+}
+
+static int upload_on_data(KlBodyReader *r, const char *data, size_t len)
+{
+    HlBodyUpload *up = (HlBodyUpload *)r;
+
+    if ((int64_t)len > up->max_size - up->size) {
+        log_warn("[hull:c] body: upload exceeds %lld bytes",
+                 (long long)up->max_size);
+        return -1;
+    }
+    int64_t before = up->size;
+    up->size += (int64_t)len; /* on_chunk sees the total so far */
+
+    switch (up->mode) {
+    case HL_BODY_STREAM:
+        if (up->on_chunk && up->on_chunk(up, data, len, up->chunk_ctx) != 0)
+            return -1;
+        break;
+
+    case HL_BODY_SPOOL:
+        for (size_t off = 0; off < len; ) {
+            ssize_t n = write(up->fd, data + off, len - off);
+            if (n < 0) {
+                if (errno == EINTR)
+                    continue;
+                log_error("[hull:c] body: spool write failed: %s",
+                          strerror(errno));
+                return -1;
+            }
+            off += (size_t)n;
+        }
+        break;
+
+    case HL_BODY_BLOB:
+        if ((int64_t)len > (int64_t)up->req->content_length - before) {
+            log_warn("[hull:c] body: blob upload longer than Content-Length");
+            return -1;
+        }
+        for (size_t off = 0; off < len; ) {
+            size_t n = len - off;
+            if (n > HL_BODY_BLOB_FLUSH - up->pending_len)
+                n = HL_BODY_BLOB_FLUSH - up->pending_len;
+            memcpy(up->pending + up->pending_len, data + off, n);
+            up->pending_len += n;
+            off += n;
+            if (up->pending_len == HL_BODY_BLOB_FLUSH && blob_flush(up) != 0)
+                return -1;
+        }
+        break;
+
+    default:
+        return -1;
+    }
+    return 0;
+}
+
+static int upload_on_complete(KlBodyReader *r)
+{
+    HlBodyUpload *up = (HlBodyUpload *)r;
+
+    if (up->mode == HL_BODY_SPOOL) {
+        if (lseek(up->fd, 0, SEEK_SET) < 0)
+            return -1;
+    } else if (up->mode == HL_BODY_BLOB) {
+        if (up->written + (int64_t)up->pending_len !=
+            (int64_t)up->req->content_length) {
+            log_warn("[hull:c] body: blob upload shorter than Content-Length");
+            return -1;
+        }
+        /* An empty body still gets its (empty) row */
+        if ((up->rowid <= 0 && blob_insert(up) != 0) || blob_flush(up) != 0)
+            return -1;
+    }
+    up->complete = 1;
+    return 0;
+}
+
+static void upload_on_error(KlBodyReader *r, int err)
+{
+    (void)err;
+    ((HlBodyUpload *)r)->complete = 0;
+}
+
+static void upload_destroy(KlBodyReader *r)
+{
+    HlBodyUpload *up = (HlBodyUpload *)r;
+    KlAllocator *alloc = up->alloc;
+
+    if (up->fd >= 0)
+        close(up->fd);
+    if (up->mode == HL_BODY_SPOOL && up->path[0] && !up->kept)
+        unlink(up->path);
+
+    /* A blob row is the handler's once the upload completed */
+    if (up->mode == HL_BODY_BLOB && up->rowid > 0 && !up->complete) {
+        char sql[64 + 2 * HL_BODY_IDENT_MAX];
+        sqlite3_stmt *stmt = NULL;
+        snprintf(sql, sizeof(sql), "DELETE FROM \"%s\" WHERE rowid = ?",
+                 up->table);
+        if (sqlite3_prepare_v2(up->db, sql, -1, &stmt, NULL) == SQLITE_OK) {
+            sqlite3_bind_int64(stmt, 1, up->rowid);
+            sqlite3_step(stmt);
+        }
+        sqlite3_finalize(stmt);
+    }
+
+    if (up->pending)
+        kl_free(alloc, up->pending, HL_BODY_BLOB_FLUSH);
+    if (up->state)
+        kl_free(alloc, up->state, up->state_len + 1);
+    kl_free(alloc, up, sizeof(*up));
+}
+
+HlBodyUpload *hl_cap_body_upload(KlBodyReader *reader)
+{
+    if (!reader || reader->on_data != upload_on_data)
+        return NULL;
+    return (HlBodyUpload *)reader;
+}
+
+/*
+ * Resolve a spool directory and check it against its fs.write entry,
+ * both with symlinks followed. The lexical check in hl_cap_body_check()
+ * cannot see a link inside the entry that points out of it.
+ */
+static int spool_resolve(const HlBodySpec *spec, char *out, size_t size)
+{
+    char dir[PATH_MAX], root[PATH_MAX];
+    if (!spec->root[0] || !realpath(spec->dir, dir) ||
+        !realpath(spec->root, root)) {
+        log_error("[hull:c] body: cannot resolve spool dir '%s': %s",
+                  spec->dir, spec->root[0] ? strerror(errno) : "unchecked");
+        return -1;
+    }
+    if (!body_dir_within(dir, root)) {
+        log_error("[hull:c] body: spool dir '%s' resolves to '%s', outside "
+                  "fs.write '%s'", spec->dir, dir, spec->root);
+        return -1;
+    }
+    if (strlen(dir) >= size) {
+        log_error("[hull:c] body: spool dir '%s' too long", dir);
+        return -1;
+    }
+    memcpy(out, dir, strlen(dir) + 1);
+    return 0;
+}
+
+KlBodyReader *hl_cap_body_open(KlAllocator *alloc, const KlRequest *req,
+                               const HlBodySpec *spec, sqlite3 *db,
+                               HlBodyChunkFn on_chunk, void *chunk_ctx)
+{
+    if (!alloc || !req || !spec)
+        return NULL;
+
+    if (spec->mode == HL_BODY_BUFFER)
+        return kl_body_reader_buffer(alloc, req,
+                                     (void *)(size_t)spec->max_size);
+
+    /* Refuse what cannot fit before reading any of it */
+    if ((int64_t)req->content_length > spec->max_size) {
+        log_warn("[hull:c] body: Content-Length %zu exceeds %lld bytes",
+                 req->content_length, (long long)spec->max_size);
+        return NULL;
+    }
+    if (spec->mode == HL_BODY_BLOB && !db)
+        return NULL;
+    if (spec->mode == HL_BODY_STREAM && !on_chunk)
+        return NULL;
+
+    HlBodyUpload *up = kl_malloc(alloc, sizeof(*up));
+    if (!up)
+        return NULL;
+    memset(up, 0, sizeof(*up));
+    up->base.on_data     = upload_on_data;
+    up->base.on_complete = upload_on_complete;
+    up->base.on_error    = upload_on_error;
+    up->base.destroy     = upload_destroy;
+    up->alloc    = alloc;
+    up->req      = req;
+    up->mode     = spec->mode;
+    up->max_size = spec->max_size;
+    up->fd       = -1;
+
+    switch (spec->mode) {
+    case HL_BODY_STREAM:
+        up->on_chunk  = on_chunk;
+        up->chunk_ctx = chunk_ctx;
+        break;
+
+    case HL_BODY_SPOOL: {
+        char dir[HL_BODY_DIR_MAX];
+        if (spool_resolve(spec, dir, sizeof(dir)) != 0) {
+            upload_destroy(&up->base);
+            return NULL;
+        }
+        snprintf(up->path, sizeof(up->path), "%s/hull-upload-XXXXXX",
+                 strcmp(dir, "/") == 0 ? "" : dir);
+        up->fd = mkstemp(up->path);
+        if (up->fd < 0) {
+            log_error("[hull:c] body: cannot create spool file in '%s': %s",
+                      spec->dir, strerror(errno));
+            up->path[0] = '\0';
+            upload_destroy(&up->base);
+            return NULL;
+        }
+        break;
+    }
+
+    case HL_BODY_BLOB:
+        up->db     = db;
+        up->table  = spec->table;
+        up->column = spec->column;
+        up->pending = kl_malloc(alloc, HL_BODY_BLOB_FLUSH);
+        if (!up->pending) {
+            upload_destroy(&up->base);
+            return NULL;
+        }
+        break;
+
+    default:
+        upload_destroy(&up->base);
+        return NULL;
+    }
+
+    return &up->base;
+}
+
+int hl_cap_body_set_state(HlBodyUpload *up, const char *data, size_t len)
+{
+    if (!up || !data || len >= SIZE_MAX)
+        return -1;
+    char *state = kl_malloc(up->alloc, len + 1);
+    if (!state)
+        return -1;
+    memcpy(state, data, len);
+    state[len] = '\0';
+    if (up->state)
+        kl_free(up->alloc, up->state, up->state_len + 1);
+    up->state = state;
+    up->state_len = len;
+    return 0;
+}
+
+/* ── Spool access ──────────────────────────────────────────────────── */
+
+int64_t hl_cap_body_read(HlBodyUpload *up, char *buf, size_t len)
+{
+    if (!up || up->mode != HL_BODY_SPOOL || !up->complete || up->fd < 0 || !buf)
+        return -1;
+    for (;;) {
+        ssize_t n = read(up->fd, buf, len);
+        if (n < 0 && errno == EINTR)
+            continue;
+        return (int64_t)n;
+    }
+}
+
+int hl_cap_body_keep(HlBodyUpload *up, const char *name)
+{
+    if (!up || up->mode != HL_BODY_SPOOL || !up->complete || up->kept)
+        return -1;
+    if (!name || !name[0] || strchr(name, '/') || strcmp(name, ".") == 0 ||
+        strcmp(name, "..") == 0 || strlen(name) >= HL_BODY_NAME_MAX)
+        return -1;
+
+    char *slash = strrchr(up->path, '/');
+    if (!slash)
+        return -1;
+    char dest[sizeof(up->path)];
+    snprintf(dest, sizeof(dest), "%.*s/%s", (int)(slash - up->path),
+             up->path, name);
+
+    /* link() instead of rename() so an existing file is never replaced */
+    if (link(up->path, dest) != 0) {
+        log_warn("[hull:c] body: cannot keep upload as '%s': %s",
+                 dest, strerror(errno));
+        return -1;
+    }
+    unlink(up->path);
+    memcpy(up->path, dest, sizeof(dest));
+    up->kept = 1;
+    return 0;
+}
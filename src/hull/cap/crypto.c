@@ -9,10 +9,14 @@
  */
 
 #include "hull/cap/crypto.h"
+#include "hull/limits.h"
 #include "tweetnacl.h"
+#include <limits.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <fcntl.h>
+#include <pthread.h>
 #include <unistd.h>
 #if defined(__linux__) && !defined(__COSMOPOLITAN__)
 #include <sys/random.h>
@@ -31,8 +35,33 @@ static void hull_secure_zero(void *p, size_t n)
  * TweetNaCl only implements SHA-512 — SHA-256 is declared in the header
  * but not in tweetnacl.c. We keep this implementation because PBKDF2
  * and HMAC-SHA256 require SHA-256 specifically.
+ *
+ * The block function is chosen once at load time: SHA-NI on x86-64,
+ * the ARMv8 SHA2 extension on AArch64, otherwise the portable kernel.
+ * All three consume whole 64-byte blocks; buffering and padding are
+ * shared (Sha256Ctx below).
  */
 
+#if (defined(__x86_64__) || defined(__i386__)) && \
+    (defined(__GNUC__) || defined(__clang__)) && !defined(__TINYC__)
+#define HL_SHA256_X86 1
+#include <cpuid.h>
+#include <immintrin.h>
+#endif
+
+#if defined(__aarch64__) && (defined(__GNUC__) || defined(__clang__)) && \
+    (defined(__ARM_FEATURE_SHA2) || defined(__ARM_FEATURE_CRYPTO) || \
+     defined(__linux__) || defined(__APPLE__))
+#define HL_SHA256_ARM 1
+#include <arm_neon.h>
+#if defined(__linux__)
+#include <sys/auxv.h>
+#ifndef HWCAP_SHA2
+#define HWCAP_SHA2 (1 << 6)
+#endif
+#endif
+#endif
+
 static const uint32_t sha256_k[64] = {
     0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5,
     0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
@@ -86,54 +115,344 @@ static void sha256_transform(uint32_t state[8], const uint8_t block[64])
     state[4] += e; state[5] += f; state[6] += g; state[7] += h;
 }
 
-int hl_cap_crypto_sha256(const void *data, size_t len, uint8_t out[32])
+typedef void (*Sha256BlocksFn)(uint32_t state[8], const uint8_t *p,
+                               size_t nblocks);
+
+static void sha256_blocks_portable(uint32_t state[8], const uint8_t *p,
+                                   size_t nblocks)
 {
-    if (!data || !out)
-        return -1;
+    for (; nblocks > 0; nblocks--, p += 64)
+        sha256_transform(state, p);
+}
+
+#ifdef HL_SHA256_X86
+/* Intel SHA extensions. The state is kept as ABEF/CDGH lane pairs, the
+ * layout sha256rnds2 expects; each iteration runs four rounds and
+ * extends the message schedule by four words. */
+__attribute__((target("sha,sse4.1")))
+static void sha256_blocks_shani(uint32_t state[8], const uint8_t *p,
+                                size_t nblocks)
+{
+    const __m128i bswap = _mm_set_epi64x(0x0c0d0e0f08090a0bLL,
+                                         0x0405060700010203LL);
+    __m128i tmp  = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *)&state[0]), 0xB1);
+    __m128i st1  = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *)&state[4]), 0x1B);
+    __m128i st0  = _mm_alignr_epi8(tmp, st1, 8);       /* ABEF */
+    st1 = _mm_blend_epi16(st1, tmp, 0xF0);             /* CDGH */
+
+    for (; nblocks > 0; nblocks--, p += 64) {
+        __m128i abef = st0, cdgh = st1;
+        __m128i w[4];
+        for (int i = 0; i < 4; i++)
+            w[i] = _mm_shuffle_epi8(
+                _mm_loadu_si128((const __m128i *)(p + 16 * i)), bswap);
+
+        for (int i = 0; i < 16; i++) {
+            __m128i msg = _mm_add_epi32(
+                w[i & 3], _mm_loadu_si128((const __m128i *)&sha256_k[4 * i]));
+            st1 = _mm_sha256rnds2_epu32(st1, st0, msg);
+            st0 = _mm_sha256rnds2_epu32(st0, st1, _mm_shuffle_epi32(msg, 0x0E));
+            if (i < 12) {
+                __m128i t = _mm_sha256msg1_epu32(w[i & 3], w[(i + 1) & 3]);
+                t = _mm_add_epi32(t, _mm_alignr_epi8(w[(i + 3) & 3],
+                                                     w[(i + 2) & 3], 4));
+                w[i & 3] = _mm_sha256msg2_epu32(t, w[(i + 3) & 3]);
+            }
+        }
+
+        st0 = _mm_add_epi32(st0, abef);
+        st1 = _mm_add_epi32(st1, cdgh);
+    }
+
+    tmp = _mm_shuffle_epi32(st0, 0x1B);                /* FEBA */
+    st1 = _mm_shuffle_epi32(st1, 0xB1);                /* DCHG */
+    _mm_storeu_si128((__m128i *)&state[0], _mm_blend_epi16(tmp, st1, 0xF0));
+    _mm_storeu_si128((__m128i *)&state[4], _mm_alignr_epi8(st1, tmp, 8));
+}
+
+static int sha256_cpu_has_shani(void)
+{
+    unsigned int a, b, c, d;
+    if (!__get_cpuid(1, &a, &b, &c, &d))
+        return 0;
+    if (!(c & (1u << 9)) || !(c & (1u << 19)))      /* SSSE3, SSE4.1 */
+        return 0;
+    if (!__get_cpuid_count(7, 0, &a, &b, &c, &d))
+        return 0;
+    return (b & (1u << 29)) != 0;                    /* SHA */
+}
+#endif /* HL_SHA256_X86 */
+
+#ifdef HL_SHA256_ARM
+#if defined(__ARM_FEATURE_SHA2) || defined(__ARM_FEATURE_CRYPTO)
+#define HL_SHA2_TARGET
+#elif defined(__clang__)
+#define HL_SHA2_TARGET __attribute__((target("crypto")))
+#else
+#define HL_SHA2_TARGET __attribute__((target("+crypto")))
+#endif
+
+/* ARMv8 SHA2 extension: four rounds per vsha256h/h2 pair */
+HL_SHA2_TARGET
+static void sha256_blocks_armv8(uint32_t state[8], const uint8_t *p,
+                                size_t nblocks)
+{
+    uint32x4_t st0 = vld1q_u32(&state[0]);             /* ABCD */
+    uint32x4_t st1 = vld1q_u32(&state[4]);             /* EFGH */
+
+    for (; nblocks > 0; nblocks--, p += 64) {
+        uint32x4_t abcd = st0, efgh = st1;
+        uint32x4_t w[4];
+        for (int i = 0; i < 4; i++)
+            w[i] = vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(p + 16 * i)));
+
+        for (int i = 0; i < 16; i++) {
+            uint32x4_t wk = vaddq_u32(w[i & 3], vld1q_u32(&sha256_k[4 * i]));
+            uint32x4_t prev = st0;
+            if (i < 12)
+                w[i & 3] = vsha256su1q_u32(
+                    vsha256su0q_u32(w[i & 3], w[(i + 1) & 3]),
+                    w[(i + 2) & 3], w[(i + 3) & 3]);
+            st0 = vsha256hq_u32(st0, st1, wk);
+            st1 = vsha256h2q_u32(st1, prev, wk);
+        }
+
+        st0 = vaddq_u32(st0, abcd);
+        st1 = vaddq_u32(st1, efgh);
+    }
+
+    vst1q_u32(&state[0], st0);
+    vst1q_u32(&state[4], st1);
+}
+
+static int sha256_cpu_has_armv8(void)
+{
+#if defined(__ARM_FEATURE_SHA2) || defined(__ARM_FEATURE_CRYPTO)
+    return 1;
+#elif defined(__APPLE__)
+    return 1;   /* every Apple Silicon core implements FEAT_SHA256 */
+#else
+    return (getauxval(AT_HWCAP) & HWCAP_SHA2) != 0;
+#endif
+}
+#endif /* HL_SHA256_ARM */
 
-    uint32_t state[8] = {
+static Sha256BlocksFn sha256_blocks;
+static const char    *sha256_backend = "portable";
+
+/* Runs before main() where supported; sha256_init() covers the rest */
+#if defined(__GNUC__) || defined(__clang__)
+__attribute__((constructor))
+#endif
+static void sha256_select(void)
+{
+#ifdef HL_SHA256_X86
+    if (sha256_cpu_has_shani()) {
+        sha256_backend = "sha-ni";
+        sha256_blocks = sha256_blocks_shani;
+        return;
+    }
+#endif
+#ifdef HL_SHA256_ARM
+    if (sha256_cpu_has_armv8()) {
+        sha256_backend = "armv8-sha2";
+        sha256_blocks = sha256_blocks_armv8;
+        return;
+    }
+#endif
+    sha256_backend = "portable";
+    sha256_blocks = sha256_blocks_portable;
+}
+
+const char *hl_cap_crypto_sha256_backend(void)
+{
+    if (!sha256_blocks)
+        sha256_select();
+    return sha256_backend;
+}
+
+void hl_cap_crypto_sha256_force_portable(int on)
+{
+    if (on) {
+        sha256_backend = "portable";
+        sha256_blocks = sha256_blocks_portable;
+    } else {
+        sha256_select();
+    }
+}
+
+/* Incremental SHA-256 — lets HMAC hash its pad and message without
+ * concatenating them into a temporary buffer. */
+typedef struct {
+    uint32_t state[8];
+    uint64_t total;     /* bytes absorbed */
+    uint8_t  buf[64];
+    size_t   buf_len;
+} Sha256Ctx;
+
+static void sha256_init(Sha256Ctx *c)
+{
+    static const uint32_t iv[8] = {
         0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
         0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19,
     };
+    if (!sha256_blocks)
+        sha256_select();
+    memcpy(c->state, iv, sizeof(iv));
+    c->total = 0;
+    c->buf_len = 0;
+}
 
+static void sha256_update(Sha256Ctx *c, const void *data, size_t len)
+{
     const uint8_t *p = (const uint8_t *)data;
-    size_t remaining = len;
-
-    while (remaining >= 64) {
-        sha256_transform(state, p);
-        p += 64;
-        remaining -= 64;
+    c->total += len;
+
+    if (c->buf_len > 0) {
+        size_t n = 64 - c->buf_len;
+        if (n > len)
+            n = len;
+        memcpy(c->buf + c->buf_len, p, n);
+        c->buf_len += n;
+        p += n;
+        len -= n;
+        if (c->buf_len < 64)
+            return;
+        sha256_blocks(c->state, c->buf, 1);
+        c->buf_len = 0;
     }
 
-    uint8_t block[64];
-    memset(block, 0, 64);
-    memcpy(block, p, remaining);
-    block[remaining] = 0x80;
+    if (len >= 64) {
+        size_t nblocks = len / 64;
+        sha256_blocks(c->state, p, nblocks);
+        p += nblocks * 64;
+        len -= nblocks * 64;
+    }
 
-    if (remaining >= 56) {
-        sha256_transform(state, block);
-        memset(block, 0, 64);
+    if (len > 0) {
+        memcpy(c->buf, p, len);
+        c->buf_len = len;
     }
+}
 
-    uint64_t bits = (uint64_t)len * 8;
-    block[56] = (uint8_t)(bits >> 56);
-    block[57] = (uint8_t)(bits >> 48);
-    block[58] = (uint8_t)(bits >> 40);
-    block[59] = (uint8_t)(bits >> 32);
-    block[60] = (uint8_t)(bits >> 24);
-    block[61] = (uint8_t)(bits >> 16);
-    block[62] = (uint8_t)(bits >>  8);
-    block[63] = (uint8_t)(bits);
+static void sha256_final(Sha256Ctx *c, uint8_t out[32])
+{
+    uint64_t bits = c->total * 8;
 
-    sha256_transform(state, block);
+    c->buf[c->buf_len++] = 0x80;
+    if (c->buf_len > 56) {
+        memset(c->buf + c->buf_len, 0, 64 - c->buf_len);
+        sha256_blocks(c->state, c->buf, 1);
+        c->buf_len = 0;
+    }
+    memset(c->buf + c->buf_len, 0, 56 - c->buf_len);
+    for (int i = 0; i < 8; i++)
+        c->buf[56 + i] = (uint8_t)(bits >> (56 - 8 * i));
+    sha256_blocks(c->state, c->buf, 1);
 
     for (int i = 0; i < 8; i++) {
-        out[i*4+0] = (uint8_t)(state[i] >> 24);
-        out[i*4+1] = (uint8_t)(state[i] >> 16);
-        out[i*4+2] = (uint8_t)(state[i] >>  8);
-        out[i*4+3] = (uint8_t)(state[i]);
+        out[i*4+0] = (uint8_t)(c->state[i] >> 24);
+        out[i*4+1] = (uint8_t)(c->state[i] >> 16);
+        out[i*4+2] = (uint8_t)(c->state[i] >>  8);
+        out[i*4+3] = (uint8_t)(c->state[i]);
+    }
+}
+
+int hl_cap_crypto_sha256(const void *data, size_t len, uint8_t out[32])
+{
+    if (!data || !out)
+        return -1;
+
+    Sha256Ctx c;
+    sha256_init(&c);
+    sha256_update(&c, data, len);
+    sha256_final(&c, out);
+    hull_secure_zero(&c, sizeof(c));
+    return 0;
+}
+
+/* ── Batched SHA-256 ───────────────────────────────────────────────────
+ *
+ * Integrity checks hash thousands of independent files. A single
+ * SHA-NI / ARMv8 stream already outruns a multi-lane SIMD kernel, so
+ * batches scale across cores instead: the caller and up to
+ * HL_SHA256_MANY_MAX_THREADS - 1 helpers claim items one at a time
+ * (sizes vary widely, so no static split).
+ */
+
+typedef struct {
+    pthread_mutex_t mu;
+    HlSha256Item   *items;
+    size_t          n;
+    size_t          next;
+} Sha256Batch;
+
+static void sha256_item(HlSha256Item *it)
+{
+    Sha256Ctx c;
+    sha256_init(&c);
+    sha256_update(&c, it->data, it->len);
+    sha256_final(&c, it->hash);
+}
+
+static void *sha256_batch_worker(void *arg)
+{
+    Sha256Batch *b = arg;
+    for (;;) {
+        pthread_mutex_lock(&b->mu);
+        size_t i = b->next < b->n ? b->next++ : b->n;
+        pthread_mutex_unlock(&b->mu);
+        if (i == b->n)
+            return NULL;
+        sha256_item(&b->items[i]);
     }
+}
+
+int hl_cap_crypto_sha256_many(HlSha256Item *items, size_t n)
+{
+    if (!items && n > 0)
+        return -1;
+
+    size_t total = 0;
+    for (size_t i = 0; i < n; i++) {
+        if (!items[i].data && items[i].len > 0)
+            return -1;
+        total += items[i].len;
+    }
+
+    long ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+    size_t nthreads = ncpu > 0 ? (size_t)ncpu : 1;
+    if (nthreads > HL_SHA256_MANY_MAX_THREADS)
+        nthreads = HL_SHA256_MANY_MAX_THREADS;
+    if (nthreads > n)
+        nthreads = n;
+
+    if (nthreads < 2 || total < HL_SHA256_MANY_MIN_BYTES) {
+        for (size_t i = 0; i < n; i++)
+            sha256_item(&items[i]);
+        return 0;
+    }
+
+    if (!sha256_blocks)
+        sha256_select();
+
+    Sha256Batch b = { .items = items, .n = n, .next = 0 };
+    pthread_mutex_init(&b.mu, NULL);
 
+    pthread_t tids[HL_SHA256_MANY_MAX_THREADS];
+    size_t started = 0;
+    for (size_t i = 0; i + 1 < nthreads; i++) {
+        if (pthread_create(&tids[started], NULL, sha256_batch_worker, &b) != 0)
+            break;
+        started++;
+    }
+
+    /* The caller works too, so a failed pthread_create only costs speed */
+    sha256_batch_worker(&b);
+    for (size_t i = 0; i < started; i++)
+        pthread_join(tids[i], NULL);
+
+    pthread_mutex_destroy(&b.mu);
     return 0;
 }
 
@@ -210,41 +529,21 @@ int hl_cap_crypto_hmac_sha256(const uint8_t *key, size_t key_len,
         k_opad[i] ^= key[i];
     }
 
-    /* inner hash: SHA256(k_ipad || msg)
-     *
-     * Hybrid stack/heap pattern: use a ~4 KB stack buffer for small
-     * messages, falling back to malloc for larger inputs. The 4096-byte
-     * threshold keeps stack usage well under 1% of typical thread stacks
-     * (1-2 MiB on Linux/macOS, same for Cosmopolitan). This pattern
-     * repeats across all crypto functions in this file. */
-    if (msg_len > SIZE_MAX / 2) {
-        hull_secure_zero(k_ipad, sizeof(k_ipad));
-        hull_secure_zero(k_opad, sizeof(k_opad));
-        hull_secure_zero(tk, sizeof(tk));
-        return -1;
-    }
-    size_t inner_len = 64 + msg_len;
-    uint8_t stack_inner[4160]; /* 64 + 4096 */
-    uint8_t *inner_buf = (inner_len <= sizeof(stack_inner)) ? stack_inner
-                                                             : malloc(inner_len);
-    if (!inner_buf) {
-        hull_secure_zero(k_ipad, sizeof(k_ipad));
-        hull_secure_zero(k_opad, sizeof(k_opad));
-        hull_secure_zero(tk, sizeof(tk));
-        return -1;
-    }
-    memcpy(inner_buf, k_ipad, 64);
-    memcpy(inner_buf + 64, msg, msg_len);
+    /* inner hash: SHA256(k_ipad || msg) */
+    Sha256Ctx c;
     uint8_t inner_hash[32];
-    hl_cap_crypto_sha256(inner_buf, inner_len, inner_hash);
-    if (inner_buf != stack_inner) free(inner_buf);
+    sha256_init(&c);
+    sha256_update(&c, k_ipad, 64);
+    sha256_update(&c, msg, msg_len);
+    sha256_final(&c, inner_hash);
 
     /* outer hash: SHA256(k_opad || inner_hash) */
-    uint8_t outer[64 + 32];
-    memcpy(outer, k_opad, 64);
-    memcpy(outer + 64, inner_hash, 32);
-    hl_cap_crypto_sha256(outer, 96, out);
+    sha256_init(&c);
+    sha256_update(&c, k_opad, 64);
+    sha256_update(&c, inner_hash, 32);
+    sha256_final(&c, out);
 
+    hull_secure_zero(&c, sizeof(c));
     hull_secure_zero(k_ipad, sizeof(k_ipad));
     hull_secure_zero(k_opad, sizeof(k_opad));
     hull_secure_zero(tk, sizeof(tk));
@@ -254,6 +553,18 @@ int hl_cap_crypto_hmac_sha256(const uint8_t *key, size_t key_len,
 
 /* ── HMAC-SHA256 verify (constant-time) ────────────────────────────── */
 
+int hl_cap_crypto_equal(const void *a, const void *b, size_t len)
+{
+    if (!a || !b)
+        return 0;
+    const uint8_t *x = (const uint8_t *)a;
+    const uint8_t *y = (const uint8_t *)b;
+    volatile uint8_t diff = 0;
+    for (size_t i = 0; i < len; i++)
+        diff |= x[i] ^ y[i];
+    return diff == 0;
+}
+
 int hl_cap_crypto_hmac_sha256_verify(const uint8_t *key, size_t key_len,
                                       const uint8_t *msg, size_t msg_len,
                                       const uint8_t expected[32])
@@ -387,7 +698,25 @@ int hl_cap_crypto_base64url_decode(const char *str, size_t str_len,
     return 0;
 }
 
-/* ── PBKDF2-HMAC-SHA256 ────────────────────────────────────────────── */
+/* ── PBKDF2-HMAC-SHA256 ────────────────────────────────────────────────
+ *
+ * Every iteration is HMAC(P, U) with the same password, so the ipad and
+ * opad key blocks are absorbed once and their midstates cloned per
+ * iteration. U is always 32 bytes, so each inner and outer hash is a
+ * single pre-padded block: two compressions per iteration instead of
+ * the four a full HMAC call costs.
+ */
+
+/* Big-endian state words into the first 32 bytes of a block */
+static void sha256_store_state(uint8_t *dst, const uint32_t state[8])
+{
+    for (int i = 0; i < 8; i++) {
+        dst[i*4+0] = (uint8_t)(state[i] >> 24);
+        dst[i*4+1] = (uint8_t)(state[i] >> 16);
+        dst[i*4+2] = (uint8_t)(state[i] >>  8);
+        dst[i*4+3] = (uint8_t)(state[i]);
+    }
+}
 
 int hl_cap_crypto_pbkdf2(const char *password, size_t pw_len,
                            const uint8_t *salt, size_t salt_len,
@@ -397,42 +726,78 @@ int hl_cap_crypto_pbkdf2(const char *password, size_t pw_len,
     if (!password || !salt || !out || iterations < 100000 || out_len == 0)
         return -1;
 
-    /* Salt size guard — stack buffer is 68 bytes */
+    /* Salt size guard — matches the historical 68-byte work buffer */
     if (salt_len > 64)
         return -1;
 
-    uint8_t work[68];
-
-    memcpy(work, salt, salt_len);
+    /* HMAC key blocks, hashing an over-long password first */
+    uint8_t key[64], tk[32];
+    const uint8_t *pw = (const uint8_t *)password;
+    if (pw_len > 64) {
+        hl_cap_crypto_sha256(pw, pw_len, tk);
+        pw = tk;
+        pw_len = 32;
+    }
 
+    Sha256Ctx inner, outer;
+    memset(key, 0x36, 64);
+    for (size_t i = 0; i < pw_len; i++)
+        key[i] ^= pw[i];
+    sha256_init(&inner);
+    sha256_update(&inner, key, 64);
+
+    memset(key, 0x5c, 64);
+    for (size_t i = 0; i < pw_len; i++)
+        key[i] ^= pw[i];
+    sha256_init(&outer);
+    sha256_update(&outer, key, 64);
+
+    /* One block: U (32 bytes) || 0x80 || zeros || bit length of
+     * key block + U = 768. Shared by the inner and outer hash. */
+    uint8_t blk[64];
+    memset(blk, 0, sizeof(blk));
+    blk[32] = 0x80;
+    blk[62] = 0x03;
+    blk[63] = 0x00;
+
+    uint8_t be[4];
+    uint32_t st[8];
+    uint8_t t[32];
     size_t offset = 0;
     uint32_t block_num = 1;
 
     while (offset < out_len) {
-        /* Append block number (big-endian) */
-        work[salt_len + 0] = (uint8_t)(block_num >> 24);
-        work[salt_len + 1] = (uint8_t)(block_num >> 16);
-        work[salt_len + 2] = (uint8_t)(block_num >>  8);
-        work[salt_len + 3] = (uint8_t)(block_num);
-
-        uint8_t u[32], t[32];
-        if (hl_cap_crypto_hmac_sha256((const uint8_t *)password, pw_len,
-                        work, salt_len + 4, u) != 0) {
-            hull_secure_zero(u, sizeof(u));
-            hull_secure_zero(t, sizeof(t));
-            return -1;
-        }
-        memcpy(t, u, 32);
+        be[0] = (uint8_t)(block_num >> 24);
+        be[1] = (uint8_t)(block_num >> 16);
+        be[2] = (uint8_t)(block_num >>  8);
+        be[3] = (uint8_t)(block_num);
+
+        /* U1 = HMAC(P, salt || INT(block_num)) */
+        Sha256Ctx c = inner;
+        sha256_update(&c, salt, salt_len);
+        sha256_update(&c, be, 4);
+        sha256_final(&c, blk);
+        c = outer;
+        sha256_update(&c, blk, 32);
+        sha256_final(&c, blk);
+        memcpy(t, blk, 32);
+
+        /* sha256_final wrote into bytes 0..31 only; restore padding */
+        memset(blk + 32, 0, 32);
+        blk[32] = 0x80;
+        blk[62] = 0x03;
 
         for (int i = 1; i < iterations; i++) {
-            if (hl_cap_crypto_hmac_sha256((const uint8_t *)password, pw_len,
-                            u, 32, u) != 0) {
-                hull_secure_zero(u, sizeof(u));
-                hull_secure_zero(t, sizeof(t));
-                return -1;
-            }
+            memcpy(st, inner.state, sizeof(st));
+            sha256_blocks(st, blk, 1);
+            sha256_store_state(blk, st);
+
+            memcpy(st, outer.state, sizeof(st));
+            sha256_blocks(st, blk, 1);
+            sha256_store_state(blk, st);
+
             for (int j = 0; j < 32; j++)
-                t[j] ^= u[j];
+                t[j] ^= blk[j];
         }
 
         size_t to_copy = out_len - offset;
@@ -440,16 +805,118 @@ int hl_cap_crypto_pbkdf2(const char *password, size_t pw_len,
             to_copy = 32;
         memcpy(out + offset, t, to_copy);
 
-        hull_secure_zero(u, sizeof(u));
-        hull_secure_zero(t, sizeof(t));
-
         offset += to_copy;
         block_num++;
     }
 
+    hull_secure_zero(&inner, sizeof(inner));
+    hull_secure_zero(&outer, sizeof(outer));
+    hull_secure_zero(key, sizeof(key));
+    hull_secure_zero(tk, sizeof(tk));
+    hull_secure_zero(blk, sizeof(blk));
+    hull_secure_zero(st, sizeof(st));
+    hull_secure_zero(t, sizeof(t));
+    return 0;
+}
+
+/* ── Password hashing ("pbkdf2:iterations:salt_hex:hash_hex") ──────── */
+
+static int crypto_hex_nibble(unsigned char c)
+{
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return 10 + (c - 'a');
+    if (c >= 'A' && c <= 'F') return 10 + (c - 'A');
+    return -1;
+}
+
+/* Decode exactly 2*n hex chars (no sscanf %x — Cosmopolitan compat) */
+static int crypto_hex_decode(const char *hex, uint8_t *out, size_t n)
+{
+    for (size_t i = 0; i < n; i++) {
+        int hi = crypto_hex_nibble((unsigned char)hex[i * 2]);
+        int lo = crypto_hex_nibble((unsigned char)hex[i * 2 + 1]);
+        if (hi < 0 || lo < 0)
+            return -1;
+        out[i] = (uint8_t)((hi << 4) | lo);
+    }
     return 0;
 }
 
+int hl_cap_crypto_password_hash(const char *password, size_t pw_len,
+                                char *out, size_t out_size)
+{
+    static const char hex[] = "0123456789abcdef";
+    uint8_t salt[16], hash[32];
+
+    if (!password || !out || out_size < HL_PASSWORD_HASH_MAX)
+        return -1;
+    if (hl_cap_crypto_random(salt, sizeof(salt)) != 0)
+        return -1;
+    if (hl_cap_crypto_pbkdf2(password, pw_len, salt, sizeof(salt),
+                             HL_PBKDF2_ITERATIONS, hash, sizeof(hash)) != 0) {
+        hull_secure_zero(salt, sizeof(salt));
+        return -1;
+    }
+
+    int n = snprintf(out, out_size, "pbkdf2:%d:", HL_PBKDF2_ITERATIONS);
+    char *p = out + n;
+    for (int i = 0; i < 16; i++) {
+        *p++ = hex[salt[i] >> 4];
+        *p++ = hex[salt[i] & 0xf];
+    }
+    *p++ = ':';
+    for (int i = 0; i < 32; i++) {
+        *p++ = hex[hash[i] >> 4];
+        *p++ = hex[hash[i] & 0xf];
+    }
+    *p = '\0';
+
+    hull_secure_zero(hash, sizeof(hash));
+    hull_secure_zero(salt, sizeof(salt));
+    return 0;
+}
+
+int hl_cap_crypto_password_verify(const char *password, size_t pw_len,
+                                  const char *stored)
+{
+    if (!password || !stored)
+        return 0;
+
+    /* Parse "pbkdf2:iterations:salt_hex:hash_hex" manually (no scansets
+     * — Cosmopolitan libc doesn't support sscanf %[...] scansets). */
+    if (strncmp(stored, "pbkdf2:", 7) != 0)
+        return 0;
+    const char *p = stored + 7;
+
+    char *end = NULL;
+    long iterations = strtol(p, &end, 10);
+    if (!end || *end != ':' || iterations < 100000 || iterations > INT_MAX)
+        return 0;
+    p = end + 1;
+
+    if (strlen(p) < 32 + 1 + 64 || p[32] != ':')
+        return 0;
+
+    uint8_t salt[16], stored_hash[32], computed[32];
+    if (crypto_hex_decode(p, salt, sizeof(salt)) != 0 ||
+        crypto_hex_decode(p + 33, stored_hash, sizeof(stored_hash)) != 0)
+        return 0;
+
+    if (hl_cap_crypto_pbkdf2(password, pw_len, salt, sizeof(salt),
+                             (int)iterations, computed, sizeof(computed)) != 0)
+        return 0;
+
+    /* Constant-time comparison */
+    volatile uint8_t diff = 0;
+    for (int i = 0; i < 32; i++)
+        diff |= computed[i] ^ stored_hash[i];
+
+    hull_secure_zero(computed, sizeof(computed));
+    hull_secure_zero(stored_hash, sizeof(stored_hash));
+    hull_secure_zero(salt, sizeof(salt));
+    return diff == 0;
+}
+
 /* ── Ed25519 (via TweetNaCl) ─────────────────────────────────────────
  *
  * Only this file includes tweetnacl.h. All other code goes through
@@ -10,6 +10,7 @@
 
 #include "hull/cap/db.h"
 #include "hull/cap/audit.h"
+#include "hull/cap/metrics.h"
 #include "hull/alloc.h"
 #include <sqlite3.h>
 #include <limits.h>
@@ -51,9 +52,11 @@ static sqlite3_stmt *cache_get(HlStmtCache *cache, const char *sql)
             cache->entries[cache->count - 1] = hit;
             sqlite3_reset(hit.stmt);
             sqlite3_clear_bindings(hit.stmt);
+            hl_metrics_stmt_cache(1);
             return hit.stmt;
         }
     }
+    hl_metrics_stmt_cache(0);
 
     /* Miss — prepare new statement */
     sqlite3_stmt *stmt = NULL;
@@ -215,18 +218,12 @@ static void column_to_value(sqlite3_stmt *stmt, int col, HlValue *out)
 
 /* ── Public API ─────────────────────────────────────────────────────── */
 
-int hl_cap_db_query(HlStmtCache *cache, const char *sql,
-                    const HlValue *params, int nparams,
-                    HlRowCallback cb, void *ctx,
-                    HlAllocator *alloc)
+/* Bind, step every row into cb, reset. Shared by query and each. */
+static int db_rows(sqlite3_stmt *stmt, const char *sql,
+                   const HlValue *params, int nparams,
+                   HlRowCallback cb, void *ctx,
+                   HlAllocator *alloc, const char *audit_event)
 {
-    if (!cache || !sql || !cb)
-        return -1;
-
-    sqlite3_stmt *stmt = cache_get(cache, sql);
-    if (!stmt)
-        return -1;
-
     if (nparams > 0 && params) {
         if (bind_params(stmt, params, nparams) != 0) {
             sqlite3_reset(stmt);
@@ -301,7 +298,7 @@ int hl_cap_db_query(HlStmtCache *cache, const char *sql,
     sqlite3_reset(stmt);
 
     {
-        ShJsonWriter w = hl_audit_begin("db.query");
+        ShJsonWriter w = hl_audit_begin(audit_event);
         size_t sql_len = strlen(sql);
         sh_json_write_key(&w, "sql");
         sh_json_write_string_n(&w, sql, sql_len < 512 ? sql_len : 512);
@@ -312,7 +309,65 @@ int hl_cap_db_query(HlStmtCache *cache, const char *sql,
     return result;
 }
 
-int hl_cap_db_exec(HlStmtCache *cache, const char *sql,
+static int db_query(HlStmtCache *cache, const char *sql,
+                    const HlValue *params, int nparams,
+                    HlRowCallback cb, void *ctx,
+                    HlAllocator *alloc)
+{
+    if (!cache || !sql || !cb)
+        return -1;
+
+    sqlite3_stmt *stmt = cache_get(cache, sql);
+    if (!stmt)
+        return -1;
+    return db_rows(stmt, sql, params, nparams, cb, ctx, alloc, "db.query");
+}
+
+/*
+ * The callback may run other queries, so the statement is prepared for
+ * this call alone: a cached one could be reset or evicted under it.
+ */
+static int db_each(HlStmtCache *cache, const char *sql,
+                   const HlValue *params, int nparams,
+                   HlRowCallback cb, void *ctx,
+                   HlAllocator *alloc)
+{
+    if (!cache || !sql || !cb)
+        return -1;
+
+    sqlite3_stmt *stmt = NULL;
+    if (sqlite3_prepare_v2(cache->db, sql, -1, &stmt, NULL) != SQLITE_OK) {
+        sqlite3_finalize(stmt);
+        return -1;
+    }
+    int rc = db_rows(stmt, sql, params, nparams, cb, ctx, alloc, "db.each");
+    sqlite3_finalize(stmt);
+    return rc;
+}
+
+int hl_cap_db_each(HlStmtCache *cache, const char *sql,
+                   const HlValue *params, int nparams,
+                   HlRowCallback cb, void *ctx,
+                   HlAllocator *alloc)
+{
+    uint64_t t0 = hl_metrics_start();
+    int rc = db_each(cache, sql, params, nparams, cb, ctx, alloc);
+    hl_metrics_cap_end(HL_METRIC_DB, t0, rc);
+    return rc;
+}
+
+int hl_cap_db_query(HlStmtCache *cache, const char *sql,
+                    const HlValue *params, int nparams,
+                    HlRowCallback cb, void *ctx,
+                    HlAllocator *alloc)
+{
+    uint64_t t0 = hl_metrics_start();
+    int rc = db_query(cache, sql, params, nparams, cb, ctx, alloc);
+    hl_metrics_cap_end(HL_METRIC_DB, t0, rc);
+    return rc;
+}
+
+static int db_exec(HlStmtCache *cache, const char *sql,
                    const HlValue *params, int nparams)
 {
     if (!cache || !sql)
@@ -350,6 +405,15 @@ int hl_cap_db_exec(HlStmtCache *cache, const char *sql,
     return result;
 }
 
+int hl_cap_db_exec(HlStmtCache *cache, const char *sql,
+                   const HlValue *params, int nparams)
+{
+    uint64_t t0 = hl_metrics_start();
+    int rc = db_exec(cache, sql, params, nparams);
+    hl_metrics_cap_end(HL_METRIC_DB, t0, rc);
+    return rc;
+}
+
 int64_t hl_cap_db_last_id(sqlite3 *db)
 {
     if (!db)
@@ -1,14 +1,16 @@
 /*
  * http.c — HTTP client capability implementation
  *
- * Synchronous HTTP/1.1 client with host allowlist, timeouts, and
- * optional TLS support via Keel's KlTls vtable.
+ * Synchronous HTTP/1.1 client with host allowlist, timeouts,
+ * optional TLS support via Keel's KlTls vtable, and an optional
+ * keep-alive connection pool.
  *
  * SPDX-License-Identifier: AGPL-3.0-or-later
  */
 
 #include "hull/cap/http.h"
 #include "hull/cap/audit.h"
+#include "hull/cap/metrics.h"
 #include "hull/cap/http_parser.h"
 #include "hull/limits.h"
 
@@ -19,10 +21,13 @@
 #include <fcntl.h>
 #include <netdb.h>
 #include <poll.h>
+#include <pthread.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <strings.h>
+#include <time.h>
 #include <unistd.h>
 #include <sys/socket.h>
 #include <sys/types.h>
@@ -306,7 +311,7 @@ static int send_request(int fd, KlTls *tls,
                          const char *method, const HlParsedUrl *url,
                          const HlHttpHeader *headers, int num_headers,
                          const char *body, size_t body_len,
-                         int timeout_ms)
+                         int keep_alive, int timeout_ms)
 {
     /* Reject CRLF in method (header injection) */
     if (has_crlf(method, strlen(method)))
@@ -348,9 +353,10 @@ static int send_request(int fd, KlTls *tls,
         off += n;
     }
 
-    /* Connection: close */
-    int n = snprintf(buf + off, sizeof(buf) - (size_t)off,
-                     "Connection: close\r\n\r\n");
+    /* Connection: close, unless the connection goes back to a pool
+     * (keep-alive is the HTTP/1.1 default) */
+    int n = snprintf(buf + off, sizeof(buf) - (size_t)off, "%s\r\n",
+                     keep_alive ? "" : "Connection: close\r\n");
     if (n < 0 || (size_t)(off + n) >= sizeof(buf)) {
         log_warn("http: request headers exceed %d-byte buffer", HL_HTTP_REQ_BUF_SIZE);
         return -1;
@@ -392,9 +398,19 @@ static int send_request(int fd, KlTls *tls,
 
 /* ── Receive + parse response ────────────────────────────────────── */
 
+/*
+ * *framed is set when the response ended where its framing said
+ * (Content-Length, chunked, or no body) with nothing after it, so the
+ * connection may carry another request; *got is set once any byte came
+ * back.
+ */
 static int recv_response(int fd, KlTls *tls, HlHttpResponse *resp,
-                          size_t max_response_size, int timeout_ms)
+                          size_t max_response_size, int timeout_ms,
+                          int *framed, int *got)
 {
+    *framed = 0;
+    *got = 0;
+
     KlAllocator alloc = kl_allocator_default();
     HlHttpParser *parser = hl_http_parser_llhttp(max_response_size, &alloc);
     if (!parser)
@@ -419,11 +435,13 @@ static int recv_response(int fd, KlTls *tls, HlHttpResponse *resp,
             }
             break;
         }
+        *got = 1;
 
         size_t consumed;
         HlHttpParseResult pr2 = parser->parse(parser, resp,
                                                buf, (size_t)nread, &consumed);
         if (pr2 == HL_HTTP_PARSE_OK) {
+            *framed = consumed == (size_t)nread;
             ret = 0;
             break;
         }
@@ -439,9 +457,188 @@ static int recv_response(int fd, KlTls *tls, HlHttpResponse *resp,
     return ret;
 }
 
+/* ── Connection pool ─────────────────────────────────────────────── */
+
+typedef struct {
+    int       fd;               /* -1 = not connected */
+    KlTls    *tls;
+    int       is_https;
+    int       port;
+    char      host[256];
+    uint64_t  idle_since_ms;
+} HttpConn;
+
+struct HlHttpPool {
+    pthread_mutex_t mu;
+    int             idle_ms;
+    int             count;
+    HttpConn        conns[HL_HTTP_POOL_SIZE];
+};
+
+static uint64_t http_now_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000 + (uint64_t)ts.tv_nsec / 1000000;
+}
+
+static void conn_close(HttpConn *c)
+{
+    if (c->fd < 0)
+        return;
+    if (c->tls) {
+        c->tls->shutdown(c->tls, c->fd);
+        c->tls->destroy(c->tls);
+        c->tls = NULL;
+    }
+    close(c->fd);
+    c->fd = -1;
+}
+
+/* An idle connection with something to read was closed (or broken) by
+ * the server */
+static int conn_stale(const HttpConn *c)
+{
+    struct pollfd pfd = { .fd = c->fd, .events = POLLIN };
+    return poll(&pfd, 1, 0) != 0;
+}
+
+static int conn_matches(const HttpConn *c, const HlParsedUrl *url)
+{
+    return c->is_https == url->is_https && c->port == url->port &&
+           strlen(c->host) == url->host_len &&
+           strncasecmp(c->host, url->host, url->host_len) == 0;
+}
+
+HlHttpPool *hl_http_pool_create(int idle_ms)
+{
+    HlHttpPool *pool = calloc(1, sizeof(*pool));
+    if (!pool)
+        return NULL;
+    if (pthread_mutex_init(&pool->mu, NULL) != 0) {
+        free(pool);
+        return NULL;
+    }
+    pool->idle_ms = idle_ms;
+    return pool;
+}
+
+void hl_http_pool_destroy(HlHttpPool *pool)
+{
+    if (!pool)
+        return;
+    for (int i = 0; i < pool->count; i++)
+        conn_close(&pool->conns[i]);
+    pthread_mutex_destroy(&pool->mu);
+    free(pool);
+}
+
+/*
+ * Take an idle connection to url's origin out of the pool. Returns 0 and
+ * fills *out, or -1 when there is none. Connections idle past idle_ms
+ * are closed on the way.
+ */
+static int pool_take(HlHttpPool *pool, const HlParsedUrl *url, HttpConn *out)
+{
+    HttpConn expired[HL_HTTP_POOL_SIZE];
+    int n_expired = 0, found = 0;
+    uint64_t now = http_now_ms();
+
+    pthread_mutex_lock(&pool->mu);
+    for (int i = pool->count - 1; i >= 0; i--) {
+        HttpConn *c = &pool->conns[i];
+        int take = !found && conn_matches(c, url);
+        if (take)
+            *out = *c;
+        else if (now - c->idle_since_ms >= (uint64_t)pool->idle_ms)
+            expired[n_expired++] = *c;
+        else
+            continue;
+        found |= take;
+        pool->conns[i] = pool->conns[--pool->count];
+    }
+    pthread_mutex_unlock(&pool->mu);
+
+    for (int i = 0; i < n_expired; i++)
+        conn_close(&expired[i]);
+    return found ? 0 : -1;
+}
+
+/* Return a connection after a complete response; evicts the least
+ * recently used one when the pool is full */
+static void pool_put(HlHttpPool *pool, HttpConn *c)
+{
+    HttpConn evicted = { .fd = -1 };
+
+    c->idle_since_ms = http_now_ms();
+    pthread_mutex_lock(&pool->mu);
+    if (pool->count == HL_HTTP_POOL_SIZE) {
+        int oldest = 0;
+        for (int i = 1; i < pool->count; i++)
+            if (pool->conns[i].idle_since_ms < pool->conns[oldest].idle_since_ms)
+                oldest = i;
+        evicted = pool->conns[oldest];
+        pool->conns[oldest] = pool->conns[--pool->count];
+    }
+    pool->conns[pool->count++] = *c;
+    pthread_mutex_unlock(&pool->mu);
+
+    conn_close(&evicted);
+    c->fd = -1;
+    c->tls = NULL;
+}
+
+/* Response says the server closes the connection after it */
+static int response_closes(const HlHttpResponse *resp)
+{
+    for (int i = 0; i < resp->num_headers; i++) {
+        if (strcasecmp(resp->headers[i].name, "Connection") == 0 &&
+            strcasecmp(resp->headers[i].value, "close") == 0)
+            return 1;
+    }
+    return 0;
+}
+
+/* Safe to send again when an idle connection dropped it unanswered */
+static int method_idempotent(const char *method)
+{
+    static const char *const m[] = { "GET", "HEAD", "PUT", "DELETE",
+                                      "OPTIONS", NULL };
+    for (int i = 0; m[i]; i++)
+        if (strcmp(method, m[i]) == 0)
+            return 1;
+    return 0;
+}
+
 /* ── Public API ──────────────────────────────────────────────────── */
 
-int hl_cap_http_request(const HlHttpConfig *cfg,
+static int conn_open(HttpConn *c, const HlParsedUrl *url,
+                     KlTlsConfig *tls_cfg, int timeout_ms)
+{
+    c->tls = NULL;
+    c->is_https = url->is_https;
+    c->port = url->port;
+    snprintf(c->host, sizeof(c->host), "%.*s", (int)url->host_len, url->host);
+
+    c->fd = connect_with_timeout(url->host, url->host_len, url->port,
+                                 timeout_ms);
+    if (c->fd < 0)
+        return -1;
+
+    /* TLS handshake (if HTTPS) */
+    if (url->is_https) {
+        c->tls = do_tls_handshake(c->fd, tls_cfg, url->host, url->host_len,
+                                  timeout_ms);
+        if (!c->tls) {
+            close(c->fd);
+            c->fd = -1;
+            return -1;
+        }
+    }
+    return 0;
+}
+
+static int http_request(const HlHttpConfig *cfg,
                         const char *method, const char *url,
                         const HlHttpHeader *headers, int num_headers,
                         const char *body, size_t body_len,
@@ -480,40 +677,49 @@ int hl_cap_http_request(const HlHttpConfig *cfg,
     if (parsed.is_https && !tls_cfg)
         return -1;
 
-    /* Connect */
-    int fd = connect_with_timeout(parsed.host, parsed.host_len,
-                                   parsed.port, timeout_ms);
-    if (fd < 0)
-        return -1;
-
-    KlTls *tls = NULL;
-    int ret = -1;
+    /* A pooled connection the server closed while idle is dropped here */
+    HttpConn conn = { .fd = -1 };
+    int reused = 0;
+    while (cfg->pool && pool_take(cfg->pool, &parsed, &conn) == 0) {
+        if (!conn_stale(&conn)) {
+            reused = 1;
+            break;
+        }
+        conn_close(&conn);
+    }
 
-    /* TLS handshake (if HTTPS) */
-    if (parsed.is_https) {
-        tls = do_tls_handshake(fd, tls_cfg, parsed.host, parsed.host_len,
-                                timeout_ms);
-        if (!tls)
+    int ret = -1, framed = 0;
+    for (;;) {
+        /* Connect */
+        if (conn.fd < 0 && conn_open(&conn, &parsed, tls_cfg, timeout_ms) != 0)
             goto cleanup;
-    }
 
-    /* Send request */
-    if (send_request(fd, tls, method, &parsed,
-                     headers, num_headers, body, body_len, timeout_ms) != 0)
-        goto cleanup;
+        /* Send request, receive response */
+        int got = 0;
+        int sent = send_request(conn.fd, conn.tls, method, &parsed,
+                                headers, num_headers, body, body_len,
+                                cfg->pool != NULL, timeout_ms) == 0;
+        if (sent && recv_response(conn.fd, conn.tls, resp, max_resp,
+                                  timeout_ms, &framed, &got) == 0)
+            break;
 
-    /* Receive response */
-    if (recv_response(fd, tls, resp, max_resp, timeout_ms) != 0)
-        goto cleanup;
+        /* The server may drop a kept-alive connection just as we reuse
+         * it: retry once on a fresh one if nothing came back and the
+         * request cannot have been processed twice */
+        conn_close(&conn);
+        hl_cap_http_free(resp);
+        if (!reused || got || (sent && !method_idempotent(method)))
+            goto cleanup;
+        reused = 0;
+    }
 
     ret = 0;
 
 cleanup:
-    if (tls) {
-        tls->shutdown(tls, fd);
-        tls->destroy(tls);
-    }
-    close(fd);
+    if (ret == 0 && cfg->pool && framed && !response_closes(resp))
+        pool_put(cfg->pool, &conn);
+    else
+        conn_close(&conn);
 
     if (ret != 0)
         hl_cap_http_free(resp);
@@ -530,6 +736,19 @@ cleanup:
     return ret;
 }
 
+int hl_cap_http_request(const HlHttpConfig *cfg,
+                        const char *method, const char *url,
+                        const HlHttpHeader *headers, int num_headers,
+                        const char *body, size_t body_len,
+                        HlHttpResponse *resp)
+{
+    uint64_t t0 = hl_metrics_start();
+    int rc = http_request(cfg, method, url, headers, num_headers,
+                          body, body_len, resp);
+    hl_metrics_cap_end(HL_METRIC_HTTP, t0, rc);
+    return rc;
+}
+
 void hl_cap_http_free(HlHttpResponse *resp)
 {
     if (!resp)
@@ -0,0 +1,556 @@
+/*
+ * metrics.c — Runtime metrics registry and Prometheus endpoint
+ *
+ * Writers are the event loop and capability code; the only reader is
+ * the listener thread. Every counter is an atomic updated with relaxed
+ * ordering, so the request path never takes a lock and a scrape sees
+ * each value whole (series may be a few events apart from each other,
+ * which the exposition format tolerates).
+ *
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#include "hull/cap/metrics.h"
+#include "hull/cap/audit.h"
+#include "hull/cap/time.h"
+#include "hull/alloc.h"
+#include "hull/limits.h"
+#include "hull/log_sink.h"
+#include "hull/runtime.h"
+
+#include <errno.h>
+#include <netdb.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdarg.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+int hl_metrics_enabled = 0;
+
+/* ── Registry ──────────────────────────────────────────────────────── */
+
+typedef struct {
+    _Atomic uint64_t buckets[HL_METRICS_BUCKETS];
+    _Atomic uint64_t sum_ns;
+} Histogram;
+
+typedef struct {
+    char             method[16];
+    char             pattern[HL_METRICS_LABEL_MAX];
+    Histogram        latency;
+    _Atomic uint64_t status[5];     /* 1xx .. 5xx */
+} RouteSeries;
+
+static RouteSeries   routes[HL_METRICS_MAX_ROUTES];
+static _Atomic int   route_count;
+
+typedef struct {
+    char             name[HL_SCHED_NAME_MAX];
+    Histogram        duration;
+    _Atomic uint64_t errors;
+    _Atomic uint64_t skipped;
+} JobSeries;
+
+static JobSeries     jobs[HL_SCHED_MAX_JOBS];
+static _Atomic int   job_count;
+
+static Histogram        caps[HL_METRIC_CAP_COUNT];
+static _Atomic uint64_t cap_errors[HL_METRIC_CAP_COUNT];
+static const char      *cap_names[HL_METRIC_CAP_COUNT] = { "db", "http", "smtp" };
+
+static _Atomic uint64_t stmt_hits;
+static _Atomic uint64_t stmt_misses;
+
+static struct {
+    const char      *name;          /* runtime name (static string) */
+    _Atomic uint64_t heap_used;
+    _Atomic uint64_t heap_peak;
+    _Atomic uint64_t gc_runs;
+    _Atomic uint64_t gc_ns;
+    _Atomic uint64_t gc_max_ns;
+    _Atomic uint64_t gc_over_budget;
+} rt_gauges;
+
+static void counter_add(_Atomic uint64_t *c, uint64_t n)
+{
+    atomic_fetch_add_explicit(c, n, memory_order_relaxed);
+}
+
+static void gauge_set(_Atomic uint64_t *g, uint64_t v)
+{
+    atomic_store_explicit(g, v, memory_order_relaxed);
+}
+
+static uint64_t load(_Atomic uint64_t *c)
+{
+    return atomic_load_explicit(c, memory_order_relaxed);
+}
+
+/* Bucket i holds (2^(i-1), 2^i] microseconds; the last one is +Inf */
+static void histogram_observe(Histogram *h, uint64_t ns)
+{
+    uint64_t us = ns / 1000;
+    int i = us <= 1 ? 0 : 64 - __builtin_clzll(us - 1);
+    if (i > HL_METRICS_BUCKETS - 1)
+        i = HL_METRICS_BUCKETS - 1;
+    counter_add(&h->buckets[i], 1);
+    counter_add(&h->sum_ns, ns);
+}
+
+int hl_metrics_route(const char *method, const char *pattern)
+{
+    if (!hl_metrics_enabled || !method || !pattern)
+        return -1;
+    int id = atomic_load_explicit(&route_count, memory_order_relaxed);
+    if (id >= HL_METRICS_MAX_ROUTES)
+        return -1;
+
+    RouteSeries *r = &routes[id];
+    snprintf(r->method, sizeof(r->method), "%s", method);
+    snprintf(r->pattern, sizeof(r->pattern), "%s", pattern);
+    /* Publish the labels before the listener can see the slot */
+    atomic_store_explicit(&route_count, id + 1, memory_order_release);
+    return id;
+}
+
+uint64_t hl_metrics_start(void)
+{
+    if (!hl_metrics_enabled)
+        return 0;
+    return (uint64_t)hl_cap_time_clock_ns();
+}
+
+void hl_metrics_route_end(int route_id, int status, uint64_t start)
+{
+    if (start == 0 || route_id < 0 || route_id >= HL_METRICS_MAX_ROUTES)
+        return;
+    RouteSeries *r = &routes[route_id];
+    histogram_observe(&r->latency, (uint64_t)hl_cap_time_clock_ns() - start);
+    if (status >= 100 && status < 600)
+        counter_add(&r->status[status / 100 - 1], 1);
+}
+
+void hl_metrics_cap_end(HlMetricCap cap, uint64_t start, int rc)
+{
+    if (start == 0 || (unsigned)cap >= HL_METRIC_CAP_COUNT)
+        return;
+    histogram_observe(&caps[cap], (uint64_t)hl_cap_time_clock_ns() - start);
+    if (rc < 0)
+        counter_add(&cap_errors[cap], 1);
+}
+
+int hl_metrics_job(const char *name)
+{
+    if (!hl_metrics_enabled || !name)
+        return -1;
+    int id = atomic_load_explicit(&job_count, memory_order_relaxed);
+    if (id >= HL_SCHED_MAX_JOBS)
+        return -1;
+
+    snprintf(jobs[id].name, sizeof(jobs[id].name), "%s", name);
+    atomic_store_explicit(&job_count, id + 1, memory_order_release);
+    return id;
+}
+
+void hl_metrics_job_end(int job_id, uint64_t start, int rc)
+{
+    if (start == 0 || job_id < 0 || job_id >= HL_SCHED_MAX_JOBS)
+        return;
+    JobSeries *j = &jobs[job_id];
+    histogram_observe(&j->duration, (uint64_t)hl_cap_time_clock_ns() - start);
+    if (rc < 0)
+        counter_add(&j->errors, 1);
+}
+
+void hl_metrics_job_skipped(int job_id, uint64_t n)
+{
+    if (!hl_metrics_enabled || job_id < 0 || job_id >= HL_SCHED_MAX_JOBS)
+        return;
+    counter_add(&jobs[job_id].skipped, n);
+}
+
+void hl_metrics_stmt_cache(int hit)
+{
+    if (!hl_metrics_enabled)
+        return;
+    counter_add(hit ? &stmt_hits : &stmt_misses, 1);
+}
+
+void hl_metrics_runtime(const HlRuntime *rt)
+{
+    if (!hl_metrics_enabled || !rt)
+        return;
+    if (!rt_gauges.name && rt->vt)
+        rt_gauges.name = rt->vt->name;
+    if (rt->alloc) {
+        gauge_set(&rt_gauges.heap_used, hl_alloc_used(rt->alloc));
+        gauge_set(&rt_gauges.heap_peak, hl_alloc_peak(rt->alloc));
+    }
+    gauge_set(&rt_gauges.gc_runs, rt->gc_stats.runs);
+    gauge_set(&rt_gauges.gc_ns, rt->gc_stats.total_ns);
+    gauge_set(&rt_gauges.gc_max_ns, rt->gc_stats.max_ns);
+    gauge_set(&rt_gauges.gc_over_budget, rt->gc_stats.over_budget);
+}
+
+/* ── Exposition ────────────────────────────────────────────────────── */
+
+typedef struct {
+    char  *p;
+    size_t len;
+    size_t cap;
+    int    oom;
+} Out;
+
+static void out_printf(Out *o, const char *fmt, ...)
+    __attribute__((format(printf, 2, 3)));
+
+static void out_printf(Out *o, const char *fmt, ...)
+{
+    if (o->oom)
+        return;
+    for (;;) {
+        va_list ap;
+        va_start(ap, fmt);
+        int n = vsnprintf(o->p + o->len, o->cap - o->len, fmt, ap);
+        va_end(ap);
+        if (n < 0) {
+            o->oom = 1;
+            return;
+        }
+        if ((size_t)n < o->cap - o->len) {
+            o->len += (size_t)n;
+            return;
+        }
+        size_t cap = o->cap * 2 + (size_t)n;
+        char *p = realloc(o->p, cap);
+        if (!p) {
+            o->oom = 1;
+            return;
+        }
+        o->p = p;
+        o->cap = cap;
+    }
+}
+
+/* Label value with \, " and newline escaped, into a bounded buffer */
+static const char *label(char *buf, size_t size, const char *s)
+{
+    size_t n = 0;
+    for (; *s && n + 2 < size; s++) {
+        if (*s == '\\' || *s == '"') {
+            buf[n++] = '\\';
+            buf[n++] = *s;
+        } else if (*s == '\n') {
+            buf[n++] = '\\';
+            buf[n++] = 'n';
+        } else {
+            buf[n++] = *s;
+        }
+    }
+    buf[n] = '\0';
+    return buf;
+}
+
+static void write_histogram(Out *o, const char *name, const char *labels,
+                            Histogram *h)
+{
+    uint64_t cumulative = 0;
+    for (int i = 0; i < HL_METRICS_BUCKETS - 1; i++) {
+        cumulative += load(&h->buckets[i]);
+        out_printf(o, "%s_bucket{%s,le=\"%g\"} %llu\n", name, labels,
+                   (double)(1ULL << i) / 1e6, (unsigned long long)cumulative);
+    }
+    cumulative += load(&h->buckets[HL_METRICS_BUCKETS - 1]);
+    out_printf(o, "%s_bucket{%s,le=\"+Inf\"} %llu\n", name, labels,
+               (unsigned long long)cumulative);
+    out_printf(o, "%s_sum{%s} %.6f\n", name, labels,
+               (double)load(&h->sum_ns) / 1e9);
+    /* From the buckets just read, so _count always equals +Inf */
+    out_printf(o, "%s_count{%s} %llu\n", name, labels,
+               (unsigned long long)cumulative);
+}
+
+char *hl_metrics_render(size_t *len)
+{
+    Out o = { malloc(16384), 0, 16384, 0 };
+    if (!o.p)
+        return NULL;
+    char labels[HL_METRICS_LABEL_MAX * 2 + 64];
+    char pat[HL_METRICS_LABEL_MAX * 2];
+    char meth[32];
+
+    int nroutes = atomic_load_explicit(&route_count, memory_order_acquire);
+
+    out_printf(&o, "# HELP hull_http_requests_total Requests handled, by route and status class.\n"
+                   "# TYPE hull_http_requests_total counter\n");
+    for (int i = 0; i < nroutes; i++) {
+        RouteSeries *r = &routes[i];
+        label(meth, sizeof(meth), r->method);
+        label(pat, sizeof(pat), r->pattern);
+        for (int c = 0; c < 5; c++) {
+            uint64_t n = load(&r->status[c]);
+            if (n > 0)
+                out_printf(&o, "hull_http_requests_total{method=\"%s\",route=\"%s\","
+                               "code=\"%dxx\"} %llu\n",
+                           meth, pat, c + 1, (unsigned long long)n);
+        }
+    }
+
+    out_printf(&o, "# HELP hull_http_request_duration_seconds Handler latency by route.\n"
+                   "# TYPE hull_http_request_duration_seconds histogram\n");
+    for (int i = 0; i < nroutes; i++) {
+        RouteSeries *r = &routes[i];
+        snprintf(labels, sizeof(labels), "method=\"%s\",route=\"%s\"",
+                 label(meth, sizeof(meth), r->method),
+                 label(pat, sizeof(pat), r->pattern));
+        write_histogram(&o, "hull_http_request_duration_seconds", labels,
+                        &r->latency);
+    }
+
+    out_printf(&o, "# HELP hull_cap_duration_seconds Capability call latency.\n"
+                   "# TYPE hull_cap_duration_seconds histogram\n");
+    for (int c = 0; c < HL_METRIC_CAP_COUNT; c++) {
+        snprintf(labels, sizeof(labels), "cap=\"%s\"", cap_names[c]);
+        write_histogram(&o, "hull_cap_duration_seconds", labels, &caps[c]);
+    }
+    out_printf(&o, "# HELP hull_cap_errors_total Capability calls that failed.\n"
+                   "# TYPE hull_cap_errors_total counter\n");
+    for (int c = 0; c < HL_METRIC_CAP_COUNT; c++)
+        out_printf(&o, "hull_cap_errors_total{cap=\"%s\"} %llu\n", cap_names[c],
+                   (unsigned long long)load(&cap_errors[c]));
+
+    int njobs = atomic_load_explicit(&job_count, memory_order_acquire);
+    if (njobs > 0) {
+        out_printf(&o, "# HELP hull_job_duration_seconds Background job run time.\n"
+                       "# TYPE hull_job_duration_seconds histogram\n");
+        for (int i = 0; i < njobs; i++) {
+            snprintf(labels, sizeof(labels), "job=\"%s\"",
+                     label(pat, sizeof(pat), jobs[i].name));
+            write_histogram(&o, "hull_job_duration_seconds", labels,
+                            &jobs[i].duration);
+        }
+        out_printf(&o, "# HELP hull_job_errors_total Background job runs that raised.\n"
+                       "# TYPE hull_job_errors_total counter\n");
+        for (int i = 0; i < njobs; i++)
+            out_printf(&o, "hull_job_errors_total{job=\"%s\"} %llu\n",
+                       label(pat, sizeof(pat), jobs[i].name),
+                       (unsigned long long)load(&jobs[i].errors));
+        out_printf(&o, "# HELP hull_job_skipped_total Fires skipped while the previous run was going.\n"
+                       "# TYPE hull_job_skipped_total counter\n");
+        for (int i = 0; i < njobs; i++)
+            out_printf(&o, "hull_job_skipped_total{job=\"%s\"} %llu\n",
+                       label(pat, sizeof(pat), jobs[i].name),
+                       (unsigned long long)load(&jobs[i].skipped));
+    }
+
+    out_printf(&o, "# HELP hull_db_stmt_cache_hits_total Prepared statement cache hits.\n"
+                   "# TYPE hull_db_stmt_cache_hits_total counter\n"
+                   "hull_db_stmt_cache_hits_total %llu\n"
+                   "# HELP hull_db_stmt_cache_misses_total Statements prepared on a miss.\n"
+                   "# TYPE hull_db_stmt_cache_misses_total counter\n"
+                   "hull_db_stmt_cache_misses_total %llu\n",
+               (unsigned long long)load(&stmt_hits),
+               (unsigned long long)load(&stmt_misses));
+
+    const char *rt = rt_gauges.name ? rt_gauges.name : "none";
+    out_printf(&o, "# HELP hull_heap_used_bytes Runtime heap in use after the last request.\n"
+                   "# TYPE hull_heap_used_bytes gauge\n"
+                   "hull_heap_used_bytes{runtime=\"%s\"} %llu\n"
+                   "# HELP hull_heap_peak_bytes Runtime heap high-water mark.\n"
+                   "# TYPE hull_heap_peak_bytes gauge\n"
+                   "hull_heap_peak_bytes{runtime=\"%s\"} %llu\n",
+               rt, (unsigned long long)load(&rt_gauges.heap_used),
+               rt, (unsigned long long)load(&rt_gauges.heap_peak));
+    out_printf(&o, "# HELP hull_gc_runs_total Request-boundary collections that did work.\n"
+                   "# TYPE hull_gc_runs_total counter\n"
+                   "hull_gc_runs_total{runtime=\"%s\"} %llu\n"
+                   "# HELP hull_gc_seconds_total Time spent in request-boundary collections.\n"
+                   "# TYPE hull_gc_seconds_total counter\n"
+                   "hull_gc_seconds_total{runtime=\"%s\"} %.6f\n"
+                   "# HELP hull_gc_max_pause_seconds Longest request-boundary pause.\n"
+                   "# TYPE hull_gc_max_pause_seconds gauge\n"
+                   "hull_gc_max_pause_seconds{runtime=\"%s\"} %.6f\n"
+                   "# HELP hull_gc_over_budget_total Pauses longer than --gc-budget.\n"
+                   "# TYPE hull_gc_over_budget_total counter\n"
+                   "hull_gc_over_budget_total{runtime=\"%s\"} %llu\n",
+               rt, (unsigned long long)load(&rt_gauges.gc_runs),
+               rt, (double)load(&rt_gauges.gc_ns) / 1e9,
+               rt, (double)load(&rt_gauges.gc_max_ns) / 1e9,
+               rt, (unsigned long long)load(&rt_gauges.gc_over_budget));
+
+    out_printf(&o, "# HELP hull_audit_dropped_total Audit events dropped on a full ring.\n"
+                   "# TYPE hull_audit_dropped_total counter\n"
+                   "hull_audit_dropped_total %llu\n"
+                   "# HELP hull_log_dropped_total Log lines dropped under --log-policy drop.\n"
+                   "# TYPE hull_log_dropped_total counter\n"
+                   "hull_log_dropped_total %llu\n",
+               (unsigned long long)hl_audit_dropped(),
+               (unsigned long long)hl_log_sink_dropped());
+
+    if (o.oom) {
+        free(o.p);
+        return NULL;
+    }
+    if (len)
+        *len = o.len;
+    return o.p;
+}
+
+/* ── Listener ──────────────────────────────────────────────────────── */
+
+static struct {
+    pthread_t   thread;
+    int         fd;
+    int         running;
+    atomic_int  stopping;
+} srv = { .fd = -1 };
+
+static void send_all(int fd, const char *data, size_t len)
+{
+    while (len > 0) {
+        ssize_t w = write(fd, data, len);
+        if (w < 0) {
+            if (errno == EINTR)
+                continue;
+            return;
+        }
+        data += w;
+        len -= (size_t)w;
+    }
+}
+
+static void serve_one(int fd)
+{
+    /* A scraper that stalls must not hold the listener forever */
+    struct timeval tv = { 1, 0 };
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+
+    char req[1024];
+    size_t n = 0;
+    while (n < sizeof(req) - 1) {
+        ssize_t r = read(fd, req + n, sizeof(req) - 1 - n);
+        if (r <= 0)
+            break;
+        n += (size_t)r;
+        req[n] = '\0';
+        if (strstr(req, "\r\n\r\n") || strstr(req, "\n\n"))
+            break;
+    }
+    req[n] = '\0';
+
+    char head[160];
+    if (strncmp(req, "GET /metrics ", 13) != 0 &&
+        strncmp(req, "GET /metrics?", 13) != 0) {
+        static const char nf[] = "HTTP/1.1 404 Not Found\r\n"
+                                 "Content-Length: 0\r\nConnection: close\r\n\r\n";
+        send_all(fd, nf, sizeof(nf) - 1);
+        return;
+    }
+
+    size_t body_len = 0;
+    char *body = hl_metrics_render(&body_len);
+    if (!body) {
+        static const char err[] = "HTTP/1.1 500 Internal Server Error\r\n"
+                                  "Content-Length: 0\r\nConnection: close\r\n\r\n";
+        send_all(fd, err, sizeof(err) - 1);
+        return;
+    }
+    int hn = snprintf(head, sizeof(head),
+                      "HTTP/1.1 200 OK\r\n"
+                      "Content-Type: text/plain; version=0.0.4\r\n"
+                      "Content-Length: %zu\r\nConnection: close\r\n\r\n",
+                      body_len);
+    send_all(fd, head, (size_t)hn);
+    send_all(fd, body, body_len);
+    free(body);
+}
+
+static void *metrics_main(void *arg)
+{
+    (void)arg;
+    struct pollfd pfd = { .fd = srv.fd, .events = POLLIN };
+    while (!atomic_load(&srv.stopping)) {
+        int rc = poll(&pfd, 1, HL_METRICS_POLL_MS);
+        if (rc <= 0)
+            continue;
+        int fd = accept(srv.fd, NULL, NULL);
+        if (fd < 0)
+            continue;
+        serve_one(fd);
+        close(fd);
+    }
+    return NULL;
+}
+
+int hl_metrics_serve(const char *addr, int port)
+{
+    if (srv.running)
+        return -1;
+
+    char port_str[8];
+    snprintf(port_str, sizeof(port_str), "%d", port);
+    struct addrinfo hints = { 0 }, *ai = NULL;
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_flags = AI_PASSIVE | AI_NUMERICHOST | AI_NUMERICSERV;
+    if (getaddrinfo(addr, port_str, &hints, &ai) != 0)
+        return -1;
+
+    int fd = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+    if (fd < 0) {
+        freeaddrinfo(ai);
+        return -1;
+    }
+    int one = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    if (bind(fd, ai->ai_addr, ai->ai_addrlen) != 0 || listen(fd, 16) != 0) {
+        close(fd);
+        freeaddrinfo(ai);
+        return -1;
+    }
+    freeaddrinfo(ai);
+
+    if (hl_metrics_serve_fd(fd) != 0) {
+        close(fd);
+        return -1;
+    }
+    return 0;
+}
+
+int hl_metrics_serve_fd(int fd)
+{
+    if (srv.running)
+        return -1;
+
+    srv.fd = fd;
+    atomic_store(&srv.stopping, 0);
+    if (pthread_create(&srv.thread, NULL, metrics_main, NULL) != 0) {
+        srv.fd = -1;
+        return -1;
+    }
+    srv.running = 1;
+    return 0;
+}
+
+int hl_metrics_fd(void)
+{
+    return srv.running ? srv.fd : -1;
+}
+
+void hl_metrics_stop(void)
+{
+    if (!srv.running)
+        return;
+    atomic_store(&srv.stopping, 1);
+    pthread_join(srv.thread, NULL);
+    close(srv.fd);
+    srv.fd = -1;
+    srv.running = 0;
+}
@@ -0,0 +1,608 @@
+/*
+ * cap/outbox.c — Native outbox dispatcher
+ *
+ * The dispatcher thread owns the SQLite connection and the statements;
+ * workers only see the batch it publishes under the mutex. Each round:
+ * claim (one transaction), deliver (workers, concurrently), record (one
+ * transaction).
+ *
+ * Each worker has its own TLS client context and keep-alive pool: the
+ * vendored mbedTLS is built without MBEDTLS_THREADING_C, so a context
+ * (and the CTR_DRBG inside it) must never be used by two threads.
+ *
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#include "hull/cap/outbox.h"
+#include "hull/cap/db.h"
+#include "hull/cap/http.h"
+#include "hull/cap/time.h"
+
+#include <keel/tls.h>
+#include <keel/tls_mbedtls.h>
+
+#include "log.h"
+#include "sh_arena.h"
+#include "sh_json.h"
+
+#include <pthread.h>
+#include <sqlite3.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/* ── Batch items ───────────────────────────────────────────────────── */
+
+enum { ITEM_UNSENT, ITEM_OK, ITEM_FAILED };
+
+typedef struct {
+    int64_t  id;
+    char    *destination;
+    char    *payload;
+    size_t   payload_len;
+    char    *headers;           /* JSON object, NULL = none */
+    int      attempts;
+    int      max_attempts;
+    int      outcome;           /* ITEM_*, written by the worker that took it */
+    char     error[HL_OUTBOX_ERROR_MAX];
+} OutboxItem;
+
+static void items_free(OutboxItem *items, int count)
+{
+    for (int i = 0; i < count; i++) {
+        free(items[i].destination);
+        free(items[i].payload);
+        free(items[i].headers);
+    }
+    free(items);
+}
+
+static char *column_dup(sqlite3_stmt *st, int col, size_t *len)
+{
+    const unsigned char *text = sqlite3_column_text(st, col);
+    if (!text)
+        return NULL;
+    size_t n = (size_t)sqlite3_column_bytes(st, col);
+    char *s = malloc(n + 1);
+    if (s) {
+        memcpy(s, text, n);
+        s[n] = '\0';
+    }
+    if (len)
+        *len = n;
+    return s;
+}
+
+/* ── Dispatcher state ──────────────────────────────────────────────── */
+
+/* SQL the dispatcher runs; prepared once _hull_outbox exists */
+enum { ST_CLAIM, ST_LEASE, ST_DELIVERED, ST_RETRY, ST_FAILED, ST_RELEASE, ST_COUNT };
+
+static const char *const outbox_sql[ST_COUNT] = {
+    [ST_CLAIM] =
+        "SELECT id, destination, payload, headers, attempts, max_attempts "
+        "FROM _hull_outbox WHERE state = 'pending' AND next_attempt_at <= ?1 "
+        "AND kind IN ('webhook', 'http') ORDER BY id LIMIT ?2",
+    [ST_LEASE] =
+        "UPDATE _hull_outbox SET next_attempt_at = ?1 WHERE id = ?2",
+    [ST_DELIVERED] =
+        "UPDATE _hull_outbox SET state = 'delivered', delivered_at = ?1, "
+        "attempts = attempts + 1 WHERE id = ?2",
+    [ST_RETRY] =
+        "UPDATE _hull_outbox SET attempts = ?1, next_attempt_at = ?2, "
+        "last_error = ?3 WHERE id = ?4",
+    [ST_FAILED] =
+        "UPDATE _hull_outbox SET state = 'failed', attempts = ?1, "
+        "last_error = ?2 WHERE id = ?3",
+    [ST_RELEASE] =
+        "UPDATE _hull_outbox SET next_attempt_at = ?1 WHERE id = ?2",
+};
+
+typedef struct {
+    HlOutbox       *ob;
+    HlHttpConfig    http;           /* the app's, with this worker's TLS and pool */
+    KlTlsConfig     tls;
+    KlTlsCtx       *tls_ctx;
+    HlHttpPool     *pool;
+    pthread_t       thread;
+} OutboxWorker;
+
+struct HlOutbox {
+    sqlite3        *db;
+    sqlite3_stmt   *st[ST_COUNT];   /* NULL until the table exists */
+    int             workers;
+    int             batch;
+    int             poll_ms;
+
+    pthread_t       thread;
+    OutboxWorker    worker[HL_OUTBOX_MAX_WORKERS];
+    int             started;        /* threads running */
+    pthread_mutex_t mu;
+    pthread_cond_t  wake_cond;      /* dispatcher: wake-up or stop */
+    pthread_cond_t  work_cond;      /* workers: batch published or stop */
+    pthread_cond_t  done_cond;      /* dispatcher: a delivery finished */
+    int             woken;
+    int             stopping;
+    int             joined;         /* hl_outbox_stop() has run */
+
+    /* Current batch, under mu */
+    OutboxItem     *items;
+    int             count;
+    int             next;           /* first item no worker has taken */
+    int             inflight;
+
+    HlOutboxStats   stats;          /* under mu */
+};
+
+int64_t hl_outbox_backoff(int attempts)
+{
+    if (attempts < 0)
+        attempts = 0;
+    if (attempts >= 9)              /* 2^9 * 10 > 3600 */
+        return 3600;
+    int64_t delay = ((int64_t)1 << attempts) * 10;
+    return delay > 3600 ? 3600 : delay;
+}
+
+/* ── Database ──────────────────────────────────────────────────────── */
+
+/* Prepare the statements once outbox.init() has created the table */
+static int outbox_prepare(HlOutbox *ob)
+{
+    if (ob->st[0])
+        return 0;
+    for (int i = 0; i < ST_COUNT; i++) {
+        if (sqlite3_prepare_v2(ob->db, outbox_sql[i], -1, &ob->st[i],
+                               NULL) != SQLITE_OK) {
+            for (int j = 0; j <= i; j++) {
+                sqlite3_finalize(ob->st[j]);
+                ob->st[j] = NULL;
+            }
+            return -1;
+        }
+    }
+    return 0;
+}
+
+static int step_done(sqlite3_stmt *st)
+{
+    int rc = sqlite3_step(st);
+    sqlite3_reset(st);
+    sqlite3_clear_bindings(st);
+    return rc == SQLITE_DONE ? 0 : -1;
+}
+
+/*
+ * Take up to ob->batch due rows and lease them. Returns the count (0 when
+ * none are due, the table does not exist yet, or the database is busy).
+ */
+static int outbox_claim(HlOutbox *ob, OutboxItem **out)
+{
+    *out = NULL;
+    if (outbox_prepare(ob) != 0)
+        return 0;
+    if (sqlite3_exec(ob->db, "BEGIN IMMEDIATE", NULL, NULL, NULL) != SQLITE_OK)
+        return 0;
+
+    int64_t now = hl_cap_time_now();
+    OutboxItem *items = calloc((size_t)ob->batch, sizeof(*items));
+    int n = 0;
+    if (!items)
+        goto fail;
+
+    sqlite3_stmt *st = ob->st[ST_CLAIM];
+    sqlite3_bind_int64(st, 1, now);
+    sqlite3_bind_int(st, 2, ob->batch);
+    int rc = SQLITE_DONE, oom = 0;
+    while (n < ob->batch && (rc = sqlite3_step(st)) == SQLITE_ROW) {
+        OutboxItem *it = &items[n++];
+        it->id = sqlite3_column_int64(st, 0);
+        it->destination = column_dup(st, 1, NULL);
+        it->payload = column_dup(st, 2, &it->payload_len);
+        it->headers = column_dup(st, 3, NULL);
+        it->attempts = sqlite3_column_int(st, 4);
+        it->max_attempts = sqlite3_column_int(st, 5);
+        if (!it->destination || !it->payload)
+            oom = 1;
+    }
+    sqlite3_reset(st);
+    sqlite3_clear_bindings(st);
+    if (oom || (rc != SQLITE_DONE && rc != SQLITE_ROW))
+        goto fail;
+
+    for (int i = 0; i < n; i++) {
+        sqlite3_bind_int64(ob->st[ST_LEASE], 1, now + HL_OUTBOX_LEASE_S);
+        sqlite3_bind_int64(ob->st[ST_LEASE], 2, items[i].id);
+        if (step_done(ob->st[ST_LEASE]) != 0)
+            goto fail;
+    }
+    if (sqlite3_exec(ob->db, "COMMIT", NULL, NULL, NULL) != SQLITE_OK)
+        goto fail;
+
+    *out = items;
+    return n;
+
+fail:
+    log_warn("[hull:c] outbox: claim failed: %s", sqlite3_errmsg(ob->db));
+    sqlite3_exec(ob->db, "ROLLBACK", NULL, NULL, NULL);
+    items_free(items, n);
+    return 0;
+}
+
+static int record_item(HlOutbox *ob, const OutboxItem *it, int64_t now)
+{
+    sqlite3_stmt *st;
+    int attempts = it->attempts + 1;
+
+    switch (it->outcome) {
+    case ITEM_OK:
+        st = ob->st[ST_DELIVERED];
+        sqlite3_bind_int64(st, 1, now);
+        sqlite3_bind_int64(st, 2, it->id);
+        break;
+    case ITEM_FAILED:
+        if (attempts >= it->max_attempts) {
+            st = ob->st[ST_FAILED];
+            sqlite3_bind_int(st, 1, attempts);
+            sqlite3_bind_text(st, 2, it->error, -1, SQLITE_STATIC);
+            sqlite3_bind_int64(st, 3, it->id);
+        } else {
+            st = ob->st[ST_RETRY];
+            sqlite3_bind_int(st, 1, attempts);
+            sqlite3_bind_int64(st, 2, now + hl_outbox_backoff(attempts));
+            sqlite3_bind_text(st, 3, it->error, -1, SQLITE_STATIC);
+            sqlite3_bind_int64(st, 4, it->id);
+        }
+        break;
+    default:
+        /* Not attempted (shutting down): due again at once */
+        st = ob->st[ST_RELEASE];
+        sqlite3_bind_int64(st, 1, now);
+        sqlite3_bind_int64(st, 2, it->id);
+        break;
+    }
+    return step_done(st);
+}
+
+/* Write a batch's outcomes in one transaction, retrying a busy database */
+static void outbox_record(HlOutbox *ob, const OutboxItem *items, int count)
+{
+    HlOutboxStats add = {0};
+
+    for (int attempt = 0; attempt < 3; attempt++) {
+        int64_t now = hl_cap_time_now();
+        if (sqlite3_exec(ob->db, "BEGIN IMMEDIATE", NULL, NULL, NULL) != SQLITE_OK)
+            continue;
+        int i = 0;
+        while (i < count && record_item(ob, &items[i], now) == 0)
+            i++;
+        if (i == count &&
+            sqlite3_exec(ob->db, "COMMIT", NULL, NULL, NULL) == SQLITE_OK)
+            goto recorded;
+        sqlite3_exec(ob->db, "ROLLBACK", NULL, NULL, NULL);
+    }
+    log_error("[hull:c] outbox: cannot record %d outcome(s): %s; "
+              "they are retried when the lease expires",
+              count, sqlite3_errmsg(ob->db));
+    return;
+
+recorded:
+    for (int i = 0; i < count; i++) {
+        if (items[i].outcome == ITEM_OK)
+            add.delivered++;
+        else if (items[i].outcome != ITEM_FAILED)
+            continue;
+        else if (items[i].attempts + 1 >= items[i].max_attempts)
+            add.failed++;
+        else
+            add.retried++;
+    }
+    pthread_mutex_lock(&ob->mu);
+    ob->stats.delivered += add.delivered;
+    ob->stats.retried += add.retried;
+    ob->stats.failed += add.failed;
+    pthread_mutex_unlock(&ob->mu);
+}
+
+/* ── Delivery ──────────────────────────────────────────────────────── */
+
+/* POST one item; the outcome and error land in the item */
+static void outbox_deliver(OutboxWorker *w, OutboxItem *it)
+{
+    HlHttpHeader hdrs[HL_HTTP_MAX_REQ_HEADERS];
+    int nhdrs = 0;
+    SHArena *arena = NULL;
+
+    /* headers: JSON object of strings, as outbox.enqueue() stores it */
+    if (it->headers && it->headers[0]) {
+        size_t len = strlen(it->headers);
+        ShJsonValue *root = NULL;
+        arena = sh_arena_create(len * 4 + 1024);
+        if (!arena || sh_json_parse(it->headers, len, arena, &root) != SH_JSON_OK ||
+            sh_json_type(root) != SH_JSON_OBJECT) {
+            it->outcome = ITEM_FAILED;
+            snprintf(it->error, sizeof(it->error), "invalid headers JSON");
+            sh_arena_free(arena);
+            return;
+        }
+        for (size_t i = 0; i < root->u.object_val.count &&
+                           nhdrs < HL_HTTP_MAX_REQ_HEADERS; i++) {
+            const ShJsonMember *m = &root->u.object_val.members[i];
+            if (sh_json_type(m->value) != SH_JSON_STRING)
+                continue;
+            hdrs[nhdrs].name = m->key;
+            hdrs[nhdrs].value = sh_json_as_string(m->value, "");
+            nhdrs++;
+        }
+    }
+
+    HlHttpResponse resp;
+    int rc = hl_cap_http_request(&w->http, "POST", it->destination,
+                                 hdrs, nhdrs, it->payload, it->payload_len,
+                                 &resp);
+    if (rc != 0) {
+        it->outcome = ITEM_FAILED;
+        snprintf(it->error, sizeof(it->error), "http request failed");
+    } else if (resp.status >= 200 && resp.status < 300) {
+        it->outcome = ITEM_OK;
+    } else {
+        it->outcome = ITEM_FAILED;
+        snprintf(it->error, sizeof(it->error), "HTTP %d", resp.status);
+    }
+    if (rc == 0)
+        hl_cap_http_free(&resp);
+    sh_arena_free(arena);
+}
+
+static void *outbox_worker(void *arg)
+{
+    OutboxWorker *w = (OutboxWorker *)arg;
+    HlOutbox *ob = w->ob;
+
+    pthread_mutex_lock(&ob->mu);
+    for (;;) {
+        while (!ob->stopping && ob->next >= ob->count)
+            pthread_cond_wait(&ob->work_cond, &ob->mu);
+        if (ob->stopping)
+            break;
+
+        OutboxItem *it = &ob->items[ob->next++];
+        ob->inflight++;
+        pthread_mutex_unlock(&ob->mu);
+
+        outbox_deliver(w, it);
+
+        pthread_mutex_lock(&ob->mu);
+        ob->inflight--;
+        pthread_cond_signal(&ob->done_cond);
+    }
+    pthread_mutex_unlock(&ob->mu);
+    return NULL;
+}
+
+/* ── Dispatcher thread ─────────────────────────────────────────────── */
+
+/* Hand a batch to the workers and wait for it; on stop, items no worker
+ * has taken yet stay ITEM_UNSENT */
+static void outbox_run_batch(HlOutbox *ob, OutboxItem *items, int count)
+{
+    pthread_mutex_lock(&ob->mu);
+    ob->items = items;
+    ob->count = count;
+    ob->next = 0;
+    pthread_cond_broadcast(&ob->work_cond);
+    while (ob->inflight > 0 || (ob->next < ob->count && !ob->stopping))
+        pthread_cond_wait(&ob->done_cond, &ob->mu);
+    ob->items = NULL;
+    ob->count = ob->next = 0;
+    pthread_mutex_unlock(&ob->mu);
+}
+
+static void *outbox_main(void *arg)
+{
+    HlOutbox *ob = (HlOutbox *)arg;
+
+    for (;;) {
+        OutboxItem *items;
+        int n = outbox_claim(ob, &items);
+        if (n > 0) {
+            outbox_run_batch(ob, items, n);
+            outbox_record(ob, items, n);
+            items_free(items, n);
+        }
+
+        pthread_mutex_lock(&ob->mu);
+        /* A full batch means more may be due: go again at once */
+        if (n < ob->batch && !ob->stopping && !ob->woken) {
+            struct timespec until;
+            clock_gettime(CLOCK_REALTIME, &until);
+            until.tv_sec += ob->poll_ms / 1000;
+            until.tv_nsec += (long)(ob->poll_ms % 1000) * 1000000L;
+            if (until.tv_nsec >= 1000000000L) {
+                until.tv_sec++;
+                until.tv_nsec -= 1000000000L;
+            }
+            pthread_cond_timedwait(&ob->wake_cond, &ob->mu, &until);
+        }
+        ob->woken = 0;
+        int stop = ob->stopping;
+        pthread_mutex_unlock(&ob->mu);
+        if (stop)
+            break;
+    }
+    return NULL;
+}
+
+/* ── Public API ────────────────────────────────────────────────────── */
+
+/* Copy the app's HTTP config, swapping in a pool and (for HTTPS) a TLS
+ * context of the worker's own */
+static int outbox_worker_init(OutboxWorker *w, HlOutbox *ob,
+                              const HlOutboxConfig *cfg)
+{
+    w->ob = ob;
+    w->http = *cfg->http;
+    w->http.tls = NULL;
+    w->pool = hl_http_pool_create(HL_HTTP_DEFAULT_IDLE_MS);
+    if (!w->pool)
+        return -1;
+    w->http.pool = w->pool;
+
+    if (cfg->http->tls) {
+        w->tls_ctx = kl_tls_mbedtls_client_ctx_create(cfg->ca_bundle);
+        if (!w->tls_ctx) {
+            log_error("[hull:c] outbox: cannot create TLS client context");
+            return -1;
+        }
+        w->tls.ctx         = w->tls_ctx;
+        w->tls.factory     = (KlTlsFactory)kl_tls_mbedtls_create;
+        w->tls.ctx_destroy = (void (*)(KlTlsCtx *))kl_tls_mbedtls_ctx_destroy;
+        w->http.tls        = &w->tls;
+    }
+    return 0;
+}
+
+HlOutbox *hl_outbox_create(const HlOutboxConfig *cfg)
+{
+    if (!cfg || !cfg->db_path || !cfg->http)
+        return NULL;
+    if (cfg->workers < 1 || cfg->workers > HL_OUTBOX_MAX_WORKERS) {
+        log_error("[hull:c] outbox: workers must be 1..%d",
+                  HL_OUTBOX_MAX_WORKERS);
+        return NULL;
+    }
+    if (cfg->db_path[0] == '\0' || strcmp(cfg->db_path, ":memory:") == 0) {
+        log_error("[hull:c] outbox: the dispatcher needs a database file");
+        return NULL;
+    }
+
+    HlOutbox *ob = calloc(1, sizeof(*ob));
+    if (!ob)
+        return NULL;
+    ob->workers = cfg->workers;
+    ob->batch = cfg->batch > 0 ? cfg->batch : HL_OUTBOX_BATCH;
+    ob->poll_ms = cfg->poll_ms > 0 ? cfg->poll_ms : HL_OUTBOX_POLL_MS;
+
+    if (sqlite3_open_v2(cfg->db_path, &ob->db,
+                        SQLITE_OPEN_READWRITE | SQLITE_OPEN_NOMUTEX,
+                        NULL) != SQLITE_OK ||
+        hl_cap_db_init(ob->db) != 0) {
+        log_error("[hull:c] outbox: cannot open %s: %s", cfg->db_path,
+                  ob->db ? sqlite3_errmsg(ob->db) : "out of memory");
+        sqlite3_close(ob->db);
+        free(ob);
+        return NULL;
+    }
+
+    for (int i = 0; i < ob->workers; i++) {
+        if (outbox_worker_init(&ob->worker[i], ob, cfg) != 0) {
+            hl_outbox_destroy(ob);
+            return NULL;
+        }
+    }
+    return ob;
+}
+
+int hl_outbox_start(HlOutbox *ob)
+{
+    if (!ob || ob->started)
+        return -1;
+
+    pthread_mutex_init(&ob->mu, NULL);
+    pthread_cond_init(&ob->wake_cond, NULL);
+    pthread_cond_init(&ob->work_cond, NULL);
+    pthread_cond_init(&ob->done_cond, NULL);
+
+    int n = 0;
+    while (n < ob->workers &&
+           pthread_create(&ob->worker[n].thread, NULL, outbox_worker,
+                          &ob->worker[n]) == 0)
+        n++;
+    if (n < ob->workers ||
+        pthread_create(&ob->thread, NULL, outbox_main, ob) != 0) {
+        pthread_mutex_lock(&ob->mu);
+        ob->stopping = 1;
+        pthread_cond_broadcast(&ob->work_cond);
+        pthread_mutex_unlock(&ob->mu);
+        for (int i = 0; i < n; i++)
+            pthread_join(ob->worker[i].thread, NULL);
+        ob->stopping = 0;
+        pthread_cond_destroy(&ob->done_cond);
+        pthread_cond_destroy(&ob->work_cond);
+        pthread_cond_destroy(&ob->wake_cond);
+        pthread_mutex_destroy(&ob->mu);
+        return -1;
+    }
+    ob->started = 1;
+    return 0;
+}
+
+void hl_outbox_wake(HlOutbox *ob)
+{
+    if (!ob || !ob->started)
+        return;
+    pthread_mutex_lock(&ob->mu);
+    ob->woken = 1;
+    pthread_cond_signal(&ob->wake_cond);
+    pthread_mutex_unlock(&ob->mu);
+}
+
+HlOutboxStats hl_outbox_stats(HlOutbox *ob)
+{
+    HlOutboxStats s = {0};
+    if (!ob || !ob->started)
+        return s;
+    pthread_mutex_lock(&ob->mu);
+    s = ob->stats;
+    pthread_mutex_unlock(&ob->mu);
+    return s;
+}
+
+void hl_outbox_stop(HlOutbox *ob)
+{
+    if (!ob || !ob->started || ob->joined)
+        return;
+
+    pthread_mutex_lock(&ob->mu);
+    ob->stopping = 1;
+    pthread_cond_broadcast(&ob->wake_cond);
+    pthread_cond_broadcast(&ob->work_cond);
+    pthread_cond_broadcast(&ob->done_cond);
+    pthread_mutex_unlock(&ob->mu);
+
+    pthread_join(ob->thread, NULL);
+    for (int i = 0; i < ob->workers; i++)
+        pthread_join(ob->worker[i].thread, NULL);
+    ob->joined = 1;
+
+    log_info("[hull:c] outbox: %llu delivered, %llu retried, %llu failed",
+             (unsigned long long)ob->stats.delivered,
+             (unsigned long long)ob->stats.retried,
+             (unsigned long long)ob->stats.failed);
+}
+
+void hl_outbox_destroy(HlOutbox *ob)
+{
+    if (!ob)
+        return;
+
+    if (ob->started) {
+        hl_outbox_stop(ob);
+        pthread_cond_destroy(&ob->done_cond);
+        pthread_cond_destroy(&ob->work_cond);
+        pthread_cond_destroy(&ob->wake_cond);
+        pthread_mutex_destroy(&ob->mu);
+    }
+
+    for (int i = 0; i < ST_COUNT; i++)
+        sqlite3_finalize(ob->st[i]);
+    sqlite3_close(ob->db);
+    for (int i = 0; i < ob->workers; i++) {
+        OutboxWorker *w = &ob->worker[i];
+        hl_http_pool_destroy(w->pool); /* closes its TLS sessions first */
+        if (w->tls_ctx)
+            kl_tls_mbedtls_ctx_destroy(w->tls_ctx);
+    }
+    free(ob);
+}
@@ -0,0 +1,930 @@
+/*
+ * cap/sched.c — Background jobs: timer wheel, cron, scheduler thread
+ *
+ * The wheel, job table and timing state belong to the scheduler thread.
+ * Run counters are written by the event loop thread in the middleware
+ * and read only after the thread and the loop have both stopped.
+ *
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#include "hull/cap/sched.h"
+#include "hull/cap/crypto.h"
+#include "hull/cap/metrics.h"
+#include "hull/cap/time.h"
+#include "hull/access_log.h"
+#include "hull/runtime.h"
+
+#include <keel/allocator.h>
+#include <keel/tls.h>
+
+#include "log.h"
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+/* ── Timer wheel ───────────────────────────────────────────────────── */
+
+#define WHEEL_MASK ((uint64_t)HL_WHEEL_SLOTS - 1)
+#define WHEEL_SPAN (1ULL << (HL_WHEEL_BITS * HL_WHEEL_LEVELS))
+
+void hl_wheel_init(HlWheel *w, uint64_t now)
+{
+    memset(w, 0, sizeof(*w));
+    w->now = now;
+}
+
+/* Slot for t relative to w->now; a deadline of now lands in the slot
+ * being processed (cascades only), later ones in the first level whose
+ * slot width covers the distance */
+static void wheel_insert(HlWheel *w, HlTimer *t)
+{
+    uint64_t delta = t->expires - w->now;
+    if (delta >= WHEEL_SPAN) {
+        t->expires = w->now + WHEEL_SPAN - 1;
+        delta = WHEEL_SPAN - 1;
+    }
+
+    int level = 0;
+    while (level < HL_WHEEL_LEVELS - 1 &&
+           delta >= 1ULL << (HL_WHEEL_BITS * (level + 1)))
+        level++;
+
+    HlTimer **head = &w->slots[level]
+        [(t->expires >> (HL_WHEEL_BITS * level)) & WHEEL_MASK];
+    t->next = *head;
+    if (*head)
+        (*head)->pprev = &t->next;
+    t->pprev = head;
+    *head = t;
+}
+
+void hl_wheel_add(HlWheel *w, HlTimer *t, uint64_t expires)
+{
+    hl_wheel_del(t);
+    t->expires = expires > w->now ? expires : w->now + 1;
+    wheel_insert(w, t);
+}
+
+void hl_wheel_del(HlTimer *t)
+{
+    if (!t->pprev)
+        return;
+    *t->pprev = t->next;
+    if (t->next)
+        t->next->pprev = t->pprev;
+    t->next = NULL;
+    t->pprev = NULL;
+}
+
+/* Detach a whole slot */
+static HlTimer *wheel_take(HlTimer **head)
+{
+    HlTimer *list = *head;
+    *head = NULL;
+    for (HlTimer *t = list; t; t = t->next)
+        t->pprev = NULL;
+    return list;
+}
+
+HlTimer *hl_wheel_advance(HlWheel *w, uint64_t now)
+{
+    /* Nothing to expire or cascade before `now`: skip the empty ticks */
+    if (hl_wheel_next(w) > now) {
+        if (now > w->now)
+            w->now = now;
+        return NULL;
+    }
+
+    HlTimer *expired = NULL;
+    while (w->now < now) {
+        w->now++;
+
+        /* Entering a new slot of level l pulls its timers down */
+        for (int l = 1; l < HL_WHEEL_LEVELS; l++) {
+            if (w->now & ((1ULL << (HL_WHEEL_BITS * l)) - 1))
+                break;
+            HlTimer *t = wheel_take(&w->slots[l]
+                [(w->now >> (HL_WHEEL_BITS * l)) & WHEEL_MASK]);
+            while (t) {
+                HlTimer *next = t->next;
+                wheel_insert(w, t);
+                t = next;
+            }
+        }
+
+        HlTimer *t = wheel_take(&w->slots[0][w->now & WHEEL_MASK]);
+        while (t) {
+            HlTimer *next = t->next;
+            t->next = expired;
+            expired = t;
+            t = next;
+        }
+    }
+    return expired;
+}
+
+uint64_t hl_wheel_next(const HlWheel *w)
+{
+    uint64_t best = UINT64_MAX;
+
+    for (uint64_t i = 1; i <= HL_WHEEL_SLOTS; i++) {
+        if (w->slots[0][(w->now + i) & WHEEL_MASK]) {
+            best = w->now + i;
+            break;
+        }
+    }
+
+    /* Higher levels: the tick their next non-empty slot cascades at */
+    for (int l = 1; l < HL_WHEEL_LEVELS; l++) {
+        int shift = HL_WHEEL_BITS * l;
+        uint64_t block = w->now >> shift;
+        for (uint64_t i = 1; i <= HL_WHEEL_SLOTS; i++) {
+            if (w->slots[l][(block + i) & WHEEL_MASK]) {
+                uint64_t at = (block + i) << shift;
+                if (at < best)
+                    best = at;
+                break;
+            }
+        }
+    }
+    return best;
+}
+
+/* ── Cron ──────────────────────────────────────────────────────────── */
+
+/* Days since 1970-01-01 for a proleptic Gregorian date, and back */
+static int64_t days_from_civil(int64_t y, int m, int d)
+{
+    y -= m <= 2;
+    int64_t era = (y >= 0 ? y : y - 399) / 400;
+    int64_t yoe = y - era * 400;
+    int64_t doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+    int64_t doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + doe - 719468;
+}
+
+static void civil_from_days(int64_t z, int64_t *y, int *m, int *d)
+{
+    z += 719468;
+    int64_t era = (z >= 0 ? z : z - 146096) / 146097;
+    int64_t doe = z - era * 146097;
+    int64_t yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    int64_t doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    int64_t mp = (5 * doy + 2) / 153;
+    *d = (int)(doy - (153 * mp + 2) / 5 + 1);
+    *m = (int)(mp < 10 ? mp + 3 : mp - 9);
+    *y = yoe + era * 400 + (*m <= 2);
+}
+
+static int cron_number(const char **p, int *out)
+{
+    const char *s = *p;
+    if (*s < '0' || *s > '9')
+        return -1;
+    int v = 0;
+    while (*s >= '0' && *s <= '9') {
+        v = v * 10 + (*s - '0');
+        if (v > 1000)
+            return -1;
+        s++;
+    }
+    *p = s;
+    *out = v;
+    return 0;
+}
+
+/* One field up to the next space: comma list of *, N, N-M with /STEP */
+static int cron_field(const char **p, int lo, int hi, uint64_t *bits,
+                      uint8_t *any)
+{
+    const char *s = *p;
+    *bits = 0;
+    *any = *s == '*';
+
+    for (;;) {
+        int a, b, step = 1, single = 0;
+        if (*s == '*') {
+            a = lo;
+            b = hi;
+            s++;
+        } else {
+            if (cron_number(&s, &a) != 0)
+                return -1;
+            b = a;
+            single = 1;
+            if (*s == '-') {
+                s++;
+                single = 0;
+                if (cron_number(&s, &b) != 0)
+                    return -1;
+            }
+        }
+        if (*s == '/') {
+            s++;
+            if (cron_number(&s, &step) != 0 || step == 0)
+                return -1;
+            /* "N/STEP" runs from N to the end of the range */
+            if (single)
+                b = hi;
+        }
+        if (a < lo || b > hi || a > b)
+            return -1;
+        for (int v = a; v <= b; v += step)
+            *bits |= 1ULL << v;
+
+        if (*s != ',')
+            break;
+        s++;
+    }
+
+    if (*s != ' ' && *s != '\t' && *s != '\0')
+        return -1;
+    while (*s == ' ' || *s == '\t')
+        s++;
+    *p = s;
+    return 0;
+}
+
+int hl_cron_parse(const char *expr, HlCron *out)
+{
+    static const struct { const char *name; const char *expr; } macros[] = {
+        { "@yearly",   "0 0 1 1 *" },
+        { "@annually", "0 0 1 1 *" },
+        { "@monthly",  "0 0 1 * *" },
+        { "@weekly",   "0 0 * * 0" },
+        { "@daily",    "0 0 * * *" },
+        { "@midnight", "0 0 * * *" },
+        { "@hourly",   "0 * * * *" },
+    };
+
+    if (!expr || !out)
+        return -1;
+    while (*expr == ' ' || *expr == '\t')
+        expr++;
+    if (*expr == '@') {
+        for (size_t i = 0; i < sizeof(macros) / sizeof(macros[0]); i++)
+            if (strcmp(expr, macros[i].name) == 0)
+                return hl_cron_parse(macros[i].expr, out);
+        return -1;
+    }
+
+    memset(out, 0, sizeof(*out));
+    const char *p = expr;
+    uint64_t bits;
+    uint8_t any;
+
+    if (cron_field(&p, 0, 59, &bits, &any) != 0)
+        return -1;
+    out->minute = bits;
+    if (cron_field(&p, 0, 23, &bits, &any) != 0)
+        return -1;
+    out->hour = (uint32_t)bits;
+    if (cron_field(&p, 1, 31, &bits, &out->dom_any) != 0)
+        return -1;
+    out->dom = (uint32_t)bits;
+    if (cron_field(&p, 1, 12, &bits, &any) != 0)
+        return -1;
+    out->month = (uint16_t)bits;
+    if (cron_field(&p, 0, 7, &bits, &out->dow_any) != 0)
+        return -1;
+    if (bits & (1ULL << 7))
+        bits |= 1;
+    out->dow = (uint8_t)(bits & 0x7f);
+
+    return *p == '\0' ? 0 : -1;
+}
+
+static int cron_day_matches(const HlCron *c, int dom, int dow)
+{
+    int dom_ok = (c->dom >> dom) & 1;
+    int dow_ok = (c->dow >> dow) & 1;
+    if (c->dom_any || c->dow_any)
+        return dom_ok && dow_ok;
+    return dom_ok || dow_ok;
+}
+
+int64_t hl_cron_next(const HlCron *c, int64_t after)
+{
+    if (!c || after < 0)
+        return -1;
+
+    /* Whole minutes since the epoch; skip a month, day or hour at a
+     * time while that field does not match */
+    int64_t t = after / 60 + 1;
+    int64_t limit = t + 8LL * 366 * 1440;
+
+    while (t < limit) {
+        int64_t days = t / 1440;
+        int mins = (int)(t % 1440);
+        int64_t y;
+        int m, d;
+        civil_from_days(days, &y, &m, &d);
+
+        if (!((c->month >> m) & 1)) {
+            t = days_from_civil(m == 12 ? y + 1 : y, m == 12 ? 1 : m + 1, 1) * 1440;
+            continue;
+        }
+        if (!cron_day_matches(c, d, (int)((days + 4) % 7))) {
+            t = (days + 1) * 1440;
+            continue;
+        }
+        int h = mins / 60;
+        if (!((c->hour >> h) & 1)) {
+            t = days * 1440 + (h + 1) * 60;
+            continue;
+        }
+        if (!((c->minute >> (mins % 60)) & 1)) {
+            t++;
+            continue;
+        }
+        return t * 60;
+    }
+    return -1;
+}
+
+/* ── Intervals ─────────────────────────────────────────────────────── */
+
+int hl_sched_interval_check(int64_t ms)
+{
+    return ms >= HL_SCHED_MIN_INTERVAL_MS && ms <= HL_SCHED_MAX_INTERVAL_MS
+           ? 0 : -1;
+}
+
+int hl_sched_interval_parse(const char *s, int64_t *ms)
+{
+    if (!s || !ms || *s < '0' || *s > '9')
+        return -1;
+
+    int64_t v = 0;
+    while (*s >= '0' && *s <= '9') {
+        v = v * 10 + (*s++ - '0');
+        if (v > HL_SCHED_MAX_INTERVAL_MS)
+            return -1;
+    }
+
+    int64_t unit;
+    if (strcmp(s, "ms") == 0)
+        unit = 1;
+    else if (*s == '\0' || strcmp(s, "s") == 0)
+        unit = 1000;
+    else if (strcmp(s, "m") == 0)
+        unit = 60 * 1000;
+    else if (strcmp(s, "h") == 0)
+        unit = 3600 * 1000;
+    else if (strcmp(s, "d") == 0)
+        unit = 86400 * 1000;
+    else
+        return -1;
+
+    if (v > HL_SCHED_MAX_INTERVAL_MS / unit)
+        return -1;
+    *ms = v * unit;
+    return hl_sched_interval_check(*ms);
+}
+
+int hl_sched_job_def(HlJobDef *def, const char *kind, const char *spec,
+                     const char *name, int64_t jitter_ms, int handler_id)
+{
+    if (!def || !kind || !spec)
+        return -1;
+    memset(def, 0, sizeof(*def));
+
+    if (strcmp(kind, "every") == 0) {
+        char *end = NULL;
+        def->every_ms = strtoll(spec, &end, 10);
+        if (!end || *end != '\0' || hl_sched_interval_check(def->every_ms) != 0)
+            return -1;
+    } else if (strcmp(kind, "at") == 0) {
+        if (hl_cron_parse(spec, &def->cron) != 0)
+            return -1;
+    } else {
+        return -1;
+    }
+
+    if (jitter_ms < 0 || jitter_ms > HL_SCHED_MAX_INTERVAL_MS)
+        return -1;
+    snprintf(def->name, sizeof(def->name), "%s", name ? name : spec);
+    def->jitter_ms = jitter_ms;
+    def->handler_id = handler_id;
+    return 0;
+}
+
+/* ── Scheduler ─────────────────────────────────────────────────────── */
+
+typedef struct {
+    HlTimer   timer;            /* first: the wheel hands back HlTimer* */
+    HlJobDef  def;
+    int       metrics_id;
+    int64_t   base_ms;          /* app.every: unjittered slot (monotonic) */
+    int64_t   cron_at;          /* app.at: next match (UTC seconds) */
+    int64_t   fire_ms;          /* when it runs, jitter included (monotonic) */
+    /* Totals: runs/errors/time from the loop thread, skipped from ours */
+    uint64_t  runs;
+    uint64_t  errors;
+    uint64_t  skipped;
+    uint64_t  total_ns;
+    uint64_t  max_ns;
+} SchedJob;
+
+struct HlSched {
+    HlRuntime      **rtp;
+    SchedJob         jobs[HL_SCHED_MAX_JOBS];
+    int              count;
+    char             token[33];
+    uint64_t         rng;
+    HlWheel          wheel;
+    int64_t          epoch_ms;  /* monotonic ms at tick 0 */
+
+    struct sockaddr_storage addr;
+    socklen_t        addrlen;
+    KlTlsConfig     *tls;
+
+    pthread_t        thread;
+    pthread_mutex_t  mu;
+    pthread_cond_t   cond;
+    int              started;
+    int              stopping;
+    int              inflight;  /* job being triggered, -1 if none (mu) */
+};
+
+static int64_t mono_ms(void)
+{
+    return hl_cap_time_clock_ns() / 1000000;
+}
+
+static uint64_t sched_rand(HlSched *s)
+{
+    /* xorshift64: jitter only needs to spread instances apart */
+    s->rng ^= s->rng << 13;
+    s->rng ^= s->rng >> 7;
+    s->rng ^= s->rng << 17;
+    return s->rng;
+}
+
+static int sched_stopping(HlSched *s)
+{
+    pthread_mutex_lock(&s->mu);
+    int stop = s->stopping;
+    pthread_mutex_unlock(&s->mu);
+    return stop;
+}
+
+static void sched_arm(HlSched *s, SchedJob *j)
+{
+    uint64_t tick = j->fire_ms <= s->epoch_ms ? 0
+        : (uint64_t)((j->fire_ms - s->epoch_ms + HL_SCHED_TICK_MS - 1) /
+                     HL_SCHED_TICK_MS);
+    hl_wheel_add(&s->wheel, &j->timer, tick);
+}
+
+/*
+ * Work out the next run after one that finished at `now` (monotonic ms)
+ * and arm it. Slots that passed while the run was going are skipped.
+ * Returns -1 when a cron expression has no future match.
+ */
+static int sched_plan(HlSched *s, SchedJob *j, int64_t now)
+{
+    uint64_t skipped = 0;
+    int64_t at;
+
+    if (j->def.every_ms > 0) {
+        int64_t next = j->base_ms + j->def.every_ms;
+        if (next <= now) {
+            int64_t missed = (now - next) / j->def.every_ms + 1;
+            skipped = (uint64_t)missed;
+            next += missed * j->def.every_ms;
+        }
+        j->base_ms = next;
+        at = next;
+    } else {
+        int64_t wall = hl_cap_time_now_ms();
+        int64_t t = hl_cron_next(&j->def.cron, j->cron_at);
+        while (t >= 0 && t * 1000 <= wall) {
+            skipped++;
+            t = hl_cron_next(&j->def.cron, t);
+        }
+        if (t < 0)
+            return -1;
+        j->cron_at = t;
+        at = now + (t * 1000 - wall);
+    }
+
+    if (skipped > 0) {
+        j->skipped += skipped;
+        hl_metrics_job_skipped(j->metrics_id, skipped);
+    }
+    j->fire_ms = at;
+    if (j->def.jitter_ms > 0)
+        j->fire_ms += (int64_t)(sched_rand(s) % (uint64_t)(j->def.jitter_ms + 1));
+    sched_arm(s, j);
+    return 0;
+}
+
+/* Wait for fd to become readable/writable, giving up on stop or timeout */
+static int sched_poll(HlSched *s, int fd, short events, int64_t deadline)
+{
+    for (;;) {
+        if (sched_stopping(s))
+            return -1;
+        int64_t left = deadline - mono_ms();
+        if (left <= 0)
+            return -1;
+        struct pollfd pfd = { .fd = fd, .events = events };
+        int pr = poll(&pfd, 1, left < 100 ? (int)left : 100);
+        if (pr > 0)
+            return 0;
+        if (pr < 0 && errno != EINTR)
+            return -1;
+    }
+}
+
+static ssize_t sched_io(int fd, KlTls *tls, void *buf, size_t len, int wr)
+{
+    if (tls)
+        return wr ? tls->write(tls, fd, buf, len) : tls->read(tls, fd, buf, len);
+    ssize_t r;
+    do {
+#ifdef MSG_NOSIGNAL
+        r = wr ? send(fd, buf, len, MSG_NOSIGNAL) : recv(fd, buf, len, 0);
+#else
+        r = wr ? write(fd, buf, len) : read(fd, buf, len);
+#endif
+    } while (r < 0 && errno == EINTR);
+    return r;
+}
+
+static KlTls *sched_handshake(HlSched *s, int fd, int64_t deadline)
+{
+    KlAllocator alloc = kl_allocator_default();
+    KlTls *tls = s->tls->factory(s->tls->ctx, &alloc);
+    if (!tls)
+        return NULL;
+    for (;;) {
+        KlTlsResult r = tls->handshake(tls, fd);
+        if (r == KL_TLS_OK)
+            return tls;
+        if (r == KL_TLS_ERROR ||
+            sched_poll(s, fd, r == KL_TLS_WANT_READ ? POLLIN : POLLOUT,
+                       deadline) != 0) {
+            tls->destroy(tls);
+            return NULL;
+        }
+    }
+}
+
+/*
+ * Ask the server to run job `id` and wait for the answer. Returns the
+ * HTTP status, or -1 when the server could not be reached in time.
+ */
+static int sched_trigger(HlSched *s, int id)
+{
+    int64_t deadline = mono_ms() + HL_SCHED_TIMEOUT_MS;
+    int fd = socket(s->addr.ss_family, SOCK_STREAM, 0);
+    if (fd < 0)
+        return -1;
+#ifdef SO_NOSIGPIPE
+    {
+        int on = 1;
+        setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &on, sizeof(on));
+    }
+#endif
+    /* The endpoint accepts job id only while this trigger is open */
+    pthread_mutex_lock(&s->mu);
+    s->inflight = id;
+    pthread_mutex_unlock(&s->mu);
+
+    KlTls *tls = NULL;
+    int status = -1;
+
+    /* Loopback to a listening socket: connects or fails at once */
+    if (connect(fd, (struct sockaddr *)&s->addr, s->addrlen) != 0)
+        goto done;
+
+    if (s->tls && !(tls = sched_handshake(s, fd, deadline)))
+        goto done;
+
+    char buf[256];
+    int n = snprintf(buf, sizeof(buf),
+                     "POST " HL_SCHED_PATH " HTTP/1.1\r\n"
+                     "Host: localhost\r\n"
+                     HL_SCHED_HEADER ": %s\r\n"
+                     HL_SCHED_ID_HEADER ": %d\r\n"
+                     "Content-Length: 0\r\n"
+                     "Connection: close\r\n\r\n", s->token, id);
+    size_t sent = 0;
+    while (n > 0 && sent < (size_t)n) {
+        if (sched_poll(s, fd, POLLOUT, deadline) != 0)
+            goto done;
+        ssize_t w = sched_io(fd, tls, buf + sent, (size_t)n - sent, 1);
+        if (w <= 0)
+            goto done;
+        sent += (size_t)w;
+    }
+
+    /* Only the status line matters: "HTTP/1.1 200 ..." */
+    size_t got = 0;
+    while (got < 12) {
+        if (sched_poll(s, fd, POLLIN, deadline) != 0)
+            goto done;
+        ssize_t r = sched_io(fd, tls, buf + got, sizeof(buf) - 1 - got, 0);
+        if (r <= 0)
+            break;
+        got += (size_t)r;
+    }
+    buf[got] = '\0';
+    if (got >= 12 && strncmp(buf, "HTTP/1.", 7) == 0)
+        status = atoi(buf + 9);
+
+done:
+    if (tls) {
+        tls->shutdown(tls, fd);
+        tls->destroy(tls);
+    }
+    close(fd);
+    pthread_mutex_lock(&s->mu);
+    s->inflight = -1;
+    pthread_mutex_unlock(&s->mu);
+    return status;
+}
+
+static void sched_fire(HlSched *s, SchedJob *j)
+{
+    int64_t now = mono_ms();
+
+    /* Early: a clamped far deadline, or the wall clock moved back */
+    if (j->def.every_ms == 0) {
+        int64_t ahead = j->cron_at * 1000 - hl_cap_time_now_ms();
+        if (ahead > HL_SCHED_TICK_MS)
+            j->fire_ms = now + ahead;
+    }
+    if (j->fire_ms > now + HL_SCHED_TICK_MS) {
+        sched_arm(s, j);
+        return;
+    }
+
+    int status = sched_trigger(s, (int)(j - s->jobs));
+    if (status < 0 && !sched_stopping(s))
+        log_warn("[hull:c] job %s: no answer from the server", j->def.name);
+    else if (status == 404)
+        log_warn("[hull:c] job %s: job endpoint not found", j->def.name);
+
+    if (sched_plan(s, j, mono_ms()) != 0)
+        log_warn("[hull:c] job %s: cron expression never matches again, "
+                 "job stopped", j->def.name);
+}
+
+static void *sched_main(void *arg)
+{
+    HlSched *s = (HlSched *)arg;
+
+    for (;;) {
+        int64_t now = mono_ms();
+        HlTimer *due = hl_wheel_advance(&s->wheel,
+            (uint64_t)(now - s->epoch_ms) / HL_SCHED_TICK_MS);
+        while (due && !sched_stopping(s)) {
+            HlTimer *next = due->next;
+            sched_fire(s, (SchedJob *)due);
+            due = next;
+        }
+
+        /* Sleep to the next tick with work, re-reading the clocks at
+         * least every HL_SCHED_MAX_SLEEP_MS (the wall clock may jump) */
+        int64_t wait = HL_SCHED_MAX_SLEEP_MS;
+        uint64_t next = hl_wheel_next(&s->wheel);
+        if (next != UINT64_MAX) {
+            int64_t at = s->epoch_ms + (int64_t)next * HL_SCHED_TICK_MS;
+            if (at - mono_ms() < wait)
+                wait = at - mono_ms();
+        }
+
+        struct timespec until;
+        clock_gettime(CLOCK_REALTIME, &until);
+        if (wait > 0) {
+            until.tv_sec += wait / 1000;
+            until.tv_nsec += (long)(wait % 1000) * 1000000L;
+            if (until.tv_nsec >= 1000000000L) {
+                until.tv_sec++;
+                until.tv_nsec -= 1000000000L;
+            }
+        }
+        pthread_mutex_lock(&s->mu);
+        if (!s->stopping && wait > 0)
+            pthread_cond_timedwait(&s->cond, &s->mu, &until);
+        int stop = s->stopping;
+        pthread_mutex_unlock(&s->mu);
+        if (stop)
+            break;
+    }
+    return NULL;
+}
+
+HlSched *hl_sched_create(const HlJobDef *jobs, int count, HlRuntime **rtp)
+{
+    if (!jobs || count <= 0 || count > HL_SCHED_MAX_JOBS || !rtp)
+        return NULL;
+
+    HlSched *s = calloc(1, sizeof(*s));
+    if (!s)
+        return NULL;
+    s->rtp = rtp;
+    s->count = count;
+    s->inflight = -1;
+    for (int i = 0; i < count; i++) {
+        s->jobs[i].def = jobs[i];
+        s->jobs[i].metrics_id = hl_metrics_job(jobs[i].name);
+    }
+
+    unsigned char rnd[24];
+    if (hl_cap_crypto_random(rnd, sizeof(rnd)) != 0) {
+        free(s);
+        return NULL;
+    }
+    for (int i = 0; i < 16; i++)
+        snprintf(s->token + i * 2, 3, "%02x", rnd[i]);
+    memcpy(&s->rng, rnd + 16, sizeof(s->rng));
+    s->rng |= 1;
+    return s;
+}
+
+int hl_sched_start(HlSched *s, int listen_fd, void *tls)
+{
+    if (!s || s->started)
+        return -1;
+
+    s->addrlen = sizeof(s->addr);
+    if (getsockname(listen_fd, (struct sockaddr *)&s->addr, &s->addrlen) != 0)
+        return -1;
+    /* A wildcard bind is reached via loopback */
+    if (s->addr.ss_family == AF_INET) {
+        struct sockaddr_in *in = (struct sockaddr_in *)&s->addr;
+        if (in->sin_addr.s_addr == htonl(INADDR_ANY))
+            in->sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    } else if (s->addr.ss_family == AF_INET6) {
+        struct sockaddr_in6 *in6 = (struct sockaddr_in6 *)&s->addr;
+        if (memcmp(&in6->sin6_addr, &in6addr_any, sizeof(in6addr_any)) == 0)
+            in6->sin6_addr = in6addr_loopback;
+    } else {
+        return -1;
+    }
+    s->tls = (KlTlsConfig *)tls;
+
+    /* First runs: one interval (or the next cron match) from now */
+    s->epoch_ms = mono_ms();
+    hl_wheel_init(&s->wheel, 0);
+    int64_t wall = hl_cap_time_now_ms();
+    for (int i = 0; i < s->count; i++) {
+        SchedJob *j = &s->jobs[i];
+        j->base_ms = s->epoch_ms;
+        j->cron_at = wall / 1000;
+        if (sched_plan(s, j, s->epoch_ms) != 0)
+            log_warn("[hull:c] job %s: cron expression never matches, "
+                     "not scheduled", j->def.name);
+    }
+
+    pthread_mutex_init(&s->mu, NULL);
+    pthread_cond_init(&s->cond, NULL);
+    if (pthread_create(&s->thread, NULL, sched_main, s) != 0) {
+        pthread_cond_destroy(&s->cond);
+        pthread_mutex_destroy(&s->mu);
+        return -1;
+    }
+    s->started = 1;
+    return 0;
+}
+
+/* ── Endpoint ──────────────────────────────────────────────────────── */
+
+static void reply(KlRequest *req, KlResponse *res, int status,
+                  const char *body)
+{
+    kl_response_status(res, status);
+    kl_response_header(res, "Content-Type", "text/plain");
+    kl_response_body(res, body, strlen(body));
+    hl_access_log_finish(req, status, strlen(body));
+}
+
+/* Set by a reverse proxy: the request came from outside, not from us */
+static const char *const forwarded_headers[] = {
+    "Forwarded", "X-Forwarded-For", "X-Real-IP",
+};
+
+/*
+ * Only the scheduler thread may run a job. Keel does not hand handlers
+ * the peer address, so instead of checking for loopback the request
+ * must carry the token, must not have passed through a proxy, and must
+ * name the job the scheduler is triggering right now; that claim is
+ * used up, so a replay in the same window is refused too.
+ */
+static int sched_claim(KlRequest *req, HlSched *s, int *id_out)
+{
+    size_t len = 0;
+    const char *token = kl_request_header_len(req, HL_SCHED_HEADER, &len);
+    /* Served on the public listener: the length is no secret (always
+     * 32 hex digits), the contents are */
+    if (!s || !s->started || !token || len != strlen(s->token) ||
+        !hl_cap_crypto_equal(token, s->token, len))
+        return -1;
+    for (size_t i = 0; i < sizeof(forwarded_headers) /
+                           sizeof(forwarded_headers[0]); i++)
+        if (kl_request_header_len(req, forwarded_headers[i], &len))
+            return -1;
+
+    const char *id_str = kl_request_header_len(req, HL_SCHED_ID_HEADER, &len);
+    int id = -1;
+    if (id_str && len > 0 && len < 4) {
+        id = 0;
+        for (size_t i = 0; i < len && id >= 0; i++)
+            id = (id_str[i] >= '0' && id_str[i] <= '9')
+                 ? id * 10 + (id_str[i] - '0') : -1;
+    }
+    if (id < 0 || id >= s->count)
+        return -1;
+
+    pthread_mutex_lock(&s->mu);
+    int claimed = s->inflight == id;
+    if (claimed)
+        s->inflight = -1;
+    pthread_mutex_unlock(&s->mu);
+    if (!claimed)
+        return -1;
+    *id_out = id;
+    return 0;
+}
+
+static void sched_run(KlRequest *req, KlResponse *res, HlSched *s)
+{
+    int id;
+    if (sched_claim(req, s, &id) != 0) {
+        reply(req, res, 404, "Not Found");
+        return;
+    }
+
+    SchedJob *j = &s->jobs[id];
+    HlRuntime *rt = *s->rtp;
+    uint64_t mt0 = hl_metrics_start();
+    int64_t t0 = hl_cap_time_clock_ns();
+    int rc = rt->vt->run_job(rt, j->def.handler_id);
+    uint64_t ns = (uint64_t)(hl_cap_time_clock_ns() - t0);
+
+    j->runs++;
+    j->total_ns += ns;
+    if (ns > j->max_ns)
+        j->max_ns = ns;
+    if (rc != 0) {
+        j->errors++;
+        log_error("[hull:c] job %s failed", j->def.name);
+    }
+    hl_metrics_job_end(j->metrics_id, mt0, rc != 0 ? -1 : 0);
+    hl_metrics_runtime(rt);
+
+    reply(req, res, rc == 0 ? 200 : 500, rc == 0 ? "ok\n" : "error\n");
+}
+
+int hl_sched_middleware(KlRequest *req, KlResponse *res, void *user_data)
+{
+    sched_run(req, res, (HlSched *)user_data);
+    return 1;
+}
+
+void hl_sched_handler(KlRequest *req, KlResponse *res, void *user_data)
+{
+    sched_run(req, res, (HlSched *)user_data);
+}
+
+void hl_sched_destroy(HlSched *s)
+{
+    if (!s)
+        return;
+
+    if (s->started) {
+        pthread_mutex_lock(&s->mu);
+        s->stopping = 1;
+        pthread_cond_signal(&s->cond);
+        pthread_mutex_unlock(&s->mu);
+        pthread_join(s->thread, NULL);
+        pthread_cond_destroy(&s->cond);
+        pthread_mutex_destroy(&s->mu);
+    }
+
+    for (int i = 0; s->started && i < s->count; i++) {
+        SchedJob *j = &s->jobs[i];
+        log_info("[hull:c] job %s: %llu runs, %llu errors, %llu skipped, "
+                 "avg %.1f ms, max %.1f ms", j->def.name,
+                 (unsigned long long)j->runs, (unsigned long long)j->errors,
+                 (unsigned long long)j->skipped,
+                 j->runs ? (double)j->total_ns / (double)j->runs / 1e6 : 0.0,
+                 (double)j->max_ns / 1e6);
+    }
+    free(s);
+}
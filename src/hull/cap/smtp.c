@@ -3,13 +3,17 @@
  *
  * Synchronous SMTP client with STARTTLS, AUTH PLAIN, and host
  * allowlist enforcement.  Follows the same connect/TLS/timeout
- * patterns as http.c.
+ * patterns as http.c.  Authenticated sessions are reused across
+ * messages (per batch, and across sends through an HlSmtpPool), and
+ * the envelope is pipelined when the server advertises PIPELINING.
  *
  * SPDX-License-Identifier: AGPL-3.0-or-later
  */
 
 #include "hull/cap/smtp.h"
 #include "hull/cap/audit.h"
+#include "hull/cap/crypto.h"
+#include "hull/cap/metrics.h"
 #include "hull/limits.h"
 
 #include <keel/allocator.h>
@@ -19,6 +23,8 @@
 #include <fcntl.h>
 #include <netdb.h>
 #include <poll.h>
+#include <pthread.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -332,15 +338,11 @@ int hl_smtp_parse_response(const char *line, int len)
 }
 
 /**
- * Send an SMTP command and read the response.
- * Returns the response code, or -1 on error.
+ * Send raw data without reading a response.
  */
-static int smtp_send_command(int fd, KlTls *tls, const char *cmd,
-                             int expected_code, int timeout_ms)
+static int smtp_send_raw(int fd, KlTls *tls, const char *data, size_t len,
+                         int timeout_ms)
 {
-    size_t len = strlen(cmd);
-
-    /* Send command (may need multiple writes) */
     size_t sent = 0;
     while (sent < len) {
         struct pollfd pfd = { .fd = fd, .events = POLLOUT };
@@ -348,15 +350,35 @@ static int smtp_send_command(int fd, KlTls *tls, const char *cmd,
         if (pr <= 0)
             return -1;
 
-        ssize_t w = io_write(fd, tls, cmd + sent, len - sent);
+        ssize_t w = io_write(fd, tls, data + sent, len - sent);
         if (w <= 0)
             return -1;
         sent += (size_t)w;
     }
+    return 0;
+}
+
+/**
+ * Send an SMTP command and read the response.
+ * Returns the response code, or -1 on I/O error.
+ */
+static int smtp_command(int fd, KlTls *tls, const char *cmd, int timeout_ms)
+{
+    if (smtp_send_raw(fd, tls, cmd, strlen(cmd), timeout_ms) != 0)
+        return -1;
 
-    /* Read response */
     char resp[HL_SMTP_RECV_BUF_SIZE];
-    int code = smtp_read_response(fd, tls, resp, (int)sizeof(resp), timeout_ms);
+    return smtp_read_response(fd, tls, resp, (int)sizeof(resp), timeout_ms);
+}
+
+/**
+ * Send an SMTP command and require a response code.
+ * Returns the response code, or -1 on error or an unexpected code.
+ */
+static int smtp_send_command(int fd, KlTls *tls, const char *cmd,
+                             int expected_code, int timeout_ms)
+{
+    int code = smtp_command(fd, tls, cmd, timeout_ms);
 
     if (expected_code > 0 && code != expected_code) {
         log_warn("smtp: expected %d, got %d for command '%.20s'",
@@ -367,24 +389,61 @@ static int smtp_send_command(int fd, KlTls *tls, const char *cmd,
     return code;
 }
 
+unsigned hl_smtp_parse_ehlo(const char *resp)
+{
+    static const struct { const char *kw; unsigned bit; } exts[] = {
+        { "PIPELINING", HL_SMTP_EXT_PIPELINING },
+        { "STARTTLS",   HL_SMTP_EXT_STARTTLS },
+    };
+
+    if (!resp)
+        return 0;
+
+    unsigned ext = 0;
+    int first = 1;
+    for (const char *line = resp; *line; ) {
+        const char *eol = strchr(line, '\n');
+        size_t len = eol ? (size_t)(eol - line) : strlen(line);
+
+        /* "250-KEYWORD params"; the first line carries the domain */
+        if (!first && len > 4) {
+            const char *kw = line + 4;
+            size_t kw_len = 0;
+            while (kw_len < len - 4 && kw[kw_len] != ' ' &&
+                   kw[kw_len] != '\r')
+                kw_len++;
+            for (size_t i = 0; i < sizeof(exts) / sizeof(exts[0]); i++) {
+                if (strlen(exts[i].kw) == kw_len &&
+                    strncasecmp(kw, exts[i].kw, kw_len) == 0)
+                    ext |= exts[i].bit;
+            }
+        }
+        first = 0;
+        if (!eol)
+            break;
+        line = eol + 1;
+    }
+    return ext;
+}
+
 /**
- * Send raw data without reading a response.
+ * Send EHLO and record the advertised extensions.
+ * Returns 0 on a 250 reply, -1 otherwise.
  */
-static int smtp_send_raw(int fd, KlTls *tls, const char *data, size_t len,
-                         int timeout_ms)
+static int smtp_ehlo(int fd, KlTls *tls, unsigned *ext, int timeout_ms)
 {
-    size_t sent = 0;
-    while (sent < len) {
-        struct pollfd pfd = { .fd = fd, .events = POLLOUT };
-        int pr = poll(&pfd, 1, timeout_ms);
-        if (pr <= 0)
-            return -1;
+    static const char cmd[] = "EHLO localhost\r\n";
+    if (smtp_send_raw(fd, tls, cmd, sizeof(cmd) - 1, timeout_ms) != 0)
+        return -1;
 
-        ssize_t w = io_write(fd, tls, data + sent, len - sent);
-        if (w <= 0)
-            return -1;
-        sent += (size_t)w;
+    char resp[HL_SMTP_RECV_BUF_SIZE];
+    int code = smtp_read_response(fd, tls, resp, (int)sizeof(resp), timeout_ms);
+    if (code != 250) {
+        log_warn("smtp: expected 250, got %d for command 'EHLO localhost'",
+                 code);
+        return -1;
     }
+    *ext = hl_smtp_parse_ehlo(resp);
     return 0;
 }
 
@@ -511,47 +570,116 @@ static int smtp_validate_message(const HlSmtpMessage *msg)
     if (msg->port < 1 || msg->port > 65535)
         return -1;
 
+    /* DNS names are at most 253 bytes; the session key stores 256 */
+    if (strlen(msg->host) > 253)
+        return -1;
+
     return 0;
 }
 
-/* ── Public API ──────────────────────────────────────────────────── */
+/* ── Sessions ────────────────────────────────────────────────────── */
 
-int hl_cap_smtp_send(const HlSmtpConfig *cfg, const HlSmtpMessage *msg)
+/*
+ * One SMTP connection past greeting, EHLO, STARTTLS and AUTH, ready for
+ * MAIL FROM. The key fields say which messages may use it.
+ */
+typedef struct {
+    int       fd;               /* -1 = not connected */
+    KlTls    *tls;
+    unsigned  ext;              /* HL_SMTP_EXT_* from the last EHLO */
+    int       messages;         /* delivered on this connection */
+    int       in_use;           /* held by a sender (pool slots only) */
+    uint64_t  idle_since_ms;
+
+    char      host[256];
+    int       port;
+    int       use_tls;
+    uint8_t   cred[32];         /* SHA-256 of "user\0pass", zero = no AUTH */
+} SmtpSession;
+
+struct HlSmtpPool {
+    pthread_mutex_t mu;
+    int             idle_ms;
+    SmtpSession     sessions[HL_SMTP_POOL_SIZE];
+};
+
+static uint64_t smtp_now_ms(void)
 {
-    if (!cfg || !msg)
-        return -1;
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000 + (uint64_t)ts.tv_nsec / 1000000;
+}
 
-    /* Validate message fields */
-    if (smtp_validate_message(msg) != 0)
-        return -1;
+static void session_key(SmtpSession *s, const HlSmtpMessage *msg)
+{
+    memset(s, 0, sizeof(*s));
+    s->fd = -1;
+    snprintf(s->host, sizeof(s->host), "%s", msg->host);
+    s->port = msg->port;
+    s->use_tls = msg->use_tls;
 
-    /* Check host allowlist */
-    if (hl_smtp_check_host(cfg, msg->host) != 0) {
-        log_warn("smtp: host '%s' not in allowlist", msg->host);
-        ShJsonWriter w = hl_audit_begin("smtp.send");
-        sh_json_write_kv_string(&w, "host", msg->host);
-        sh_json_write_kv_string(&w, "from", msg->from);
-        sh_json_write_kv_string(&w, "to", msg->to);
-        sh_json_write_kv_string(&w, "result", "denied");
-        hl_audit_end(&w);
-        return -1;
+    if (msg->username && msg->password) {
+        size_t ulen = strlen(msg->username);
+        size_t plen = strlen(msg->password);
+        KlAllocator alloc = kl_allocator_default();
+        char *buf = kl_malloc(&alloc, ulen + plen + 1);
+        if (buf) {
+            memcpy(buf, msg->username, ulen);
+            buf[ulen] = '\0';
+            memcpy(buf + ulen + 1, msg->password, plen);
+            hl_cap_crypto_sha256(buf, ulen + plen + 1, s->cred);
+            kl_free(&alloc, buf, ulen + plen + 1);
+        } else {
+            memset(s->cred, 0xff, sizeof(s->cred));  /* never matches */
+        }
+    }
+}
+
+static int session_matches(const SmtpSession *s, const SmtpSession *key)
+{
+    return s->port == key->port && s->use_tls == key->use_tls &&
+           strcasecmp(s->host, key->host) == 0 &&
+           memcmp(s->cred, key->cred, sizeof(s->cred)) == 0;
+}
+
+static void session_close(SmtpSession *s, int quit, int timeout_ms)
+{
+    if (s->fd < 0)
+        return;
+    if (quit)
+        smtp_command(s->fd, s->tls, "QUIT\r\n", timeout_ms);
+    if (s->tls) {
+        s->tls->shutdown(s->tls, s->fd);
+        s->tls->destroy(s->tls);
+        s->tls = NULL;
     }
+    close(s->fd);
+    s->fd = -1;
+    s->messages = 0;
+}
 
-    int timeout_ms = cfg->timeout_ms > 0 ? cfg->timeout_ms
-                                         : HL_SMTP_DEFAULT_TIMEOUT_MS;
+/* An idle connection with something to read was closed (or sent 421) */
+static int session_stale(const SmtpSession *s)
+{
+    struct pollfd pfd = { .fd = s->fd, .events = POLLIN };
+    return poll(&pfd, 1, 0) != 0;
+}
 
+/* Connect, greet, EHLO, STARTTLS and AUTH. Returns 0 or -1. */
+static int session_open(SmtpSession *s, const HlSmtpConfig *cfg,
+                        const HlSmtpMessage *msg, int timeout_ms)
+{
     /* TLS config (for STARTTLS or implicit TLS) */
     KlTlsConfig *tls_cfg = (KlTlsConfig *)cfg->tls;
 
     /* Connect to SMTP server */
-    int fd = smtp_connect(msg->host, msg->port, timeout_ms);
-    if (fd < 0) {
+    s->fd = smtp_connect(msg->host, msg->port, timeout_ms);
+    if (s->fd < 0) {
         log_warn("smtp: connect to %s:%d failed", msg->host, msg->port);
         return -1;
     }
+    s->messages = 0;
 
-    KlTls *tls = NULL;
-    int ret = -1;
     char resp[HL_SMTP_RECV_BUF_SIZE];
     char cmd[HL_SMTP_SEND_BUF_SIZE];
 
@@ -559,61 +687,59 @@ int hl_cap_smtp_send(const HlSmtpConfig *cfg, const HlSmtpMessage *msg)
     if (msg->use_tls == 2) {
         if (!tls_cfg) {
             log_warn("smtp: implicit TLS requested but no TLS config");
-            goto cleanup;
+            goto fail;
         }
-        tls = smtp_tls_handshake(fd, tls_cfg, msg->host, timeout_ms);
-        if (!tls) {
+        s->tls = smtp_tls_handshake(s->fd, tls_cfg, msg->host, timeout_ms);
+        if (!s->tls) {
             log_warn("smtp: implicit TLS handshake failed");
-            goto cleanup;
+            goto fail;
         }
     }
 
     /* Read 220 greeting */
-    int code = smtp_read_response(fd, tls, resp, (int)sizeof(resp), timeout_ms);
+    int code = smtp_read_response(s->fd, s->tls, resp, (int)sizeof(resp),
+                                  timeout_ms);
     if (code != 220) {
         log_warn("smtp: expected 220 greeting, got %d", code);
-        goto cleanup;
+        goto fail;
     }
 
     /* EHLO */
-    snprintf(cmd, sizeof(cmd), "EHLO localhost\r\n");
-    code = smtp_send_command(fd, tls, cmd, 250, timeout_ms);
-    if (code < 0)
-        goto cleanup;
+    if (smtp_ehlo(s->fd, s->tls, &s->ext, timeout_ms) != 0)
+        goto fail;
 
     /* STARTTLS (if requested and not already implicit TLS) */
-    if (msg->use_tls == 1 && !tls) {
+    if (msg->use_tls == 1 && !s->tls) {
         if (!tls_cfg) {
             log_warn("smtp: STARTTLS requested but no TLS config");
-            goto cleanup;
+            goto fail;
         }
 
-        code = smtp_send_command(fd, tls, "STARTTLS\r\n", 220, timeout_ms);
+        code = smtp_send_command(s->fd, s->tls, "STARTTLS\r\n", 220,
+                                 timeout_ms);
         if (code < 0) {
             log_warn("smtp: STARTTLS rejected");
-            goto cleanup;
+            goto fail;
         }
 
-        tls = smtp_tls_handshake(fd, tls_cfg, msg->host, timeout_ms);
-        if (!tls) {
+        s->tls = smtp_tls_handshake(s->fd, tls_cfg, msg->host, timeout_ms);
+        if (!s->tls) {
             log_warn("smtp: STARTTLS handshake failed");
-            goto cleanup;
+            goto fail;
         }
 
-        /* Re-EHLO after TLS upgrade */
-        snprintf(cmd, sizeof(cmd), "EHLO localhost\r\n");
-        code = smtp_send_command(fd, tls, cmd, 250, timeout_ms);
-        if (code < 0)
-            goto cleanup;
+        /* Re-EHLO after TLS upgrade — extensions may differ */
+        if (smtp_ehlo(s->fd, s->tls, &s->ext, timeout_ms) != 0)
+            goto fail;
     }
 
     /* AUTH PLAIN (if credentials provided) */
     if (msg->username && msg->password) {
         /* Refuse to send credentials over a plaintext connection */
-        if (!tls) {
+        if (!s->tls) {
             log_warn("smtp: AUTH PLAIN requires TLS — refusing to send "
                      "credentials in plaintext (set use_tls=1 or 2)");
-            goto cleanup;
+            goto fail;
         }
 
         /* AUTH PLAIN: base64(\0username\0password) */
@@ -623,7 +749,7 @@ int hl_cap_smtp_send(const HlSmtpConfig *cfg, const HlSmtpMessage *msg)
 
         if (plain_len > 1024) {
             log_warn("smtp: AUTH PLAIN credentials too long");
-            goto cleanup;
+            goto fail;
         }
 
         unsigned char plain[1026];
@@ -637,100 +763,391 @@ int hl_cap_smtp_send(const HlSmtpConfig *cfg, const HlSmtpMessage *msg)
                                             b64, (int)sizeof(b64));
         if (b64_len < 0) {
             log_warn("smtp: AUTH PLAIN base64 encode failed");
-            goto cleanup;
+            goto fail;
         }
 
         snprintf(cmd, sizeof(cmd), "AUTH PLAIN %s\r\n", b64);
-        code = smtp_send_command(fd, tls, cmd, 235, timeout_ms);
+        code = smtp_send_command(s->fd, s->tls, cmd, 235, timeout_ms);
         if (code < 0) {
             log_warn("smtp: AUTH PLAIN failed");
-            goto cleanup;
+            goto fail;
         }
     }
 
-    /* MAIL FROM */
-    snprintf(cmd, sizeof(cmd), "MAIL FROM:<%s>\r\n", msg->from);
-    code = smtp_send_command(fd, tls, cmd, 250, timeout_ms);
-    if (code < 0)
-        goto cleanup;
+    return 0;
 
-    /* RCPT TO — primary recipient */
-    snprintf(cmd, sizeof(cmd), "RCPT TO:<%s>\r\n", msg->to);
-    code = smtp_send_command(fd, tls, cmd, 250, timeout_ms);
-    if (code < 0)
-        goto cleanup;
+fail:
+    session_close(s, 0, timeout_ms);
+    return -1;
+}
 
-    /* RCPT TO — CC recipients */
-    if (msg->cc) {
-        for (int i = 0; i < msg->cc_count; i++) {
-            snprintf(cmd, sizeof(cmd), "RCPT TO:<%s>\r\n", msg->cc[i]);
-            code = smtp_send_command(fd, tls, cmd, 250, timeout_ms);
-            if (code < 0)
-                goto cleanup;
-        }
-    }
+/* Transaction outcomes */
+#define SMTP_TX_OK        0
+#define SMTP_TX_REJECTED -1    /* server said no; session still usable */
+#define SMTP_TX_BROKEN   -2    /* connection unusable */
 
-    /* DATA */
-    code = smtp_send_command(fd, tls, "DATA\r\n", 354, timeout_ms);
-    if (code < 0)
-        goto cleanup;
+/* After a rejection: RSET back to the post-EHLO state */
+static int smtp_reset(SmtpSession *s, int timeout_ms)
+{
+    return smtp_command(s->fd, s->tls, "RSET\r\n", timeout_ms) == 250
+               ? SMTP_TX_REJECTED : SMTP_TX_BROKEN;
+}
 
-    /* Format and send the message */
-    {
-        /* Allocate message buffer (body + headers overhead) */
-        size_t body_len = strlen(msg->body);
-        size_t msg_size = body_len + 4096;  /* headers + dot-stuffing headroom */
-        if (msg_size > (size_t)HL_SMTP_MAX_MSG_SIZE)
-            msg_size = (size_t)HL_SMTP_MAX_MSG_SIZE;
+/* MAIL FROM and every RCPT TO; returns an SMTP_TX_* outcome */
+static int smtp_envelope(SmtpSession *s, const HlSmtpMessage *msg,
+                         int timeout_ms)
+{
+    int n_rcpt = 1 + (msg->cc ? msg->cc_count : 0);
+    char cmd[HL_SMTP_SEND_BUF_SIZE];
+    int rejected = 0;
 
+    if (s->ext & HL_SMTP_EXT_PIPELINING) {
+        /* RFC 2920: the whole envelope in one write, replies read in
+         * order. DATA waits for them so a rejected recipient ends in
+         * RSET rather than a delivery to the remaining ones. */
+        size_t cap = (size_t)(n_rcpt + 1) * HL_SMTP_SEND_BUF_SIZE;
         KlAllocator alloc = kl_allocator_default();
-        char *msg_buf = kl_malloc(&alloc, msg_size);
-        if (!msg_buf) {
-            log_warn("smtp: message buffer allocation failed");
-            goto cleanup;
+        char *batch = kl_malloc(&alloc, cap);
+        if (!batch)
+            return SMTP_TX_REJECTED;
+
+        size_t off = (size_t)snprintf(batch, cap, "MAIL FROM:<%s>\r\n",
+                                      msg->from);
+        for (int i = 0; i < n_rcpt && off < cap; i++)
+            off += (size_t)snprintf(batch + off, cap - off, "RCPT TO:<%s>\r\n",
+                                    i == 0 ? msg->to : msg->cc[i - 1]);
+        int rc = off < cap ? smtp_send_raw(s->fd, s->tls, batch, off,
+                                           timeout_ms) : -1;
+        kl_free(&alloc, batch, cap);
+        if (rc != 0)
+            return SMTP_TX_BROKEN;
+
+        char resp[HL_SMTP_RECV_BUF_SIZE];
+        for (int i = 0; i <= n_rcpt; i++) {
+            int code = smtp_read_response(s->fd, s->tls, resp,
+                                          (int)sizeof(resp), timeout_ms);
+            if (code < 0)
+                return SMTP_TX_BROKEN;
+            if (code != 250 && !rejected) {
+                log_warn("smtp: expected 250, got %d for %s", code,
+                         i == 0 ? "MAIL FROM" : "RCPT TO");
+                rejected = 1;
+            }
         }
+        return rejected ? smtp_reset(s, timeout_ms) : SMTP_TX_OK;
+    }
 
-        int msg_len = hl_smtp_format_message(msg, msg_buf, (int)msg_size);
-        if (msg_len < 0) {
-            kl_free(&alloc, msg_buf, msg_size);
-            log_warn("smtp: message formatting failed");
-            goto cleanup;
+    snprintf(cmd, sizeof(cmd), "MAIL FROM:<%s>\r\n", msg->from);
+    for (int i = -1; i < n_rcpt; i++) {
+        if (i >= 0)
+            snprintf(cmd, sizeof(cmd), "RCPT TO:<%s>\r\n",
+                     i == 0 ? msg->to : msg->cc[i - 1]);
+        int code = smtp_command(s->fd, s->tls, cmd, timeout_ms);
+        if (code < 0)
+            return SMTP_TX_BROKEN;
+        if (code != 250) {
+            log_warn("smtp: expected 250, got %d for command '%.20s'",
+                     code, cmd);
+            return smtp_reset(s, timeout_ms);
         }
+    }
+    return SMTP_TX_OK;
+}
 
-        /* Send formatted message */
-        if (smtp_send_raw(fd, tls, msg_buf, (size_t)msg_len, timeout_ms) != 0) {
-            kl_free(&alloc, msg_buf, msg_size);
-            goto cleanup;
-        }
+/*
+ * One mail transaction on an open session. *committed is set once the
+ * end-of-data marker may have reached the server: from then on a failure
+ * must not be retried, the message may have been delivered.
+ */
+static int smtp_transact(SmtpSession *s, const HlSmtpMessage *msg,
+                         int timeout_ms, int *committed)
+{
+    *committed = 0;
 
-        kl_free(&alloc, msg_buf, msg_size);
+    /* Format first so a bad message never leaves the session mid-DATA */
+    size_t body_len = strlen(msg->body);
+    size_t msg_size = body_len + 4096;  /* headers + dot-stuffing headroom */
+    if (msg_size > (size_t)HL_SMTP_MAX_MSG_SIZE)
+        msg_size = (size_t)HL_SMTP_MAX_MSG_SIZE;
+
+    KlAllocator alloc = kl_allocator_default();
+    char *msg_buf = kl_malloc(&alloc, msg_size);
+    if (!msg_buf) {
+        log_warn("smtp: message buffer allocation failed");
+        return SMTP_TX_REJECTED;
+    }
+
+    int rc;
+    int msg_len = hl_smtp_format_message(msg, msg_buf, (int)msg_size);
+    if (msg_len < 0) {
+        log_warn("smtp: message formatting failed");
+        rc = SMTP_TX_REJECTED;
+        goto done;
+    }
+
+    rc = smtp_envelope(s, msg, timeout_ms);
+    if (rc != SMTP_TX_OK)
+        goto done;
+
+    int code = smtp_command(s->fd, s->tls, "DATA\r\n", timeout_ms);
+    if (code != 354) {
+        log_warn("smtp: expected 354, got %d for command 'DATA'", code);
+        rc = code < 0 ? SMTP_TX_BROKEN : smtp_reset(s, timeout_ms);
+        goto done;
+    }
+
+    if (smtp_send_raw(s->fd, s->tls, msg_buf, (size_t)msg_len,
+                      timeout_ms) != 0) {
+        rc = SMTP_TX_BROKEN;
+        goto done;
     }
 
     /* End DATA with \r\n.\r\n */
-    code = smtp_send_command(fd, tls, ".\r\n", 250, timeout_ms);
-    if (code < 0)
-        goto cleanup;
+    *committed = 1;
+    code = smtp_command(s->fd, s->tls, ".\r\n", timeout_ms);
+    if (code < 0) {
+        rc = SMTP_TX_BROKEN;
+    } else if (code != 250) {
+        log_warn("smtp: message rejected with %d", code);
+        rc = SMTP_TX_REJECTED;
+    } else {
+        rc = SMTP_TX_OK;
+    }
+
+done:
+    kl_free(&alloc, msg_buf, msg_size);
+    return rc;
+}
 
-    /* QUIT */
-    smtp_send_command(fd, tls, "QUIT\r\n", 221, timeout_ms);
+/* ── Session pool ────────────────────────────────────────────────── */
 
-    ret = 0;
+HlSmtpPool *hl_smtp_pool_create(int idle_ms)
+{
+    HlSmtpPool *pool = calloc(1, sizeof(*pool));
+    if (!pool)
+        return NULL;
+    if (pthread_mutex_init(&pool->mu, NULL) != 0) {
+        free(pool);
+        return NULL;
+    }
+    pool->idle_ms = idle_ms;
+    for (int i = 0; i < HL_SMTP_POOL_SIZE; i++)
+        pool->sessions[i].fd = -1;
+    return pool;
+}
 
-cleanup:
-    if (tls) {
-        tls->shutdown(tls, fd);
-        tls->destroy(tls);
+void hl_smtp_pool_destroy(HlSmtpPool *pool)
+{
+    if (!pool)
+        return;
+    for (int i = 0; i < HL_SMTP_POOL_SIZE; i++)
+        session_close(&pool->sessions[i], 1, HL_SMTP_DEFAULT_TIMEOUT_MS);
+    pthread_mutex_destroy(&pool->mu);
+    free(pool);
+}
+
+/*
+ * Take a session for `key`: an idle pooled one for the same server and
+ * credentials, else a reserved empty slot (fd -1), else `local` when
+ * every slot is busy. Sessions idle past idle_ms are closed on the way.
+ */
+static SmtpSession *pool_acquire(HlSmtpPool *pool, const SmtpSession *key,
+                                 SmtpSession *local, int timeout_ms)
+{
+    SmtpSession expired[HL_SMTP_POOL_SIZE];
+    int n_expired = 0;
+    SmtpSession *found = NULL, *empty = NULL, *oldest = NULL;
+    uint64_t now = smtp_now_ms();
+
+    pthread_mutex_lock(&pool->mu);
+    for (int i = 0; i < HL_SMTP_POOL_SIZE; i++) {
+        SmtpSession *s = &pool->sessions[i];
+        if (s->in_use)
+            continue;
+        if (s->fd >= 0 && now - s->idle_since_ms >= (uint64_t)pool->idle_ms) {
+            expired[n_expired++] = *s;
+            s->fd = -1;
+            s->tls = NULL;
+        }
+        if (s->fd >= 0 && !found && session_matches(s, key))
+            found = s;
+        else if (s->fd < 0 && !empty)
+            empty = s;
+        else if (s->fd >= 0 && (!oldest || s->idle_since_ms < oldest->idle_since_ms))
+            oldest = s;
     }
-    close(fd);
 
-    {
+    if (!found) {
+        found = empty ? empty : oldest;
+        if (found && found->fd >= 0)
+            expired[n_expired++] = *found;   /* evict the least recent */
+        if (found)
+            *found = *key;
+    }
+    if (found)
+        found->in_use = 1;
+    pthread_mutex_unlock(&pool->mu);
+
+    for (int i = 0; i < n_expired; i++)
+        session_close(&expired[i], 1, timeout_ms);
+
+    if (!found) {
+        *local = *key;
+        found = local;
+    }
+    return found;
+}
+
+static void pool_release(HlSmtpPool *pool, SmtpSession *s)
+{
+    pthread_mutex_lock(&pool->mu);
+    s->in_use = 0;
+    s->idle_since_ms = smtp_now_ms();
+    pthread_mutex_unlock(&pool->mu);
+}
+
+/* ── Public API ──────────────────────────────────────────────────── */
+
+/* The session a send or batch currently holds */
+typedef struct {
+    const HlSmtpConfig *cfg;
+    int                 timeout_ms;
+    SmtpSession        *cur;
+    SmtpSession         local;     /* no pool, or every slot busy */
+} SmtpBatch;
+
+static void batch_release(SmtpBatch *b)
+{
+    SmtpSession *s = b->cur;
+    if (!s)
+        return;
+    b->cur = NULL;
+
+    if (s == &b->local || !b->cfg->pool) {
+        session_close(s, 1, b->timeout_ms);
+        return;
+    }
+    if (s->messages >= HL_SMTP_SESSION_MAX_MSGS)
+        session_close(s, 1, b->timeout_ms);
+    pool_release(b->cfg->pool, s);
+}
+
+static int batch_deliver(SmtpBatch *b, const HlSmtpMessage *msg)
+{
+    SmtpSession key;
+    session_key(&key, msg);
+
+    if (b->cur && (!session_matches(b->cur, &key) ||
+                   b->cur->messages >= HL_SMTP_SESSION_MAX_MSGS))
+        batch_release(b);
+
+    if (!b->cur) {
+        if (b->cfg->pool) {
+            b->cur = pool_acquire(b->cfg->pool, &key, &b->local,
+                                  b->timeout_ms);
+        } else {
+            b->local = key;
+            b->cur = &b->local;
+        }
+    }
+    SmtpSession *s = b->cur;
+
+    int reused = s->fd >= 0;
+    if (reused && session_stale(s)) {
+        session_close(s, 0, b->timeout_ms);
+        reused = 0;
+    }
+
+    for (;;) {
+        if (s->fd < 0 && session_open(s, b->cfg, msg, b->timeout_ms) != 0) {
+            batch_release(b);
+            return -1;
+        }
+
+        int committed;
+        int rc = smtp_transact(s, msg, b->timeout_ms, &committed);
+        if (rc == SMTP_TX_OK) {
+            s->messages++;
+            return 0;
+        }
+        if (rc == SMTP_TX_REJECTED)
+            return -1;
+
+        /* Broken connection: a reused one may have been dropped by the
+         * server while idle, so retry once on a fresh connection unless
+         * the message may already have been accepted */
+        session_close(s, 0, b->timeout_ms);
+        if (!reused || committed)
+            return -1;
+        reused = 0;
+    }
+}
+
+static void smtp_audit(const HlSmtpMessage *msg, int ret)
+{
+    ShJsonWriter w = hl_audit_begin("smtp.send");
+    sh_json_write_kv_string(&w, "host", msg->host);
+    sh_json_write_kv_string(&w, "from", msg->from);
+    sh_json_write_kv_string(&w, "to", msg->to);
+    sh_json_write_kv_string(&w, "subject", msg->subject);
+    sh_json_write_kv_int(&w, "result", ret);
+    hl_audit_end(&w);
+}
+
+static int smtp_send(SmtpBatch *b, const HlSmtpMessage *msg)
+{
+    /* Validate message fields */
+    if (smtp_validate_message(msg) != 0)
+        return -1;
+
+    /* Check host allowlist */
+    if (hl_smtp_check_host(b->cfg, msg->host) != 0) {
+        log_warn("smtp: host '%s' not in allowlist", msg->host);
         ShJsonWriter w = hl_audit_begin("smtp.send");
         sh_json_write_kv_string(&w, "host", msg->host);
         sh_json_write_kv_string(&w, "from", msg->from);
         sh_json_write_kv_string(&w, "to", msg->to);
-        sh_json_write_kv_string(&w, "subject", msg->subject);
-        sh_json_write_kv_int(&w, "result", ret);
+        sh_json_write_kv_string(&w, "result", "denied");
         hl_audit_end(&w);
+        return -1;
     }
+
+    int ret = batch_deliver(b, msg);
+    smtp_audit(msg, ret);
     return ret;
 }
+
+int hl_cap_smtp_send_many(const HlSmtpConfig *cfg, const HlSmtpMessage *msgs,
+                          int count, int *results)
+{
+    if (!cfg || !msgs || !results || count < 0)
+        return -1;
+
+    SmtpBatch b = {
+        .cfg = cfg,
+        .timeout_ms = cfg->timeout_ms > 0 ? cfg->timeout_ms
+                                          : HL_SMTP_DEFAULT_TIMEOUT_MS,
+    };
+
+    int delivered = 0;
+    for (int i = 0; i < count; i++) {
+        uint64_t t0 = hl_metrics_start();
+        results[i] = smtp_send(&b, &msgs[i]);
+        hl_metrics_cap_end(HL_METRIC_SMTP, t0, results[i]);
+        if (results[i] == 0)
+            delivered++;
+    }
+
+    batch_release(&b);
+    return delivered;
+}
+
+int hl_cap_smtp_send(const HlSmtpConfig *cfg, const HlSmtpMessage *msg)
+{
+    if (!cfg || !msg)
+        return -1;
+
+    int result;
+    hl_cap_smtp_send_many(cfg, msg, 1, &result);
+    return result;
+}
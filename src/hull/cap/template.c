@@ -0,0 +1,406 @@
+/*
+ * cap/template.c — Native template renderer
+ *
+ * Executes template bytecode emitted by hull.template / hull:template.
+ * Runtime-specific value access goes through HlTplOps; everything else
+ * (program validation, dispatch, output buffer, HTML escaping) is shared.
+ *
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#include "hull/cap/template.h"
+#include "hull/alloc.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+static const char *const filter_names[HL_TPL_F_COUNT] = {
+    [HL_TPL_F_UPPER]   = "upper",
+    [HL_TPL_F_LOWER]   = "lower",
+    [HL_TPL_F_TRIM]    = "trim",
+    [HL_TPL_F_LENGTH]  = "length",
+    [HL_TPL_F_DEFAULT] = "default",
+    [HL_TPL_F_JSON]    = "json",
+};
+
+const char *hl_tpl_filter_name(int id)
+{
+    if (id <= 0 || id >= HL_TPL_F_COUNT)
+        return NULL;
+    return filter_names[id];
+}
+
+/* ── Output buffer ──────────────────────────────────────────────────── */
+
+void hl_tpl_buf_init(HlTplBuf *b, HlAllocator *alloc)
+{
+    memset(b, 0, sizeof(*b));
+    b->alloc = alloc;
+}
+
+void hl_tpl_buf_free(HlTplBuf *b)
+{
+    if (b->data)
+        hl_alloc_free(b->alloc, b->data, b->cap);
+    b->data = NULL;
+    b->len = b->cap = 0;
+}
+
+static int buf_reserve(HlTplBuf *b, size_t extra)
+{
+    if (extra <= b->cap - b->len)
+        return 0;
+    if (extra > SIZE_MAX / 2 - b->len) {
+        b->oom = 1;
+        return -1;
+    }
+    size_t cap = b->cap ? b->cap : 1024;
+    while (cap - b->len < extra)
+        cap *= 2;
+    char *p = hl_alloc_realloc(b->alloc, b->data, b->cap, cap);
+    if (!p) {
+        b->oom = 1;
+        return -1;
+    }
+    b->data = p;
+    b->cap = cap;
+    return 0;
+}
+
+int hl_tpl_buf_append(HlTplBuf *b, const char *s, size_t n)
+{
+    if (n == 0)
+        return 0;
+    if (buf_reserve(b, n) != 0)
+        return -1;
+    memcpy(b->data + b->len, s, n);
+    b->len += n;
+    return 0;
+}
+
+/* ── HTML escaping ──────────────────────────────────────────────────── */
+
+/* 0 = plain, otherwise index into esc_repl */
+static const unsigned char esc_class[256] = {
+    ['&'] = 1, ['<'] = 2, ['>'] = 3, ['"'] = 4, ['\''] = 5, ['`'] = 6,
+};
+
+static const struct { const char *s; size_t n; } esc_repl[] = {
+    { "", 0 },
+    { "&amp;", 5 }, { "&lt;", 4 }, { "&gt;", 4 },
+    { "&quot;", 6 }, { "&#39;", 5 }, { "&#96;", 5 },
+};
+
+#define SWAR_ONES  0x0101010101010101ULL
+#define SWAR_HIGHS 0x8080808080808080ULL
+
+/* Nonzero if any byte of w equals c */
+static inline uint64_t swar_has(uint64_t w, unsigned char c)
+{
+    uint64_t x = w ^ (SWAR_ONES * c);
+    return (x - SWAR_ONES) & ~x & SWAR_HIGHS;
+}
+
+/* Length of the leading run of bytes that need no escaping. Scans 16
+ * bytes per step with SSE2 / NEON, 8 with SWAR otherwise; the exact
+ * position inside a hit block is found by the scalar tail. */
+static size_t scan_plain(const unsigned char *s, size_t n)
+{
+    size_t i = 0;
+
+#if defined(__SSE2__)
+    const __m128i amp = _mm_set1_epi8('&'), lt = _mm_set1_epi8('<');
+    const __m128i gt  = _mm_set1_epi8('>'), dq = _mm_set1_epi8('"');
+    const __m128i sq  = _mm_set1_epi8('\''), bt = _mm_set1_epi8('`');
+    for (; i + 16 <= n; i += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(const void *)(s + i));
+        __m128i m = _mm_or_si128(
+            _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, amp), _mm_cmpeq_epi8(v, lt)),
+                         _mm_or_si128(_mm_cmpeq_epi8(v, gt), _mm_cmpeq_epi8(v, dq))),
+            _mm_or_si128(_mm_cmpeq_epi8(v, sq), _mm_cmpeq_epi8(v, bt)));
+        int mask = _mm_movemask_epi8(m);
+        if (mask)
+            return i + (size_t)__builtin_ctz((unsigned)mask);
+    }
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+    const uint8x16_t amp = vdupq_n_u8('&'), lt = vdupq_n_u8('<');
+    const uint8x16_t gt  = vdupq_n_u8('>'), dq = vdupq_n_u8('"');
+    const uint8x16_t sq  = vdupq_n_u8('\''), bt = vdupq_n_u8('`');
+    for (; i + 16 <= n; i += 16) {
+        uint8x16_t v = vld1q_u8(s + i);
+        uint8x16_t m = vorrq_u8(
+            vorrq_u8(vorrq_u8(vceqq_u8(v, amp), vceqq_u8(v, lt)),
+                     vorrq_u8(vceqq_u8(v, gt), vceqq_u8(v, dq))),
+            vorrq_u8(vceqq_u8(v, sq), vceqq_u8(v, bt)));
+        if (vmaxvq_u8(m))
+            break;
+    }
+#endif
+
+    for (; i + 8 <= n; i += 8) {
+        uint64_t w;
+        memcpy(&w, s + i, 8);
+        if (swar_has(w, '&') | swar_has(w, '<') | swar_has(w, '>') |
+            swar_has(w, '"') | swar_has(w, '\'') | swar_has(w, '`'))
+            break;
+    }
+    while (i < n && !esc_class[s[i]])
+        i++;
+    return i;
+}
+
+int hl_tpl_buf_escape(HlTplBuf *b, const char *s, size_t n)
+{
+    const unsigned char *p = (const unsigned char *)s;
+
+    /* Most values need no escaping at all: one scan, one copy */
+    size_t run = scan_plain(p, n);
+    if (run == n)
+        return hl_tpl_buf_append(b, s, n);
+    if (buf_reserve(b, n + n / 8) != 0)
+        return -1;
+
+    while (n > 0) {
+        if (hl_tpl_buf_append(b, (const char *)p, run) != 0)
+            return -1;
+        if (run == n)
+            break;
+        unsigned char c = esc_class[p[run]];
+        if (hl_tpl_buf_append(b, esc_repl[c].s, esc_repl[c].n) != 0)
+            return -1;
+        p += run + 1;
+        n -= run + 1;
+        run = scan_plain(p, n);
+    }
+    return 0;
+}
+
+/* ── Programs ───────────────────────────────────────────────────────── */
+
+static inline uint16_t rd16(const uint8_t *p)
+{
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static inline uint32_t rd32(const uint8_t *p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) |
+           ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+/* Size of the instruction at pc (including opcode), 0 if truncated or
+ * unknown. Jump target, if any, is stored in *target. */
+static size_t insn_size(const uint8_t *code, size_t len, size_t pc,
+                        uint32_t *target)
+{
+    size_t avail = len - pc;
+    *target = UINT32_MAX;
+
+    switch (code[pc]) {
+    case HL_TPL_OP_END:
+        return 1;
+    case HL_TPL_OP_TEXT:
+        if (avail < 5) return 0;
+        return rd32(code + pc + 1) <= avail - 5 ? 5 + rd32(code + pc + 1) : 0;
+    case HL_TPL_OP_GET:
+        if (avail < 5) return 0;
+        return rd16(code + pc + 3) <= avail - 5 ? 5 + (size_t)rd16(code + pc + 3) : 0;
+    case HL_TPL_OP_STR:
+        if (avail < 6) return 0;
+        return rd32(code + pc + 2) <= avail - 6 ? 6 + rd32(code + pc + 2) : 0;
+    case HL_TPL_OP_NIL:
+        return avail >= 2 ? 2 : 0;
+    case HL_TPL_OP_FILTER:
+        return avail >= 5 ? 5 : 0;
+    case HL_TPL_OP_OUT:
+        return avail >= 3 ? 3 : 0;
+    case HL_TPL_OP_JMPF:
+    case HL_TPL_OP_JMPT:
+        if (avail < 6) return 0;
+        *target = rd32(code + pc + 2);
+        return 6;
+    case HL_TPL_OP_JMP:
+        if (avail < 5) return 0;
+        *target = rd32(code + pc + 1);
+        return 5;
+    case HL_TPL_OP_NEXT:
+        if (avail < 10) return 0;
+        *target = rd32(code + pc + 6);
+        return 10;
+    default:
+        return 0;
+    }
+}
+
+/* Register operands of the instruction at pc are all < nregs */
+static int insn_regs_ok(const uint8_t *ins, int nregs)
+{
+    const uint8_t *a = ins + 1;
+
+#define REG_OK(r)     ((int)(r) < nregs)
+#define OPT_REG_OK(r) ((r) == HL_TPL_NO_REG || REG_OK(r))
+
+    switch (ins[0]) {
+    case HL_TPL_OP_GET:
+        return REG_OK(a[0]) && REG_OK(a[1]);
+    case HL_TPL_OP_STR:
+    case HL_TPL_OP_NIL:
+    case HL_TPL_OP_JMPF:
+    case HL_TPL_OP_JMPT:
+        return REG_OK(a[0]);
+    case HL_TPL_OP_FILTER:
+        return hl_tpl_filter_name(a[0]) != NULL &&
+               REG_OK(a[1]) && REG_OK(a[2]) && OPT_REG_OK(a[3]);
+    case HL_TPL_OP_OUT:
+        return REG_OK(a[0]) && a[1] <= 1;
+    case HL_TPL_OP_NEXT:
+        return REG_OK(a[0]) && (int)a[1] + 1 < nregs && OPT_REG_OK(a[2]) &&
+               REG_OK(a[3]) && a[4] <= 1;
+    default:
+        return 1;
+    }
+
+#undef REG_OK
+#undef OPT_REG_OK
+}
+
+int hl_tpl_check(const uint8_t *code, size_t len)
+{
+    if (!code || len < HL_TPL_HEADER_SIZE + 1 ||
+        memcmp(code, HL_TPL_MAGIC, 4) != 0 || code[4] != HL_TPL_VERSION)
+        return -1;
+    int nregs = code[5];
+    if (nregs < 1 || nregs == HL_TPL_NO_REG || len > UINT32_MAX)
+        return -1;
+
+    /* Pass 1: instruction boundaries; pass 2: jump targets */
+    uint8_t *starts = calloc(len / 8 + 1, 1);
+    if (!starts)
+        return -1;
+
+    int rc = -1;
+    size_t pc = HL_TPL_HEADER_SIZE;
+    uint32_t target;
+    while (pc < len) {
+        size_t n = insn_size(code, len, pc, &target);
+        if (n == 0 || !insn_regs_ok(code + pc, nregs))
+            goto done;
+        starts[pc / 8] |= (uint8_t)(1u << (pc % 8));
+        if (code[pc] == HL_TPL_OP_END) {
+            /* END must be the last instruction */
+            if (pc + 1 != len)
+                goto done;
+        }
+        pc += n;
+    }
+    if (code[len - 1] != HL_TPL_OP_END || !(starts[(len - 1) / 8] & (1u << ((len - 1) % 8))))
+        goto done;
+
+    for (pc = HL_TPL_HEADER_SIZE; pc < len; ) {
+        size_t n = insn_size(code, len, pc, &target);
+        if (target != UINT32_MAX &&
+            (target < HL_TPL_HEADER_SIZE || target >= len ||
+             !(starts[target / 8] & (1u << (target % 8)))))
+            goto done;
+        pc += n;
+    }
+    rc = nregs;
+
+done:
+    free(starts);
+    return rc;
+}
+
+int hl_tpl_render(const uint8_t *code, const HlTplOps *ops, void *ud,
+                  HlTplBuf *out)
+{
+    const uint8_t *pc = code + HL_TPL_HEADER_SIZE;
+
+    for (;;) {
+        switch (*pc) {
+        case HL_TPL_OP_END:
+            return 0;
+
+        case HL_TPL_OP_TEXT: {
+            uint32_t n = rd32(pc + 1);
+            if (hl_tpl_buf_append(out, (const char *)pc + 5, n) != 0)
+                return -1;
+            pc += 5 + n;
+            break;
+        }
+
+        case HL_TPL_OP_GET: {
+            uint16_t n = rd16(pc + 3);
+            if (ops->get(ud, pc[1], pc[2], (const char *)pc + 5, n) != 0)
+                return -1;
+            pc += 5 + n;
+            break;
+        }
+
+        case HL_TPL_OP_STR: {
+            uint32_t n = rd32(pc + 2);
+            if (ops->set_str(ud, pc[1], (const char *)pc + 6, n) != 0)
+                return -1;
+            pc += 6 + n;
+            break;
+        }
+
+        case HL_TPL_OP_NIL:
+            if (ops->set_nil(ud, pc[1]) != 0)
+                return -1;
+            pc += 2;
+            break;
+
+        case HL_TPL_OP_FILTER: {
+            int arg = pc[4] == HL_TPL_NO_REG ? -1 : pc[4];
+            if (ops->filter(ud, pc[1], pc[2], pc[3], arg) != 0)
+                return -1;
+            pc += 5;
+            break;
+        }
+
+        case HL_TPL_OP_OUT:
+            if (ops->out(ud, pc[1], pc[2], out) != 0)
+                return -1;
+            pc += 3;
+            break;
+
+        case HL_TPL_OP_JMPF:
+        case HL_TPL_OP_JMPT: {
+            int t = ops->truthy(ud, pc[1]);
+            if (t < 0)
+                return -1;
+            if (t == (*pc == HL_TPL_OP_JMPT))
+                pc = code + rd32(pc + 2);
+            else
+                pc += 6;
+            break;
+        }
+
+        case HL_TPL_OP_JMP:
+            pc = code + rd32(pc + 1);
+            break;
+
+        case HL_TPL_OP_NEXT: {
+            int key = pc[3] == HL_TPL_NO_REG ? -1 : pc[3];
+            int more = ops->next(ud, pc[1], pc[2], key, pc[4], pc[5]);
+            if (more < 0)
+                return -1;
+            if (more)
+                pc += 10;
+            else
+                pc = code + rd32(pc + 6);
+            break;
+        }
+
+        default:
+            return -1;
+        }
+    }
+}
@@ -24,24 +24,15 @@
 #define TEST_ROUTER_KEY   "__hull_test_router"
 #define TEST_CASES_KEY    "__hull_test_cases"
 
+/* Upload routes get their body in chunks of this size, as off the wire */
+#define TEST_BODY_CHUNK   16384
+
 /* ── Shared C dispatch logic ───────────────────────────────────────── */
 
-/*
- * Build a KlRequest on the stack, match a route, dispatch the handler,
- * and return response info. Used by both Lua and JS bindings.
- */
-typedef struct {
-    int status;
-    const char *body;
-    size_t body_len;
-    const char *hdr_buf;
-    size_t hdr_len;
-} HlTestResult;
-
-static int test_dispatch(KlRouter *router, const char *method,
+int hl_cap_test_dispatch(KlRouter *router, const char *method,
                          const char *path, const char *body_data,
-                         size_t body_len, const char **header_names,
-                         const char **header_values, int num_headers,
+                         size_t body_len, const char *const *header_names,
+                         const char *const *header_values, int num_headers,
                          HlTestResult *result)
 {
     if (!router || !method || !path || !result) return -1;
@@ -112,7 +103,29 @@ static int test_dispatch(KlRouter *router, const char *method,
      * hl_cap_body_data() can cast and read .data/.len fields. */
     KlBufReader fake_buf;
     memset(&fake_buf, 0, sizeof(fake_buf));
-    if (body_data && body_len > 0) {
+    KlAllocator alloc = kl_allocator_default();
+    KlBodyReader *reader = NULL;
+    if (matched->body_reader) {
+        /* Upload route (stream/spool/blob): run its own reader over the
+         * body; a reader error is answered with 413 before the handler */
+        req.content_length = body_len;
+        reader = matched->body_reader(&alloc, &req, matched->user_data);
+        int ok = reader != NULL;
+        for (size_t off = 0; ok && off < body_len; off += TEST_BODY_CHUNK) {
+            size_t n = body_len - off < TEST_BODY_CHUNK
+                     ? body_len - off : TEST_BODY_CHUNK;
+            ok = reader->on_data(reader, body_data + off, n) == 0;
+        }
+        if (ok)
+            ok = reader->on_complete(reader) == 0;
+        if (!ok) {
+            if (reader)
+                reader->destroy(reader);
+            result->status = 413;
+            return 0;
+        }
+        req.body_reader = reader;
+    } else if (body_data && body_len > 0) {
         fake_buf.data = (char *)body_data;
         fake_buf.len = body_len;
         fake_buf.cap = body_len;
@@ -121,13 +134,18 @@ static int test_dispatch(KlRouter *router, const char *method,
     }
 
     /* Build response */
-    KlAllocator alloc = kl_allocator_default();
     KlResponse res;
-    if (kl_response_init(&res, &alloc) != 0) return -1;
+    if (kl_response_init(&res, &alloc) != 0) {
+        if (reader)
+            reader->destroy(reader);
+        return -1;
+    }
     res.conn_fd = -1; /* no actual connection */
 
     /* Dispatch handler */
     matched->handler(&req, &res, matched->user_data);
+    if (reader)
+        reader->destroy(reader);
 
     /* Extract results */
     result->status = res.status;
@@ -245,7 +263,7 @@ static int l_test_http(lua_State *L, const char *method)
     }
 
     HlTestResult result;
-    if (test_dispatch(router, method, path, body_str, body_len,
+    if (hl_cap_test_dispatch(router, method, path, body_str, body_len,
                       header_names, header_values, num_headers,
                       &result) != 0) {
         return luaL_error(L, "test dispatch failed");
@@ -570,7 +588,7 @@ static JSValue js_test_http(JSContext *ctx, const char *method,
     }
 
     HlTestResult result;
-    int rc = test_dispatch(state->router, method, path, body_str, body_len,
+    int rc = hl_cap_test_dispatch(state->router, method, path, body_str, body_len,
                            header_names, header_values, num_headers, &result);
 
     /* Free C strings */
@@ -35,6 +35,14 @@ int64_t hl_cap_time_clock(void)
     return (int64_t)ts.tv_sec * 1000 + (int64_t)ts.tv_nsec / 1000000;
 }
 
+int64_t hl_cap_time_clock_ns(void)
+{
+    struct timespec ts;
+    if (clock_gettime(CLOCK_MONOTONIC, &ts) != 0)
+        return -1;
+    return (int64_t)ts.tv_sec * 1000000000 + (int64_t)ts.tv_nsec;
+}
+
 int hl_cap_time_date(char *buf, size_t buf_size)
 {
     if (!buf || buf_size < 11)
@@ -17,6 +17,10 @@
 #include "lauxlib.h"
 #endif
 
+#if defined(HL_ENABLE_LUA) && defined(HL_ENABLE_JS)
+#include "quickjs.h"
+#endif
+
 #include <dirent.h>
 #include <errno.h>
 #include <fnmatch.h>
@@ -778,6 +782,128 @@ static int l_tool_loadfile(lua_State *L)
     return 1; /* chunk function on stack */
 }
 
+/* ── tool.compile_lua(source, chunkname) ───────────────────────────── */
+/*
+ * Precompile Lua source to a bytecode string for embedding as a
+ * "<name>.luac" VFS entry. Debug info is kept so runtime errors still
+ * carry line numbers. Returns bytecode, or nil + error message.
+ */
+
+typedef struct {
+    luaL_Buffer b;
+    int init;
+} ToolDumpState;
+
+static int tool_dump_writer(lua_State *L, const void *p, size_t sz, void *ud)
+{
+    ToolDumpState *st = (ToolDumpState *)ud;
+    if (!st->init) {
+        st->init = 1;
+        luaL_buffinit(L, &st->b);
+    }
+    luaL_addlstring(&st->b, (const char *)p, sz);
+    return 0;
+}
+
+static int l_tool_compile_lua(lua_State *L)
+{
+    size_t len;
+    const char *src = luaL_checklstring(L, 1, &len);
+    const char *chunkname = luaL_optstring(L, 2, "=chunk");
+
+    if (luaL_loadbufferx(L, src, len, chunkname, "t") != LUA_OK) {
+        lua_pushnil(L);
+        lua_insert(L, -2);
+        return 2;
+    }
+
+    ToolDumpState st;
+    st.init = 0;
+    /* Chunk function is at the top; the buffer grows above it. */
+    if (lua_dump(L, tool_dump_writer, &st, 0) != 0 || !st.init) {
+        lua_pushnil(L);
+        lua_pushstring(L, "failed to dump bytecode");
+        return 2;
+    }
+    luaL_pushresult(&st.b);
+    return 1;
+}
+
+/* ── tool.compile_js(source, module_name) ──────────────────────────── */
+/*
+ * Precompile an ES module to QuickJS bytecode for embedding as a
+ * "<name>.jsc" VFS entry. The module name is baked into the bytecode,
+ * so it must be the canonical runtime name (e.g. "./routes/users.js").
+ * Imports are not resolved at compile time. Returns bytecode, or
+ * nil + error message. Only available when the JS runtime is built in.
+ */
+
+#ifdef HL_ENABLE_JS
+/* Compiling a module resolves its imports; satisfy them with empty
+ * native modules — only the importing module is serialized. */
+static int tool_js_dummy_init(JSContext *ctx, JSModuleDef *m)
+{
+    (void)ctx;
+    (void)m;
+    return 0;
+}
+
+static JSModuleDef *tool_js_dummy_loader(JSContext *ctx, const char *name,
+                                         void *opaque)
+{
+    (void)opaque;
+    return JS_NewCModule(ctx, name, tool_js_dummy_init);
+}
+
+static int l_tool_compile_js(lua_State *L)
+{
+    size_t len;
+    /* Lua strings are NUL-terminated, which the QuickJS lexer requires */
+    const char *src = luaL_checklstring(L, 1, &len);
+    const char *name = luaL_checkstring(L, 2);
+
+    JSRuntime *rt = JS_NewRuntime();
+    JSContext *ctx = rt ? JS_NewContext(rt) : NULL;
+    if (!ctx) {
+        if (rt) JS_FreeRuntime(rt);
+        lua_pushnil(L);
+        lua_pushstring(L, "failed to create JS context");
+        return 2;
+    }
+    JS_SetModuleLoaderFunc(rt, NULL, tool_js_dummy_loader, NULL);
+
+    int nret;
+    JSValue mod = JS_Eval(ctx, src, len, name,
+                          JS_EVAL_TYPE_MODULE | JS_EVAL_FLAG_COMPILE_ONLY);
+    if (JS_IsException(mod)) {
+        JSValue exc = JS_GetException(ctx);
+        const char *msg = JS_ToCString(ctx, exc);
+        lua_pushnil(L);
+        lua_pushfstring(L, "%s: %s", name, msg ? msg : "compile error");
+        if (msg) JS_FreeCString(ctx, msg);
+        JS_FreeValue(ctx, exc);
+        nret = 2;
+    } else {
+        size_t bc_len = 0;
+        uint8_t *bc = JS_WriteObject(ctx, &bc_len, mod, JS_WRITE_OBJ_BYTECODE);
+        JS_FreeValue(ctx, mod);
+        if (bc) {
+            lua_pushlstring(L, (const char *)bc, bc_len);
+            js_free(ctx, bc);
+            nret = 1;
+        } else {
+            lua_pushnil(L);
+            lua_pushstring(L, "failed to write bytecode");
+            nret = 2;
+        }
+    }
+
+    JS_FreeContext(ctx);
+    JS_FreeRuntime(rt);
+    return nret;
+}
+#endif /* HL_ENABLE_JS */
+
 /* ── tool.extract_platform(dir) → bool ─────────────────────────────── */
 
 static int l_tool_extract_platform(lua_State *L)
@@ -888,6 +1014,10 @@ static const luaL_Reg tool_funcs[] = {
     { "file_exists",            l_tool_file_exists },
     { "stderr",                 l_tool_stderr },
     { "loadfile",               l_tool_loadfile },
+    { "compile_lua",            l_tool_compile_lua },
+#ifdef HL_ENABLE_JS
+    { "compile_js",             l_tool_compile_js },
+#endif
     { "extract_platform",       l_tool_extract_platform },
     { "extract_platform_cosmo", l_tool_extract_platform_cosmo },
     { "platform_archs",         l_tool_platform_archs },
@@ -0,0 +1,412 @@
+/*
+ * commands/bench.c — hull bench subcommand
+ *
+ * Replays a weighted request mix and reports throughput and latency
+ * percentiles as JSON. By default the app is loaded the way hull test
+ * loads it (migrated :memory: database, routes wired into a standalone
+ * KlRouter) and requests are dispatched in-process, one at a time, so
+ * the numbers cover routing, marshaling and handler work without TCP
+ * noise. Middleware does not run in this mode. With --url the same mix
+ * is sent to a running server over keep-alive connections instead.
+ *
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#include "hull/commands/bench.h"
+#include "hull/bench.h"
+#include "hull/cap/db.h"
+#include "hull/cap/test.h"
+#include "hull/migrate.h"
+#include "hull/vfs.h"
+
+#ifdef HL_ENABLE_LUA
+#include "hull/runtime/lua.h"
+#endif
+
+#ifdef HL_ENABLE_JS
+#include "hull/runtime/js.h"
+#endif
+
+#include <keel/router.h>
+#include <keel/allocator.h>
+
+#include <sqlite3.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/* ── Usage ─────────────────────────────────────────────────────────── */
+
+static void bench_usage(void)
+{
+    fprintf(stderr,
+            "Usage: hull bench [options] [app_dir]\n"
+            "\n"
+            "Replay a request mix in-process (default) or against a running\n"
+            "server (--url) and print throughput and latency as JSON.\n"
+            "\n"
+            "Options:\n"
+            "  -s FILE       Request mix script (JSON, see below)\n"
+            "  --method M    Single request method without -s (default: GET)\n"
+            "  --path P      Single request path without -s (default: /)\n"
+            "  -n N          Measured requests (default: 10000)\n"
+            "  -t SECONDS    Run for a duration instead of -n\n"
+            "  -w N          Warmup requests, not recorded (default: 100)\n"
+            "  -c N          Keep-alive connections with --url (default: 8)\n"
+            "  --url URL     Benchmark http://host:port over TCP instead\n"
+            "  --seed N      Seed for {{rand}} and the weighted pick (default: 1)\n"
+            "  -o FILE       Write the report to FILE instead of stdout\n"
+            "\n"
+            "Script:\n"
+            "  {\"requests\": [{\"method\": \"GET\", \"path\": \"/items/{{rand:100}}\",\n"
+            "                 \"weight\": 9},\n"
+            "                {\"method\": \"POST\", \"path\": \"/items\", \"weight\": 1,\n"
+            "                 \"headers\": {\"Content-Type\": \"application/json\"},\n"
+            "                 \"body\": \"{\\\"n\\\": {{seq}}}\"}]}\n"
+            "  Placeholders: {{seq}} {{conn}} {{rand}} {{rand:N}}\n");
+}
+
+/* ── Argument helpers ──────────────────────────────────────────────── */
+
+static int parse_u64(const char *s, uint64_t *out)
+{
+    char *end;
+    if (!s || !s[0] || s[0] == '-')
+        return -1;
+    unsigned long long v = strtoull(s, &end, 10);
+    if (*end != '\0')
+        return -1;
+    *out = v;
+    return 0;
+}
+
+/* http://host[:port][/...] → host (brackets stripped), port */
+static int parse_url(const char *url, char *host, size_t host_size, int *port)
+{
+    if (strncmp(url, "http://", 7) != 0)
+        return -1;
+    const char *h = url + 7;
+    const char *end;
+    const char *colon;
+
+    if (*h == '[') {
+        end = strchr(h, ']');
+        if (!end)
+            return -1;
+        h++;
+        colon = (end[1] == ':') ? end + 1 : NULL;
+    } else {
+        end = h + strcspn(h, ":/");
+        colon = (*end == ':') ? end : NULL;
+    }
+
+    size_t len = (size_t)(end - h);
+    if (len == 0 || len >= host_size)
+        return -1;
+    memcpy(host, h, len);
+    host[len] = '\0';
+
+    *port = 80;
+    if (colon) {
+        char *pend;
+        long p = strtol(colon + 1, &pend, 10);
+        if (p < 1 || p > 65535 || (*pend != '\0' && *pend != '/'))
+            return -1;
+        *port = (int)p;
+    }
+    return 0;
+}
+
+/* ── In-process runs ───────────────────────────────────────────────── */
+
+/* HlBenchDispatchFn over a router */
+static int router_dispatch(void *ctx, const HlBenchPrepared *req,
+                           size_t *bytes)
+{
+    HlTestResult r;
+    if (hl_cap_test_dispatch((KlRouter *)ctx, req->method, req->path,
+                             req->body, req->body_len,
+                             req->header_names, req->header_values,
+                             req->num_headers, &r) != 0)
+        return -1;
+    *bytes += r.body_len;
+    free((void *)r.body);
+    return r.status;
+}
+
+/* Database and VFS set up the way hull test does */
+typedef struct {
+    sqlite3    *db;
+    HlStmtCache stmt_cache;
+    HlVfs       app_vfs;
+    HlVfs       platform_vfs;
+} BenchEnv;
+
+static int env_open(BenchEnv *env, const char *app_dir)
+{
+    if (sqlite3_open(":memory:", &env->db) != SQLITE_OK) {
+        fprintf(stderr, "hull bench: cannot open :memory: database\n");
+        sqlite3_close(env->db);
+        return -1;
+    }
+    hl_cap_db_init(env->db);
+
+    extern const HlEntry hl_app_entries[];
+    extern const HlEntry hl_stdlib_entries[];
+    hl_vfs_init(&env->app_vfs, hl_app_entries, app_dir);
+    hl_vfs_init(&env->platform_vfs, hl_stdlib_entries, NULL);
+    hl_migrate_run(env->db, &env->app_vfs);
+    hl_stmt_cache_init(&env->stmt_cache, env->db);
+    return 0;
+}
+
+static void env_close(BenchEnv *env)
+{
+    hl_stmt_cache_destroy(&env->stmt_cache);
+    hl_cap_db_shutdown(env->db);
+    sqlite3_close(env->db);
+}
+
+#ifdef HL_ENABLE_LUA
+
+static int bench_lua(const char *app_dir, const char *entry,
+                     const HlBenchScript *s, const HlBenchConfig *cfg,
+                     HlBenchStats *st)
+{
+    BenchEnv env;
+    if (env_open(&env, app_dir) != 0)
+        return -1;
+
+    HlLuaConfig lcfg = HL_LUA_CONFIG_DEFAULT;
+    lcfg.sandbox = 1;
+    HlLua lua;
+    memset(&lua, 0, sizeof(lua));
+    lua.base.db = env.db;
+    lua.base.stmt_cache = &env.stmt_cache;
+    lua.base.app_vfs = &env.app_vfs;
+    lua.base.platform_vfs = &env.platform_vfs;
+
+    int rc = -1;
+    if (hl_lua_init(&lua, &lcfg) != 0) {
+        fprintf(stderr, "hull bench: Lua init failed\n");
+        env_close(&env);
+        return -1;
+    }
+
+    KlAllocator alloc = kl_allocator_default();
+    KlRouter router;
+    kl_router_init(&router, &alloc);
+
+    if (hl_lua_load_app(&lua, entry) != 0)
+        fprintf(stderr, "hull bench: failed to load %s\n", entry);
+    else if (hl_lua_wire_routes(&lua, &router) != 0)
+        fprintf(stderr, "hull bench: no routes registered\n");
+    else
+        rc = hl_bench_run_inprocess(s, cfg, router_dispatch, &router, st);
+
+    kl_router_free(&router);
+    hl_lua_free(&lua);
+    env_close(&env);
+    return rc;
+}
+
+#endif /* HL_ENABLE_LUA */
+
+#ifdef HL_ENABLE_JS
+
+static int bench_js(const char *app_dir, const char *entry,
+                    const HlBenchScript *s, const HlBenchConfig *cfg,
+                    HlBenchStats *st)
+{
+    BenchEnv env;
+    if (env_open(&env, app_dir) != 0)
+        return -1;
+
+    HlJSConfig jcfg = HL_JS_CONFIG_DEFAULT;
+    HlJS js;
+    memset(&js, 0, sizeof(js));
+    js.base.db = env.db;
+    js.base.stmt_cache = &env.stmt_cache;
+    js.base.app_vfs = &env.app_vfs;
+    js.base.platform_vfs = &env.platform_vfs;
+
+    int rc = -1;
+    if (hl_js_init(&js, &jcfg) != 0) {
+        fprintf(stderr, "hull bench: QuickJS init failed\n");
+        env_close(&env);
+        return -1;
+    }
+
+    KlAllocator alloc = kl_allocator_default();
+    KlRouter router;
+    kl_router_init(&router, &alloc);
+
+    if (hl_js_load_app(&js, entry) != 0)
+        fprintf(stderr, "hull bench: failed to load %s\n", entry);
+    else if (hl_js_wire_routes(&js, &router) != 0)
+        fprintf(stderr, "hull bench: no routes registered\n");
+    else
+        rc = hl_bench_run_inprocess(s, cfg, router_dispatch, &router, st);
+
+    kl_router_free(&router);
+    hl_js_free(&js);
+    env_close(&env);
+    return rc;
+}
+
+#endif /* HL_ENABLE_JS */
+
+/* app.js or app.lua in app_dir, JS first as hull dev does */
+static const char *detect_entry(const char *app_dir, int *is_js)
+{
+    static char buf[4096];
+#ifdef HL_ENABLE_JS
+    snprintf(buf, sizeof(buf), "%s/app.js", app_dir);
+    if (access(buf, F_OK) == 0) {
+        *is_js = 1;
+        return buf;
+    }
+#endif
+#ifdef HL_ENABLE_LUA
+    snprintf(buf, sizeof(buf), "%s/app.lua", app_dir);
+    if (access(buf, F_OK) == 0) {
+        *is_js = 0;
+        return buf;
+    }
+#endif
+    (void)app_dir;
+    (void)is_js;
+    return NULL;
+}
+
+/* ── Command entry point ───────────────────────────────────────────── */
+
+int hl_cmd_bench(int argc, char **argv, const char *hull_exe)
+{
+    (void)hull_exe;
+
+    const char *app_dir = ".";
+    const char *script_path = NULL;
+    const char *method = "GET";
+    const char *path = "/";
+    const char *url = NULL;
+    const char *out_path = NULL;
+    HlBenchConfig cfg = { .requests = 10000, .warmup = 100,
+                          .connections = 8, .seed = 1 };
+
+    for (int i = 1; i < argc; i++) {
+        const char *a = argv[i];
+        const char *val = (i + 1 < argc) ? argv[i + 1] : NULL;
+        uint64_t n;
+        int takes = 1;
+
+        if (strcmp(a, "-h") == 0 || strcmp(a, "--help") == 0) {
+            bench_usage();
+            return 0;
+        } else if (strcmp(a, "-s") == 0 && val) {
+            script_path = val;
+        } else if (strcmp(a, "--method") == 0 && val) {
+            method = val;
+        } else if (strcmp(a, "--path") == 0 && val) {
+            path = val;
+        } else if (strcmp(a, "--url") == 0 && val) {
+            url = val;
+        } else if (strcmp(a, "-o") == 0 && val) {
+            out_path = val;
+        } else if (strcmp(a, "-n") == 0 && parse_u64(val, &n) == 0 && n > 0) {
+            cfg.requests = n;
+        } else if (strcmp(a, "-t") == 0 && parse_u64(val, &n) == 0 &&
+                   n > 0 && n <= 86400) {
+            cfg.duration_ms = (int)n * 1000;
+        } else if (strcmp(a, "-w") == 0 && parse_u64(val, &n) == 0) {
+            cfg.warmup = n;
+        } else if (strcmp(a, "-c") == 0 && parse_u64(val, &n) == 0 &&
+                   n > 0 && n <= HL_BENCH_MAX_CONNS) {
+            cfg.connections = (int)n;
+        } else if (strcmp(a, "--seed") == 0 && parse_u64(val, &n) == 0 && n > 0) {
+            cfg.seed = n;
+        } else if (a[0] != '-') {
+            app_dir = a;
+            takes = 0;
+        } else {
+            fprintf(stderr, "hull bench: invalid option or value: %s%s%s\n",
+                    a, val ? " " : "", val ? val : "");
+            bench_usage();
+            return 1;
+        }
+        i += takes;
+    }
+
+    char err[256] = "";
+    HlBenchScript script;
+    if (script_path) {
+        if (hl_bench_script_load(&script, script_path, err, sizeof(err)) != 0) {
+            fprintf(stderr, "hull bench: %s: %s\n", script_path, err);
+            return 1;
+        }
+    } else {
+        if (path[0] != '/') {
+            fprintf(stderr, "hull bench: --path must start with /\n");
+            return 1;
+        }
+        hl_bench_script_single(&script, method, path);
+    }
+
+    HlBenchStats st;
+    if (hl_bench_stats_init(&st, script.count) != 0) {
+        fprintf(stderr, "hull bench: out of memory\n");
+        hl_bench_script_free(&script);
+        return 1;
+    }
+
+    int rc = -1;
+    const char *mode = url ? "loopback" : "inprocess";
+    const char *target = url ? url : app_dir;
+    int conns = url ? cfg.connections : 1;
+
+    if (url) {
+        char host[256];
+        int port;
+        if (parse_url(url, host, sizeof(host), &port) != 0)
+            fprintf(stderr, "hull bench: --url must be http://host[:port]\n");
+        else if (hl_bench_run_loopback(&script, &cfg, host, port, &st,
+                                       err, sizeof(err)) != 0)
+            fprintf(stderr, "hull bench: %s: %s\n", url, err);
+        else
+            rc = 0;
+    } else {
+        int is_js = 0;
+        const char *entry = detect_entry(app_dir, &is_js);
+        if (!entry) {
+            fprintf(stderr, "hull bench: no entry point found (app.js or "
+                    "app.lua) in %s\n", app_dir);
+        } else {
+#ifdef HL_ENABLE_LUA
+            if (!is_js)
+                rc = bench_lua(app_dir, entry, &script, &cfg, &st);
+#endif
+#ifdef HL_ENABLE_JS
+            if (is_js)
+                rc = bench_js(app_dir, entry, &script, &cfg, &st);
+#endif
+        }
+    }
+
+    if (rc == 0) {
+        FILE *out = out_path ? fopen(out_path, "w") : stdout;
+        if (!out) {
+            fprintf(stderr, "hull bench: cannot write %s\n", out_path);
+            rc = -1;
+        } else {
+            rc = hl_bench_report(out, &script, &st, mode, target, conns);
+            if (out != stdout)
+                fclose(out);
+        }
+    }
+
+    hl_bench_stats_free(&st);
+    hl_bench_script_free(&script);
+    return rc == 0 ? 0 : 1;
+}
@@ -1,8 +1,12 @@
 /*
  * commands/dev.c — hull dev: hot-reload development server
  *
- * Forks a child process running the hull server, monitors app files
- * for changes (by polling max mtime), and restarts on change.
+ * Forks a child process running the hull server and watches the app
+ * directory (inotify/kqueue, see watch.h). A code change is applied in
+ * the running child through its reload endpoint (see reload.h): the
+ * socket, database and open connections survive. Migrations, route or
+ * manifest changes, TLS mode and a child that cannot be reached fall
+ * back to restarting the child.
  *
  * Pure C — no Lua VM needed.
  *
@@ -10,14 +14,20 @@
  */
 
 #include "hull/commands/dev.h"
+#include "hull/limits.h"
+#include "hull/reload.h"
+#include "hull/watch.h"
 
-#include <dirent.h>
 #include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
 #include <signal.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/socket.h>
 #include <sys/stat.h>
+#include <sys/time.h>
 #include <sys/wait.h>
 #include <time.h>
 #include <unistd.h>
@@ -63,60 +73,91 @@ static void dev_signal_handler(int sig)
         kill(dev_child_pid, SIGTERM);
 }
 
-/* ── File mtime scanning ──────────────────────────────────────────── */
+/* ── In-process reload ────────────────────────────────────────────── */
 
-static int should_skip(const char *name)
+/* Random hex token so only this parent can trigger the child's reload */
+static void dev_make_token(char *out, size_t out_size)
 {
-    if (name[0] == '.') return 1;
-    if (strcmp(name, "node_modules") == 0) return 1;
-    if (strcmp(name, "vendor") == 0) return 1;
-    if (strcmp(name, "build") == 0) return 1;
-    return 0;
-}
+    unsigned char raw[16];
+    int fd = open("/dev/urandom", O_RDONLY | O_CLOEXEC);
+    if (fd < 0 || read(fd, raw, sizeof(raw)) != (ssize_t)sizeof(raw)) {
+        unsigned long seed = (unsigned long)time(NULL) ^ ((unsigned long)getpid() << 16);
+        for (size_t i = 0; i < sizeof(raw); i++) {
+            seed = seed * 6364136223846793005UL + 1442695040888963407UL;
+            raw[i] = (unsigned char)(seed >> 56);
+        }
+    }
+    if (fd >= 0)
+        close(fd);
 
-static int is_app_file(const char *name)
-{
-    size_t len = strlen(name);
-    if (len > 4 && strcmp(name + len - 4, ".lua") == 0) return 1;
-    if (len > 3 && strcmp(name + len - 3, ".js") == 0) return 1;
-    if (len > 5 && strcmp(name + len - 5, ".html") == 0) return 1;
-    return 0;
+    size_t n = 0;
+    for (size_t i = 0; i < sizeof(raw) && n + 3 <= out_size; i++)
+        n += (size_t)snprintf(out + n, out_size - n, "%02x", raw[i]);
 }
 
 /*
- * Recursively scan a directory for .lua/.js files and return the
- * maximum mtime found. Returns 0 if no files found.
+ * POST the reload endpoint of the child listening on host:port.
+ * Returns the HTTP status, or -1 if the child could not be reached.
  */
-static time_t scan_mtime(const char *dir)
+static int dev_request_reload(const char *host, int port, const char *token)
 {
-    DIR *d = opendir(dir);
-    if (!d) return 0;
-
-    time_t max_mt = 0;
-    struct dirent *ent;
-    while ((ent = readdir(d)) != NULL) {
-        if (ent->d_name[0] == '.') continue;
-        if (should_skip(ent->d_name)) continue;
-
-        char path[PATH_MAX];
-        size_t dlen = strlen(dir);
-        size_t nlen = strlen(ent->d_name);
-        if (dlen + 1 + nlen + 1 > PATH_MAX) continue;
-        snprintf(path, sizeof(path), "%s/%s", dir, ent->d_name);
-
-        struct stat st;
-        if (lstat(path, &st) != 0) continue;
-
-        if (S_ISDIR(st.st_mode)) {
-            time_t sub = scan_mtime(path);
-            if (sub > max_mt) max_mt = sub;
-        } else if (S_ISREG(st.st_mode) && is_app_file(ent->d_name)) {
-            if (st.st_mtime > max_mt) max_mt = st.st_mtime;
-        }
+    /* The child may listen on a wildcard address; reach it via loopback */
+    if (!host || strcmp(host, "0.0.0.0") == 0)
+        host = "127.0.0.1";
+    else if (strcmp(host, "::") == 0)
+        host = "::1";
+
+    char port_str[8];
+    snprintf(port_str, sizeof(port_str), "%d", port);
+    struct addrinfo hints, *res = NULL;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_flags = AI_NUMERICSERV;
+    if (getaddrinfo(host, port_str, &hints, &res) != 0 || !res)
+        return -1;
+
+    int fd = socket(res->ai_family, res->ai_socktype | SOCK_CLOEXEC, res->ai_protocol);
+    if (fd < 0) {
+        freeaddrinfo(res);
+        return -1;
+    }
+    struct timeval tv = { HL_DEV_RELOAD_TIMEOUT_MS / 1000, 0 };
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+    int rc = connect(fd, res->ai_addr, res->ai_addrlen);
+    freeaddrinfo(res);
+    if (rc != 0) {
+        close(fd);
+        return -1;
     }
 
-    closedir(d);
-    return max_mt;
+    char req[256];
+    int n = snprintf(req, sizeof(req),
+                     "POST " HL_RELOAD_PATH " HTTP/1.1\r\n"
+                     "Host: localhost\r\n"
+                     HL_RELOAD_HEADER ": %s\r\n"
+                     "Content-Length: 0\r\n"
+                     "Connection: close\r\n\r\n", token);
+    if (n <= 0 || write(fd, req, (size_t)n) != n) {
+        close(fd);
+        return -1;
+    }
+
+    /* Only the status line matters: "HTTP/1.1 200 ..." */
+    char buf[32];
+    size_t got = 0;
+    while (got < sizeof(buf) - 1) {
+        ssize_t r = read(fd, buf + got, sizeof(buf) - 1 - got);
+        if (r <= 0)
+            break;
+        got += (size_t)r;
+    }
+    close(fd);
+    buf[got] = '\0';
+
+    if (got < 12 || strncmp(buf, "HTTP/1.", 7) != 0)
+        return -1;
+    return atoi(buf + 9);
 }
 
 /*
@@ -151,8 +192,10 @@ static const char *dev_detect_entry(void)
 int hl_cmd_dev(int argc, char **argv, const char *hull_exe)
 {
     const char *entry_point = NULL;
+    const char *bind_addr = NULL;
     int agent_mode = 0;
     int port = 3000;
+    int tls = 0;
 
     /* Parse args: first positional is the entry point, rest are passthrough */
     for (int i = 1; i < argc; i++) {
@@ -177,6 +220,10 @@ int hl_cmd_dev(int argc, char **argv, const char *hull_exe)
                 if (*end == '\0' && p > 0 && p <= 65535)
                     port = (int)p;
             }
+            if (strcmp(argv[i], "-b") == 0)
+                bind_addr = argv[i + 1];
+            if (strcmp(argv[i], "--tls-cert") == 0)
+                tls = 1;
             i++; /* skip value, will be collected below */
         }
     }
@@ -218,7 +265,23 @@ int hl_cmd_dev(int argc, char **argv, const char *hull_exe)
     sigaction(SIGINT, &sa, NULL);
     sigaction(SIGTERM, &sa, NULL);
 
-    fprintf(stderr, "[hull:dev] watching %s for changes...\n", app_dir);
+    HlWatch watch;
+    if (hl_watch_open(&watch, app_dir) != 0) {
+        fprintf(stderr, "hull dev: allocation failed\n");
+        free(child_argv);
+        return 1;
+    }
+
+    /* The child serves the reload endpoint only with this token. The
+     * parent cannot speak TLS, so TLS dev servers always restart. */
+    char token[33] = "";
+    if (!tls) {
+        dev_make_token(token, sizeof(token));
+        setenv(HL_RELOAD_ENV, token, 1);
+    }
+
+    fprintf(stderr, "[hull:dev] watching %s for changes (%s)...\n",
+            app_dir, watch.backend);
 
     if (agent_mode)
         agent_ensure_dir(app_dir);
@@ -252,10 +315,7 @@ int hl_cmd_dev(int argc, char **argv, const char *hull_exe)
         if (agent_mode)
             agent_write_dev_json(app_dir, port, pid);
 
-        /* Record baseline mtime */
-        time_t baseline = scan_mtime(app_dir);
-
-        /* Poll for changes or child exit */
+        /* Wait for changes or child exit */
         int child_exited = 0;
         int change_detected = 0;
 
@@ -278,18 +338,35 @@ int hl_cmd_dev(int argc, char **argv, const char *hull_exe)
                 break;
             }
 
-            /* Sleep 1 second between polls */
-            struct timespec ts = { .tv_sec = 1, .tv_nsec = 0 };
-            nanosleep(&ts, NULL);
-
-            /* Check for file changes */
-            time_t current = scan_mtime(app_dir);
-            if (current > baseline) {
-                change_detected = 1;
-                fprintf(stderr, "[hull:dev] change detected, reloading...\n");
-                kill(pid, SIGTERM);
-                waitpid(pid, NULL, 0);
+            int change = hl_watch_wait(&watch, 250, HL_WATCH_DEBOUNCE_MS);
+            if (change < 0) {
+                fprintf(stderr, "[hull:dev] watch failed: %s\n", strerror(errno));
+                struct timespec ts = { .tv_sec = 1, .tv_nsec = 0 };
+                nanosleep(&ts, NULL);
+                continue;
+            }
+            if (change == HL_WATCH_NONE)
+                continue;
+
+            if (change == HL_WATCH_CODE && token[0]) {
+                int code = dev_request_reload(bind_addr, port, token);
+                if (code == 200) {
+                    fprintf(stderr, "[hull:dev] change detected, reloaded\n");
+                    continue;
+                }
+                /* Load error: keep the old code serving until the next
+                 * save. Agents restart instead to get last_error.json. */
+                if (code == 500 && !agent_mode) {
+                    fprintf(stderr, "[hull:dev] reload failed, still serving "
+                            "the previous version\n");
+                    continue;
+                }
             }
+
+            change_detected = 1;
+            fprintf(stderr, "[hull:dev] change detected, restarting...\n");
+            kill(pid, SIGTERM);
+            waitpid(pid, NULL, 0);
         }
 
         dev_child_pid = 0;
@@ -309,6 +386,7 @@ int hl_cmd_dev(int argc, char **argv, const char *hull_exe)
     if (agent_mode)
         agent_remove_dev_json(app_dir);
 
+    hl_watch_close(&watch);
     free(child_argv);
     return ret;
 }
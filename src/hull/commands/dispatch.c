@@ -20,6 +20,7 @@
 #include "hull/commands/migrate.h"
 #include "hull/commands/sign_platform.h"
 #include "hull/commands/agent.h"
+#include "hull/commands/bench.h"
 
 #include <string.h>
 
@@ -38,6 +39,7 @@ static const HlCommand commands[] = {
     { "sign-platform", hl_cmd_sign_platform },
     { "migrate",       hl_cmd_migrate },
     { "agent",         hl_cmd_agent },
+    { "bench",         hl_cmd_bench },
     { NULL, NULL }  /* sentinel */
 };
 
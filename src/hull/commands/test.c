@@ -4,14 +4,27 @@
  * In-process test runner: discovers test files, loads app,
  * wires routes, executes tests with assertions.
  *
+ * The loaded runtime acts as a zygote: each test file runs in a child
+ * forked from it, so files start from the same post-load state (routes,
+ * migrated :memory: database) without paying for a fresh runtime, and
+ * cannot leak globals or rows into each other. -j N runs up to N files
+ * at once, capturing each child's output and printing it in file order.
+ * --no-fork runs all files in the one process instead; the database is
+ * then restored from a snapshot taken after load (SQLite backup API)
+ * before each file, so rows still do not leak between files.
+ *
  * SPDX-License-Identifier: AGPL-3.0-or-later
  */
 
 #include "hull/commands/test.h"
 #include "hull/cap/db.h"
+#include "hull/cap/time.h"
 #include "hull/cap/tool.h"
+#include "hull/limits.h"
+#include "hull/manifest.h"
 #include "hull/migrate.h"
 #include "hull/vfs.h"
+#include "hull/zygote.h"
 
 #ifdef HL_ENABLE_LUA
 #include "hull/runtime/lua.h"
@@ -32,6 +45,7 @@
 #include <sqlite3.h>
 #include <sh_arena.h>
 
+#include <poll.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -41,16 +55,315 @@
 
 static void test_usage(void)
 {
-    fprintf(stderr, "Usage: hull test [app_dir]\n"
+    fprintf(stderr, "Usage: hull test [-j N] [--no-fork] [app_dir]\n"
+            "\n"
+            "Discovers and runs test_*.[lua|js] files.\n"
             "\n"
-            "Discovers and runs test_*.[lua|js] files.\n");
+            "Options:\n"
+            "  -j N        Run up to N test files in parallel (0 = one per CPU)\n"
+            "  --no-fork   Run all test files in one process (no per-file isolation)\n");
+}
+
+/* ── Per-file isolation ────────────────────────────────────────────── */
+
+typedef struct {
+    int total;
+    int passed;
+    int failed;
+} TestCounts;
+
+/* One test file for a runtime's HlZygoteFn; rt is the HlLua / HlJS */
+typedef struct {
+    void       *rt;
+    const char *file;
+} TestFile;
+
+typedef struct {
+    int      isolate;   /* fork a child per file */
+    int      jobs;      /* files run at once (isolate only) */
+    sqlite3 *db;        /* test database, restored between in-process files */
+} TestOptions;
+
+static const char *base_name(const char *path)
+{
+    const char *slash = strrchr(path, '/');
+    return slash ? slash + 1 : path;
+}
+
+static void count_error(TestCounts *out)
+{
+    out->total = 1;
+    out->passed = 0;
+    out->failed = 1;
+}
+
+/* Copy src's main database over dst's (SQLite online backup) */
+static int copy_db(sqlite3 *dst, sqlite3 *src)
+{
+    sqlite3_backup *b = sqlite3_backup_init(dst, "main", src, "main");
+    if (!b)
+        return -1;
+    int rc = sqlite3_backup_step(b, -1);
+    sqlite3_backup_finish(b);
+    return rc == SQLITE_DONE ? 0 : -1;
+}
+
+/*
+ * Run one test file via fn, in a child forked from the warm runtime when
+ * `isolate` is set. Falls back to in-process if fork is unavailable.
+ * SQLite connections must not be used across fork() for on-disk
+ * databases; the test database is :memory: and the parent does not touch
+ * it while a child runs. In-process runs start from `tmpl`, the database
+ * as it was after migrations and app load.
+ */
+static void run_test_file(HlZygoteFn fn, void *ctx, int isolate,
+                          sqlite3 *db, sqlite3 *tmpl, TestCounts *out)
+{
+    memset(out, 0, sizeof(*out));
+    if (isolate) {
+        int rc = hl_zygote_run(fn, ctx, out, sizeof(*out));
+        if (rc >= 0)
+            return;
+        if (rc == -1) {
+            fprintf(stderr, "  ERROR: test process exited abnormally\n");
+            count_error(out);
+            return;
+        }
+        /* rc == -2: could not fork — run in-process */
+        memset(out, 0, sizeof(*out));
+    }
+    if (tmpl && copy_db(db, tmpl) != 0)
+        fprintf(stderr, "  WARN: could not reset test database: %s\n",
+                sqlite3_errmsg(db));
+    fn(ctx, out, sizeof(*out));
+}
+
+/* ── Parallel files (-j) ───────────────────────────────────────────── */
+
+/* Child side of a parallel file: output goes to the slot's capture file */
+typedef struct {
+    HlZygoteFn fn;
+    TestFile   tf;
+    int        out_fd;
+} CapturedFile;
+
+static int captured_test_file(void *ctx, void *result, size_t result_size)
+{
+    CapturedFile *cf = ctx;
+    dup2(cf->out_fd, STDOUT_FILENO);
+    dup2(cf->out_fd, STDERR_FILENO);
+    return cf->fn(&cf->tf, result, result_size);
+}
+
+typedef struct {
+    HlZygoteChild child;
+    FILE         *out;      /* captured stdout + stderr */
+    TestCounts    counts;
+    int           state;    /* 0 pending, 1 running, 2 done */
+} TestSlot;
+
+static void start_slot(TestSlot *slot, HlZygoteFn fn, void *rt,
+                       const char *file)
+{
+    slot->out = tmpfile();
+    if (slot->out) {
+        CapturedFile cf = {
+            .fn = fn, .tf = { .rt = rt, .file = file },
+            .out_fd = fileno(slot->out),
+        };
+        if (hl_zygote_spawn(&slot->child, captured_test_file, &cf,
+                            sizeof(slot->counts)) == 0) {
+            slot->state = 1;
+            return;
+        }
+    }
+    fprintf(stderr, "  ERROR: cannot start test process for %s\n", file);
+    count_error(&slot->counts);
+    slot->state = 2;
+}
+
+static void finish_slot(TestSlot *slot)
+{
+    if (hl_zygote_wait(&slot->child, &slot->counts,
+                       sizeof(slot->counts)) < 0) {
+        memset(&slot->counts, 0, sizeof(slot->counts));
+        if (slot->out)
+            fputs("  ERROR: test process exited abnormally\n", slot->out);
+        count_error(&slot->counts);
+    }
+    slot->state = 2;
+}
+
+static void print_slot(TestSlot *slot, const char *file)
+{
+    printf("\n--- %s ---\n", base_name(file));
+    if (slot->out) {
+        char buf[4096];
+        size_t n;
+        fflush(slot->out);
+        rewind(slot->out);
+        while ((n = fread(buf, 1, sizeof(buf), slot->out)) > 0)
+            fwrite(buf, 1, n, stdout);
+        fclose(slot->out);
+        slot->out = NULL;
+    }
+    fflush(stdout);
+}
+
+/*
+ * Up to `jobs` children at a time, each forked from the warm runtime.
+ * Output is printed in file order as soon as every earlier file is done.
+ */
+static void run_parallel(char **files, size_t n, HlZygoteFn fn, void *rt,
+                         int jobs, TestCounts *sum)
+{
+    TestSlot *slots = calloc(n, sizeof(*slots));
+    struct pollfd *pfds = calloc((size_t)jobs, sizeof(*pfds));
+    size_t *idx = calloc((size_t)jobs, sizeof(*idx));
+    if (!slots || !pfds || !idx) {
+        fprintf(stderr, "hull test: out of memory\n");
+        count_error(sum);
+        free(slots);
+        free(pfds);
+        free(idx);
+        return;
+    }
+
+    size_t next = 0, printed = 0;
+    int running = 0;
+    while (printed < n) {
+        while (running < jobs && next < n) {
+            start_slot(&slots[next], fn, rt, files[next]);
+            if (slots[next].state == 1)
+                running++;
+            next++;
+        }
+
+        if (running > 0) {
+            int np = 0;
+            for (size_t i = printed; i < next; i++) {
+                if (slots[i].state == 1) {
+                    pfds[np].fd = slots[i].child.fd;
+                    pfds[np].events = POLLIN;
+                    pfds[np].revents = 0;
+                    idx[np++] = i;
+                }
+            }
+            if (poll(pfds, (nfds_t)np, -1) > 0) {
+                for (int p = 0; p < np; p++) {
+                    if (pfds[p].revents) {
+                        finish_slot(&slots[idx[p]]);
+                        running--;
+                    }
+                }
+            }
+        }
+
+        while (printed < n && slots[printed].state == 2) {
+            print_slot(&slots[printed], files[printed]);
+            sum->total += slots[printed].counts.total;
+            sum->passed += slots[printed].counts.passed;
+            sum->failed += slots[printed].counts.failed;
+            printed++;
+        }
+    }
+
+    free(slots);
+    free(pfds);
+    free(idx);
+}
+
+/*
+ * Run every file in `files` (NULL-terminated, freed here) against the
+ * loaded runtime rt and print the summary. Returns 1 if anything failed.
+ */
+static int run_test_files(char **files, HlZygoteFn fn, void *rt,
+                          const TestOptions *opt)
+{
+    size_t n = 0;
+    while (files[n])
+        n++;
+
+    int64_t t0 = hl_cap_time_clock_ns();
+    TestCounts sum = {0};
+    int jobs = opt->isolate ? opt->jobs : 1;
+
+    if (jobs > 1 && n > 1) {
+        run_parallel(files, n, fn, rt, jobs, &sum);
+    } else {
+        /* Snapshot of the loaded database, restored before each file
+         * that runs in-process */
+        sqlite3 *tmpl = NULL;
+        if (sqlite3_open(":memory:", &tmpl) != SQLITE_OK ||
+            copy_db(tmpl, opt->db) != 0) {
+            sqlite3_close(tmpl);
+            tmpl = NULL;
+        }
+
+        for (size_t i = 0; i < n; i++) {
+            printf("\n--- %s ---\n", base_name(files[i]));
+
+            TestFile tf = { .rt = rt, .file = files[i] };
+            TestCounts counts;
+            run_test_file(fn, &tf, opt->isolate, opt->db, tmpl, &counts);
+
+            sum.total += counts.total;
+            sum.passed += counts.passed;
+            sum.failed += counts.failed;
+        }
+        sqlite3_close(tmpl);
+    }
+
+    for (size_t i = 0; i < n; i++)
+        free(files[i]);
+    free(files);
+
+    /* Report */
+    double secs = (double)(hl_cap_time_clock_ns() - t0) / 1e9;
+    printf("\n%d/%d tests passed", sum.passed, sum.total);
+    if (sum.failed > 0)
+        printf(", %d failed", sum.failed);
+    printf(" (%zu file%s in %.2fs", n, n == 1 ? "" : "s", secs);
+    if (jobs > 1 && n > 1)
+        printf(", %d workers", jobs < (int)n ? jobs : (int)n);
+    printf(")\n");
+
+    return sum.failed > 0 ? 1 : 0;
 }
 
 #ifdef HL_ENABLE_LUA
 
 /* ── Lua test runner ───────────────────────────────────────────────── */
 
-static int run_lua_tests(const char *app_dir, const char *entry)
+/* HlZygoteFn: load one test file and run the cases it registers */
+static int lua_test_file(void *ctx, void *result, size_t result_size)
+{
+    (void)result_size;
+    TestFile *tf = ctx;
+    TestCounts *c = result;
+    lua_State *L = ((HlLua *)tf->rt)->L;
+
+    /* Clear test cases from previous file */
+    hl_cap_test_clear_lua(L);
+
+    /* Load and execute the test file → registers test cases */
+    if (luaL_dofile(L, tf->file) != LUA_OK) {
+        const char *err = lua_tostring(L, -1);
+        fprintf(stderr, "  ERROR: %s\n", err ? err : "unknown");
+        lua_pop(L, 1);
+        c->total = 1;
+        c->failed = 1;
+        return 1;
+    }
+
+    /* Execute registered test cases */
+    hl_cap_test_run_lua(L, &c->total, &c->passed, &c->failed,
+                        stdout, NULL, 0);
+    return c->failed > 0 ? 1 : 0;
+}
+
+static int run_lua_tests(const char *app_dir, const char *entry,
+                         TestOptions *opt)
 {
     /* Init Lua VM (sandboxed — tests run in app context) */
     HlLuaConfig cfg = HL_LUA_CONFIG_DEFAULT;
@@ -95,6 +408,12 @@ static int run_lua_tests(const char *app_dir, const char *entry)
         return 1;
     }
 
+    /* Upload routes check their spool dirs against the manifest */
+    HlManifest manifest;
+    memset(&manifest, 0, sizeof(manifest));
+    hl_manifest_extract(lua.L, &manifest);
+    lua.base.manifest = &manifest;
+
     /* Wire routes into a standalone KlRouter */
     KlAllocator alloc = kl_allocator_default();
     KlRouter router;
@@ -123,47 +442,8 @@ static int run_lua_tests(const char *app_dir, const char *entry)
     }
 
     /* Run each test file */
-    int total = 0, passed = 0, failed = 0;
-
-    for (char **fp = test_files; *fp; fp++) {
-        const char *file = *fp;
-        const char *basename = strrchr(file, '/');
-        basename = basename ? basename + 1 : file;
-
-        printf("\n--- %s ---\n", basename);
-
-        /* Clear test cases from previous file */
-        hl_cap_test_clear_lua(lua.L);
-
-        /* Load and execute the test file → registers test cases */
-        if (luaL_dofile(lua.L, file) != LUA_OK) {
-            const char *err = lua_tostring(lua.L, -1);
-            fprintf(stderr, "  ERROR: %s\n", err ? err : "unknown");
-            lua_pop(lua.L, 1);
-            failed++;
-            total++;
-            free(*fp);
-            continue;
-        }
-
-        /* Execute registered test cases */
-        int file_total = 0, file_passed = 0, file_failed = 0;
-        hl_cap_test_run_lua(lua.L, &file_total, &file_passed, &file_failed,
-                            stdout, NULL, 0);
-
-        total += file_total;
-        passed += file_passed;
-        failed += file_failed;
-
-        free(*fp);
-    }
-    free(test_files);
-
-    /* Report */
-    printf("\n%d/%d tests passed", passed, total);
-    if (failed > 0)
-        printf(", %d failed", failed);
-    printf("\n");
+    opt->db = db;
+    int failed = run_test_files(test_files, lua_test_file, &lua, opt);
 
     /* Cleanup */
     kl_router_free(&router);
@@ -172,7 +452,7 @@ static int run_lua_tests(const char *app_dir, const char *entry)
     hl_cap_db_shutdown(db);
     sqlite3_close(db);
 
-    return failed > 0 ? 1 : 0;
+    return failed;
 }
 
 #endif /* HL_ENABLE_LUA */
@@ -181,7 +461,57 @@ static int run_lua_tests(const char *app_dir, const char *entry)
 
 /* ── JS test runner ────────────────────────────────────────────────── */
 
-static int run_js_tests(const char *app_dir, const char *entry)
+/* HlZygoteFn: evaluate one test module and run the cases it registers */
+static int js_test_file(void *ctx, void *result, size_t result_size)
+{
+    (void)result_size;
+    TestFile *tf = ctx;
+    TestCounts *c = result;
+    HlJS *js = tf->rt;
+    JSContext *jctx = js->ctx;
+
+    hl_cap_test_clear_js(jctx);
+
+    /* Read and evaluate the test file */
+    FILE *f = fopen(tf->file, "r");
+    if (!f) {
+        fprintf(stderr, "  ERROR: cannot open %s\n", tf->file);
+        c->total = 1;
+        c->failed = 1;
+        return 1;
+    }
+    fseek(f, 0, SEEK_END);
+    long flen = ftell(f);
+    if (flen < 0) { fclose(f); return 0; }
+    fseek(f, 0, SEEK_SET);
+    char *src = malloc((size_t)flen + 1);
+    if (!src) { fclose(f); return 0; }
+    if (fread(src, 1, (size_t)flen, f) != (size_t)flen) {
+        free(src); fclose(f); return 0;
+    }
+    src[flen] = '\0';
+    fclose(f);
+
+    JSValue val = JS_Eval(jctx, src, (size_t)flen, tf->file,
+                          JS_EVAL_TYPE_MODULE);
+    free(src);
+
+    if (JS_IsException(val)) {
+        hl_js_dump_error(js);
+        JS_FreeValue(jctx, val);
+        c->total = 1;
+        c->failed = 1;
+        return 1;
+    }
+    JS_FreeValue(jctx, val);
+
+    hl_cap_test_run_js(jctx, &c->total, &c->passed, &c->failed,
+                       stdout, NULL, 0);
+    return c->failed > 0 ? 1 : 0;
+}
+
+static int run_js_tests(const char *app_dir, const char *entry,
+                        TestOptions *opt)
 {
     HlJSConfig cfg = HL_JS_CONFIG_DEFAULT;
     HlJS js;
@@ -221,6 +551,11 @@ static int run_js_tests(const char *app_dir, const char *entry)
         return 1;
     }
 
+    HlManifest manifest;
+    memset(&manifest, 0, sizeof(manifest));
+    hl_manifest_extract_js(js.ctx, &manifest);
+    js.base.manifest = &manifest;
+
     KlAllocator alloc = kl_allocator_default();
     KlRouter router;
     kl_router_init(&router, &alloc);
@@ -228,6 +563,7 @@ static int run_js_tests(const char *app_dir, const char *entry)
     if (hl_js_wire_routes(&js, &router) != 0) {
         fprintf(stderr, "hull test: no routes registered\n");
         kl_router_free(&router);
+        hl_manifest_free_js_strings(js.ctx, &manifest);
         hl_js_free(&js);
         sqlite3_close(db);
         return 1;
@@ -240,81 +576,23 @@ static int run_js_tests(const char *app_dir, const char *entry)
         fprintf(stderr, "hull test: no test files found in %s\n", app_dir);
         if (test_files) free(test_files);
         kl_router_free(&router);
+        hl_manifest_free_js_strings(js.ctx, &manifest);
         hl_js_free(&js);
         sqlite3_close(db);
         return 1;
     }
 
-    int total = 0, passed = 0, failed = 0;
-
-    for (char **fp = test_files; *fp; fp++) {
-        const char *file = *fp;
-        const char *basename = strrchr(file, '/');
-        basename = basename ? basename + 1 : file;
-
-        printf("\n--- %s ---\n", basename);
-
-        hl_cap_test_clear_js(js.ctx);
-
-        /* Read and evaluate the test file */
-        FILE *f = fopen(file, "r");
-        if (!f) {
-            fprintf(stderr, "  ERROR: cannot open %s\n", file);
-            failed++;
-            total++;
-            free(*fp);
-            continue;
-        }
-        fseek(f, 0, SEEK_END);
-        long flen = ftell(f);
-        if (flen < 0) { fclose(f); free(*fp); continue; }
-        fseek(f, 0, SEEK_SET);
-        char *src = malloc((size_t)flen + 1);
-        if (!src) { fclose(f); free(*fp); continue; }
-        if (fread(src, 1, (size_t)flen, f) != (size_t)flen) {
-            free(src); fclose(f); free(*fp); continue;
-        }
-        src[flen] = '\0';
-        fclose(f);
-
-        JSValue result = JS_Eval(js.ctx, src, (size_t)flen, file,
-                                 JS_EVAL_TYPE_MODULE);
-        free(src);
-
-        if (JS_IsException(result)) {
-            hl_js_dump_error(&js);
-            JS_FreeValue(js.ctx, result);
-            failed++;
-            total++;
-            free(*fp);
-            continue;
-        }
-        JS_FreeValue(js.ctx, result);
-
-        int file_total = 0, file_passed = 0, file_failed = 0;
-        hl_cap_test_run_js(js.ctx, &file_total, &file_passed, &file_failed,
-                           stdout, NULL, 0);
-
-        total += file_total;
-        passed += file_passed;
-        failed += file_failed;
-
-        free(*fp);
-    }
-    free(test_files);
-
-    printf("\n%d/%d tests passed", passed, total);
-    if (failed > 0)
-        printf(", %d failed", failed);
-    printf("\n");
+    opt->db = db;
+    int failed = run_test_files(test_files, js_test_file, &js, opt);
 
     kl_router_free(&router);
+    hl_manifest_free_js_strings(js.ctx, &manifest);
     hl_js_free(&js);
     hl_stmt_cache_destroy(&js_stmt_cache);
     hl_cap_db_shutdown(db);
     sqlite3_close(db);
 
-    return failed > 0 ? 1 : 0;
+    return failed;
 }
 
 #endif /* HL_ENABLE_JS */
@@ -344,8 +622,33 @@ int hl_cmd_test(int argc, char **argv, const char *hull_exe)
     (void)hull_exe;
 
     const char *app_dir = ".";
-    if (argc >= 2 && argv[1][0] != '-')
-        app_dir = argv[1];
+    TestOptions opt = { .isolate = 1, .jobs = 1 };
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--no-fork") == 0) {
+            opt.isolate = 0;
+        } else if (strncmp(argv[i], "-j", 2) == 0) {
+            const char *val = argv[i][2] ? argv[i] + 2
+                            : (i + 1 < argc ? argv[++i] : "");
+            char *end;
+            long j = strtol(val, &end, 10);
+            if (!val[0] || *end != '\0' || j < 0 || j > HL_TEST_MAX_JOBS) {
+                fprintf(stderr, "hull test: invalid -j value: %s (0-%d)\n",
+                        val, HL_TEST_MAX_JOBS);
+                return 1;
+            }
+            if (j == 0) {
+                long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+                j = cpus < 1 ? 1 : cpus > HL_TEST_MAX_JOBS ? HL_TEST_MAX_JOBS : cpus;
+            }
+            opt.jobs = (int)j;
+        } else if (argv[i][0] != '-') {
+            app_dir = argv[i];
+        }
+    }
+    if (!opt.isolate && opt.jobs > 1) {
+        fprintf(stderr, "hull test: -j needs per-file processes (drop --no-fork)\n");
+        return 1;
+    }
 
     const char *lua_entry = detect_lua_entry(app_dir);
     const char *js_entry = detect_js_entry(app_dir);
@@ -366,7 +669,7 @@ int hl_cmd_test(int argc, char **argv, const char *hull_exe)
         char **lua_tests = hl_tool_find_files(app_dir, "test_*.lua", NULL);
         if (lua_tests && lua_tests[0]) {
             ran_any = 1;
-            result |= run_lua_tests(app_dir, lua_entry);
+            result |= run_lua_tests(app_dir, lua_entry, &opt);
         }
         if (lua_tests) {
             for (char **fp = lua_tests; *fp; fp++) free(*fp);
@@ -381,7 +684,7 @@ int hl_cmd_test(int argc, char **argv, const char *hull_exe)
         char **js_tests = hl_tool_find_files(app_dir, "test_*.js", NULL);
         if (js_tests && js_tests[0]) {
             ran_any = 1;
-            result |= run_js_tests(app_dir, js_entry);
+            result |= run_js_tests(app_dir, js_entry, &opt);
         }
         if (js_tests) {
             for (char **fp = js_tests; *fp; fp++) free(*fp);
@@ -0,0 +1,113 @@
+/*
+ * hdr.c — Log-linear latency histogram (HDR style)
+ *
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#include "hull/hdr.h"
+
+#include <string.h>
+
+#define SUB_COUNT  (1u << HL_HDR_SUB_BITS)
+
+/* Index of the highest set bit; v > 0 */
+static int msb(uint64_t v)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return 63 - __builtin_clzll(v);
+#else
+    int n = 0;
+    while (v >>= 1)
+        n++;
+    return n;
+#endif
+}
+
+/*
+ * Values below 2 * SUB_COUNT map to themselves. Above that, shift the
+ * value right until it has HL_HDR_SUB_BITS + 1 significant bits: the
+ * shift picks the range, the remaining bits (SUB_COUNT..2*SUB_COUNT-1)
+ * the sub-bucket within it.
+ */
+static unsigned bucket_of(uint64_t v)
+{
+    if (v < 2 * SUB_COUNT)
+        return (unsigned)v;
+    int shift = msb(v) - HL_HDR_SUB_BITS;
+    return (unsigned)shift * SUB_COUNT + (unsigned)(v >> shift);
+}
+
+/* Highest value that maps to bucket idx */
+static uint64_t bucket_high(unsigned idx)
+{
+    if (idx < 2 * SUB_COUNT)
+        return idx;
+    unsigned shift = idx / SUB_COUNT - 1;
+    uint64_t sub = idx - shift * SUB_COUNT;
+    return ((sub + 1) << shift) - 1;
+}
+
+void hl_hdr_init(HlHdr *h)
+{
+    memset(h, 0, sizeof(*h));
+    h->min = UINT64_MAX;
+}
+
+void hl_hdr_record(HlHdr *h, uint64_t value)
+{
+    h->counts[bucket_of(value)]++;
+    h->total++;
+    h->sum += (double)value;
+    if (value < h->min)
+        h->min = value;
+    if (value > h->max)
+        h->max = value;
+}
+
+void hl_hdr_merge(HlHdr *dst, const HlHdr *src)
+{
+    if (src->total == 0)
+        return;
+    for (unsigned i = 0; i < HL_HDR_BUCKETS; i++)
+        dst->counts[i] += src->counts[i];
+    dst->total += src->total;
+    dst->sum += src->sum;
+    if (src->min < dst->min)
+        dst->min = src->min;
+    if (src->max > dst->max)
+        dst->max = src->max;
+}
+
+uint64_t hl_hdr_percentile(const HlHdr *h, double pct)
+{
+    if (h->total == 0)
+        return 0;
+    if (pct <= 0.0)
+        return h->min;
+    if (pct >= 100.0)
+        return h->max;
+
+    /* Smallest rank whose cumulative share reaches pct; the slack keeps
+     * 99.9% of 1000 at rank 999 despite binary rounding */
+    double want = pct / 100.0 * (double)h->total;
+    uint64_t rank = (uint64_t)want;
+    if ((double)rank + 1e-9 < want)
+        rank++;
+    if (rank < 1)
+        rank = 1;
+
+    uint64_t seen = 0;
+    for (unsigned i = 0; i < HL_HDR_BUCKETS; i++) {
+        seen += h->counts[i];
+        if (seen >= rank) {
+            uint64_t v = bucket_high(i);
+            return v > h->max ? h->max : v;
+        }
+    }
+    return h->max;
+}
+
+double hl_hdr_mean(const HlHdr *h)
+{
+    return h->total ? h->sum / (double)h->total : 0.0;
+}
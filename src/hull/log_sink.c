@@ -0,0 +1,468 @@
+/*
+ * log_sink.c — Buffered log backend for rxi/log.c
+ *
+ * Producers format into thread-local buffers without holding any lock,
+ * then copy the finished line into the active half of a double buffer
+ * under one mutex. The flusher swaps halves and writes the full one
+ * with a single write(2), outside the lock.
+ *
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#include "hull/log_sink.h"
+#include "hull/limits.h"
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+/* ── Formatting ────────────────────────────────────────────────────── */
+
+static const char *level_names[] = {
+    "trace", "debug", "info", "warn", "error", "fatal"
+};
+
+static HlLogFormat sink_format = HL_LOG_TEXT;
+
+/* Thread-local scratch: formatting never touches shared state */
+static _Thread_local char tl_msg[HL_LOG_LINE_MAX];
+static _Thread_local char tl_line[HL_LOG_LINE_MAX];
+static _Thread_local struct {
+    time_t      sec;
+    HlLogFormat format;
+    size_t      len;
+    char        str[32];
+} tl_ts = { .sec = (time_t)-1 };
+
+static const char *cached_ts(size_t *len)
+{
+    time_t now = time(NULL);
+    if (now != tl_ts.sec || sink_format != tl_ts.format) {
+        struct tm tm;
+        if (sink_format == HL_LOG_TEXT) {
+            localtime_r(&now, &tm);
+            tl_ts.len = strftime(tl_ts.str, sizeof(tl_ts.str), "%H:%M:%S", &tm);
+        } else {
+            gmtime_r(&now, &tm);
+            tl_ts.len = strftime(tl_ts.str, sizeof(tl_ts.str),
+                                 "%Y-%m-%dT%H:%M:%SZ", &tm);
+        }
+        tl_ts.sec = now;
+        tl_ts.format = sink_format;
+    }
+    *len = tl_ts.len;
+    return tl_ts.str;
+}
+
+typedef struct {
+    char  *p;
+    size_t len;
+    size_t cap;    /* one byte is kept back for the newline */
+} LineBuf;
+
+static void lb_put(LineBuf *b, const char *s, size_t n)
+{
+    if (n > b->cap - b->len)
+        n = b->cap - b->len;
+    memcpy(b->p + b->len, s, n);
+    b->len += n;
+}
+
+static void lb_str(LineBuf *b, const char *s)
+{
+    lb_put(b, s, strlen(s));
+}
+
+/*
+ * JSON string body, or logfmt quoted value when json == 0. Stops at a
+ * whole escape sequence so that `reserve` bytes are left for the closing
+ * quote; a cut line stays well-formed.
+ */
+static void lb_escaped(LineBuf *b, const char *s, size_t n, int json,
+                       size_t reserve)
+{
+    for (size_t i = 0; i < n; i++) {
+        unsigned char c = (unsigned char)s[i];
+        char esc[8];
+        const char *seq = esc;
+        size_t seq_len = 2;
+        switch (c) {
+        case '"':  seq = "\\\""; break;
+        case '\\': seq = "\\\\"; break;
+        case '\n': seq = "\\n"; break;
+        case '\r': seq = "\\r"; break;
+        case '\t': seq = "\\t"; break;
+        default:
+            if (c < 0x20 && json) {
+                snprintf(esc, sizeof(esc), "\\u%04x", c);
+                seq_len = 6;
+            } else {
+                esc[0] = (char)c;
+                seq_len = 1;
+            }
+        }
+        if (b->len + reserve + seq_len > b->cap)
+            return;
+        memcpy(b->p + b->len, seq, seq_len);
+        b->len += seq_len;
+    }
+}
+
+/* Format one line (newline included) into out[HL_LOG_LINE_MAX] */
+static size_t format_line(char *out, int level, const char *file, int line,
+                          const char *msg, size_t msg_len)
+{
+    LineBuf b = { out, 0, HL_LOG_LINE_MAX - 1 };
+    size_t ts_len;
+    const char *ts = cached_ts(&ts_len);
+    if (level < LOG_TRACE || level > LOG_FATAL)
+        level = LOG_INFO;
+
+    switch (sink_format) {
+    case HL_LOG_JSON:
+        lb_str(&b, "{\"ts\":\"");
+        lb_put(&b, ts, ts_len);
+        lb_str(&b, "\",\"level\":\"");
+        lb_str(&b, level_names[level]);
+        lb_str(&b, "\",\"msg\":\"");
+        lb_escaped(&b, msg, msg_len, 1, 2);
+        lb_str(&b, "\"}");
+        break;
+    case HL_LOG_LOGFMT:
+        lb_str(&b, "ts=");
+        lb_put(&b, ts, ts_len);
+        lb_str(&b, " level=");
+        lb_str(&b, level_names[level]);
+        lb_str(&b, " msg=\"");
+        lb_escaped(&b, msg, msg_len, 0, 1);
+        lb_str(&b, "\"");
+        break;
+    case HL_LOG_TEXT:
+    default: {
+        char head[64];
+        int n = snprintf(head, sizeof(head), " %-5s ", log_level_string(level));
+        lb_put(&b, ts, ts_len);
+        lb_put(&b, head, (size_t)n);
+#ifdef DEBUG
+        char where[300];
+        n = snprintf(where, sizeof(where), "%s:%d: ", file, line);
+        lb_put(&b, where, (size_t)n < sizeof(where) ? (size_t)n : sizeof(where) - 1);
+#else
+        (void)file;
+        (void)line;
+#endif
+        lb_put(&b, msg, msg_len);
+        break;
+    }
+    }
+
+    out[b.len++] = '\n';
+    return b.len;
+}
+
+/* logfmt value: bare unless it needs quoting */
+static void lb_logfmt_value(LineBuf *b, const char *s, size_t n, size_t reserve)
+{
+    int quote = (n == 0);
+    for (size_t i = 0; i < n && !quote; i++) {
+        unsigned char c = (unsigned char)s[i];
+        quote = (c <= ' ' || c == '=' || c == '"' || c == '\\');
+    }
+    if (!quote) {
+        if (b->len + reserve + n <= b->cap)
+            lb_put(b, s, n);
+        return;
+    }
+    lb_str(b, "\"");
+    lb_escaped(b, s, n, 0, reserve + 1);
+    lb_str(b, "\"");
+}
+
+/* Structured line: head as format_line(), then one member per field */
+static size_t format_fields(char *out, int level, const char *msg,
+                            const HlLogField *fields, int count)
+{
+    /* JSON keeps room for the closing brace whatever gets cut */
+    size_t tail = (sink_format == HL_LOG_JSON) ? 1 : 0;
+    LineBuf b = { out, 0, HL_LOG_LINE_MAX - 1 - tail };
+    size_t ts_len;
+    const char *ts = cached_ts(&ts_len);
+    int json = (sink_format == HL_LOG_JSON);
+    if (level < LOG_TRACE || level > LOG_FATAL)
+        level = LOG_INFO;
+
+    switch (sink_format) {
+    case HL_LOG_JSON:
+        lb_str(&b, "{\"ts\":\"");
+        lb_put(&b, ts, ts_len);
+        lb_str(&b, "\",\"level\":\"");
+        lb_str(&b, level_names[level]);
+        lb_str(&b, "\",\"msg\":\"");
+        lb_escaped(&b, msg, strlen(msg), 1, 1);
+        lb_str(&b, "\"");
+        break;
+    case HL_LOG_LOGFMT:
+        lb_str(&b, "ts=");
+        lb_put(&b, ts, ts_len);
+        lb_str(&b, " level=");
+        lb_str(&b, level_names[level]);
+        lb_str(&b, " msg=");
+        lb_logfmt_value(&b, msg, strlen(msg), 0);
+        break;
+    case HL_LOG_TEXT:
+    default: {
+        char head[64];
+        int n = snprintf(head, sizeof(head), " %-5s ", log_level_string(level));
+        lb_put(&b, ts, ts_len);
+        lb_put(&b, head, (size_t)n);
+        lb_str(&b, msg);
+        break;
+    }
+    }
+
+    for (int i = 0; i < count; i++) {
+        const HlLogField *f = &fields[i];
+        char num[24];
+        size_t num_len = 0;
+        if (!f->str)
+            num_len = (size_t)snprintf(num, sizeof(num), "%llu",
+                                       (unsigned long long)f->num);
+        /* Whole members only: a field that does not fit ends the line */
+        size_t need = strlen(f->key) + (f->str ? 6 : num_len + 4);
+        if (b.len + need > b.cap)
+            break;
+        if (json) {
+            lb_str(&b, ",\"");
+            lb_str(&b, f->key);
+            lb_str(&b, "\":");
+            if (f->str) {
+                lb_str(&b, "\"");
+                lb_escaped(&b, f->str, f->str_len, 1, 1);
+                lb_str(&b, "\"");
+            } else {
+                lb_put(&b, num, num_len);
+            }
+        } else {
+            lb_str(&b, " ");
+            lb_str(&b, f->key);
+            lb_str(&b, "=");
+            if (f->str)
+                lb_logfmt_value(&b, f->str, f->str_len, 0);
+            else
+                lb_put(&b, num, num_len);
+        }
+    }
+
+    b.cap += tail;
+    if (json)
+        lb_str(&b, "}");
+    out[b.len++] = '\n';
+    return b.len;
+}
+
+int hl_log_sink_parse_format(const char *s)
+{
+    if (strcmp(s, "text") == 0)   return HL_LOG_TEXT;
+    if (strcmp(s, "json") == 0)   return HL_LOG_JSON;
+    if (strcmp(s, "logfmt") == 0) return HL_LOG_LOGFMT;
+    return -1;
+}
+
+int hl_log_sink_parse_policy(const char *s)
+{
+    if (strcmp(s, "block") == 0) return HL_LOG_BLOCK;
+    if (strcmp(s, "drop") == 0)  return HL_LOG_DROP;
+    return -1;
+}
+
+void hl_log_sink_set_format(HlLogFormat format)
+{
+    sink_format = format;
+}
+
+/* ── Flusher ───────────────────────────────────────────────────────── */
+
+static struct {
+    pthread_mutex_t mu;
+    pthread_cond_t  more;       /* producers -> flusher */
+    pthread_cond_t  space;      /* flusher -> blocked producers */
+    pthread_t       thread;
+    char            buf[2][HL_LOG_BUF_SIZE];
+    int             active;
+    size_t          len;
+    int             running;
+    int             stopping;
+    HlLogPolicy     policy;
+    int             fd;
+    uint64_t        dropped;
+} sink = {
+    .mu    = PTHREAD_MUTEX_INITIALIZER,
+    .more  = PTHREAD_COND_INITIALIZER,
+    .space = PTHREAD_COND_INITIALIZER,
+    .fd    = STDERR_FILENO,
+};
+
+static void write_all(int fd, const char *data, size_t len)
+{
+    while (len > 0) {
+        ssize_t w = write(fd, data, len);
+        if (w < 0) {
+            if (errno == EINTR)
+                continue;
+            return; /* nowhere left to report a log write failure */
+        }
+        data += w;
+        len -= (size_t)w;
+    }
+}
+
+static void *sink_main(void *arg)
+{
+    (void)arg;
+    uint64_t reported = 0;
+
+    pthread_mutex_lock(&sink.mu);
+    for (;;) {
+        if (!sink.stopping && sink.len < HL_LOG_BUF_SIZE / 2) {
+            struct timespec until;
+            clock_gettime(CLOCK_REALTIME, &until);
+            until.tv_nsec += HL_LOG_FLUSH_MS * 1000000L;
+            if (until.tv_nsec >= 1000000000L) {
+                until.tv_sec++;
+                until.tv_nsec -= 1000000000L;
+            }
+            pthread_cond_timedwait(&sink.more, &sink.mu, &until);
+        }
+        if (sink.len == 0 && sink.dropped == reported) {
+            if (sink.stopping)
+                break;
+            continue;
+        }
+
+        char *out = sink.buf[sink.active];
+        size_t len = sink.len;
+        uint64_t dropped = sink.dropped;
+        sink.active ^= 1;
+        sink.len = 0;
+        pthread_cond_broadcast(&sink.space);
+        pthread_mutex_unlock(&sink.mu);
+
+        write_all(sink.fd, out, len);
+        if (dropped != reported) {
+            char msg[96];
+            int n = snprintf(msg, sizeof(msg), "[hull:c] log: %llu lines dropped",
+                             (unsigned long long)(dropped - reported));
+            size_t ln = format_line(tl_line, LOG_WARN, __FILE__, __LINE__,
+                                    msg, (size_t)n);
+            write_all(sink.fd, tl_line, ln);
+            reported = dropped;
+        }
+
+        pthread_mutex_lock(&sink.mu);
+    }
+
+    sink.running = 0;
+    pthread_cond_broadcast(&sink.space);
+    pthread_mutex_unlock(&sink.mu);
+    return NULL;
+}
+
+int hl_log_sink_start(int fd, HlLogPolicy policy)
+{
+    pthread_mutex_lock(&sink.mu);
+    if (sink.running) {
+        pthread_mutex_unlock(&sink.mu);
+        return -1;
+    }
+    sink.fd = fd;
+    sink.policy = policy;
+    sink.len = 0;
+    sink.dropped = 0;
+    sink.stopping = 0;
+    sink.running = 1;
+    if (pthread_create(&sink.thread, NULL, sink_main, NULL) != 0) {
+        sink.running = 0;
+        sink.fd = STDERR_FILENO;
+        pthread_mutex_unlock(&sink.mu);
+        return -1;
+    }
+    pthread_mutex_unlock(&sink.mu);
+    return 0;
+}
+
+void hl_log_sink_stop(void)
+{
+    pthread_mutex_lock(&sink.mu);
+    if (!sink.running || sink.stopping) {
+        pthread_mutex_unlock(&sink.mu);
+        return;
+    }
+    sink.stopping = 1;
+    pthread_cond_signal(&sink.more);
+    pthread_mutex_unlock(&sink.mu);
+
+    pthread_join(sink.thread, NULL);
+
+    pthread_mutex_lock(&sink.mu);
+    sink.stopping = 0;
+    sink.fd = STDERR_FILENO;
+    pthread_mutex_unlock(&sink.mu);
+}
+
+uint64_t hl_log_sink_dropped(void)
+{
+    pthread_mutex_lock(&sink.mu);
+    uint64_t n = sink.dropped;
+    pthread_mutex_unlock(&sink.mu);
+    return n;
+}
+
+/* ── Producer ──────────────────────────────────────────────────────── */
+
+static void sink_submit(const char *line, size_t len, int level)
+{
+    pthread_mutex_lock(&sink.mu);
+    while (sink.running && sink.len + len > HL_LOG_BUF_SIZE) {
+        if (sink.policy == HL_LOG_DROP) {
+            sink.dropped++;
+            pthread_mutex_unlock(&sink.mu);
+            return;
+        }
+        pthread_cond_signal(&sink.more);
+        pthread_cond_wait(&sink.space, &sink.mu);
+    }
+    if (!sink.running) {
+        int fd = sink.fd;
+        pthread_mutex_unlock(&sink.mu);
+        write_all(fd, line, len);
+        return;
+    }
+
+    memcpy(sink.buf[sink.active] + sink.len, line, len);
+    sink.len += len;
+    if (sink.len >= HL_LOG_BUF_SIZE / 2 || level >= LOG_ERROR)
+        pthread_cond_signal(&sink.more);
+    pthread_mutex_unlock(&sink.mu);
+}
+
+void hl_log_sink_callback(log_Event *ev)
+{
+    int n = vsnprintf(tl_msg, sizeof(tl_msg), ev->fmt, ev->ap);
+    if (n < 0)
+        return;
+    size_t msg_len = (size_t)n < sizeof(tl_msg) ? (size_t)n : sizeof(tl_msg) - 1;
+    size_t len = format_line(tl_line, ev->level, ev->file, ev->line,
+                             tl_msg, msg_len);
+    sink_submit(tl_line, len, ev->level);
+}
+
+void hl_log_sink_fields(int level, const char *msg,
+                        const HlLogField *fields, int count)
+{
+    size_t len = format_fields(tl_line, level, msg, fields, count);
+    sink_submit(tl_line, len, level);
+}
@@ -21,11 +21,15 @@
 #include "hull/runtime/lua.h"
 #endif
 
+#include "hull/access_log.h"
 #include "hull/alloc.h"
 #include "hull/cap/audit.h"
 #include "hull/cap/db.h"
 #include "hull/cap/env.h"
 #include "hull/cap/http.h"
+#include "hull/cap/metrics.h"
+#include "hull/cap/outbox.h"
+#include "hull/cap/sched.h"
 #include "hull/cap/smtp.h"
 #include "hull/migrate.h"
 #include "hull/vfs.h"
@@ -33,12 +37,15 @@
 #include <keel/tls_mbedtls.h>
 #include "hull/commands/dispatch.h"
 #include "hull/limits.h"
+#include "hull/log_sink.h"
 #include "hull/manifest.h"
 #include "hull/parse_size.h"
+#include "hull/reload.h"
 #include "hull/sandbox.h"
 #include "hull/signature.h"
 #include "hull/static.h"
 #include "hull/tool.h"
+#include "hull/upgrade.h"
 
 #include <keel/keel.h>
 
@@ -48,6 +55,7 @@
 
 #include <sh_arena.h>
 
+#include <errno.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -64,23 +72,6 @@
 
 /* ── Logging ───────────────────────────────────────────────────────── */
 
-/* Custom log callback: suppresses file:line in release builds */
-static void hl_log_callback(log_Event *ev) {
-    char ts[16];
-    ts[strftime(ts, sizeof(ts), "%H:%M:%S", ev->time)] = '\0';
-
-    char msg[1024];
-    vsnprintf(msg, sizeof(msg), ev->fmt, ev->ap);
-
-#ifdef DEBUG
-    fprintf((FILE *)ev->udata, "%s %-5s %s:%d: %s\n",
-            ts, log_level_string(ev->level), ev->file, ev->line, msg);
-#else
-    fprintf((FILE *)ev->udata, "%s %-5s %s\n",
-            ts, log_level_string(ev->level), msg);
-#endif
-}
-
 static int hl_parse_log_level(const char *s) {
     if (strcmp(s, "trace") == 0) return LOG_TRACE;
     if (strcmp(s, "debug") == 0) return LOG_DEBUG;
@@ -145,6 +136,40 @@ static const char *auto_detect_entry(void)
     return NULL;
 }
 
+/* ── Metrics listen address ────────────────────────────────────────── */
+
+/*
+ * "[ADDR:]PORT" into addr/port; ADDR defaults to 127.0.0.1 and may be
+ * a bracketed IPv6 literal. Returns 0 or -1.
+ */
+static int parse_listen_addr(const char *spec, char *addr, size_t addr_size,
+                             int *port)
+{
+    const char *colon = strrchr(spec, ':');
+    const char *port_str = colon ? colon + 1 : spec;
+    char *end;
+    long p = strtol(port_str, &end, 10);
+    if (*port_str == '\0' || *end != '\0' || p < 1 || p > 65535)
+        return -1;
+    *port = (int)p;
+
+    if (!colon) {
+        snprintf(addr, addr_size, "127.0.0.1");
+        return 0;
+    }
+    const char *a = spec;
+    size_t len = (size_t)(colon - spec);
+    if (len >= 2 && a[0] == '[' && a[len - 1] == ']') {
+        a++;
+        len -= 2;
+    }
+    if (len == 0 || len >= addr_size)
+        return -1;
+    memcpy(addr, a, len);
+    addr[len] = '\0';
+    return 0;
+}
+
 /* ── Usage ──────────────────────────────────────────────────────────── */
 
 static void usage(const char *prog)
@@ -159,14 +184,26 @@ static void usage(const char *prog)
             "  -M SIZE              Process memory limit (default: unlimited)\n"
             "  -s SIZE              JS stack size limit (default: 1m)\n"
             "  -l LEVEL             Log level: trace|debug|info|warn|error|fatal (default: info)\n"
+            "  --log-format FMT     Log line format: text|json|logfmt (default: text)\n"
+            "  --log-policy POLICY  When the log buffer is full: block|drop (default: block)\n"
             "  --tls-cert PATH      TLS certificate file (PEM)\n"
             "  --tls-key PATH       TLS private key file (PEM)\n"
             "  --verify-sig PUBKEY  Verify app signature before startup\n"
             "  --drain-timeout MS   Graceful shutdown drain timeout (default: 5000)\n"
+            "  --smtp-idle MS       Keep SMTP sessions open this long between sends (default: 30000, 0 = off)\n"
+            "  --outbox-workers N   Deliver webhook/http outbox rows off the request path, N at a time\n"
+            "  --upgrade            On SIGUSR2, re-exec and hand the listening socket over\n"
+            "  --alloc BACKEND      Runtime allocator: libc|pool (default: libc)\n"
+            "  --gc MODE            GC pacing: request|incremental (default: request)\n"
+            "  --gc-budget US       Per-request GC pause budget in microseconds (default: 1000)\n"
             "  --no-migrate         Skip auto-run migrations on startup\n"
+            "  --no-jobs            Do not run app.every/app.at jobs in this instance\n"
             "  --skip-ca-bundle     Skip TLS certificate verification (dev mode)\n"
+            "  --access-log         Log one line per request from C (id, status, bytes, duration)\n"
+            "  --metrics ADDR:PORT  Serve Prometheus metrics at /metrics (ADDR optional)\n"
             "  --max-instructions N Set runtime instruction limit per request (default: 100m)\n"
             "  --audit              Enable capability audit logging (JSON to stderr)\n"
+            "  --audit-file PATH    Audit log file, rotated to PATH.1 at 64 MB (implies --audit)\n"
             "  --no-sandbox         Disable kernel sandbox (dev/debug only)\n"
             "  -h                   Show this help\n"
             "\n"
@@ -177,6 +214,7 @@ static void usage(const char *prog)
             "  inspect [dir]        Display app capabilities\n"
             "  manifest [dir]       Extract app manifest\n"
             "  test [options] dir   Run app tests\n"
+            "  bench [options] dir  Load-test routes in-process or over loopback\n"
             "  new <name>           Scaffold new project\n"
             "  dev [app] [options]  Hot-reload development server\n"
             "  migrate [subcommand] Run/status/create SQL migrations\n"
@@ -212,16 +250,27 @@ static int hull_serve(int argc, char **argv)
     const char *db_path = "data.db";
     const char *entry_point = NULL;
     const char *verify_sig_path = NULL;
+    const char *alloc_backend = NULL; /* NULL = libc */
+    const char *audit_file = NULL;    /* NULL = stderr */
+    const char *metrics_spec = NULL;  /* NULL = metrics off */
+    int gc_mode = HL_GC_REQUEST;
+    int gc_budget_us = HL_GC_BUDGET_US;
     long heap_limit = 0;    /* 0 = use default */
     long stack_limit = 0;   /* 0 = use default */
     long mem_limit = 0;     /* 0 = unlimited */
     long instruction_limit = 0; /* 0 = use default */
     int log_level = LOG_INFO;
+    int log_format = -1;    /* -1 = HULL_LOG_FORMAT or text */
+    int log_policy = HL_LOG_BLOCK;
     int no_migrate = 0;
+    int no_jobs = 0;
     int no_sandbox = 0;
     int skip_ca_bundle = 0;
     int agent_mode = 0;
+    int upgrade = 0;
     int drain_timeout = HL_DEFAULT_DRAIN_TIMEOUT_MS;
+    int smtp_idle = HL_SMTP_DEFAULT_IDLE_MS;
+    int outbox_workers = 0; /* 0 = outbox.flush() delivers everything */
     const char *tls_cert_path = NULL;
     const char *tls_key_path = NULL;
 
@@ -263,6 +312,20 @@ static int hull_serve(int argc, char **argv)
                 fprintf(stderr, "hull: invalid log level: %s\n", argv[i]);
                 return 1;
             }
+        } else if (strcmp(argv[i], "--log-format") == 0 && i + 1 < argc) {
+            log_format = hl_log_sink_parse_format(argv[++i]);
+            if (log_format < 0) {
+                fprintf(stderr, "hull: invalid log format: %s (text|json|logfmt)\n",
+                        argv[i]);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--log-policy") == 0 && i + 1 < argc) {
+            log_policy = hl_log_sink_parse_policy(argv[++i]);
+            if (log_policy < 0) {
+                fprintf(stderr, "hull: invalid log policy: %s (block|drop)\n",
+                        argv[i]);
+                return 1;
+            }
         } else if (strcmp(argv[i], "--tls-cert") == 0 && i + 1 < argc) {
             tls_cert_path = argv[++i];
         } else if (strcmp(argv[i], "--tls-key") == 0 && i + 1 < argc) {
@@ -271,14 +334,25 @@ static int hull_serve(int argc, char **argv)
             verify_sig_path = argv[++i];
         } else if (strcmp(argv[i], "--no-migrate") == 0) {
             no_migrate = 1;
+        } else if (strcmp(argv[i], "--no-jobs") == 0) {
+            no_jobs = 1;
         } else if (strcmp(argv[i], "--no-sandbox") == 0) {
             no_sandbox = 1;
         } else if (strcmp(argv[i], "--skip-ca-bundle") == 0) {
             skip_ca_bundle = 1;
         } else if (strcmp(argv[i], "--agent") == 0) {
             agent_mode = 1;
+        } else if (strcmp(argv[i], "--upgrade") == 0) {
+            upgrade = 1;
         } else if (strcmp(argv[i], "--audit") == 0) {
             hl_audit_enabled = 1;
+        } else if (strcmp(argv[i], "--metrics") == 0 && i + 1 < argc) {
+            metrics_spec = argv[++i];
+        } else if (strcmp(argv[i], "--access-log") == 0) {
+            hl_access_log_enabled = 1;
+        } else if (strcmp(argv[i], "--audit-file") == 0 && i + 1 < argc) {
+            audit_file = argv[++i];
+            hl_audit_enabled = 1;
         } else if (strcmp(argv[i], "--max-instructions") == 0 && i + 1 < argc) {
             char *end;
             instruction_limit = strtol(argv[++i], &end, 10);
@@ -294,6 +368,44 @@ static int hull_serve(int argc, char **argv)
                 return 1;
             }
             drain_timeout = (int)dt;
+        } else if (strcmp(argv[i], "--smtp-idle") == 0 && i + 1 < argc) {
+            char *end;
+            long si = strtol(argv[++i], &end, 10);
+            if (*end != '\0' || si < 0 || si > 3600000) {
+                fprintf(stderr, "hull: invalid SMTP idle time: %s\n", argv[i]);
+                return 1;
+            }
+            smtp_idle = (int)si;
+        } else if (strcmp(argv[i], "--outbox-workers") == 0 && i + 1 < argc) {
+            char *end;
+            long ow = strtol(argv[++i], &end, 10);
+            if (*end != '\0' || ow < 0 || ow > HL_OUTBOX_MAX_WORKERS) {
+                fprintf(stderr, "hull: invalid outbox workers: %s (0-%d)\n",
+                        argv[i], HL_OUTBOX_MAX_WORKERS);
+                return 1;
+            }
+            outbox_workers = (int)ow;
+        } else if (strcmp(argv[i], "--alloc") == 0 && i + 1 < argc) {
+            alloc_backend = argv[++i];
+        } else if (strcmp(argv[i], "--gc") == 0 && i + 1 < argc) {
+            i++;
+            if (strcmp(argv[i], "request") == 0) {
+                gc_mode = HL_GC_REQUEST;
+            } else if (strcmp(argv[i], "incremental") == 0) {
+                gc_mode = HL_GC_INCREMENTAL;
+            } else {
+                fprintf(stderr, "hull: invalid gc mode: %s (request|incremental)\n",
+                        argv[i]);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--gc-budget") == 0 && i + 1 < argc) {
+            char *end;
+            long us = strtol(argv[++i], &end, 10);
+            if (*end != '\0' || us <= 0 || us > 1000000) {
+                fprintf(stderr, "hull: invalid gc budget: %s\n", argv[i]);
+                return 1;
+            }
+            gc_budget_us = (int)us;
         } else if (strcmp(argv[i], "-h") == 0) {
             usage(argv[0]);
             return 0;
@@ -307,6 +419,45 @@ static int hull_serve(int argc, char **argv)
         const char *audit_env = getenv("HULL_AUDIT");
         if (audit_env && strcmp(audit_env, "1") == 0)
             hl_audit_enabled = 1;
+        if (!audit_file)
+            audit_file = getenv("HULL_AUDIT_FILE");
+        if (audit_file)
+            hl_audit_enabled = 1;
+    }
+
+    /* Check HULL_ACCESS_LOG env var */
+    {
+        const char *al_env = getenv("HULL_ACCESS_LOG");
+        if (al_env && strcmp(al_env, "1") == 0)
+            hl_access_log_enabled = 1;
+    }
+
+    /* Check HULL_UPGRADE env var */
+    {
+        const char *up_env = getenv("HULL_UPGRADE");
+        if (up_env && strcmp(up_env, "1") == 0)
+            upgrade = 1;
+    }
+
+    /* Check HULL_LOG_FORMAT env var (--log-format wins) */
+    if (log_format < 0) {
+        const char *lf_env = getenv("HULL_LOG_FORMAT");
+        log_format = lf_env ? hl_log_sink_parse_format(lf_env) : HL_LOG_TEXT;
+        if (log_format < 0) {
+            fprintf(stderr, "hull: invalid HULL_LOG_FORMAT: %s (text|json|logfmt)\n",
+                    lf_env);
+            return 1;
+        }
+    }
+
+    /* Check HULL_ALLOC env var (--alloc wins) */
+    if (!alloc_backend)
+        alloc_backend = getenv("HULL_ALLOC");
+    if (alloc_backend && strcmp(alloc_backend, "libc") != 0 &&
+        strcmp(alloc_backend, "pool") != 0) {
+        fprintf(stderr, "hull: invalid allocator: %s (libc|pool)\n",
+                alloc_backend);
+        return 1;
     }
 
     /* Check HULL_MAX_INSTRUCTIONS env var */
@@ -329,6 +480,56 @@ static int hull_serve(int argc, char **argv)
         return 1;
     }
 
+    /* Audit events go through the ring; the drain thread is started
+     * before the sandbox and flushed by atexit on every exit path. */
+    if (hl_audit_enabled) {
+        if (hl_audit_start(audit_file, audit_file ? HL_AUDIT_ROTATE_BYTES : 0) != 0) {
+            fprintf(stderr, "hull: cannot start audit log%s%s\n",
+                    audit_file ? ": " : "", audit_file ? audit_file : "");
+            return 1;
+        }
+        atexit(hl_audit_stop);
+    }
+
+    /* Started by a SIGUSR2 upgrade: take over the old process's
+     * listening sockets instead of binding new ones */
+    int inherited[HL_UPGRADE_MAX_FDS];
+    int inherited_count = hl_upgrade_receive(inherited, HL_UPGRADE_MAX_FDS);
+    if (inherited_count < 0) {
+        fprintf(stderr, "hull: listening socket handoff failed\n");
+        return 1;
+    }
+
+    /* Metrics listener: bound before the sandbox, series registered as
+     * routes are wired. HULL_METRICS is used when --metrics is absent. */
+    if (!metrics_spec)
+        metrics_spec = getenv("HULL_METRICS");
+    if (inherited_count > 1 && !metrics_spec) {
+        close(inherited[1]);
+        inherited_count = 1;
+    }
+    if (metrics_spec) {
+        char metrics_addr[64];
+        int metrics_port;
+        if (parse_listen_addr(metrics_spec, metrics_addr, sizeof(metrics_addr),
+                              &metrics_port) != 0) {
+            fprintf(stderr, "hull: invalid metrics address: %s ([ADDR:]PORT)\n",
+                    metrics_spec);
+            return 1;
+        }
+        hl_metrics_enabled = 1;
+        if (inherited_count > 1) {
+            if (hl_metrics_serve_fd(inherited[1]) != 0) {
+                fprintf(stderr, "hull: cannot serve metrics on inherited socket\n");
+                return 1;
+            }
+        } else if (hl_metrics_serve(metrics_addr, metrics_port) != 0) {
+            fprintf(stderr, "hull: cannot listen for metrics on %s\n", metrics_spec);
+            return 1;
+        }
+        atexit(hl_metrics_stop);
+    }
+
     /* Resolve entry point to absolute path.  This ensures app_dir (derived
      * below) is also absolute, so realpath() inside the sandbox doesn't need
      * to stat the CWD — which may be outside the sandbox's allowed paths. */
@@ -384,14 +585,21 @@ static int hull_serve(int argc, char **argv)
     }
 #endif
 
-    /* Initialize logging */
+    /* Initialize logging: lines are buffered and written by the sink's
+     * flusher thread; atexit flushes whatever is left on every path. */
     log_set_level(log_level);
     log_set_quiet(true);  /* suppress default stderr callback */
-    log_add_callback(hl_log_callback, stderr, log_level);
+    hl_log_sink_set_format((HlLogFormat)log_format);
+    log_add_callback(hl_log_sink_callback, NULL, log_level);
+    if (hl_log_sink_start(STDERR_FILENO, (HlLogPolicy)log_policy) == 0)
+        atexit(hl_log_sink_stop);
 
     /* Initialize tracking allocator */
     HlAllocator alloc;
     hl_alloc_init(&alloc, (size_t)mem_limit);
+    if (alloc_backend && strcmp(alloc_backend, "pool") == 0 &&
+        hl_alloc_use_pool(&alloc) != 0)
+        log_warn("[hull:c] size-class pool unavailable, using libc malloc");
     KlAllocator kl_alloc = hl_alloc_kl(&alloc);
 
     int ret = 1;
@@ -467,6 +675,13 @@ static int hull_serve(int argc, char **argv)
         config.tls = &server_tls_config;
     }
 
+    /* The old process still holds the port: let Keel bind a throwaway
+     * loopback socket, then put the inherited one in its place */
+    if (inherited_count > 0) {
+        config.port = 0;
+        config.bind_addr = "127.0.0.1";
+    }
+
     KlServer server;
     if (kl_server_init(&server, &config) != 0) {
         log_error("[hull:c] server init failed");
@@ -474,6 +689,24 @@ static int hull_serve(int argc, char **argv)
             kl_tls_mbedtls_ctx_destroy(server_tls_ctx);
         goto cleanup_db;
     }
+    if (inherited_count > 0) {
+        if (dup2(inherited[0], server.listen_fd) < 0) {
+            log_error("[hull:c] cannot take over listening socket: %s",
+                      strerror(errno));
+            goto cleanup_server;
+        }
+        close(inherited[0]);
+        log_info("[hull:c] took over listening socket from previous process");
+    }
+
+    /* SIGUSR2 upgrade helper: forked now, while fork/exec are still
+     * allowed — the sandbox applied below blocks both */
+    if (upgrade) {
+        int listen_fds[HL_UPGRADE_MAX_FDS] = { server.listen_fd, hl_metrics_fd() };
+        int nfds = listen_fds[1] >= 0 ? 2 : 1;
+        if (hl_upgrade_arm(argv, listen_fds, nfds, HL_UPGRADE_READY_TIMEOUT_MS) != 0)
+            log_warn("[hull:c] cannot start upgrade helper; SIGUSR2 disabled");
+    }
 
     /* ── Runtime vtable dispatch ─────────────────────────────────── */
 
@@ -503,6 +736,8 @@ static int hull_serve(int argc, char **argv)
         if (heap_limit > 0)        js_cfg.max_heap_bytes   = (size_t)heap_limit;
         if (stack_limit > 0)       js_cfg.max_stack_bytes   = (size_t)stack_limit;
         if (instruction_limit > 0) js_cfg.max_instructions  = instruction_limit;
+        js_cfg.gc_mode = gc_mode;
+        js_cfg.gc_budget_us = gc_budget_us;
         rt = &rt_storage.js.base;
         rt->vt = &hl_js_vtable;
         rt_cfg = &js_cfg;
@@ -512,6 +747,8 @@ static int hull_serve(int argc, char **argv)
         lua_cfg = (HlLuaConfig)HL_LUA_CONFIG_DEFAULT;
         if (heap_limit > 0)        lua_cfg.max_heap_bytes   = (size_t)heap_limit;
         if (instruction_limit > 0) lua_cfg.max_instructions  = instruction_limit;
+        lua_cfg.gc_mode = gc_mode;
+        lua_cfg.gc_budget_us = gc_budget_us;
         rt = &rt_storage.lua.base;
         rt->vt = &hl_lua_vtable;
         rt_cfg = &lua_cfg;
@@ -589,6 +826,58 @@ static int hull_serve(int argc, char **argv)
                  manifest.fs_read_count, manifest.fs_write_count,
                  manifest.env_count, manifest.hosts_count);
     }
+    rt->manifest = &manifest; /* upload routes: spool dirs need fs.write */
+
+    /* hull dev: in-process reload swaps the runtime behind reload.rt */
+    HlReload reload;
+    memset(&reload, 0, sizeof(reload));
+    const char *reload_token = getenv(HL_RELOAD_ENV);
+    int reloadable = reload_token && reload_token[0];
+
+    /* Background jobs: the scheduler thread triggers each run through
+     * HL_SCHED_PATH, answered by a middleware ahead of the app's so app
+     * middleware (auth, CSRF) never sees it */
+    HlSched *sched = NULL;
+    KlTlsConfig sched_tls_config = {0};
+    KlTlsCtx *sched_tls_ctx = NULL;
+    int njobs = 0;
+    {
+        HlJobDef jobs[HL_SCHED_MAX_JOBS];
+        njobs = rt->vt->extract_jobs(rt, jobs, HL_SCHED_MAX_JOBS);
+        if (njobs < 0)
+            log_error("[hull:c] malformed app.every/app.at registration, "
+                      "jobs disabled");
+        else if (njobs > 0 && no_jobs)
+            log_info("[hull:c] %d job(s) not scheduled (--no-jobs)", njobs);
+        else if (njobs > 0)
+            sched = hl_sched_create(jobs, njobs, reloadable ? &reload.rt : &rt);
+    }
+    if (sched && server_tls_ctx) {
+        /* Our own certificate: nothing to verify on loopback */
+        sched_tls_ctx = kl_tls_mbedtls_client_ctx_create(NULL);
+        if (sched_tls_ctx) {
+            sched_tls_config.ctx         = sched_tls_ctx;
+            sched_tls_config.factory     = (KlTlsFactory)kl_tls_mbedtls_create;
+            sched_tls_config.ctx_destroy = (void (*)(KlTlsCtx *))kl_tls_mbedtls_ctx_destroy;
+        } else {
+            log_error("[hull:c] cannot create TLS client context, jobs disabled");
+            hl_sched_destroy(sched);
+            sched = NULL;
+        }
+    }
+
+    /* Access log: CLI/env or access_log = true in the manifest.
+     * Registered first so the clock starts before anything else runs;
+     * job runs are logged too (the job middleware finishes the line). */
+    if (manifest.access_log)
+        hl_access_log_enabled = 1;
+    if (hl_access_log_enabled)
+        kl_server_use(&server, "*", "/*", hl_access_log_middleware, NULL);
+
+    if (sched) {
+        kl_server_use(&server, "POST", HL_SCHED_PATH, hl_sched_middleware, sched);
+        kl_server_route(&server, "POST", HL_SCHED_PATH, hl_sched_handler, sched, NULL);
+    }
 
     /* Wire CSP policy to runtime.
      * Default CSP is always active — even without app.manifest().
@@ -653,6 +942,22 @@ static int hull_serve(int argc, char **argv)
         rt->smtp_cfg = &smtp_cfg_storage;
     }
 
+    /* Outbox dispatcher: its own connection to the app database, opened
+     * before the sandbox; threads start once routes are wired */
+    HlOutbox *outbox = NULL;
+    if (outbox_workers > 0 && !rt->http_cfg) {
+        log_warn("[hull:c] --outbox-workers ignored: the manifest declares no hosts");
+    } else if (outbox_workers > 0) {
+        HlOutboxConfig ocfg = {
+            .db_path = db_path,
+            .http      = &http_cfg_storage,
+            .ca_bundle = skip_ca_bundle ? NULL : ca_bundle_path,
+            .workers   = outbox_workers,
+        };
+        outbox = hl_outbox_create(&ocfg);
+        rt->outbox = outbox;
+    }
+
     /* RT-04: Apply kernel sandbox BEFORE wiring routes — all route
      * handlers execute inside sandbox constraints. */
     if (!no_sandbox) {
@@ -661,8 +966,12 @@ static int hull_serve(int argc, char **argv)
             log_error("[hull:c] sandbox enforcement failed");
             rt->vt->free_manifest_strings(rt, &manifest);
             rt->vt->destroy(rt);
+            hl_outbox_destroy(outbox);
             if (client_tls_ctx)
                 kl_tls_mbedtls_ctx_destroy(client_tls_ctx);
+            hl_sched_destroy(sched);
+            if (sched_tls_ctx)
+                kl_tls_mbedtls_ctx_destroy(sched_tls_ctx);
             goto cleanup_server;
         }
     } else {
@@ -673,11 +982,27 @@ static int hull_serve(int argc, char **argv)
     if (rt->vt->wire_routes_server(rt, &server, track_route_alloc) != 0) {
         rt->vt->free_manifest_strings(rt, &manifest);
         rt->vt->destroy(rt);
+        hl_outbox_destroy(outbox);
         if (client_tls_ctx)
             kl_tls_mbedtls_ctx_destroy(client_tls_ctx);
+        hl_sched_destroy(sched);
+        if (sched_tls_ctx)
+            kl_tls_mbedtls_ctx_destroy(sched_tls_ctx);
         goto cleanup_server;
     }
 
+    /* hull dev: in-process reload endpoint, keyed by the parent's token */
+    if (reloadable) {
+        reload.rt = rt;
+        reload.rt_size = sizeof(rt_storage);
+        reload.rt_cfg = rt_cfg;
+        reload.entry_point = entry_point;
+        reload.manifest = &manifest;
+        reload.token = reload_token;
+        kl_server_route(&server, "POST", HL_RELOAD_PATH,
+                        hl_reload_handler, &reload, NULL);
+    }
+
     /* Auto-register static file serving (after sandbox is applied) */
     {
         int has_static = hl_vfs_has_prefix(&app_vfs, "static/");
@@ -699,18 +1024,81 @@ static int hull_serve(int argc, char **argv)
     log_info("[hull:c] listening on %s://%s:%d (%s runtime)",
              server_tls_ctx ? "https" : "http",
              bind_addr, port, rt->vt->name);
+    if (metrics_spec)
+        log_info("[hull:c] metrics on %s (GET /metrics)", metrics_spec);
+
+    if (upgrade)
+        log_info("[hull:c] upgrade: kill -USR2 %d", (int)getpid());
+
+    /* SMTP sessions outlive a send for up to --smtp-idle ms */
+    HlSmtpPool *smtp_pool = NULL;
+    if (rt->smtp_cfg && smtp_idle > 0) {
+        smtp_pool = hl_smtp_pool_create(smtp_idle);
+        smtp_cfg_storage.pool = smtp_pool;
+    }
+
+    if (sched) {
+        if (hl_sched_start(sched, server.listen_fd,
+                           sched_tls_ctx ? &sched_tls_config : NULL) == 0)
+            log_info("[hull:c] %d background job(s) scheduled", njobs);
+        else
+            log_error("[hull:c] cannot start job scheduler");
+    }
+
+    if (outbox) {
+        if (hl_outbox_start(outbox) == 0) {
+            log_info("[hull:c] outbox dispatcher: %d worker(s)", outbox_workers);
+        } else {
+            log_error("[hull:c] cannot start outbox dispatcher");
+            rt->outbox = NULL; /* outbox.flush() keeps delivering */
+        }
+    }
+
+    /* Routes are wired: a previous process may start draining now */
+    hl_upgrade_ready();
 
     /* Enter event loop */
     kl_server_run(&server);
 
     log_info("[hull:c] server stopped");
+    hl_upgrade_disarm();
+
+    /* Join every thread that can emit audit events or log lines before
+     * the audit ring and the log sink go away. */
+    hl_sched_destroy(sched);
+    hl_outbox_stop(outbox);
+
+    /* A dev reload may have swapped in another runtime */
+    if (reload.owned)
+        rt = reload.rt;
+
+    {
+        const HlGcStats *gs = &rt->gc_stats;
+        log_info("[hull:c] gc: %llu boundary pauses, %.1f ms total, "
+                 "max %.0f us, %llu over %d us budget, %llu KB freed",
+                 (unsigned long long)gs->runs, (double)gs->total_ns / 1e6,
+                 (double)gs->max_ns / 1e3, (unsigned long long)gs->over_budget,
+                 gc_budget_us, (unsigned long long)(gs->bytes_freed / 1024));
+    }
+
+    hl_audit_stop();
+    if (hl_audit_enabled)
+        log_info("[hull:c] audit: %llu events written, %llu dropped",
+                 (unsigned long long)hl_audit_written(),
+                 (unsigned long long)hl_audit_dropped());
 
     /* Cleanup — free manifest strings AFTER server stops
      * (env_cfg and http_cfg reference them during runtime) */
     rt->vt->free_manifest_strings(rt, &manifest);
     rt->vt->destroy(rt);
+    if (reload.owned)
+        free(rt);
+    hl_smtp_pool_destroy(smtp_pool);
+    hl_outbox_destroy(outbox); /* after the runtime: wakes are no-ops */
     if (client_tls_ctx)
         kl_tls_mbedtls_ctx_destroy(client_tls_ctx);
+    if (sched_tls_ctx)
+        kl_tls_mbedtls_ctx_destroy(sched_tls_ctx);
     if (server_tls_ctx)
         kl_tls_mbedtls_ctx_destroy(server_tls_ctx);
     ret = 0;
@@ -723,7 +1111,10 @@ cleanup_db:
     sqlite3_close(db);
     free_route_allocs(&alloc);
 
-    log_debug("[hull:c] peak memory: %zu bytes", hl_alloc_peak(&alloc));
+    log_debug("[hull:c] peak memory: %zu bytes (%s, %zu reserved in slabs)",
+              hl_alloc_peak(&alloc), hl_alloc_backend(&alloc),
+              hl_alloc_pool_reserved(&alloc));
+    hl_alloc_destroy(&alloc);
 
     return ret;
 }
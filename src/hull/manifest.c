@@ -29,6 +29,36 @@ static int csp_is_valid(const char *s)
     return 1;
 }
 
+/* ── Comparison ────────────────────────────────────────────────────── */
+
+static int str_equal(const char *a, const char *b)
+{
+    return (a && b) ? strcmp(a, b) == 0 : a == b;
+}
+
+static int list_equal(const char *const *a, int na,
+                      const char *const *b, int nb)
+{
+    if (na != nb)
+        return 0;
+    for (int i = 0; i < na; i++)
+        if (!str_equal(a[i], b[i]))
+            return 0;
+    return 1;
+}
+
+int hl_manifest_equal(const HlManifest *a, const HlManifest *b)
+{
+    return a->present == b->present &&
+           a->csp_set == b->csp_set &&
+           a->access_log == b->access_log &&
+           str_equal(a->csp, b->csp) &&
+           list_equal(a->fs_read, a->fs_read_count, b->fs_read, b->fs_read_count) &&
+           list_equal(a->fs_write, a->fs_write_count, b->fs_write, b->fs_write_count) &&
+           list_equal(a->env, a->env_count, b->env, b->env_count) &&
+           list_equal(a->hosts, a->hosts_count, b->hosts, b->hosts_count);
+}
+
 #ifdef HL_ENABLE_LUA
 #include "lua.h"
 #include "lauxlib.h"
@@ -118,6 +148,11 @@ int hl_manifest_extract(lua_State *L, HlManifest *out)
     }
     lua_pop(L, 1);
 
+    /* access_log = true */
+    lua_getfield(L, manifest_idx, "access_log");
+    out->access_log = lua_toboolean(L, -1);
+    lua_pop(L, 1);
+
     lua_pop(L, 1); /* pop manifest table */
     return 0;
 }
@@ -220,6 +255,11 @@ int hl_manifest_extract_js(JSContext *ctx, HlManifest *out)
     }
     JS_FreeValue(ctx, csp_val);
 
+    /* access_log = true */
+    JSValue al_val = JS_GetPropertyStr(ctx, manifest, "access_log");
+    out->access_log = JS_IsBool(al_val) && JS_ToBool(ctx, al_val);
+    JS_FreeValue(ctx, al_val);
+
     JS_FreeValue(ctx, manifest);
     return 0;
 }
@@ -0,0 +1,122 @@
+/*
+ * reload.c — In-process app reload for hull dev
+ *
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#include "hull/reload.h"
+#include "hull/cap/crypto.h"
+#include "hull/cap/time.h"
+#include "log.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/* ── Reload ────────────────────────────────────────────────────────── */
+
+/* Tear down a runtime that never went live */
+static void discard(HlRuntime *rt, HlManifest *m)
+{
+    if (m)
+        rt->vt->free_manifest_strings(rt, m);
+    rt->vt->destroy(rt);
+    free(rt);
+}
+
+int hl_reload_run(HlReload *r)
+{
+    HlRuntime *old = r->rt;
+    HlRuntime *rt = calloc(1, r->rt_size);
+    if (!rt)
+        return -1;
+
+    rt->vt = old->vt;
+    rt->db = old->db;
+    rt->stmt_cache = old->stmt_cache;
+    rt->alloc = old->alloc;
+    rt->app_vfs = old->app_vfs;
+    rt->platform_vfs = old->platform_vfs;
+
+    if (rt->vt->init(rt, r->rt_cfg) != 0) {
+        log_error("[hull:c] reload: %s init failed", rt->vt->name);
+        free(rt);
+        return -1;
+    }
+    if (rt->vt->load_app(rt, r->entry_point) != 0) {
+        log_error("[hull:c] reload: failed to load %s, keeping previous version",
+                  r->entry_point);
+        discard(rt, NULL);
+        return -1;
+    }
+
+    /* Capabilities and the sandbox were fixed at startup */
+    HlManifest m;
+    memset(&m, 0, sizeof(m));
+    rt->vt->extract_manifest(rt, &m);
+    if (!hl_manifest_equal(&m, r->manifest)) {
+        log_info("[hull:c] reload: manifest changed, restart needed");
+        discard(rt, &m);
+        return 1;
+    }
+
+    if (rt->vt->adopt_routes(rt, old) != 0) {
+        log_info("[hull:c] reload: routes or middleware changed, restart needed");
+        discard(rt, &m);
+        return 1;
+    }
+
+    /* The cap configs point into *r->manifest: same content, new strings */
+    rt->fs_cfg = old->fs_cfg;
+    rt->env_cfg = old->env_cfg;
+    rt->http_cfg = old->http_cfg;
+    rt->smtp_cfg = old->smtp_cfg;
+    rt->outbox = old->outbox;
+    rt->manifest = r->manifest;
+    rt->csp_policy = r->manifest->csp_set ? m.csp : old->csp_policy;
+    rt->gc_stats = old->gc_stats;
+
+    old->vt->free_manifest_strings(old, r->manifest);
+    *r->manifest = m;
+    old->vt->destroy(old);
+    if (r->owned)
+        free(old);
+
+    r->rt = rt;
+    r->owned = 1;
+    r->count++;
+    return 0;
+}
+
+/* ── Endpoint ──────────────────────────────────────────────────────── */
+
+static void reply(KlResponse *res, int status, const char *body)
+{
+    kl_response_status(res, status);
+    kl_response_header(res, "Content-Type", "text/plain");
+    kl_response_body(res, body, strlen(body));
+}
+
+void hl_reload_handler(KlRequest *req, KlResponse *res, void *user_data)
+{
+    HlReload *r = (HlReload *)user_data;
+
+    size_t len = 0;
+    const char *token = kl_request_header_len(req, HL_RELOAD_HEADER, &len);
+    if (!r || !r->token || !token || len != strlen(r->token) ||
+        !hl_cap_crypto_equal(token, r->token, len)) {
+        reply(res, 404, "Not Found");
+        return;
+    }
+
+    int64_t t0 = hl_cap_time_clock_ns();
+    int rc = hl_reload_run(r);
+    if (rc == 0) {
+        log_info("[hull:c] reloaded %s in %.1f ms", r->entry_point,
+                 (double)(hl_cap_time_clock_ns() - t0) / 1e6);
+        reply(res, 200, "reloaded\n");
+    } else if (rc > 0) {
+        reply(res, 409, "restart\n");
+    } else {
+        reply(res, 500, "load failed\n");
+    }
+}
@@ -22,6 +22,102 @@
 #include <string.h>
 #include <stdio.h>
 
+/* ── Upload object ──────────────────────────────────────────────────── */
+
+/*
+ * req.upload of a route declared with body: "stream" | "spool" | "blob":
+ *   { mode, size }                                  (all)
+ *   { path, read(n?), keep(name) }                  (spool)
+ *   { table, column, rowid }                        (blob)
+ * The methods work only while the request is being handled.
+ */
+
+static HlBodyUpload *js_check_upload(JSContext *ctx, JSValue *func_data)
+{
+    HlJS *js = (HlJS *)JS_GetContextOpaque(ctx);
+    int64_t id = 0;
+    JS_ToInt64(ctx, &id, func_data[0]);
+    if (!js || !js->upload || (int64_t)(intptr_t)js->upload != id) {
+        JS_ThrowTypeError(ctx, "upload is only available during its request");
+        return NULL;
+    }
+    return js->upload;
+}
+
+/* upload.read(n?) → ArrayBuffer of the next n bytes (default 64 KB), null at the end */
+static JSValue js_upload_read(JSContext *ctx, JSValueConst this_val,
+                              int argc, JSValueConst *argv, int magic,
+                              JSValue *func_data)
+{
+    (void)this_val;
+    (void)magic;
+    HlBodyUpload *up = js_check_upload(ctx, func_data);
+    if (!up)
+        return JS_EXCEPTION;
+
+    int64_t n = 65536;
+    if (argc >= 1 && !JS_IsUndefined(argv[0]) && JS_ToInt64(ctx, &n, argv[0]) != 0)
+        return JS_EXCEPTION;
+    if (n <= 0 || n > HL_BODY_MAX_SIZE)
+        return JS_ThrowRangeError(ctx, "read size must be 1..1048576");
+
+    char *buf = js_malloc(ctx, (size_t)n);
+    if (!buf)
+        return JS_EXCEPTION;
+    int64_t got = hl_cap_body_read(up, buf, (size_t)n);
+    JSValue ret;
+    if (got < 0)
+        ret = JS_ThrowInternalError(ctx, "upload read failed");
+    else if (got == 0)
+        ret = JS_NULL;
+    else
+        ret = JS_NewArrayBufferCopy(ctx, (const uint8_t *)buf, (size_t)got);
+    js_free(ctx, buf);
+    return ret;
+}
+
+/* upload.keep(name) → path the file was kept at, or null */
+static JSValue js_upload_keep(JSContext *ctx, JSValueConst this_val,
+                              int argc, JSValueConst *argv, int magic,
+                              JSValue *func_data)
+{
+    (void)this_val;
+    (void)magic;
+    HlBodyUpload *up = js_check_upload(ctx, func_data);
+    if (!up)
+        return JS_EXCEPTION;
+    if (argc < 1)
+        return JS_ThrowTypeError(ctx, "keep requires a file name");
+    const char *name = JS_ToCString(ctx, argv[0]);
+    if (!name)
+        return JS_EXCEPTION;
+    int rc = hl_cap_body_keep(up, name);
+    JS_FreeCString(ctx, name);
+    return rc == 0 ? JS_NewString(ctx, up->path) : JS_NULL;
+}
+
+static JSValue js_make_upload(JSContext *ctx, HlBodyUpload *up)
+{
+    JSValue obj = JS_NewObject(ctx);
+    JS_SetPropertyStr(ctx, obj, "mode",
+                      JS_NewString(ctx, hl_cap_body_mode_name(up->mode)));
+    JS_SetPropertyStr(ctx, obj, "size", JS_NewInt64(ctx, up->size));
+
+    if (up->mode == HL_BODY_SPOOL) {
+        JSValue id = JS_NewInt64(ctx, (int64_t)(intptr_t)up);
+        JS_SetPropertyStr(ctx, obj, "path", JS_NewString(ctx, up->path));
+        JS_SetPropertyStr(ctx, obj, "read",
+                          JS_NewCFunctionData(ctx, js_upload_read, 1, 0, 1, &id));
+        JS_SetPropertyStr(ctx, obj, "keep",
+                          JS_NewCFunctionData(ctx, js_upload_keep, 1, 0, 1, &id));
+    } else if (up->mode == HL_BODY_BLOB) {
+        JS_SetPropertyStr(ctx, obj, "table", JS_NewString(ctx, up->table));
+        JS_SetPropertyStr(ctx, obj, "column", JS_NewString(ctx, up->column));
+        JS_SetPropertyStr(ctx, obj, "rowid", JS_NewInt64(ctx, up->rowid));
+    }
+    return obj;
+}
+
 /* ── Request object ─────────────────────────────────────────────────── */
 
 /* req.header(name) — case-insensitive header lookup.
@@ -66,6 +162,7 @@ static JSValue js_req_header(JSContext *ctx, JSValueConst this_val,
  *     query:   { limit: "10" },
  *     headers: { "content-type": "application/json" },
  *     body:    "..." or parsed object,
+ *     upload:  {...} (routes with an upload body mode),
  *     ctx:     {}
  *   }
  */
@@ -148,7 +245,12 @@ JSValue hl_js_make_request(JSContext *ctx, KlRequest *req)
     JS_SetPropertyStr(ctx, obj, "headers", headers_obj);
 
     /* body — extract from buffer reader if available */
-    if (req->body_reader) {
+    HlJS *js = (HlJS *)JS_GetContextOpaque(ctx);
+    HlBodyUpload *up = js ? js->upload : NULL;
+    if (up) {
+        JS_SetPropertyStr(ctx, obj, "upload", js_make_upload(ctx, up));
+        JS_SetPropertyStr(ctx, obj, "body", JS_NULL);
+    } else if (req->body_reader) {
         const char *data;
         size_t len = hl_cap_body_data(req->body_reader, &data);
         if (len > 0)
@@ -162,9 +264,10 @@ JSValue hl_js_make_request(JSContext *ctx, KlRequest *req)
 
     /* ctx — per-request context object (middleware → handler).
      * If req->ctx carries a JSON string from a prior middleware dispatch,
-     * parse it; otherwise start with an empty object. */
-    if (req->ctx) {
-        const char *json_ctx = (const char *)req->ctx;
+     * parse it; otherwise start with an empty object. A stream upload's
+     * onChunk calls carry theirs, which started from that one. */
+    const char *json_ctx = up && up->state ? up->state : (const char *)req->ctx;
+    if (json_ctx) {
         JSValue parsed = JS_ParseJSON(ctx, json_ctx, strlen(json_ctx), "<ctx>");
         if (JS_IsException(parsed)) {
             JS_FreeValue(ctx, JS_GetException(ctx));
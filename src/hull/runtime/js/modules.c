@@ -10,6 +10,8 @@
 
 #include "hull/runtime/js.h"
 #include "hull/limits.h"
+#include "hull/parse_size.h"
+#include "hull/cap/body.h"
 #include "hull/cap/db.h"
 #include "hull/cap/time.h"
 #include "hull/cap/env.h"
@@ -17,10 +19,14 @@
 #include "hull/cap/smtp.h"
 #include "hull/cap/crypto.h"
 #include "hull/cap/fs.h"
+#include "hull/cap/outbox.h"
+#include "hull/cap/sched.h"
+#include "hull/cap/template.h"
 #include "quickjs.h"
 
 #include "log.h"
 
+#include <ctype.h>
 #include <sqlite3.h>
 #include <stdlib.h>
 #include <string.h>
@@ -39,9 +45,97 @@ static void secure_zero(void *p, size_t n)
  * Provides route registration: app.get(), app.post(), app.use(), etc.
  * Routes are stored in globalThis.__hull_routes (array of functions)
  * and globalThis.__hull_route_defs (array of {method, pattern} objects)
- * for the C router to consume at startup.
+ * for the C router to consume at startup; a route's options add
+ * {body, max_body, dir, table, column, chunk_id}. app.every() / app.at() add
+ * {kind, spec, name, jitter, handler_id} to globalThis.__hull_jobs.
  * ════════════════════════════════════════════════════════════════════ */
 
+/*
+ * Copy the body options of app.post(pattern, handler, opts) into `def`;
+ * an onChunk callback goes into `routes`. The manifest-dependent checks
+ * run when the routes are wired (hl_cap_body_check). Returns 0, or -1
+ * with an exception thrown.
+ *
+ *   body    = "buffer" | "stream" | "spool" | "blob"
+ *   maxBody = bytes or a size string ("500m")
+ *   dir     = spool directory (inside a manifest fs.write path)
+ *   table, column = blob destination
+ *   onChunk = (req, chunk) => {}, required for "stream"
+ */
+static int js_app_route_opts(JSContext *ctx, JSValueConst opts,
+                             JSValueConst routes, JSValueConst def)
+{
+    int mode = HL_BODY_BUFFER;
+    JSValue v = JS_GetPropertyStr(ctx, opts, "body");
+    if (!JS_IsUndefined(v)) {
+        const char *s = JS_IsString(v) ? JS_ToCString(ctx, v) : NULL;
+        mode = hl_cap_body_mode(s);
+        if (s) JS_FreeCString(ctx, s);
+        if (mode < 0) {
+            JS_FreeValue(ctx, v);
+            JS_ThrowTypeError(ctx, "body must be \"buffer\", \"stream\", \"spool\" or \"blob\"");
+            return -1;
+        }
+        JS_SetPropertyStr(ctx, def, "body", JS_DupValue(ctx, v));
+    }
+    JS_FreeValue(ctx, v);
+
+    v = JS_GetPropertyStr(ctx, opts, "maxBody");
+    if (!JS_IsUndefined(v)) {
+        int64_t n = -1;
+        if (JS_IsString(v)) {
+            const char *s = JS_ToCString(ctx, v);
+            n = s ? hl_parse_size(s) : -1;
+            if (s) JS_FreeCString(ctx, s);
+        } else if (JS_IsNumber(v)) {
+            double d;
+            JS_ToFloat64(ctx, &d, v);
+            n = (d >= 1 && d <= 9007199254740991.0 && d == (double)(int64_t)d)
+              ? (int64_t)d : -1;
+        }
+        JS_FreeValue(ctx, v);
+        if (n <= 0) {
+            JS_ThrowTypeError(ctx, "maxBody must be a positive integer or size string");
+            return -1;
+        }
+        JS_SetPropertyStr(ctx, def, "max_body", JS_NewInt64(ctx, n));
+    }
+
+    static const char *strings[] = { "dir", "table", "column", NULL };
+    for (int i = 0; strings[i]; i++) {
+        v = JS_GetPropertyStr(ctx, opts, strings[i]);
+        if (!JS_IsUndefined(v) && !JS_IsString(v)) {
+            JS_FreeValue(ctx, v);
+            JS_ThrowTypeError(ctx, "%s must be a string", strings[i]);
+            return -1;
+        }
+        if (!JS_IsUndefined(v))
+            JS_SetPropertyStr(ctx, def, strings[i], v);
+    }
+
+    v = JS_GetPropertyStr(ctx, opts, "onChunk");
+    int has_chunk = JS_IsFunction(ctx, v);
+    if (!has_chunk && !JS_IsUndefined(v)) {
+        JS_FreeValue(ctx, v);
+        JS_ThrowTypeError(ctx, "onChunk must be a function");
+        return -1;
+    }
+    if ((mode == HL_BODY_STREAM) != has_chunk) {
+        JS_FreeValue(ctx, v);
+        JS_ThrowTypeError(ctx, "onChunk goes with body: \"stream\" (and only with it)");
+        return -1;
+    }
+    if (has_chunk) {
+        JSValue len_val = JS_GetPropertyStr(ctx, routes, "length");
+        int32_t chunk_id = 0;
+        JS_ToInt32(ctx, &chunk_id, len_val);
+        JS_FreeValue(ctx, len_val);
+        JS_SetPropertyUint32(ctx, routes, (uint32_t)chunk_id, v);
+        JS_SetPropertyStr(ctx, def, "chunk_id", JS_NewInt32(ctx, chunk_id));
+    }
+    return 0;
+}
+
 /* Helper: register a route with given method string */
 static JSValue js_app_route(JSContext *ctx, JSValueConst this_val,
                              int argc, JSValueConst *argv, int magic)
@@ -66,6 +160,10 @@ static JSValue js_app_route(JSContext *ctx, JSValueConst this_val,
         JS_FreeCString(ctx, pattern);
         return JS_ThrowTypeError(ctx, "handler must be a function");
     }
+    if (argc >= 3 && !JS_IsUndefined(argv[2]) && !JS_IsObject(argv[2])) {
+        JS_FreeCString(ctx, pattern);
+        return JS_ThrowTypeError(ctx, "route options must be an object");
+    }
 
     JSValue global = JS_GetGlobalObject(ctx);
 
@@ -98,14 +196,20 @@ static JSValue js_app_route(JSContext *ctx, JSValueConst this_val,
                       JS_NewString(ctx, method_names[magic]));
     JS_SetPropertyStr(ctx, def, "pattern", JS_NewString(ctx, pattern));
     JS_SetPropertyStr(ctx, def, "handler_id", JS_NewInt32(ctx, idx));
-    JS_SetPropertyUint32(ctx, defs, (uint32_t)idx, def);
+    int rc = 0;
+    if (argc >= 3 && JS_IsObject(argv[2]))
+        rc = js_app_route_opts(ctx, argv[2], routes, def);
+    if (rc == 0)
+        JS_SetPropertyUint32(ctx, defs, (uint32_t)idx, def);
+    else
+        JS_FreeValue(ctx, def);   /* rejected: handler slot stays unused */
 
     JS_FreeValue(ctx, defs);
     JS_FreeValue(ctx, routes);
     JS_FreeValue(ctx, global);
     JS_FreeCString(ctx, pattern);
 
-    return JS_UNDEFINED;
+    return rc == 0 ? JS_UNDEFINED : JS_EXCEPTION;
 }
 
 /* app.use(method, pattern, handler) — middleware registration */
@@ -228,6 +332,135 @@ static JSValue js_app_use_post(JSContext *ctx, JSValueConst this_val,
     return JS_UNDEFINED;
 }
 
+/* Interval argument: a number of seconds or a string such as "30s" */
+static int js_app_interval(JSContext *ctx, JSValueConst v, int64_t *ms)
+{
+    if (JS_IsNumber(v)) {
+        double n = 0;
+        JS_ToFloat64(ctx, &n, v);
+        n *= 1000;
+        if (!(n >= 0 && n <= (double)HL_SCHED_MAX_INTERVAL_MS))
+            return -1;
+        *ms = (int64_t)n;
+        return 0;
+    }
+    if (!JS_IsString(v))
+        return -1;
+    const char *s = JS_ToCString(ctx, v);
+    if (!s)
+        return -1;
+    int rc = hl_sched_interval_parse(s, ms);
+    JS_FreeCString(ctx, s);
+    return rc;
+}
+
+/*
+ * app.every(interval, fn, opts?) / app.at(cron, fn, opts?) — store fn
+ * with the route handlers and the job in __hull_jobs.
+ * opts: name (logs and metrics), jitter (interval, default 0).
+ * magic: 0 = every, 1 = at.
+ */
+static JSValue js_app_job(JSContext *ctx, JSValueConst this_val,
+                          int argc, JSValueConst *argv, int magic)
+{
+    (void)this_val;
+    const char *kind = magic ? "at" : "every";
+    if (argc < 2 || !JS_IsFunction(ctx, argv[1]))
+        return JS_ThrowTypeError(ctx, "app.%s requires (%s, handler)", kind,
+                                 magic ? "cron" : "interval");
+
+    char spec[32];
+    const char *cron = NULL;
+    if (!magic) {
+        int64_t ms;
+        if (js_app_interval(ctx, argv[0], &ms) != 0 ||
+            hl_sched_interval_check(ms) != 0)
+            return JS_ThrowRangeError(ctx, "app.every: interval must be 100ms .. 366d "
+                                      "(seconds or \"30s\", \"5m\", ...)");
+        snprintf(spec, sizeof(spec), "%lld", (long long)ms);
+    } else {
+        cron = JS_ToCString(ctx, argv[0]);
+        if (!cron)
+            return JS_EXCEPTION;
+        HlCron parsed;
+        if (hl_cron_parse(cron, &parsed) != 0) {
+            JSValue err = JS_ThrowTypeError(ctx, "app.at: invalid cron expression '%s'",
+                                            cron);
+            JS_FreeCString(ctx, cron);
+            return err;
+        }
+    }
+
+    JSValue name = JS_UNDEFINED;
+    int64_t jitter = 0;
+    if (argc > 2 && JS_IsObject(argv[2])) {
+        name = JS_GetPropertyStr(ctx, argv[2], "name");
+        JSValue j = JS_GetPropertyStr(ctx, argv[2], "jitter");
+        int bad = !JS_IsUndefined(j) && js_app_interval(ctx, j, &jitter) != 0;
+        JS_FreeValue(ctx, j);
+        if (bad) {
+            JS_FreeValue(ctx, name);
+            if (cron) JS_FreeCString(ctx, cron);
+            return JS_ThrowRangeError(ctx, "app.%s: invalid jitter", kind);
+        }
+    }
+    if (JS_IsUndefined(name)) {
+        const char *arg = JS_ToCString(ctx, argv[0]);
+        char buf[HL_SCHED_NAME_MAX];
+        snprintf(buf, sizeof(buf), "%s %s", kind, arg ? arg : "");
+        if (arg) JS_FreeCString(ctx, arg);
+        name = JS_NewString(ctx, buf);
+    }
+
+    JSValue global = JS_GetGlobalObject(ctx);
+
+    JSValue jobs = JS_GetPropertyStr(ctx, global, "__hull_jobs");
+    if (JS_IsUndefined(jobs)) {
+        jobs = JS_NewArray(ctx);
+        JS_SetPropertyStr(ctx, global, "__hull_jobs", JS_DupValue(ctx, jobs));
+    }
+    JSValue len_val = JS_GetPropertyStr(ctx, jobs, "length");
+    int32_t idx = 0;
+    JS_ToInt32(ctx, &idx, len_val);
+    JS_FreeValue(ctx, len_val);
+    if (idx >= HL_SCHED_MAX_JOBS) {
+        JS_FreeValue(ctx, jobs);
+        JS_FreeValue(ctx, global);
+        JS_FreeValue(ctx, name);
+        if (cron) JS_FreeCString(ctx, cron);
+        return JS_ThrowRangeError(ctx, "app.%s: too many jobs (max %d)", kind,
+                                  HL_SCHED_MAX_JOBS);
+    }
+
+    /* Store handler in __hull_routes (same array as route handlers) */
+    JSValue routes = JS_GetPropertyStr(ctx, global, "__hull_routes");
+    if (JS_IsUndefined(routes)) {
+        routes = JS_NewArray(ctx);
+        JS_SetPropertyStr(ctx, global, "__hull_routes", JS_DupValue(ctx, routes));
+    }
+    JSValue routes_len_val = JS_GetPropertyStr(ctx, routes, "length");
+    int32_t handler_id = 0;
+    JS_ToInt32(ctx, &handler_id, routes_len_val);
+    JS_FreeValue(ctx, routes_len_val);
+    JS_SetPropertyUint32(ctx, routes, (uint32_t)handler_id,
+                         JS_DupValue(ctx, argv[1]));
+    JS_FreeValue(ctx, routes);
+
+    JSValue entry = JS_NewObject(ctx);
+    JS_SetPropertyStr(ctx, entry, "kind", JS_NewString(ctx, kind));
+    JS_SetPropertyStr(ctx, entry, "spec", JS_NewString(ctx, cron ? cron : spec));
+    JS_SetPropertyStr(ctx, entry, "name", name);
+    JS_SetPropertyStr(ctx, entry, "jitter", JS_NewInt64(ctx, jitter));
+    JS_SetPropertyStr(ctx, entry, "handler_id", JS_NewInt32(ctx, handler_id));
+    JS_SetPropertyUint32(ctx, jobs, (uint32_t)idx, entry);
+
+    JS_FreeValue(ctx, jobs);
+    JS_FreeValue(ctx, global);
+    if (cron) JS_FreeCString(ctx, cron);
+
+    return JS_UNDEFINED;
+}
+
 /* app.config(obj) — application configuration */
 static JSValue js_app_config(JSContext *ctx, JSValueConst this_val,
                               int argc, JSValueConst *argv)
@@ -342,6 +575,12 @@ static int js_app_module_init(JSContext *ctx, JSModuleDef *m)
                       JS_NewCFunction(ctx, js_app_use, "use", 3));
     JS_SetPropertyStr(ctx, app, "usePost",
                       JS_NewCFunction(ctx, js_app_use_post, "usePost", 3));
+    JS_SetPropertyStr(ctx, app, "every",
+        JS_NewCFunctionMagic(ctx, (JSCFunctionMagic *)js_app_job,
+                             "every", 2, JS_CFUNC_generic_magic, 0));
+    JS_SetPropertyStr(ctx, app, "at",
+        JS_NewCFunctionMagic(ctx, (JSCFunctionMagic *)js_app_job,
+                             "at", 2, JS_CFUNC_generic_magic, 1));
     JS_SetPropertyStr(ctx, app, "config",
                       JS_NewCFunction(ctx, js_app_config, "config", 1));
     JS_SetPropertyStr(ctx, app, "static",
@@ -369,6 +608,7 @@ int hl_js_init_app_module(JSContext *ctx, HlJS *js)
  * hull:db module
  *
  * db.query(sql, params?) → array of row objects
+ * db.each(sql, params?, fn) → rows visited; fn(row) per row, false stops
  * db.exec(sql, params?)  → number of rows affected
  * db.lastId()            → last insert rowid
  * ════════════════════════════════════════════════════════════════════ */
@@ -380,45 +620,76 @@ typedef struct {
     int32_t    row_count;
 } JsQueryCtx;
 
-static int js_query_row_cb(void *opaque, HlColumn *cols, int ncols)
+/* One row as an object keyed by column name */
+static JSValue js_make_row(JSContext *ctx, HlColumn *cols, int ncols)
 {
-    JsQueryCtx *qc = (JsQueryCtx *)opaque;
-
-    JSValue row = JS_NewObject(qc->ctx);
+    JSValue row = JS_NewObject(ctx);
     for (int i = 0; i < ncols; i++) {
         JSValue val;
         switch (cols[i].value.type) {
         case HL_TYPE_INT:
-            val = JS_NewInt64(qc->ctx, cols[i].value.i);
+            val = JS_NewInt64(ctx, cols[i].value.i);
             break;
         case HL_TYPE_DOUBLE:
-            val = JS_NewFloat64(qc->ctx, cols[i].value.d);
+            val = JS_NewFloat64(ctx, cols[i].value.d);
             break;
         case HL_TYPE_TEXT:
-            val = JS_NewStringLen(qc->ctx, cols[i].value.s,
+            val = JS_NewStringLen(ctx, cols[i].value.s,
                                   cols[i].value.len);
             break;
         case HL_TYPE_BLOB:
-            val = JS_NewArrayBufferCopy(qc->ctx,
+            val = JS_NewArrayBufferCopy(ctx,
                                          (const uint8_t *)cols[i].value.s,
                                          cols[i].value.len);
             break;
         case HL_TYPE_BOOL:
-            val = JS_NewBool(qc->ctx, cols[i].value.b);
+            val = JS_NewBool(ctx, cols[i].value.b);
             break;
         case HL_TYPE_NIL:
         default:
             val = JS_NULL;
             break;
         }
-        JS_SetPropertyStr(qc->ctx, row, cols[i].name, val);
+        JS_SetPropertyStr(ctx, row, cols[i].name, val);
     }
+    return row;
+}
+
+static int js_query_row_cb(void *opaque, HlColumn *cols, int ncols)
+{
+    JsQueryCtx *qc = (JsQueryCtx *)opaque;
 
+    JSValue row = js_make_row(qc->ctx, cols, ncols);
     JS_SetPropertyUint32(qc->ctx, qc->array, (uint32_t)qc->row_count, row);
     qc->row_count++;
     return 0;
 }
 
+/* Callback context for db.each: rows go to a JS function one at a time */
+typedef struct {
+    JSContext  *ctx;
+    JSValueConst fn;
+    int32_t     row_count;
+    int         failed;     /* fn threw: the exception is pending */
+} JsEachCtx;
+
+static int js_each_row_cb(void *opaque, HlColumn *cols, int ncols)
+{
+    JsEachCtx *ec = (JsEachCtx *)opaque;
+
+    JSValue row = js_make_row(ec->ctx, cols, ncols);
+    JSValue ret = JS_Call(ec->ctx, ec->fn, JS_UNDEFINED, 1, &row);
+    JS_FreeValue(ec->ctx, row);
+    if (JS_IsException(ret)) {
+        ec->failed = 1;
+        return -1;
+    }
+    ec->row_count++;
+    int stop = JS_IsBool(ret) && !JS_ToBool(ec->ctx, ret);
+    JS_FreeValue(ec->ctx, ret);
+    return stop;
+}
+
 /* Marshal JS values to HlValue array for parameter binding */
 static int js_to_hl_values(JSContext *ctx, JSValueConst arr,
                               HlValue **out_params, int *out_count)
@@ -574,6 +845,60 @@ static JSValue js_db_query_impl(JSContext *ctx, JSValueConst this_val,
     return qc.array;
 }
 
+/* db.each(sql, params?, fn) — rows are never collected into an array */
+static JSValue js_db_each(JSContext *ctx, JSValueConst this_val,
+                           int argc, JSValueConst *argv)
+{
+    (void)this_val;
+    HlJS *js = (HlJS *)JS_GetContextOpaque(ctx);
+    if (!js || !js->base.stmt_cache)
+        return JS_ThrowInternalError(ctx, "database not available");
+
+    int fn_idx = argc >= 2 && JS_IsFunction(ctx, argv[1]) ? 1 : 2;
+    if (argc <= fn_idx || !JS_IsFunction(ctx, argv[fn_idx]))
+        return JS_ThrowTypeError(ctx, "db.each requires (sql, params?, fn)");
+
+    const char *sql = JS_ToCString(ctx, argv[0]);
+    if (!sql)
+        return JS_EXCEPTION;
+
+    if (!js_is_stdlib_caller(ctx) && hl_cap_db_check_namespace(sql) != 0) {
+        JS_FreeCString(ctx, sql);
+        return JS_ThrowInternalError(ctx,
+            "access denied: _hull_* tables are reserved");
+    }
+
+    HlValue *params = NULL;
+    int nparams = 0;
+    if (fn_idx == 2) {
+        if (js_to_hl_values(ctx, argv[1], &params, &nparams) != 0) {
+            JS_FreeCString(ctx, sql);
+            return JS_ThrowTypeError(ctx, "params must be an array");
+        }
+    }
+
+    JsEachCtx ec = {
+        .ctx = ctx,
+        .fn = argv[fn_idx],
+        .row_count = 0,
+        .failed = 0,
+    };
+
+    int rc = hl_cap_db_each(js->base.stmt_cache, sql, params, nparams,
+                            js_each_row_cb, &ec, js->base.alloc);
+
+    js_free_hl_values(ctx, params, nparams);
+    JS_FreeCString(ctx, sql);
+
+    if (ec.failed)
+        return JS_EXCEPTION; /* fn's exception */
+    if (rc != 0)
+        return JS_ThrowInternalError(ctx, "query failed: %s",
+                                     sqlite3_errmsg(js->base.db));
+
+    return JS_NewInt32(ctx, ec.row_count);
+}
+
 /* db.exec implementation */
 static JSValue js_db_exec_impl(JSContext *ctx, JSValueConst this_val,
                                 int argc, JSValueConst *argv)
@@ -675,6 +1000,8 @@ static int js_db_module_init(JSContext *ctx, JSModuleDef *m)
     JSValue db = JS_NewObject(ctx);
     JS_SetPropertyStr(ctx, db, "query",
                       JS_NewCFunction(ctx, js_db_query, "query", 2));
+    JS_SetPropertyStr(ctx, db, "each",
+                      JS_NewCFunction(ctx, js_db_each, "each", 3));
     JS_SetPropertyStr(ctx, db, "exec",
                       JS_NewCFunction(ctx, js_db_exec, "exec", 2));
     JS_SetPropertyStr(ctx, db, "lastId",
@@ -825,6 +1152,7 @@ int hl_js_init_env_module(JSContext *ctx, HlJS *js)
  * hull:crypto module
  *
  * crypto.sha256(data)          → hex string
+ * crypto.sha256Many([data...]) → [hex...]
  * crypto.random(n)             → ArrayBuffer of n random bytes
  * crypto.hashPassword(pw)      → hash string
  * crypto.verifyPassword(pw, h) → boolean
@@ -858,6 +1186,64 @@ static JSValue js_crypto_sha256(JSContext *ctx, JSValueConst this_val,
     return JS_NewString(ctx, hex);
 }
 
+/* crypto.sha256Many([data, ...]) → [hex, ...] — hashed as one batch */
+static JSValue js_crypto_sha256_many(JSContext *ctx, JSValueConst this_val,
+                                     int argc, JSValueConst *argv)
+{
+    (void)this_val;
+    if (argc < 1 || !JS_IsArray(ctx, argv[0]))
+        return JS_ThrowTypeError(ctx, "crypto.sha256Many requires (array)");
+
+    JSValue len_val = JS_GetPropertyStr(ctx, argv[0], "length");
+    uint32_t n = 0;
+    int rc = JS_ToUint32(ctx, &n, len_val);
+    JS_FreeValue(ctx, len_val);
+    if (rc < 0)
+        return JS_EXCEPTION;
+    if ((size_t)n >= SIZE_MAX / sizeof(HlSha256Item))
+        return JS_ThrowRangeError(ctx, "crypto.sha256Many: too many items");
+
+    HlSha256Item *items = js_mallocz(ctx, (size_t)n * sizeof(*items) + 1);
+    if (!items)
+        return JS_EXCEPTION;
+
+    JSValue result = JS_EXCEPTION;
+    uint32_t got = 0;
+    for (; got < n; got++) {
+        JSValue v = JS_GetPropertyUint32(ctx, argv[0], got);
+        size_t len;
+        const char *data = JS_ToCStringLen(ctx, &len, v);
+        JS_FreeValue(ctx, v);
+        if (!data)
+            goto done;
+        items[got].data = data;
+        items[got].len = len;
+    }
+
+    if (hl_cap_crypto_sha256_many(items, (size_t)n) != 0) {
+        JS_ThrowInternalError(ctx, "sha256 failed");
+        goto done;
+    }
+
+    result = JS_NewArray(ctx);
+    for (uint32_t i = 0; i < n && !JS_IsException(result); i++) {
+        char hex[65];
+        for (int j = 0; j < 32; j++)
+            snprintf(hex + j * 2, 3, "%02x", items[i].hash[j]);
+        if (JS_SetPropertyUint32(ctx, result, i,
+                                 JS_NewStringLen(ctx, hex, 64)) < 0) {
+            JS_FreeValue(ctx, result);
+            result = JS_EXCEPTION;
+        }
+    }
+
+done:
+    for (uint32_t i = 0; i < got; i++)
+        JS_FreeCString(ctx, items[i].data);
+    js_free(ctx, items);
+    return result;
+}
+
 static JSValue js_crypto_random(JSContext *ctx, JSValueConst this_val,
                                  int argc, JSValueConst *argv)
 {
@@ -910,36 +1296,11 @@ static JSValue js_crypto_hash_password(JSContext *ctx, JSValueConst this_val,
     if (!pw)
         return JS_EXCEPTION;
 
-    /* Generate 16-byte salt */
-    uint8_t salt[16];
-    if (hl_cap_crypto_random(salt, sizeof(salt)) != 0) {
-        JS_FreeCString(ctx, pw);
-        return JS_ThrowInternalError(ctx, "random failed");
-    }
-
-    /* PBKDF2-HMAC-SHA256, 32-byte output */
-    uint8_t hash[32];
-    int iterations = HL_PBKDF2_ITERATIONS;
-    if (hl_cap_crypto_pbkdf2(pw, pw_len, salt, sizeof(salt),
-                               iterations, hash, sizeof(hash)) != 0) {
-        JS_FreeCString(ctx, pw);
-        return JS_ThrowInternalError(ctx, "pbkdf2 failed");
-    }
+    char result[HL_PASSWORD_HASH_MAX];
+    int rc = hl_cap_crypto_password_hash(pw, pw_len, result, sizeof(result));
     JS_FreeCString(ctx, pw);
-
-    /* Format: "pbkdf2:100000:salt_hex:hash_hex" */
-    char salt_hex[33], hash_hex[65];
-    for (int i = 0; i < 16; i++)
-        snprintf(salt_hex + i * 2, 3, "%02x", salt[i]);
-    for (int i = 0; i < 32; i++)
-        snprintf(hash_hex + i * 2, 3, "%02x", hash[i]);
-
-    char result[128];
-    snprintf(result, sizeof(result), "pbkdf2:%d:%s:%s",
-             iterations, salt_hex, hash_hex);
-
-    secure_zero(hash, sizeof(hash));
-    secure_zero(salt, sizeof(salt));
+    if (rc != 0)
+        return JS_ThrowInternalError(ctx, "pbkdf2 failed");
 
     return JS_NewString(ctx, result);
 }
@@ -961,82 +1322,10 @@ static JSValue js_crypto_verify_password(JSContext *ctx, JSValueConst this_val,
         return JS_EXCEPTION;
     }
 
-    /* Parse "pbkdf2:iterations:salt_hex:hash_hex" manually (no scansets
-     * — Cosmopolitan libc doesn't support sscanf %[...] scansets). */
-    if (strncmp(stored, "pbkdf2:", 7) != 0) {
-        JS_FreeCString(ctx, pw);
-        JS_FreeCString(ctx, stored);
-        return JS_FALSE;
-    }
-    const char *p = stored + 7;
-
-    char *end = NULL;
-    long iterations = strtol(p, &end, 10);
-    if (!end || *end != ':' || iterations < 100000) {
-        JS_FreeCString(ctx, pw);
-        JS_FreeCString(ctx, stored);
-        return JS_FALSE;
-    }
-    p = end + 1;
-
-    if (strlen(p) < 32 + 1 + 64 || p[32] != ':') {
-        JS_FreeCString(ctx, pw);
-        JS_FreeCString(ctx, stored);
-        return JS_FALSE;
-    }
-    char salt_hex[33];
-    memcpy(salt_hex, p, 32);
-    salt_hex[32] = '\0';
-    p += 33;
-
-    if (strlen(p) < 64) {
-        JS_FreeCString(ctx, pw);
-        JS_FreeCString(ctx, stored);
-        return JS_FALSE;
-    }
-    char hash_hex[65];
-    memcpy(hash_hex, p, 64);
-    hash_hex[64] = '\0';
-
-    JS_FreeCString(ctx, stored);
-
-    /* Decode hex salt (manual — sscanf %x broken on Cosmopolitan) */
-    uint8_t salt[16];
-    for (int i = 0; i < 16; i++) {
-        int hi = hex_nibble((unsigned char)salt_hex[i * 2]);
-        int lo = hex_nibble((unsigned char)salt_hex[i * 2 + 1]);
-        if (hi < 0 || lo < 0) { JS_FreeCString(ctx, pw); return JS_FALSE; }
-        salt[i] = (uint8_t)((hi << 4) | lo);
-    }
-
-    /* Recompute hash */
-    uint8_t computed[32];
-    if (hl_cap_crypto_pbkdf2(pw, pw_len, salt, sizeof(salt),
-                               (int)iterations, computed, sizeof(computed)) != 0) {
-        JS_FreeCString(ctx, pw);
-        return JS_FALSE;
-    }
+    int ok = hl_cap_crypto_password_verify(pw, pw_len, stored);
     JS_FreeCString(ctx, pw);
-
-    /* Decode stored hash and compare (constant-time) */
-    uint8_t stored_hash[32];
-    for (int i = 0; i < 32; i++) {
-        int hi = hex_nibble((unsigned char)hash_hex[i * 2]);
-        int lo = hex_nibble((unsigned char)hash_hex[i * 2 + 1]);
-        if (hi < 0 || lo < 0) return JS_FALSE;
-        stored_hash[i] = (uint8_t)((hi << 4) | lo);
-    }
-
-    /* Constant-time comparison */
-    volatile uint8_t diff = 0;
-    for (int i = 0; i < 32; i++)
-        diff |= computed[i] ^ stored_hash[i];
-
-    secure_zero(computed, sizeof(computed));
-    secure_zero(stored_hash, sizeof(stored_hash));
-    secure_zero(salt, sizeof(salt));
-
-    return diff == 0 ? JS_TRUE : JS_FALSE;
+    JS_FreeCString(ctx, stored);
+    return ok ? JS_TRUE : JS_FALSE;
 }
 
 /* ── Hex decode helper (no sscanf — Cosmopolitan compat) ──────────── */
@@ -1794,6 +2083,8 @@ static int js_crypto_module_init(JSContext *ctx, JSModuleDef *m)
     JSValue crypto = JS_NewObject(ctx);
     JS_SetPropertyStr(ctx, crypto, "sha256",
                       JS_NewCFunction(ctx, js_crypto_sha256, "sha256", 1));
+    JS_SetPropertyStr(ctx, crypto, "sha256Many",
+                      JS_NewCFunction(ctx, js_crypto_sha256_many, "sha256Many", 1));
     JS_SetPropertyStr(ctx, crypto, "sha512",
                       JS_NewCFunction(ctx, js_crypto_sha512, "sha512", 1));
     JS_SetPropertyStr(ctx, crypto, "random",
@@ -2192,6 +2483,8 @@ int hl_js_init_http_module(JSContext *ctx, HlJS *js)
  * hull:smtp module
  *
  * smtp.send(opts) → { ok: true } or { ok: false, error: "..." }
+ * smtp.sendMany(conn, messages) → array of the same, one per message;
+ *   conn holds host/port/username/password/tls, each message the rest
  * ════════════════════════════════════════════════════════════════════ */
 
 /* Helper: extract JS string array from an Array object */
@@ -2242,139 +2535,224 @@ static void js_free_string_array(JSContext *ctx, const char **strs, int count)
     js_free(ctx, strs);
 }
 
-/* smtp.send(opts) */
-static JSValue js_smtp_send(JSContext *ctx, JSValueConst this_val,
-                            int argc, JSValueConst *argv)
+/* String property of obj as a C string (caller frees), NULL if not a string */
+static const char *js_smtp_cstr(JSContext *ctx, JSValueConst obj,
+                                const char *name)
 {
-    (void)this_val;
-    HlJS *js = (HlJS *)JS_GetContextOpaque(ctx);
-    if (!js || !js->base.smtp_cfg)
-        return JS_ThrowInternalError(ctx, "smtp not configured (no hosts in manifest)");
+    JSValue v = JS_GetPropertyStr(ctx, obj, name);
+    const char *s = JS_IsString(v) ? JS_ToCString(ctx, v) : NULL;
+    JS_FreeValue(ctx, v);
+    return s;
+}
 
-    if (argc < 1 || !JS_IsObject(argv[0]))
-        return JS_ThrowTypeError(ctx, "smtp.send requires an options object");
+/* Connection fields (host, port, username, password, tls) of obj into msg */
+static void js_smtp_read_conn(JSContext *ctx, JSValueConst obj,
+                              HlSmtpMessage *msg)
+{
+    msg->host = js_smtp_cstr(ctx, obj, "host");
+    msg->username = js_smtp_cstr(ctx, obj, "username");
+    msg->password = js_smtp_cstr(ctx, obj, "password");
 
-    JSValueConst opts = argv[0];
-
-    /* Extract fields */
-    JSValue v_host = JS_GetPropertyStr(ctx, opts, "host");
-    JSValue v_port = JS_GetPropertyStr(ctx, opts, "port");
-    JSValue v_user = JS_GetPropertyStr(ctx, opts, "username");
-    JSValue v_pass = JS_GetPropertyStr(ctx, opts, "password");
-    JSValue v_tls  = JS_GetPropertyStr(ctx, opts, "tls");
-    JSValue v_from = JS_GetPropertyStr(ctx, opts, "from");
-    JSValue v_to   = JS_GetPropertyStr(ctx, opts, "to");
-    JSValue v_subj = JS_GetPropertyStr(ctx, opts, "subject");
-    JSValue v_body = JS_GetPropertyStr(ctx, opts, "body");
-    JSValue v_ct   = JS_GetPropertyStr(ctx, opts, "content_type");
-    JSValue v_rto  = JS_GetPropertyStr(ctx, opts, "reply_to");
-    JSValue v_cc   = JS_GetPropertyStr(ctx, opts, "cc");
-
-    const char *host = JS_IsString(v_host) ? JS_ToCString(ctx, v_host) : NULL;
+    JSValue v_port = JS_GetPropertyStr(ctx, obj, "port");
     int32_t port = 587;
     if (JS_IsNumber(v_port))
         JS_ToInt32(ctx, &port, v_port);
-    const char *username = JS_IsString(v_user) ? JS_ToCString(ctx, v_user) : NULL;
-    const char *password = JS_IsString(v_pass) ? JS_ToCString(ctx, v_pass) : NULL;
+    JS_FreeValue(ctx, v_port);
+    msg->port = port;
 
-    int use_tls = 0;
+    JSValue v_tls = JS_GetPropertyStr(ctx, obj, "tls");
+    msg->use_tls = 0;
     if (JS_IsBool(v_tls)) {
-        use_tls = JS_ToBool(ctx, v_tls) ? 1 : 0;
+        msg->use_tls = JS_ToBool(ctx, v_tls) ? 1 : 0;
     } else if (JS_IsNumber(v_tls)) {
         int32_t t = 0;
         JS_ToInt32(ctx, &t, v_tls);
-        use_tls = t;
+        msg->use_tls = t;
     }
+    JS_FreeValue(ctx, v_tls);
+}
+
+static void js_smtp_free_conn(JSContext *ctx, HlSmtpMessage *msg)
+{
+    if (msg->host)     JS_FreeCString(ctx, msg->host);
+    if (msg->username) JS_FreeCString(ctx, msg->username);
+    if (msg->password) JS_FreeCString(ctx, msg->password);
+}
 
-    const char *from = JS_IsString(v_from) ? JS_ToCString(ctx, v_from) : NULL;
-    const char *to   = JS_IsString(v_to)   ? JS_ToCString(ctx, v_to)   : NULL;
-    const char *subject = JS_IsString(v_subj) ? JS_ToCString(ctx, v_subj) : NULL;
-    const char *body = JS_IsString(v_body) ? JS_ToCString(ctx, v_body) : NULL;
-    const char *content_type = JS_IsString(v_ct) ? JS_ToCString(ctx, v_ct) : NULL;
-    const char *reply_to = JS_IsString(v_rto) ? JS_ToCString(ctx, v_rto) : NULL;
+/* Message fields of obj into msg. Returns NULL, or the name of the first
+ * missing required field. */
+static const char *js_smtp_read_envelope(JSContext *ctx, JSValueConst obj,
+                                         HlSmtpMessage *msg)
+{
+    msg->from = js_smtp_cstr(ctx, obj, "from");
+    msg->to = js_smtp_cstr(ctx, obj, "to");
+    msg->subject = js_smtp_cstr(ctx, obj, "subject");
+    msg->body = js_smtp_cstr(ctx, obj, "body");
+    msg->content_type = js_smtp_cstr(ctx, obj, "content_type");
+    msg->reply_to = js_smtp_cstr(ctx, obj, "reply_to");
 
     /* CC array */
-    const char **cc = NULL;
-    int cc_count = 0;
+    msg->cc = NULL;
+    msg->cc_count = 0;
+    JSValue v_cc = JS_GetPropertyStr(ctx, obj, "cc");
     if (JS_IsArray(ctx, v_cc))
-        js_get_string_array(ctx, v_cc, &cc, &cc_count);
-
-    /* Free JS values */
-    JS_FreeValue(ctx, v_host);
-    JS_FreeValue(ctx, v_port);
-    JS_FreeValue(ctx, v_user);
-    JS_FreeValue(ctx, v_pass);
-    JS_FreeValue(ctx, v_tls);
-    JS_FreeValue(ctx, v_from);
-    JS_FreeValue(ctx, v_to);
-    JS_FreeValue(ctx, v_subj);
-    JS_FreeValue(ctx, v_body);
-    JS_FreeValue(ctx, v_ct);
-    JS_FreeValue(ctx, v_rto);
+        js_get_string_array(ctx, v_cc, &msg->cc, &msg->cc_count);
     JS_FreeValue(ctx, v_cc);
 
-    /* Build result early for validation errors */
-    JSValue result;
+    return !msg->from ? "from" : !msg->to ? "to" :
+           !msg->subject ? "subject" : !msg->body ? "body" : NULL;
+}
+
+static void js_smtp_free_envelope(JSContext *ctx, HlSmtpMessage *msg)
+{
+    if (msg->from)         JS_FreeCString(ctx, msg->from);
+    if (msg->to)           JS_FreeCString(ctx, msg->to);
+    if (msg->subject)      JS_FreeCString(ctx, msg->subject);
+    if (msg->body)         JS_FreeCString(ctx, msg->body);
+    if (msg->content_type) JS_FreeCString(ctx, msg->content_type);
+    if (msg->reply_to)     JS_FreeCString(ctx, msg->reply_to);
+    js_free_string_array(ctx, msg->cc, msg->cc_count);
+}
 
-    if (!host || !from || !to || !subject || !body) {
-        result = JS_NewObject(ctx);
-        JS_SetPropertyStr(ctx, result, "ok", JS_FALSE);
-        const char *missing = !host ? "host" : !from ? "from" :
-                              !to ? "to" : !subject ? "subject" : "body";
-        char errbuf[64];
+/* { ok: true }, or { ok: false, error } with error = "<missing> required"
+ * or the given message */
+static JSValue js_smtp_result(JSContext *ctx, const char *missing,
+                              const char *err)
+{
+    JSValue result = JS_NewObject(ctx);
+    if (!missing && !err) {
+        JS_SetPropertyStr(ctx, result, "ok", JS_TRUE);
+        return result;
+    }
+    JS_SetPropertyStr(ctx, result, "ok", JS_FALSE);
+    char errbuf[64];
+    if (missing) {
         snprintf(errbuf, sizeof(errbuf), "%s required", missing);
-        JS_SetPropertyStr(ctx, result, "error", JS_NewString(ctx, errbuf));
-        goto cleanup;
-    }
-
-    /* Build message struct */
-    HlSmtpMessage msg = {
-        .host = host,
-        .port = port,
-        .username = username,
-        .password = password,
-        .use_tls = use_tls,
-        .from = from,
-        .to = to,
-        .cc = cc,
-        .cc_count = cc_count,
-        .reply_to = reply_to,
-        .subject = subject,
-        .body = body,
-        .content_type = content_type,
-    };
+        err = errbuf;
+    }
+    JS_SetPropertyStr(ctx, result, "error", JS_NewString(ctx, err));
+    return result;
+}
 
-    int rc = hl_cap_smtp_send(js->base.smtp_cfg, &msg);
+/* smtp.send(opts) */
+static JSValue js_smtp_send(JSContext *ctx, JSValueConst this_val,
+                            int argc, JSValueConst *argv)
+{
+    (void)this_val;
+    HlJS *js = (HlJS *)JS_GetContextOpaque(ctx);
+    if (!js || !js->base.smtp_cfg)
+        return JS_ThrowInternalError(ctx, "smtp not configured (no hosts in manifest)");
 
-    result = JS_NewObject(ctx);
-    if (rc == 0) {
-        JS_SetPropertyStr(ctx, result, "ok", JS_TRUE);
+    if (argc < 1 || !JS_IsObject(argv[0]))
+        return JS_ThrowTypeError(ctx, "smtp.send requires an options object");
+
+    HlSmtpMessage msg = {0};
+    js_smtp_read_conn(ctx, argv[0], &msg);
+    const char *missing = js_smtp_read_envelope(ctx, argv[0], &msg);
+    if (!msg.host)
+        missing = "host";
+
+    JSValue result;
+    if (missing) {
+        result = js_smtp_result(ctx, missing, NULL);
     } else {
-        JS_SetPropertyStr(ctx, result, "ok", JS_FALSE);
-        JS_SetPropertyStr(ctx, result, "error",
-                          JS_NewString(ctx, "smtp send failed"));
-    }
-
-cleanup:
-    if (host)         JS_FreeCString(ctx, host);
-    if (username)     JS_FreeCString(ctx, username);
-    if (password)     JS_FreeCString(ctx, password);
-    if (from)         JS_FreeCString(ctx, from);
-    if (to)           JS_FreeCString(ctx, to);
-    if (subject)      JS_FreeCString(ctx, subject);
-    if (body)         JS_FreeCString(ctx, body);
-    if (content_type) JS_FreeCString(ctx, content_type);
-    if (reply_to)     JS_FreeCString(ctx, reply_to);
-    js_free_string_array(ctx, cc, cc_count);
+        int rc = hl_cap_smtp_send(js->base.smtp_cfg, &msg);
+        result = js_smtp_result(ctx, NULL,
+                                rc == 0 ? NULL : "smtp send failed");
+    }
 
+    js_smtp_free_envelope(ctx, &msg);
+    js_smtp_free_conn(ctx, &msg);
     return result;
 }
 
+/* smtp.sendMany(conn, messages) — one session for the whole batch */
+static JSValue js_smtp_send_many(JSContext *ctx, JSValueConst this_val,
+                                 int argc, JSValueConst *argv)
+{
+    (void)this_val;
+    HlJS *js = (HlJS *)JS_GetContextOpaque(ctx);
+    if (!js || !js->base.smtp_cfg)
+        return JS_ThrowInternalError(ctx, "smtp not configured (no hosts in manifest)");
+
+    if (argc < 2 || !JS_IsObject(argv[0]) || !JS_IsArray(ctx, argv[1]))
+        return JS_ThrowTypeError(ctx, "smtp.sendMany requires (conn, messages[])");
+
+    JSValue len_val = JS_GetPropertyStr(ctx, argv[1], "length");
+    int32_t n = 0;
+    JS_ToInt32(ctx, &n, len_val);
+    JS_FreeValue(ctx, len_val);
+    if (n > HL_SMTP_MAX_BATCH)
+        return JS_ThrowRangeError(ctx, "smtp.sendMany: at most %d messages",
+                                  HL_SMTP_MAX_BATCH);
+    if (n <= 0)
+        return JS_NewArray(ctx);
+
+    HlSmtpMessage *msgs = js_mallocz(ctx, (size_t)n * sizeof(*msgs));
+    const char **missing = js_mallocz(ctx, (size_t)n * sizeof(*missing));
+    int *slot = js_mallocz(ctx, (size_t)n * sizeof(*slot));
+    int *results = js_mallocz(ctx, (size_t)n * sizeof(*results));
+    if (!msgs || !missing || !slot || !results) {
+        js_free(ctx, msgs);
+        js_free(ctx, missing);
+        js_free(ctx, slot);
+        js_free(ctx, results);
+        return JS_ThrowOutOfMemory(ctx);
+    }
+
+    HlSmtpMessage conn = {0};
+    js_smtp_read_conn(ctx, argv[0], &conn);
+
+    /* Messages missing a field get their error here; the rest are sent
+     * together */
+    int count = 0;
+    for (int32_t i = 0; i < n; i++) {
+        JSValue m = JS_GetPropertyUint32(ctx, argv[1], (uint32_t)i);
+        slot[i] = -1;
+        if (!JS_IsObject(m)) {
+            missing[i] = "message";
+        } else if (!conn.host) {
+            missing[i] = "host";
+        } else {
+            HlSmtpMessage *msg = &msgs[count];
+            *msg = conn;
+            missing[i] = js_smtp_read_envelope(ctx, m, msg);
+            if (missing[i])
+                js_smtp_free_envelope(ctx, msg);
+            else
+                slot[i] = count++;
+        }
+        JS_FreeValue(ctx, m);
+    }
+
+    hl_cap_smtp_send_many(js->base.smtp_cfg, msgs, count, results);
+
+    JSValue out = JS_NewArray(ctx);
+    for (int32_t i = 0; i < n; i++) {
+        const char *err = NULL;
+        if (!missing[i] && results[slot[i]] != 0)
+            err = "smtp send failed";
+        JS_SetPropertyUint32(ctx, out, (uint32_t)i,
+                             js_smtp_result(ctx, missing[i], err));
+    }
+
+    for (int i = 0; i < count; i++)
+        js_smtp_free_envelope(ctx, &msgs[i]);
+    js_smtp_free_conn(ctx, &conn);
+    js_free(ctx, msgs);
+    js_free(ctx, missing);
+    js_free(ctx, slot);
+    js_free(ctx, results);
+    return out;
+}
+
 static int js_smtp_module_init(JSContext *ctx, JSModuleDef *m)
 {
     JSValue smtp = JS_NewObject(ctx);
     JS_SetPropertyStr(ctx, smtp, "send",
                       JS_NewCFunction(ctx, js_smtp_send, "send", 1));
+    JS_SetPropertyStr(ctx, smtp, "sendMany",
+                      JS_NewCFunction(ctx, js_smtp_send_many, "sendMany", 2));
     JS_SetModuleExport(ctx, m, "smtp", smtp);
     return 0;
 }
@@ -2389,6 +2767,53 @@ int hl_js_init_smtp_module(JSContext *ctx, HlJS *js)
     return 0;
 }
 
+/* ════════════════════════════════════════════════════════════════════
+ * hull:_outbox module (internal — called only by hull:middleware:outbox)
+ *
+ * _outbox.native() → true when the native dispatcher delivers "webhook"
+ *                    and "http" rows (hull --outbox-workers N)
+ * _outbox.wake()   → have it look for due rows now
+ * ════════════════════════════════════════════════════════════════════ */
+
+static JSValue js_outbox_native(JSContext *ctx, JSValueConst this_val,
+                                int argc, JSValueConst *argv)
+{
+    (void)this_val; (void)argc; (void)argv;
+    HlJS *js = (HlJS *)JS_GetContextOpaque(ctx);
+    return JS_NewBool(ctx, js && js->base.outbox);
+}
+
+static JSValue js_outbox_wake(JSContext *ctx, JSValueConst this_val,
+                              int argc, JSValueConst *argv)
+{
+    (void)this_val; (void)argc; (void)argv;
+    HlJS *js = (HlJS *)JS_GetContextOpaque(ctx);
+    if (js)
+        hl_outbox_wake(js->base.outbox);
+    return JS_UNDEFINED;
+}
+
+static int js_outbox_module_init(JSContext *ctx, JSModuleDef *m)
+{
+    JSValue ob = JS_NewObject(ctx);
+    JS_SetPropertyStr(ctx, ob, "native",
+                      JS_NewCFunction(ctx, js_outbox_native, "native", 0));
+    JS_SetPropertyStr(ctx, ob, "wake",
+                      JS_NewCFunction(ctx, js_outbox_wake, "wake", 0));
+    JS_SetModuleExport(ctx, m, "_outbox", ob);
+    return 0;
+}
+
+int hl_js_init_outbox_module(JSContext *ctx, HlJS *js)
+{
+    (void)js;
+    JSModuleDef *m = JS_NewCModule(ctx, "hull:_outbox", js_outbox_module_init);
+    if (!m)
+        return -1;
+    JS_AddModuleExport(ctx, m, "_outbox");
+    return 0;
+}
+
 /* ════════════════════════════════════════════════════════════════════
  * hull:json module
  *
@@ -2519,46 +2944,445 @@ int hl_js_init_log_module(JSContext *ctx, HlJS *js)
 /* ════════════════════════════════════════════════════════════════════
  * hull:_template module (internal — called only by hull:template stdlib)
  *
- * _template.compile(code, name?)   → compiled JS function
- * _template.loadRaw(name)          → raw template string or null
+ * _template.program(buffer, filters)      → render function(data)
+ * _template.loadRaw(name)                 → raw template string or null
+ * _template.loadCompiled(name, filters)   → precompiled render fn or null
+ *
+ * Programs are executed by the native renderer (cap/template.c) over a
+ * JSValue register file; `filters` supplies the filters that call back
+ * into JS (json, and upper/lower/trim/length outside their fast paths).
  * ════════════════════════════════════════════════════════════════════ */
 
 /* VFS: O(log n) lookups into sorted entry arrays */
 #include "hull/vfs.h"
 
-/* _template.compile(code, name?) — compile generated JS source to a function */
-static JSValue js_template_compile(JSContext *ctx, JSValueConst this_val,
-                                    int argc, JSValueConst *argv)
+typedef struct {
+    JSContext *ctx;
+    JSValue   *regs;
+    JSValue    filters;
+} JsTpl;
+
+static void js_tpl_set(JsTpl *t, int dst, JSValue v)
+{
+    JS_FreeValue(t->ctx, t->regs[dst]);
+    t->regs[dst] = v;
+}
+
+static int js_tpl_nullish(JSValueConst v)
+{
+    return JS_IsNull(v) || JS_IsUndefined(v);
+}
+
+static int js_tpl_get(void *ud, int dst, int obj, const char *key, size_t len)
+{
+    JsTpl *t = ud;
+    /* Optional chaining: null/undefined yield undefined */
+    if (js_tpl_nullish(t->regs[obj])) {
+        js_tpl_set(t, dst, JS_UNDEFINED);
+        return 0;
+    }
+    JSAtom atom = JS_NewAtomLen(t->ctx, key, len);
+    if (atom == JS_ATOM_NULL)
+        return -1;
+    JSValue v = JS_GetProperty(t->ctx, t->regs[obj], atom);
+    JS_FreeAtom(t->ctx, atom);
+    if (JS_IsException(v))
+        return -1;
+    js_tpl_set(t, dst, v);
+    return 0;
+}
+
+static int js_tpl_set_str(void *ud, int dst, const char *s, size_t len)
+{
+    JsTpl *t = ud;
+    JSValue v = JS_NewStringLen(t->ctx, s, len);
+    if (JS_IsException(v))
+        return -1;
+    js_tpl_set(t, dst, v);
+    return 0;
+}
+
+static int js_tpl_set_nil(void *ud, int dst)
+{
+    js_tpl_set(ud, dst, JS_UNDEFINED);
+    return 0;
+}
+
+static int js_tpl_truthy(void *ud, int src)
+{
+    JsTpl *t = ud;
+    return JS_ToBool(t->ctx, t->regs[src]) > 0;
+}
+
+/* c[Symbol.iterator]() as for...of would call it; throws if c is not
+ * iterable. Returns the iterator or JS_EXCEPTION. */
+static JSValue js_tpl_iter_open(JSContext *ctx, JSValueConst c)
+{
+    JSValue global = JS_GetGlobalObject(ctx);
+    JSValue sym_ctor = JS_GetPropertyStr(ctx, global, "Symbol");
+    JSValue sym = JS_GetPropertyStr(ctx, sym_ctor, "iterator");
+    JS_FreeValue(ctx, sym_ctor);
+    JS_FreeValue(ctx, global);
+    JSAtom atom = JS_ValueToAtom(ctx, sym);
+    JS_FreeValue(ctx, sym);
+    if (atom == JS_ATOM_NULL)
+        return JS_EXCEPTION;
+
+    JSValue method = JS_GetProperty(ctx, c, atom);
+    JS_FreeAtom(ctx, atom);
+    if (JS_IsException(method))
+        return JS_EXCEPTION;
+    if (!JS_IsFunction(ctx, method)) {
+        JS_FreeValue(ctx, method);
+        return JS_ThrowTypeError(ctx, "template: {%% for x in ... %%} value is "
+                                 "not iterable; use {%% for k, v in ... %%} "
+                                 "for objects");
+    }
+    JSValue iter = JS_Call(ctx, method, c, 0, NULL);
+    JS_FreeValue(ctx, method);
+    if (!JS_IsException(iter) && !JS_IsObject(iter)) {
+        JS_FreeValue(ctx, iter);
+        return JS_ThrowTypeError(ctx, "iterator is not an object");
+    }
+    return iter;
+}
+
+/* iter.next() into r[val]. Returns 1, 0 when done, -1 on error. */
+static int js_tpl_iter_step(JsTpl *t, JSValueConst iter, int val)
+{
+    JSContext *ctx = t->ctx;
+    JSValue next = JS_GetPropertyStr(ctx, iter, "next");
+    if (JS_IsException(next))
+        return -1;
+    JSValue res = JS_Call(ctx, next, iter, 0, NULL);
+    JS_FreeValue(ctx, next);
+    if (JS_IsException(res))
+        return -1;
+    if (!JS_IsObject(res)) {
+        JS_FreeValue(ctx, res);
+        JS_ThrowTypeError(ctx, "iterator result is not an object");
+        return -1;
+    }
+    JSValue done = JS_GetPropertyStr(ctx, res, "done");
+    int d = JS_ToBool(ctx, done);
+    JS_FreeValue(ctx, done);
+    if (d != 0) {
+        JS_FreeValue(ctx, res);
+        return d < 0 ? -1 : 0;
+    }
+    JSValue v = JS_GetPropertyStr(ctx, res, "value");
+    JS_FreeValue(ctx, res);
+    if (JS_IsException(v))
+        return -1;
+    js_tpl_set(t, val, v);
+    return 1;
+}
+
+/* Array loops: state = index, state + 1 = length. Other values follow
+ * for...of (strings, Map, Set, typed arrays, generators): state + 1 =
+ * the iterator. null/undefined iterate zero times; a value that is not
+ * iterable throws, as `for (const x of v)` would. Key/value loops
+ * (Object.entries order): state = index, state + 1 = array of keys. */
+static int js_tpl_next(void *ud, int coll, int state, int key, int val,
+                       int kv)
+{
+    JsTpl *t = ud;
+    JSContext *ctx = t->ctx;
+    JSValueConst c = t->regs[coll];
+    int first = JS_IsUndefined(t->regs[state]);
+    uint32_t i = 0;
+
+    if (first) {
+        if (!kv) {
+            int is_array = JS_IsArray(ctx, c);
+            if (is_array < 0)
+                return -1;
+            if (!is_array) {
+                if (js_tpl_nullish(c))
+                    return 0;
+                JSValue iter = js_tpl_iter_open(ctx, c);
+                if (JS_IsException(iter))
+                    return -1;
+                js_tpl_set(t, state + 1, iter);
+                js_tpl_set(t, state, JS_NewUint32(ctx, 0));
+                return js_tpl_iter_step(t, t->regs[state + 1], val);
+            }
+            JSValue lv = JS_GetPropertyStr(ctx, c, "length");
+            uint32_t n = 0;
+            int rc = JS_ToUint32(ctx, &n, lv);
+            JS_FreeValue(ctx, lv);
+            if (rc < 0)
+                return -1;
+            js_tpl_set(t, state + 1, JS_NewUint32(ctx, n));
+        } else {
+            if (!JS_IsObject(c))
+                return 0;
+            JSPropertyEnum *props;
+            uint32_t count;
+            if (JS_GetOwnPropertyNames(ctx, &props, &count, c,
+                                       JS_GPN_STRING_MASK | JS_GPN_ENUM_ONLY) < 0)
+                return -1;
+            JSValue keys = JS_NewArray(ctx);
+            for (uint32_t k = 0; k < count; k++) {
+                if (!JS_IsException(keys))
+                    JS_SetPropertyUint32(ctx, keys, k,
+                                         JS_AtomToString(ctx, props[k].atom));
+                JS_FreeAtom(ctx, props[k].atom);
+            }
+            js_free(ctx, props);
+            if (JS_IsException(keys))
+                return -1;
+            js_tpl_set(t, state + 1, keys);
+        }
+    } else if (!kv && JS_IsObject(t->regs[state + 1])) {
+        return js_tpl_iter_step(t, t->regs[state + 1], val);
+    } else {
+        JS_ToUint32(ctx, &i, t->regs[state]);
+        i++;
+    }
+    js_tpl_set(t, state, JS_NewUint32(ctx, i));
+
+    JSValue v;
+    if (!kv) {
+        uint32_t n = 0;
+        JS_ToUint32(ctx, &n, t->regs[state + 1]);
+        if (i >= n)
+            return 0;
+        v = JS_GetPropertyUint32(ctx, c, i);
+    } else {
+        JSValue k = JS_GetPropertyUint32(ctx, t->regs[state + 1], i);
+        if (JS_IsUndefined(k))
+            return 0;
+        JSAtom atom = JS_ValueToAtom(ctx, k);
+        if (atom == JS_ATOM_NULL) {
+            JS_FreeValue(ctx, k);
+            return -1;
+        }
+        v = JS_GetProperty(ctx, c, atom);
+        JS_FreeAtom(ctx, atom);
+        if (key >= 0)
+            js_tpl_set(t, key, k);
+        else
+            JS_FreeValue(ctx, k);
+    }
+    if (JS_IsException(v))
+        return -1;
+    js_tpl_set(t, val, v);
+    return 1;
+}
+
+/* upper/lower/trim on ASCII strings without calling into JS.
+ * Returns 1 if handled, 0 to fall back to the JS filter, -1 on error. */
+static int js_tpl_ascii_filter(JsTpl *t, int id, int dst, JSValueConst v)
+{
+    if (!JS_IsString(v))
+        return 0;
+
+    size_t n;
+    const char *s = JS_ToCStringLen(t->ctx, &n, v);
+    if (!s)
+        return -1;
+    for (size_t i = 0; i < n; i++) {
+        if ((unsigned char)s[i] >= 0x80) {
+            JS_FreeCString(t->ctx, s);
+            return 0;
+        }
+    }
+
+    JSValue r;
+    if (id == HL_TPL_F_TRIM) {
+        size_t i = 0;
+        while (i < n && isspace((unsigned char)s[i]))
+            i++;
+        while (n > i && isspace((unsigned char)s[n - 1]))
+            n--;
+        r = JS_NewStringLen(t->ctx, s + i, n - i);
+    } else {
+        char *p = js_malloc(t->ctx, n + 1);
+        if (!p) {
+            JS_FreeCString(t->ctx, s);
+            return -1;
+        }
+        for (size_t i = 0; i < n; i++)
+            p[i] = (char)(id == HL_TPL_F_UPPER ? toupper((unsigned char)s[i])
+                                               : tolower((unsigned char)s[i]));
+        r = JS_NewStringLen(t->ctx, p, n);
+        js_free(t->ctx, p);
+    }
+    JS_FreeCString(t->ctx, s);
+    if (JS_IsException(r))
+        return -1;
+    js_tpl_set(t, dst, r);
+    return 1;
+}
+
+static int js_tpl_filter(void *ud, int id, int dst, int src, int arg)
+{
+    JsTpl *t = ud;
+    JSContext *ctx = t->ctx;
+    JSValueConst v = t->regs[src];
+
+    switch (id) {
+    case HL_TPL_F_UPPER:
+    case HL_TPL_F_LOWER:
+    case HL_TPL_F_TRIM: {
+        int rc = js_tpl_ascii_filter(t, id, dst, v);
+        if (rc != 0)
+            return rc > 0 ? 0 : -1;
+        break;
+    }
+    case HL_TPL_F_LENGTH:
+        if (JS_IsArray(ctx, v) > 0) {
+            JSValue n = JS_GetPropertyStr(ctx, v, "length");
+            if (JS_IsException(n))
+                return -1;
+            js_tpl_set(t, dst, n);
+            return 0;
+        }
+        break;
+    case HL_TPL_F_DEFAULT: {
+        /* val == null || val === false || val === "" → fallback ?? "" */
+        int empty = js_tpl_nullish(v) || (JS_IsBool(v) && !JS_ToBool(ctx, v));
+        if (!empty && JS_IsString(v)) {
+            JSValue n = JS_GetPropertyStr(ctx, v, "length");
+            empty = JS_VALUE_GET_TAG(n) == JS_TAG_INT && JS_VALUE_GET_INT(n) == 0;
+            JS_FreeValue(ctx, n);
+        }
+        if (!empty)
+            js_tpl_set(t, dst, JS_DupValue(ctx, v));
+        else if (arg >= 0 && !js_tpl_nullish(t->regs[arg]))
+            js_tpl_set(t, dst, JS_DupValue(ctx, t->regs[arg]));
+        else
+            js_tpl_set(t, dst, JS_NewStringLen(ctx, "", 0));
+        return 0;
+    }
+    default:
+        break;
+    }
+
+    /* Implemented in JS: filters[name](val[, arg]) */
+    const char *name = hl_tpl_filter_name(id);
+    if (!name) {
+        JS_ThrowInternalError(ctx, "unknown template filter");
+        return -1;
+    }
+    JSValue fn = JS_GetPropertyStr(ctx, t->filters, name);
+    if (JS_IsException(fn))
+        return -1;
+    JSValueConst args[2] = { v, arg >= 0 ? t->regs[arg] : JS_UNDEFINED };
+    JSValue r = JS_Call(ctx, fn, JS_UNDEFINED, arg >= 0 ? 2 : 1, args);
+    JS_FreeValue(ctx, fn);
+    if (JS_IsException(r))
+        return -1;
+    js_tpl_set(t, dst, r);
+    return 0;
+}
+
+static int js_tpl_out(void *ud, int src, int escape, HlTplBuf *buf)
+{
+    JsTpl *t = ud;
+    JSValueConst v = t->regs[src];
+
+    /* null/undefined render nothing, everything else through String() */
+    if (js_tpl_nullish(v))
+        return 0;
+
+    size_t n;
+    const char *s = JS_ToCStringLen(t->ctx, &n, v);
+    if (!s)
+        return -1;
+    int rc = escape ? hl_tpl_buf_escape(buf, s, n)
+                    : hl_tpl_buf_append(buf, s, n);
+    JS_FreeCString(t->ctx, s);
+    return rc;
+}
+
+static const HlTplOps js_tpl_ops = {
+    .get     = js_tpl_get,
+    .set_str = js_tpl_set_str,
+    .set_nil = js_tpl_set_nil,
+    .truthy  = js_tpl_truthy,
+    .next    = js_tpl_next,
+    .filter  = js_tpl_filter,
+    .out     = js_tpl_out,
+};
+
+/* Render function: func_data[0] = validated program (ArrayBuffer),
+ * func_data[1] = filters object */
+static JSValue js_template_render(JSContext *ctx, JSValueConst this_val,
+                                  int argc, JSValueConst *argv, int magic,
+                                  JSValue *func_data)
 {
     (void)this_val;
-    if (argc < 1)
-        return JS_ThrowTypeError(ctx, "_template.compile requires (code)");
+    (void)magic;
 
     size_t len;
-    const char *code = JS_ToCStringLen(ctx, &len, argv[0]);
+    const uint8_t *code = JS_GetArrayBuffer(ctx, &len, func_data[0]);
     if (!code)
         return JS_EXCEPTION;
 
-    const char *name = "<template>";
-    if (argc >= 2 && JS_IsString(argv[1])) {
-        name = JS_ToCString(ctx, argv[1]);
-        if (!name) {
-            JS_FreeCString(ctx, code);
-            return JS_EXCEPTION;
-        }
-    }
+    JSValue regs[HL_TPL_NO_REG];
+    int nregs = code[5];
+    regs[0] = argc > 0 ? JS_DupValue(ctx, argv[0]) : JS_UNDEFINED;
+    for (int i = 1; i < nregs; i++)
+        regs[i] = JS_UNDEFINED;
 
-    /* Evaluate the IIFE source — returns a function */
-    JSValue result = JS_Eval(ctx, code, len, name,
-                              JS_EVAL_TYPE_GLOBAL | JS_EVAL_FLAG_STRICT);
+    HlJS *js = (HlJS *)JS_GetContextOpaque(ctx);
+    HlTplBuf buf;
+    hl_tpl_buf_init(&buf, js ? js->base.alloc : NULL);
 
-    if (argc >= 2 && JS_IsString(argv[1]))
-        JS_FreeCString(ctx, name);
-    JS_FreeCString(ctx, code);
+    JsTpl t = { .ctx = ctx, .regs = regs, .filters = func_data[1] };
+    JSValue result;
+    if (hl_tpl_render(code, &js_tpl_ops, &t, &buf) == 0)
+        result = JS_NewStringLen(ctx, buf.data ? buf.data : "", buf.len);
+    else
+        result = buf.oom ? JS_ThrowOutOfMemory(ctx) : JS_EXCEPTION;
 
+    hl_tpl_buf_free(&buf);
+    for (int i = 0; i < nregs; i++)
+        JS_FreeValue(ctx, regs[i]);
     return result;
 }
 
+/* Validate a program and wrap a private copy of it in a render function.
+ * Returns JS_NULL if the program is malformed. */
+static JSValue js_template_new_program(JSContext *ctx, const uint8_t *code,
+                                       size_t len, JSValueConst filters)
+{
+    if (hl_tpl_check(code, len) < 0)
+        return JS_NULL;
+
+    JSValue data[2];
+    data[0] = JS_NewArrayBufferCopy(ctx, code, len);
+    if (JS_IsException(data[0]))
+        return JS_EXCEPTION;
+    data[1] = JS_DupValue(ctx, filters);
+
+    JSValue fn = JS_NewCFunctionData(ctx, js_template_render, 1, 0, 2, data);
+    JS_FreeValue(ctx, data[0]);
+    JS_FreeValue(ctx, data[1]);
+    return fn;
+}
+
+/* _template.program(buffer, filters) — wrap an emitted program */
+static JSValue js_template_program(JSContext *ctx, JSValueConst this_val,
+                                   int argc, JSValueConst *argv)
+{
+    (void)this_val;
+    if (argc < 2 || !JS_IsObject(argv[1]))
+        return JS_ThrowTypeError(ctx, "_template.program requires (buffer, filters)");
+
+    size_t len;
+    const uint8_t *code = JS_GetArrayBuffer(ctx, &len, argv[0]);
+    if (!code)
+        return JS_EXCEPTION;
+
+    JSValue fn = js_template_new_program(ctx, code, len, argv[1]);
+    if (JS_IsNull(fn))
+        return JS_ThrowInternalError(ctx, "invalid template program");
+    return fn;
+}
+
 /* _template.loadRaw(name) — load raw template bytes from embedded
  * entries or filesystem fallback. Returns string or null. */
 static JSValue js_template_load_raw(JSContext *ctx, JSValueConst this_val,
@@ -2657,13 +3481,53 @@ static JSValue js_template_load_raw(JSContext *ctx, JSValueConst this_val,
     return JS_NULL;
 }
 
+/* _template.loadCompiled(name, filters) — load a template program
+ * precompiled by hull build ("templates/<name>.tplc", inheritance
+ * already flattened). Returns the render function, or null if there is
+ * no usable entry. */
+static JSValue js_template_load_compiled(JSContext *ctx, JSValueConst this_val,
+                                          int argc, JSValueConst *argv)
+{
+    (void)this_val;
+    if (argc < 2 || !JS_IsObject(argv[1]))
+        return JS_ThrowTypeError(ctx, "_template.loadCompiled requires (name, filters)");
+
+    HlJS *js = (HlJS *)JS_GetContextOpaque(ctx);
+    if (!js || !js->base.app_vfs)
+        return JS_NULL;
+
+    const char *name = JS_ToCString(ctx, argv[0]);
+    if (!name)
+        return JS_EXCEPTION;
+
+    char tpl_name[HL_MODULE_PATH_MAX];
+    int n = snprintf(tpl_name, sizeof(tpl_name), "templates/%s", name);
+    const HlEntry *bc = NULL;
+    if (name[0] != '\0' && n > 0 && (size_t)n < sizeof(tpl_name))
+        bc = hl_vfs_find_suffixed(js->base.app_vfs, tpl_name,
+                                  HL_TPL_BYTECODE_SUFFIX);
+    if (!bc) {
+        JS_FreeCString(ctx, name);
+        return JS_NULL;
+    }
+
+    JSValue result = js_template_new_program(ctx, bc->data, bc->len, argv[1]);
+    if (JS_IsNull(result))
+        log_warn("[hull:c] ignoring precompiled template '%s': "
+                 "invalid program", name);
+    JS_FreeCString(ctx, name);
+    return result;
+}
+
 static int js_template_module_init(JSContext *ctx, JSModuleDef *m)
 {
     JSValue tpl = JS_NewObject(ctx);
-    JS_SetPropertyStr(ctx, tpl, "compile",
-                      JS_NewCFunction(ctx, js_template_compile, "compile", 2));
+    JS_SetPropertyStr(ctx, tpl, "program",
+                      JS_NewCFunction(ctx, js_template_program, "program", 2));
     JS_SetPropertyStr(ctx, tpl, "loadRaw",
                       JS_NewCFunction(ctx, js_template_load_raw, "loadRaw", 1));
+    JS_SetPropertyStr(ctx, tpl, "loadCompiled",
+                      JS_NewCFunction(ctx, js_template_load_compiled, "loadCompiled", 2));
     JS_SetModuleExport(ctx, m, "_template", tpl);
     return 0;
 }
@@ -2728,6 +3592,10 @@ int hl_js_register_modules(HlJS *js)
     if (hl_js_init_smtp_module(js->ctx, js) != 0)
         return -1;
 
+    /* Register hull:_outbox — internal bridge for hull:middleware:outbox */
+    if (hl_js_init_outbox_module(js->ctx, js) != 0)
+        return -1;
+
     /* Register hull:_template — internal bridge for hull:template stdlib */
     if (hl_js_init_template_module(js->ctx, js) != 0)
         return -1;
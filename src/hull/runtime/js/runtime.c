@@ -9,15 +9,19 @@
  */
 
 #include "hull/runtime/js.h"
+#include "hull/access_log.h"
 #include "hull/alloc.h"
 #include "hull/limits.h"
 #include "hull/manifest.h"
 #include "hull/cap/body.h"
 #include "hull/cap/fs.h"
+#include "hull/cap/metrics.h"
+#include "hull/cap/sched.h"
 #include "hull/cap/env.h"
 #include "hull/cap/http.h"
 #include "hull/cap/db.h"
 #include "hull/cap/test.h"
+#include "hull/cap/time.h"
 #include "quickjs.h"
 
 #include <keel/keel.h>
@@ -43,6 +47,7 @@ int hl_js_init_env_module(JSContext *ctx, HlJS *js);
 int hl_js_init_crypto_module(JSContext *ctx, HlJS *js);
 int hl_js_init_log_module(JSContext *ctx, HlJS *js);
 int hl_js_init_smtp_module(JSContext *ctx, HlJS *js);
+int hl_js_init_outbox_module(JSContext *ctx, HlJS *js);
 int hl_js_init_template_module(JSContext *ctx, HlJS *js);
 
 /* ── Forward declarations for binding helpers (defined in bindings.c) ─ */
@@ -63,6 +68,79 @@ static int hl_js_interrupt_handler(JSRuntime *rt, void *opaque)
     return 0;
 }
 
+/* ── Allocator ──────────────────────────────────────────────────────── */
+
+/*
+ * Same contract as QuickJS's default allocator (limit check, malloc_size
+ * and malloc_count upkeep), but blocks carry their size in a prefix so
+ * no malloc_usable_size() is needed, and the runtime's JSMallocState is
+ * captured so request-boundary GC can read the heap size without
+ * walking the heap (JS_ComputeMemoryUsage).
+ */
+#define HL_JS_BLOCK_HDR 16  /* size prefix, keeps 16-byte alignment */
+
+static void *hl_js_malloc(JSMallocState *s, size_t size)
+{
+    ((HlJS *)s->opaque)->malloc_state = s;
+
+    if (size > s->malloc_limit ||
+        s->malloc_size > s->malloc_limit - size)
+        return NULL;
+
+    size_t *block = malloc(HL_JS_BLOCK_HDR + size);
+    if (!block)
+        return NULL;
+    block[0] = size;
+    s->malloc_count++;
+    s->malloc_size += HL_JS_BLOCK_HDR + size;
+    return (char *)block + HL_JS_BLOCK_HDR;
+}
+
+static void hl_js_free_block(JSMallocState *s, void *ptr)
+{
+    if (!ptr)
+        return;
+    size_t *block = (size_t *)((char *)ptr - HL_JS_BLOCK_HDR);
+    s->malloc_count--;
+    s->malloc_size -= HL_JS_BLOCK_HDR + block[0];
+    free(block);
+}
+
+static void *hl_js_realloc(JSMallocState *s, void *ptr, size_t size)
+{
+    if (!ptr)
+        return size ? hl_js_malloc(s, size) : NULL;
+    if (size == 0) {
+        hl_js_free_block(s, ptr);
+        return NULL;
+    }
+
+    size_t *block = (size_t *)((char *)ptr - HL_JS_BLOCK_HDR);
+    size_t old_size = block[0];
+    if (size > old_size && (size - old_size > s->malloc_limit ||
+                            s->malloc_size > s->malloc_limit - (size - old_size)))
+        return NULL;
+
+    block = realloc(block, HL_JS_BLOCK_HDR + size);
+    if (!block)
+        return NULL;
+    block[0] = size;
+    s->malloc_size = s->malloc_size - old_size + size;
+    return (char *)block + HL_JS_BLOCK_HDR;
+}
+
+static size_t hl_js_usable_size(const void *ptr)
+{
+    return ((const size_t *)((const char *)ptr - HL_JS_BLOCK_HDR))[0];
+}
+
+static const JSMallocFunctions hl_js_malloc_funcs = {
+    hl_js_malloc,
+    hl_js_free_block,
+    hl_js_realloc,
+    hl_js_usable_size,
+};
+
 /* ── Module loader ──────────────────────────────────────────────────── */
 
 /*
@@ -87,12 +165,56 @@ static int hl_js_validate_module_name(const char *name)
  * Module name normalizer. For hull: prefix, return as-is.
  * For relative paths, resolve against the application root.
  */
+/*
+ * Map a resolved module name onto its embedded app entry name, if any.
+ * Resolved names look like "/abs/app/./routes/users.js" or, for imports
+ * from an embedded module, "./routes/./util.js"; embedded entries use the
+ * canonical "./routes/util.js" form. Collapses "/./" segments after the
+ * first "./" and returns a js_malloc'd canonical name when the app VFS
+ * contains it, NULL otherwise.
+ *
+ * Embedded modules must be named canonically: precompiled bytecode
+ * carries its own module name, and QuickJS dedups loaded modules by
+ * that name.
+ */
+static char *hl_js_canonical_app_name(JSContext *ctx, const HlJS *js,
+                                      const char *resolved)
+{
+    if (!js || !js->base.app_vfs || js->base.app_vfs->count == 0)
+        return NULL;
+
+    const char *start = resolved;
+    if (strncmp(start, "./", 2) != 0) {
+        start = strstr(resolved, "/./");
+        if (!start)
+            return NULL;
+        start++; /* points to "./" */
+    }
+
+    char canon[HL_MODULE_PATH_MAX];
+    size_t len = 0;
+    canon[len++] = '.';
+    for (const char *p = start + 1; *p; ) {
+        if (p[0] == '/' && p[1] == '.' && p[2] == '/') {
+            p += 2; /* drop "/." — the following '/' is kept */
+            continue;
+        }
+        if (len + 1 >= sizeof(canon))
+            return NULL;
+        canon[len++] = *p++;
+    }
+    canon[len] = '\0';
+
+    if (!hl_vfs_find(js->base.app_vfs, canon))
+        return NULL;
+    return js_strdup(ctx, canon);
+}
+
 static char *hl_js_module_normalize(JSContext *ctx,
                                        const char *base_name,
                                        const char *name, void *opaque)
 {
-    (void)base_name;
-    (void)opaque;
+    HlJS *js = (HlJS *)opaque;
 
     /* hull:* modules are already normalized */
     if (strncmp(name, "hull:", 5) == 0)
@@ -129,6 +251,11 @@ static char *hl_js_module_normalize(JSContext *ctx,
                 return NULL;
             }
 
+            char *canon = hl_js_canonical_app_name(ctx, js, resolved);
+            if (canon) {
+                js_free(ctx, resolved);
+                return canon;
+            }
             return resolved;
         }
     }
@@ -136,6 +263,41 @@ static char *hl_js_module_normalize(JSContext *ctx,
     return js_strdup(ctx, name);
 }
 
+/*
+ * Load precompiled bytecode for an embedded module, if the VFS carries a
+ * "<name>.jsc" companion (".js" extension stripped). Returns the module,
+ * or NULL with no pending exception when there is no usable bytecode —
+ * e.g. it was produced by a different QuickJS version — so the caller
+ * falls back to compiling the source.
+ */
+static JSModuleDef *hl_js_load_bytecode(JSContext *ctx, const HlVfs *vfs,
+                                        const char *name)
+{
+    char base[HL_MODULE_PATH_MAX];
+    size_t n = strlen(name);
+    if (n >= 3 && strcmp(name + n - 3, ".js") == 0)
+        n -= 3;
+    if (n >= sizeof(base))
+        return NULL;
+    memcpy(base, name, n);
+    base[n] = '\0';
+
+    const HlEntry *bc = hl_vfs_find_suffixed(vfs, base, HL_JS_BYTECODE_SUFFIX);
+    if (!bc)
+        return NULL;
+
+    JSValue obj = JS_ReadObject(ctx, bc->data, bc->len, JS_READ_OBJ_BYTECODE);
+    if (JS_IsException(obj) || JS_VALUE_GET_TAG(obj) != JS_TAG_MODULE) {
+        log_warn("[hull:c] ignoring bytecode for '%s'", name);
+        JS_FreeValue(ctx, JS_GetException(ctx));
+        JS_FreeValue(ctx, obj);
+        return NULL;
+    }
+    JSModuleDef *m = (JSModuleDef *)JS_VALUE_GET_PTR(obj);
+    JS_FreeValue(ctx, obj);
+    return m;
+}
+
 /*
  * Module loader. Handles:
  * 1. hull:* prefix → built-in modules (registered at init time)
@@ -154,6 +316,11 @@ static JSModuleDef *hl_js_module_loader(JSContext *ctx,
         if (js->base.platform_vfs) {
             const HlEntry *e = hl_vfs_find(js->base.platform_vfs, module_name);
             if (e) {
+                JSModuleDef *bm = hl_js_load_bytecode(ctx, js->base.platform_vfs,
+                                                      module_name);
+                if (bm)
+                    return bm;
+
                 /* QuickJS lexer requires a '\0' sentinel after the
                  * source buffer; xxd arrays lack one, so copy. */
                 char *src = js_malloc(ctx, (size_t)e->len + 1);
@@ -196,6 +363,13 @@ static JSModuleDef *hl_js_module_loader(JSContext *ctx,
             int is_js = (elen >= 3 && strcmp(e->name + elen - 3, ".js") == 0);
             int is_json = (elen >= 5 && strcmp(e->name + elen - 5, ".json") == 0);
 
+            if (is_js) {
+                JSModuleDef *bm = hl_js_load_bytecode(ctx, js->base.app_vfs,
+                                                      e->name);
+                if (bm)
+                    return bm;
+            }
+
             if (is_js || is_json) {
                 const char *src = (const char *)e->data;
                 size_t src_len = e->len;
@@ -460,10 +634,14 @@ int hl_js_init(HlJS *js, const HlJSConfig *cfg)
     /* Restore caller-set base fields */
     js->base = saved_base;
     js->max_instructions = cfg->max_instructions;
+    js->gc_mode = cfg->gc_mode;
+    js->gc_threshold = cfg->gc_threshold;
+    js->gc_growth = cfg->gc_threshold;
+    js->gc_budget_ns = (int64_t)cfg->gc_budget_us * 1000;
 
-    /* Create runtime (using default allocator for now;
+    /* Create runtime (process malloc with size-prefixed blocks;
      * custom KlAllocator routing added when Keel is linked) */
-    js->rt = JS_NewRuntime();
+    js->rt = JS_NewRuntime2(&hl_js_malloc_funcs, js);
     if (!js->rt)
         return -1;
 
@@ -614,6 +792,13 @@ int hl_js_load_app(HlJS *js, const char *filename)
     /* Reset scratch arena — startup module loads no longer needed */
     sh_arena_reset(js->scratch);
 
+    /* Start boundary pacing from the loaded app's heap */
+    if (js->gc_mode == HL_GC_REQUEST && js->malloc_state) {
+        JS_RunGC(js->rt);
+        js->gc_baseline = js->malloc_state->malloc_size;
+        JS_SetGCThreshold(js->rt, js->gc_baseline + HL_JS_GC_HEADROOM);
+    }
+
     return 0;
 }
 
@@ -639,6 +824,36 @@ void hl_js_gc(HlJS *js)
         JS_RunGC(js->rt);
 }
 
+void hl_js_request_end(HlJS *js)
+{
+    if (!js || !js->rt || js->gc_mode != HL_GC_REQUEST || !js->malloc_state)
+        return;
+
+    size_t used = js->malloc_state->malloc_size;
+    if (used < js->gc_baseline)
+        js->gc_baseline = used;
+    if (used - js->gc_baseline > js->gc_growth) {
+        int64_t t0 = hl_cap_time_clock_ns();
+        JS_RunGC(js->rt);
+        uint64_t ns = (uint64_t)(hl_cap_time_clock_ns() - t0);
+        js->gc_baseline = js->malloc_state->malloc_size;
+        hl_gc_stats_record(&js->base.gc_stats, ns, (uint64_t)js->gc_budget_ns,
+                           used, js->gc_baseline);
+
+        /* A pause scales with the live heap, not the garbage: when it
+         * overruns the budget, collect half as often instead */
+        size_t growth_max = js->malloc_state->malloc_limit / 4;
+        if (ns > (uint64_t)js->gc_budget_ns && js->gc_growth < growth_max / 2)
+            js->gc_growth *= 2;
+        else if (ns < (uint64_t)js->gc_budget_ns / 4 &&
+                 js->gc_growth / 2 >= js->gc_threshold)
+            js->gc_growth /= 2;
+    }
+
+    /* Mid-handler collection only as a backstop for large requests */
+    JS_SetGCThreshold(js->rt, js->malloc_state->malloc_size + HL_JS_GC_HEADROOM);
+}
+
 void hl_js_reset_request(HlJS *js)
 {
     if (!js)
@@ -673,7 +888,7 @@ void hl_js_free(HlJS *js)
         static const char *hull_globals[] = {
             "console",
             "__hull_routes", "__hull_route_defs",
-            "__hull_middleware", "__hull_post_middleware",
+            "__hull_middleware", "__hull_post_middleware", "__hull_jobs",
             "__hull_config", "__hull_manifest", "__hull_statics",
             "__hull_test_state", "test",
         };
@@ -788,12 +1003,14 @@ int hl_js_dispatch(HlJS *js, int handler_id,
     }
 
     /* Build JS request and response objects */
+    js->upload = hl_cap_body_upload(req->body_reader);
     JSValue js_req = hl_js_make_request(js->ctx, req);
     JSValue js_res = hl_js_make_response(js, res);
 
     /* Call handler(req, res) */
     JSValue argv[2] = { js_req, js_res };
     JSValue ret = JS_Call(js->ctx, handler, JS_UNDEFINED, 2, argv);
+    js->upload = NULL; /* req.upload methods stop working here */
 
     int result = 0;
     if (JS_IsException(ret)) {
@@ -836,16 +1053,154 @@ int hl_js_register_stdlib(HlJS *js)
     return 0;
 }
 
+/* ── Upload routes ─────────────────────────────────────────────────── */
+
+/*
+ * Stream route: call onChunk(req, chunk) as each chunk arrives (chunk
+ * is an ArrayBuffer), with the same stale transaction guard and
+ * instruction budget as a request. req.ctx is kept as JSON in the
+ * upload between calls and reaches the handler's req.ctx.
+ */
+static int hl_js_body_chunk(HlBodyUpload *up, const char *data, size_t len,
+                            void *user_data)
+{
+    HlJSRoute *route = (HlJSRoute *)user_data;
+    HlJS *js = route->js;
+    JSContext *ctx = js->ctx;
+
+    hl_cap_db_guard_stale_txn(js->base.db);
+    hl_js_reset_request(js);
+
+    JSValue global = JS_GetGlobalObject(ctx);
+    JSValue routes = JS_GetPropertyStr(ctx, global, "__hull_routes");
+    JSValue fn = JS_GetPropertyUint32(ctx, routes, (uint32_t)route->chunk_id);
+    JS_FreeValue(ctx, routes);
+    JS_FreeValue(ctx, global);
+    if (!JS_IsFunction(ctx, fn)) {
+        JS_FreeValue(ctx, fn);
+        return -1;
+    }
+
+    js->upload = up;
+    JSValue js_req = hl_js_make_request(ctx, (KlRequest *)up->req);
+    JSValue argv[2] = {
+        js_req, JS_NewArrayBufferCopy(ctx, (const uint8_t *)data, len)
+    };
+    JSValue ret = JS_Call(ctx, fn, JS_UNDEFINED, 2, argv);
+
+    int rc = 0;
+    if (JS_IsException(ret)) {
+        hl_js_dump_error(js);
+        rc = -1;
+    } else {
+        JSValue ctx_val = JS_GetPropertyStr(ctx, js_req, "ctx");
+        if (JS_IsObject(ctx_val)) {
+            JSValue json_val = JS_JSONStringify(ctx, ctx_val, JS_UNDEFINED,
+                                                 JS_UNDEFINED);
+            size_t json_len = 0;
+            const char *json_str = JS_IsString(json_val)
+                                 ? JS_ToCStringLen(ctx, &json_len, json_val)
+                                 : NULL;
+            if (json_str && (json_len >= 65536 ||
+                             hl_cap_body_set_state(up, json_str, json_len) != 0)) {
+                log_error("[hull:c] onChunk: req.ctx too large to carry");
+                rc = -1;
+            }
+            if (json_str) JS_FreeCString(ctx, json_str);
+            JS_FreeValue(ctx, json_val);
+        }
+        JS_FreeValue(ctx, ctx_val);
+    }
+    js->upload = NULL;
+
+    JS_FreeValue(ctx, ret);
+    JS_FreeValue(ctx, argv[1]);
+    JS_FreeValue(ctx, js_req);
+    JS_FreeValue(ctx, fn);
+    hl_js_run_jobs(js);
+    return rc;
+}
+
+/* Body reader for a route: its declared mode, buffered by default */
+static KlBodyReader *hl_js_body_factory(KlAllocator *alloc,
+                                        const KlRequest *req,
+                                        void *user_data)
+{
+    HlJSRoute *route = (HlJSRoute *)user_data;
+    return hl_cap_body_open(alloc, req, &route->body, route->js->base.db,
+                            route->chunk_id > 0 ? hl_js_body_chunk : NULL,
+                            route);
+}
+
+static int js_route_string(JSContext *ctx, JSValueConst def, const char *key,
+                           char *out, size_t size)
+{
+    JSValue v = JS_GetPropertyStr(ctx, def, key);
+    const char *s = JS_IsString(v) ? JS_ToCString(ctx, v) : NULL;
+    int rc = 0;
+    if (s && strlen(s) < size)
+        memcpy(out, s, strlen(s) + 1);
+    else if (s)
+        rc = -1;
+    if (s) JS_FreeCString(ctx, s);
+    JS_FreeValue(ctx, v);
+    return rc;
+}
+
+/*
+ * Fill route->body from a route def and check it against the manifest.
+ * Returns 0, or -1 (logged) for a bad declaration.
+ */
+static int hl_js_route_body(HlJS *js, JSValueConst def, HlJSRoute *route)
+{
+    JSContext *ctx = js->ctx;
+    HlBodySpec *spec = &route->body;
+
+    memset(spec, 0, sizeof(*spec));
+    JSValue v = JS_GetPropertyStr(ctx, def, "body");
+    const char *mode = JS_IsString(v) ? JS_ToCString(ctx, v) : NULL;
+    spec->mode = mode ? (HlBodyMode)hl_cap_body_mode(mode) : HL_BODY_BUFFER;
+    if (mode) JS_FreeCString(ctx, mode);
+    JS_FreeValue(ctx, v);
+
+    v = JS_GetPropertyStr(ctx, def, "max_body");
+    int64_t max_size = 0;
+    if (JS_IsNumber(v))
+        JS_ToInt64(ctx, &max_size, v);
+    spec->max_size = max_size;
+    JS_FreeValue(ctx, v);
+
+    v = JS_GetPropertyStr(ctx, def, "chunk_id");
+    int32_t chunk_id = 0;
+    if (JS_IsNumber(v))
+        JS_ToInt32(ctx, &chunk_id, v);
+    route->chunk_id = chunk_id;
+    JS_FreeValue(ctx, v);
+
+    if (js_route_string(ctx, def, "dir", spec->dir, sizeof(spec->dir)) != 0 ||
+        js_route_string(ctx, def, "table", spec->table, sizeof(spec->table)) != 0 ||
+        js_route_string(ctx, def, "column", spec->column, sizeof(spec->column)) != 0) {
+        log_error("[hull:c] body: dir, table or column too long");
+        return -1;
+    }
+    return hl_cap_body_check(spec, js->base.manifest);
+}
+
 /* ── Route wiring ──────────────────────────────────────────────────── */
 
 void hl_js_keel_handler(KlRequest *req, KlResponse *res, void *user_data)
 {
     HlJSRoute *route = (HlJSRoute *)user_data;
+    uint64_t t0 = hl_metrics_start();
     if (hl_js_dispatch(route->js, route->handler_id, req, res) != 0) {
         kl_response_status(res, 500);
         kl_response_header(res, "Content-Type", "text/plain");
         kl_response_body(res, "Internal Server Error", 21);
     }
+    hl_metrics_route_end(route->metrics_id, res->status, t0);
+    hl_access_log_finish(req, res->status, res->body_len);
+    hl_js_request_end(route->js);
+    hl_metrics_runtime(&route->js->base);
 }
 
 int hl_js_wire_routes(HlJS *js, KlRouter *router)
@@ -866,7 +1221,8 @@ int hl_js_wire_routes(HlJS *js, KlRouter *router)
     JS_ToInt32(ctx, &count, len_val);
     JS_FreeValue(ctx, len_val);
 
-    for (int32_t i = 0; i < count; i++) {
+    int failed = 0;
+    for (int32_t i = 0; i < count && !failed; i++) {
         JSValue def = JS_GetPropertyUint32(ctx, defs, (uint32_t)i);
         if (JS_IsUndefined(def))
             continue;
@@ -886,9 +1242,20 @@ int hl_js_wire_routes(HlJS *js, KlRouter *router)
             if (route) {
                 route->js = js;
                 route->handler_id = handler_id;
-                hl_js_track_route(js, route);
-                kl_router_add(router, method_str, pattern,
-                              hl_js_keel_handler, route, NULL);
+                route->metrics_id = -1;
+                if (hl_js_route_body(js, def, route) != 0) {
+                    log_error("[hull:c] route %s %s: invalid body options",
+                              method_str, pattern);
+                    hl_alloc_free(js->base.alloc, route, sizeof(HlJSRoute));
+                    failed = 1;
+                } else {
+                    hl_js_track_route(js, route);
+                    /* Buffered bodies come from the caller (hull test) */
+                    kl_router_add(router, method_str, pattern,
+                                  hl_js_keel_handler, route,
+                                  route->body.mode != HL_BODY_BUFFER
+                                      ? hl_js_body_factory : NULL);
+                }
             }
         }
 
@@ -903,7 +1270,7 @@ int hl_js_wire_routes(HlJS *js, KlRouter *router)
     JS_FreeValue(ctx, defs);
     JS_FreeValue(ctx, global);
 
-    return 0;
+    return failed ? -1 : 0;
 }
 
 /* ── Server route wiring (with body reader factory) ────────────────── */
@@ -928,7 +1295,8 @@ int hl_js_wire_routes_server(HlJS *js, KlServer *server,
     JS_ToInt32(ctx, &count, len_val);
     JS_FreeValue(ctx, len_val);
 
-    for (int32_t i = 0; i < count; i++) {
+    int failed = 0;
+    for (int32_t i = 0; i < count && !failed; i++) {
         JSValue def = JS_GetPropertyUint32(ctx, defs, (uint32_t)i);
         if (JS_IsUndefined(def))
             continue;
@@ -948,10 +1316,18 @@ int hl_js_wire_routes_server(HlJS *js, KlServer *server,
             if (route) {
                 route->js = js;
                 route->handler_id = handler_id;
-                hl_js_track_route(js, route);
-                kl_server_route(server, method_str, pattern,
-                                hl_js_keel_handler, route,
-                                hl_cap_body_factory);
+                route->metrics_id = hl_metrics_route(method_str, pattern);
+                if (hl_js_route_body(js, def, route) != 0) {
+                    log_error("[hull:c] route %s %s: invalid body options",
+                              method_str, pattern);
+                    hl_alloc_free(js->base.alloc, route, sizeof(HlJSRoute));
+                    failed = 1;
+                } else {
+                    hl_js_track_route(js, route);
+                    kl_server_route(server, method_str, pattern,
+                                    hl_js_keel_handler, route,
+                                    hl_js_body_factory);
+                }
             }
         }
 
@@ -964,6 +1340,10 @@ int hl_js_wire_routes_server(HlJS *js, KlServer *server,
     }
 
     JS_FreeValue(ctx, defs);
+    if (failed) {
+        JS_FreeValue(ctx, global);
+        return -1;
+    }
 
     /* Wire middleware from __hull_middleware */
     JSValue mw = JS_GetPropertyStr(ctx, global, "__hull_middleware");
@@ -993,6 +1373,7 @@ int hl_js_wire_routes_server(HlJS *js, KlServer *server,
                 if (mw_ctx) {
                     mw_ctx->js = js;
                     mw_ctx->handler_id = handler_id;
+                    mw_ctx->metrics_id = -1;
                     hl_js_track_route(js, mw_ctx);
                     kl_server_use(server, method_str, pattern,
                                   hl_js_keel_middleware, mw_ctx);
@@ -1037,6 +1418,7 @@ int hl_js_wire_routes_server(HlJS *js, KlServer *server,
                 if (mw_ctx) {
                     mw_ctx->js = js;
                     mw_ctx->handler_id = handler_id;
+                    mw_ctx->metrics_id = -1;
                     hl_js_track_route(js, mw_ctx);
                     kl_server_use_post(server, method_str, pattern,
                                        hl_js_keel_middleware, mw_ctx);
@@ -1057,6 +1439,184 @@ int hl_js_wire_routes_server(HlJS *js, KlServer *server,
     return 0;
 }
 
+/* ── Hot reload ────────────────────────────────────────────────────── */
+
+/* String form of obj[field] (NULL if missing); free with JS_FreeCString */
+static const char *js_field_cstring(JSContext *ctx, JSValueConst obj,
+                                    const char *field)
+{
+    JSValue v = JS_GetPropertyStr(ctx, obj, field);
+    const char *s = JS_IsUndefined(v) ? NULL : JS_ToCString(ctx, v);
+    JS_FreeValue(ctx, v);
+    return s;
+}
+
+static int32_t js_array_length(JSContext *ctx, JSValueConst arr)
+{
+    int32_t n = 0;
+    if (JS_IsArray(ctx, arr)) {
+        JSValue len = JS_GetPropertyStr(ctx, arr, "length");
+        JS_ToInt32(ctx, &n, len);
+        JS_FreeValue(ctx, len);
+    }
+    return n;
+}
+
+static const char *route_fields[] = { "method", "pattern", "handler_id",
+                                      "body", "max_body", "dir", "table",
+                                      "column", "chunk_id", NULL };
+static const char *job_fields[] = { "kind", "spec", "name", "jitter", "handler_id", NULL };
+
+/*
+ * Compare one registration array (route defs, middleware or jobs) of two
+ * contexts: same length, and the same `fields` at every index. Missing
+ * arrays compare as empty.
+ */
+static int js_defs_equal(JSContext *a, JSContext *b, const char *key,
+                         const char **fields)
+{
+    JSValue ga = JS_GetGlobalObject(a);
+    JSValue gb = JS_GetGlobalObject(b);
+    JSValue da = JS_GetPropertyStr(a, ga, key);
+    JSValue db = JS_GetPropertyStr(b, gb, key);
+    int32_t n = js_array_length(a, da);
+    int equal = (n == js_array_length(b, db));
+
+    for (int32_t i = 0; equal && i < n; i++) {
+        JSValue ea = JS_GetPropertyUint32(a, da, (uint32_t)i);
+        JSValue eb = JS_GetPropertyUint32(b, db, (uint32_t)i);
+        for (int f = 0; equal && fields[f]; f++) {
+            const char *va = js_field_cstring(a, ea, fields[f]);
+            const char *vb = js_field_cstring(b, eb, fields[f]);
+            equal = (va && vb) ? strcmp(va, vb) == 0 : va == vb;
+            if (va) JS_FreeCString(a, va);
+            if (vb) JS_FreeCString(b, vb);
+        }
+        JS_FreeValue(a, ea);
+        JS_FreeValue(b, eb);
+    }
+
+    JS_FreeValue(a, da);
+    JS_FreeValue(b, db);
+    JS_FreeValue(a, ga);
+    JS_FreeValue(b, gb);
+    return equal;
+}
+
+int hl_js_adopt_routes(HlJS *js, HlJS *from)
+{
+    if (!js || !js->ctx || !from || !from->ctx || js->routes)
+        return 1;
+
+    if (!js_defs_equal(js->ctx, from->ctx, "__hull_route_defs", route_fields) ||
+        !js_defs_equal(js->ctx, from->ctx, "__hull_middleware", route_fields) ||
+        !js_defs_equal(js->ctx, from->ctx, "__hull_post_middleware", route_fields) ||
+        !js_defs_equal(js->ctx, from->ctx, "__hull_jobs", job_fields))
+        return 1;
+
+    /* Same handler_id at every registration: only the context changes */
+    for (size_t i = 0; i < from->route_count; i++)
+        ((HlJSRoute *)from->routes[i])->js = js;
+
+    js->routes = from->routes;
+    js->route_count = from->route_count;
+    js->route_cap = from->route_cap;
+    from->routes = NULL;
+    from->route_count = 0;
+    from->route_cap = 0;
+    return 0;
+}
+
+/* ── Background jobs ───────────────────────────────────────────────── */
+
+int hl_js_extract_jobs(HlJS *js, HlJobDef *out, int max)
+{
+    if (!js || !js->ctx || !out)
+        return -1;
+
+    JSContext *ctx = js->ctx;
+    JSValue global = JS_GetGlobalObject(ctx);
+    JSValue jobs = JS_GetPropertyStr(ctx, global, "__hull_jobs");
+    int32_t n = js_array_length(ctx, jobs);
+
+    int count = 0;
+    for (int32_t i = 0; i < n && count < max; i++) {
+        JSValue e = JS_GetPropertyUint32(ctx, jobs, (uint32_t)i);
+        const char *kind = js_field_cstring(ctx, e, "kind");
+        const char *spec = js_field_cstring(ctx, e, "spec");
+        const char *name = js_field_cstring(ctx, e, "name");
+        int64_t jitter = 0;
+        int32_t handler_id = -1;
+        JSValue v = JS_GetPropertyStr(ctx, e, "jitter");
+        JS_ToInt64(ctx, &jitter, v);
+        JS_FreeValue(ctx, v);
+        v = JS_GetPropertyStr(ctx, e, "handler_id");
+        JS_ToInt32(ctx, &handler_id, v);
+        JS_FreeValue(ctx, v);
+
+        int rc = hl_sched_job_def(&out[count], kind, spec, name, jitter,
+                                  handler_id);
+        if (kind) JS_FreeCString(ctx, kind);
+        if (spec) JS_FreeCString(ctx, spec);
+        if (name) JS_FreeCString(ctx, name);
+        JS_FreeValue(ctx, e);
+        if (rc != 0) {
+            count = -1;
+            break;
+        }
+        count++;
+    }
+
+    JS_FreeValue(ctx, jobs);
+    JS_FreeValue(ctx, global);
+    return count;
+}
+
+int hl_js_run_job(HlJS *js, int handler_id)
+{
+    if (!js || !js->ctx)
+        return -1;
+
+    /* Guard: roll back any stale transaction left by a crashed handler */
+    hl_cap_db_guard_stale_txn(js->base.db);
+
+    hl_js_reset_request(js);
+
+    JSContext *ctx = js->ctx;
+    JSValue global = JS_GetGlobalObject(ctx);
+    JSValue routes = JS_GetPropertyStr(ctx, global, "__hull_routes");
+    JSValue fn = JS_IsArray(ctx, routes)
+        ? JS_GetPropertyUint32(ctx, routes, (uint32_t)handler_id)
+        : JS_UNDEFINED;
+    JS_FreeValue(ctx, routes);
+    JS_FreeValue(ctx, global);
+
+    int rc = -1;
+    if (JS_IsFunction(ctx, fn)) {
+        JSValue ret = JS_Call(ctx, fn, JS_UNDEFINED, 0, NULL);
+        if (JS_IsException(ret)) {
+            hl_js_dump_error(js);
+        } else {
+            rc = 0;
+            /* An async job settles in the microtasks run here */
+            hl_js_run_jobs(js);
+            if (JS_PromiseState(ctx, ret) == JS_PROMISE_REJECTED) {
+                JSValue reason = JS_PromiseResult(ctx, ret);
+                const char *msg = JS_ToCString(ctx, reason);
+                log_error("[hull:c] js job rejected: %s", msg ? msg : "?");
+                if (msg) JS_FreeCString(ctx, msg);
+                JS_FreeValue(ctx, reason);
+                rc = -1;
+            }
+        }
+        JS_FreeValue(ctx, ret);
+    }
+    JS_FreeValue(ctx, fn);
+
+    hl_js_request_end(js);
+    return rc;
+}
+
 /* ── Middleware dispatch ────────────────────────────────────────────── */
 
 int hl_js_dispatch_middleware(HlJS *js, int handler_id,
@@ -1161,8 +1721,11 @@ int hl_js_keel_middleware(KlRequest *req, KlResponse *res, void *user_data)
         kl_response_status(res, 500);
         kl_response_header(res, "Content-Type", "text/plain");
         kl_response_body(res, "Internal Server Error", 21);
+        hl_access_log_finish(req, 500, 21);
         return 1; /* short-circuit */
     }
+    if (rc != 0)
+        hl_access_log_finish(req, res->status, res->body_len);
     return rc;
 }
 
@@ -1196,6 +1759,21 @@ static void vt_js_free_manifest_strings(HlRuntime *rt, HlManifest *m)
     hl_manifest_free_js_strings(js->ctx, m);
 }
 
+static int vt_js_adopt_routes(HlRuntime *rt, HlRuntime *from)
+{
+    return hl_js_adopt_routes((HlJS *)rt, (HlJS *)from);
+}
+
+static int vt_js_extract_jobs(HlRuntime *rt, HlJobDef *out, int max)
+{
+    return hl_js_extract_jobs((HlJS *)rt, out, max);
+}
+
+static int vt_js_run_job(HlRuntime *rt, int handler_id)
+{
+    return hl_js_run_job((HlJS *)rt, handler_id);
+}
+
 static void vt_js_destroy(HlRuntime *rt)
 {
     hl_js_free((HlJS *)rt);
@@ -1207,6 +1785,9 @@ const HlRuntimeVtable hl_js_vtable = {
     .wire_routes_server  = vt_js_wire_routes_server,
     .extract_manifest    = vt_js_extract_manifest,
     .free_manifest_strings = vt_js_free_manifest_strings,
+    .adopt_routes        = vt_js_adopt_routes,
+    .extract_jobs        = vt_js_extract_jobs,
+    .run_job             = vt_js_run_job,
     .destroy             = vt_js_destroy,
     .name                = "QuickJS",
 };
@@ -66,6 +66,105 @@ static const char *hl_lua_stash_body(lua_State *L, const char *data,
     return hlua->response_body;
 }
 
+/* ── Upload object ──────────────────────────────────────────────────── */
+
+/*
+ * req.upload of a route declared with body = "stream" | "spool" | "blob":
+ *   { mode, size }                                  (all)
+ *   { path, read(self, n?), keep(self, name) }      (spool)
+ *   { table, column, rowid }                        (blob)
+ * The methods work only while the request is being handled.
+ */
+
+static HlBodyUpload *lua_check_upload(lua_State *L)
+{
+    HlBodyUpload *up = (HlBodyUpload *)lua_touserdata(L, lua_upvalueindex(1));
+    HlLua *hlua = get_hl_lua_from_L(L);
+    if (!hlua || !up || hlua->upload != up)
+        luaL_error(L, "upload is only available during its request");
+    return up;
+}
+
+/* upload:read(n?) → next n bytes (default 64 KB), nil at the end */
+static int lua_upload_read(lua_State *L)
+{
+    HlBodyUpload *up = lua_check_upload(L);
+    lua_Integer n = luaL_optinteger(L, 2, 65536);
+    luaL_argcheck(L, n > 0 && n <= HL_BODY_MAX_SIZE, 2,
+                  "must be 1..1048576");
+
+    luaL_Buffer b;
+    char *p = luaL_buffinitsize(L, &b, (size_t)n);
+    int64_t got = hl_cap_body_read(up, p, (size_t)n);
+    if (got < 0)
+        return luaL_error(L, "upload read failed");
+    if (got == 0) {
+        lua_pushnil(L);
+        return 1;
+    }
+    luaL_pushresultsize(&b, (size_t)got);
+    return 1;
+}
+
+/* upload:keep(name) → path the file was kept at, or nil */
+static int lua_upload_keep(lua_State *L)
+{
+    HlBodyUpload *up = lua_check_upload(L);
+    const char *name = luaL_checkstring(L, 2);
+    if (hl_cap_body_keep(up, name) != 0) {
+        lua_pushnil(L);
+        return 1;
+    }
+    lua_pushstring(L, up->path);
+    return 1;
+}
+
+static void lua_push_upload(lua_State *L, HlBodyUpload *up)
+{
+    lua_newtable(L);
+    lua_pushstring(L, hl_cap_body_mode_name(up->mode));
+    lua_setfield(L, -2, "mode");
+    lua_pushinteger(L, (lua_Integer)up->size);
+    lua_setfield(L, -2, "size");
+
+    if (up->mode == HL_BODY_SPOOL) {
+        lua_pushstring(L, up->path);
+        lua_setfield(L, -2, "path");
+        lua_pushlightuserdata(L, up);
+        lua_pushcclosure(L, lua_upload_read, 1);
+        lua_setfield(L, -2, "read");
+        lua_pushlightuserdata(L, up);
+        lua_pushcclosure(L, lua_upload_keep, 1);
+        lua_setfield(L, -2, "keep");
+    } else if (up->mode == HL_BODY_BLOB) {
+        lua_pushstring(L, up->table);
+        lua_setfield(L, -2, "table");
+        lua_pushstring(L, up->column);
+        lua_setfield(L, -2, "column");
+        lua_pushinteger(L, (lua_Integer)up->rowid);
+        lua_setfield(L, -2, "rowid");
+    }
+}
+
+/* Decode a JSON object and merge its fields into the table at ctx_idx */
+static void lua_merge_json(lua_State *L, int ctx_idx, const char *json)
+{
+    lua_getglobal(L, "json");
+    lua_getfield(L, -1, "decode");
+    lua_pushstring(L, json);
+    if (lua_pcall(L, 1, 1, 0) == LUA_OK && lua_istable(L, -1)) {
+        /* Merge decoded table into ctx */
+        lua_pushnil(L);
+        while (lua_next(L, -2) != 0) {
+            lua_pushvalue(L, -2); /* copy key */
+            lua_insert(L, -2);    /* stack: ..., key, key, value */
+            lua_settable(L, ctx_idx);  /* ctx[key] = value */
+        }
+    }
+    lua_pop(L, 1); /* pop decoded table or error */
+    lua_pop(L, 1); /* pop json table */
+}
+
 /* ── Request object ─────────────────────────────────────────────────── */
 
 /*
@@ -77,11 +176,15 @@ static const char *hl_lua_stash_body(lua_State *L, const char *data,
  *     query   = { limit = "10" },
  *     headers = { ["content-type"] = "application/json" },
  *     body    = "..." or nil,
+ *     upload  = {...} or nil,   (routes with an upload body mode)
  *     ctx     = {}
  *   }
  */
 void hl_lua_make_request(lua_State *L, KlRequest *req)
 {
+    HlLua *hlua = get_hl_lua_from_L(L);
+    HlBodyUpload *up = hlua ? hlua->upload : NULL;
+
     lua_newtable(L);
 
     /* method (Keel stores as string) */
@@ -158,7 +261,11 @@ void hl_lua_make_request(lua_State *L, KlRequest *req)
     lua_setfield(L, -2, "headers");
 
     /* body — extract from buffer reader if available */
-    if (req->body_reader) {
+    if (up) {
+        lua_push_upload(L, up);
+        lua_setfield(L, -2, "upload");
+        lua_pushnil(L);
+    } else if (req->body_reader) {
         const char *data;
         size_t len = hl_cap_body_data(req->body_reader, &data);
         if (len > 0)
@@ -172,26 +279,13 @@ void hl_lua_make_request(lua_State *L, KlRequest *req)
 
     /* ctx — per-request context table (middleware → handler).
      * If req->ctx carries a JSON string from a prior middleware dispatch,
-     * parse it and merge into the ctx table; otherwise start empty. */
+     * parse it and merge into the ctx table; otherwise start empty.
+     * A stream upload's on_chunk calls carry theirs on top. */
     lua_newtable(L);
-    if (req->ctx) {
-        int ctx_idx = lua_absindex(L, -1);
-        const char *json_ctx = (const char *)req->ctx;
-        lua_getglobal(L, "json");
-        lua_getfield(L, -1, "decode");
-        lua_pushstring(L, json_ctx);
-        if (lua_pcall(L, 1, 1, 0) == LUA_OK && lua_istable(L, -1)) {
-            /* Merge decoded table into ctx */
-            lua_pushnil(L);
-            while (lua_next(L, -2) != 0) {
-                lua_pushvalue(L, -2); /* copy key */
-                lua_insert(L, -2);    /* stack: ..., key, key, value */
-                lua_settable(L, ctx_idx);  /* ctx[key] = value */
-            }
-        }
-        lua_pop(L, 1); /* pop decoded table or error */
-        lua_pop(L, 1); /* pop json table */
-    }
+    if (req->ctx)
+        lua_merge_json(L, lua_absindex(L, -1), (const char *)req->ctx);
+    if (up && up->state)
+        lua_merge_json(L, lua_absindex(L, -1), up->state);
     lua_setfield(L, -2, "ctx");
 }
 
@@ -10,6 +10,8 @@
 
 #include "hull/runtime/lua.h"
 #include "hull/limits.h"
+#include "hull/parse_size.h"
+#include "hull/cap/body.h"
 #include "hull/cap/db.h"
 #include "hull/cap/time.h"
 #include "hull/cap/env.h"
@@ -17,6 +19,9 @@
 #include "hull/cap/smtp.h"
 #include "hull/cap/crypto.h"
 #include "hull/cap/fs.h"
+#include "hull/cap/outbox.h"
+#include "hull/cap/sched.h"
+#include "hull/cap/template.h"
 
 #include "lua.h"
 #include "lualib.h"
@@ -26,6 +31,7 @@
 
 #include "log.h"
 
+#include <ctype.h>
 #include <sqlite3.h>
 #include <stdlib.h>
 #include <string.h>
@@ -58,13 +64,83 @@ static HlLua *get_hl_lua(lua_State *L)
  * Routes are stored in the Lua registry:
  *   registry["__hull_routes"]     = { [1]=fn, [2]=fn, ... }
  *   registry["__hull_route_defs"] = { [1]={method,pattern,handler_id}, ... }
+ *                                   (+ body,max_body,dir,table,column,chunk_id
+ *                                    for routes declared with options)
+ *   registry["__hull_jobs"]       = { [1]={kind,spec,name,jitter,handler_id}, ... }
  * ════════════════════════════════════════════════════════════════════ */
 
+/*
+ * Copy the body options of app.get(pattern, handler, opts) into the def
+ * table at the top of the stack; routes_idx is __hull_routes, which also
+ * holds the on_chunk callback. The manifest-dependent checks run when the
+ * routes are wired (hl_cap_body_check).
+ *
+ *   body     = "buffer" | "stream" | "spool" | "blob"
+ *   max_body = bytes or a size string ("500m")
+ *   dir      = spool directory (inside a manifest fs.write path)
+ *   table, column = blob destination
+ *   on_chunk = function(req, chunk), required for "stream"
+ */
+static void lua_app_route_opts(lua_State *L, int opts_idx, int routes_idx)
+{
+    int def_idx = lua_absindex(L, -1);
+
+    lua_getfield(L, opts_idx, "body");
+    int mode = lua_isnil(L, -1) ? HL_BODY_BUFFER
+             : lua_type(L, -1) == LUA_TSTRING ? hl_cap_body_mode(lua_tostring(L, -1))
+             : -1;
+    if (mode < 0)
+        luaL_error(L, "body must be \"buffer\", \"stream\", \"spool\" or \"blob\"");
+    lua_setfield(L, def_idx, "body");
+
+    lua_getfield(L, opts_idx, "max_body");
+    if (lua_type(L, -1) == LUA_TSTRING) {
+        long n = hl_parse_size(lua_tostring(L, -1));
+        if (n <= 0)
+            luaL_error(L, "invalid max_body size '%s'", lua_tostring(L, -1));
+        lua_pushinteger(L, (lua_Integer)n);
+        lua_setfield(L, def_idx, "max_body");
+    } else if (!lua_isnil(L, -1)) {
+        int isint = 0;
+        lua_Integer n = lua_tointegerx(L, -1, &isint);
+        if (!isint || n <= 0)
+            luaL_error(L, "max_body must be a positive integer or size string");
+        lua_pushinteger(L, n);
+        lua_setfield(L, def_idx, "max_body");
+    }
+    lua_pop(L, 1);
+
+    static const char *strings[] = { "dir", "table", "column", NULL };
+    for (int i = 0; strings[i]; i++) {
+        lua_getfield(L, opts_idx, strings[i]);
+        if (!lua_isnil(L, -1) && lua_type(L, -1) != LUA_TSTRING)
+            luaL_error(L, "%s must be a string", strings[i]);
+        lua_setfield(L, def_idx, strings[i]);
+    }
+
+    lua_getfield(L, opts_idx, "on_chunk");
+    if (lua_isfunction(L, -1)) {
+        lua_Integer chunk_id = (lua_Integer)luaL_len(L, routes_idx) + 1;
+        lua_rawseti(L, routes_idx, chunk_id);
+        lua_pushinteger(L, chunk_id);
+        lua_setfield(L, def_idx, "chunk_id");
+    } else {
+        if (!lua_isnil(L, -1))
+            luaL_error(L, "on_chunk must be a function");
+        lua_pop(L, 1);
+    }
+    if ((mode == HL_BODY_STREAM) != (lua_getfield(L, def_idx, "chunk_id") != LUA_TNIL))
+        luaL_error(L, "on_chunk goes with body = \"stream\" (and only with it)");
+    lua_pop(L, 1);
+}
+
 /* Helper: register a route with given method string */
 static int lua_app_route(lua_State *L, const char *method)
 {
     const char *pattern = luaL_checkstring(L, 1);
     luaL_checktype(L, 2, LUA_TFUNCTION);
+    if (!lua_isnoneornil(L, 3))
+        luaL_checktype(L, 3, LUA_TTABLE);
 
     /* Ensure __hull_routes table exists in registry */
     lua_getfield(L, LUA_REGISTRYINDEX, "__hull_routes");
@@ -103,6 +179,8 @@ static int lua_app_route(lua_State *L, const char *method)
     lua_setfield(L, -2, "pattern");
     lua_pushinteger(L, handler_id);
     lua_setfield(L, -2, "handler_id");
+    if (lua_istable(L, 3))
+        lua_app_route_opts(L, 3, lua_absindex(L, -3));
     lua_rawseti(L, -2, def_idx); /* defs[def_idx] = def */
 
     lua_pop(L, 2); /* pop routes_table, defs_table */
@@ -206,6 +284,104 @@ static int lua_app_use_post(lua_State *L)
     return 0;
 }
 
+/* Interval argument: a number of seconds or a string such as "30s" */
+static int lua_app_interval(lua_State *L, int idx, int64_t *ms)
+{
+    if (lua_type(L, idx) == LUA_TNUMBER) {
+        lua_Number n = lua_tonumber(L, idx) * 1000;
+        if (!(n >= 0 && n <= (lua_Number)HL_SCHED_MAX_INTERVAL_MS))
+            return -1;
+        *ms = (int64_t)n;
+        return 0;
+    }
+    const char *s = lua_tostring(L, idx);
+    return s ? hl_sched_interval_parse(s, ms) : -1;
+}
+
+/*
+ * app.every(interval, fn [, opts]) / app.at(cron, fn [, opts]) — store
+ * fn with the route handlers and the job in __hull_jobs.
+ * opts: name (logs and metrics), jitter (interval, default 0).
+ */
+static int lua_app_job(lua_State *L, const char *kind)
+{
+    char spec[32];
+    const char *spec_str = spec;
+    if (strcmp(kind, "every") == 0) {
+        int64_t ms;
+        if (lua_app_interval(L, 1, &ms) != 0 || hl_sched_interval_check(ms) != 0)
+            return luaL_error(L, "app.every: interval must be 100ms .. 366d "
+                              "(seconds or \"30s\", \"5m\", ...)");
+        snprintf(spec, sizeof(spec), "%lld", (long long)ms);
+    } else {
+        spec_str = luaL_checkstring(L, 1);
+        HlCron cron;
+        if (hl_cron_parse(spec_str, &cron) != 0)
+            return luaL_error(L, "app.at: invalid cron expression '%s'", spec_str);
+    }
+    luaL_checktype(L, 2, LUA_TFUNCTION);
+
+    const char *name = NULL;
+    int64_t jitter = 0;
+    if (!lua_isnoneornil(L, 3)) {
+        luaL_checktype(L, 3, LUA_TTABLE);
+        lua_getfield(L, 3, "name");
+        if (!lua_isnil(L, -1))
+            name = luaL_checkstring(L, -1);
+        lua_getfield(L, 3, "jitter");
+        if (!lua_isnil(L, -1) && lua_app_interval(L, -1, &jitter) != 0)
+            return luaL_error(L, "app.%s: invalid jitter", kind);
+        lua_pop(L, 2); /* name stays alive in opts */
+    }
+
+    lua_getfield(L, LUA_REGISTRYINDEX, "__hull_jobs");
+    if (lua_isnil(L, -1)) {
+        lua_pop(L, 1);
+        lua_newtable(L);
+        lua_pushvalue(L, -1);
+        lua_setfield(L, LUA_REGISTRYINDEX, "__hull_jobs");
+    }
+    lua_Integer idx = (lua_Integer)luaL_len(L, -1) + 1;
+    if (idx > HL_SCHED_MAX_JOBS)
+        return luaL_error(L, "app.%s: too many jobs (max %d)", kind,
+                          HL_SCHED_MAX_JOBS);
+
+    /* Store handler in __hull_routes (same array as route handlers) */
+    lua_getfield(L, LUA_REGISTRYINDEX, "__hull_routes");
+    if (lua_isnil(L, -1)) {
+        lua_pop(L, 1);
+        lua_newtable(L);
+        lua_pushvalue(L, -1);
+        lua_setfield(L, LUA_REGISTRYINDEX, "__hull_routes");
+    }
+    lua_Integer handler_id = (lua_Integer)luaL_len(L, -1) + 1;
+    lua_pushvalue(L, 2);
+    lua_rawseti(L, -2, handler_id);
+    lua_pop(L, 1); /* pop routes table */
+
+    lua_newtable(L);
+    lua_pushstring(L, kind);
+    lua_setfield(L, -2, "kind");
+    lua_pushstring(L, spec_str);
+    lua_setfield(L, -2, "spec");
+    if (name)
+        lua_pushstring(L, name);
+    else
+        lua_pushfstring(L, "%s %s", kind, lua_tostring(L, 1));
+    lua_setfield(L, -2, "name");
+    lua_pushinteger(L, (lua_Integer)jitter);
+    lua_setfield(L, -2, "jitter");
+    lua_pushinteger(L, handler_id);
+    lua_setfield(L, -2, "handler_id");
+    lua_rawseti(L, -2, idx);
+
+    lua_pop(L, 1); /* pop jobs table */
+    return 0;
+}
+
+static int lua_app_every(lua_State *L) { return lua_app_job(L, "every"); }
+static int lua_app_at(lua_State *L)    { return lua_app_job(L, "at"); }
+
 /* app.config(tbl) — application configuration */
 static int lua_app_config(lua_State *L)
 {
@@ -249,6 +425,8 @@ static const luaL_Reg app_funcs[] = {
     {"options",      lua_app_options},
     {"use",          lua_app_use},
     {"use_post",     lua_app_use_post},
+    {"every",        lua_app_every},
+    {"at",           lua_app_at},
     {"config",       lua_app_config},
     {"manifest",     lua_app_manifest},
     {"get_manifest", lua_app_get_manifest},
@@ -265,6 +443,7 @@ static int luaopen_hull_app(lua_State *L)
  * hull.db module
  *
  * db.query(sql, params?) → array of row tables
+ * db.each(sql, params?, fn) → rows visited; fn(row) per row, false stops
  * db.exec(sql, params?)  → number of rows affected
  * db.last_id()           → last insert rowid
  * ════════════════════════════════════════════════════════════════════ */
@@ -276,43 +455,80 @@ typedef struct {
     int        row_count;
 } LuaQueryCtx;
 
-static int lua_query_row_cb(void *opaque, HlColumn *cols, int ncols)
+/* Push one row as a table keyed by column name */
+static int lua_push_row(lua_State *L, HlColumn *cols, int ncols)
 {
-    LuaQueryCtx *qc = (LuaQueryCtx *)opaque;
-    qc->row_count++;
-
-    lua_newtable(qc->L);
-    if (!lua_checkstack(qc->L, ncols + 2))
+    lua_newtable(L);
+    if (!lua_checkstack(L, ncols + 2))
         return -1;
     for (int i = 0; i < ncols; i++) {
         switch (cols[i].value.type) {
         case HL_TYPE_INT:
-            lua_pushinteger(qc->L, (lua_Integer)cols[i].value.i);
+            lua_pushinteger(L, (lua_Integer)cols[i].value.i);
             break;
         case HL_TYPE_DOUBLE:
-            lua_pushnumber(qc->L, (lua_Number)cols[i].value.d);
+            lua_pushnumber(L, (lua_Number)cols[i].value.d);
             break;
         case HL_TYPE_TEXT:
-            lua_pushlstring(qc->L, cols[i].value.s, cols[i].value.len);
+            lua_pushlstring(L, cols[i].value.s, cols[i].value.len);
             break;
         case HL_TYPE_BLOB:
-            lua_pushlstring(qc->L, cols[i].value.s, cols[i].value.len);
+            lua_pushlstring(L, cols[i].value.s, cols[i].value.len);
             break;
         case HL_TYPE_BOOL:
-            lua_pushboolean(qc->L, cols[i].value.b);
+            lua_pushboolean(L, cols[i].value.b);
             break;
         case HL_TYPE_NIL:
         default:
-            lua_pushnil(qc->L);
+            lua_pushnil(L);
             break;
         }
-        lua_setfield(qc->L, -2, cols[i].name);
+        lua_setfield(L, -2, cols[i].name);
     }
+    return 0;
+}
+
+static int lua_query_row_cb(void *opaque, HlColumn *cols, int ncols)
+{
+    LuaQueryCtx *qc = (LuaQueryCtx *)opaque;
+    qc->row_count++;
 
+    if (lua_push_row(qc->L, cols, ncols) != 0)
+        return -1;
     lua_rawseti(qc->L, qc->table_idx, qc->row_count);
     return 0;
 }
 
+/* Callback context for db.each: rows go to a Lua function one at a time */
+typedef struct {
+    lua_State *L;
+    int        fn_idx;    /* absolute stack index of the row function */
+    int        row_count;
+    int        failed;    /* fn raised: its error is on top of the stack */
+} LuaEachCtx;
+
+static int lua_each_row_cb(void *opaque, HlColumn *cols, int ncols)
+{
+    LuaEachCtx *ec = (LuaEachCtx *)opaque;
+    lua_State *L = ec->L;
+
+    lua_pushvalue(L, ec->fn_idx);
+    if (lua_push_row(L, cols, ncols) != 0) {
+        lua_pop(L, 2);
+        lua_pushstring(L, "too many columns");
+        ec->failed = 1;
+        return -1;
+    }
+    if (lua_pcall(L, 1, 1, 0) != LUA_OK) {
+        ec->failed = 1;
+        return -1;
+    }
+    ec->row_count++;
+    int stop = lua_isboolean(L, -1) && !lua_toboolean(L, -1);
+    lua_pop(L, 1);
+    return stop;
+}
+
 /* Marshal Lua table values to HlValue array for parameter binding */
 static int lua_to_hl_values(lua_State *L, int idx,
                                HlValue **out_params, int *out_count)
@@ -457,6 +673,42 @@ static int lua_db_query_impl(lua_State *L)
     return 1; /* result table already on stack */
 }
 
+/* db.each(sql, params?, fn) — rows are never collected into a table */
+static int lua_db_each(lua_State *L)
+{
+    HlLua *lua = get_hl_lua(L);
+    if (!lua || !lua->base.stmt_cache)
+        return luaL_error(L, "database not available");
+
+    const char *sql = luaL_checkstring(L, 1);
+    int fn_idx = lua_isfunction(L, 2) ? 2 : 3;
+    luaL_checktype(L, fn_idx, LUA_TFUNCTION);
+
+    if (!lua_is_stdlib_caller(L) && hl_cap_db_check_namespace(sql) != 0)
+        return luaL_error(L, "access denied: _hull_* tables are reserved");
+
+    HlValue *params = NULL;
+    int nparams = 0;
+    if (fn_idx == 3 && !lua_isnil(L, 2)) {
+        if (lua_to_hl_values(L, 2, &params, &nparams) != 0)
+            return luaL_error(L, "params must be a table");
+    }
+
+    LuaEachCtx ec = { .L = L, .fn_idx = fn_idx, .row_count = 0, .failed = 0 };
+    int rc = hl_cap_db_each(lua->base.stmt_cache, sql, params, nparams,
+                            lua_each_row_cb, &ec, lua->base.alloc);
+    if (ec.failed)
+        return lua_error(L); /* re-raise fn's error */
+
+    lua_free_hl_values(L, params, nparams);
+
+    if (rc != 0)
+        return luaL_error(L, "query failed: %s", sqlite3_errmsg(lua->base.db));
+
+    lua_pushinteger(L, ec.row_count);
+    return 1;
+}
+
 /* db.exec implementation */
 static int lua_db_exec_impl(lua_State *L)
 {
@@ -531,6 +783,7 @@ static int lua_db_batch(lua_State *L)
 
 static const luaL_Reg db_funcs[] = {
     {"query",   lua_db_query},
+    {"each",    lua_db_each},
     {"exec",    lua_db_exec},
     {"last_id", lua_db_last_id},
     {"batch",   lua_db_batch},
@@ -641,6 +894,7 @@ static int luaopen_hull_env(lua_State *L)
  * hull.crypto module
  *
  * crypto.sha256(data)                → hex string
+ * crypto.sha256_many({data, ...})    → {hex, ...}
  * crypto.random(n)                   → string of n random bytes
  * crypto.hash_password(password)     → hash string
  * crypto.verify_password(pw, hash)   → boolean
@@ -668,6 +922,44 @@ static int lua_crypto_sha256(lua_State *L)
     return 1;
 }
 
+/* crypto.sha256_many({data, ...}) → {hex, ...} — hashed as one batch */
+static int lua_crypto_sha256_many(lua_State *L)
+{
+    luaL_checktype(L, 1, LUA_TTABLE);
+    lua_Integer n = luaL_len(L, 1);
+
+    if (n < 0 || (size_t)n > SIZE_MAX / sizeof(HlSha256Item))
+        return luaL_error(L, "sha256_many: too many items");
+
+    /* Userdata, not the scratch arena: build batches can be large */
+    HlSha256Item *items = lua_newuserdatauv(L, (size_t)n * sizeof(*items), 0);
+
+    /* Strings stay referenced by the argument table during hashing */
+    for (lua_Integer i = 0; i < n; i++) {
+        if (lua_rawgeti(L, 1, i + 1) != LUA_TSTRING)
+            return luaL_error(L, "sha256_many: item %d is not a string",
+                              (int)(i + 1));
+        size_t len;
+        const char *data = lua_tolstring(L, -1, &len);
+        items[i].data = data;
+        items[i].len = len;
+        lua_pop(L, 1);
+    }
+
+    if (hl_cap_crypto_sha256_many(items, (size_t)n) != 0)
+        return luaL_error(L, "sha256 failed");
+
+    lua_createtable(L, (int)n, 0);
+    for (lua_Integer i = 0; i < n; i++) {
+        char hex[65];
+        for (int j = 0; j < 32; j++)
+            snprintf(hex + j * 2, 3, "%02x", items[i].hash[j]);
+        lua_pushlstring(L, hex, 64);
+        lua_rawseti(L, -2, i + 1);
+    }
+    return 1;
+}
+
 static int lua_crypto_random(lua_State *L)
 {
     lua_Integer n = luaL_checkinteger(L, 1);
@@ -695,46 +987,14 @@ static int lua_crypto_hash_password(lua_State *L)
     size_t pw_len;
     const char *pw = luaL_checklstring(L, 1, &pw_len);
 
-    /* Generate 16-byte salt */
-    uint8_t salt[16];
-    if (hl_cap_crypto_random(salt, sizeof(salt)) != 0)
-        return luaL_error(L, "random failed");
-
-    /* PBKDF2-HMAC-SHA256, 32-byte output */
-    uint8_t hash[32];
-    int iterations = HL_PBKDF2_ITERATIONS;
-    if (hl_cap_crypto_pbkdf2(pw, pw_len, salt, sizeof(salt),
-                                iterations, hash, sizeof(hash)) != 0)
+    char result[HL_PASSWORD_HASH_MAX];
+    if (hl_cap_crypto_password_hash(pw, pw_len, result, sizeof(result)) != 0)
         return luaL_error(L, "pbkdf2 failed");
 
-    /* Format: "pbkdf2:100000:salt_hex:hash_hex" */
-    char salt_hex[33], hash_hex[65];
-    for (int i = 0; i < 16; i++)
-        snprintf(salt_hex + i * 2, 3, "%02x", salt[i]);
-    for (int i = 0; i < 32; i++)
-        snprintf(hash_hex + i * 2, 3, "%02x", hash[i]);
-
-    char result[128];
-    snprintf(result, sizeof(result), "pbkdf2:%d:%s:%s",
-             iterations, salt_hex, hash_hex);
-
-    secure_zero(hash, sizeof(hash));
-    secure_zero(salt, sizeof(salt));
-
     lua_pushstring(L, result);
     return 1;
 }
 
-/* ── Hex nibble helper (no sscanf — Cosmopolitan compat) ──────────── */
-
-static int hex_nibble(unsigned char c)
-{
-    if (c >= '0' && c <= '9') return c - '0';
-    if (c >= 'a' && c <= 'f') return 10 + (c - 'a');
-    if (c >= 'A' && c <= 'F') return 10 + (c - 'A');
-    return -1;
-}
-
 /* crypto.verify_password(password, hash_string) → boolean */
 static int lua_crypto_verify_password(lua_State *L)
 {
@@ -742,79 +1002,18 @@ static int lua_crypto_verify_password(lua_State *L)
     const char *pw = luaL_checklstring(L, 1, &pw_len);
     const char *stored = luaL_checkstring(L, 2);
 
-    /* Parse "pbkdf2:iterations:salt_hex:hash_hex" manually (no scansets
-     * — Cosmopolitan libc doesn't support sscanf %[...] scansets). */
-    if (strncmp(stored, "pbkdf2:", 7) != 0) {
-        lua_pushboolean(L, 0);
-        return 1;
-    }
-    const char *p = stored + 7;
-
-    /* Parse iterations */
-    char *end = NULL;
-    long iterations = strtol(p, &end, 10);
-    if (!end || *end != ':' || iterations < 100000) {
-        lua_pushboolean(L, 0);
-        return 1;
-    }
-    p = end + 1;
-
-    /* Read 32-char salt hex */
-    if (strlen(p) < 32 + 1 + 64 || p[32] != ':') {
-        lua_pushboolean(L, 0);
-        return 1;
-    }
-    char salt_hex[33];
-    memcpy(salt_hex, p, 32);
-    salt_hex[32] = '\0';
-    p += 33;
-
-    /* Read 64-char hash hex */
-    if (strlen(p) < 64) {
-        lua_pushboolean(L, 0);
-        return 1;
-    }
-    char hash_hex[65];
-    memcpy(hash_hex, p, 64);
-    hash_hex[64] = '\0';
-
-    /* Decode hex salt (manual — sscanf %x broken on Cosmopolitan) */
-    uint8_t salt[16];
-    for (int i = 0; i < 16; i++) {
-        int hi = hex_nibble((unsigned char)salt_hex[i * 2]);
-        int lo = hex_nibble((unsigned char)salt_hex[i * 2 + 1]);
-        if (hi < 0 || lo < 0) { lua_pushboolean(L, 0); return 1; }
-        salt[i] = (uint8_t)((hi << 4) | lo);
-    }
-
-    /* Recompute hash */
-    uint8_t computed[32];
-    if (hl_cap_crypto_pbkdf2(pw, pw_len, salt, sizeof(salt),
-                                (int)iterations, computed, sizeof(computed)) != 0) {
-        lua_pushboolean(L, 0);
-        return 1;
-    }
-
-    /* Decode stored hash and compare (constant-time) */
-    uint8_t stored_hash[32];
-    for (int i = 0; i < 32; i++) {
-        int hi = hex_nibble((unsigned char)hash_hex[i * 2]);
-        int lo = hex_nibble((unsigned char)hash_hex[i * 2 + 1]);
-        if (hi < 0 || lo < 0) { lua_pushboolean(L, 0); return 1; }
-        stored_hash[i] = (uint8_t)((hi << 4) | lo);
-    }
-
-    /* Constant-time comparison */
-    volatile uint8_t diff = 0;
-    for (int i = 0; i < 32; i++)
-        diff |= computed[i] ^ stored_hash[i];
+    lua_pushboolean(L, hl_cap_crypto_password_verify(pw, pw_len, stored));
+    return 1;
+}
 
-    secure_zero(computed, sizeof(computed));
-    secure_zero(stored_hash, sizeof(stored_hash));
-    secure_zero(salt, sizeof(salt));
+/* ── Hex nibble helper (no sscanf — Cosmopolitan compat) ──────────── */
 
-    lua_pushboolean(L, diff == 0);
-    return 1;
+static int hex_nibble(unsigned char c)
+{
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return 10 + (c - 'a');
+    if (c >= 'A' && c <= 'F') return 10 + (c - 'A');
+    return -1;
 }
 
 /* ── Hex decode helper (no sscanf — Cosmopolitan compat) ──────────── */
@@ -1356,6 +1555,7 @@ static int lua_crypto_base64url_decode(lua_State *L)
 
 static const luaL_Reg crypto_funcs[] = {
     {"sha256",            lua_crypto_sha256},
+    {"sha256_many",       lua_crypto_sha256_many},
     {"sha512",            lua_crypto_sha512},
     {"random",            lua_crypto_random},
     {"hash_password",     lua_crypto_hash_password},
@@ -1655,6 +1855,8 @@ static int luaopen_hull_http(lua_State *L)
  * hull.smtp module
  *
  * smtp.send(opts) → { ok = true } or { ok = false, error = "..." }
+ * smtp.send_many(conn, messages) → array of the same, one per message;
+ *   conn holds host/port/username/password/tls, each message the rest
  * ════════════════════════════════════════════════════════════════════ */
 
 /* Helper: extract string array from Lua table at stack index */
@@ -1701,117 +1903,190 @@ static int lua_get_string_array(lua_State *L, int idx,
     return 0;
 }
 
-/* smtp.send(opts) */
-static int lua_smtp_send(lua_State *L)
+/* Connection fields (host, port, username, password, tls) of the table
+ * at idx into msg */
+static void lua_smtp_read_conn(lua_State *L, int idx, HlSmtpMessage *msg)
 {
-    HlLua *lua = get_hl_lua(L);
-    if (!lua || !lua->base.smtp_cfg)
-        return luaL_error(L, "smtp not configured (no hosts in manifest)");
-
-    luaL_checktype(L, 1, LUA_TTABLE);
-
-    /* Extract required fields */
-    lua_getfield(L, 1, "host");
-    const char *host = lua_isstring(L, -1) ? lua_tostring(L, -1) : NULL;
+    lua_getfield(L, idx, "host");
+    msg->host = lua_isstring(L, -1) ? lua_tostring(L, -1) : NULL;
     lua_pop(L, 1);
 
-    lua_getfield(L, 1, "port");
-    int port = lua_isinteger(L, -1) ? (int)lua_tointeger(L, -1) : 587;
+    lua_getfield(L, idx, "port");
+    msg->port = lua_isinteger(L, -1) ? (int)lua_tointeger(L, -1) : 587;
     lua_pop(L, 1);
 
-    lua_getfield(L, 1, "username");
-    const char *username = lua_isstring(L, -1) ? lua_tostring(L, -1) : NULL;
+    lua_getfield(L, idx, "username");
+    msg->username = lua_isstring(L, -1) ? lua_tostring(L, -1) : NULL;
     lua_pop(L, 1);
 
-    lua_getfield(L, 1, "password");
-    const char *password = lua_isstring(L, -1) ? lua_tostring(L, -1) : NULL;
+    lua_getfield(L, idx, "password");
+    msg->password = lua_isstring(L, -1) ? lua_tostring(L, -1) : NULL;
     lua_pop(L, 1);
 
-    lua_getfield(L, 1, "tls");
-    int use_tls = 0;
+    lua_getfield(L, idx, "tls");
+    msg->use_tls = 0;
     if (lua_isboolean(L, -1))
-        use_tls = lua_toboolean(L, -1) ? 1 : 0;
+        msg->use_tls = lua_toboolean(L, -1) ? 1 : 0;
     else if (lua_isinteger(L, -1))
-        use_tls = (int)lua_tointeger(L, -1);
+        msg->use_tls = (int)lua_tointeger(L, -1);
     lua_pop(L, 1);
+}
 
-    lua_getfield(L, 1, "from");
-    const char *from = lua_isstring(L, -1) ? lua_tostring(L, -1) : NULL;
+/* Message fields of the table at idx into msg. Returns NULL, or the
+ * error for the first missing required field. */
+static const char *lua_smtp_read_envelope(lua_State *L, int idx,
+                                          HlSmtpMessage *msg)
+{
+    lua_getfield(L, idx, "from");
+    msg->from = lua_isstring(L, -1) ? lua_tostring(L, -1) : NULL;
     lua_pop(L, 1);
 
-    lua_getfield(L, 1, "to");
-    const char *to = lua_isstring(L, -1) ? lua_tostring(L, -1) : NULL;
+    lua_getfield(L, idx, "to");
+    msg->to = lua_isstring(L, -1) ? lua_tostring(L, -1) : NULL;
     lua_pop(L, 1);
 
-    lua_getfield(L, 1, "subject");
-    const char *subject = lua_isstring(L, -1) ? lua_tostring(L, -1) : NULL;
+    lua_getfield(L, idx, "subject");
+    msg->subject = lua_isstring(L, -1) ? lua_tostring(L, -1) : NULL;
     lua_pop(L, 1);
 
-    lua_getfield(L, 1, "body");
-    const char *body = lua_isstring(L, -1) ? lua_tostring(L, -1) : NULL;
+    lua_getfield(L, idx, "body");
+    msg->body = lua_isstring(L, -1) ? lua_tostring(L, -1) : NULL;
     lua_pop(L, 1);
 
-    lua_getfield(L, 1, "content_type");
-    const char *content_type = lua_isstring(L, -1) ? lua_tostring(L, -1) : NULL;
+    lua_getfield(L, idx, "content_type");
+    msg->content_type = lua_isstring(L, -1) ? lua_tostring(L, -1) : NULL;
     lua_pop(L, 1);
 
-    lua_getfield(L, 1, "reply_to");
-    const char *reply_to = lua_isstring(L, -1) ? lua_tostring(L, -1) : NULL;
+    lua_getfield(L, idx, "reply_to");
+    msg->reply_to = lua_isstring(L, -1) ? lua_tostring(L, -1) : NULL;
     lua_pop(L, 1);
 
     /* CC array (optional) */
-    const char **cc = NULL;
-    int cc_count = 0;
-    lua_getfield(L, 1, "cc");
+    msg->cc = NULL;
+    msg->cc_count = 0;
+    lua_getfield(L, idx, "cc");
     if (lua_istable(L, -1)) {
         int cc_idx = lua_gettop(L);
-        lua_get_string_array(L, cc_idx, &cc, &cc_count);
+        lua_get_string_array(L, cc_idx, &msg->cc, &msg->cc_count);
     }
     lua_pop(L, 1);
 
+    if (!msg->from)    return "from required";
+    if (!msg->to)      return "to required";
+    if (!msg->subject) return "subject required";
+    if (!msg->body)    return "body required";
+    return NULL;
+}
+
+/* Push { ok = true } or { ok = false, error = err } */
+static void lua_smtp_push_result(lua_State *L, const char *err)
+{
+    lua_newtable(L);
+    lua_pushboolean(L, err == NULL);
+    lua_setfield(L, -2, "ok");
+    if (err) {
+        lua_pushstring(L, err);
+        lua_setfield(L, -2, "error");
+    }
+}
+
+/* smtp.send(opts) */
+static int lua_smtp_send(lua_State *L)
+{
+    HlLua *lua = get_hl_lua(L);
+    if (!lua || !lua->base.smtp_cfg)
+        return luaL_error(L, "smtp not configured (no hosts in manifest)");
+
+    luaL_checktype(L, 1, LUA_TTABLE);
+
+    HlSmtpMessage msg = {0};
+    lua_smtp_read_conn(L, 1, &msg);
+    const char *err = lua_smtp_read_envelope(L, 1, &msg);
+
     /* Validate required fields */
-    if (!host)    { lua_newtable(L); lua_pushboolean(L, 0); lua_setfield(L, -2, "ok"); lua_pushstring(L, "host required"); lua_setfield(L, -2, "error"); return 1; }
-    if (!from)    { lua_newtable(L); lua_pushboolean(L, 0); lua_setfield(L, -2, "ok"); lua_pushstring(L, "from required"); lua_setfield(L, -2, "error"); return 1; }
-    if (!to)      { lua_newtable(L); lua_pushboolean(L, 0); lua_setfield(L, -2, "ok"); lua_pushstring(L, "to required"); lua_setfield(L, -2, "error"); return 1; }
-    if (!subject) { lua_newtable(L); lua_pushboolean(L, 0); lua_setfield(L, -2, "ok"); lua_pushstring(L, "subject required"); lua_setfield(L, -2, "error"); return 1; }
-    if (!body)    { lua_newtable(L); lua_pushboolean(L, 0); lua_setfield(L, -2, "ok"); lua_pushstring(L, "body required"); lua_setfield(L, -2, "error"); return 1; }
-
-    /* Build message struct */
-    HlSmtpMessage msg = {
-        .host = host,
-        .port = port,
-        .username = username,
-        .password = password,
-        .use_tls = use_tls,
-        .from = from,
-        .to = to,
-        .cc = cc,
-        .cc_count = cc_count,
-        .reply_to = reply_to,
-        .subject = subject,
-        .body = body,
-        .content_type = content_type,
-    };
+    if (!msg.host)
+        err = "host required";
+    if (err) {
+        lua_smtp_push_result(L, err);
+        return 1;
+    }
 
     int rc = hl_cap_smtp_send(lua->base.smtp_cfg, &msg);
+    lua_smtp_push_result(L, rc == 0 ? NULL : "smtp send failed");
+    return 1;
+}
 
-    /* Return { ok = true/false, error = "..." } */
-    lua_newtable(L);
-    if (rc == 0) {
-        lua_pushboolean(L, 1);
-        lua_setfield(L, -2, "ok");
-    } else {
-        lua_pushboolean(L, 0);
-        lua_setfield(L, -2, "ok");
-        lua_pushstring(L, "smtp send failed");
-        lua_setfield(L, -2, "error");
+/* smtp.send_many(conn, messages) — one session for the whole batch */
+static int lua_smtp_send_many(lua_State *L)
+{
+    HlLua *lua = get_hl_lua(L);
+    if (!lua || !lua->base.smtp_cfg)
+        return luaL_error(L, "smtp not configured (no hosts in manifest)");
+
+    luaL_checktype(L, 1, LUA_TTABLE);
+    luaL_checktype(L, 2, LUA_TTABLE);
+
+    int n = (int)luaL_len(L, 2);
+    if (n > HL_SMTP_MAX_BATCH)
+        return luaL_error(L, "smtp.send_many: at most %d messages",
+                          HL_SMTP_MAX_BATCH);
+    if (n <= 0) {
+        lua_newtable(L);
+        return 1;
     }
+    if (!lua->scratch)
+        return luaL_error(L, "smtp.send_many: no scratch arena");
+
+    HlSmtpMessage conn = {0};
+    lua_smtp_read_conn(L, 1, &conn);
+
+    HlSmtpMessage *msgs = sh_arena_calloc(lua->scratch, (size_t)n,
+                                          sizeof(*msgs));
+    const char **errs = sh_arena_calloc(lua->scratch, (size_t)n,
+                                        sizeof(*errs));
+    int *slot = sh_arena_calloc(lua->scratch, (size_t)n, sizeof(*slot));
+    int *results = sh_arena_calloc(lua->scratch, (size_t)n,
+                                   sizeof(*results));
+    if (!msgs || !errs || !slot || !results)
+        return luaL_error(L, "smtp.send_many: out of memory");
+
+    /* Messages missing a field get their error here; the rest are sent
+     * together. The message tables stay referenced by argument 2, so
+     * their strings outlive the send. */
+    int count = 0;
+    for (int i = 0; i < n; i++) {
+        lua_rawgeti(L, 2, i + 1);
+        slot[i] = -1;
+        if (!lua_istable(L, -1)) {
+            errs[i] = "message must be a table";
+        } else if (!conn.host) {
+            errs[i] = "host required";
+        } else {
+            HlSmtpMessage *m = &msgs[count];
+            *m = conn;
+            errs[i] = lua_smtp_read_envelope(L, lua_gettop(L), m);
+            if (!errs[i])
+                slot[i] = count++;
+        }
+        lua_pop(L, 1);
+    }
+
+    hl_cap_smtp_send_many(lua->base.smtp_cfg, msgs, count, results);
 
+    lua_createtable(L, n, 0);
+    for (int i = 0; i < n; i++) {
+        const char *err = errs[i];
+        if (!err && results[slot[i]] != 0)
+            err = "smtp send failed";
+        lua_smtp_push_result(L, err);
+        lua_rawseti(L, -2, i + 1);
+    }
     return 1;
 }
 
 static const luaL_Reg smtp_funcs[] = {
-    {"send", lua_smtp_send},
+    {"send",      lua_smtp_send},
+    {"send_many", lua_smtp_send_many},
     {NULL, NULL}
 };
 
@@ -1821,6 +2096,41 @@ static int luaopen_hull_smtp(lua_State *L)
     return 1;
 }
 
+/* ════════════════════════════════════════════════════════════════════
+ * hull._outbox module (internal — called only by hull.middleware.outbox)
+ *
+ * _outbox.native() → true when the native dispatcher delivers "webhook"
+ *                    and "http" rows (hull --outbox-workers N)
+ * _outbox.wake()   → have it look for due rows now
+ * ════════════════════════════════════════════════════════════════════ */
+
+static int lua_outbox_native(lua_State *L)
+{
+    HlLua *lua = get_hl_lua(L);
+    lua_pushboolean(L, lua && lua->base.outbox);
+    return 1;
+}
+
+static int lua_outbox_wake(lua_State *L)
+{
+    HlLua *lua = get_hl_lua(L);
+    if (lua)
+        hl_outbox_wake(lua->base.outbox);
+    return 0;
+}
+
+static const luaL_Reg outbox_funcs[] = {
+    {"native", lua_outbox_native},
+    {"wake",   lua_outbox_wake},
+    {NULL, NULL}
+};
+
+static int luaopen_hull_outbox_bridge(lua_State *L)
+{
+    luaL_newlib(L, outbox_funcs);
+    return 1;
+}
+
 /* ════════════════════════════════════════════════════════════════════
  * hull.log module
  *
@@ -1878,25 +2188,275 @@ static int luaopen_hull_log(lua_State *L)
 /* ════════════════════════════════════════════════════════════════════
  * hull._template module (internal — called only by stdlib hull.template)
  *
- * _template._compile(code)    → compiled Lua function
- * _template._load_raw(name)   → raw template string or nil
+ * _template._program(bc, filters)         → render function(data)
+ * _template._load_raw(name)               → raw template string or nil
+ * _template._load_compiled(name, filters) → precompiled render fn or nil
+ *
+ * Programs are executed by the native renderer (cap/template.c). The
+ * register file lives on the Lua stack; `filters` supplies the filters
+ * that call back into Lua (json).
  * ════════════════════════════════════════════════════════════════════ */
 
-/* _template._compile(code) — compile generated Lua source to a function */
-static int lua_template_compile(lua_State *L)
+#define HL_TEMPLATE_BUF_MT "hull.template.buf"
+
+typedef struct {
+    lua_State *L;
+    int        base;    /* stack index of register 0 */
+} LuaTpl;
+
+#define TPL_REG(t, r) ((t)->base + (r))
+
+static int lua_tpl_get(void *ud, int dst, int obj, const char *key, size_t len)
+{
+    LuaTpl *t = ud;
+    lua_State *L = t->L;
+    /* Nil-safe dot path: anything but a table yields nil */
+    if (lua_type(L, TPL_REG(t, obj)) == LUA_TTABLE) {
+        lua_pushlstring(L, key, len);
+        lua_gettable(L, TPL_REG(t, obj));
+    } else {
+        lua_pushnil(L);
+    }
+    lua_replace(L, TPL_REG(t, dst));
+    return 0;
+}
+
+static int lua_tpl_set_str(void *ud, int dst, const char *s, size_t len)
+{
+    LuaTpl *t = ud;
+    lua_pushlstring(t->L, s, len);
+    lua_replace(t->L, TPL_REG(t, dst));
+    return 0;
+}
+
+static int lua_tpl_set_nil(void *ud, int dst)
+{
+    LuaTpl *t = ud;
+    lua_pushnil(t->L);
+    lua_replace(t->L, TPL_REG(t, dst));
+    return 0;
+}
+
+static int lua_tpl_truthy(void *ud, int src)
+{
+    LuaTpl *t = ud;
+    return lua_toboolean(t->L, TPL_REG(t, src));
+}
+
+/* ipairs() order for arrays (state = last index), pairs() for key/value
+ * loops (state = last key). Non-tables iterate zero times. */
+static int lua_tpl_next(void *ud, int coll, int state, int key, int val,
+                        int kv)
+{
+    LuaTpl *t = ud;
+    lua_State *L = t->L;
+    int c = TPL_REG(t, coll);
+    int st = TPL_REG(t, state);
+
+    if (lua_type(L, c) != LUA_TTABLE)
+        return 0;
+
+    if (!kv) {
+        lua_Integer i = lua_isnil(L, st) ? 1 : lua_tointeger(L, st) + 1;
+        if (lua_geti(L, c, i) == LUA_TNIL) {
+            lua_pop(L, 1);
+            return 0;
+        }
+        lua_replace(L, TPL_REG(t, val));
+        lua_pushinteger(L, i);
+        lua_replace(L, st);
+        return 1;
+    }
+
+    lua_pushvalue(L, st);
+    if (!lua_next(L, c))
+        return 0;
+    lua_replace(L, TPL_REG(t, val));
+    if (key >= 0) {
+        lua_pushvalue(L, -1);
+        lua_replace(L, TPL_REG(t, key));
+    }
+    lua_replace(L, st);
+    return 1;
+}
+
+/* tostring(val or "") — pushes the string */
+static const char *lua_tpl_tostring(lua_State *L, int idx, size_t *len)
+{
+    if (!lua_toboolean(L, idx)) {
+        lua_pushliteral(L, "");
+        *len = 0;
+        return "";
+    }
+    return luaL_tolstring(L, idx, len);
+}
+
+static int lua_tpl_filter(void *ud, int id, int dst, int src, int arg)
+{
+    LuaTpl *t = ud;
+    lua_State *L = t->L;
+    int s = TPL_REG(t, src);
+    size_t n;
+    const char *str;
+
+    switch (id) {
+    case HL_TPL_F_UPPER:
+    case HL_TPL_F_LOWER: {
+        str = lua_tpl_tostring(L, s, &n);
+        luaL_Buffer b;
+        char *p = luaL_buffinitsize(L, &b, n);
+        for (size_t i = 0; i < n; i++)
+            p[i] = (char)(id == HL_TPL_F_UPPER
+                          ? toupper((unsigned char)str[i])
+                          : tolower((unsigned char)str[i]));
+        luaL_pushresultsize(&b, n);
+        lua_remove(L, -2);
+        break;
+    }
+    case HL_TPL_F_TRIM: {
+        str = lua_tpl_tostring(L, s, &n);
+        size_t i = 0;
+        while (i < n && isspace((unsigned char)str[i]))
+            i++;
+        while (n > i && isspace((unsigned char)str[n - 1]))
+            n--;
+        lua_pushlstring(L, str + i, n - i);
+        lua_remove(L, -2);
+        break;
+    }
+    case HL_TPL_F_LENGTH:
+        if (lua_type(L, s) == LUA_TTABLE) {
+            lua_len(L, s);
+        } else {
+            lua_tpl_tostring(L, s, &n);
+            lua_pop(L, 1);
+            lua_pushinteger(L, (lua_Integer)n);
+        }
+        break;
+    case HL_TPL_F_DEFAULT:
+        if (!lua_toboolean(L, s) ||
+            (lua_type(L, s) == LUA_TSTRING && lua_rawlen(L, s) == 0)) {
+            if (arg >= 0 && lua_toboolean(L, TPL_REG(t, arg)))
+                lua_pushvalue(L, TPL_REG(t, arg));
+            else
+                lua_pushliteral(L, "");
+        } else {
+            lua_pushvalue(L, s);
+        }
+        break;
+    default: {
+        /* Implemented in Lua: filters[name](val[, arg]) */
+        const char *name = hl_tpl_filter_name(id);
+        if (!name || lua_getfield(L, lua_upvalueindex(2), name) != LUA_TFUNCTION)
+            return luaL_error(L, "unknown template filter: %s",
+                              name ? name : "?");
+        lua_pushvalue(L, s);
+        if (arg >= 0)
+            lua_pushvalue(L, TPL_REG(t, arg));
+        lua_call(L, arg >= 0 ? 2 : 1, 1);
+        break;
+    }
+    }
+
+    lua_replace(L, TPL_REG(t, dst));
+    return 0;
+}
+
+static int lua_tpl_out(void *ud, int src, int escape, HlTplBuf *buf)
+{
+    LuaTpl *t = ud;
+    lua_State *L = t->L;
+    int idx = TPL_REG(t, src);
+    int type = lua_type(L, idx);
+    size_t n;
+
+    /* {{ nil }} and {{{ nil/false }}} render nothing */
+    if (type == LUA_TNIL || (!escape && !lua_toboolean(L, idx)))
+        return 0;
+
+    if (type == LUA_TSTRING) {
+        const char *s = lua_tolstring(L, idx, &n);
+        return escape ? hl_tpl_buf_escape(buf, s, n)
+                      : hl_tpl_buf_append(buf, s, n);
+    }
+
+    const char *s = luaL_tolstring(L, idx, &n);
+    int rc = escape ? hl_tpl_buf_escape(buf, s, n)
+                    : hl_tpl_buf_append(buf, s, n);
+    lua_pop(L, 1);
+    return rc;
+}
+
+static const HlTplOps lua_tpl_ops = {
+    .get     = lua_tpl_get,
+    .set_str = lua_tpl_set_str,
+    .set_nil = lua_tpl_set_nil,
+    .truthy  = lua_tpl_truthy,
+    .next    = lua_tpl_next,
+    .filter  = lua_tpl_filter,
+    .out     = lua_tpl_out,
+};
+
+static int lua_template_buf_gc(lua_State *L)
+{
+    HlTplBuf *buf = luaL_checkudata(L, 1, HL_TEMPLATE_BUF_MT);
+    hl_tpl_buf_free(buf);
+    return 0;
+}
+
+/* Render closure: upvalue 1 = validated program, upvalue 2 = filters */
+static int lua_template_render(lua_State *L)
 {
     size_t len;
-    const char *code = luaL_checklstring(L, 1, &len);
-    const char *name = luaL_optstring(L, 2, "=template");
+    const uint8_t *code = (const uint8_t *)lua_tolstring(
+        L, lua_upvalueindex(1), &len);
+    int nregs = code[5];
 
-    if (luaL_loadbuffer(L, code, len, name) != LUA_OK)
-        return lua_error(L); /* propagate compile error */
+    lua_settop(L, 1);
+    if (lua_isnil(L, 1)) {
+        lua_newtable(L);
+        lua_replace(L, 1);
+    }
+    luaL_checkstack(L, nregs + LUA_MINSTACK, "template too complex");
+    lua_settop(L, nregs);
 
-    /* loadbuffer pushes a function — call it to get the inner function */
-    if (lua_pcall(L, 0, 1, 0) != LUA_OK)
-        return lua_error(L);
+    /* Boxed so the buffer is released if a filter raises */
+    HlLua *lua = get_hl_lua(L);
+    HlTplBuf *buf = lua_newuserdatauv(L, sizeof(*buf), 0);
+    hl_tpl_buf_init(buf, lua ? lua->base.alloc : NULL);
+    luaL_setmetatable(L, HL_TEMPLATE_BUF_MT);
+
+    LuaTpl t = { .L = L, .base = 1 };
+    if (hl_tpl_render(code, &lua_tpl_ops, &t, buf) != 0)
+        return luaL_error(L, "template render: out of memory");
+
+    lua_pushlstring(L, buf->data ? buf->data : "", buf->len);
+    hl_tpl_buf_free(buf);
+    return 1;
+}
+
+/* Validate `bc` and push a render closure over it and `filters` */
+static int push_template_program(lua_State *L, const char *bc, size_t len,
+                                 int filters_idx)
+{
+    if (hl_tpl_check((const uint8_t *)bc, len) < 0)
+        return -1;
+    lua_pushlstring(L, bc, len);
+    lua_pushvalue(L, filters_idx);
+    lua_pushcclosure(L, lua_template_render, 2);
+    return 0;
+}
 
-    return 1; /* compiled function on stack */
+/* _template._program(bc, filters) — wrap an emitted program */
+static int lua_template_program(lua_State *L)
+{
+    size_t len;
+    const char *bc = luaL_checklstring(L, 1, &len);
+    luaL_checktype(L, 2, LUA_TTABLE);
+
+    if (push_template_program(L, bc, len, 2) != 0)
+        return luaL_error(L, "invalid template program");
+    return 1;
 }
 
 /* _template._load_raw(name) — load raw template bytes from embedded
@@ -1982,14 +2542,57 @@ static int lua_template_load_raw(lua_State *L)
     return 1;
 }
 
+/* _template._load_compiled(name, filters) — load a template program
+ * precompiled by hull build ("templates/<name>.tplc", inheritance
+ * already flattened). Returns the render function, or nil if there is
+ * no usable entry. */
+static int lua_template_load_compiled(lua_State *L)
+{
+    const char *name = luaL_checkstring(L, 1);
+    luaL_checktype(L, 2, LUA_TTABLE);
+    HlLua *lua = get_hl_lua(L);
+    if (!lua || !lua->base.app_vfs || name[0] == '\0') {
+        lua_pushnil(L);
+        return 1;
+    }
+
+    char tpl_name[HL_MODULE_PATH_MAX];
+    int n = snprintf(tpl_name, sizeof(tpl_name), "templates/%s", name);
+    if (n <= 0 || (size_t)n >= sizeof(tpl_name)) {
+        lua_pushnil(L);
+        return 1;
+    }
+
+    const HlEntry *bc = hl_vfs_find_suffixed(lua->base.app_vfs, tpl_name,
+                                             HL_TPL_BYTECODE_SUFFIX);
+    if (!bc) {
+        lua_pushnil(L);
+        return 1;
+    }
+
+    if (push_template_program(L, (const char *)bc->data, bc->len, 2) != 0) {
+        log_warn("[hull:c] ignoring precompiled template '%s': "
+                 "invalid program", name);
+        lua_pushnil(L);
+    }
+    return 1;
+}
+
 static const luaL_Reg template_funcs[] = {
-    {"_compile",  lua_template_compile},
-    {"_load_raw", lua_template_load_raw},
+    {"_program",       lua_template_program},
+    {"_load_raw",      lua_template_load_raw},
+    {"_load_compiled", lua_template_load_compiled},
     {NULL, NULL}
 };
 
 static int luaopen_hull_template_bridge(lua_State *L)
 {
+    if (luaL_newmetatable(L, HL_TEMPLATE_BUF_MT)) {
+        lua_pushcfunction(L, lua_template_buf_gc);
+        lua_setfield(L, -2, "__gc");
+    }
+    lua_pop(L, 1);
+
     luaL_newlib(L, template_funcs);
     return 1;
 }
@@ -2347,6 +2950,39 @@ static int hl_lua_require(lua_State *L)
     return luaL_error(L, "module not found: %s", name);
 }
 
+/*
+ * Compile an embedded module entry onto the stack.
+ *
+ * If the VFS carries a precompiled companion ("<name>.luac"), load it
+ * in binary-only mode and skip the parser entirely. Bytecode produced
+ * by a different Lua build (version, int/float size) is rejected by
+ * lundump — in that case fall back to the source so a mismatched
+ * build degrades to the old path instead of failing startup.
+ */
+static int load_embedded_chunk(lua_State *L, const HlVfs *vfs,
+                               const HlEntry *e)
+{
+    const HlEntry *bc = hl_vfs_find_suffixed(vfs, e->name,
+                                             HL_LUA_BYTECODE_SUFFIX);
+    if (bc) {
+        if (luaL_loadbufferx(L, (const char *)bc->data, bc->len,
+                             e->name, "b") == LUA_OK)
+            return LUA_OK;
+        log_warn("[hull:c] ignoring bytecode for '%s': %s",
+                 e->name, lua_tostring(L, -1));
+        lua_pop(L, 1);
+    }
+    return luaL_loadbufferx(L, (const char *)e->data, e->len, e->name, "t");
+}
+
+static int is_bytecode_entry(const char *name)
+{
+    size_t nlen = strlen(name);
+    size_t slen = sizeof(HL_LUA_BYTECODE_SUFFIX) - 1;
+    return nlen > slen &&
+           strcmp(name + nlen - slen, HL_LUA_BYTECODE_SUFFIX) == 0;
+}
+
 int hl_lua_register_stdlib(HlLua *lua)
 {
     if (!lua || !lua->L)
@@ -2360,14 +2996,16 @@ int hl_lua_register_stdlib(HlLua *lua)
 
     /* Create __hull_modules table and populate with compiled chunks.
      * Iterates the platform VFS entries, skipping JS modules
-     * (colon-separated names) — adding a new .lua file requires no C changes. */
+     * (colon-separated names) — adding a new .lua file requires no C changes.
+     * Precompiled "<name>.luac" companions are preferred when present. */
     lua_newtable(L);
 
     if (lua->base.platform_vfs) {
         for (size_t i = 0; i < lua->base.platform_vfs->count; i++) {
             const HlEntry *e = &lua->base.platform_vfs->entries[i];
             if (strchr(e->name, ':')) continue; /* skip JS modules */
-            if (luaL_loadbuffer(L, (const char *)e->data, e->len, e->name) != LUA_OK) {
+            if (is_bytecode_entry(e->name)) continue; /* loaded via source entry */
+            if (load_embedded_chunk(L, lua->base.platform_vfs, e) != LUA_OK) {
                 log_error("[hull:c] failed to load stdlib module '%s': %s",
                           e->name, lua_tostring(L, -1));
                 lua_pop(L, 2); /* pop error + modules table */
@@ -2382,16 +3020,21 @@ int hl_lua_register_stdlib(HlLua *lua)
         for (size_t i = 0; i < lua->base.app_vfs->count; i++) {
             const HlEntry *e = &lua->base.app_vfs->entries[i];
             size_t nlen = strlen(e->name);
-            /* Skip JS modules (.js) and non-module entries (templates/, static/, migrations/) */
+            /* Skip JS modules (.js, precompiled .jsc) and non-module entries
+             * (templates/, static/, migrations/) */
             if (nlen >= 3 && strcmp(e->name + nlen - 3, ".js") == 0)
                 continue;
+            if (nlen >= 4 && strcmp(e->name + nlen - 4, HL_JS_BYTECODE_SUFFIX) == 0)
+                continue;
             if (e->name[0] != '.')
                 continue;  /* module entries start with "./" */
+            if (is_bytecode_entry(e->name))
+                continue;  /* picked up by its source entry */
             if (nlen >= 5 && strcmp(e->name + nlen - 5, ".json") == 0) {
                 /* JSON data — store as raw string, decoded on first require() */
                 lua_pushlstring(L, (const char *)e->data, e->len);
             } else {
-                if (luaL_loadbuffer(L, (const char *)e->data, e->len, e->name) != LUA_OK) {
+                if (load_embedded_chunk(L, lua->base.app_vfs, e) != LUA_OK) {
                     log_error("[hull:c] failed to load app module '%s': %s",
                               e->name, lua_tostring(L, -1));
                     lua_pop(L, 2); /* pop error + modules table */
@@ -2473,6 +3116,10 @@ int hl_lua_register_modules(HlLua *lua)
     luaL_requiref(L, "hull.smtp", luaopen_hull_smtp, 0);
     lua_setglobal(L, "smtp");
 
+    /* Register hull._outbox — internal bridge for hull.middleware.outbox */
+    luaL_requiref(L, "hull._outbox", luaopen_hull_outbox_bridge, 0);
+    lua_setglobal(L, "_outbox");
+
     /* Register hull._template — internal bridge for hull.template stdlib */
     luaL_requiref(L, "hull._template", luaopen_hull_template_bridge, 0);
     lua_setglobal(L, "_template");
@@ -8,13 +8,17 @@
  */
 
 #include "hull/runtime/lua.h"
+#include "hull/access_log.h"
 #include "hull/alloc.h"
 #include "hull/manifest.h"
 #include "hull/cap/body.h"
 #include "hull/cap/fs.h"
+#include "hull/cap/metrics.h"
+#include "hull/cap/sched.h"
 #include "hull/cap/env.h"
 #include "hull/cap/tool.h"
 #include "hull/cap/db.h"
+#include "hull/cap/time.h"
 
 #include "lua.h"
 #include "lualib.h"
@@ -74,9 +78,10 @@ static void *hl_lua_alloc(void *ud, void *ptr, size_t osize, size_t nsize)
         new_ptr = hl_alloc_realloc(lua->base.alloc, ptr, osize, nsize);
 
     if (new_ptr) {
-        if (nsize > effective_osize)
+        if (nsize > effective_osize) {
             lua->mem_used += nsize - effective_osize;
-        else if (lua->mem_used >= effective_osize - nsize)
+            lua->alloc_since_gc += nsize - effective_osize;
+        } else if (lua->mem_used >= effective_osize - nsize)
             lua->mem_used -= effective_osize - nsize;
         else
             lua->mem_used = 0;
@@ -132,6 +137,8 @@ int hl_lua_init(HlLua *lua, const HlLuaConfig *cfg)
     lua->base = saved_base;
     lua->mem_limit = cfg->max_heap_bytes;
     lua->max_instructions = cfg->max_instructions;
+    lua->gc_mode = cfg->gc_mode;
+    lua->gc_budget_ns = (int64_t)cfg->gc_budget_us * 1000;
 
     /* Create Lua state with custom allocator */
     lua->L = lua_newstate(hl_lua_alloc, lua);
@@ -247,9 +254,56 @@ int hl_lua_load_app(HlLua *lua, const char *filename)
     /* Reset scratch arena — startup module loads no longer needed */
     sh_arena_reset(lua->scratch);
 
+    /* Switch to generational mode only now: the switch runs a full
+     * collection and ages every survivor, so the app's routes, modules
+     * and caches start out old and young collections skip them. */
+    if (lua->gc_mode == HL_GC_REQUEST) {
+        lua_gc(lua->L, LUA_GCGEN, HL_LUA_GC_MINOR_MUL, HL_LUA_GC_MAJOR_MUL);
+    } else {
+        lua_gc(lua->L, LUA_GCINC, HL_LUA_GC_BACKSTOP, 0, 0);
+        lua->gc_trigger = lua->mem_used / 100 * HL_LUA_GC_PAUSE;
+    }
+    lua->alloc_since_gc = 0;
+
     return 0;
 }
 
+void hl_lua_request_end(HlLua *lua)
+{
+    if (!lua || !lua->L)
+        return;
+
+    size_t before = lua->mem_used;
+    int64_t t0;
+
+    if (lua->gc_mode == HL_GC_REQUEST) {
+        /* Nothing allocated, no young generation to collect */
+        if (lua->alloc_since_gc == 0)
+            return;
+        lua->alloc_since_gc = 0;
+        t0 = hl_cap_time_clock_ns();
+        /* In generational mode a basic step is one young collection (or
+         * a major one once the old generation outgrew HL_LUA_GC_MAJOR_MUL) */
+        lua_gc(lua->L, LUA_GCSTEP, 0);
+    } else {
+        if (!lua->gc_cycle && lua->mem_used < lua->gc_trigger)
+            return;
+        lua->gc_cycle = 1;
+        t0 = hl_cap_time_clock_ns();
+        do {
+            if (lua_gc(lua->L, LUA_GCSTEP, 0)) {
+                lua->gc_cycle = 0;
+                lua->gc_trigger = lua->mem_used / 100 * HL_LUA_GC_PAUSE;
+                break;
+            }
+        } while (hl_cap_time_clock_ns() - t0 < lua->gc_budget_ns);
+    }
+
+    hl_gc_stats_record(&lua->base.gc_stats,
+                       (uint64_t)(hl_cap_time_clock_ns() - t0),
+                       (uint64_t)lua->gc_budget_ns, before, lua->mem_used);
+}
+
 int hl_lua_dispatch(HlLua *lua, int handler_id,
                        KlRequest *req, KlResponse *res)
 {
@@ -281,11 +335,14 @@ int hl_lua_dispatch(HlLua *lua, int handler_id,
     }
 
     /* Build request and response objects */
+    lua->upload = hl_cap_body_upload(req->body_reader);
     hl_lua_make_request(lua->L, req);
     hl_lua_make_response(lua->L, res);
 
     /* Call handler(req, res) */
-    if (lua_pcall(lua->L, 2, 0, 0) != LUA_OK) {
+    int rc = lua_pcall(lua->L, 2, 0, 0);
+    lua->upload = NULL; /* req.upload methods stop working here */
+    if (rc != LUA_OK) {
         log_error("[hull:c] lua handler error: %s",
                   lua_tostring(lua->L, -1));
         lua_pop(lua->L, 1); /* pop error message */
@@ -384,16 +441,144 @@ static int hl_lua_track_route(HlLua *lua, void *route)
     return 0;
 }
 
+/* ── Upload routes ─────────────────────────────────────────────────── */
+
+/*
+ * Stream route: call on_chunk(req, chunk) as each chunk arrives, with
+ * the same stale transaction guard and instruction budget as a request.
+ * req.ctx is kept as JSON in the upload between calls and reaches the
+ * handler's req.ctx.
+ */
+static int hl_lua_body_chunk(HlBodyUpload *up, const char *data, size_t len,
+                             void *ctx)
+{
+    HlLuaRoute *route = (HlLuaRoute *)ctx;
+    HlLua *lua = route->lua;
+    lua_State *L = lua->L;
+
+    hl_cap_db_guard_stale_txn(lua->base.db);
+    if (lua->max_instructions > 0)
+        lua_sethook(L, hl_lua_instruction_hook, LUA_MASKCOUNT,
+                    (int)lua->max_instructions);
+    sh_arena_reset(lua->scratch);
+
+    lua_getfield(L, LUA_REGISTRYINDEX, "__hull_routes");
+    if (!lua_istable(L, -1)) {
+        lua_pop(L, 1);
+        return -1;
+    }
+    lua_rawgeti(L, -1, route->chunk_id);
+    if (!lua_isfunction(L, -1)) {
+        lua_pop(L, 2); /* pop value + routes table */
+        return -1;
+    }
+
+    lua->upload = up;
+    hl_lua_make_request(L, (KlRequest *)up->req);
+    lua_pushvalue(L, -1);
+    lua_insert(L, -3); /* routes, req, fn, req */
+    lua_pushlstring(L, data, len);
+
+    int rc = 0;
+    if (lua_pcall(L, 2, 0, 0) != LUA_OK) {
+        log_error("[hull:c] lua on_chunk error: %s", lua_tostring(L, -1));
+        lua_pop(L, 1);
+        rc = -1;
+    } else {
+        lua_getfield(L, -1, "ctx");
+        if (lua_istable(L, -1)) {
+            lua_getglobal(L, "json");
+            lua_getfield(L, -1, "encode");
+            lua_pushvalue(L, -3);
+            if (lua_pcall(L, 1, 1, 0) == LUA_OK) {
+                size_t json_len;
+                const char *json_str = lua_tolstring(L, -1, &json_len);
+                if (!json_str || json_len >= 65536 ||
+                    hl_cap_body_set_state(up, json_str, json_len) != 0) {
+                    log_error("[hull:c] on_chunk: req.ctx too large to carry");
+                    rc = -1;
+                }
+            }
+            lua_pop(L, 2); /* json string or error, json table */
+        }
+        lua_pop(L, 1); /* ctx */
+    }
+    lua->upload = NULL;
+    lua_pop(L, 2); /* req, routes table */
+    return rc;
+}
+
+/* Body reader for a route: its declared mode, buffered by default */
+static KlBodyReader *hl_lua_body_factory(KlAllocator *alloc,
+                                         const KlRequest *req,
+                                         void *user_data)
+{
+    HlLuaRoute *route = (HlLuaRoute *)user_data;
+    return hl_cap_body_open(alloc, req, &route->body, route->lua->base.db,
+                            route->chunk_id > 0 ? hl_lua_body_chunk : NULL,
+                            route);
+}
+
+static int lua_route_string(lua_State *L, int def, const char *key,
+                            char *out, size_t size)
+{
+    lua_getfield(L, def, key);
+    const char *v = lua_tostring(L, -1);
+    int rc = 0;
+    if (v && strlen(v) < size)
+        memcpy(out, v, strlen(v) + 1);
+    else if (v)
+        rc = -1;
+    lua_pop(L, 1);
+    return rc;
+}
+
+/*
+ * Fill route->body from the route def at stack index `def` and check it
+ * against the manifest. Returns 0, or -1 (logged) for a bad declaration.
+ */
+static int hl_lua_route_body(HlLua *lua, int def, HlLuaRoute *route)
+{
+    lua_State *L = lua->L;
+    HlBodySpec *spec = &route->body;
+
+    memset(spec, 0, sizeof(*spec));
+    lua_getfield(L, def, "body");
+    spec->mode = lua_isstring(L, -1)
+               ? (HlBodyMode)hl_cap_body_mode(lua_tostring(L, -1))
+               : HL_BODY_BUFFER;
+    lua_pop(L, 1);
+    lua_getfield(L, def, "max_body");
+    spec->max_size = (int64_t)lua_tointeger(L, -1);
+    lua_pop(L, 1);
+    lua_getfield(L, def, "chunk_id");
+    route->chunk_id = (int)lua_tointeger(L, -1);
+    lua_pop(L, 1);
+
+    if (lua_route_string(L, def, "dir", spec->dir, sizeof(spec->dir)) != 0 ||
+        lua_route_string(L, def, "table", spec->table, sizeof(spec->table)) != 0 ||
+        lua_route_string(L, def, "column", spec->column, sizeof(spec->column)) != 0) {
+        log_error("[hull:c] body: dir, table or column too long");
+        return -1;
+    }
+    return hl_cap_body_check(spec, lua->base.manifest);
+}
+
 /* ── Route wiring ──────────────────────────────────────────────────── */
 
 void hl_lua_keel_handler(KlRequest *req, KlResponse *res, void *user_data)
 {
     HlLuaRoute *route = (HlLuaRoute *)user_data;
+    uint64_t t0 = hl_metrics_start();
     if (hl_lua_dispatch(route->lua, route->handler_id, req, res) != 0) {
         kl_response_status(res, 500);
         kl_response_header(res, "Content-Type", "text/plain");
         kl_response_body(res, "Internal Server Error", 21);
     }
+    hl_metrics_route_end(route->metrics_id, res->status, t0);
+    hl_access_log_finish(req, res->status, res->body_len);
+    hl_lua_request_end(route->lua);
+    hl_metrics_runtime(&route->lua->base);
 }
 
 int hl_lua_wire_routes(HlLua *lua, KlRouter *router)
@@ -435,11 +620,22 @@ int hl_lua_wire_routes(HlLua *lua, KlRouter *router)
             if (route) {
                 route->lua = lua;
                 route->handler_id = handler_id;
+                route->metrics_id = -1;
+                if (hl_lua_route_body(lua, lua_absindex(L, -4), route) != 0) {
+                    log_error("[hull:c] route %s %s: invalid body options",
+                              method_str, pattern);
+                    hl_alloc_free(lua->base.alloc, route, sizeof(HlLuaRoute));
+                    lua_pop(L, 5); /* fields, route def, defs table */
+                    return -1;
+                }
                 if (hl_lua_track_route(lua, route) != 0) {
                     hl_alloc_free(lua->base.alloc, route, sizeof(HlLuaRoute));
                 } else {
+                    /* Buffered bodies come from the caller (hull test) */
                     kl_router_add(router, method_str, pattern,
-                                  hl_lua_keel_handler, route, NULL);
+                                  hl_lua_keel_handler, route,
+                                  route->body.mode != HL_BODY_BUFFER
+                                      ? hl_lua_body_factory : NULL);
                 }
             }
         }
@@ -495,12 +691,20 @@ int hl_lua_wire_routes_server(HlLua *lua, KlServer *server,
             if (route) {
                 route->lua = lua;
                 route->handler_id = handler_id;
+                route->metrics_id = hl_metrics_route(method_str, pattern);
+                if (hl_lua_route_body(lua, lua_absindex(L, -4), route) != 0) {
+                    log_error("[hull:c] route %s %s: invalid body options",
+                              method_str, pattern);
+                    hl_alloc_free(lua->base.alloc, route, sizeof(HlLuaRoute));
+                    lua_pop(L, 5); /* fields, route def, defs table */
+                    return -1;
+                }
                 if (hl_lua_track_route(lua, route) != 0) {
                     hl_alloc_free(lua->base.alloc, route, sizeof(HlLuaRoute));
                 } else {
                     kl_server_route(server, method_str, pattern,
                                     hl_lua_keel_handler, route,
-                                    hl_cap_body_factory);
+                                    hl_lua_body_factory);
                 }
             }
         }
@@ -536,6 +740,7 @@ int hl_lua_wire_routes_server(HlLua *lua, KlServer *server,
                 if (ctx) {
                     ctx->lua = lua;
                     ctx->handler_id = handler_id;
+                    ctx->metrics_id = -1;
                     if (hl_lua_track_route(lua, ctx) != 0) {
                         hl_alloc_free(lua->base.alloc, ctx, sizeof(HlLuaRoute));
                     } else {
@@ -576,6 +781,7 @@ int hl_lua_wire_routes_server(HlLua *lua, KlServer *server,
                 if (ctx) {
                     ctx->lua = lua;
                     ctx->handler_id = handler_id;
+                    ctx->metrics_id = -1;
                     if (hl_lua_track_route(lua, ctx) != 0) {
                         hl_alloc_free(lua->base.alloc, ctx, sizeof(HlLuaRoute));
                     } else {
@@ -594,6 +800,148 @@ int hl_lua_wire_routes_server(HlLua *lua, KlServer *server,
     return 0;
 }
 
+/* ── Hot reload ────────────────────────────────────────────────────── */
+
+static const char *route_fields[] = { "method", "pattern", "handler_id",
+                                      "body", "max_body", "dir", "table",
+                                      "column", "chunk_id", NULL };
+static const char *job_fields[] = { "kind", "spec", "name", "jitter", "handler_id", NULL };
+
+/*
+ * Compare one registration table (route defs, middleware or jobs) of two
+ * Lua states: same length, and the same `fields` at every index. Missing
+ * tables compare as empty.
+ */
+static int lua_defs_equal(lua_State *a, lua_State *b, const char *key,
+                          const char **fields)
+{
+    lua_getfield(a, LUA_REGISTRYINDEX, key);
+    lua_getfield(b, LUA_REGISTRYINDEX, key);
+    lua_Integer na = lua_istable(a, -1) ? luaL_len(a, -1) : 0;
+    lua_Integer nb = lua_istable(b, -1) ? luaL_len(b, -1) : 0;
+    int equal = (na == nb);
+
+    for (lua_Integer i = 1; equal && i <= na; i++) {
+        lua_rawgeti(a, -1, i);
+        lua_rawgeti(b, -1, i);
+        if (!lua_istable(a, -1) || !lua_istable(b, -1)) {
+            equal = lua_type(a, -1) == lua_type(b, -1);
+        } else {
+            for (int f = 0; equal && fields[f]; f++) {
+                lua_getfield(a, -1, fields[f]);
+                lua_getfield(b, -1, fields[f]);
+                const char *va = lua_tostring(a, -1);
+                const char *vb = lua_tostring(b, -1);
+                equal = (va && vb) ? strcmp(va, vb) == 0 : va == vb;
+                lua_pop(a, 1);
+                lua_pop(b, 1);
+            }
+        }
+        lua_pop(a, 1);
+        lua_pop(b, 1);
+    }
+
+    lua_pop(a, 1);
+    lua_pop(b, 1);
+    return equal;
+}
+
+int hl_lua_adopt_routes(HlLua *lua, HlLua *from)
+{
+    if (!lua || !lua->L || !from || !from->L || lua->routes)
+        return 1;
+
+    if (!lua_defs_equal(lua->L, from->L, "__hull_route_defs", route_fields) ||
+        !lua_defs_equal(lua->L, from->L, "__hull_middleware", route_fields) ||
+        !lua_defs_equal(lua->L, from->L, "__hull_post_middleware", route_fields) ||
+        !lua_defs_equal(lua->L, from->L, "__hull_jobs", job_fields))
+        return 1;
+
+    /* Same handler_id at every registration: only the state changes */
+    for (size_t i = 0; i < from->route_count; i++)
+        ((HlLuaRoute *)from->routes[i])->lua = lua;
+
+    lua->routes = from->routes;
+    lua->route_count = from->route_count;
+    lua->route_cap = from->route_cap;
+    from->routes = NULL;
+    from->route_count = 0;
+    from->route_cap = 0;
+    return 0;
+}
+
+/* ── Background jobs ───────────────────────────────────────────────── */
+
+int hl_lua_extract_jobs(HlLua *lua, HlJobDef *out, int max)
+{
+    if (!lua || !lua->L || !out)
+        return -1;
+
+    lua_State *L = lua->L;
+    lua_getfield(L, LUA_REGISTRYINDEX, "__hull_jobs");
+    if (!lua_istable(L, -1)) {
+        lua_pop(L, 1);
+        return 0;
+    }
+
+    int count = 0;
+    lua_Integer n = luaL_len(L, -1);
+    for (lua_Integer i = 1; i <= n && count < max; i++) {
+        lua_rawgeti(L, -1, i);
+        lua_getfield(L, -1, "kind");
+        lua_getfield(L, -2, "spec");
+        lua_getfield(L, -3, "name");
+        lua_getfield(L, -4, "jitter");
+        lua_getfield(L, -5, "handler_id");
+        int rc = hl_sched_job_def(&out[count], lua_tostring(L, -5),
+                                  lua_tostring(L, -4), lua_tostring(L, -3),
+                                  (int64_t)lua_tointeger(L, -2),
+                                  (int)lua_tointeger(L, -1));
+        lua_pop(L, 6);
+        if (rc != 0) {
+            lua_pop(L, 1);
+            return -1;
+        }
+        count++;
+    }
+
+    lua_pop(L, 1);
+    return count;
+}
+
+int hl_lua_run_job(HlLua *lua, int handler_id)
+{
+    if (!lua || !lua->L)
+        return -1;
+
+    /* Guard: roll back any stale transaction left by a crashed handler */
+    hl_cap_db_guard_stale_txn(lua->base.db);
+
+    /* Same instruction budget and scratch as a request */
+    if (lua->max_instructions > 0)
+        lua_sethook(lua->L, hl_lua_instruction_hook, LUA_MASKCOUNT,
+                    (int)lua->max_instructions);
+    sh_arena_reset(lua->scratch);
+
+    int rc = -1;
+    lua_getfield(lua->L, LUA_REGISTRYINDEX, "__hull_routes");
+    if (lua_istable(lua->L, -1)) {
+        lua_rawgeti(lua->L, -1, handler_id);
+        if (!lua_isfunction(lua->L, -1)) {
+            lua_pop(lua->L, 1);
+        } else if (lua_pcall(lua->L, 0, 0, 0) != LUA_OK) {
+            log_error("[hull:c] lua job error: %s", lua_tostring(lua->L, -1));
+            lua_pop(lua->L, 1); /* pop error message */
+        } else {
+            rc = 0;
+        }
+    }
+    lua_pop(lua->L, 1); /* pop routes table */
+
+    hl_lua_request_end(lua);
+    return rc;
+}
+
 /* ── Middleware dispatch ────────────────────────────────────────────── */
 
 int hl_lua_dispatch_middleware(HlLua *lua, int handler_id,
@@ -709,8 +1057,11 @@ int hl_lua_keel_middleware(KlRequest *req, KlResponse *res, void *user_data)
         kl_response_status(res, 500);
         kl_response_header(res, "Content-Type", "text/plain");
         kl_response_body(res, "Internal Server Error", 21);
+        hl_access_log_finish(req, 500, 21);
         return 1; /* short-circuit */
     }
+    if (rc != 0)
+        hl_access_log_finish(req, res->status, res->body_len);
     return rc;
 }
 
@@ -745,6 +1096,21 @@ static void vt_lua_free_manifest_strings(HlRuntime *rt, HlManifest *m)
     (void)m;
 }
 
+static int vt_lua_adopt_routes(HlRuntime *rt, HlRuntime *from)
+{
+    return hl_lua_adopt_routes((HlLua *)rt, (HlLua *)from);
+}
+
+static int vt_lua_extract_jobs(HlRuntime *rt, HlJobDef *out, int max)
+{
+    return hl_lua_extract_jobs((HlLua *)rt, out, max);
+}
+
+static int vt_lua_run_job(HlRuntime *rt, int handler_id)
+{
+    return hl_lua_run_job((HlLua *)rt, handler_id);
+}
+
 static void vt_lua_destroy(HlRuntime *rt)
 {
     hl_lua_free((HlLua *)rt);
@@ -756,6 +1122,9 @@ const HlRuntimeVtable hl_lua_vtable = {
     .wire_routes_server  = vt_lua_wire_routes_server,
     .extract_manifest    = vt_lua_extract_manifest,
     .free_manifest_strings = vt_lua_free_manifest_strings,
+    .adopt_routes        = vt_lua_adopt_routes,
+    .extract_jobs        = vt_lua_extract_jobs,
+    .run_job             = vt_lua_run_job,
     .destroy             = vt_lua_destroy,
     .name                = "Lua",
 };
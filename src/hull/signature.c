@@ -10,6 +10,7 @@
 
 #include "hull/signature.h"
 #include "hull/cap/crypto.h"
+#include "hull/limits.h"
 
 #include "log.h"
 
@@ -357,15 +358,14 @@ int hl_sig_verify_platform(const HlSignature *sig, const uint8_t pubkey[32])
 /* Search the VFS for a file matching sig_name.
  * For .lua entries, the embedded name has the extension stripped,
  * so we try both "./sig_name" and "./sig_name_without_lua". */
-static int sig_find_in_entries(const HlVfs *vfs, const char *sig_name,
-                               const unsigned char **out_data,
-                               unsigned int *out_len)
+static const HlEntry *sig_find_in_entries(const HlVfs *vfs,
+                                          const char *sig_name)
 {
     /* Try "./sig_name" first (exact match for .js/.json) */
     char lookup[1024];
     int n = snprintf(lookup, sizeof(lookup), "./%s", sig_name);
     if (n < 0 || (size_t)n >= sizeof(lookup))
-        return 0;
+        return NULL;
 
     const HlEntry *e = hl_vfs_find(vfs, lookup);
 
@@ -379,56 +379,44 @@ static int sig_find_in_entries(const HlVfs *vfs, const char *sig_name,
                 e = hl_vfs_find(vfs, lookup);
         }
     }
-
-    if (e) {
-        *out_data = e->data;
-        *out_len = e->len;
-        return 1;
-    }
-    return 0;
-}
-
-/* Check whether an embedded entry name matches any signature entry. */
-static int sig_entry_in_sig(const HlSignature *sig, const char *ename)
-{
-    for (size_t i = 0; i < sig->entry_count; i++) {
-        const char *sig_name = sig->entries[i].name;
-        size_t slen = strlen(sig_name);
-        size_t mlen = slen;
-        if (slen > 4 && strcmp(sig_name + slen - 4, ".lua") == 0)
-            mlen = slen - 4;
-
-        if (strlen(ename) == mlen && strncmp(ename, sig_name, mlen) == 0)
-            return 1;
-    }
-    return 0;
+    return e;
 }
 
 int hl_sig_verify_files_embedded(const HlSignature *sig, const HlVfs *vfs)
 {
     if (!sig || !sig->entries || !vfs) return -1;
 
+    /* Resolve every entry first, then hash them as one batch. `seen`
+     * marks the VFS entries a signature entry resolved to, so the
+     * extra-file check below is linear rather than entries x files. */
+    HlSha256Item *items = calloc(sig->entry_count + 1, sizeof(*items));
+    unsigned char *seen = calloc(vfs->count + 1, 1);
+    int rc = -1;
+    if (!items || !seen)
+        goto out;
+
     for (size_t i = 0; i < sig->entry_count; i++) {
         const char *sig_name = sig->entries[i].name;
-        const char *expected_hash = sig->entries[i].hash_hex;
-
-        const unsigned char *data = NULL;
-        unsigned int data_len = 0;
-
-        if (!sig_find_in_entries(vfs, sig_name, &data, &data_len)) {
+        const HlEntry *e = sig_find_in_entries(vfs, sig_name);
+        if (!e) {
             log_error("[sig] file not found in binary: %s", sig_name);
-            return -1;
+            goto out;
         }
+        seen[e - vfs->entries] = 1;
+        items[i].data = e->data;
+        items[i].len = e->len;
+    }
 
-        uint8_t hash[32];
-        if (hl_cap_crypto_sha256(data, data_len, hash) != 0) return -1;
+    if (hl_cap_crypto_sha256_many(items, sig->entry_count) != 0)
+        goto out;
 
+    for (size_t i = 0; i < sig->entry_count; i++) {
         char hash_hex[65];
-        hex_encode(hash, 32, hash_hex);
+        hex_encode(items[i].hash, 32, hash_hex);
 
-        if (strcmp(hash_hex, expected_hash) != 0) {
-            log_error("[sig] hash mismatch for %s", sig_name);
-            return -1;
+        if (strcmp(hash_hex, sig->entries[i].hash_hex) != 0) {
+            log_error("[sig] hash mismatch for %s", sig->entries[i].name);
+            goto out;
         }
     }
 
@@ -436,71 +424,132 @@ int hl_sig_verify_files_embedded(const HlSignature *sig, const HlVfs *vfs)
     const HlEntry *mod_first = NULL;
     size_t mod_count = hl_vfs_prefix(vfs, "./", &mod_first);
     for (size_t i = 0; i < mod_count; i++) {
-        const char *ename = mod_first[i].name;
-        if (ename[0] == '.' && ename[1] == '/')
-            ename += 2;
-
-        if (!sig_entry_in_sig(sig, ename)) {
+        if (!seen[(mod_first + i) - vfs->entries]) {
             log_error("[sig] extra file in binary not in signature: %s",
                       mod_first[i].name);
-            return -1;
+            goto out;
         }
     }
+    rc = 0;
+
+out:
+    free(seen);
+    free(items);
+    return rc;
+}
 
+/* Embedded bytecode companion ("x.luac" / "x.jsc") — no file on disk. */
+static int sig_is_bytecode_name(const char *name)
+{
+    static const char *const suffixes[] = {
+        HL_LUA_BYTECODE_SUFFIX, HL_JS_BYTECODE_SUFFIX
+    };
+    size_t nlen = strlen(name);
+    for (size_t i = 0; i < sizeof(suffixes) / sizeof(suffixes[0]); i++) {
+        size_t slen = strlen(suffixes[i]);
+        if (nlen > slen && strcmp(name + nlen - slen, suffixes[i]) == 0)
+            return 1;
+    }
     return 0;
 }
 
-int hl_sig_verify_files_fs(const HlSignature *sig, const char *app_dir)
+/* Read one signed file into a malloc'd buffer. 0 or -1 (logged). */
+static int sig_read_file(const char *app_dir, const char *name,
+                         char **out, size_t *out_len)
 {
-    if (!sig || !sig->entries || !app_dir) return -1;
+    char path[PATH_MAX];
+    snprintf(path, sizeof(path), "%s/%s", app_dir, name);
 
-    for (size_t i = 0; i < sig->entry_count; i++) {
-        const char *name = sig->entries[i].name;
-        const char *expected_hash = sig->entries[i].hash_hex;
+    FILE *f = fopen(path, "rb");
+    if (!f) {
+        log_error("[sig] cannot open file: %s", path);
+        return -1;
+    }
+
+    fseek(f, 0, SEEK_END);
+    long fsize = ftell(f);
+    fseek(f, 0, SEEK_SET);
 
-        char path[PATH_MAX];
-        snprintf(path, sizeof(path), "%s/%s", app_dir, name);
+    if (fsize < 0 || fsize > 100 * 1024 * 1024) {
+        fclose(f);
+        log_error("[sig] file too large: %s", path);
+        return -1;
+    }
 
-        FILE *f = fopen(path, "rb");
-        if (!f) {
-            log_error("[sig] cannot open file: %s", path);
-            return -1;
-        }
+    /* +1: a zero-length malloc may return NULL */
+    char *data = malloc((size_t)fsize + 1);
+    if (!data) { fclose(f); return -1; }
 
-        fseek(f, 0, SEEK_END);
-        long fsize = ftell(f);
-        fseek(f, 0, SEEK_SET);
+    *out_len = fread(data, 1, (size_t)fsize, f);
+    *out = data;
+    fclose(f);
+    return 0;
+}
 
-        if (fsize < 0 || fsize > 100 * 1024 * 1024) {
-            fclose(f);
-            log_error("[sig] file too large: %s", path);
-            return -1;
+/* Hash and compare a batch read by hl_sig_verify_files_fs; frees it. */
+static int sig_check_batch(const HlSignature *sig, const size_t *idx,
+                           HlSha256Item *items, size_t n)
+{
+    int rc = hl_cap_crypto_sha256_many(items, n);
+
+    for (size_t i = 0; i < n && rc == 0; i++) {
+        char hash_hex[65];
+        hex_encode(items[i].hash, 32, hash_hex);
+
+        const char *expected_hash = sig->entries[idx[i]].hash_hex;
+        if (strcmp(hash_hex, expected_hash) != 0) {
+            log_error("[sig] hash mismatch: %s (expected %s, got %s)",
+                      sig->entries[idx[i]].name, expected_hash, hash_hex);
+            rc = -1;
         }
+    }
 
-        char *data = malloc((size_t)fsize);
-        if (!data) { fclose(f); return -1; }
+    for (size_t i = 0; i < n; i++)
+        free((void *)items[i].data);
+    return rc;
+}
 
-        size_t nread = fread(data, 1, (size_t)fsize, f);
-        fclose(f);
+int hl_sig_verify_files_fs(const HlSignature *sig, const char *app_dir)
+{
+    if (!sig || !sig->entries || !app_dir) return -1;
+
+    /* Files are read in batches (bounded by count and bytes) and each
+     * batch is hashed in parallel while memory stays capped. */
+    HlSha256Item items[HL_SIG_HASH_BATCH];
+    size_t idx[HL_SIG_HASH_BATCH];
+    size_t n = 0, bytes = 0;
 
-        uint8_t hash[32];
-        if (hl_cap_crypto_sha256(data, nread, hash) != 0) {
-            free(data);
+    for (size_t i = 0; i < sig->entry_count; i++) {
+        const char *name = sig->entries[i].name;
+
+        /* Precompiled bytecode only exists inside the binary; the
+         * filesystem path always loads (and hashes) the source. */
+        if (sig_is_bytecode_name(name))
+            continue;
+
+        char *data;
+        size_t len;
+        if (sig_read_file(app_dir, name, &data, &len) != 0) {
+            for (size_t j = 0; j < n; j++)
+                free((void *)items[j].data);
             return -1;
         }
-        free(data);
 
-        char hash_hex[65];
-        hex_encode(hash, 32, hash_hex);
+        items[n].data = data;
+        items[n].len = len;
+        idx[n] = i;
+        n++;
+        bytes += len;
 
-        if (strcmp(hash_hex, expected_hash) != 0) {
-            log_error("[sig] hash mismatch: %s (expected %s, got %s)",
-                      name, expected_hash, hash_hex);
-            return -1;
+        if (n == HL_SIG_HASH_BATCH || bytes >= HL_SIG_HASH_BATCH_BYTES) {
+            if (sig_check_batch(sig, idx, items, n) != 0)
+                return -1;
+            n = 0;
+            bytes = 0;
         }
     }
 
-    return 0;
+    return n > 0 ? sig_check_batch(sig, idx, items, n) : 0;
 }
 
 void hl_sig_free(HlSignature *sig)
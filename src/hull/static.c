@@ -8,6 +8,7 @@
  */
 
 #include "hull/static.h"
+#include "hull/access_log.h"
 
 #include <keel/request.h>
 #include <keel/response.h>
@@ -164,6 +165,7 @@ int hl_static_middleware(KlRequest *req, KlResponse *res, void *user_data)
             kl_response_status(res, 304);
             kl_response_header(res, "ETag", etag);
             kl_response_body(res, NULL, 0);
+            hl_access_log_finish(req, 304, 0);
             return 1;
         }
 
@@ -173,6 +175,7 @@ int hl_static_middleware(KlRequest *req, KlResponse *res, void *user_data)
         if (elen > 0)
             kl_response_header(res, "ETag", etag);
         kl_response_body(res, (const char *)e->data, e->len);
+        hl_access_log_finish(req, 200, e->len);
         return 1;
     }
 
@@ -201,6 +204,7 @@ int hl_static_middleware(KlRequest *req, KlResponse *res, void *user_data)
             kl_response_status(res, 304);
             kl_response_header(res, "ETag", etag);
             kl_response_body(res, NULL, 0);
+            hl_access_log_finish(req, 304, 0);
             return 1;
         }
 
@@ -210,6 +214,7 @@ int hl_static_middleware(KlRequest *req, KlResponse *res, void *user_data)
         if (elen > 0)
             kl_response_header(res, "ETag", etag);
         kl_response_file(res, fd, st.st_size);
+        hl_access_log_finish(req, 200, (size_t)st.st_size);
         return 1;
     }
 
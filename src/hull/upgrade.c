@@ -0,0 +1,369 @@
+/*
+ * upgrade.c — Zero-downtime binary upgrade on SIGUSR2
+ *
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#include "hull/upgrade.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+static int trigger_fd = -1;    /* old process: the SIGUSR2 handler writes here */
+static int channel_fd = -1;    /* new process: socket back to the helper */
+static struct sigaction prev_usr2;
+
+/* ── Helpers ───────────────────────────────────────────────────────── */
+
+/* The helper is forked from a threaded process: format on the stack and
+ * write(2) rather than going through stdio or the log sink. */
+static void say(const char *fmt, ...)
+{
+    char buf[512];
+    int n = snprintf(buf, sizeof(buf), "[hull:upgrade] ");
+    va_list ap;
+    va_start(ap, fmt);
+    n += vsnprintf(buf + n, sizeof(buf) - (size_t)n, fmt, ap);
+    va_end(ap);
+    if (n > (int)sizeof(buf) - 2)
+        n = (int)sizeof(buf) - 2;
+    buf[n++] = '\n';
+    ssize_t w = write(STDERR_FILENO, buf, (size_t)n);
+    (void)w;
+}
+
+static int64_t now_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+static void set_cloexec(int fd)
+{
+    int flags = fcntl(fd, F_GETFD);
+    if (flags >= 0)
+        fcntl(fd, F_SETFD, flags | FD_CLOEXEC);
+}
+
+/* ── Descriptor passing ────────────────────────────────────────────── */
+
+typedef union {
+    struct cmsghdr hdr;
+    char           buf[CMSG_SPACE(sizeof(int) * HL_UPGRADE_MAX_FDS)];
+} FdControl;
+
+static int send_fds(int sock, const int *fds, int nfds)
+{
+    char byte = (char)nfds;
+    struct iovec iov = { .iov_base = &byte, .iov_len = 1 };
+    FdControl ctl;
+    memset(&ctl, 0, sizeof(ctl));
+
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = ctl.buf;
+    msg.msg_controllen = CMSG_SPACE(sizeof(int) * (size_t)nfds);
+
+    struct cmsghdr *c = CMSG_FIRSTHDR(&msg);
+    c->cmsg_level = SOL_SOCKET;
+    c->cmsg_type = SCM_RIGHTS;
+    c->cmsg_len = CMSG_LEN(sizeof(int) * (size_t)nfds);
+    memcpy(CMSG_DATA(c), fds, sizeof(int) * (size_t)nfds);
+
+    ssize_t n;
+    do {
+        n = sendmsg(sock, &msg, 0);
+    } while (n < 0 && errno == EINTR);
+    return n == 1 ? 0 : -1;
+}
+
+static int recv_fds(int sock, int *fds, int max)
+{
+    char byte;
+    struct iovec iov = { .iov_base = &byte, .iov_len = 1 };
+    FdControl ctl;
+
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = ctl.buf;
+    msg.msg_controllen = sizeof(ctl.buf);
+
+    ssize_t n;
+    do {
+        n = recvmsg(sock, &msg, 0);
+    } while (n < 0 && errno == EINTR);
+    if (n != 1)
+        return -1;
+
+    struct cmsghdr *c = CMSG_FIRSTHDR(&msg);
+    if (!c || c->cmsg_level != SOL_SOCKET || c->cmsg_type != SCM_RIGHTS)
+        return -1;
+
+    int got[HL_UPGRADE_MAX_FDS];
+    size_t count = (c->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+    if (count > HL_UPGRADE_MAX_FDS)
+        count = HL_UPGRADE_MAX_FDS;
+    memcpy(got, CMSG_DATA(c), count * sizeof(int));
+
+    int kept = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (kept < max) {
+            set_cloexec(got[i]);
+            fds[kept++] = got[i];
+        } else {
+            close(got[i]);
+        }
+    }
+    return kept;
+}
+
+/* ── Helper process ────────────────────────────────────────────────── */
+
+/* 1 on 'R', 0 if the new process exited first, -1 on timeout */
+static int wait_ready(int sock, int timeout_ms)
+{
+    int64_t deadline = now_ms() + timeout_ms;
+    for (;;) {
+        int64_t left = deadline - now_ms();
+        if (left <= 0)
+            return -1;
+        struct pollfd p = { .fd = sock, .events = POLLIN };
+        int rc = poll(&p, 1, (int)left);
+        if (rc < 0 && errno == EINTR)
+            continue;
+        if (rc < 0)
+            return 0;
+        if (rc == 0)
+            return -1;
+
+        char c;
+        ssize_t n = read(sock, &c, 1);
+        if (n < 0 && errno == EINTR)
+            continue;
+        return n == 1 && c == 'R' ? 1 : 0;
+    }
+}
+
+/*
+ * Exec argv with the listening sockets and wait for it to report ready.
+ * Returns 1 if it took over (the old server has been told to drain),
+ * 0 if the old server keeps serving.
+ */
+static int spawn_successor(char *const *argv, const int *fds, int nfds,
+                           int timeout_ms, pid_t server)
+{
+    int sv[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, sv) != 0) {
+        say("socketpair failed: %s", strerror(errno));
+        return 0;
+    }
+    set_cloexec(sv[0]);
+
+    pid_t pid = fork();
+    if (pid < 0) {
+        say("fork failed: %s", strerror(errno));
+        close(sv[0]);
+        close(sv[1]);
+        return 0;
+    }
+
+    if (pid == 0) {
+        char val[16];
+        snprintf(val, sizeof(val), "%d", sv[1]);
+        setenv(HL_UPGRADE_ENV, val, 1);
+
+        sigset_t none;
+        sigemptyset(&none);
+        sigprocmask(SIG_SETMASK, &none, NULL);
+        signal(SIGINT, SIG_DFL);
+        signal(SIGUSR2, SIG_DFL);
+        signal(SIGPIPE, SIG_DFL);
+
+        execvp(argv[0], argv);
+        say("cannot exec %s: %s", argv[0], strerror(errno));
+        _exit(127);
+    }
+
+    close(sv[1]);
+    say("starting %s as pid %d", argv[0], (int)pid);
+
+    int ready = 0;
+    if (send_fds(sv[0], fds, nfds) == 0)
+        ready = wait_ready(sv[0], timeout_ms);
+    close(sv[0]);
+
+    if (ready == 1) {
+        say("pid %d ready, draining pid %d", (int)pid, (int)server);
+        kill(server, SIGTERM);
+        return 1;
+    }
+
+    if (ready < 0)
+        say("pid %d not ready after %d ms, killing it", (int)pid, timeout_ms);
+    kill(pid, SIGKILL);
+    int status = 0;
+    while (waitpid(pid, &status, 0) < 0 && errno == EINTR)
+        ;
+    if (ready == 0 && WIFEXITED(status))
+        say("pid %d exited with status %d before it was ready",
+            (int)pid, WEXITSTATUS(status));
+    say("pid %d keeps serving", (int)server);
+    return 0;
+}
+
+static void helper_main(int trigger, char *const *argv, const int *fds,
+                        int nfds, int timeout_ms, pid_t server)
+{
+    signal(SIGUSR2, SIG_IGN);
+    signal(SIGINT, SIG_IGN);     /* ^C reaches the group; the server decides */
+    signal(SIGPIPE, SIG_IGN);
+    signal(SIGTERM, SIG_DFL);
+    signal(SIGCHLD, SIG_DFL);
+
+    /* Keep stdio, the trigger and the listeners; the database, log and
+     * audit files belong to the server and must not leak into the new
+     * binary. */
+    long max_fd = sysconf(_SC_OPEN_MAX);
+    if (max_fd < 0 || max_fd > 65536)
+        max_fd = 65536;
+    for (int fd = STDERR_FILENO + 1; fd < max_fd; fd++) {
+        int keep = (fd == trigger);
+        for (int i = 0; i < nfds; i++)
+            keep |= (fd == fds[i]);
+        if (!keep)
+            close(fd);
+    }
+    for (int i = 0; i < nfds; i++)
+        set_cloexec(fds[i]);
+
+    int done = 0;
+    for (;;) {
+        char c;
+        ssize_t n = read(trigger, &c, 1);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            break;          /* server exited or disarmed */
+        if (!done)
+            done = spawn_successor(argv, fds, nfds, timeout_ms, server);
+    }
+}
+
+/* ── Old process ───────────────────────────────────────────────────── */
+
+static void on_sigusr2(int sig)
+{
+    (void)sig;
+    int saved = errno;
+    char c = 'U';
+    ssize_t n = write(trigger_fd, &c, 1);
+    (void)n;
+    errno = saved;
+}
+
+int hl_upgrade_arm(char *const *argv, const int *fds, int nfds,
+                   int ready_timeout_ms)
+{
+    if (trigger_fd >= 0 || !argv || !argv[0] ||
+        nfds < 1 || nfds > HL_UPGRADE_MAX_FDS)
+        return -1;
+
+    int p[2];
+    if (pipe(p) != 0)
+        return -1;
+    set_cloexec(p[0]);
+    set_cloexec(p[1]);
+    /* The handler must never block the event loop */
+    fcntl(p[1], F_SETFL, fcntl(p[1], F_GETFL) | O_NONBLOCK);
+
+    pid_t server = getpid();
+    fflush(NULL);
+    pid_t pid = fork();
+    if (pid < 0) {
+        close(p[0]);
+        close(p[1]);
+        return -1;
+    }
+    if (pid == 0) {
+        close(p[1]);
+        helper_main(p[0], argv, fds, nfds, ready_timeout_ms, server);
+        /* _exit: the server's atexit handlers join threads we don't have */
+        _exit(0);
+    }
+
+    close(p[0]);
+    trigger_fd = p[1];
+
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = on_sigusr2;
+    sigemptyset(&sa.sa_mask);
+    sa.sa_flags = SA_RESTART;
+    sigaction(SIGUSR2, &sa, &prev_usr2);
+    return 0;
+}
+
+void hl_upgrade_disarm(void)
+{
+    if (trigger_fd < 0)
+        return;
+    sigaction(SIGUSR2, &prev_usr2, NULL);
+    close(trigger_fd);
+    trigger_fd = -1;
+}
+
+/* ── New process ───────────────────────────────────────────────────── */
+
+int hl_upgrade_receive(int *fds, int max)
+{
+    const char *env = getenv(HL_UPGRADE_ENV);
+    if (!env || !env[0])
+        return 0;
+
+    char *end;
+    long sock = strtol(env, &end, 10);
+    int valid = (*end == '\0' && sock > STDERR_FILENO && sock < INT_MAX);
+    /* Not for whatever this process starts later */
+    unsetenv(HL_UPGRADE_ENV);
+    if (!valid)
+        return -1;
+
+    int n = recv_fds((int)sock, fds, max);
+    if (n <= 0) {
+        close((int)sock);
+        return -1;
+    }
+    set_cloexec((int)sock);
+    channel_fd = (int)sock;
+    return n;
+}
+
+void hl_upgrade_ready(void)
+{
+    if (channel_fd < 0)
+        return;
+    char c = 'R';
+    ssize_t n;
+    do {
+        n = write(channel_fd, &c, 1);
+    } while (n < 0 && errno == EINTR);
+    close(channel_fd);
+    channel_fd = -1;
+}
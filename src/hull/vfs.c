@@ -59,6 +59,20 @@ const HlEntry *hl_vfs_find(const HlVfs *vfs, const char *name)
     return NULL;
 }
 
+const HlEntry *hl_vfs_find_suffixed(const HlVfs *vfs, const char *name,
+                                    const char *suffix)
+{
+    if (!vfs || !name || !suffix || vfs->count == 0)
+        return NULL;
+
+    char buf[1024];
+    int n = snprintf(buf, sizeof(buf), "%s%s", name, suffix);
+    if (n < 0 || (size_t)n >= sizeof(buf))
+        return NULL;
+
+    return hl_vfs_find(vfs, buf);
+}
+
 /*
  * Find the lower bound: the first entry whose name >= prefix.
  * Returns vfs->count if all entries are < prefix.
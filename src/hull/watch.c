@@ -0,0 +1,467 @@
+/*
+ * watch.c — App directory change notification for hull dev
+ *
+ * inotify watches every directory (IN_ONLYDIR) and reports file names,
+ * so events are classified by extension; directories created later are
+ * added as they appear. kqueue needs a descriptor per watched vnode:
+ * directories and app files are opened, and a directory event (file
+ * added, removed or renamed over — the way most editors save) rebuilds
+ * the set. Polling compares the newest code and .sql mtimes.
+ *
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#include "hull/watch.h"
+#include "hull/limits.h"
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <poll.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#if defined(__linux__) && !defined(__COSMOPOLITAN__)
+#define HL_WATCH_INOTIFY 1
+#include <sys/inotify.h>
+#elif defined(__APPLE__) || defined(__FreeBSD__) || defined(__OpenBSD__) || \
+      defined(__NetBSD__)
+#define HL_WATCH_KQUEUE 1
+#include <sys/event.h>
+#include <sys/time.h>
+#endif
+
+/* ── File classification ──────────────────────────────────────────── */
+
+static int should_skip(const char *name)
+{
+    if (name[0] == '.') return 1;
+    if (strcmp(name, "node_modules") == 0) return 1;
+    if (strcmp(name, "vendor") == 0) return 1;
+    if (strcmp(name, "build") == 0) return 1;
+    return 0;
+}
+
+static int has_suffix(const char *name, const char *suffix)
+{
+    size_t n = strlen(name), s = strlen(suffix);
+    return n > s && strcmp(name + n - s, suffix) == 0;
+}
+
+static int classify(const char *name)
+{
+    if (has_suffix(name, ".lua") || has_suffix(name, ".js") ||
+        has_suffix(name, ".html"))
+        return HL_WATCH_CODE;
+    if (has_suffix(name, ".sql"))
+        return HL_WATCH_RESTART;
+    return HL_WATCH_NONE;
+}
+
+static int64_t now_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+/* ── Tree walk ────────────────────────────────────────────────────── */
+
+typedef int (*WalkFn)(HlWatch *w, const char *path, int is_dir, void *ud);
+
+/* Visit dir itself, then every non-skipped subdirectory and file below */
+static int walk(HlWatch *w, const char *dir, WalkFn fn, void *ud)
+{
+    if (fn(w, dir, 1, ud) != 0)
+        return -1;
+
+    DIR *d = opendir(dir);
+    if (!d)
+        return 0;
+
+    int rc = 0;
+    struct dirent *ent;
+    while (rc == 0 && (ent = readdir(d)) != NULL) {
+        if (should_skip(ent->d_name))
+            continue;
+
+        char path[PATH_MAX];
+        if (snprintf(path, sizeof(path), "%s/%s", dir, ent->d_name) >= (int)sizeof(path))
+            continue;
+
+        struct stat st;
+        if (lstat(path, &st) != 0)
+            continue;
+        if (S_ISDIR(st.st_mode))
+            rc = walk(w, path, fn, ud);
+        else if (S_ISREG(st.st_mode))
+            rc = fn(w, path, 0, ud);
+    }
+
+    closedir(d);
+    return rc;
+}
+
+typedef struct {
+    time_t code;
+    time_t sql;
+} Mtimes;
+
+static int scan_fn(HlWatch *w, const char *path, int is_dir, void *ud)
+{
+    (void)w;
+    if (is_dir)
+        return 0;
+    Mtimes *mt = (Mtimes *)ud;
+    int kind = classify(path);
+    struct stat st;
+    if (kind == HL_WATCH_NONE || stat(path, &st) != 0)
+        return 0;
+    time_t *slot = kind == HL_WATCH_CODE ? &mt->code : &mt->sql;
+    if (st.st_mtime > *slot)
+        *slot = st.st_mtime;
+    return 0;
+}
+
+static Mtimes scan(const char *dir)
+{
+    Mtimes mt = { 0, 0 };
+    walk(NULL, dir, scan_fn, &mt);
+    return mt;
+}
+
+/* ── Entries ──────────────────────────────────────────────────────── */
+
+static int entry_add(HlWatch *w, int wd, const char *path, int is_dir)
+{
+    if (w->count == w->cap) {
+        int cap = w->cap ? w->cap * 2 : 64;
+        HlWatchEntry *e = realloc(w->entries, (size_t)cap * sizeof(*e));
+        if (!e)
+            return -1;
+        w->entries = e;
+        w->cap = cap;
+    }
+    char *copy = strdup(path);
+    if (!copy)
+        return -1;
+    w->entries[w->count++] = (HlWatchEntry){ wd, copy, is_dir };
+    return 0;
+}
+
+static HlWatchEntry *entry_find(HlWatch *w, int wd)
+{
+    for (int i = 0; i < w->count; i++)
+        if (w->entries[i].wd == wd)
+            return &w->entries[i];
+    return NULL;
+}
+
+static void entries_clear(HlWatch *w)
+{
+    for (int i = 0; i < w->count; i++) {
+#ifdef HL_WATCH_KQUEUE
+        close(w->entries[i].wd);
+#endif
+        free(w->entries[i].path);
+    }
+    w->count = 0;
+}
+
+/* ── Polling ──────────────────────────────────────────────────────── */
+
+static void use_polling(HlWatch *w)
+{
+    entries_clear(w);
+    if (w->fd >= 0)
+        close(w->fd);
+    w->fd = -1;
+    w->backend = "poll";
+    Mtimes mt = scan(w->root);
+    w->poll_code = mt.code;
+    w->poll_sql = mt.sql;
+}
+
+/* Compare against the baseline and move it forward */
+static int poll_changes(HlWatch *w)
+{
+    Mtimes mt = scan(w->root);
+    int level = HL_WATCH_NONE;
+    if (mt.code > w->poll_code)
+        level = HL_WATCH_CODE;
+    if (mt.sql > w->poll_sql)
+        level = HL_WATCH_RESTART;
+    w->poll_code = mt.code;
+    w->poll_sql = mt.sql;
+    return level;
+}
+
+static int poll_wait(HlWatch *w, int timeout_ms, int debounce_ms)
+{
+    int64_t deadline = timeout_ms < 0 ? INT64_MAX : now_ms() + timeout_ms;
+    int level = HL_WATCH_NONE;
+
+    while (level == HL_WATCH_NONE) {
+        int64_t left = deadline - now_ms();
+        if (left <= 0)
+            return HL_WATCH_NONE;
+        int64_t step = left < HL_WATCH_POLL_MS ? left : HL_WATCH_POLL_MS;
+        struct timespec ts = { (time_t)(step / 1000), (long)(step % 1000) * 1000000L };
+        if (nanosleep(&ts, NULL) != 0 && errno == EINTR)
+            return HL_WATCH_NONE;
+        level = poll_changes(w);
+    }
+
+    /* Quiet period: keep folding in changes until a scan finds none */
+    for (;;) {
+        struct timespec ts = { debounce_ms / 1000, (long)(debounce_ms % 1000) * 1000000L };
+        if (nanosleep(&ts, NULL) != 0 && errno == EINTR)
+            return level;
+        int more = poll_changes(w);
+        if (more == HL_WATCH_NONE)
+            return level;
+        if (more > level)
+            level = more;
+    }
+}
+
+/* ── inotify ──────────────────────────────────────────────────────── */
+
+#ifdef HL_WATCH_INOTIFY
+
+#define INOTIFY_MASK (IN_MODIFY | IN_CLOSE_WRITE | IN_CREATE | IN_DELETE | \
+                      IN_MOVED_FROM | IN_MOVED_TO | IN_ONLYDIR)
+
+static int inotify_add_fn(HlWatch *w, const char *path, int is_dir, void *ud)
+{
+    (void)ud;
+    if (!is_dir)
+        return 0;
+    int wd = inotify_add_watch(w->fd, path, INOTIFY_MASK);
+    if (wd < 0)
+        return -1;   /* ENOSPC: over the per-user watch limit */
+    if (entry_find(w, wd))
+        return 0;    /* same directory reached twice */
+    return entry_add(w, wd, path, 1);
+}
+
+/* Drain pending events; returns the strongest change, -1 on error */
+static int inotify_read(HlWatch *w)
+{
+    char buf[8192] __attribute__((aligned(__alignof__(struct inotify_event))));
+    int level = HL_WATCH_NONE;
+
+    for (;;) {
+        ssize_t n = read(w->fd, buf, sizeof(buf));
+        if (n < 0) {
+            if (errno == EAGAIN || errno == EINTR)
+                return level;
+            return -1;
+        }
+        for (char *p = buf; p < buf + n;) {
+            const struct inotify_event *ev = (const struct inotify_event *)p;
+            p += sizeof(*ev) + ev->len;
+
+            if (ev->mask & IN_Q_OVERFLOW) {
+                level = HL_WATCH_RESTART;
+                continue;
+            }
+            HlWatchEntry *dir = entry_find(w, ev->wd);
+            if (dir && (ev->mask & IN_IGNORED)) {
+                /* Directory removed: drop its entry */
+                free(dir->path);
+                *dir = w->entries[--w->count];
+                continue;
+            }
+            if (!dir || ev->len == 0 || should_skip(ev->name))
+                continue;
+
+            if (ev->mask & IN_ISDIR) {
+                if (!(ev->mask & (IN_CREATE | IN_MOVED_TO)))
+                    continue;
+                /* New subtree: watch it and look at what is already inside */
+                char path[PATH_MAX];
+                if (snprintf(path, sizeof(path), "%s/%s", dir->path, ev->name) >= (int)sizeof(path))
+                    continue;
+                if (walk(w, path, inotify_add_fn, NULL) != 0) {
+                    use_polling(w);
+                    return HL_WATCH_RESTART;
+                }
+                Mtimes mt = scan(path);
+                int kind = mt.sql ? HL_WATCH_RESTART : mt.code ? HL_WATCH_CODE : HL_WATCH_NONE;
+                if (kind > level)
+                    level = kind;
+                continue;
+            }
+
+            int kind = classify(ev->name);
+            if (kind > level)
+                level = kind;
+        }
+    }
+}
+
+#endif /* HL_WATCH_INOTIFY */
+
+/* ── kqueue ───────────────────────────────────────────────────────── */
+
+#ifdef HL_WATCH_KQUEUE
+
+#ifndef O_EVTONLY
+#define O_EVTONLY O_RDONLY
+#endif
+
+#define KQUEUE_NOTES (NOTE_WRITE | NOTE_EXTEND | NOTE_ATTRIB | NOTE_DELETE | NOTE_RENAME)
+
+static int kqueue_add_fn(HlWatch *w, const char *path, int is_dir, void *ud)
+{
+    (void)ud;
+    if (!is_dir && classify(path) == HL_WATCH_NONE)
+        return 0;
+    int fd = open(path, O_EVTONLY | O_CLOEXEC);
+    if (fd < 0)
+        return is_dir ? -1 : 0;   /* a file may vanish mid-walk */
+    struct kevent kev;
+    EV_SET(&kev, (uintptr_t)fd, EVFILT_VNODE, EV_ADD | EV_CLEAR, KQUEUE_NOTES, 0, NULL);
+    if (kevent(w->fd, &kev, 1, NULL, 0, NULL) != 0 ||
+        entry_add(w, fd, path, is_dir) != 0) {
+        close(fd);
+        return -1;
+    }
+    return 0;
+}
+
+static int kqueue_rebuild(HlWatch *w)
+{
+    entries_clear(w);   /* closing the fds removes their kevents */
+    return walk(w, w->root, kqueue_add_fn, NULL);
+}
+
+/* Collect pending events without blocking; returns the strongest change */
+static int kqueue_read(HlWatch *w, int wait_ms)
+{
+    struct kevent evs[64];
+    struct timespec ts = { wait_ms / 1000, (long)(wait_ms % 1000) * 1000000L };
+    int n = kevent(w->fd, NULL, 0, evs, 64, wait_ms < 0 ? NULL : &ts);
+    if (n < 0)
+        return errno == EINTR ? HL_WATCH_NONE : -1;
+
+    int level = HL_WATCH_NONE, rebuild = 0;
+    for (int i = 0; i < n; i++) {
+        HlWatchEntry *e = entry_find(w, (int)evs[i].ident);
+        if (!e)
+            continue;
+        if (e->is_dir || (evs[i].fflags & (NOTE_DELETE | NOTE_RENAME)))
+            rebuild = 1;
+        if (!e->is_dir && classify(e->path) > level)
+            level = classify(e->path);
+    }
+
+    if (rebuild) {
+        /* Directory contents changed: new files need descriptors, and
+         * the only way to see a new migration is its mtime */
+        time_t sql = w->poll_sql;
+        if (kqueue_rebuild(w) != 0) {
+            use_polling(w);
+            return HL_WATCH_RESTART;
+        }
+        w->poll_sql = scan(w->root).sql;
+        if (w->poll_sql > sql)
+            level = HL_WATCH_RESTART;
+        else if (level == HL_WATCH_NONE)
+            level = HL_WATCH_CODE;
+    }
+    return level;
+}
+
+#endif /* HL_WATCH_KQUEUE */
+
+/* ── Public API ───────────────────────────────────────────────────── */
+
+int hl_watch_open(HlWatch *w, const char *dir)
+{
+    memset(w, 0, sizeof(*w));
+    w->fd = -1;
+    w->root = strdup(dir);
+    if (!w->root)
+        return -1;
+
+#if defined(HL_WATCH_INOTIFY)
+    w->fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (w->fd >= 0 && walk(w, w->root, inotify_add_fn, NULL) == 0) {
+        w->backend = "inotify";
+        return 0;
+    }
+#elif defined(HL_WATCH_KQUEUE)
+    w->fd = kqueue();
+    if (w->fd >= 0 && kqueue_rebuild(w) == 0) {
+        w->backend = "kqueue";
+        w->poll_sql = scan(w->root).sql;
+        return 0;
+    }
+#endif
+
+    use_polling(w);
+    return 0;
+}
+
+int hl_watch_wait(HlWatch *w, int timeout_ms, int debounce_ms)
+{
+    if (w->fd < 0)
+        return poll_wait(w, timeout_ms, debounce_ms);
+
+#if defined(HL_WATCH_INOTIFY)
+    struct pollfd pfd = { .fd = w->fd, .events = POLLIN };
+    int rc = poll(&pfd, 1, timeout_ms);
+    if (rc <= 0)
+        return (rc == 0 || errno == EINTR) ? HL_WATCH_NONE : -1;
+
+    int level = inotify_read(w);
+    for (;;) {
+        if (level < 0 || w->fd < 0)
+            return level;
+        rc = poll(&pfd, 1, debounce_ms);
+        if (rc <= 0)
+            return level;   /* quiet (or interrupted): report */
+        int more = inotify_read(w);
+        if (more < 0)
+            return -1;
+        if (more > level)
+            level = more;
+    }
+#elif defined(HL_WATCH_KQUEUE)
+    int level = kqueue_read(w, timeout_ms);
+    if (level <= 0)
+        return level;
+    for (;;) {
+        if (w->fd < 0)
+            return level;
+        int more = kqueue_read(w, debounce_ms);
+        if (more <= 0)
+            return more < 0 ? -1 : level;
+        if (more > level)
+            level = more;
+    }
+#else
+    (void)debounce_ms;
+    return -1;
+#endif
+}
+
+void hl_watch_close(HlWatch *w)
+{
+    entries_clear(w);
+    free(w->entries);
+    w->entries = NULL;
+    w->cap = 0;
+    if (w->fd >= 0)
+        close(w->fd);
+    w->fd = -1;
+    free(w->root);
+    w->root = NULL;
+}
@@ -0,0 +1,113 @@
+/*
+ * zygote.c — Fork-from-warm runtime instances
+ *
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#include "hull/zygote.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+static int write_all(int fd, const void *buf, size_t len)
+{
+    const char *p = buf;
+    while (len > 0) {
+        ssize_t n = write(fd, p, len);
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            return -1;
+        }
+        p += n;
+        len -= (size_t)n;
+    }
+    return 0;
+}
+
+static size_t read_all(int fd, void *buf, size_t len)
+{
+    char *p = buf;
+    size_t got = 0;
+    while (got < len) {
+        ssize_t n = read(fd, p + got, len - got);
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            break;
+        }
+        if (n == 0)
+            break;
+        got += (size_t)n;
+    }
+    return got;
+}
+
+int hl_zygote_spawn(HlZygoteChild *child, HlZygoteFn fn, void *ctx,
+                    size_t result_size)
+{
+    int fds[2];
+    if (pipe(fds) != 0)
+        return -1;
+
+    /* Anything still buffered would otherwise be written twice */
+    fflush(NULL);
+
+    pid_t pid = fork();
+    if (pid < 0) {
+        close(fds[0]);
+        close(fds[1]);
+        return -1;
+    }
+
+    if (pid == 0) {
+        close(fds[0]);
+        void *result = result_size > 0 ? calloc(1, result_size) : NULL;
+        int rc = 1;
+        if (result || result_size == 0) {
+            rc = fn(ctx, result, result_size);
+            if (result_size > 0 && write_all(fds[1], result, result_size) != 0)
+                rc = 1;
+        }
+        free(result);
+        close(fds[1]);
+        fflush(NULL);
+        /* _exit: skip atexit handlers and destructors owned by the zygote */
+        _exit(rc & 0xff);
+    }
+
+    close(fds[1]);
+    child->pid = pid;
+    child->fd  = fds[0];
+    return 0;
+}
+
+int hl_zygote_wait(HlZygoteChild *child, void *result, size_t result_size)
+{
+    size_t got = result_size > 0 ? read_all(child->fd, result, result_size) : 0;
+    close(child->fd);
+    child->fd = -1;
+
+    int status = 0;
+    while (waitpid(child->pid, &status, 0) < 0) {
+        if (errno != EINTR)
+            return -1;
+    }
+    child->pid = -1;
+
+    if (!WIFEXITED(status) || got != result_size)
+        return -1;
+    return WEXITSTATUS(status);
+}
+
+int hl_zygote_run(HlZygoteFn fn, void *ctx, void *result, size_t result_size)
+{
+    HlZygoteChild child;
+    if (hl_zygote_spawn(&child, fn, ctx, result_size) != 0)
+        return -2;
+    return hl_zygote_wait(&child, result, result_size);
+}
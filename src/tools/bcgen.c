@@ -0,0 +1,185 @@
+/*
+ * bcgen.c — Host-side bytecode generator for embedded stdlib modules
+ *
+ * Built with HOSTCC against the vendored interpreter sources and run
+ * at `make` time to precompile stdlib modules before they are xxd'd
+ * into the stdlib registry. Not linked into hull itself.
+ *
+ * Usage:
+ *   bcgen lua <chunkname> <input.lua> <output.luac>
+ *   bcgen js  <modname>   <input.js>  <output.jsc>
+ *
+ * The name must match the runtime VFS entry name ("hull.json",
+ * "hull:verify") so error messages and tracebacks are identical to
+ * source loading. For JS the module name is baked into the bytecode and
+ * QuickJS dedups loaded modules by it. Debug info is kept.
+ *
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#include "lua.h"
+#include "lauxlib.h"
+#include "quickjs.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static char *read_file(const char *path, size_t *out_len)
+{
+    FILE *f = fopen(path, "rb");
+    if (!f)
+        return NULL;
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    if (size < 0) {
+        fclose(f);
+        return NULL;
+    }
+    char *buf = malloc((size_t)size + 1);
+    if (!buf) {
+        fclose(f);
+        return NULL;
+    }
+    size_t n = fread(buf, 1, (size_t)size, f);
+    fclose(f);
+    buf[n] = '\0';
+    *out_len = n;
+    return buf;
+}
+
+static int file_writer(lua_State *L, const void *p, size_t sz, void *ud)
+{
+    (void)L;
+    return fwrite(p, 1, sz, (FILE *)ud) == sz ? 0 : 1;
+}
+
+static int gen_lua(const char *chunkname, const char *in, const char *out)
+{
+    size_t len = 0;
+    char *src = read_file(in, &len);
+    if (!src) {
+        fprintf(stderr, "bcgen: cannot read %s\n", in);
+        return 1;
+    }
+
+    lua_State *L = luaL_newstate();
+    if (!L) {
+        free(src);
+        fprintf(stderr, "bcgen: out of memory\n");
+        return 1;
+    }
+
+    int rc = 1;
+    if (luaL_loadbufferx(L, src, len, chunkname, "t") != LUA_OK) {
+        fprintf(stderr, "bcgen: %s\n", lua_tostring(L, -1));
+        goto done;
+    }
+
+    FILE *f = fopen(out, "wb");
+    if (!f) {
+        fprintf(stderr, "bcgen: cannot write %s\n", out);
+        goto done;
+    }
+    int werr = lua_dump(L, file_writer, f, 0);
+    if (fclose(f) != 0 || werr != 0) {
+        fprintf(stderr, "bcgen: failed to write %s\n", out);
+        remove(out);
+        goto done;
+    }
+    rc = 0;
+
+done:
+    lua_close(L);
+    free(src);
+    return rc;
+}
+
+/* Compiling a module resolves its imports; satisfy them with empty
+ * native modules — only the importing module is serialized. */
+static int dummy_module_init(JSContext *ctx, JSModuleDef *m)
+{
+    (void)ctx;
+    (void)m;
+    return 0;
+}
+
+static JSModuleDef *dummy_module_loader(JSContext *ctx, const char *name,
+                                        void *opaque)
+{
+    (void)opaque;
+    return JS_NewCModule(ctx, name, dummy_module_init);
+}
+
+static int gen_js(const char *modname, const char *in, const char *out)
+{
+    size_t len = 0;
+    /* read_file NUL-terminates, as the QuickJS lexer requires */
+    char *src = read_file(in, &len);
+    if (!src) {
+        fprintf(stderr, "bcgen: cannot read %s\n", in);
+        return 1;
+    }
+
+    JSRuntime *rt = JS_NewRuntime();
+    JSContext *ctx = rt ? JS_NewContext(rt) : NULL;
+    if (!ctx) {
+        if (rt) JS_FreeRuntime(rt);
+        free(src);
+        fprintf(stderr, "bcgen: out of memory\n");
+        return 1;
+    }
+    JS_SetModuleLoaderFunc(rt, NULL, dummy_module_loader, NULL);
+
+    int rc = 1;
+    uint8_t *bc = NULL;
+    size_t bc_len = 0;
+    JSValue mod = JS_Eval(ctx, src, len, modname,
+                          JS_EVAL_TYPE_MODULE | JS_EVAL_FLAG_COMPILE_ONLY);
+    if (JS_IsException(mod)) {
+        JSValue exc = JS_GetException(ctx);
+        const char *msg = JS_ToCString(ctx, exc);
+        fprintf(stderr, "bcgen: %s: %s\n", modname, msg ? msg : "compile error");
+        if (msg) JS_FreeCString(ctx, msg);
+        JS_FreeValue(ctx, exc);
+        goto done;
+    }
+    bc = JS_WriteObject(ctx, &bc_len, mod, JS_WRITE_OBJ_BYTECODE);
+    JS_FreeValue(ctx, mod);
+    if (!bc) {
+        fprintf(stderr, "bcgen: failed to serialize %s\n", modname);
+        goto done;
+    }
+
+    FILE *f = fopen(out, "wb");
+    if (!f) {
+        fprintf(stderr, "bcgen: cannot write %s\n", out);
+        goto done;
+    }
+    size_t n = fwrite(bc, 1, bc_len, f);
+    if (fclose(f) != 0 || n != bc_len) {
+        fprintf(stderr, "bcgen: failed to write %s\n", out);
+        remove(out);
+        goto done;
+    }
+    rc = 0;
+
+done:
+    if (bc) js_free(ctx, bc);
+    JS_FreeContext(ctx);
+    JS_FreeRuntime(rt);
+    free(src);
+    return rc;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc == 5 && strcmp(argv[1], "lua") == 0)
+        return gen_lua(argv[2], argv[3], argv[4]);
+    if (argc == 5 && strcmp(argv[1], "js") == 0)
+        return gen_js(argv[2], argv[3], argv[4]);
+
+    fprintf(stderr, "usage: bcgen lua|js <name> <input> <output>\n");
+    return 2;
+}
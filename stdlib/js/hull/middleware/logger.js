@@ -1,11 +1,13 @@
 /*
- * hull:middleware:logger -- Request logging middleware (logfmt)
+ * hull:middleware:logger -- Request logging middleware (logfmt or JSON)
  *
- * Logs incoming requests as single-line key=value pairs (logfmt).
+ * Logs incoming requests as single-line key=value pairs (logfmt), or as
+ * one JSON object per line with opts.format = "json".
  * Sets X-Request-ID header for request tracing.
  *
  * logger.generateId()              - hex counter string for request ID
  * logger.formatLine(entries)       - key=value pairs -> single string
+ * logger.formatJson(entries)       - key/value pairs -> JSON object string
  * logger.shouldSkip(path, skip)    - exact-match path check
  * logger.middleware(opts)          - returns middleware function
  *
@@ -44,6 +46,17 @@ function formatLine(entries) {
     return parts.join(" ");
 }
 
+/* Numbers stay numbers; key order follows entries */
+function formatJson(entries) {
+    const parts = [];
+    for (let i = 0; i < entries.length; i++) {
+        const v = entries[i][1];
+        const enc = (typeof v === "number" && isFinite(v)) ? String(v) : JSON.stringify(String(v));
+        parts.push(JSON.stringify(String(entries[i][0])) + ":" + enc);
+    }
+    return "{" + parts.join(",") + "}";
+}
+
 function shouldSkip(path, skipList) {
     if (!skipList) return false;
     for (let i = 0; i < skipList.length; i++) {
@@ -56,6 +69,7 @@ function middleware(opts) {
     const o = opts || {};
     const skip = o.skip || null;
     const includeHeaders = o.include_headers || null;
+    const asJson = o.format === "json";
 
     return function loggerMiddleware(req, res) {
         if (shouldSkip(req.path, skip))
@@ -83,11 +97,16 @@ function middleware(opts) {
             }
         }
 
-        log.info("req " + formatLine(entries));
+        if (asJson) {
+            entries.unshift(["msg", "req"]);
+            log.info(formatJson(entries));
+        } else {
+            log.info("req " + formatLine(entries));
+        }
 
         return 0;
     };
 }
 
-const logger = { generateId, formatLine, shouldSkip, middleware };
+const logger = { generateId, formatLine, formatJson, shouldSkip, middleware };
 export { logger };
@@ -18,26 +18,47 @@
  *       idempotencyKey: `evt-${eventId}-wh-${wh.id}`,
  *   });
  *
+ *   // Email: destination is the recipient, payload the rest of the
+ *   // message. flush() sends all due emails over one SMTP session.
+ *   outbox.init({ smtp: { host: "smtp.example.com", port: 587,
+ *                         username: "apikey", password: pass, tls: true } });
+ *   outbox.enqueue({
+ *       kind: "smtp",
+ *       destination: user.email,
+ *       payload: JSON.stringify({ from: "noreply@example.com",
+ *                                 subject: "Welcome", body: text }),
+ *   });
+ *
  *   // After handler returns (or explicitly):
  *   outbox.flush();
  *
+ * With `hull --outbox-workers N`, "webhook" and "http" rows are delivered
+ * by a native dispatcher off the request path; flush() then only handles
+ * the other kinds and wakes the dispatcher.
+ *
  * SPDX-License-Identifier: AGPL-3.0-or-later
  */
 
 import { db } from "hull:db";
 import { http } from "hull:http";
+import { smtp } from "hull:smtp";
 import { time } from "hull:time";
 import { json } from "hull:json";
+import { _outbox } from "hull:_outbox";
 
 let maxAttempts = 5;
+let smtpConn = null;
 
 /**
  * Initialize the outbox table.
- * @param {Object} opts - Options: maxAttempts (default 5)
+ * @param {Object} opts - Options: maxAttempts (default 5), smtp (connection
+ *   for kind "smtp" items: host, port, username, password, tls — as for
+ *   smtp.send)
  */
 function init(opts) {
     const o = opts || {};
     if (o.maxAttempts !== undefined) maxAttempts = o.maxAttempts;
+    if (o.smtp) smtpConn = o.smtp;
 
     db.exec(
         "CREATE TABLE IF NOT EXISTS _hull_outbox (" +
@@ -72,8 +93,9 @@ function init(opts) {
  *
  * @param {Object} opts
  * @param {string} opts.kind - "webhook", "http", "smtp"
- * @param {string} opts.destination - URL or address
- * @param {string} opts.payload - string body
+ * @param {string} opts.destination - URL or address (the recipient for "smtp")
+ * @param {string} opts.payload - string body (for "smtp", JSON with from,
+ *   subject, body and optionally content_type, reply_to, cc)
  * @param {string} opts.headers - JSON-encoded headers (optional)
  * @param {string} opts.idempotencyKey - unique key for dedup (optional)
  * @param {number} opts.maxAttempts - override default (optional)
@@ -130,6 +152,52 @@ function deliverItem(item) {
     return [false, "unsupported outbox kind: " + item.kind];
 }
 
+/**
+ * Deliver every "smtp" item of a flush in one smtp.sendMany batch.
+ * @returns {Object} index in items → [success, errorMessage]
+ */
+function deliverSmtp(items) {
+    const outcomes = {};
+    const msgs = [];
+    const index = [];
+
+    for (let i = 0; i < items.length; i++) {
+        const item = items[i];
+        if (item.kind !== "smtp") continue;
+        let decoded = null;
+        try {
+            decoded = json.decode(item.payload);
+        } catch (e) {
+            decoded = null;
+        }
+        if (!smtpConn) {
+            outcomes[i] = [false, "outbox smtp not configured"];
+        } else if (!decoded || typeof decoded !== "object") {
+            outcomes[i] = [false, "invalid smtp payload"];
+        } else {
+            decoded.to = item.destination;
+            msgs.push(decoded);
+            index.push(i);
+        }
+    }
+
+    if (msgs.length > 0) {
+        let results = null, error = null;
+        try {
+            results = smtp.sendMany(smtpConn, msgs);
+        } catch (e) {
+            error = String(e);
+        }
+        for (let n = 0; n < index.length; n++) {
+            outcomes[index[n]] = results
+                ? [results[n].ok, results[n].error || null]
+                : [false, error];
+        }
+    }
+
+    return outcomes;
+}
+
 /**
  * Compute exponential backoff delay (seconds) for attempt N.
  * 2^attempt * 10 seconds, capped at 1 hour.
@@ -142,6 +210,7 @@ function backoffDelay(attempt) {
 
 /**
  * Flush pending outbox items. Delivers items where next_attempt_at <= now.
+ * While the native dispatcher runs, "webhook"/"http" items are left to it.
  * @param {Object} opts - Options: limit (max items, default 50)
  * @returns {{ delivered: number, failed: number, retried: number }}
  */
@@ -150,17 +219,26 @@ function flush(opts) {
     const limit = o.limit || 50;
     const now = time.now();
 
+    let kinds = "";
+    if (_outbox.native()) {
+        _outbox.wake();
+        kinds = " AND kind NOT IN ('webhook', 'http')";
+    }
+
     const items = db.query(
         "SELECT id, kind, destination, payload, headers, idempotency_key, attempts, max_attempts " +
-        "FROM _hull_outbox WHERE state = 'pending' AND next_attempt_at <= ? ORDER BY id LIMIT ?",
+        "FROM _hull_outbox WHERE state = 'pending' AND next_attempt_at <= ?" + kinds +
+        " ORDER BY id LIMIT ?",
         [now, limit]
     );
 
     let delivered = 0, failed = 0, retried = 0;
 
+    const smtpOutcomes = deliverSmtp(items);
+
     for (let i = 0; i < items.length; i++) {
         const item = items[i];
-        const [ok, err] = deliverItem(item);
+        const [ok, err] = smtpOutcomes[i] || deliverItem(item);
 
         if (ok) {
             db.exec(
@@ -53,6 +53,22 @@ test("formatLine quotes values with spaces", () => {
     assertEq(line, 'ua="Mozilla Firefox"');
 });
 
+test("formatJson keeps order and number types", () => {
+    const line = logger.formatJson([
+        ["msg", "req"],
+        ["path", "/api"],
+        ["body_in", 12],
+    ]);
+    assertEq(line, '{"msg":"req","path":"/api","body_in":12}');
+});
+
+test("formatJson escapes strings", () => {
+    const line = logger.formatJson([
+        ["ua", 'say "hi"\n\u0001'],
+    ]);
+    assertEq(line, '{"ua":"say \\"hi\\"\\n\\u0001"}');
+});
+
 // ── shouldSkip ───────────────────────────────────────────────────────
 
 test("shouldSkip matches exact path", () => {
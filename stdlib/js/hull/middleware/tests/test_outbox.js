@@ -116,6 +116,21 @@ test("flush processes pending items", () => {
     assertEq(typeof result.retried, "number", "has retried count");
 });
 
+test("flush retries smtp items when smtp is not configured", () => {
+    db.exec("DELETE FROM _hull_outbox");
+
+    outbox.enqueue({
+        kind: "smtp",
+        destination: "user@example.com",
+        payload: JSON.stringify({ from: "a@example.com", subject: "Hi", body: "x" }),
+    });
+
+    const result = outbox.flush();
+    assertEq(result.retried, 1);
+    const rows = db.query("SELECT last_error FROM _hull_outbox");
+    assertEq(rows[0].last_error, "outbox smtp not configured");
+});
+
 // ── stats ───────────────────────────────────────────────────────────
 
 test("stats returns counts by state", () => {
@@ -6,6 +6,12 @@
  * template.compile(name)                - returns compiled function
  * template.clearCache()                 - clear compiled function cache
  *
+ * Templates compile to a bytecode program rendered natively (shared with
+ * the Lua runtime, see cap/template.h). Programs precompiled by
+ * `hull build` ("templates/<name>.tplc") are loaded directly, skipping
+ * lex/parse/emit. Compiled functions are kept in an LRU cache of
+ * MAX_CACHE_SIZE entries.
+ *
  * Syntax:
  *   {{ var }}              HTML-escaped output
  *   {{ var.path }}         dot path lookup (nil-safe)
@@ -18,7 +24,7 @@
  *   {% elif not var %}     negated else-if
  *   {% else %}             else
  *   {% end %}              end block
- *   {% for item in list %} iterate array
+ *   {% for item in list %} iterate an array or other iterable
  *   {% for key, val in obj %} iterate key/value pairs
  *   {% block name %}       define overridable block
  *   {% extends "name" %}   inherit from parent template
@@ -46,25 +52,15 @@ function validateIdent(s, context) {
     }
 }
 
-// ── HTML escape ──────────────────────────────────────────────────────
+// ── Filters ─────────────────────────────────────────────────────────
 
-const escapeMap = {
-    "&": "&amp;",
-    "<": "&lt;",
-    ">": "&gt;",
-    '"': "&quot;",
-    "'": "&#39;",
-    "`": "&#96;",
+// Filter ids understood by the native renderer (cap/template.h). The
+// functions below are called back for json and for values outside the
+// native fast paths; `raw` is resolved at compile time.
+const FILTER_IDS = {
+    upper: 1, lower: 2, trim: 3, length: 4, default: 5, json: 6,
 };
 
-function htmlEscape(s) {
-    if (s == null) return "";
-    s = String(s);
-    return s.replace(/[&<>"'`]/g, (ch) => escapeMap[ch]);
-}
-
-// ── Built-in filters ────────────────────────────────────────────────
-
 const filters = {
     upper(val) { return String(val ?? "").toUpperCase(); },
     lower(val) { return String(val ?? "").toLowerCase(); },
@@ -79,7 +75,6 @@ const filters = {
         return val;
     },
     json(val) { return JSON.stringify(val).replace(/</g, "\\u003c"); },
-    raw(val) { return val; },
 };
 
 // ── Lexer ────────────────────────────────────────────────────────────
@@ -363,190 +358,258 @@ function resolveIncludes(ast, loadFn, visited, depth) {
     return result;
 }
 
-// ── JS code generator ───────────────────────────────────────────────
+// ── Bytecode emitter ────────────────────────────────────────────────
+
+// Programs are executed by the native renderer shared with the Lua
+// runtime; the format is documented in include/hull/cap/template.h.
+// Register 0 holds the data object, loop variables get fixed registers
+// and expression temporaries sit above the innermost loop's registers.
+
+const OP_END = 0, OP_TEXT = 1, OP_GET = 2, OP_STR = 3, OP_NIL = 4;
+const OP_FILTER = 5, OP_OUT = 6, OP_JMPF = 7, OP_JMPT = 8, OP_JMP = 9, OP_NEXT = 10;
+const NO_REG = 0xFF;
+const TPL_VERSION = 1;
+
+// Append the UTF-8 encoding of s (lone surrogates become U+FFFD)
+function pushUtf8(out, s) {
+    for (let i = 0; i < s.length; i++) {
+        let c = s.charCodeAt(i);
+        if (c >= 0xD800 && c <= 0xDBFF && i + 1 < s.length) {
+            const d = s.charCodeAt(i + 1);
+            if (d >= 0xDC00 && d <= 0xDFFF) {
+                c = 0x10000 + ((c - 0xD800) << 10) + (d - 0xDC00);
+                i++;
+            }
+        }
+        if (c >= 0xD800 && c <= 0xDFFF) c = 0xFFFD;
+
+        if (c < 0x80) {
+            out.push(c);
+        } else if (c < 0x800) {
+            out.push(0xC0 | (c >> 6), 0x80 | (c & 0x3F));
+        } else if (c < 0x10000) {
+            out.push(0xE0 | (c >> 12), 0x80 | ((c >> 6) & 0x3F), 0x80 | (c & 0x3F));
+        } else {
+            out.push(0xF0 | (c >> 18), 0x80 | ((c >> 12) & 0x3F),
+                     0x80 | ((c >> 6) & 0x3F), 0x80 | (c & 0x3F));
+        }
+    }
+}
 
-// Generate optional-chaining dot path access
-// "user.name" → "__d.user?.name"
-// "title" → "__d.title"
-// If the first segment is a loop-local variable, use it directly.
-function genDotPath(path, prefix, localsSet) {
-    prefix = prefix || "__d";
-    const parts = path.split(".");
+function emitProgram(ast) {
+    // Header: "HTPL", version, nregs (patched at the end), reserved
+    const code = [0x48, 0x54, 0x50, 0x4C, TPL_VERSION, 0, 0, 0];
+    let nregs = 1;
+    const locals = Object.create(null);  // loop variable name -> register
 
-    if (parts.length === 0) throw new Error("empty expression in template");
-    for (const p of parts) {
-        validateIdent(p, "dot path '" + path + "'");
+    function reg(r) {
+        if (r >= NO_REG) throw new Error("template too deeply nested");
+        if (r >= nregs) nregs = r + 1;
+        return r;
     }
 
-    // Check if first segment is a loop-local variable
-    if (localsSet && localsSet[parts[0]]) {
-        if (parts.length === 1) return parts[0];
-        return parts[0] + parts.slice(1).map(p => "?." + p).join("");
+    function u16(v) { code.push(v & 0xFF, (v >>> 8) & 0xFF); }
+    function u32(v) {
+        code.push(v & 0xFF, (v >>> 8) & 0xFF, (v >>> 16) & 0xFF, (v >>> 24) & 0xFF);
     }
 
-    if (parts.length === 1) return prefix + "." + parts[0];
-    return prefix + "." + parts[0] + parts.slice(1).map(p => "?." + p).join("");
-}
+    // u32 jump target placeholder; returns its offset
+    function placeholder() {
+        const at = code.length;
+        u32(0);
+        return at;
+    }
 
-function genExpr(exprInfo, escaped, localsSet) {
-    let code = genDotPath(exprInfo.var, null, localsSet);
+    function patch(at, target) {
+        code[at] = target & 0xFF;
+        code[at + 1] = (target >>> 8) & 0xFF;
+        code[at + 2] = (target >>> 16) & 0xFF;
+        code[at + 3] = (target >>> 24) & 0xFF;
+    }
 
-    for (const f of exprInfo.filters) {
-        if (f.name !== "raw" && !filters[f.name]) {
-            throw new Error("unknown template filter: " + f.name);
-        }
-        if (f.name === "raw") {
-            escaped = false;
-        } else if (f.arg) {
-            let arg = f.arg.trim();
-            if (arg[0] === '"') {
-                if (!/^"[^"]*"$/.test(arg)) {
-                    throw new Error("invalid filter argument (unbalanced quotes): " + arg);
-                }
-                code = "__f." + f.name + "(" + code + ", " + arg + ")";
-            } else if (arg[0] === "'") {
-                if (!/^'[^']*'$/.test(arg)) {
-                    throw new Error("invalid filter argument (unbalanced quotes): " + arg);
-                }
-                code = "__f." + f.name + "(" + code + ", " + arg + ")";
-            } else {
-                // Variable reference — validated by genDotPath
-                code = "__f." + f.name + "(" + code + ", " + genDotPath(arg, null, localsSet) + ")";
-            }
-        } else {
-            code = "__f." + f.name + "(" + code + ")";
-        }
+    function bytes(s, wide) {
+        const b = [];
+        pushUtf8(b, s);
+        if (wide) u32(b.length); else u16(b.length);
+        for (let i = 0; i < b.length; i++) code.push(b[i]);
     }
 
-    if (escaped) code = "__e(" + code + ")";
-    return code;
-}
+    // Dot path lookup into register dst (optional chaining). Returns the
+    // register holding the value — a loop variable's own register for "item".
+    function genPath(path, dst) {
+        const parts = path.split(".");
+        if (parts.length === 0) throw new Error("empty expression in template");
+        for (const p of parts) {
+            validateIdent(p, "dot path '" + path + "'");
+        }
 
-function genCond(cond, negated, localsSet) {
-    const path = genDotPath(cond.trim(), null, localsSet);
-    return negated ? "!" + path : path;
-}
+        let obj = 0, first = 0;
+        if (locals[parts[0]] !== undefined) {
+            obj = locals[parts[0]];
+            first = 1;
+        }
+        if (first >= parts.length) return obj;
+        reg(dst);
+        for (let i = first; i < parts.length; i++) {
+            code.push(OP_GET, dst, obj);
+            bytes(parts[i], false);
+            obj = dst;
+        }
+        return dst;
+    }
 
-function jsQuote(s) {
-    return JSON.stringify(s);
-}
+    // Path + filter chain into register t (t + 1 holds a filter argument)
+    function genExpr(exprInfo, escaped, t) {
+        let r = genPath(exprInfo.var, t);
 
-function codegen(ast) {
-    const lines = [];
-    let indent = 1;
-    const localsSet = Object.create(null);  // track loop-local variable names
+        for (const f of exprInfo.filters) {
+            if (f.name !== "raw" && !FILTER_IDS[f.name]) {
+                throw new Error("unknown template filter: " + f.name);
+            }
+            if (f.name === "raw") {
+                escaped = false;
+                continue;
+            }
+            let a = NO_REG;
+            if (f.arg) {
+                const arg = f.arg.trim();
+                if (arg[0] === '"' || arg[0] === "'") {
+                    const re = arg[0] === '"' ? /^"[^"]*"$/ : /^'[^']*'$/;
+                    if (!re.test(arg)) {
+                        throw new Error("invalid filter argument (unbalanced quotes): " + arg);
+                    }
+                    if (arg.includes("\\")) {
+                        throw new Error("invalid filter argument (backslash not allowed): " + arg);
+                    }
+                    a = reg(t + 1);
+                    code.push(OP_STR, a);
+                    bytes(arg.slice(1, -1), true);
+                } else {
+                    // Variable reference — validated by genPath
+                    a = genPath(arg, t + 1);
+                }
+            }
+            code.push(OP_FILTER, FILTER_IDS[f.name], reg(t), r, a);
+            r = t;
+        }
 
-    function emit(line) {
-        lines.push("  ".repeat(indent) + line);
+        return [r, escaped];
     }
 
-    function genBody(nodes) {
+    function genBody(nodes, top) {
         for (const node of nodes) {
             if (node.kind === "text") {
-                if (node.value.length > 0) emit("__p.push(" + jsQuote(node.value) + ");");
-            } else if (node.kind === "var") {
-                emit("__p.push(" + genExpr(node.expr, true, localsSet) + ");");
-            } else if (node.kind === "raw") {
-                emit("__p.push(String(" + genExpr(node.expr, false, localsSet) + " ?? \"\"));");
-            } else if (node.kind === "if") {
-                for (let i = 0; i < node.branches.length; i++) {
-                    const b = node.branches[i];
-                    const keyword = i === 0 ? "if" : "} else if";
-                    emit(keyword + " (" + genCond(b.cond, b.negated, localsSet) + ") {");
-                    indent++;
-                    genBody(b.body);
-                    indent--;
+                if (node.value.length > 0) {
+                    code.push(OP_TEXT);
+                    bytes(node.value, true);
                 }
-                if (node.elseBody) {
-                    emit("} else {");
-                    indent++;
-                    genBody(node.elseBody);
-                    indent--;
+            } else if (node.kind === "var" || node.kind === "raw") {
+                const [r, escaped] = genExpr(node.expr, node.kind === "var", top);
+                code.push(OP_OUT, r, escaped ? 1 : 0);
+            } else if (node.kind === "if") {
+                const ends = [];
+                for (const b of node.branches) {
+                    const r = genPath(b.cond.trim(), top);
+                    code.push(b.negated ? OP_JMPT : OP_JMPF, r);
+                    const skip = placeholder();
+                    genBody(b.body, top);
+                    code.push(OP_JMP);
+                    ends.push(placeholder());
+                    patch(skip, code.length);
                 }
-                emit("}");
-            } else if (node.kind === "for") {
-                emit("for (const " + node.var + " of (" + genDotPath(node.expr, null, localsSet) + " || [])) {");
-                localsSet[node.var] = true;
-                indent++;
-                genBody(node.body);
-                indent--;
-                delete localsSet[node.var];
-                emit("}");
-            } else if (node.kind === "for_kv") {
-                emit("for (const [" + node.key + ", " + node.val + "] of Object.entries(" + genDotPath(node.expr, null, localsSet) + " || {})) {");
-                localsSet[node.key] = true;
-                localsSet[node.val] = true;
-                indent++;
-                genBody(node.body);
-                indent--;
-                delete localsSet[node.key];
-                delete localsSet[node.val];
-                emit("}");
+                if (node.elseBody) genBody(node.elseBody, top);
+                for (const e of ends) patch(e, code.length);
+            } else if (node.kind === "for" || node.kind === "for_kv") {
+                // Registers: collection, iterator state (2), [key,] value
+                const kv = node.kind === "for_kv";
+                const coll = genPath(node.expr, top);
+                const state = reg(top + 1);
+                reg(top + 2);
+                const key = kv ? reg(top + 3) : NO_REG;
+                const val = reg(kv ? top + 4 : top + 3);
+
+                code.push(OP_NIL, state, OP_NIL, state + 1);
+                const head = code.length;
+                code.push(OP_NEXT, coll, state, key, val, kv ? 1 : 0);
+                const exit = placeholder();
+
+                const names = kv ? [node.key, node.val] : [node.var];
+                const regs = kv ? [key, val] : [val];
+                const saved = names.map(n => locals[n]);
+                names.forEach((n, i) => { locals[n] = regs[i]; });
+                genBody(node.body, val + 1);
+                names.forEach((n, i) => { locals[n] = saved[i]; });
+
+                code.push(OP_JMP);
+                u32(head);
+                patch(exit, code.length);
             } else if (node.kind === "block") {
-                genBody(node.body);
+                // Blocks are already resolved by inheritance; render their content
+                genBody(node.body, top);
             }
         }
     }
 
-    lines.push("(function(__d, __e, __f) {");
-    lines.push("  const __p = [];");
-    genBody(ast);
-    lines.push("  return __p.join(\"\");");
-    lines.push("})");
+    genBody(ast, 1);
+    code.push(OP_END);
+    code[5] = nregs;
 
-    return lines.join("\n");
+    return new Uint8Array(code).buffer;
 }
 
 // ── Compile + cache ─────────────────────────────────────────────────
 
-const cache = Object.create(null);
-let cacheCount = 0;
+// LRU cache: Map iteration order is insertion order, so re-inserting on
+// hit keeps the least recently used template first.
+const cache = new Map();
 
 function loadRaw(name) {
     return _template.loadRaw(name);
 }
 
-function compileSource(source, name) {
-    const tokens = lex(source);
-    let ast = parse(tokens);
+// Lex, parse, flatten inheritance/includes and emit a program
+function compileSource(source) {
+    let ast = parse(lex(source));
     ast = resolveInheritance(ast, loadRaw);
     ast = resolveIncludes(ast, loadRaw);
-    const code = codegen(ast);
-    const chunkName = name ? "template:" + name : "template";
-    return _template.compile(code, chunkName);
+    return _template.program(emitProgram(ast), filters);
 }
 
 function compile(name) {
-    if (cache[name]) return cache[name];
-
-    const source = loadRaw(name);
-    if (source == null) throw new Error("template not found: " + name);
+    let fn = cache.get(name);
+    if (fn) {
+        cache.delete(name);
+        cache.set(name, fn);
+        return fn;
+    }
 
-    // Evict cache if at capacity
-    if (cacheCount >= MAX_CACHE_SIZE) {
-        for (const k in cache) delete cache[k];
-        cacheCount = 0;
+    // Precompiled by hull build (inheritance and includes already flattened)
+    fn = _template.loadCompiled(name, filters);
+    if (!fn) {
+        const source = loadRaw(name);
+        if (source == null) throw new Error("template not found: " + name);
+        fn = compileSource(source);
     }
 
-    const fn = compileSource(source, name);
-    cache[name] = fn;
-    cacheCount++;
+    if (cache.size >= MAX_CACHE_SIZE) {
+        cache.delete(cache.keys().next().value);
+    }
+    cache.set(name, fn);
     return fn;
 }
 
 function render(name, data) {
     const fn = compile(name);
-    return fn(data || {}, htmlEscape, filters);
+    return fn(data || {});
 }
 
 function renderString(source, data) {
-    const fn = compileSource(source, null);
-    return fn(data || {}, htmlEscape, filters);
+    const fn = compileSource(source);
+    return fn(data || {});
 }
 
 function clearCache() {
-    for (const k in cache) delete cache[k];
-    cacheCount = 0;
+    cache.clear();
 }
 
 const template = { render, renderString, compile, clearCache };
@@ -135,6 +135,72 @@ local function xxd_data(varname, data)
     return table.concat(lines, "\n")
 end
 
+-- ── Lua bytecode ─────────────────────────────────────────────────────
+
+-- Precompile a Lua module to bytecode under its embedded entry name so
+-- runtime errors report the same chunkname as the source path.
+-- Returns the bytecode string, or nil if the source does not compile.
+local function compile_lua_module(path, entry_name)
+    local data = read_file(path)
+    if not data then return nil end
+    local bc, err = tool.compile_lua(data, entry_name)
+    if not bc then
+        tool.stderr("hull build: " .. tostring(err) .. "\n")
+        tool.exit(1)
+    end
+    return bc
+end
+
+-- Precompile a JS module to QuickJS bytecode. The module name is baked
+-- into the bytecode and must be the canonical runtime name ("./x.js").
+-- Returns nil when this hull binary was built without the JS runtime.
+local function compile_js_module(path, module_name)
+    if not tool.compile_js then return nil end
+    local data = read_file(path)
+    if not data then return nil end
+    local bc, err = tool.compile_js(data, module_name)
+    if not bc then
+        tool.stderr("hull build: " .. tostring(err) .. "\n")
+        tool.exit(1)
+    end
+    return bc
+end
+
+-- ── Template bytecode ────────────────────────────────────────────────
+
+-- Precompile every template to the runtime-neutral program executed by
+-- the native renderer (cap/template.c), shared by Lua and JS apps.
+-- Inheritance and includes are flattened at build time by the same
+-- hull.template engine the runtime uses, so the embedded
+-- "templates/<name>.tplc" entries render identically to compiling from
+-- source. A template that fails to compile is skipped with a warning; the
+-- runtime falls back to its source and reports the error on first
+-- render, as in dev mode. Returns { [name] = program }.
+local function compile_templates(app_dir, html_files, quiet)
+    local out = {}
+    local prefix = app_dir .. "/templates/"
+    if #html_files == 0 then return out end
+
+    local template = require("hull.template")
+    local function load_fn(name)
+        if name:sub(1, 1) == "/" or name:find("%.%.") then return nil end
+        return read_file(prefix .. name)
+    end
+
+    for _, path in ipairs(html_files) do
+        local name = path:sub(#prefix + 1)
+        local ok, prog = pcall(template.generate, name, load_fn)
+        if ok then
+            out[name] = prog
+        elseif not quiet then
+            tool.stderr("hull build: warning: template " .. name ..
+                        " not precompiled: " .. tostring(prog) .. "\n")
+        end
+    end
+
+    return out
+end
+
 -- ── Build steps ──────────────────────────────────────────────────────
 
 local function generate_app_registry(app_dir, files)
@@ -162,16 +228,36 @@ local function generate_app_registry(app_dir, files)
             '    { "%s", %s, sizeof(%s) },', entry_name, varname, varname)
     end
 
-    -- Lua modules: "./path" (no .lua extension)
+    -- Lua modules: "./path" (no .lua extension), plus precompiled
+    -- bytecode as "./path.luac" which the runtime prefers over source
     for _, path in ipairs(files.lua or {}) do
         local rel = path:sub(#app_dir + 2)
-        add_file(path, "./" .. rel:gsub("%.lua$", ""), "app_")
+        local entry_name = "./" .. rel:gsub("%.lua$", "")
+        add_file(path, entry_name, "app_")
+
+        local bc = compile_lua_module(path, entry_name)
+        local varname = "app_" .. rel:gsub("[/.]", "_") .. "c"
+        parts[#parts + 1] = xxd_data(varname, bc)
+        parts[#parts + 1] = ""
+        entries[#entries + 1] = string.format(
+            '    { "%s.luac", %s, sizeof(%s) },', entry_name, varname, varname)
     end
 
-    -- JS modules: "./path.js" (keep extension)
+    -- JS modules: "./path.js" (keep extension), plus precompiled
+    -- bytecode as "./path.jsc" when the JS runtime is available
     for _, path in ipairs(files.js or {}) do
         local rel = path:sub(#app_dir + 2)
         add_file(path, "./" .. rel, "app_js_")
+
+        local bc = compile_js_module(path, "./" .. rel)
+        if bc then
+            local base = rel:gsub("%.js$", "")
+            local varname = "app_js_" .. base:gsub("[/.]", "_") .. "_jsc"
+            parts[#parts + 1] = xxd_data(varname, bc)
+            parts[#parts + 1] = ""
+            entries[#entries + 1] = string.format(
+                '    { "./%s.jsc", %s, sizeof(%s) },', base, varname, varname)
+        end
     end
 
     -- JSON data: "./path.json" (keep extension)
@@ -180,11 +266,19 @@ local function generate_app_registry(app_dir, files)
         add_file(path, "./" .. rel, "app_")
     end
 
-    -- Templates: "templates/path" (relative from app_dir)
+    -- Templates: "templates/path" (relative from app_dir), plus
+    -- precompiled programs as "templates/path.tplc"
     for _, path in ipairs(files.html or {}) do
         local rel = path:sub(#app_dir + 2) -- e.g. "templates/base.html"
         add_file(path, rel, "tpl_")
     end
+    for name, prog in pairs(compile_templates(app_dir, files.html or {})) do
+        local varname = "tpl_templates_" .. name:gsub("[/.]", "_") .. "_tplc"
+        parts[#parts + 1] = xxd_data(varname, prog)
+        parts[#parts + 1] = ""
+        entries[#entries + 1] = string.format(
+            '    { "templates/%s.tplc", %s, sizeof(%s) },', name, varname, varname)
+    end
 
     -- Static files: "static/path" (relative from app_dir)
     for _, path in ipairs(files.static or {}) do
@@ -234,8 +328,18 @@ local function sign_app(app_dir, key_file, sign_ctx, files)
     local pk_data = read_file(pk_file)
     local pk_hex = pk_data and pk_data:match("^(%x+)") or ""
 
-    -- Compute file hashes (all embedded file types)
-    local file_hashes = {}
+    -- Collect every signed blob (all embedded file types), then hash them
+    -- as one batch — crypto.sha256_many spreads large batches across cores
+    local names, blobs = {}, {}
+    local function add(name, data)
+        if not data then
+            tool.stderr("hull build: cannot read " .. name .. "\n")
+            tool.exit(1)
+        end
+        names[#names + 1] = name
+        blobs[#blobs + 1] = data
+    end
+
     local all_lists = {
         files.js or {},
         files.json or {},
@@ -246,12 +350,31 @@ local function sign_app(app_dir, key_file, sign_ctx, files)
     }
     for _, list in ipairs(all_lists) do
         for _, path in ipairs(list) do
-            local data = read_file(path)
-            local rel = path:sub(#app_dir + 2)
-            file_hashes[rel] = crypto.sha256(data)
+            add(path:sub(#app_dir + 2), read_file(path))
         end
     end
 
+    -- Embedded bytecode is covered by the signature alongside its source
+    for _, path in ipairs(files.lua or {}) do
+        local rel = path:sub(#app_dir + 2):gsub("%.lua$", "")
+        add(rel .. ".luac", compile_lua_module(path, "./" .. rel))
+    end
+    for _, path in ipairs(files.js or {}) do
+        local rel = path:sub(#app_dir + 2)
+        local bc = compile_js_module(path, "./" .. rel)
+        if bc then
+            add(rel:gsub("%.js$", "") .. ".jsc", bc)
+        end
+    end
+    for name, prog in pairs(compile_templates(app_dir, files.templates or {}, true)) do
+        add("templates/" .. name .. ".tplc", prog)
+    end
+
+    local file_hashes = {}
+    for i, hash in ipairs(crypto.sha256_many(blobs)) do
+        file_hashes[names[i]] = hash
+    end
+
     -- Execute app to capture manifest
     local manifest = nil
     local entry = app_dir .. "/app.lua"
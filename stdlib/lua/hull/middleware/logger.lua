@@ -1,11 +1,13 @@
 --
--- hull.middleware.logger -- Request logging middleware (logfmt)
+-- hull.middleware.logger -- Request logging middleware (logfmt or JSON)
 --
--- Logs incoming requests as single-line key=value pairs (logfmt).
+-- Logs incoming requests as single-line key=value pairs (logfmt), or as
+-- one JSON object per line with opts.format = "json".
 -- Sets X-Request-ID header for request tracing.
 --
 -- logger.generate_id()            - hex counter string for request ID
 -- logger.format_line(entries)     - key=value pairs -> single string
+-- logger.format_json(entries)     - key/value pairs -> JSON object string
 -- logger.should_skip(path, skip)  - exact-match path check
 -- logger.middleware(opts)         - returns middleware function
 --
@@ -47,6 +49,30 @@ function logger.format_line(entries)
     return table.concat(parts, " ")
 end
 
+local json_escapes = {
+    ['"'] = '\\"', ["\\"] = "\\\\", ["\n"] = "\\n", ["\r"] = "\\r", ["\t"] = "\\t",
+}
+
+local function json_string(v)
+    return '"' .. v:gsub('[%c"\\]', function(c)
+        return json_escapes[c] or string.format("\\u%04x", c:byte())
+    end) .. '"'
+end
+
+--- Format a list of {key, value} pairs into a JSON object, in order.
+-- Numbers are written bare, everything else as a string.
+function logger.format_json(entries)
+    local parts = {}
+    for _, entry in ipairs(entries) do
+        local v = entry[2]
+        if type(v) ~= "number" or v ~= v or v == math.huge or v == -math.huge then
+            v = json_string(tostring(v))
+        end
+        parts[#parts + 1] = json_string(entry[1]) .. ":" .. tostring(v)
+    end
+    return "{" .. table.concat(parts, ",") .. "}"
+end
+
 --- Check whether a path is in the skip list (exact match).
 function logger.should_skip(path, skip_list)
     if not skip_list then return false end
@@ -59,10 +85,12 @@ end
 --- Create a logging middleware function for use with app.use().
 -- opts.skip: list of paths to skip (exact match)
 -- opts.include_headers: list of header names to include in log line
+-- opts.format: "logfmt" (default) or "json"
 function logger.middleware(opts)
     opts = opts or {}
     local skip = opts.skip
     local include_headers = opts.include_headers
+    local as_json = opts.format == "json"
 
     return function(req, res)
         if logger.should_skip(req.path, skip) then
@@ -89,7 +117,12 @@ function logger.middleware(opts)
             end
         end
 
-        log.info("req " .. logger.format_line(entries))
+        if as_json then
+            table.insert(entries, 1, { "msg", "req" })
+            log.info(logger.format_json(entries))
+        else
+            log.info("req " .. logger.format_line(entries))
+        end
 
         return 0
     end
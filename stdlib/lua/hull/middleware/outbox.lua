@@ -18,24 +18,45 @@
 --       idempotency_key = "evt-" .. event_id .. "-wh-" .. wh.id,
 --   })
 --
+--   -- Email: destination is the recipient, payload the rest of the
+--   -- message. flush() sends all due emails over one SMTP session.
+--   outbox.init({ smtp = { host = "smtp.example.com", port = 587,
+--                          username = "apikey", password = pass, tls = true } })
+--   outbox.enqueue({
+--       kind = "smtp",
+--       destination = user.email,
+--       payload = json.encode({ from = "noreply@example.com",
+--                               subject = "Welcome", body = text }),
+--   })
+--
 --   -- After handler returns (or explicitly):
 --   outbox.flush()
 --
+-- With `hull --outbox-workers N`, "webhook" and "http" rows are delivered
+-- by a native dispatcher off the request path; flush() then only handles
+-- the other kinds and wakes the dispatcher.
+--
 -- SPDX-License-Identifier: AGPL-3.0-or-later
 --
 
 local outbox = {}
 
 local _max_attempts = 5
+local _smtp_conn = nil
 
 --- Initialize the outbox table.
 -- opts.max_attempts: max delivery attempts before marking failed (default 5)
 -- opts.flush_after_request: auto-flush after each request (default false)
+-- opts.smtp: connection for kind = "smtp" items (host, port, username,
+--   password, tls — as for smtp.send)
 function outbox.init(opts)
     opts = opts or {}
     if opts.max_attempts then
         _max_attempts = opts.max_attempts
     end
+    if opts.smtp then
+        _smtp_conn = opts.smtp
+    end
     db.exec([[
         CREATE TABLE IF NOT EXISTS _hull_outbox (
             id              INTEGER PRIMARY KEY AUTOINCREMENT,
@@ -67,8 +88,9 @@ end
 -- Must be called inside a transaction (db.batch) to be atomic with state changes.
 --
 -- opts.kind: type of delivery ("webhook", "http", "smtp", etc.)
--- opts.destination: URL or address
--- opts.payload: string body
+-- opts.destination: URL or address (the recipient for "smtp")
+-- opts.payload: string body (for "smtp", JSON with from, subject, body and
+--   optionally content_type, reply_to, cc)
 -- opts.headers: JSON-encoded headers string (optional)
 -- opts.idempotency_key: unique key for dedup (optional but recommended)
 -- opts.max_attempts: override default max attempts (optional)
@@ -133,6 +155,42 @@ local function deliver_item(item)
     return false, "unsupported outbox kind: " .. tostring(item.kind)
 end
 
+--- Deliver every "smtp" item of a flush in one smtp.send_many batch.
+-- Returns { [index in items] = { ok = bool, error = string } }.
+local function deliver_smtp(items)
+    local outcomes = {}
+    local msgs = {}
+    local index = {}
+
+    for i, item in ipairs(items) do
+        if item.kind == "smtp" then
+            local dec_ok, decoded = pcall(json.decode, item.payload)
+            if not _smtp_conn then
+                outcomes[i] = { ok = false, error = "outbox smtp not configured" }
+            elseif not dec_ok or type(decoded) ~= "table" then
+                outcomes[i] = { ok = false, error = "invalid smtp payload" }
+            else
+                decoded.to = item.destination
+                msgs[#msgs + 1] = decoded
+                index[#msgs] = i
+            end
+        end
+    end
+
+    if #msgs > 0 then
+        local send_ok, results = pcall(smtp.send_many, _smtp_conn, msgs)
+        for n, i in ipairs(index) do
+            if send_ok then
+                outcomes[i] = results[n]
+            else
+                outcomes[i] = { ok = false, error = tostring(results) }
+            end
+        end
+    end
+
+    return outcomes
+end
+
 --- Compute exponential backoff delay (in seconds) for attempt N.
 -- 2^attempt * 10 seconds, capped at 1 hour.
 local function backoff_delay(attempt)
@@ -142,6 +200,7 @@ local function backoff_delay(attempt)
 end
 
 --- Flush pending outbox items. Delivers items where next_attempt_at <= now.
+-- While the native dispatcher runs, "webhook"/"http" items are left to it.
 -- opts.limit: max items to process per flush (default 50)
 -- Returns { delivered = N, failed = N, retried = N }
 function outbox.flush(opts)
@@ -149,8 +208,14 @@ function outbox.flush(opts)
     local limit = opts.limit or 50
     local now = time.now()
 
+    local kinds = ""
+    if _outbox.native() then
+        _outbox.wake()
+        kinds = " AND kind NOT IN ('webhook', 'http')"
+    end
+
     local items = db.query(
-        "SELECT id, kind, destination, payload, headers, idempotency_key, attempts, max_attempts FROM _hull_outbox WHERE state = 'pending' AND next_attempt_at <= ? ORDER BY id LIMIT ?",
+        "SELECT id, kind, destination, payload, headers, idempotency_key, attempts, max_attempts FROM _hull_outbox WHERE state = 'pending' AND next_attempt_at <= ?" .. kinds .. " ORDER BY id LIMIT ?",
         { now, limit }
     )
 
@@ -158,8 +223,16 @@ function outbox.flush(opts)
     local failed = 0
     local retried = 0
 
-    for _, item in ipairs(items) do
-        local ok, err = deliver_item(item)
+    local smtp_outcomes = deliver_smtp(items)
+
+    for i, item in ipairs(items) do
+        local ok, err
+        local outcome = smtp_outcomes[i]
+        if outcome then
+            ok, err = outcome.ok, outcome.error
+        else
+            ok, err = deliver_item(item)
+        end
 
         if ok then
             db.exec(
@@ -55,6 +55,22 @@ test("format_line quotes values with spaces", function()
     assert_eq(line, 'ua="Mozilla Firefox"')
 end)
 
+test("format_json keeps order and number types", function()
+    local line = logger.format_json({
+        { "msg", "req" },
+        { "path", "/api" },
+        { "body_in", 12 },
+    })
+    assert_eq(line, '{"msg":"req","path":"/api","body_in":12}')
+end)
+
+test("format_json escapes strings", function()
+    local line = logger.format_json({
+        { "ua", 'say "hi"\n\1' },
+    })
+    assert_eq(line, '{"ua":"say \\"hi\\"\\n\\u0001"}')
+end)
+
 -- ── should_skip ──────────────────────────────────────────────────────
 
 test("should_skip matches exact path", function()
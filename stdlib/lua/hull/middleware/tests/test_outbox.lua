@@ -108,6 +108,21 @@ test("flush processes pending items", function()
     assert(type(result.retried) == "number", "has retried count")
 end)
 
+test("flush retries smtp items when smtp is not configured", function()
+    db.exec("DELETE FROM _hull_outbox")
+
+    outbox.enqueue({
+        kind = "smtp",
+        destination = "user@example.com",
+        payload = json.encode({ from = "a@example.com", subject = "Hi", body = "x" }),
+    })
+
+    local result = outbox.flush()
+    assert_eq(result.retried, 1)
+    local rows = db.query("SELECT last_error FROM _hull_outbox")
+    assert_eq(rows[1].last_error, "outbox smtp not configured")
+end)
+
 -- ── stats ───────────────────────────────────────────────────────────
 
 test("stats returns counts by state", function()
@@ -5,6 +5,13 @@
 -- template.render_string(source, data)    - compile from string + render
 -- template.compile(name)                  - returns compiled function
 -- template.clear_cache()                  - clear compiled function cache
+-- template.generate(name, load_fn)        - bytecode program (build time)
+--
+-- Templates compile to a bytecode program rendered natively (shared with
+-- the JS runtime, see cap/template.h). Programs precompiled by
+-- `hull build` ("templates/<name>.tplc") are loaded directly, skipping
+-- lex/parse/emit. Compiled functions are kept in an LRU cache of
+-- MAX_CACHE_SIZE entries.
 --
 -- Syntax:
 --   {{ var }}              HTML-escaped output
@@ -44,58 +51,20 @@ local function validate_ident(s, context)
     end
 end
 
--- ── HTML escape ──────────────────────────────────────────────────────
+-- ── Filters ─────────────────────────────────────────────────────────
 
-local escape_map = {
-    ["&"] = "&amp;",
-    ["<"] = "&lt;",
-    [">"] = "&gt;",
-    ['"'] = "&quot;",
-    ["'"] = "&#39;",
+-- Filter ids understood by the native renderer (cap/template.h). Only
+-- `json` calls back into Lua; `raw` is resolved at compile time.
+local FILTER_IDS = {
+    upper = 1, lower = 2, trim = 3, length = 4, default = 5, json = 6,
 }
 
-local function html_escape(s)
-    if s == nil then return "" end
-    s = tostring(s)
-    return (s:gsub("[&<>\"']", escape_map))
-end
-
--- ── Built-in filters ────────────────────────────────────────────────
-
 local filters = {}
 
-function filters.upper(val)
-    return tostring(val or ""):upper()
-end
-
-function filters.lower(val)
-    return tostring(val or ""):lower()
-end
-
-function filters.trim(val)
-    return tostring(val or ""):match("^%s*(.-)%s*$")
-end
-
-function filters.length(val)
-    if type(val) == "table" then return #val end
-    return #tostring(val or "")
-end
-
-function filters.default(val, fallback)
-    if val == nil or val == false or val == "" then
-        return fallback or ""
-    end
-    return val
-end
-
 function filters.json(val)
     return json.encode(val)
 end
 
-function filters.raw(val)
-    return val
-end
-
 -- ── Lexer ────────────────────────────────────────────────────────────
 
 -- Token types
@@ -493,267 +462,306 @@ local function resolve_includes(ast, load_fn, visited, depth)
     return result
 end
 
--- ── Lua code generator ──────────────────────────────────────────────
+-- ── Bytecode emitter ────────────────────────────────────────────────
 
--- Generate nil-safe dot path access for Lua
--- "user.name" → "(__d.user and __d.user.name)"
--- "title" → "__d.title"
--- If the first segment is a loop-local variable, use it directly instead of __d.
-local function gen_dot_path(path, prefix, locals_set)
-    prefix = prefix or "__d"
-    local parts = {}
-    for part in path:gmatch("[^.]+") do
-        validate_ident(part, "dot path '" .. path .. "'")
-        parts[#parts + 1] = part
-    end
-    if #parts == 0 then
-        error("empty expression in template")
+-- Programs are executed by the native renderer shared with the JS
+-- runtime; the format is documented in include/hull/cap/template.h.
+-- Register 0 holds the data table, loop variables get fixed registers
+-- and expression temporaries sit above the innermost loop's registers.
+
+local OP_END, OP_TEXT, OP_GET, OP_STR, OP_NIL = 0, 1, 2, 3, 4
+local OP_FILTER, OP_OUT, OP_JMPF, OP_JMPT, OP_JMP, OP_NEXT = 5, 6, 7, 8, 9, 10
+local NO_REG = 0xFF
+local TPL_VERSION = 1
+local TPL_HEADER_SIZE = 8
+
+local function emit_program(ast)
+    local out = {}
+    local pos = TPL_HEADER_SIZE   -- absolute offset of the next byte
+    local nregs = 1
+    local locals = {}             -- loop variable name -> register
+
+    local function put(bytes)
+        out[#out + 1] = bytes
+        pos = pos + #bytes
     end
 
-    -- Check if first segment is a loop-local variable
-    if locals_set and locals_set[parts[1]] then
-        if #parts == 1 then
-            return parts[1]
-        end
-        -- Build nil-safe chain using the local directly: item and item.name
-        local checks = {}
-        local chain = parts[1]
-        for i = 2, #parts - 1 do
-            chain = chain .. "." .. parts[i]
-            checks[#checks + 1] = chain
+    local function reg(r)
+        if r >= NO_REG then
+            error("template too deeply nested")
         end
-        chain = chain .. "." .. parts[#parts]
-        if #checks == 0 then
-            return "(" .. parts[1] .. " and " .. chain .. ")"
-        end
-        return "(" .. parts[1] .. " and " .. table.concat(checks, " and ") .. " and " .. chain .. ")"
+        if r >= nregs then nregs = r + 1 end
+        return r
     end
 
-    if #parts == 1 then
-        return prefix .. "." .. parts[1]
+    -- u32 jump target placeholder; returns its index in `out`
+    local function placeholder()
+        put("\0\0\0\0")
+        return #out
     end
 
-    -- Build nil-safe chain: a and a.b and a.b.c
-    local checks = {}
-    local chain = prefix
-    for i = 1, #parts - 1 do
-        chain = chain .. "." .. parts[i]
-        checks[#checks + 1] = chain
+    local function patch(idx, target)
+        out[idx] = string.pack("<I4", target)
     end
-    chain = chain .. "." .. parts[#parts]
-
-    return "(" .. table.concat(checks, " and ") .. " and " .. chain .. ")"
-end
 
--- Generate expression with filters
-local function gen_expr(expr_info, escaped, locals_set)
-    local code = gen_dot_path(expr_info.var, nil, locals_set)
-
-    -- Apply filter chain
-    for _, f in ipairs(expr_info.filters) do
-        if f.name ~= "raw" and not filters[f.name] then
-            error("unknown template filter: " .. f.name)
+    -- Dot path lookup into register dst (nil-safe). Returns the register
+    -- holding the value — a loop variable's own register for "item".
+    local function gen_path(path, dst)
+        local parts = {}
+        for part in path:gmatch("[^.]+") do
+            validate_ident(part, "dot path '" .. path .. "'")
+            parts[#parts + 1] = part
         end
-        if f.name == "raw" then
-            escaped = false
-        elseif f.arg then
-            -- Filter with argument
-            local arg = f.arg:match("^%s*(.-)%s*$")
-            -- Check if arg is a string literal
-            if arg:sub(1, 1) == '"' then
-                if not arg:match('^"[^"]*"$') then
-                    error("invalid filter argument (unbalanced quotes): " .. arg)
-                end
-                if arg:find("\\") then
-                    error("invalid filter argument (backslash not allowed): " .. arg)
-                end
-                code = "__f." .. f.name .. "(" .. code .. ", " .. arg .. ")"
-            elseif arg:sub(1, 1) == "'" then
-                if not arg:match("^'[^']*'$") then
-                    error("invalid filter argument (unbalanced quotes): " .. arg)
-                end
-                if arg:find("\\") then
-                    error("invalid filter argument (backslash not allowed): " .. arg)
-                end
-                code = "__f." .. f.name .. "(" .. code .. ", " .. arg .. ")"
-            else
-                -- It's a variable reference — validated by gen_dot_path
-                code = "__f." .. f.name .. "(" .. code .. ", " .. gen_dot_path(arg, nil, locals_set) .. ")"
-            end
-        else
-            code = "__f." .. f.name .. "(" .. code .. ")"
+        if #parts == 0 then
+            error("empty expression in template")
         end
-    end
 
-    if escaped then
-        code = "__e(" .. code .. ")"
+        local obj, first = 0, 1
+        if locals[parts[1]] then
+            obj, first = locals[parts[1]], 2
+        end
+        if first > #parts then
+            return obj
+        end
+        reg(dst)
+        for i = first, #parts do
+            put(string.pack("<BBBs2", OP_GET, dst, obj, parts[i]))
+            obj = dst
+        end
+        return dst
     end
 
-    return code
-end
+    -- Path + filter chain into register t (t + 1 holds a filter argument)
+    local function gen_expr(expr_info, escaped, t)
+        local r = gen_path(expr_info.var, t)
 
--- Generate condition expression
-local function gen_cond(cond, negated, locals_set)
-    local path = gen_dot_path(cond:match("^%s*(.-)%s*$"), nil, locals_set)
-    if negated then
-        return "not " .. path
-    end
-    return path
-end
+        for _, f in ipairs(expr_info.filters) do
+            local id = FILTER_IDS[f.name]
+            if f.name ~= "raw" and not id then
+                error("unknown template filter: " .. f.name)
+            end
+            if f.name == "raw" then
+                escaped = false
+            else
+                local a = NO_REG
+                if f.arg then
+                    local arg = f.arg:match("^%s*(.-)%s*$")
+                    local q = arg:sub(1, 1)
+                    if q == '"' or q == "'" then
+                        if not arg:match("^" .. q .. "[^" .. q .. "]*" .. q .. "$") then
+                            error("invalid filter argument (unbalanced quotes): " .. arg)
+                        end
+                        if arg:find("\\", 1, true) then
+                            error("invalid filter argument (backslash not allowed): " .. arg)
+                        end
+                        a = reg(t + 1)
+                        put(string.pack("<BBs4", OP_STR, a, arg:sub(2, -2)))
+                    else
+                        -- Variable reference — validated by gen_path
+                        a = gen_path(arg, t + 1)
+                    end
+                end
+                put(string.pack("<BBBBB", OP_FILTER, id, reg(t), r, a))
+                r = t
+            end
+        end
 
-local function lua_quote(s)
-    -- Use Lua long string to avoid escaping issues
-    -- Find a level of [=...=[ that doesn't appear in the string
-    local level = 0
-    while s:find("%]" .. string.rep("=", level) .. "%]") do
-        level = level + 1
+        return r, escaped
     end
-    local eq = string.rep("=", level)
-    return "[" .. eq .. "[" .. s .. "]" .. eq .. "]"
-end
 
-local function codegen(ast)
-    local lines = {}
-    local indent = 1
-    local locals_set = {}  -- track loop-local variable names
-
-    local function emit(line)
-        lines[#lines + 1] = string.rep("  ", indent) .. line
+    local function bind(name, r)
+        local prev = locals[name]
+        locals[name] = r
+        return prev
     end
 
-    local function gen_body(nodes)
+    local function gen_body(nodes, top)
         for _, node in ipairs(nodes) do
             if node.kind == "text" then
                 if #node.value > 0 then
-                    emit("__p[#__p+1] = " .. lua_quote(node.value))
+                    put(string.pack("<Bs4", OP_TEXT, node.value))
                 end
 
-            elseif node.kind == "var" then
-                emit("__p[#__p+1] = " .. gen_expr(node.expr, true, locals_set))
-
-            elseif node.kind == "raw" then
-                emit("__p[#__p+1] = tostring(" .. gen_expr(node.expr, false, locals_set) .. " or \"\")")
+            elseif node.kind == "var" or node.kind == "raw" then
+                local r, escaped = gen_expr(node.expr, node.kind == "var", top)
+                put(string.pack("<BBB", OP_OUT, r, escaped and 1 or 0))
 
             elseif node.kind == "if" then
-                for i, branch in ipairs(node.branches) do
-                    if i == 1 then
-                        emit("if " .. gen_cond(branch.cond, branch.negated, locals_set) .. " then")
-                    else
-                        emit("elseif " .. gen_cond(branch.cond, branch.negated, locals_set) .. " then")
-                    end
-                    indent = indent + 1
-                    gen_body(branch.body)
-                    indent = indent - 1
+                local ends = {}
+                for _, branch in ipairs(node.branches) do
+                    local r = gen_path(branch.cond:match("^%s*(.-)%s*$"), top)
+                    put(string.pack("<BB", branch.negated and OP_JMPT or OP_JMPF, r))
+                    local skip = placeholder()
+                    gen_body(branch.body, top)
+                    put(string.char(OP_JMP))
+                    ends[#ends + 1] = placeholder()
+                    patch(skip, pos)
                 end
                 if node.else_body then
-                    emit("else")
-                    indent = indent + 1
-                    gen_body(node.else_body)
-                    indent = indent - 1
+                    gen_body(node.else_body, top)
+                end
+                for _, e in ipairs(ends) do
+                    patch(e, pos)
                 end
-                emit("end")
-
-            elseif node.kind == "for" then
-                emit("for _, " .. node.var .. " in ipairs(" .. gen_dot_path(node.expr, nil, locals_set) .. " or {}) do")
-                locals_set[node.var] = (locals_set[node.var] or 0) + 1
-                indent = indent + 1
-                gen_body(node.body)
-                indent = indent - 1
-                locals_set[node.var] = locals_set[node.var] - 1
-                if locals_set[node.var] == 0 then locals_set[node.var] = nil end
-                emit("end")
-
-            elseif node.kind == "for_kv" then
-                emit("for " .. node.key .. ", " .. node.val .. " in pairs(" .. gen_dot_path(node.expr, nil, locals_set) .. " or {}) do")
-                locals_set[node.key] = (locals_set[node.key] or 0) + 1
-                locals_set[node.val] = (locals_set[node.val] or 0) + 1
-                indent = indent + 1
-                gen_body(node.body)
-                indent = indent - 1
-                locals_set[node.key] = locals_set[node.key] - 1
-                if locals_set[node.key] == 0 then locals_set[node.key] = nil end
-                locals_set[node.val] = locals_set[node.val] - 1
-                if locals_set[node.val] == 0 then locals_set[node.val] = nil end
-                emit("end")
+
+            elseif node.kind == "for" or node.kind == "for_kv" then
+                -- Registers: collection, iterator state (2), [key,] value
+                local kv = node.kind == "for_kv"
+                local coll = gen_path(node.expr, top)
+                local state = reg(top + 1)
+                reg(top + 2)
+                local key = kv and reg(top + 3) or NO_REG
+                local val = reg(kv and top + 4 or top + 3)
+
+                put(string.pack("<BBBB", OP_NIL, state, OP_NIL, state + 1))
+                local head = pos
+                put(string.pack("<BBBBBB", OP_NEXT, coll, state, key, val, kv and 1 or 0))
+                local exit = placeholder()
+
+                local prev_key, prev_val
+                if kv then
+                    prev_key = bind(node.key, key)
+                    prev_val = bind(node.val, val)
+                else
+                    prev_val = bind(node.var, val)
+                end
+                gen_body(node.body, val + 1)
+                if kv then
+                    locals[node.key] = prev_key
+                    locals[node.val] = prev_val
+                else
+                    locals[node.var] = prev_val
+                end
+
+                put(string.pack("<BI4", OP_JMP, head))
+                patch(exit, pos)
 
             elseif node.kind == "block" then
                 -- Blocks are already resolved by inheritance; render their content
-                gen_body(node.body)
+                gen_body(node.body, top)
             end
         end
     end
 
-    lines[#lines + 1] = "return function(__d, __e, __f)"
-    lines[#lines + 1] = "  local __p = {}"
-    gen_body(ast)
-    lines[#lines + 1] = "  return table.concat(__p)"
-    lines[#lines + 1] = "end"
+    gen_body(ast, 1)
+    put(string.char(OP_END))
 
-    return table.concat(lines, "\n")
+    return string.pack("<c4BBI2", "HTPL", TPL_VERSION, nregs, 0) .. table.concat(out)
 end
 
 -- ── Compile + cache ─────────────────────────────────────────────────
 
-local cache = {}
-
 local function load_raw(name)
     return _template._load_raw(name)
 end
 
-local function compile_source(source, name)
+-- Lex, parse, flatten inheritance/includes and emit a program
+local function generate_source(source, load_fn)
     local tokens = lex(source)
     local ast = parse(tokens)
-    ast = resolve_inheritance(ast, load_raw)
-    ast = resolve_includes(ast, load_raw)
-    local code = codegen(ast)
-    local chunk_name = name and ("=template:" .. name) or "=template"
-    local fn = _template._compile(code, chunk_name)
-    return fn
+    ast = resolve_inheritance(ast, load_fn)
+    ast = resolve_includes(ast, load_fn)
+    return emit_program(ast)
+end
+
+local function compile_source(source)
+    return _template._program(generate_source(source, load_raw), filters)
 end
 
+-- LRU cache: name -> node, nodes in a doubly-linked list with the most
+-- recently used at `lru_head` and the eviction candidate at `lru_tail`
+local cache = {}
 local cache_count = 0
+local lru_head, lru_tail = nil, nil
+
+local function lru_unlink(node)
+    if node.prev then node.prev.next = node.next else lru_head = node.next end
+    if node.next then node.next.prev = node.prev else lru_tail = node.prev end
+    node.prev, node.next = nil, nil
+end
+
+local function lru_push_front(node)
+    node.next = lru_head
+    if lru_head then lru_head.prev = node end
+    lru_head = node
+    if not lru_tail then lru_tail = node end
+end
+
+local function cache_get(name)
+    local node = cache[name]
+    if not node then return nil end
+    if node ~= lru_head then
+        lru_unlink(node)
+        lru_push_front(node)
+    end
+    return node.fn
+end
+
+local function cache_put(name, fn)
+    if cache_count >= MAX_CACHE_SIZE then
+        local old = lru_tail
+        lru_unlink(old)
+        cache[old.name] = nil
+        cache_count = cache_count - 1
+    end
+    local node = { name = name, fn = fn }
+    lru_push_front(node)
+    cache[name] = node
+    cache_count = cache_count + 1
+end
 
 --- Compile a named template (from embedded entries or filesystem).
 -- Returns a function(data) that renders the template.
 function template.compile(name)
-    if cache[name] then
-        return cache[name]
-    end
-
-    local source = load_raw(name)
-    if not source then
-        error("template not found: " .. name)
+    local fn = cache_get(name)
+    if fn then
+        return fn
     end
 
-    -- Evict cache if at capacity
-    if cache_count >= MAX_CACHE_SIZE then
-        cache = {}
-        cache_count = 0
+    -- Precompiled by hull build (inheritance and includes already flattened)
+    fn = _template._load_compiled(name, filters)
+    if not fn then
+        local source = load_raw(name)
+        if not source then
+            error("template not found: " .. name)
+        end
+        fn = compile_source(source)
     end
 
-    local fn = compile_source(source, name)
-    cache[name] = fn
-    cache_count = cache_count + 1
+    cache_put(name, fn)
     return fn
 end
 
+--- Generate the bytecode program for a named template without loading it.
+-- load_fn(name) returns template source or nil; used by hull build to
+-- precompile templates read from the app directory.
+function template.generate(name, load_fn)
+    load_fn = load_fn or load_raw
+    local source = load_fn(name)
+    if not source then
+        error("template not found: " .. name)
+    end
+    return generate_source(source, load_fn)
+end
+
 --- Render a named template with data.
 -- Loads, compiles (cached), and renders in one call.
 function template.render(name, data)
     local fn = template.compile(name)
-    return fn(data or {}, html_escape, filters)
+    return fn(data or {})
 end
 
 --- Compile and render a template from a source string.
 function template.render_string(source, data)
-    local fn = compile_source(source, nil)
-    return fn(data or {}, html_escape, filters)
+    local fn = compile_source(source)
+    return fn(data or {})
 end
 
 --- Clear the compiled function cache.
 function template.clear_cache()
     cache = {}
     cache_count = 0
+    lru_head, lru_tail = nil, nil
 end
 
 return template
@@ -175,6 +175,7 @@ local function main()
     -- Recompute file hashes
     local mismatches = {}
     local missing = {}
+    local checked, blobs = {}, {}
     for name, expected_hash in pairs(sig.files) do
         -- Path traversal defense: reject suspicious file names
         if name:find("%.%.") or name:sub(1, 1) == "/" then
@@ -183,22 +184,48 @@ local function main()
             goto continue_files
         end
         local path = app_dir .. "/" .. name
-        local data = read_file(path)
+        local data
+        local tpl = name:match("^templates/(.+)%.tplc$")
+        local module = name:match("^(.+)%.luac$")
+        local js_module = name:match("^(.+)%.jsc$")
+        if tpl then
+            -- Precompiled template: regenerate the program as hull build does
+            local template = require("hull.template")
+            local ok, prog = pcall(template.generate, tpl, function(n)
+                if n:sub(1, 1) == "/" or n:find("%.%.") then return nil end
+                return read_file(app_dir .. "/templates/" .. n)
+            end)
+            data = ok and prog or nil
+        elseif module then
+            -- Embedded bytecode: recompile the source exactly as hull build does
+            local src = read_file(app_dir .. "/" .. module .. ".lua")
+            data = src and tool.compile_lua(src, "./" .. module)
+        elseif js_module and tool.compile_js then
+            local src = read_file(app_dir .. "/" .. js_module .. ".js")
+            data = src and tool.compile_js(src, "./" .. js_module .. ".js")
+        else
+            data = read_file(path)
+        end
         if not data then
             missing[#missing + 1] = name
         else
-            local actual_hash = crypto.sha256(data)
-            if actual_hash ~= expected_hash then
-                mismatches[#mismatches + 1] = {
-                    name = name,
-                    expected = expected_hash,
-                    actual = actual_hash,
-                }
-            end
+            checked[#checked + 1] = { name = name, expected = expected_hash }
+            blobs[#blobs + 1] = data
         end
         ::continue_files::
     end
 
+    -- Hash everything as one batch (spread across cores when large)
+    for i, actual_hash in ipairs(crypto.sha256_many(blobs)) do
+        if actual_hash ~= checked[i].expected then
+            mismatches[#mismatches + 1] = {
+                name = checked[i].name,
+                expected = checked[i].expected,
+                actual = actual_hash,
+            }
+        end
+    end
+
     -- Report file issues
     if #missing > 0 then
         tool.stderr("Missing files:\n")
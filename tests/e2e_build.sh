@@ -336,9 +336,10 @@ check_exit "verify passes after restore" 0 $RC
 echo ""
 echo "=== Step 10: Multi-file app ==="
 
-mkdir -p "$WORKDIR/multiapp/lib"
+mkdir -p "$WORKDIR/multiapp/lib" "$WORKDIR/multiapp/templates"
 cat > "$WORKDIR/multiapp/app.lua" << 'APPEOF'
 local greet = require("./lib/greet")
+local template = require("hull.template")
 
 app.manifest({
     env = {"APP_NAME"},
@@ -351,8 +352,20 @@ end)
 app.get("/health", function(req, res)
     res:json({status = "ok", app = "multiapp"})
 end)
+
+app.get("/page", function(req, res)
+    res:html(template.render("page.html", {name = "tpl"}))
+end)
 APPEOF
 
+cat > "$WORKDIR/multiapp/templates/base.html" << 'TPLEOF'
+<main>{% block content %}{% end %}</main>
+TPLEOF
+
+cat > "$WORKDIR/multiapp/templates/page.html" << 'TPLEOF'
+{% extends "base.html" %}{% block content %}Hi {{ name }}{% end %}
+TPLEOF
+
 cat > "$WORKDIR/multiapp/lib/greet.lua" << 'LIBEOF'
 local M = {}
 function M.hello(name)
@@ -376,6 +389,9 @@ if wait_for_server 19871; then
 
     RESP=$(curl -s "http://127.0.0.1:19871/health")
     check_contains "multi-file GET /health" "$RESP" "multiapp"
+
+    RESP=$(curl -s "http://127.0.0.1:19871/page")
+    check_contains "multi-file precompiled template renders" "$RESP" "<main>Hi tpl</main>"
 else
     fail "multi-file app did not start"
 fi
@@ -385,6 +401,7 @@ stop_server
 # Verify multi-file signature
 VERIFY_OUT=$("$HULL" verify --platform-key "$WORKDIR/developer.pub" "$WORKDIR/multiapp" 2>&1); RC=$?
 check_exit "multi-file verify passes" 0 $RC
+check_contains "signature covers precompiled template" "$(cat "$WORKDIR/multiapp/package.sig")" "templates/page.html.tplc"
 
 # Inspect multi-file app (manifest may be nil if app has require() deps)
 INSPECT_OUT=$("$HULL" inspect "$WORKDIR/multiapp" 2>&1); RC=$?
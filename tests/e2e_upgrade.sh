@@ -0,0 +1,202 @@
+#!/bin/sh
+# E2E zero-downtime upgrade — SIGUSR2 listening-socket handoff
+#
+# Starts hull --upgrade on a fixed port, sends SIGUSR2 and checks that:
+#   1. the helper reports a new pid ready and the old pid exits
+#   2. the new pid keeps serving requests on the same port
+#   3. requests made throughout the handoff never fail
+#
+# The new process takes the inherited socket over after kl_server_init()
+# (see src/hull/main.c). This is the end-to-end check that Keel's event
+# loop accepts on it; tests/hull/test_upgrade.c covers the fd passing.
+#
+# Usage: sh tests/e2e_upgrade.sh
+#        RUNTIME=js sh tests/e2e_upgrade.sh    # test JS only
+#        RUNTIME=lua sh tests/e2e_upgrade.sh   # test Lua only
+# Requires: build/hull already built, curl available
+#
+# SPDX-License-Identifier: AGPL-3.0-or-later
+
+set -e
+
+SRCDIR="$(cd "$(dirname "$0")/.." && pwd)"
+HULL="$SRCDIR/build/hull"
+PASS=0
+FAIL=0
+RUNTIME=${RUNTIME:-all}
+SERVER_PID=""
+NEW_PID=""
+LOAD_PID=""
+
+if [ ! -x "$HULL" ]; then
+    echo "e2e_upgrade: hull binary not found at $HULL — run 'make' first"
+    exit 1
+fi
+
+fail() {
+    echo "  FAIL: $1"
+    FAIL=$((FAIL + 1))
+}
+
+pass() {
+    echo "  PASS: $1"
+    PASS=$((PASS + 1))
+}
+
+wait_for_server() {
+    # $1 = port
+    for _i in 1 2 3 4 5 6 7 8 9 10 11 12 13 14 15 16 17 18 19 20; do
+        if curl -s "http://127.0.0.1:$1/health" >/dev/null 2>&1; then
+            return 0
+        fi
+        sleep 0.3
+    done
+    echo "  server did not start on port $1"
+    return 1
+}
+
+stop_pid() {
+    if [ -n "$1" ]; then
+        kill "$1" 2>/dev/null || true
+        wait "$1" 2>/dev/null || true
+    fi
+}
+
+cleanup() {
+    stop_pid "$LOAD_PID"
+    stop_pid "$SERVER_PID"
+    # The successor is not our child: signal it and poll for its exit
+    if [ -n "$NEW_PID" ]; then
+        kill "$NEW_PID" 2>/dev/null || true
+        for _i in 1 2 3 4 5 6 7 8 9 10; do
+            kill -0 "$NEW_PID" 2>/dev/null || break
+            sleep 0.3
+        done
+    fi
+    if [ -n "$TMPDIR_WORK" ] && [ -d "$TMPDIR_WORK" ]; then
+        rm -rf "$TMPDIR_WORK"
+    fi
+}
+trap cleanup EXIT
+
+run_upgrade_test() {
+    LABEL=$1
+    PORT=$2
+    APP=$3
+
+    echo ""
+    echo "--- upgrade ($LABEL) port $PORT ---"
+
+    TMPDIR_WORK=$(mktemp -d)
+    LOG="$TMPDIR_WORK/hull.log"
+    "$HULL" --upgrade --drain-timeout 2000 -p "$PORT" \
+        -d "$TMPDIR_WORK/data.db" "$APP" >"$LOG" 2>&1 &
+    SERVER_PID=$!
+    if ! wait_for_server "$PORT"; then
+        fail "$LABEL upgrade — server startup"
+        stop_pid "$SERVER_PID"; SERVER_PID=""
+        rm -rf "$TMPDIR_WORK"; return
+    fi
+    OLD_PID=$SERVER_PID
+
+    # Steady requests across the handoff; any failure is recorded
+    (
+        while :; do
+            curl -s -o /dev/null -w '%{http_code}\n' \
+                "http://127.0.0.1:$PORT/health" >>"$TMPDIR_WORK/codes" 2>&1 \
+                || echo "curl-error" >>"$TMPDIR_WORK/codes"
+            sleep 0.05
+        done
+    ) &
+    LOAD_PID=$!
+    sleep 0.3
+
+    kill -USR2 "$OLD_PID"
+
+    # "[hull:upgrade] pid N ready, draining pid M"
+    _i=0
+    while [ "$_i" -lt 100 ]; do
+        NEW_PID=$(sed -n 's/.*\[hull:upgrade\] pid \([0-9]*\) ready, draining.*/\1/p' "$LOG" | tail -1)
+        [ -n "$NEW_PID" ] && break
+        sleep 0.1
+        _i=$((_i + 1))
+    done
+    if [ -z "$NEW_PID" ]; then
+        fail "$LABEL upgrade — no successor reported ready"
+        sed 's/^/    /' "$LOG"
+        stop_pid "$LOAD_PID"; LOAD_PID=""
+        stop_pid "$SERVER_PID"; SERVER_PID=""
+        rm -rf "$TMPDIR_WORK"; return
+    fi
+    pass "$LABEL successor pid $NEW_PID ready"
+
+    # The old process drains and exits by itself
+    wait "$OLD_PID" 2>/dev/null || true
+    SERVER_PID=""
+    if kill -0 "$OLD_PID" 2>/dev/null; then
+        fail "$LABEL old pid $OLD_PID still running"
+    else
+        pass "$LABEL old pid $OLD_PID exited"
+    fi
+
+    if grep -q "took over listening socket" "$LOG"; then
+        pass "$LABEL successor took over the listening socket"
+    else
+        fail "$LABEL successor did not report the socket takeover"
+    fi
+
+    # Only the successor holds the port now: it must accept and serve
+    OK=0
+    for _i in 1 2 3 4 5 6 7 8 9 10; do
+        CODE=$(curl -s -m 2 -o /dev/null -w '%{http_code}' \
+            "http://127.0.0.1:$PORT/health" 2>/dev/null || true)
+        [ "$CODE" = "200" ] && OK=$((OK + 1))
+    done
+    if [ "$OK" -eq 10 ] && kill -0 "$NEW_PID" 2>/dev/null; then
+        pass "$LABEL pid $NEW_PID serves on port $PORT"
+    else
+        fail "$LABEL pid $NEW_PID served $OK/10 requests on port $PORT"
+    fi
+
+    stop_pid "$LOAD_PID"; LOAD_PID=""
+    TOTAL=$(wc -l <"$TMPDIR_WORK/codes" | tr -d ' ')
+    BAD=$(grep -vc '^200$' "$TMPDIR_WORK/codes" || true)
+    if [ "$BAD" -eq 0 ] && [ "$TOTAL" -gt 0 ]; then
+        pass "$LABEL $TOTAL requests during the handoff, none failed"
+    else
+        fail "$LABEL $BAD of $TOTAL requests during the handoff failed"
+    fi
+
+    kill "$NEW_PID" 2>/dev/null || true
+    for _i in 1 2 3 4 5 6 7 8 9 10; do
+        kill -0 "$NEW_PID" 2>/dev/null || break
+        sleep 0.3
+    done
+    NEW_PID=""
+    rm -rf "$TMPDIR_WORK"
+    TMPDIR_WORK=""
+}
+
+# ── Run tests ────────────────────────────────────────────────────────
+
+PORT_BASE=19900
+
+echo ""
+echo "=== E2E Upgrade Tests ==="
+
+if [ "$RUNTIME" != "js" ]; then
+    run_upgrade_test "lua" $((PORT_BASE))     "$SRCDIR/examples/hello/app.lua"
+fi
+
+if [ "$RUNTIME" != "lua" ]; then
+    run_upgrade_test "js"  $((PORT_BASE + 1)) "$SRCDIR/examples/hello/app.js"
+fi
+
+# ── Summary ──────────────────────────────────────────────────────────
+
+echo ""
+TOTAL=$((PASS + FAIL))
+echo "$PASS/$TOTAL e2e upgrade tests passed"
+if [ "$FAIL" -gt 0 ]; then
+    exit 1
+fi
@@ -6,9 +6,56 @@
 
 #include "utest.h"
 #include "hull/cap/audit.h"
+#include "hull/limits.h"
+
+#include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#include <sys/stat.h>
 #include <unistd.h>
 
+/* Read a whole file into a malloc'd, NUL-terminated buffer */
+static char *slurp(const char *path, size_t *len)
+{
+    FILE *f = fopen(path, "rb");
+    if (!f)
+        return NULL;
+    fseek(f, 0, SEEK_END);
+    long n = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    char *buf = malloc((size_t)n + 1);
+    if (buf && fread(buf, 1, (size_t)n, f) != (size_t)n) {
+        free(buf);
+        buf = NULL;
+    }
+    fclose(f);
+    if (buf) {
+        buf[n] = '\0';
+        *len = (size_t)n;
+    }
+    return buf;
+}
+
+static int count_lines(const char *buf)
+{
+    int n = 0;
+    for (const char *p = buf; *p; p++)
+        n += *p == '\n';
+    return n;
+}
+
+/* A db.query-shaped event */
+static void emit_query(int i)
+{
+    static const char sql[] = "SELECT id, name, email FROM users WHERE id = ?";
+    ShJsonWriter w = hl_audit_begin("db.query");
+    sh_json_write_key(&w, "sql");
+    sh_json_write_string_n(&w, sql, sizeof(sql) - 1);
+    sh_json_write_kv_int(&w, "nparams", 1);
+    sh_json_write_kv_int(&w, "result", i);
+    hl_audit_end(&w);
+}
+
 /* ── Gating: disabled audit produces no output ───────────────────── */
 
 UTEST(hl_audit, disabled_is_noop)
@@ -109,4 +156,121 @@ UTEST(hl_audit, escaping)
     hl_audit_enabled = 0;
 }
 
+/* ── Ring: drain thread writes batched lines to a file ───────────── */
+
+UTEST(hl_audit, ring_writes_file)
+{
+    char dir[] = "/tmp/hull_audit_XXXXXX";
+    ASSERT_NE(mkdtemp(dir), NULL);
+    char path[256];
+    snprintf(path, sizeof(path), "%s/audit.log", dir);
+
+    hl_audit_enabled = 1;
+    ASSERT_EQ(hl_audit_start(path, 0), 0);
+    ASSERT_EQ(hl_audit_start(path, 0), -1); /* already running */
+    for (int i = 0; i < 1000; i++)
+        emit_query(i);
+    hl_audit_stop();
+    hl_audit_stop(); /* idempotent */
+    hl_audit_enabled = 0;
+
+    ASSERT_EQ(hl_audit_written(), (uint64_t)1000);
+    ASSERT_EQ(hl_audit_dropped(), (uint64_t)0);
+
+    size_t len = 0;
+    char *buf = slurp(path, &len);
+    ASSERT_TRUE(buf != NULL);
+    ASSERT_EQ(count_lines(buf), 1000);
+    ASSERT_EQ(strncmp(buf, "{\"ts\":\"", 7), 0);
+    ASSERT_NE(strstr(buf, "Z\",\"cap\":\"db.query\",\"sql\":\"SELECT"), NULL);
+    ASSERT_NE(strstr(buf, "\"nparams\":1,\"result\":0}\n"), NULL);
+    ASSERT_NE(strstr(buf, "\"result\":999}\n"), NULL);
+    free(buf);
+
+    unlink(path);
+    rmdir(dir);
+}
+
+/* ── Truncation: oversized events stay valid JSON ─────────────────── */
+
+UTEST(hl_audit, oversized_event_truncated)
+{
+    char dir[] = "/tmp/hull_audit_XXXXXX";
+    ASSERT_NE(mkdtemp(dir), NULL);
+    char path[256];
+    snprintf(path, sizeof(path), "%s/audit.log", dir);
+
+    char big[HL_AUDIT_RECORD_SIZE * 2];
+    memset(big, 'x', sizeof(big) - 1);
+    big[sizeof(big) - 1] = '\0';
+
+    hl_audit_enabled = 1;
+    ASSERT_EQ(hl_audit_start(path, 0), 0);
+    ShJsonWriter w = hl_audit_begin("test.big");
+    sh_json_write_kv_string(&w, "val", big);
+    sh_json_write_kv_int(&w, "after", 1);
+    hl_audit_end(&w);
+    emit_query(7);
+    hl_audit_stop();
+    hl_audit_enabled = 0;
+
+    size_t len = 0;
+    char *buf = slurp(path, &len);
+    ASSERT_TRUE(buf != NULL);
+    ASSERT_EQ(count_lines(buf), 2);
+    ASSERT_NE(strstr(buf, "\"cap\":\"test.big\",\"truncated\":true}\n"), NULL);
+    ASSERT_EQ(strstr(buf, "xxx"), NULL);
+    ASSERT_NE(strstr(buf, "\"result\":7}\n"), NULL);
+    free(buf);
+
+    unlink(path);
+    rmdir(dir);
+}
+
+/* ── Rotation: file moves to <path>.1 past the size limit ─────────── */
+
+UTEST(hl_audit, rotates_file)
+{
+    char dir[] = "/tmp/hull_audit_XXXXXX";
+    ASSERT_NE(mkdtemp(dir), NULL);
+    char path[256], old[272];
+    snprintf(path, sizeof(path), "%s/audit.log", dir);
+    snprintf(old, sizeof(old), "%s.1", path);
+
+    hl_audit_enabled = 1;
+    ASSERT_EQ(hl_audit_start(path, 4096), 0);
+    for (int i = 0; i < 500; i++) {
+        emit_query(i);
+        if (i % 50 == 49)
+            usleep(20 * 1000); /* let several batches land */
+    }
+    hl_audit_stop();
+    hl_audit_enabled = 0;
+
+    struct stat st;
+    ASSERT_EQ(stat(old, &st), 0);
+    ASSERT_GT(st.st_size, (off_t)0);
+    ASSERT_EQ(hl_audit_written(), (uint64_t)500);
+
+    unlink(path);
+    unlink(old);
+    rmdir(dir);
+}
+
+/* ── Ring accounting: every event is either written or dropped ─── */
+
+UTEST(hl_audit, ring_accounts_every_event)
+{
+    enum { EVENTS = 5000 };
+
+    hl_audit_enabled = 1;
+    ASSERT_EQ(hl_audit_start("/dev/null", 0), 0);
+    for (int i = 0; i < EVENTS; i++)
+        emit_query(i);
+    hl_audit_stop();
+    hl_audit_enabled = 0;
+
+    ASSERT_EQ(hl_audit_written() + hl_audit_dropped(), (uint64_t)EVENTS);
+}
+
 UTEST_MAIN()
@@ -6,8 +6,14 @@
 
 #include "utest.h"
 #include "hull/cap/body.h"
+#include "hull/manifest.h"
 #include <keel/body_reader.h>
+#include <sqlite3.h>
+#include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 UTEST(hl_cap_body, null_reader_returns_zero)
 {
@@ -43,4 +49,345 @@ UTEST(hl_cap_body, empty_buf_reader_returns_zero)
     ASSERT_EQ((size_t)0, len);
 }
 
+/* ── Upload specs ─────────────────────────────────────────────────── */
+
+UTEST(hl_cap_body, mode_names)
+{
+    ASSERT_EQ(HL_BODY_BUFFER, hl_cap_body_mode("buffer"));
+    ASSERT_EQ(HL_BODY_STREAM, hl_cap_body_mode("stream"));
+    ASSERT_EQ(HL_BODY_SPOOL, hl_cap_body_mode("spool"));
+    ASSERT_EQ(HL_BODY_BLOB, hl_cap_body_mode("blob"));
+    ASSERT_EQ(-1, hl_cap_body_mode("file"));
+    ASSERT_EQ(-1, hl_cap_body_mode(NULL));
+    ASSERT_STREQ("spool", hl_cap_body_mode_name(HL_BODY_SPOOL));
+}
+
+UTEST(hl_cap_body, check_defaults_and_ceilings)
+{
+    HlBodySpec spec;
+    memset(&spec, 0, sizeof(spec));
+    ASSERT_EQ(0, hl_cap_body_check(&spec, NULL));
+    ASSERT_EQ((int64_t)HL_BODY_MAX_SIZE, spec.max_size);
+
+    spec.max_size = (int64_t)HL_BODY_MAX_BUFFER + 1;
+    ASSERT_EQ(-1, hl_cap_body_check(&spec, NULL));
+
+    memset(&spec, 0, sizeof(spec));
+    spec.mode = HL_BODY_STREAM;
+    ASSERT_EQ(0, hl_cap_body_check(&spec, NULL));
+    ASSERT_EQ((int64_t)HL_BODY_STREAM_SIZE, spec.max_size);
+
+    spec.max_size = -1;
+    ASSERT_EQ(-1, hl_cap_body_check(&spec, NULL));
+}
+
+UTEST(hl_cap_body, check_blob_identifiers)
+{
+    HlBodySpec spec;
+    memset(&spec, 0, sizeof(spec));
+    spec.mode = HL_BODY_BLOB;
+    ASSERT_EQ(-1, hl_cap_body_check(&spec, NULL));
+
+    snprintf(spec.table, sizeof(spec.table), "files");
+    snprintf(spec.column, sizeof(spec.column), "data");
+    ASSERT_EQ(0, hl_cap_body_check(&spec, NULL));
+    ASSERT_EQ((int64_t)HL_BODY_BLOB_SIZE, spec.max_size);
+
+    snprintf(spec.table, sizeof(spec.table), "files\"; DROP");
+    ASSERT_EQ(-1, hl_cap_body_check(&spec, NULL));
+    snprintf(spec.table, sizeof(spec.table), "_HULL_outbox");
+    ASSERT_EQ(-1, hl_cap_body_check(&spec, NULL));
+    snprintf(spec.table, sizeof(spec.table), "1files");
+    ASSERT_EQ(-1, hl_cap_body_check(&spec, NULL));
+
+    snprintf(spec.table, sizeof(spec.table), "files");
+    spec.max_size = HL_BODY_MAX_BLOB + 1;
+    ASSERT_EQ(-1, hl_cap_body_check(&spec, NULL));
+}
+
+UTEST(hl_cap_body, check_spool_dir_against_manifest)
+{
+    HlManifest m;
+    memset(&m, 0, sizeof(m));
+    m.fs_write[0] = "data/";
+    m.fs_write_count = 1;
+
+    HlBodySpec spec;
+    memset(&spec, 0, sizeof(spec));
+    spec.mode = HL_BODY_SPOOL;
+
+    snprintf(spec.dir, sizeof(spec.dir), "data/uploads");
+    ASSERT_EQ(-1, hl_cap_body_check(&spec, NULL));
+    ASSERT_EQ(0, hl_cap_body_check(&spec, &m));
+    ASSERT_STREQ("data/", spec.root);
+
+    snprintf(spec.dir, sizeof(spec.dir), "./data");
+    ASSERT_EQ(0, hl_cap_body_check(&spec, &m));
+
+    snprintf(spec.dir, sizeof(spec.dir), "database");
+    ASSERT_EQ(-1, hl_cap_body_check(&spec, &m));
+
+    snprintf(spec.dir, sizeof(spec.dir), "data/../etc");
+    ASSERT_EQ(-1, hl_cap_body_check(&spec, &m));
+
+    snprintf(spec.dir, sizeof(spec.dir), "/tmp");
+    ASSERT_EQ(-1, hl_cap_body_check(&spec, &m));
+}
+
+/* ── Upload readers ───────────────────────────────────────────────── */
+
+typedef struct {
+    char   buf[64];
+    size_t len;
+    int    calls;
+} ChunkSink;
+
+static int sink_chunk(HlBodyUpload *up, const char *data, size_t len,
+                      void *ctx)
+{
+    (void)up;
+    ChunkSink *s = ctx;
+    if (s->len + len > sizeof(s->buf))
+        return -1;
+    memcpy(s->buf + s->len, data, len);
+    s->len += len;
+    s->calls++;
+    return 0;
+}
+
+UTEST(hl_cap_body, stream_passes_chunks_and_enforces_max)
+{
+    KlAllocator alloc = kl_allocator_default();
+    KlRequest req;
+    memset(&req, 0, sizeof(req));
+    HlBodySpec spec;
+    memset(&spec, 0, sizeof(spec));
+    spec.mode = HL_BODY_STREAM;
+    spec.max_size = 10;
+
+    ChunkSink sink;
+    memset(&sink, 0, sizeof(sink));
+    KlBodyReader *r = hl_cap_body_open(&alloc, &req, &spec, NULL,
+                                       sink_chunk, &sink);
+    ASSERT_NE(NULL, r);
+    HlBodyUpload *up = hl_cap_body_upload(r);
+    ASSERT_NE(NULL, up);
+
+    ASSERT_EQ(0, r->on_data(r, "hello", 5));
+    ASSERT_EQ(0, r->on_data(r, "world", 5));
+    ASSERT_EQ(-1, r->on_data(r, "!", 1));
+    ASSERT_EQ(0, r->on_complete(r));
+    ASSERT_EQ(2, sink.calls);
+    ASSERT_EQ((int64_t)10, up->size);
+    ASSERT_EQ(0, memcmp(sink.buf, "helloworld", 10));
+
+    /* Upload readers expose no buffered body */
+    const char *data = (const char *)0x1;
+    ASSERT_EQ((size_t)0, hl_cap_body_data(r, &data));
+    ASSERT_EQ(NULL, data);
+    r->destroy(r);
+
+    /* Declared length over the limit: refused before any data */
+    req.content_length = 11;
+    ASSERT_EQ(NULL, hl_cap_body_open(&alloc, &req, &spec, NULL,
+                                     sink_chunk, &sink));
+}
+
+UTEST(hl_cap_body, buffer_mode_uses_keel_reader)
+{
+    KlAllocator alloc = kl_allocator_default();
+    KlRequest req;
+    memset(&req, 0, sizeof(req));
+    HlBodySpec spec;
+    memset(&spec, 0, sizeof(spec));
+    ASSERT_EQ(0, hl_cap_body_check(&spec, NULL));
+
+    KlBodyReader *r = hl_cap_body_open(&alloc, &req, &spec, NULL, NULL, NULL);
+    ASSERT_NE(NULL, r);
+    ASSERT_EQ(NULL, hl_cap_body_upload(r));
+    r->destroy(r);
+}
+
+UTEST(hl_cap_body, spool_writes_reads_and_keeps)
+{
+    char dir[] = "/tmp/hull_body_XXXXXX";
+    ASSERT_NE(NULL, mkdtemp(dir));
+
+    KlAllocator alloc = kl_allocator_default();
+    KlRequest req;
+    memset(&req, 0, sizeof(req));
+    HlManifest m;
+    memset(&m, 0, sizeof(m));
+    m.fs_write[0] = dir;
+    m.fs_write_count = 1;
+    HlBodySpec spec;
+    memset(&spec, 0, sizeof(spec));
+    spec.mode = HL_BODY_SPOOL;
+    spec.max_size = 1024;
+    snprintf(spec.dir, sizeof(spec.dir), "%s", dir);
+    ASSERT_EQ(0, hl_cap_body_check(&spec, &m));
+
+    /* Not kept: the file is gone after destroy */
+    KlBodyReader *r = hl_cap_body_open(&alloc, &req, &spec, NULL, NULL, NULL);
+    ASSERT_NE(NULL, r);
+    HlBodyUpload *up = hl_cap_body_upload(r);
+    char tmp_path[sizeof(up->path)];
+    memcpy(tmp_path, up->path, sizeof(tmp_path));
+    ASSERT_EQ(0, access(tmp_path, F_OK));
+    ASSERT_EQ(-1, hl_cap_body_keep(up, "early.bin"));
+    ASSERT_EQ(0, r->on_data(r, "abc", 3));
+    ASSERT_EQ(0, r->on_data(r, "def", 3));
+    ASSERT_EQ(0, r->on_complete(r));
+
+    char buf[16];
+    ASSERT_EQ((int64_t)6, hl_cap_body_read(up, buf, sizeof(buf)));
+    ASSERT_EQ(0, memcmp(buf, "abcdef", 6));
+    ASSERT_EQ((int64_t)0, hl_cap_body_read(up, buf, sizeof(buf)));
+    r->destroy(r);
+    ASSERT_NE(0, access(tmp_path, F_OK));
+
+    /* Kept under a plain name, never over an existing file */
+    r = hl_cap_body_open(&alloc, &req, &spec, NULL, NULL, NULL);
+    ASSERT_NE(NULL, r);
+    up = hl_cap_body_upload(r);
+    ASSERT_EQ(0, r->on_data(r, "xyz", 3));
+    ASSERT_EQ(0, r->on_complete(r));
+    ASSERT_EQ(-1, hl_cap_body_keep(up, "../escape"));
+    ASSERT_EQ(0, hl_cap_body_keep(up, "kept.bin"));
+    ASSERT_EQ(-1, hl_cap_body_keep(up, "again.bin"));
+    r->destroy(r);
+
+    char kept[512];
+    snprintf(kept, sizeof(kept), "%s/kept.bin", dir);
+    struct stat st;
+    ASSERT_EQ(0, stat(kept, &st));
+    ASSERT_EQ((off_t)3, st.st_size);
+
+    r = hl_cap_body_open(&alloc, &req, &spec, NULL, NULL, NULL);
+    ASSERT_NE(NULL, r);
+    up = hl_cap_body_upload(r);
+    ASSERT_EQ(0, r->on_complete(r));
+    ASSERT_EQ(-1, hl_cap_body_keep(up, "kept.bin"));
+    r->destroy(r);
+
+    unlink(kept);
+    ASSERT_EQ(0, rmdir(dir)); /* nothing else left behind */
+}
+
+UTEST(hl_cap_body, spool_refuses_symlink_out_of_fs_write)
+{
+    char root[] = "/tmp/hull_body_XXXXXX";
+    char other[] = "/tmp/hull_body_XXXXXX";
+    ASSERT_NE(NULL, mkdtemp(root));
+    ASSERT_NE(NULL, mkdtemp(other));
+    char link_path[256];
+    snprintf(link_path, sizeof(link_path), "%s/uploads", root);
+    ASSERT_EQ(0, symlink(other, link_path));
+
+    HlManifest m;
+    memset(&m, 0, sizeof(m));
+    m.fs_write[0] = root;
+    m.fs_write_count = 1;
+    HlBodySpec spec;
+    memset(&spec, 0, sizeof(spec));
+    spec.mode = HL_BODY_SPOOL;
+    snprintf(spec.dir, sizeof(spec.dir), "%s", link_path);
+    ASSERT_EQ(0, hl_cap_body_check(&spec, &m)); /* lexically fine */
+
+    KlAllocator alloc = kl_allocator_default();
+    KlRequest req;
+    memset(&req, 0, sizeof(req));
+    ASSERT_EQ(NULL, hl_cap_body_open(&alloc, &req, &spec, NULL, NULL, NULL));
+
+    /* Unchecked specs are refused too */
+    memset(spec.root, 0, sizeof(spec.root));
+    snprintf(spec.dir, sizeof(spec.dir), "%s", other);
+    ASSERT_EQ(NULL, hl_cap_body_open(&alloc, &req, &spec, NULL, NULL, NULL));
+
+    ASSERT_EQ(0, unlink(link_path));
+    ASSERT_EQ(0, rmdir(other)); /* nothing was created there */
+    ASSERT_EQ(0, rmdir(root));
+}
+
+static int64_t blob_rows(sqlite3 *db)
+{
+    sqlite3_stmt *stmt = NULL;
+    int64_t n = -1;
+    sqlite3_prepare_v2(db, "SELECT count(*) FROM files", -1, &stmt, NULL);
+    if (sqlite3_step(stmt) == SQLITE_ROW)
+        n = sqlite3_column_int64(stmt, 0);
+    sqlite3_finalize(stmt);
+    return n;
+}
+
+UTEST(hl_cap_body, blob_writes_in_place)
+{
+    sqlite3 *db = NULL;
+    ASSERT_EQ(SQLITE_OK, sqlite3_open(":memory:", &db));
+    ASSERT_EQ(SQLITE_OK, sqlite3_exec(db,
+        "CREATE TABLE files (id INTEGER PRIMARY KEY, name TEXT, data BLOB)",
+        NULL, NULL, NULL));
+
+    KlAllocator alloc = kl_allocator_default();
+    HlBodySpec spec;
+    memset(&spec, 0, sizeof(spec));
+    spec.mode = HL_BODY_BLOB;
+    snprintf(spec.table, sizeof(spec.table), "files");
+    snprintf(spec.column, sizeof(spec.column), "data");
+    ASSERT_EQ(0, hl_cap_body_check(&spec, NULL));
+
+    /* Larger than one flush, fed in odd-sized chunks */
+    size_t total = HL_BODY_BLOB_FLUSH * 2 + 123;
+    char *body = malloc(total);
+    ASSERT_NE(NULL, body);
+    for (size_t i = 0; i < total; i++)
+        body[i] = (char)(i * 7);
+
+    KlRequest req;
+    memset(&req, 0, sizeof(req));
+    req.content_length = total;
+    KlBodyReader *r = hl_cap_body_open(&alloc, &req, &spec, db, NULL, NULL);
+    ASSERT_NE(NULL, r);
+    HlBodyUpload *up = hl_cap_body_upload(r);
+    ASSERT_EQ((int64_t)0, blob_rows(db)); /* headers alone reserve nothing */
+    for (size_t off = 0; off < total; off += 1000) {
+        size_t n = total - off < 1000 ? total - off : 1000;
+        ASSERT_EQ(0, r->on_data(r, body + off, n));
+    }
+    ASSERT_EQ(-1, r->on_data(r, "x", 1)); /* past Content-Length */
+    ASSERT_EQ(0, r->on_complete(r));
+    int64_t rowid = up->rowid;
+    r->destroy(r);
+
+    sqlite3_stmt *stmt = NULL;
+    ASSERT_EQ(SQLITE_OK, sqlite3_prepare_v2(db,
+        "SELECT data FROM files WHERE id = ?", -1, &stmt, NULL));
+    sqlite3_bind_int64(stmt, 1, rowid);
+    ASSERT_EQ(SQLITE_ROW, sqlite3_step(stmt));
+    ASSERT_EQ((int)total, sqlite3_column_bytes(stmt, 0));
+    ASSERT_EQ(0, memcmp(body, sqlite3_column_blob(stmt, 0), total));
+    sqlite3_finalize(stmt);
+
+    /* A short body leaves no row behind */
+    r = hl_cap_body_open(&alloc, &req, &spec, db, NULL, NULL);
+    ASSERT_NE(NULL, r);
+    ASSERT_EQ(0, r->on_data(r, body, HL_BODY_BLOB_FLUSH + 10));
+    ASSERT_EQ((int64_t)2, blob_rows(db));
+    ASSERT_EQ(-1, r->on_complete(r));
+    r->destroy(r);
+    ASSERT_EQ((int64_t)1, blob_rows(db));
+
+    /* An empty body still gets a row */
+    req.content_length = 0;
+    r = hl_cap_body_open(&alloc, &req, &spec, db, NULL, NULL);
+    ASSERT_NE(NULL, r);
+    ASSERT_EQ(0, r->on_complete(r));
+    ASSERT_GT(hl_cap_body_upload(r)->rowid, (int64_t)0);
+    r->destroy(r);
+    ASSERT_EQ((int64_t)2, blob_rows(db));
+
+    free(body);
+    sqlite3_close(db);
+}
+
 UTEST_MAIN();
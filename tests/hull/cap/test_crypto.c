@@ -6,8 +6,10 @@
 
 #include "utest.h"
 #include "hull/cap/crypto.h"
+#include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
+#include <time.h>
 
 /* ── SHA-256 tests ──────────────────────────────────────────────────── */
 
@@ -67,8 +69,207 @@ UTEST(hl_cap_crypto, sha256_null)
     ASSERT_EQ(rc, -1);
 }
 
+/* Known answers, run against whichever kernel is active */
+static int sha256_kats_pass(void)
+{
+    static const struct { const char *msg; const char *hex; } kats[] = {
+        { "", "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855" },
+        { "abc", "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad" },
+        { "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq",
+          "248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1" },
+        { "abcdefghbcdefghicdefghijdefghijkefghijklfghijklmghijklmnhijklmno"
+          "ijklmnopjklmnopqklmnopqrlmnopqrsmnopqrstnopqrstu",
+          "cf5b16a778af8380036ce59e7b0492370b249b11e8f07a51afac45037afee9d1" },
+    };
+    uint8_t hash[32];
+    char hex[65];
+    for (size_t i = 0; i < sizeof(kats) / sizeof(kats[0]); i++) {
+        hl_cap_crypto_sha256(kats[i].msg, strlen(kats[i].msg), hash);
+        hex_encode(hash, 32, hex);
+        if (strcmp(hex, kats[i].hex) != 0)
+            return 0;
+    }
+
+    /* One million 'a' — exercises multi-block input */
+    size_t n = 1000000;
+    char *a = malloc(n);
+    if (!a)
+        return 0;
+    memset(a, 'a', n);
+    hl_cap_crypto_sha256(a, n, hash);
+    free(a);
+    hex_encode(hash, 32, hex);
+    return strcmp(hex,
+        "cdc76e5c9914fb9281a1c7e284d73e67f1809a48a497200e046d39ccc7112cd0") == 0;
+}
+
+UTEST(hl_cap_crypto, sha256_kat_all_backends)
+{
+    const char *backend = hl_cap_crypto_sha256_backend();
+    ASSERT_TRUE(backend != NULL);
+    ASSERT_TRUE(sha256_kats_pass());
+
+    hl_cap_crypto_sha256_force_portable(1);
+    ASSERT_STREQ(hl_cap_crypto_sha256_backend(), "portable");
+    int ok = sha256_kats_pass();
+    hl_cap_crypto_sha256_force_portable(0);
+    ASSERT_TRUE(ok);
+    ASSERT_STREQ(hl_cap_crypto_sha256_backend(), backend);
+}
+
+UTEST(hl_cap_crypto, sha256_backend_matches_portable)
+{
+    enum { MAX = 1100 };
+    uint8_t *buf = malloc(MAX + 16);
+    ASSERT_TRUE(buf != NULL);
+    ASSERT_EQ(hl_cap_crypto_random(buf, MAX + 16), 0);
+
+    /* Every length across several block boundaries, at odd alignments */
+    int mismatches = 0;
+    for (size_t len = 0; len <= MAX; len++) {
+        const uint8_t *p = buf + (len % 7);
+        uint8_t fast[32], slow[32];
+        hl_cap_crypto_sha256(p, len, fast);
+        hl_cap_crypto_sha256_force_portable(1);
+        hl_cap_crypto_sha256(p, len, slow);
+        hl_cap_crypto_sha256_force_portable(0);
+        if (memcmp(fast, slow, 32) != 0)
+            mismatches++;
+    }
+    free(buf);
+    ASSERT_EQ(mismatches, 0);
+}
+
+static double now_sec(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+/* Throughput report (MB/s, HMACs/s) for the active and portable kernels.
+ * Informational — only checks that both produce identical digests. */
+UTEST(hl_cap_crypto, sha256_throughput)
+{
+    enum { BULK = 8 * 1024 * 1024, HMACS = 100000 };
+    uint8_t *bulk = calloc(1, BULK);
+    ASSERT_TRUE(bulk != NULL);
+    const uint8_t key[32] = { 1, 2, 3 };
+    const uint8_t msg[64] = { 4, 5, 6 };
+    uint8_t digest[2][32], mac[2][32];
+
+    for (int pass = 0; pass < 2; pass++) {
+        hl_cap_crypto_sha256_force_portable(pass);
+        const char *name = hl_cap_crypto_sha256_backend();
+
+        double t0 = now_sec();
+        hl_cap_crypto_sha256(bulk, BULK, digest[pass]);
+        double t1 = now_sec();
+        for (int i = 0; i < HMACS; i++)
+            hl_cap_crypto_hmac_sha256(key, sizeof(key), msg, sizeof(msg),
+                                      mac[pass]);
+        double t2 = now_sec();
+
+        printf("  sha256 %-10s %8.1f MB/s  %10.0f HMAC-SHA256/s (64 B)\n",
+               name, BULK / (t1 - t0) / 1e6, HMACS / (t2 - t1));
+    }
+    hl_cap_crypto_sha256_force_portable(0);
+    free(bulk);
+
+    ASSERT_EQ(memcmp(digest[0], digest[1], 32), 0);
+    ASSERT_EQ(memcmp(mac[0], mac[1], 32), 0);
+}
+
+/* Batched hashing must match one-at-a-time, above and below the
+ * threshold where the batch is split across threads. */
+UTEST(hl_cap_crypto, sha256_many_matches_single)
+{
+    enum { N = 600 };
+    HlSha256Item *items = calloc(N, sizeof(*items));
+    uint8_t *buf = malloc(16384);
+    ASSERT_TRUE(items != NULL && buf != NULL);
+    for (int i = 0; i < 16384; i++)
+        buf[i] = (uint8_t)(i * 131 + 7);
+
+    /* 600 items up to ~16 KB: several MB in total */
+    for (int i = 0; i < N; i++) {
+        items[i].data = buf + (i % 13);
+        items[i].len = (size_t)(i * 97) % 16000;
+    }
+    items[0].data = NULL;   /* empty item may carry no data */
+    items[0].len = 0;
+    ASSERT_EQ(hl_cap_crypto_sha256_many(items, N), 0);
+
+    int mismatches = 0;
+    for (int i = 0; i < N; i++) {
+        uint8_t want[32];
+        hl_cap_crypto_sha256(buf + (i % 13), items[i].len, want);
+        if (memcmp(want, items[i].hash, 32) != 0)
+            mismatches++;
+    }
+    ASSERT_EQ(mismatches, 0);
+
+    /* Small batch stays serial */
+    ASSERT_EQ(hl_cap_crypto_sha256_many(items + 1, 3), 0);
+    ASSERT_EQ(hl_cap_crypto_sha256_many(items, 0), 0);
+
+    free(buf);
+    free(items);
+}
+
+UTEST(hl_cap_crypto, sha256_many_rejects_null_data)
+{
+    HlSha256Item items[2] = { { "abc", 3, {0} }, { NULL, 1, {0} } };
+    ASSERT_EQ(hl_cap_crypto_sha256_many(items, 2), -1);
+    ASSERT_EQ(hl_cap_crypto_sha256_many(NULL, 1), -1);
+}
+
+/* ── HMAC-SHA256 tests ──────────────────────────────────────────────── */
+
+static void hmac_hex(const uint8_t *key, size_t key_len, const char *msg,
+                     char hex[65])
+{
+    uint8_t mac[32];
+    hl_cap_crypto_hmac_sha256(key, key_len, (const uint8_t *)msg,
+                              strlen(msg), mac);
+    hex_encode(mac, 32, hex);
+}
+
+UTEST(hl_cap_crypto, hmac_sha256_rfc4231)
+{
+    char hex[65];
+    uint8_t key[131];
+
+    /* Test case 1 */
+    memset(key, 0x0b, 20);
+    hmac_hex(key, 20, "Hi There", hex);
+    ASSERT_STREQ(hex,
+        "b0344c61d8db38535ca8afceaf0bf12b881dc200c9833da726e9376c2e32cff7");
+
+    /* Test case 2 */
+    hmac_hex((const uint8_t *)"Jefe", 4, "what do ya want for nothing?", hex);
+    ASSERT_STREQ(hex,
+        "5bdcc146bf60754e6a042426089575c75a003f089d2739839dec58b964ec3843");
+
+    /* Test case 6 — key longer than the block size */
+    memset(key, 0xaa, sizeof(key));
+    hmac_hex(key, sizeof(key),
+             "Test Using Larger Than Block-Size Key - Hash Key First", hex);
+    ASSERT_STREQ(hex,
+        "60e431591ee0b67f0d8a26aacbf5b77f8e0bc6213728c5140546040f0ee37f54");
+}
+
 /* ── Random bytes tests ─────────────────────────────────────────────── */
 
+UTEST(hl_cap_crypto, equal)
+{
+    ASSERT_EQ(1, hl_cap_crypto_equal("0123abcd", "0123abcd", 8));
+    ASSERT_EQ(0, hl_cap_crypto_equal("0123abcd", "0123abce", 8));
+    ASSERT_EQ(0, hl_cap_crypto_equal("x123abcd", "0123abcd", 8));
+    ASSERT_EQ(1, hl_cap_crypto_equal("a", "b", 0));
+    ASSERT_EQ(0, hl_cap_crypto_equal(NULL, "a", 1));
+}
+
 UTEST(hl_cap_crypto, random_nonzero)
 {
     uint8_t buf[32];
@@ -170,6 +371,43 @@ UTEST(hl_cap_crypto, pbkdf2_null_args)
     ASSERT_EQ(rc, -1);
 }
 
+UTEST(hl_cap_crypto, pbkdf2_known_answers)
+{
+    char long_pw[101];
+    memset(long_pw, 'x', 100);
+    long_pw[100] = '\0';
+
+    /* Reference values from Python hashlib.pbkdf2_hmac */
+    static const struct {
+        const char *pw, *salt, *hex;
+        size_t out_len;
+    } kats[] = {
+        { "password", "salt",
+          "0394a2ede332c9a13eb82e9b24631604c31df978b4e2f0fbd2c549944f9d79a5",
+          32 },
+        /* > 64-byte password (pre-hashed key), two output blocks */
+        { NULL, "NaCl-salt-0123456789",
+          "07e71054b741d90a36461d734fb059d2fd098e168ae4f30974ae1c9bfe7de40b"
+          "63473133664193e4", 40 },
+    };
+
+    for (int pass = 0; pass < 2; pass++) {
+        hl_cap_crypto_sha256_force_portable(pass);
+        for (size_t i = 0; i < sizeof(kats) / sizeof(kats[0]); i++) {
+            const char *pw = kats[i].pw ? kats[i].pw : long_pw;
+            uint8_t out[40];
+            char hex[81];
+            ASSERT_EQ(hl_cap_crypto_pbkdf2(pw, strlen(pw),
+                                           (const uint8_t *)kats[i].salt,
+                                           strlen(kats[i].salt), 100000,
+                                           out, kats[i].out_len), 0);
+            hex_encode(out, kats[i].out_len, hex);
+            ASSERT_STREQ(hex, kats[i].hex);
+        }
+    }
+    hl_cap_crypto_sha256_force_portable(0);
+}
+
 /* ── Ed25519 tests ─────────────────────────────────────────────────── */
 
 UTEST(hl_cap_crypto, ed25519_keypair)
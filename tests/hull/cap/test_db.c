@@ -390,6 +390,53 @@ UTEST(hl_cap_db, stmt_cache_reuse)
     teardown_db();
 }
 
+/* Runs the same SELECT from inside db.each's callback */
+typedef struct {
+    QueryResult outer;
+    int         inner_rows;
+} EachResult;
+
+static int each_nested_query(void *ctx, HlColumn *cols, int ncols)
+{
+    EachResult *r = (EachResult *)ctx;
+    QueryResult inner = { .count = 0 };
+    hl_cap_db_query(&test_cache, "SELECT name FROM users ORDER BY id",
+                    NULL, 0, collect_rows, &inner, NULL);
+    r->inner_rows += inner.count;
+    collect_rows(&r->outer, cols, ncols);
+    return r->outer.count == 2; /* stop after two rows */
+}
+
+UTEST(hl_cap_db, each_survives_nested_queries)
+{
+    setup_db();
+
+    const char *names[] = { "Alice", "Bob", "Carol" };
+    for (int i = 0; i < 3; i++) {
+        HlValue p[] = { { .type = HL_TYPE_TEXT, .s = names[i],
+                          .len = strlen(names[i]) } };
+        ASSERT_GE(hl_cap_db_exec(&test_cache,
+            "INSERT INTO users (name) VALUES (?)", p, 1), 0);
+    }
+
+    /* The callback's query reuses the cached statement for this SQL;
+     * the cursor has its own, so it keeps its place */
+    EachResult r;
+    memset(&r, 0, sizeof(r));
+    ASSERT_EQ(0, hl_cap_db_each(&test_cache,
+        "SELECT name FROM users ORDER BY id", NULL, 0,
+        each_nested_query, &r, NULL));
+    ASSERT_EQ(2, r.outer.count);
+    ASSERT_STREQ("Alice", r.outer.names[0]);
+    ASSERT_STREQ("Bob", r.outer.names[1]);
+    ASSERT_EQ(6, r.inner_rows);
+
+    ASSERT_EQ(-1, hl_cap_db_each(&test_cache, "SELECT FROM", NULL, 0,
+                                 each_nested_query, &r, NULL));
+
+    teardown_db();
+}
+
 /* ── Namespace check tests ──────────────────────────────────────────── */
 
 UTEST(hl_cap_db, namespace_check_blocks_hull_tables)
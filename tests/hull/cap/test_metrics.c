@@ -0,0 +1,266 @@
+/*
+ * test_metrics.c — Tests for the metrics registry and endpoint
+ *
+ * The registry is process-global, so each test uses its own route
+ * patterns and compares counters before and after.
+ *
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#include "utest.h"
+#include "hull/cap/metrics.h"
+#include "hull/cap/db.h"
+#include "hull/cap/time.h"
+#include "hull/alloc.h"
+#include "hull/runtime.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sqlite3.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+/* Value of the first sample line starting with `series` (-1 if absent) */
+static double sample(const char *text, const char *series)
+{
+    size_t n = strlen(series);
+    for (const char *p = text; p && *p; p = strchr(p, '\n'), p = p ? p + 1 : p) {
+        if (strncmp(p, series, n) == 0 && p[n] == ' ')
+            return atof(p + n + 1);
+    }
+    return -1;
+}
+
+static double scrape(const char *series)
+{
+    size_t len = 0;
+    char *text = hl_metrics_render(&len);
+    if (!text)
+        return -2;
+    double v = sample(text, series);
+    free(text);
+    return v;
+}
+
+/* ── Enable flag ───────────────────────────────────────────────────── */
+
+UTEST(metrics, disabled_is_noop)
+{
+    hl_metrics_enabled = 0;
+    ASSERT_EQ(hl_metrics_route("GET", "/off"), -1);
+    ASSERT_EQ(hl_metrics_start(), (uint64_t)0);
+    hl_metrics_route_end(0, 200, 0);
+    hl_metrics_cap_end(HL_METRIC_DB, 0, 0);
+}
+
+/* ── Route histograms ──────────────────────────────────────────────── */
+
+UTEST(metrics, route_latency_buckets)
+{
+    hl_metrics_enabled = 1;
+    int id = hl_metrics_route("GET", "/tasks/:id");
+    ASSERT_GE(id, 0);
+
+    /* 5 ms ago: lands in the (4.096 ms, 8.192 ms] bucket */
+    uint64_t start = (uint64_t)hl_cap_time_clock_ns() - 5000000ULL;
+    hl_metrics_route_end(id, 200, start);
+    hl_metrics_route_end(id, 404, hl_metrics_start());
+    hl_metrics_enabled = 0;
+
+    ASSERT_EQ(scrape("hull_http_requests_total{method=\"GET\",route=\"/tasks/:id\",code=\"2xx\"}"), 1.0);
+    ASSERT_EQ(scrape("hull_http_requests_total{method=\"GET\",route=\"/tasks/:id\",code=\"4xx\"}"), 1.0);
+    ASSERT_EQ(scrape("hull_http_request_duration_seconds_bucket{method=\"GET\","
+                     "route=\"/tasks/:id\",le=\"0.004096\"}"), 1.0);
+    ASSERT_EQ(scrape("hull_http_request_duration_seconds_bucket{method=\"GET\","
+                     "route=\"/tasks/:id\",le=\"0.008192\"}"), 2.0);
+    ASSERT_EQ(scrape("hull_http_request_duration_seconds_bucket{method=\"GET\","
+                     "route=\"/tasks/:id\",le=\"+Inf\"}"), 2.0);
+    ASSERT_EQ(scrape("hull_http_request_duration_seconds_count{method=\"GET\","
+                     "route=\"/tasks/:id\"}"), 2.0);
+    ASSERT_GE(scrape("hull_http_request_duration_seconds_sum{method=\"GET\","
+                     "route=\"/tasks/:id\"}"), 0.005);
+}
+
+UTEST(metrics, label_is_escaped)
+{
+    hl_metrics_enabled = 1;
+    int id = hl_metrics_route("GET", "/a\"b\\c");
+    ASSERT_GE(id, 0);
+    hl_metrics_route_end(id, 500, hl_metrics_start());
+    hl_metrics_enabled = 0;
+
+    ASSERT_EQ(scrape("hull_http_requests_total{method=\"GET\",route=\"/a\\\"b\\\\c\",code=\"5xx\"}"),
+              1.0);
+}
+
+/* ── Background jobs ───────────────────────────────────────────────── */
+
+UTEST(metrics, job_series)
+{
+    hl_metrics_enabled = 1;
+    int id = hl_metrics_job("cleanup");
+    ASSERT_GE(id, 0);
+    hl_metrics_job_end(id, hl_metrics_start(), 0);
+    hl_metrics_job_end(id, hl_metrics_start(), -1);
+    hl_metrics_job_skipped(id, 3);
+    hl_metrics_enabled = 0;
+
+    ASSERT_EQ(scrape("hull_job_duration_seconds_count{job=\"cleanup\"}"), 2.0);
+    ASSERT_EQ(scrape("hull_job_errors_total{job=\"cleanup\"}"), 1.0);
+    ASSERT_EQ(scrape("hull_job_skipped_total{job=\"cleanup\"}"), 3.0);
+}
+
+/* ── Capabilities ──────────────────────────────────────────────────── */
+
+UTEST(metrics, db_timing_and_stmt_cache)
+{
+    sqlite3 *db = NULL;
+    ASSERT_EQ(sqlite3_open(":memory:", &db), SQLITE_OK);
+    HlStmtCache cache;
+    hl_stmt_cache_init(&cache, db);
+
+    double calls = scrape("hull_cap_duration_seconds_count{cap=\"db\"}");
+    double errors = scrape("hull_cap_errors_total{cap=\"db\"}");
+    double hits = scrape("hull_db_stmt_cache_hits_total");
+    double misses = scrape("hull_db_stmt_cache_misses_total");
+
+    hl_metrics_enabled = 1;
+    ASSERT_EQ(hl_cap_db_exec(&cache, "CREATE TABLE t (x INTEGER)", NULL, 0), 0);
+    HlValue v = { .type = HL_TYPE_INT, .i = 1 };
+    ASSERT_EQ(hl_cap_db_exec(&cache, "INSERT INTO t VALUES (?)", &v, 1), 1);
+    ASSERT_EQ(hl_cap_db_exec(&cache, "INSERT INTO t VALUES (?)", &v, 1), 1);
+    ASSERT_EQ(hl_cap_db_exec(&cache, "INSERT INTO missing VALUES (1)", NULL, 0), -1);
+    hl_metrics_enabled = 0;
+
+    ASSERT_EQ(scrape("hull_cap_duration_seconds_count{cap=\"db\"}"), calls + 4);
+    ASSERT_EQ(scrape("hull_cap_errors_total{cap=\"db\"}"), errors + 1);
+    ASSERT_EQ(scrape("hull_db_stmt_cache_hits_total"), hits + 1);
+    ASSERT_EQ(scrape("hull_db_stmt_cache_misses_total"), misses + 3);
+
+    hl_stmt_cache_destroy(&cache);
+    sqlite3_close(db);
+}
+
+UTEST(metrics, runtime_gauges)
+{
+    HlAllocator alloc;
+    hl_alloc_init(&alloc, 0);
+    void *p = hl_alloc_malloc(&alloc, 4096);
+    ASSERT_TRUE(p != NULL);
+
+    HlRuntime rt;
+    memset(&rt, 0, sizeof(rt));
+    rt.alloc = &alloc;
+    rt.gc_stats.runs = 3;
+    rt.gc_stats.total_ns = 1500000;
+
+    hl_metrics_enabled = 1;
+    hl_metrics_runtime(&rt);
+    hl_metrics_enabled = 0;
+
+    ASSERT_GE(scrape("hull_heap_used_bytes{runtime=\"none\"}"), 4096.0);
+    ASSERT_EQ(scrape("hull_gc_runs_total{runtime=\"none\"}"), 3.0);
+    ASSERT_EQ(scrape("hull_gc_seconds_total{runtime=\"none\"}"), 0.0015);
+
+    hl_alloc_free(&alloc, p, 4096);
+}
+
+/* ── Endpoint ──────────────────────────────────────────────────────── */
+
+static int free_port(void)
+{
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in sa = { .sin_family = AF_INET };
+    sa.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t len = sizeof(sa);
+    if (fd < 0 || bind(fd, (struct sockaddr *)&sa, sizeof(sa)) != 0 ||
+        getsockname(fd, (struct sockaddr *)&sa, &len) != 0) {
+        if (fd >= 0)
+            close(fd);
+        return -1;
+    }
+    close(fd);
+    return ntohs(sa.sin_port);
+}
+
+/* Send one request, return the whole response (malloc'd) */
+static char *http_get(int port, const char *path)
+{
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in sa = { .sin_family = AF_INET, .sin_port = htons((uint16_t)port) };
+    sa.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (fd < 0 || connect(fd, (struct sockaddr *)&sa, sizeof(sa)) != 0) {
+        if (fd >= 0)
+            close(fd);
+        return NULL;
+    }
+    char req[128];
+    int n = snprintf(req, sizeof(req), "GET %s HTTP/1.1\r\nHost: x\r\n\r\n", path);
+    if (write(fd, req, (size_t)n) != n) {
+        close(fd);
+        return NULL;
+    }
+    size_t cap = 65536, len = 0;
+    char *buf = malloc(cap);
+    ssize_t r;
+    while (buf && (r = read(fd, buf + len, cap - len - 1)) > 0) {
+        len += (size_t)r;
+        if (len + 1 == cap) {
+            char *nb = realloc(buf, cap *= 2);
+            if (!nb)
+                free(buf);
+            buf = nb;
+        }
+    }
+    if (buf)
+        buf[len] = '\0';
+    close(fd);
+    return buf;
+}
+
+UTEST(metrics, serves_text_exposition)
+{
+    int port = free_port();
+    ASSERT_GT(port, 0);
+    ASSERT_EQ(hl_metrics_serve("127.0.0.1", port), 0);
+    ASSERT_EQ(hl_metrics_serve("127.0.0.1", port), -1);
+
+    char *resp = http_get(port, "/metrics");
+    ASSERT_TRUE(resp != NULL);
+    ASSERT_EQ(strncmp(resp, "HTTP/1.1 200 OK\r\n", 17), 0);
+    ASSERT_NE(strstr(resp, "Content-Type: text/plain; version=0.0.4\r\n"), NULL);
+    ASSERT_NE(strstr(resp, "# TYPE hull_http_request_duration_seconds histogram\n"), NULL);
+    ASSERT_NE(strstr(resp, "hull_cap_duration_seconds_bucket{cap=\"smtp\",le=\"+Inf\"}"), NULL);
+    free(resp);
+
+    resp = http_get(port, "/other");
+    ASSERT_TRUE(resp != NULL);
+    ASSERT_EQ(strncmp(resp, "HTTP/1.1 404 ", 13), 0);
+    free(resp);
+
+    hl_metrics_stop();
+    hl_metrics_stop(); /* idempotent */
+}
+
+/* ── Benchmark ─────────────────────────────────────────────────────── */
+
+UTEST(metrics, per_request_cost)
+{
+    enum { REQS = 1000000 };
+
+    hl_metrics_enabled = 1;
+    int id = hl_metrics_route("GET", "/bench");
+    ASSERT_GE(id, 0);
+    int64_t t0 = hl_cap_time_clock_ns();
+    for (int i = 0; i < REQS; i++)
+        hl_metrics_route_end(id, 200, hl_metrics_start());
+    int64_t ns = hl_cap_time_clock_ns() - t0;
+    hl_metrics_enabled = 0;
+
+    printf("  route observe %.0f ns/request\n", (double)ns / REQS);
+}
+
+UTEST_MAIN();
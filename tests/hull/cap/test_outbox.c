@@ -0,0 +1,558 @@
+/*
+ * test_outbox.c — Tests for the native outbox dispatcher and the HTTP
+ * keep-alive pool it delivers over
+ *
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#include "utest.h"
+#include "hull/cap/outbox.h"
+#include "hull/cap/db.h"
+#include "hull/cap/http.h"
+#include "hull/cap/time.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sqlite3.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+static void sleep_ms(int ms)
+{
+    struct timespec ts = { ms / 1000, (long)(ms % 1000) * 1000000L };
+    nanosleep(&ts, NULL);
+}
+
+/* ── Backoff ───────────────────────────────────────────────────────── */
+
+UTEST(outbox, backoff_matches_flush)
+{
+    /* 2^attempts * 10 s, capped at an hour */
+    ASSERT_EQ(hl_outbox_backoff(1), (int64_t)20);
+    ASSERT_EQ(hl_outbox_backoff(3), (int64_t)80);
+    ASSERT_EQ(hl_outbox_backoff(8), (int64_t)2560);
+    ASSERT_EQ(hl_outbox_backoff(9), (int64_t)3600);
+    ASSERT_EQ(hl_outbox_backoff(62), (int64_t)3600);
+}
+
+/* ── Mock endpoint ─────────────────────────────────────────────────── */
+
+/*
+ * Keep-alive HTTP/1.1 server, one thread per connection. Answers
+ * POST /ok with 200, /fail with 500 and /close with 200 plus
+ * "Connection: close", each after delay_ms. /drop answers 200 and
+ * hangs up without saying so, as an idle timeout would.
+ */
+#define MOCK_CONNS 32
+
+typedef struct {
+    int             fd;
+    int             delay_ms;
+    volatile int    stop;
+    pthread_t       accept_th;
+    pthread_t       conn_th[MOCK_CONNS];
+    pthread_mutex_t mu;
+    int             conns;      /* connections accepted */
+    int             requests;
+    int             active;     /* requests being answered now */
+    int             max_active;
+    int             auth_seen;  /* requests carrying X-Sig: abc */
+} MockServer;
+
+typedef struct {
+    MockServer *m;
+    int         fd;
+} MockConn;
+
+static void *mock_conn_main(void *arg)
+{
+    MockServer *m = ((MockConn *)arg)->m;
+    int c = ((MockConn *)arg)->fd;
+    free(arg);
+
+    char buf[4096];
+    size_t got = 0;
+    while (!m->stop) {
+        struct pollfd p = { .fd = c, .events = POLLIN };
+        if (poll(&p, 1, 20) <= 0)
+            continue;
+        ssize_t r = read(c, buf + got, sizeof(buf) - 1 - got);
+        if (r <= 0)
+            break;
+        got += (size_t)r;
+        buf[got] = '\0';
+
+        char *eoh = strstr(buf, "\r\n\r\n");
+        if (!eoh)
+            continue;
+        const char *cl = strstr(buf, "Content-Length: ");
+        size_t body = cl && cl < eoh ? strtoul(cl + 16, NULL, 10) : 0;
+        size_t total = (size_t)(eoh - buf) + 4 + body;
+        if (got < total)
+            continue;
+
+        pthread_mutex_lock(&m->mu);
+        m->requests++;
+        if (++m->active > m->max_active)
+            m->max_active = m->active;
+        if (strstr(buf, "\r\nX-Sig: abc\r\n"))
+            m->auth_seen++;
+        pthread_mutex_unlock(&m->mu);
+
+        if (m->delay_ms > 0)
+            sleep_ms(m->delay_ms);
+
+        int close_after = strncmp(buf, "POST /close ", 12) == 0 ||
+                          strncmp(buf, "POST /drop ", 11) == 0;
+        const char *resp;
+        if (strncmp(buf, "POST /fail ", 11) == 0)
+            resp = "HTTP/1.1 500 Internal Server Error\r\nContent-Length: 0\r\n\r\n";
+        else if (strncmp(buf, "POST /close ", 12) == 0)
+            resp = "HTTP/1.1 200 OK\r\nConnection: close\r\nContent-Length: 2\r\n\r\nok";
+        else
+            resp = "HTTP/1.1 200 OK\r\nContent-Length: 2\r\n\r\nok";
+
+        pthread_mutex_lock(&m->mu);
+        m->active--;
+        pthread_mutex_unlock(&m->mu);
+        (void)!write(c, resp, strlen(resp));
+
+        memmove(buf, buf + total, got - total);
+        got -= total;
+        if (close_after)
+            break;
+    }
+    close(c);
+    return NULL;
+}
+
+static void *mock_accept_main(void *arg)
+{
+    MockServer *m = (MockServer *)arg;
+    while (!m->stop) {
+        struct pollfd p = { .fd = m->fd, .events = POLLIN };
+        if (poll(&p, 1, 20) <= 0)
+            continue;
+        int c = accept(m->fd, NULL, NULL);
+        if (c < 0)
+            continue;
+        MockConn *mc = malloc(sizeof(*mc));
+        pthread_mutex_lock(&m->mu);
+        int n = m->conns;
+        pthread_mutex_unlock(&m->mu);
+        if (!mc || n >= MOCK_CONNS) {
+            free(mc);
+            close(c);
+            continue;
+        }
+        mc->m = m;
+        mc->fd = c;
+        if (pthread_create(&m->conn_th[n], NULL, mock_conn_main, mc) != 0) {
+            free(mc);
+            close(c);
+            continue;
+        }
+        pthread_mutex_lock(&m->mu);
+        m->conns++;
+        pthread_mutex_unlock(&m->mu);
+    }
+    return NULL;
+}
+
+/* Returns the port, or -1 */
+static int mock_start(MockServer *m, int delay_ms)
+{
+    memset(m, 0, sizeof(*m));
+    pthread_mutex_init(&m->mu, NULL);
+    m->delay_ms = delay_ms;
+    m->fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (m->fd < 0)
+        return -1;
+    struct sockaddr_in a;
+    memset(&a, 0, sizeof(a));
+    a.sin_family = AF_INET;
+    a.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t len = sizeof(a);
+    if (bind(m->fd, (struct sockaddr *)&a, sizeof(a)) != 0 ||
+        listen(m->fd, 64) != 0 ||
+        getsockname(m->fd, (struct sockaddr *)&a, &len) != 0 ||
+        pthread_create(&m->accept_th, NULL, mock_accept_main, m) != 0) {
+        close(m->fd);
+        return -1;
+    }
+    return ntohs(a.sin_port);
+}
+
+static void mock_stop(MockServer *m)
+{
+    m->stop = 1;
+    pthread_join(m->accept_th, NULL);
+    for (int i = 0; i < m->conns; i++)
+        pthread_join(m->conn_th[i], NULL);
+    close(m->fd);
+    pthread_mutex_destroy(&m->mu);
+}
+
+static const char *loopback[] = { "127.0.0.1" };
+
+static HlHttpConfig loopback_cfg(void)
+{
+    HlHttpConfig cfg = {
+        .allowed_hosts     = loopback,
+        .count             = 1,
+        .timeout_ms        = 2000,
+        .max_response_size = HL_HTTP_DEFAULT_MAX_RESP,
+    };
+    return cfg;
+}
+
+/* ── Keep-alive pool ───────────────────────────────────────────────── */
+
+static int post(const HlHttpConfig *cfg, int port, const char *path)
+{
+    char url[64];
+    snprintf(url, sizeof(url), "http://127.0.0.1:%d%s", port, path);
+    HlHttpResponse resp;
+    if (hl_cap_http_request(cfg, "POST", url, NULL, 0, "x", 1, &resp) != 0)
+        return -1;
+    int status = resp.status;
+    hl_cap_http_free(&resp);
+    return status;
+}
+
+UTEST(http_pool, reuses_connection)
+{
+    MockServer m;
+    int port = mock_start(&m, 0);
+    ASSERT_GT(port, 0);
+
+    HlHttpConfig cfg = loopback_cfg();
+    cfg.pool = hl_http_pool_create(HL_HTTP_DEFAULT_IDLE_MS);
+    ASSERT_TRUE(cfg.pool != NULL);
+
+    for (int i = 0; i < 5; i++)
+        ASSERT_EQ(post(&cfg, port, "/ok"), 200);
+    ASSERT_EQ(post(&cfg, port, "/fail"), 500);
+
+    hl_http_pool_destroy(cfg.pool);
+    mock_stop(&m);
+    EXPECT_EQ(m.requests, 6);
+    EXPECT_EQ(m.conns, 1);
+}
+
+UTEST(http_pool, honours_connection_close)
+{
+    MockServer m;
+    int port = mock_start(&m, 0);
+    ASSERT_GT(port, 0);
+
+    HlHttpConfig cfg = loopback_cfg();
+    cfg.pool = hl_http_pool_create(HL_HTTP_DEFAULT_IDLE_MS);
+    ASSERT_TRUE(cfg.pool != NULL);
+
+    ASSERT_EQ(post(&cfg, port, "/close"), 200);
+    ASSERT_EQ(post(&cfg, port, "/close"), 200);
+    ASSERT_EQ(post(&cfg, port, "/ok"), 200);
+    ASSERT_EQ(post(&cfg, port, "/ok"), 200);
+
+    hl_http_pool_destroy(cfg.pool);
+    mock_stop(&m);
+    EXPECT_EQ(m.requests, 4);
+    EXPECT_EQ(m.conns, 3);
+}
+
+UTEST(http_pool, replaces_connection_closed_while_idle)
+{
+    MockServer m;
+    int port = mock_start(&m, 0);
+    ASSERT_GT(port, 0);
+
+    HlHttpConfig cfg = loopback_cfg();
+    cfg.pool = hl_http_pool_create(HL_HTTP_DEFAULT_IDLE_MS);
+    ASSERT_TRUE(cfg.pool != NULL);
+
+    ASSERT_EQ(post(&cfg, port, "/drop"), 200);
+    sleep_ms(50);   /* the FIN arrives while the connection is pooled */
+    ASSERT_EQ(post(&cfg, port, "/ok"), 200);
+
+    hl_http_pool_destroy(cfg.pool);
+    mock_stop(&m);
+    EXPECT_EQ(m.requests, 2);
+    EXPECT_EQ(m.conns, 2);
+}
+
+UTEST(http_pool, without_pool_one_connection_per_request)
+{
+    MockServer m;
+    int port = mock_start(&m, 0);
+    ASSERT_GT(port, 0);
+
+    HlHttpConfig cfg = loopback_cfg();
+    ASSERT_EQ(post(&cfg, port, "/ok"), 200);
+    ASSERT_EQ(post(&cfg, port, "/ok"), 200);
+
+    mock_stop(&m);
+    EXPECT_EQ(m.conns, 2);
+}
+
+/* ── Dispatcher ────────────────────────────────────────────────────── */
+
+typedef struct {
+    char     path[64];
+    sqlite3 *db;
+} TestDb;
+
+static const char schema[] =
+    "CREATE TABLE _hull_outbox ("
+    " id INTEGER PRIMARY KEY AUTOINCREMENT, kind TEXT NOT NULL,"
+    " destination TEXT NOT NULL, payload TEXT NOT NULL, headers TEXT,"
+    " idempotency_key TEXT, attempts INTEGER NOT NULL DEFAULT 0,"
+    " max_attempts INTEGER NOT NULL DEFAULT 5,"
+    " next_attempt_at INTEGER NOT NULL,"
+    " state TEXT NOT NULL DEFAULT 'pending', created_at INTEGER NOT NULL,"
+    " delivered_at INTEGER, last_error TEXT)";
+
+static int testdb_open(TestDb *t)
+{
+    snprintf(t->path, sizeof(t->path), "/tmp/hull_test_outbox_XXXXXX");
+    int fd = mkstemp(t->path);
+    if (fd < 0)
+        return -1;
+    close(fd);
+    if (sqlite3_open(t->path, &t->db) != SQLITE_OK ||
+        hl_cap_db_init(t->db) != 0 ||
+        sqlite3_exec(t->db, schema, NULL, NULL, NULL) != SQLITE_OK)
+        return -1;
+    return 0;
+}
+
+static void testdb_close(TestDb *t)
+{
+    sqlite3_close(t->db);
+    char side[80];
+    unlink(t->path);
+    snprintf(side, sizeof(side), "%s-wal", t->path);
+    unlink(side);
+    snprintf(side, sizeof(side), "%s-shm", t->path);
+    unlink(side);
+}
+
+static void enqueue(TestDb *t, const char *kind, int port, const char *path,
+                    const char *headers, int attempts, int max_attempts)
+{
+    char dest[64], sql[512];
+    snprintf(dest, sizeof(dest), "http://127.0.0.1:%d%s", port, path);
+    int64_t now = hl_cap_time_now();
+    snprintf(sql, sizeof(sql),
+             "INSERT INTO _hull_outbox (kind, destination, payload, headers, "
+             "attempts, max_attempts, next_attempt_at, created_at) "
+             "VALUES ('%s', '%s', '{\"n\":1}', %s, %d, %d, %lld, %lld)",
+             kind, dest, headers ? headers : "NULL", attempts, max_attempts,
+             (long long)now, (long long)now);
+    sqlite3_exec(t->db, sql, NULL, NULL, NULL);
+}
+
+static int count_where(TestDb *t, const char *where)
+{
+    char sql[256];
+    snprintf(sql, sizeof(sql), "SELECT count(*) FROM _hull_outbox WHERE %s", where);
+    sqlite3_stmt *st;
+    int n = -1;
+    if (sqlite3_prepare_v2(t->db, sql, -1, &st, NULL) == SQLITE_OK &&
+        sqlite3_step(st) == SQLITE_ROW)
+        n = sqlite3_column_int(st, 0);
+    sqlite3_finalize(st);
+    return n;
+}
+
+/* Wait up to 3 s for `where` to match n rows */
+static int wait_rows(TestDb *t, const char *where, int n)
+{
+    for (int i = 0; i < 300; i++) {
+        if (count_where(t, where) == n)
+            return 1;
+        sleep_ms(10);
+    }
+    return 0;
+}
+
+UTEST(outbox, create_rejects_bad_config)
+{
+    HlHttpConfig http = loopback_cfg();
+    HlOutboxConfig cfg = { .db_path = ":memory:", .http = &http, .workers = 1 };
+    ASSERT_TRUE(hl_outbox_create(&cfg) == NULL);
+    cfg.db_path = "";
+    ASSERT_TRUE(hl_outbox_create(&cfg) == NULL);
+    cfg.db_path = "/nonexistent/dir/app.db";
+    ASSERT_TRUE(hl_outbox_create(&cfg) == NULL);
+
+    TestDb t;
+    ASSERT_EQ(testdb_open(&t), 0);
+    cfg.db_path = t.path;
+    cfg.workers = 0;
+    ASSERT_TRUE(hl_outbox_create(&cfg) == NULL);
+    cfg.workers = HL_OUTBOX_MAX_WORKERS + 1;
+    ASSERT_TRUE(hl_outbox_create(&cfg) == NULL);
+    ASSERT_TRUE(hl_outbox_create(NULL) == NULL);
+
+    /* Created but never started */
+    cfg.workers = 2;
+    HlOutbox *ob = hl_outbox_create(&cfg);
+    ASSERT_TRUE(ob != NULL);
+    hl_outbox_wake(ob);
+    ASSERT_EQ(hl_outbox_stats(ob).delivered, (uint64_t)0);
+    hl_outbox_destroy(ob);
+    hl_outbox_destroy(NULL);
+    hl_outbox_wake(NULL);
+    testdb_close(&t);
+}
+
+UTEST(outbox, delivers_retries_and_fails)
+{
+    MockServer m;
+    int port = mock_start(&m, 0);
+    ASSERT_GT(port, 0);
+    TestDb t;
+    ASSERT_EQ(testdb_open(&t), 0);
+
+    enqueue(&t, "webhook", port, "/ok", "'{\"X-Sig\":\"abc\"}'", 0, 5);
+    enqueue(&t, "http", port, "/ok", NULL, 0, 5);
+    enqueue(&t, "webhook", port, "/fail", NULL, 0, 5);     /* retried */
+    enqueue(&t, "webhook", port, "/fail", NULL, 4, 5);     /* last attempt */
+    enqueue(&t, "webhook", port, "/ok", "'not json'", 0, 5);
+    enqueue(&t, "smtp", port, "/ok", NULL, 0, 5);          /* flush()'s */
+
+    HlHttpConfig http = loopback_cfg();
+    HlOutboxConfig cfg = { .db_path = t.path, .http = &http, .workers = 2 };
+    HlOutbox *ob = hl_outbox_create(&cfg);
+    ASSERT_TRUE(ob != NULL);
+    ASSERT_EQ(hl_outbox_start(ob), 0);
+    EXPECT_TRUE(wait_rows(&t, "state = 'delivered'", 2));
+    EXPECT_TRUE(wait_rows(&t, "state = 'failed'", 1));
+    EXPECT_TRUE(wait_rows(&t, "attempts = 1 AND last_error IS NOT NULL", 2));
+    HlOutboxStats s = hl_outbox_stats(ob);
+    hl_outbox_destroy(ob);
+    mock_stop(&m);
+
+    EXPECT_EQ(s.delivered, (uint64_t)2);
+    EXPECT_EQ(s.retried, (uint64_t)2);
+    EXPECT_EQ(s.failed, (uint64_t)1);
+    EXPECT_EQ(m.auth_seen, 1);
+
+    int64_t now = hl_cap_time_now();
+    char where[160];
+    /* Retry scheduled with backoff(1) = 20 s */
+    snprintf(where, sizeof(where),
+             "state = 'pending' AND last_error = 'HTTP 500' AND "
+             "next_attempt_at BETWEEN %lld AND %lld",
+             (long long)now + 15, (long long)now + 25);
+    EXPECT_EQ(count_where(&t, where), 1);
+    EXPECT_EQ(count_where(&t, "state = 'failed' AND attempts = 5 "
+                              "AND last_error = 'HTTP 500'"), 1);
+    EXPECT_EQ(count_where(&t, "last_error = 'invalid headers JSON'"), 1);
+    EXPECT_EQ(count_where(&t, "kind = 'smtp' AND state = 'pending' "
+                              "AND attempts = 0"), 1);
+    EXPECT_EQ(count_where(&t, "delivered_at IS NOT NULL"), 2);
+    testdb_close(&t);
+}
+
+UTEST(outbox, wake_and_concurrency)
+{
+    MockServer m;
+    int port = mock_start(&m, 150);
+    ASSERT_GT(port, 0);
+    TestDb t;
+    ASSERT_EQ(testdb_open(&t), 0);
+
+    /* Long poll: only a wake gets rows inserted after start picked up */
+    HlHttpConfig http = loopback_cfg();
+    HlOutboxConfig cfg = { .db_path = t.path, .http = &http, .workers = 4,
+                           .poll_ms = 60000 };
+    HlOutbox *ob = hl_outbox_create(&cfg);
+    ASSERT_TRUE(ob != NULL);
+    ASSERT_EQ(hl_outbox_start(ob), 0);
+    sleep_ms(50);
+
+    for (int i = 0; i < 8; i++)
+        enqueue(&t, "webhook", port, "/ok", NULL, 0, 5);
+    int64_t t0 = hl_cap_time_clock_ns();
+    hl_outbox_wake(ob);
+    EXPECT_TRUE(wait_rows(&t, "state = 'delivered'", 8));
+    int64_t ms = (hl_cap_time_clock_ns() - t0) / 1000000;
+    hl_outbox_destroy(ob);
+    mock_stop(&m);
+
+    /* 8 x 150 ms serially; 4 at a time is two rounds */
+    EXPECT_GE(m.max_active, 2);
+    EXPECT_LT(ms, (int64_t)1000);
+    EXPECT_LE(m.conns, 4);
+    testdb_close(&t);
+}
+
+UTEST(outbox, claimed_rows_are_leased)
+{
+    MockServer m;
+    int port = mock_start(&m, 300);
+    ASSERT_GT(port, 0);
+    TestDb t;
+    ASSERT_EQ(testdb_open(&t), 0);
+    enqueue(&t, "webhook", port, "/ok", NULL, 0, 5);
+
+    HlHttpConfig http = loopback_cfg();
+    HlOutboxConfig cfg = { .db_path = t.path, .http = &http, .workers = 1 };
+    HlOutbox *ob = hl_outbox_create(&cfg);
+    ASSERT_TRUE(ob != NULL);
+    ASSERT_EQ(hl_outbox_start(ob), 0);
+
+    /* While in flight the row is pending but not due for flush() */
+    char where[96];
+    snprintf(where, sizeof(where), "state = 'pending' AND next_attempt_at > %lld",
+             (long long)hl_cap_time_now() + HL_OUTBOX_LEASE_S / 2);
+    EXPECT_TRUE(wait_rows(&t, where, 1));
+    EXPECT_TRUE(wait_rows(&t, "state = 'delivered'", 1));
+    hl_outbox_destroy(ob);
+    mock_stop(&m);
+
+    EXPECT_EQ(m.requests, 1);
+    testdb_close(&t);
+}
+
+UTEST(outbox, stop_joins_before_destroy)
+{
+    MockServer m;
+    int port = mock_start(&m, 0);
+    ASSERT_GT(port, 0);
+    TestDb t;
+    ASSERT_EQ(testdb_open(&t), 0);
+    enqueue(&t, "webhook", port, "/ok", NULL, 0, 5);
+
+    HlHttpConfig http = loopback_cfg();
+    HlOutboxConfig cfg = { .db_path = t.path, .http = &http, .workers = 2 };
+    HlOutbox *ob = hl_outbox_create(&cfg);
+    ASSERT_TRUE(ob != NULL);
+    ASSERT_EQ(hl_outbox_start(ob), 0);
+    EXPECT_TRUE(wait_rows(&t, "state = 'delivered'", 1));
+
+    /* Shutdown stops the threads early (before the audit ring and log
+     * sink go) and destroys later; nothing is delivered in between. */
+    hl_outbox_stop(ob);
+    hl_outbox_stop(ob);
+    enqueue(&t, "webhook", port, "/ok", NULL, 0, 5);
+    hl_outbox_wake(ob);
+    sleep_ms(100);
+    EXPECT_EQ(count_where(&t, "state = 'pending'"), 1);
+    EXPECT_EQ(hl_outbox_stats(ob).delivered, (uint64_t)1);
+    hl_outbox_destroy(ob);
+    mock_stop(&m);
+
+    EXPECT_EQ(m.requests, 1);
+    testdb_close(&t);
+}
+
+UTEST_MAIN();
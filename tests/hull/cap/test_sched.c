@@ -0,0 +1,501 @@
+/*
+ * test_sched.c — Tests for the timer wheel, cron schedules and the
+ * background job scheduler
+ *
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#include "utest.h"
+#include "hull/cap/sched.h"
+#include "hull/runtime.h"
+
+#include <keel/allocator.h>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+/* 2024-01-01 00:00:00 UTC, a Monday */
+#define JAN1 1704067200LL
+#define DAY  86400LL
+
+static int list_len(HlTimer *t)
+{
+    int n = 0;
+    for (; t; t = t->next)
+        n++;
+    return n;
+}
+
+/* ── Timer wheel ───────────────────────────────────────────────────── */
+
+UTEST(wheel, expires_on_its_tick)
+{
+    HlWheel w;
+    HlTimer t = {0};
+    hl_wheel_init(&w, 0);
+    ASSERT_EQ(hl_wheel_next(&w), UINT64_MAX);
+
+    hl_wheel_add(&w, &t, 5);
+    ASSERT_EQ(hl_wheel_next(&w), (uint64_t)5);
+    ASSERT_TRUE(hl_wheel_advance(&w, 4) == NULL);
+    ASSERT_TRUE(hl_wheel_advance(&w, 5) == &t);
+    ASSERT_TRUE(t.pprev == NULL);
+    ASSERT_EQ(hl_wheel_next(&w), UINT64_MAX);
+}
+
+UTEST(wheel, past_deadline_fires_next_tick)
+{
+    HlWheel w;
+    HlTimer t = {0};
+    hl_wheel_init(&w, 100);
+    hl_wheel_add(&w, &t, 50);
+    ASSERT_EQ(t.expires, (uint64_t)101);
+    ASSERT_TRUE(hl_wheel_advance(&w, 101) == &t);
+}
+
+UTEST(wheel, cascades_from_higher_levels)
+{
+    HlWheel w;
+    HlTimer a = {0}, b = {0}, c = {0};
+    hl_wheel_init(&w, 3);
+
+    hl_wheel_add(&w, &a, 64 * 3 + 7);             /* level 1 */
+    hl_wheel_add(&w, &b, 64 * 64 * 2 + 1);        /* level 2 */
+    hl_wheel_add(&w, &c, 64ULL * 64 * 64 * 5 + 9); /* level 3 */
+    ASSERT_LE(hl_wheel_next(&w), a.expires);
+
+    /* Tick by tick: nothing fires early */
+    for (uint64_t now = 4; now < a.expires; now++)
+        ASSERT_TRUE(hl_wheel_advance(&w, now) == NULL);
+    ASSERT_TRUE(hl_wheel_advance(&w, a.expires) == &a);
+
+    /* One big step expires b on the way */
+    HlTimer *due = hl_wheel_advance(&w, b.expires + 10);
+    ASSERT_TRUE(due == &b);
+    ASSERT_EQ(list_len(due), 1);
+
+    ASSERT_TRUE(hl_wheel_advance(&w, c.expires - 1) == NULL);
+    ASSERT_TRUE(hl_wheel_advance(&w, c.expires) == &c);
+    ASSERT_EQ(hl_wheel_next(&w), UINT64_MAX);
+}
+
+UTEST(wheel, same_tick_returns_all)
+{
+    HlWheel w;
+    HlTimer t[3] = {{0}};
+    hl_wheel_init(&w, 0);
+    for (int i = 0; i < 3; i++)
+        hl_wheel_add(&w, &t[i], 200);
+    ASSERT_EQ(list_len(hl_wheel_advance(&w, 200)), 3);
+}
+
+UTEST(wheel, del_and_rearm)
+{
+    HlWheel w;
+    HlTimer a = {0}, b = {0};
+    hl_wheel_init(&w, 0);
+    hl_wheel_add(&w, &a, 10);
+    hl_wheel_add(&w, &b, 10);
+
+    hl_wheel_del(&a);
+    ASSERT_TRUE(a.pprev == NULL);
+    hl_wheel_del(&a);               /* not on the wheel: no-op */
+
+    /* Re-adding moves the timer */
+    hl_wheel_add(&w, &b, 20);
+    ASSERT_TRUE(hl_wheel_advance(&w, 19) == NULL);
+    ASSERT_TRUE(hl_wheel_advance(&w, 20) == &b);
+}
+
+UTEST(wheel, far_deadline_clamped_to_span)
+{
+    HlWheel w;
+    HlTimer t = {0};
+    uint64_t span = 1ULL << (HL_WHEEL_BITS * HL_WHEEL_LEVELS);
+    hl_wheel_init(&w, 0);
+    hl_wheel_add(&w, &t, span * 10);
+    ASSERT_EQ(t.expires, span - 1);
+    ASSERT_TRUE(hl_wheel_advance(&w, span - 2) == NULL);
+    ASSERT_TRUE(hl_wheel_advance(&w, span - 1) == &t);
+}
+
+/* ── Cron ──────────────────────────────────────────────────────────── */
+
+static int64_t cron_next(const char *expr, int64_t after)
+{
+    HlCron c;
+    if (hl_cron_parse(expr, &c) != 0)
+        return -2;
+    return hl_cron_next(&c, after);
+}
+
+UTEST(cron, steps_and_strictly_after)
+{
+    ASSERT_EQ(cron_next("*/15 * * * *", JAN1), JAN1 + 900);
+    ASSERT_EQ(cron_next("* * * * *", JAN1 + 30), JAN1 + 60);
+    ASSERT_EQ(cron_next("0 0 * * *", JAN1), JAN1 + DAY);
+    ASSERT_EQ(cron_next("5/20 * * * *", JAN1 + 25 * 60), JAN1 + 45 * 60);
+}
+
+UTEST(cron, lists_and_ranges)
+{
+    /* Saturday Jan 6 -> Monday Jan 8, 09:30 */
+    ASSERT_EQ(cron_next("30 9 * * 1-5", JAN1 + 5 * DAY),
+              JAN1 + 7 * DAY + 9 * 3600 + 1800);
+    ASSERT_EQ(cron_next("0 6,18 * * *", JAN1 + 7 * 3600),
+              JAN1 + 18 * 3600);
+}
+
+UTEST(cron, day_fields)
+{
+    /* 7 is Sunday too: Jan 7 */
+    ASSERT_EQ(cron_next("0 12 * * 7", JAN1), JAN1 + 6 * DAY + 43200);
+    /* Both restricted: the 13th or a Friday, whichever is first */
+    ASSERT_EQ(cron_next("0 0 13 * 5", JAN1), JAN1 + 4 * DAY);
+    /* Only the day of month restricted */
+    ASSERT_EQ(cron_next("0 0 13 * *", JAN1), JAN1 + 12 * DAY);
+    /* Next Feb 29 after 2024's is in 2028 */
+    ASSERT_EQ(cron_next("0 0 29 2 *", JAN1 + 60 * DAY), JAN1 + 1520 * DAY);
+    /* Never */
+    ASSERT_EQ(cron_next("0 0 30 2 *", JAN1), -1);
+}
+
+UTEST(cron, macros)
+{
+    ASSERT_EQ(cron_next("@hourly", JAN1 + 1), JAN1 + 3600);
+    ASSERT_EQ(cron_next("@daily", JAN1), JAN1 + DAY);
+    ASSERT_EQ(cron_next("@midnight", JAN1), JAN1 + DAY);
+    ASSERT_EQ(cron_next("@weekly", JAN1), JAN1 + 6 * DAY);
+    ASSERT_EQ(cron_next("@monthly", JAN1 + 14 * DAY), JAN1 + 31 * DAY);
+    ASSERT_EQ(cron_next("@yearly", JAN1), JAN1 + 366 * DAY);
+}
+
+UTEST(cron, rejects_invalid)
+{
+    HlCron c;
+    ASSERT_EQ(hl_cron_parse("", &c), -1);
+    ASSERT_EQ(hl_cron_parse("* * * *", &c), -1);
+    ASSERT_EQ(hl_cron_parse("* * * * * *", &c), -1);
+    ASSERT_EQ(hl_cron_parse("60 * * * *", &c), -1);
+    ASSERT_EQ(hl_cron_parse("* 24 * * *", &c), -1);
+    ASSERT_EQ(hl_cron_parse("* * 0 * *", &c), -1);
+    ASSERT_EQ(hl_cron_parse("* * * 13 *", &c), -1);
+    ASSERT_EQ(hl_cron_parse("* * * * 8", &c), -1);
+    ASSERT_EQ(hl_cron_parse("5-1 * * * *", &c), -1);
+    ASSERT_EQ(hl_cron_parse("*/0 * * * *", &c), -1);
+    ASSERT_EQ(hl_cron_parse("a * * * *", &c), -1);
+    ASSERT_EQ(hl_cron_parse("1,,2 * * * *", &c), -1);
+    ASSERT_EQ(hl_cron_parse("@never", &c), -1);
+}
+
+/* ── Intervals and job definitions ─────────────────────────────────── */
+
+UTEST(sched, interval_parse)
+{
+    int64_t ms = 0;
+    ASSERT_EQ(hl_sched_interval_parse("500ms", &ms), 0);
+    ASSERT_EQ(ms, 500);
+    ASSERT_EQ(hl_sched_interval_parse("10", &ms), 0);
+    ASSERT_EQ(ms, 10000);
+    ASSERT_EQ(hl_sched_interval_parse("30s", &ms), 0);
+    ASSERT_EQ(ms, 30000);
+    ASSERT_EQ(hl_sched_interval_parse("5m", &ms), 0);
+    ASSERT_EQ(ms, 300000);
+    ASSERT_EQ(hl_sched_interval_parse("2h", &ms), 0);
+    ASSERT_EQ(ms, 7200000);
+    ASSERT_EQ(hl_sched_interval_parse("1d", &ms), 0);
+    ASSERT_EQ(ms, 86400000);
+
+    ASSERT_EQ(hl_sched_interval_parse("", &ms), -1);
+    ASSERT_EQ(hl_sched_interval_parse("-5", &ms), -1);
+    ASSERT_EQ(hl_sched_interval_parse("1.5s", &ms), -1);
+    ASSERT_EQ(hl_sched_interval_parse("5x", &ms), -1);
+    ASSERT_EQ(hl_sched_interval_parse("50ms", &ms), -1);   /* too short */
+    ASSERT_EQ(hl_sched_interval_parse("367d", &ms), -1);   /* too long */
+    ASSERT_EQ(hl_sched_interval_parse("99999999999999999999", &ms), -1);
+}
+
+UTEST(sched, job_def)
+{
+    HlJobDef d;
+    ASSERT_EQ(hl_sched_job_def(&d, "every", "1000", "tick", 50, 3), 0);
+    ASSERT_EQ(d.every_ms, 1000);
+    ASSERT_EQ(d.jitter_ms, 50);
+    ASSERT_EQ(d.handler_id, 3);
+    ASSERT_STREQ(d.name, "tick");
+
+    ASSERT_EQ(hl_sched_job_def(&d, "at", "0 3 * * *", NULL, 0, 1), 0);
+    ASSERT_EQ(d.every_ms, 0);
+    ASSERT_STREQ(d.name, "0 3 * * *");
+
+    ASSERT_EQ(hl_sched_job_def(&d, "every", "50", NULL, 0, 0), -1);
+    ASSERT_EQ(hl_sched_job_def(&d, "every", "1s", NULL, 0, 0), -1);
+    ASSERT_EQ(hl_sched_job_def(&d, "at", "bad", NULL, 0, 0), -1);
+    ASSERT_EQ(hl_sched_job_def(&d, "later", "1000", NULL, 0, 0), -1);
+    ASSERT_EQ(hl_sched_job_def(&d, "every", "1000", NULL, -1, 0), -1);
+}
+
+/* ── Scheduler ─────────────────────────────────────────────────────── */
+
+/*
+ * Stand-in for the server: answers each trigger after delay_ms and
+ * counts them per job id. One connection at a time, like the loop.
+ * With sched set, each trigger also goes through hl_sched_middleware
+ * three times: via a proxy, as sent, and replayed.
+ */
+typedef struct {
+    int fd;
+    int delay_ms;
+    volatile int stop;
+    int hits[4];
+    int bad;            /* requests without the token or a valid id */
+    HlSched *sched;
+    int runs;           /* middleware calls that ran the job */
+    int refused;        /* middleware calls that did not */
+} MockServer;
+
+static int fake_runs;
+
+static int fake_run_job(HlRuntime *rt, int handler_id)
+{
+    (void)rt;
+    (void)handler_id;
+    fake_runs++;
+    return 0;
+}
+
+static const HlRuntimeVtable fake_vt = { .run_job = fake_run_job, .name = "fake" };
+
+/* Parse "Name: value" lines after the request line into req */
+static void mock_parse(char *buf, KlRequest *req)
+{
+    memset(req, 0, sizeof(*req));
+    req->method = "POST";
+    req->method_len = 4;
+    req->path = HL_SCHED_PATH;
+    req->path_len = strlen(HL_SCHED_PATH);
+    char *line = strstr(buf, "\r\n");
+    while (line && req->num_headers < KL_MAX_HEADERS - 1) {
+        line += 2;
+        char *end = strstr(line, "\r\n");
+        char *colon = end ? memchr(line, ':', (size_t)(end - line)) : NULL;
+        if (!colon)
+            break;
+        KlHeader *h = &req->headers[req->num_headers++];
+        h->name = line;
+        h->name_len = (size_t)(colon - line);
+        h->value = colon + 2;
+        h->value_len = (size_t)(end - colon - 2);
+        line = end;
+    }
+}
+
+static void mock_dispatch(MockServer *m, KlRequest *req)
+{
+    KlAllocator alloc = kl_allocator_default();
+    KlResponse res;
+    memset(&res, 0, sizeof(res));
+    kl_response_init(&res, &alloc);
+    int before = fake_runs;
+    hl_sched_middleware(req, &res, m->sched);
+    if (fake_runs > before)
+        m->runs++;
+    else
+        m->refused++;
+    kl_response_free(&res);
+}
+
+static void *mock_main(void *arg)
+{
+    MockServer *m = (MockServer *)arg;
+    while (!m->stop) {
+        struct pollfd p = { .fd = m->fd, .events = POLLIN };
+        if (poll(&p, 1, 20) <= 0)
+            continue;
+        int c = accept(m->fd, NULL, NULL);
+        if (c < 0)
+            continue;
+
+        char buf[1024];
+        size_t got = 0;
+        while (got < sizeof(buf) - 1) {
+            ssize_t r = read(c, buf + got, sizeof(buf) - 1 - got);
+            if (r <= 0)
+                break;
+            got += (size_t)r;
+            buf[got] = '\0';
+            if (strstr(buf, "\r\n\r\n"))
+                break;
+        }
+        buf[got] = '\0';
+
+        const char *tok = strstr(buf, "\r\n" HL_SCHED_HEADER ": ");
+        const char *id = strstr(buf, "\r\n" HL_SCHED_ID_HEADER ": ");
+        int n = id ? atoi(id + strlen("\r\n" HL_SCHED_ID_HEADER ": ")) : -1;
+        if (strncmp(buf, "POST " HL_SCHED_PATH " ", strlen(HL_SCHED_PATH) + 6) != 0 ||
+            !tok || strcspn(tok + strlen("\r\n" HL_SCHED_HEADER ": "), "\r") != 32 ||
+            n < 0 || n >= 4)
+            m->bad++;
+        else
+            m->hits[n]++;
+
+        if (m->sched) {
+            KlRequest req;
+            mock_parse(buf, &req);
+            KlHeader *fwd = &req.headers[req.num_headers++];
+            fwd->name = "X-Forwarded-For";
+            fwd->name_len = strlen(fwd->name);
+            fwd->value = "203.0.113.7";
+            fwd->value_len = strlen(fwd->value);
+            mock_dispatch(m, &req);
+            req.num_headers--;
+            mock_dispatch(m, &req);
+            mock_dispatch(m, &req);
+        }
+
+        if (m->delay_ms > 0) {
+            struct timespec ts = { m->delay_ms / 1000,
+                                   (long)(m->delay_ms % 1000) * 1000000L };
+            nanosleep(&ts, NULL);
+        }
+        static const char ok[] =
+            "HTTP/1.1 200 OK\r\nContent-Length: 3\r\n\r\nok\n";
+        (void)!write(c, ok, sizeof(ok) - 1);
+        close(c);
+    }
+    return NULL;
+}
+
+static int mock_start(MockServer *m, pthread_t *th, int delay_ms)
+{
+    memset(m, 0, sizeof(*m));
+    m->delay_ms = delay_ms;
+    m->fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (m->fd < 0)
+        return -1;
+    struct sockaddr_in a;
+    memset(&a, 0, sizeof(a));
+    a.sin_family = AF_INET;
+    a.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (bind(m->fd, (struct sockaddr *)&a, sizeof(a)) != 0 ||
+        listen(m->fd, 16) != 0 ||
+        pthread_create(th, NULL, mock_main, m) != 0) {
+        close(m->fd);
+        return -1;
+    }
+    return 0;
+}
+
+static void mock_stop(MockServer *m, pthread_t th)
+{
+    m->stop = 1;
+    pthread_join(th, NULL);
+    close(m->fd);
+}
+
+static void sleep_ms(int ms)
+{
+    struct timespec ts = { ms / 1000, (long)(ms % 1000) * 1000000L };
+    nanosleep(&ts, NULL);
+}
+
+UTEST(sched, create_rejects_bad_args)
+{
+    HlJobDef d;
+    HlRuntime *rt = NULL;
+    ASSERT_EQ(hl_sched_job_def(&d, "every", "1000", NULL, 0, 0), 0);
+    ASSERT_TRUE(hl_sched_create(&d, 0, &rt) == NULL);
+    ASSERT_TRUE(hl_sched_create(&d, HL_SCHED_MAX_JOBS + 1, &rt) == NULL);
+    ASSERT_TRUE(hl_sched_create(&d, 1, NULL) == NULL);
+    hl_sched_destroy(NULL);
+
+    /* Created but never started */
+    HlSched *s = hl_sched_create(&d, 1, &rt);
+    ASSERT_TRUE(s != NULL);
+    hl_sched_destroy(s);
+}
+
+UTEST(sched, fires_each_job_on_its_interval)
+{
+    MockServer m;
+    pthread_t th;
+    HlRuntime *rt = NULL;
+    HlJobDef d[2];
+    ASSERT_EQ(hl_sched_job_def(&d[0], "every", "100", "fast", 0, 0), 0);
+    ASSERT_EQ(hl_sched_job_def(&d[1], "every", "300", "slow", 0, 1), 0);
+    ASSERT_EQ(mock_start(&m, &th, 0), 0);
+
+    HlSched *s = hl_sched_create(d, 2, &rt);
+    ASSERT_TRUE(s != NULL);
+    ASSERT_EQ(hl_sched_start(s, m.fd, NULL), 0);
+    sleep_ms(750);
+    hl_sched_destroy(s);
+    mock_stop(&m, th);
+
+    EXPECT_EQ(m.bad, 0);
+    /* 7 and 2 on time; leave room for a slow machine */
+    EXPECT_GE(m.hits[0], 4);
+    EXPECT_LE(m.hits[0], 8);
+    EXPECT_GE(m.hits[1], 1);
+    EXPECT_LE(m.hits[1], 2);
+}
+
+UTEST(sched, slow_runs_skip_instead_of_queueing)
+{
+    MockServer m;
+    pthread_t th;
+    HlRuntime *rt = NULL;
+    HlJobDef d;
+    ASSERT_EQ(hl_sched_job_def(&d, "every", "100", "busy", 0, 0), 0);
+    ASSERT_EQ(mock_start(&m, &th, 350), 0);
+
+    HlSched *s = hl_sched_create(&d, 1, &rt);
+    ASSERT_TRUE(s != NULL);
+    ASSERT_EQ(hl_sched_start(s, m.fd, NULL), 0);
+    sleep_ms(1000);
+    hl_sched_destroy(s);
+    mock_stop(&m, th);
+
+    /* One run per ~400ms, not one per 100ms */
+    EXPECT_EQ(m.bad, 0);
+    EXPECT_GE(m.hits[0], 1);
+    EXPECT_LE(m.hits[0], 3);
+}
+
+UTEST(sched, endpoint_runs_only_the_open_trigger)
+{
+    MockServer m;
+    pthread_t th;
+    HlRuntime fake;
+    memset(&fake, 0, sizeof(fake));
+    fake.vt = &fake_vt;
+    HlRuntime *rt = &fake;
+    HlJobDef d;
+    ASSERT_EQ(hl_sched_job_def(&d, "every", "100", "job", 0, 0), 0);
+    ASSERT_EQ(mock_start(&m, &th, 0), 0);
+
+    HlSched *s = hl_sched_create(&d, 1, &rt);
+    ASSERT_TRUE(s != NULL);
+    m.sched = s;
+    ASSERT_EQ(hl_sched_start(s, m.fd, NULL), 0);
+    sleep_ms(450);
+    hl_sched_destroy(s);
+    mock_stop(&m, th);
+
+    /* Each trigger ran once; the proxied copy and the replay did not */
+    EXPECT_EQ(m.bad, 0);
+    EXPECT_GE(m.hits[0], 2);
+    EXPECT_EQ(m.runs, m.hits[0]);
+    EXPECT_EQ(m.refused, 2 * m.hits[0]);
+}
+
+UTEST_MAIN();
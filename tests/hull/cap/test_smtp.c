@@ -418,4 +418,31 @@ UTEST(smtp_send, invalid_port)
     ASSERT_NE(0, hl_cap_smtp_send(&cfg, &msg));
 }
 
+/* ── EHLO extensions ────────────────────────────────────────────── */
+
+UTEST(smtp_ehlo, pipelining_and_starttls)
+{
+    unsigned ext = hl_smtp_parse_ehlo("250-mail.example.com Hello\r\n"
+                                      "250-SIZE 35882577\r\n"
+                                      "250-PIPELINING\r\n"
+                                      "250-starttls\r\n"
+                                      "250 AUTH PLAIN LOGIN\r\n");
+    ASSERT_EQ((unsigned)(HL_SMTP_EXT_PIPELINING | HL_SMTP_EXT_STARTTLS), ext);
+}
+
+UTEST(smtp_ehlo, none_advertised)
+{
+    ASSERT_EQ(0u, hl_smtp_parse_ehlo("250 mail.example.com\r\n"));
+    ASSERT_EQ(0u, hl_smtp_parse_ehlo(""));
+    ASSERT_EQ(0u, hl_smtp_parse_ehlo(NULL));
+}
+
+UTEST(smtp_ehlo, greeting_line_ignored)
+{
+    /* The first line is the server's domain, not a keyword */
+    ASSERT_EQ(0u, hl_smtp_parse_ehlo("250-PIPELINING\r\n250 8BITMIME\r\n"));
+    /* Keywords must match whole */
+    ASSERT_EQ(0u, hl_smtp_parse_ehlo("250-mx\r\n250 PIPELININGX\r\n"));
+}
+
 UTEST_MAIN();
@@ -1,10 +1,11 @@
 /*
  * test_smtp_e2e.c — End-to-end SMTP tests with in-process mock server
  *
- * A mock SMTP server on a background thread accepts one connection,
- * speaks the SMTP protocol, and captures the conversation.  Tests
- * verify the full path: connect → greeting → EHLO → AUTH → MAIL FROM
- * → RCPT TO → DATA → QUIT over real TCP sockets.
+ * A mock SMTP server on a background thread accepts one connection
+ * (or max_conns, one after another), speaks the SMTP protocol, and
+ * captures the conversation.  Tests verify the full path: connect →
+ * greeting → EHLO → AUTH → MAIL FROM → RCPT TO → DATA → QUIT over real
+ * TCP sockets, and session reuse across messages.
  *
  * SPDX-License-Identifier: AGPL-3.0-or-later
  */
@@ -13,6 +14,7 @@
 #include "hull/cap/smtp.h"
 
 #include <netinet/in.h>
+#include <poll.h>
 #include <pthread.h>
 #include <string.h>
 #include <strings.h>
@@ -38,9 +40,19 @@ typedef struct {
     int             data_len;
     int             quit_seen;
 
+    /* Across all connections */
+    int             connections;
+    int             messages;        /* accepted at end of DATA */
+    int             rset_seen;
+    int             pipelined;       /* commands queued behind MAIL FROM */
+
     /* Configurable behavior */
     int             reject_rcpt;
     int             require_auth;
+    int             advertise_pipelining;
+    const char     *reject_rcpt_match; /* 550 for RCPT TO containing this */
+    int             max_conns;       /* connections to serve (default 1) */
+    volatile int    stop;
 } MockSmtp;
 
 /* Read one CRLF-terminated line from the client */
@@ -68,14 +80,8 @@ static int mock_send(int fd, const char *s)
     return (w == (ssize_t)len) ? 0 : -1;
 }
 
-static void *mock_smtp_thread(void *arg)
+static void mock_smtp_session(MockSmtp *m, int client)
 {
-    MockSmtp *m = (MockSmtp *)arg;
-
-    int client = accept(m->listen_fd, NULL, NULL);
-    if (client < 0)
-        return NULL;
-
     /* 220 greeting */
     mock_send(client, "220 mock.local ESMTP\r\n");
 
@@ -87,6 +93,7 @@ static void *mock_smtp_thread(void *arg)
             /* Data terminator: standalone ".\r\n" */
             if (strcmp(line, ".\r\n") == 0) {
                 in_data = 0;
+                m->messages++;
                 mock_send(client, "250 OK\r\n");
                 continue;
             }
@@ -107,9 +114,14 @@ static void *mock_smtp_thread(void *arg)
                 memcpy(m->ehlo_host, line + 5, (size_t)hlen);
                 m->ehlo_host[hlen] = '\0';
             }
-            if (m->require_auth)
+            if (m->require_auth && m->advertise_pipelining)
+                mock_send(client, "250-mock.local\r\n250-PIPELINING\r\n"
+                                  "250 AUTH PLAIN\r\n");
+            else if (m->require_auth)
                 mock_send(client,
                           "250-mock.local\r\n250 AUTH PLAIN\r\n");
+            else if (m->advertise_pipelining)
+                mock_send(client, "250-mock.local\r\n250 PIPELINING\r\n");
             else
                 mock_send(client, "250 mock.local\r\n");
         }
@@ -123,6 +135,11 @@ static void *mock_smtp_thread(void *arg)
             mock_send(client, "235 OK\r\n");
         }
         else if (strncasecmp(line, "MAIL FROM:", 10) == 0) {
+            /* RCPT TO already waiting means the client did not wait
+             * for this reply */
+            char peek;
+            if (recv(client, &peek, 1, MSG_PEEK | MSG_DONTWAIT) == 1)
+                m->pipelined = 1;
             const char *lt = strchr(line, '<');
             const char *gt = strchr(line, '>');
             if (lt && gt && gt > lt) {
@@ -135,7 +152,9 @@ static void *mock_smtp_thread(void *arg)
             mock_send(client, "250 OK\r\n");
         }
         else if (strncasecmp(line, "RCPT TO:", 8) == 0) {
-            if (m->reject_rcpt) {
+            if (m->reject_rcpt ||
+                (m->reject_rcpt_match &&
+                 strstr(line, m->reject_rcpt_match))) {
                 mock_send(client, "550 Rejected\r\n");
             } else {
                 const char *lt = strchr(line, '<');
@@ -156,14 +175,37 @@ static void *mock_smtp_thread(void *arg)
             in_data = 1;
             mock_send(client, "354 Go\r\n");
         }
+        else if (strncasecmp(line, "RSET", 4) == 0) {
+            m->rset_seen++;
+            mock_send(client, "250 OK\r\n");
+        }
         else if (strncasecmp(line, "QUIT", 4) == 0) {
             m->quit_seen = 1;
             mock_send(client, "221 Bye\r\n");
             break;
         }
     }
+}
 
-    close(client);
+static void *mock_smtp_thread(void *arg)
+{
+    MockSmtp *m = (MockSmtp *)arg;
+
+    while (!m->stop &&
+           m->connections < (m->max_conns > 0 ? m->max_conns : 1)) {
+        /* Poll so mock_smtp_stop() can end a server still waiting for
+         * a connection that never comes */
+        struct pollfd pfd = { .fd = m->listen_fd, .events = POLLIN };
+        if (poll(&pfd, 1, 50) <= 0)
+            continue;
+
+        int client = accept(m->listen_fd, NULL, NULL);
+        if (client < 0)
+            break;
+        m->connections++;
+        mock_smtp_session(m, client);
+        close(client);
+    }
     return NULL;
 }
 
@@ -197,7 +239,7 @@ static int mock_smtp_start(MockSmtp *m)
     }
     m->port = ntohs(addr.sin_port);
 
-    if (listen(fd, 1) < 0) {
+    if (listen(fd, 4) < 0) {
         close(fd);
         return -1;
     }
@@ -214,12 +256,12 @@ static int mock_smtp_start(MockSmtp *m)
 
 static void mock_smtp_stop(MockSmtp *m)
 {
-    /* Close listen fd to unblock accept() if no client connected */
+    m->stop = 1;
+    pthread_join(m->tid, NULL);
     if (m->listen_fd >= 0) {
         close(m->listen_fd);
         m->listen_fd = -1;
     }
-    pthread_join(m->tid, NULL);
 }
 
 /* ════════════════════════════════════════════════════════════════════
@@ -527,4 +569,194 @@ UTEST(smtp_e2e, host_not_allowed)
     ASSERT_EQ(-1, hl_cap_smtp_send(&cfg, &msg));
 }
 
+/* ── 9. Batch over one session ───────────────────────────────────── */
+
+UTEST(smtp_e2e, send_many_one_session)
+{
+    MockSmtp m;
+    ASSERT_EQ(0, mock_smtp_start(&m));
+    m.max_conns = 3;
+
+    const char *hosts[] = { "127.0.0.1" };
+    HlSmtpConfig cfg = {
+        .allowed_hosts = hosts,
+        .host_count    = 1,
+        .timeout_ms    = TEST_TIMEOUT_MS,
+    };
+
+    HlSmtpMessage msgs[3];
+    for (int i = 0; i < 3; i++) {
+        msgs[i] = (HlSmtpMessage){
+            .host    = "127.0.0.1",
+            .port    = m.port,
+            .from    = "a@b.com",
+            .to      = "c@d.com",
+            .subject = "batch",
+            .body    = "body",
+        };
+    }
+
+    int results[3] = { -9, -9, -9 };
+    ASSERT_EQ(3, hl_cap_smtp_send_many(&cfg, msgs, 3, results));
+    mock_smtp_stop(&m);
+
+    ASSERT_EQ(0, results[0]);
+    ASSERT_EQ(0, results[1]);
+    ASSERT_EQ(0, results[2]);
+    ASSERT_EQ(1, m.connections);
+    ASSERT_EQ(3, m.messages);
+    ASSERT_EQ(0, m.pipelined);
+    ASSERT_TRUE(m.quit_seen);
+}
+
+/* ── 10. Pool keeps the session between sends ───────────────────── */
+
+UTEST(smtp_e2e, pool_reuses_session)
+{
+    MockSmtp m;
+    ASSERT_EQ(0, mock_smtp_start(&m));
+    m.max_conns = 2;
+
+    HlSmtpPool *pool = hl_smtp_pool_create(5000);
+    ASSERT_TRUE(pool != NULL);
+
+    const char *hosts[] = { "127.0.0.1" };
+    HlSmtpConfig cfg = {
+        .allowed_hosts = hosts,
+        .host_count    = 1,
+        .timeout_ms    = TEST_TIMEOUT_MS,
+        .pool          = pool,
+    };
+
+    HlSmtpMessage msg = {
+        .host    = "127.0.0.1",
+        .port    = m.port,
+        .from    = "a@b.com",
+        .to      = "c@d.com",
+        .subject = "pooled",
+        .body    = "body",
+    };
+
+    ASSERT_EQ(0, hl_cap_smtp_send(&cfg, &msg));
+    ASSERT_EQ(0, hl_cap_smtp_send(&cfg, &msg));
+    ASSERT_EQ(0, m.quit_seen);
+
+    /* QUIT is sent when the pool goes away */
+    hl_smtp_pool_destroy(pool);
+    mock_smtp_stop(&m);
+
+    ASSERT_EQ(1, m.connections);
+    ASSERT_EQ(2, m.messages);
+    ASSERT_TRUE(m.quit_seen);
+}
+
+/* ── 11. Pipelined envelope ──────────────────────────────────────── */
+
+UTEST(smtp_e2e, pipelining_when_advertised)
+{
+    MockSmtp m;
+    ASSERT_EQ(0, mock_smtp_start(&m));
+    m.advertise_pipelining = 1;
+
+    const char *hosts[] = { "127.0.0.1" };
+    HlSmtpConfig cfg = {
+        .allowed_hosts = hosts,
+        .host_count    = 1,
+        .timeout_ms    = TEST_TIMEOUT_MS,
+    };
+
+    const char *cc[] = { "cc1@example.com" };
+    HlSmtpMessage msg = {
+        .host     = "127.0.0.1",
+        .port     = m.port,
+        .from     = "a@b.com",
+        .to       = "c@d.com",
+        .cc       = cc,
+        .cc_count = 1,
+        .subject  = "pipelined",
+        .body     = "body",
+    };
+
+    ASSERT_EQ(0, hl_cap_smtp_send(&cfg, &msg));
+    mock_smtp_stop(&m);
+
+    ASSERT_TRUE(m.pipelined);
+    ASSERT_EQ(2, m.rcpt_count);
+    ASSERT_EQ(1, m.messages);
+    ASSERT_TRUE(m.quit_seen);
+}
+
+/* ── 12. Rejected recipient resets, session carries on ───────────── */
+
+UTEST(smtp_e2e, rejected_rcpt_keeps_session)
+{
+    MockSmtp m;
+    ASSERT_EQ(0, mock_smtp_start(&m));
+    m.advertise_pipelining = 1;
+    m.reject_rcpt_match = "bad@";
+
+    const char *hosts[] = { "127.0.0.1" };
+    HlSmtpConfig cfg = {
+        .allowed_hosts = hosts,
+        .host_count    = 1,
+        .timeout_ms    = TEST_TIMEOUT_MS,
+    };
+
+    HlSmtpMessage msgs[2] = {
+        { .host = "127.0.0.1", .port = m.port, .from = "a@b.com",
+          .to = "bad@d.com", .subject = "one", .body = "body" },
+        { .host = "127.0.0.1", .port = m.port, .from = "a@b.com",
+          .to = "good@d.com", .subject = "two", .body = "body" },
+    };
+
+    int results[2];
+    ASSERT_EQ(1, hl_cap_smtp_send_many(&cfg, msgs, 2, results));
+    mock_smtp_stop(&m);
+
+    ASSERT_EQ(-1, results[0]);
+    ASSERT_EQ(0, results[1]);
+    ASSERT_EQ(1, m.rset_seen);
+    ASSERT_EQ(1, m.connections);
+    ASSERT_EQ(1, m.messages);
+}
+
+/* ── 13. Idle session expires ────────────────────────────────────── */
+
+UTEST(smtp_e2e, pool_idle_expiry)
+{
+    MockSmtp m;
+    ASSERT_EQ(0, mock_smtp_start(&m));
+    m.max_conns = 2;
+
+    HlSmtpPool *pool = hl_smtp_pool_create(50);
+    ASSERT_TRUE(pool != NULL);
+
+    const char *hosts[] = { "127.0.0.1" };
+    HlSmtpConfig cfg = {
+        .allowed_hosts = hosts,
+        .host_count    = 1,
+        .timeout_ms    = TEST_TIMEOUT_MS,
+        .pool          = pool,
+    };
+
+    HlSmtpMessage msg = {
+        .host    = "127.0.0.1",
+        .port    = m.port,
+        .from    = "a@b.com",
+        .to      = "c@d.com",
+        .subject = "idle",
+        .body    = "body",
+    };
+
+    ASSERT_EQ(0, hl_cap_smtp_send(&cfg, &msg));
+    usleep(100 * 1000);
+    ASSERT_EQ(0, hl_cap_smtp_send(&cfg, &msg));
+
+    hl_smtp_pool_destroy(pool);
+    mock_smtp_stop(&m);
+
+    ASSERT_EQ(2, m.connections);
+    ASSERT_EQ(2, m.messages);
+}
+
 UTEST_MAIN();
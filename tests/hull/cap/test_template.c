@@ -0,0 +1,418 @@
+/*
+ * test_template.c — Tests for the native template renderer
+ *
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#include "utest.h"
+#include "hull/cap/template.h"
+
+#include <ctype.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* ── Program assembler ──────────────────────────────────────────────── */
+
+typedef struct {
+    uint8_t b[1024];
+    size_t  n;
+} Prog;
+
+static void p_u8(Prog *p, unsigned v) { p->b[p->n++] = (uint8_t)v; }
+static void p_u16(Prog *p, unsigned v) { p_u8(p, v & 0xff); p_u8(p, v >> 8); }
+static void p_u32(Prog *p, uint32_t v)
+{
+    for (int i = 0; i < 4; i++)
+        p_u8(p, (v >> (8 * i)) & 0xff);
+}
+static void p_bytes(Prog *p, const char *s)
+{
+    memcpy(p->b + p->n, s, strlen(s));
+    p->n += strlen(s);
+}
+static void p_header(Prog *p, unsigned nregs)
+{
+    p->n = 0;
+    p_bytes(p, HL_TPL_MAGIC);
+    p_u8(p, HL_TPL_VERSION);
+    p_u8(p, nregs);
+    p_u16(p, 0);
+}
+static void p_text(Prog *p, const char *s)
+{
+    p_u8(p, HL_TPL_OP_TEXT); p_u32(p, (uint32_t)strlen(s)); p_bytes(p, s);
+}
+static void p_get(Prog *p, unsigned dst, unsigned obj, const char *key)
+{
+    p_u8(p, HL_TPL_OP_GET); p_u8(p, dst); p_u8(p, obj);
+    p_u16(p, (unsigned)strlen(key)); p_bytes(p, key);
+}
+static void p_out(Prog *p, unsigned src, unsigned escape)
+{
+    p_u8(p, HL_TPL_OP_OUT); p_u8(p, src); p_u8(p, escape);
+}
+/* Emit a jump with a placeholder target; returns the patch offset */
+static size_t p_jump(Prog *p, unsigned op, unsigned src)
+{
+    p_u8(p, op);
+    if (op != HL_TPL_OP_JMP)
+        p_u8(p, src);
+    size_t at = p->n;
+    p_u32(p, 0);
+    return at;
+}
+static void p_patch(Prog *p, size_t at, size_t target)
+{
+    for (int i = 0; i < 4; i++)
+        p->b[at + (size_t)i] = (uint8_t)((target >> (8 * i)) & 0xff);
+}
+
+/* ── Fake runtime: string-keyed maps and lists of strings ────────────── */
+
+typedef struct Val Val;
+struct Val {
+    enum { V_NIL, V_STR, V_MAP, V_LIST } kind;
+    const char  *str;
+    const char **keys;     /* V_MAP */
+    const Val   *items;    /* V_MAP values / V_LIST items */
+    size_t       n;
+};
+
+typedef struct {
+    Val  regs[8];
+    char scratch[8][64];
+} Fake;
+
+static int f_get(void *ud, int dst, int obj, const char *key, size_t len)
+{
+    Fake *f = ud;
+    Val v = { .kind = V_NIL };
+    const Val *o = &f->regs[obj];
+    if (o->kind == V_MAP) {
+        for (size_t i = 0; i < o->n; i++) {
+            if (strlen(o->keys[i]) == len && memcmp(o->keys[i], key, len) == 0)
+                v = o->items[i];
+        }
+    }
+    f->regs[dst] = v;
+    return 0;
+}
+
+static int f_set_str(void *ud, int dst, const char *s, size_t len)
+{
+    Fake *f = ud;
+    memcpy(f->scratch[dst], s, len);
+    f->scratch[dst][len] = '\0';
+    f->regs[dst] = (Val){ .kind = V_STR, .str = f->scratch[dst] };
+    return 0;
+}
+
+static int f_set_nil(void *ud, int dst)
+{
+    ((Fake *)ud)->regs[dst] = (Val){ .kind = V_NIL };
+    return 0;
+}
+
+static int f_truthy(void *ud, int src)
+{
+    return ((Fake *)ud)->regs[src].kind != V_NIL;
+}
+
+static int f_next(void *ud, int coll, int state, int key, int val, int kv)
+{
+    Fake *f = ud;
+    const Val *c = &f->regs[coll];
+    size_t i = f->regs[state].kind == V_NIL ? 0 : f->regs[state].n;
+    if ((c->kind != V_LIST && c->kind != V_MAP) || i >= c->n)
+        return 0;
+    f->regs[val] = c->items[i];
+    if (kv && key >= 0)
+        f->regs[key] = (Val){ .kind = V_STR, .str = c->keys[i] };
+    f->regs[state] = (Val){ .kind = V_STR, .n = i + 1 };
+    return 1;
+}
+
+static int f_filter(void *ud, int id, int dst, int src, int arg)
+{
+    Fake *f = ud;
+    (void)arg;
+    if (id != HL_TPL_F_UPPER || f->regs[src].kind != V_STR)
+        return -1;
+    char *out = f->scratch[dst];
+    const char *s = f->regs[src].str;
+    size_t i = 0;
+    for (; s[i] && i < 63; i++)
+        out[i] = (char)toupper((unsigned char)s[i]);
+    out[i] = '\0';
+    f->regs[dst] = (Val){ .kind = V_STR, .str = out };
+    return 0;
+}
+
+static int f_out(void *ud, int src, int escape, HlTplBuf *buf)
+{
+    const Val *v = &((Fake *)ud)->regs[src];
+    if (v->kind != V_STR)
+        return 0;
+    return escape ? hl_tpl_buf_escape(buf, v->str, strlen(v->str))
+                  : hl_tpl_buf_append(buf, v->str, strlen(v->str));
+}
+
+static const HlTplOps fake_ops = {
+    f_get, f_set_str, f_set_nil, f_truthy, f_next, f_filter, f_out,
+};
+
+/* Validate + render p with data in r0; returns malloc'd NUL-terminated
+ * output or NULL on failure */
+static char *run(const Prog *p, Val data)
+{
+    int nregs = hl_tpl_check(p->b, p->n);
+    if (nregs < 1 || nregs > 8)
+        return NULL;
+    Fake f;
+    memset(&f, 0, sizeof(f));
+    f.regs[0] = data;
+    HlTplBuf buf;
+    hl_tpl_buf_init(&buf, NULL);
+    if (hl_tpl_render(p->b, &fake_ops, &f, &buf) != 0 ||
+        hl_tpl_buf_append(&buf, "", 1) != 0) {
+        hl_tpl_buf_free(&buf);
+        return NULL;
+    }
+    char *s = strdup(buf.data);
+    hl_tpl_buf_free(&buf);
+    return s;
+}
+
+/* ── Escaping ───────────────────────────────────────────────────────── */
+
+static void naive_escape(const char *s, size_t n, char *out)
+{
+    size_t o = 0;
+    for (size_t i = 0; i < n; i++) {
+        const char *r = NULL;
+        switch (s[i]) {
+        case '&':  r = "&amp;";  break;
+        case '<':  r = "&lt;";   break;
+        case '>':  r = "&gt;";   break;
+        case '"':  r = "&quot;"; break;
+        case '\'': r = "&#39;";  break;
+        case '`':  r = "&#96;";  break;
+        }
+        if (r) {
+            memcpy(out + o, r, strlen(r));
+            o += strlen(r);
+        } else {
+            out[o++] = s[i];
+        }
+    }
+    out[o] = '\0';
+}
+
+UTEST(hl_tpl, escape_plain_and_special)
+{
+    HlTplBuf b;
+    hl_tpl_buf_init(&b, NULL);
+    ASSERT_EQ(hl_tpl_buf_escape(&b, "hello", 5), 0);
+    ASSERT_EQ(hl_tpl_buf_escape(&b, "<a href=\"x\">&'`", 15), 0);
+    ASSERT_EQ(hl_tpl_buf_append(&b, "", 1), 0);
+    ASSERT_STREQ(b.data, "hello&lt;a href=&quot;x&quot;&gt;&amp;&#39;&#96;");
+    hl_tpl_buf_free(&b);
+}
+
+UTEST(hl_tpl, escape_matches_scalar_at_every_offset)
+{
+    /* Long inputs exercise the 16-byte and 8-byte block scans; place
+     * each special character at every offset, alone and in pairs. */
+    const char specials[] = "&<>\"'`";
+    char in[80], expect[512];
+    for (size_t c = 0; c < sizeof(specials) - 1; c++) {
+        for (size_t pos = 0; pos < sizeof(in); pos++) {
+            memset(in, 'x', sizeof(in));
+            in[pos] = specials[c];
+            in[(pos * 7 + 3) % sizeof(in)] = specials[(c + 1) % 6];
+
+            HlTplBuf b;
+            hl_tpl_buf_init(&b, NULL);
+            ASSERT_EQ(hl_tpl_buf_escape(&b, in, sizeof(in)), 0);
+            ASSERT_EQ(hl_tpl_buf_append(&b, "", 1), 0);
+            naive_escape(in, sizeof(in), expect);
+            ASSERT_STREQ(b.data, expect);
+            hl_tpl_buf_free(&b);
+        }
+    }
+}
+
+UTEST(hl_tpl, escape_utf8_passthrough)
+{
+    HlTplBuf b;
+    hl_tpl_buf_init(&b, NULL);
+    const char *s = "caf\xc3\xa9 \xe2\x80\x94 <b>\xf0\x9f\x98\x80</b> and more text here";
+    ASSERT_EQ(hl_tpl_buf_escape(&b, s, strlen(s)), 0);
+    ASSERT_EQ(hl_tpl_buf_append(&b, "", 1), 0);
+    ASSERT_STREQ(b.data, "caf\xc3\xa9 \xe2\x80\x94 &lt;b&gt;\xf0\x9f\x98\x80&lt;/b&gt; and more text here");
+    hl_tpl_buf_free(&b);
+}
+
+/* ── Validation ─────────────────────────────────────────────────────── */
+
+UTEST(hl_tpl, check_accepts_minimal_program)
+{
+    Prog p;
+    p_header(&p, 1);
+    p_text(&p, "hi");
+    p_u8(&p, HL_TPL_OP_END);
+    ASSERT_EQ(hl_tpl_check(p.b, p.n), 1);
+}
+
+UTEST(hl_tpl, check_rejects_malformed)
+{
+    Prog p;
+
+    /* bad magic */
+    p_header(&p, 1);
+    p_u8(&p, HL_TPL_OP_END);
+    p.b[0] = 'X';
+    ASSERT_EQ(hl_tpl_check(p.b, p.n), -1);
+
+    /* truncated TEXT */
+    p_header(&p, 1);
+    p_text(&p, "hello");
+    p_u8(&p, HL_TPL_OP_END);
+    ASSERT_EQ(hl_tpl_check(p.b, p.n - 3), -1);
+
+    /* missing END */
+    p_header(&p, 1);
+    p_text(&p, "hello");
+    ASSERT_EQ(hl_tpl_check(p.b, p.n), -1);
+
+    /* register out of range */
+    p_header(&p, 2);
+    p_out(&p, 2, 1);
+    p_u8(&p, HL_TPL_OP_END);
+    ASSERT_EQ(hl_tpl_check(p.b, p.n), -1);
+
+    /* jump into the middle of an instruction */
+    p_header(&p, 1);
+    size_t j = p_jump(&p, HL_TPL_OP_JMP, 0);
+    p_text(&p, "abc");
+    p_u8(&p, HL_TPL_OP_END);
+    p_patch(&p, j, j + 6);
+    ASSERT_EQ(hl_tpl_check(p.b, p.n), -1);
+
+    /* unknown filter */
+    p_header(&p, 2);
+    p_u8(&p, HL_TPL_OP_FILTER); p_u8(&p, 99); p_u8(&p, 1); p_u8(&p, 0);
+    p_u8(&p, HL_TPL_NO_REG);
+    p_u8(&p, HL_TPL_OP_END);
+    ASSERT_EQ(hl_tpl_check(p.b, p.n), -1);
+}
+
+/* ── Rendering ──────────────────────────────────────────────────────── */
+
+static const char *user_keys[] = { "name" };
+static const Val user_vals[] = { { .kind = V_STR, .str = "<ann>" } };
+static const Val items[] = {
+    { .kind = V_STR, .str = "a" }, { .kind = V_STR, .str = "b&" },
+};
+static const char *data_keys[] = { "user", "items", "title" };
+static const Val data_vals[] = {
+    { .kind = V_MAP, .keys = user_keys, .items = user_vals, .n = 1 },
+    { .kind = V_LIST, .items = items, .n = 2 },
+    { .kind = V_STR, .str = "t" },
+};
+static const Val data = {
+    .kind = V_MAP, .keys = data_keys, .items = data_vals, .n = 3,
+};
+
+UTEST(hl_tpl, render_text_and_dot_path)
+{
+    /* Hi {{ user.name }}{{ user.missing.deep }}! {{{ user.name }}} */
+    Prog p;
+    p_header(&p, 2);
+    p_text(&p, "Hi ");
+    p_get(&p, 1, 0, "user");
+    p_get(&p, 1, 1, "name");
+    p_out(&p, 1, 1);
+    p_get(&p, 1, 0, "user");
+    p_get(&p, 1, 1, "missing");
+    p_get(&p, 1, 1, "deep");
+    p_out(&p, 1, 1);
+    p_text(&p, "! ");
+    p_get(&p, 1, 0, "user");
+    p_get(&p, 1, 1, "name");
+    p_out(&p, 1, 0);
+    p_u8(&p, HL_TPL_OP_END);
+
+    char *s = run(&p, data);
+    ASSERT_TRUE(s != NULL);
+    ASSERT_STREQ(s, "Hi &lt;ann&gt;! <ann>");
+    free(s);
+}
+
+UTEST(hl_tpl, render_if_else)
+{
+    /* {% if nope %}A{% elif not title %}B{% else %}C{% end %} */
+    Prog p;
+    p_header(&p, 2);
+    p_get(&p, 1, 0, "nope");
+    size_t j1 = p_jump(&p, HL_TPL_OP_JMPF, 1);
+    p_text(&p, "A");
+    size_t e1 = p_jump(&p, HL_TPL_OP_JMP, 0);
+    p_patch(&p, j1, p.n);
+    p_get(&p, 1, 0, "title");
+    size_t j2 = p_jump(&p, HL_TPL_OP_JMPT, 1);
+    p_text(&p, "B");
+    size_t e2 = p_jump(&p, HL_TPL_OP_JMP, 0);
+    p_patch(&p, j2, p.n);
+    p_text(&p, "C");
+    p_patch(&p, e1, p.n);
+    p_patch(&p, e2, p.n);
+    p_u8(&p, HL_TPL_OP_END);
+
+    char *s = run(&p, data);
+    ASSERT_TRUE(s != NULL);
+    ASSERT_STREQ(s, "C");
+    free(s);
+}
+
+UTEST(hl_tpl, render_loop_with_filter)
+{
+    /* {% for it in items %}[{{ it | upper }}]{% end %} */
+    Prog p;
+    p_header(&p, 6);
+    p_get(&p, 1, 0, "items");
+    p_u8(&p, HL_TPL_OP_NIL); p_u8(&p, 2);
+    p_u8(&p, HL_TPL_OP_NIL); p_u8(&p, 3);
+    size_t head = p.n;
+    p_u8(&p, HL_TPL_OP_NEXT); p_u8(&p, 1); p_u8(&p, 2);
+    p_u8(&p, HL_TPL_NO_REG); p_u8(&p, 4); p_u8(&p, 0);
+    size_t exit_at = p.n;
+    p_u32(&p, 0);
+    p_text(&p, "[");
+    p_u8(&p, HL_TPL_OP_FILTER); p_u8(&p, HL_TPL_F_UPPER); p_u8(&p, 5);
+    p_u8(&p, 4); p_u8(&p, HL_TPL_NO_REG);
+    p_out(&p, 5, 1);
+    p_text(&p, "]");
+    size_t back = p_jump(&p, HL_TPL_OP_JMP, 0);
+    p_patch(&p, back, head);
+    p_patch(&p, exit_at, p.n);
+    p_u8(&p, HL_TPL_OP_END);
+
+    char *s = run(&p, data);
+    ASSERT_TRUE(s != NULL);
+    ASSERT_STREQ(s, "[A][B&amp;]");
+    free(s);
+}
+
+UTEST(hl_tpl, render_propagates_op_error)
+{
+    /* upper on a map fails in the fake runtime */
+    Prog p;
+    p_header(&p, 2);
+    p_u8(&p, HL_TPL_OP_FILTER); p_u8(&p, HL_TPL_F_UPPER); p_u8(&p, 1);
+    p_u8(&p, 0); p_u8(&p, HL_TPL_NO_REG);
+    p_u8(&p, HL_TPL_OP_END);
+    ASSERT_TRUE(run(&p, data) == NULL);
+}
+
+UTEST_MAIN();
@@ -10,9 +10,13 @@
 #include "utest.h"
 #include "hull/runtime/js.h"
 #include "hull/manifest.h"
+#include "hull/reload.h"
 #include "hull/vfs.h"
 #include "hull/cap/db.h"
 #include "hull/cap/env.h"
+#include "hull/cap/test.h"
+#include "hull/cap/sched.h"
+#include "hull/limits.h"
 #include "quickjs.h"
 
 #include <keel/keel.h>
@@ -22,6 +26,7 @@
 #include <string.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <unistd.h>
 
 /* ── Helpers ────────────────────────────────────────────────────────── */
 
@@ -392,6 +397,45 @@ UTEST(js_runtime, hull_json_roundtrip)
     cleanup_js();
 }
 
+/* ── Template module tests ───────────────────────────────────────────── */
+
+UTEST(js_runtime, hull_template_for_over_object)
+{
+    init_js();
+
+    /* {% for x in v %} follows for...of: arrays and other iterables
+     * (strings, Set, Map) loop, null renders nothing, and a plain
+     * object throws instead of silently rendering nothing. */
+    const char *code =
+        "import { template } from 'hull:template';\n"
+        "const r = template.renderString;\n"
+        "const f = '{% for x in o %}{{ x }},{% end %}';\n"
+        "let threw = 0;\n"
+        "try { r(f, { o: { a: 1 } }); }\n"
+        "catch (e) { threw = e instanceof TypeError ? 1 : 0; }\n"
+        "globalThis.__test_ok = threw &&\n"
+        "    r(f, { o: [1, 2] }) === '1,2,' &&\n"
+        "    r(f, { o: 'ab' }) === 'a,b,' &&\n"
+        "    r(f, { o: new Set(['x', 'y', 'x']) }) === 'x,y,' &&\n"
+        "    r('{% for e in o %}{% for x in e %}{{ x }}{% end %};{% end %}',\n"
+        "      { o: new Map([['k', 1]]) }) === 'k1;' &&\n"
+        "    r(f, { o: null }) === '' &&\n"
+        "    r('{% for k, v in o %}{{ k }}={{ v }};{% end %}', { o: { a: 1 } })\n"
+        "        === 'a=1;' ? 1 : 0;\n";
+
+    JSValue val = JS_Eval(js.ctx, code, strlen(code), "<test>",
+                          JS_EVAL_TYPE_MODULE);
+    if (JS_IsException(val))
+        hl_js_dump_error(&js);
+    JS_FreeValue(js.ctx, val);
+    hl_js_run_jobs(&js);
+
+    int result = eval_int("globalThis.__test_ok");
+    ASSERT_EQ(result, 1);
+
+    cleanup_js();
+}
+
 /* ── GC test ────────────────────────────────────────────────────────── */
 
 UTEST(js_runtime, gc_runs)
@@ -411,6 +455,54 @@ UTEST(js_runtime, gc_runs)
     cleanup_js();
 }
 
+/* ── Request-boundary GC ────────────────────────────────────────────── */
+
+UTEST(js_runtime, gc_request_mode)
+{
+    char dir[] = "/tmp/hull_test_XXXXXX";
+    ASSERT_NE(mkdtemp(dir), NULL);
+    char path[1024];
+    snprintf(path, sizeof(path), "%s/app.js", dir);
+    FILE *f = fopen(path, "w");
+    ASSERT_TRUE(f != NULL);
+    /* Cyclic garbage only the cycle collector can reclaim, plus one
+     * object escaping into a global every 100 requests */
+    fputs("globalThis.kept = [];\n"
+          "globalThis.handle = function (r) {\n"
+          "  for (let i = 0; i < 100; i++) {\n"
+          "    const a = { id: i, s: 'x' + r * i }; a.self = a;\n"
+          "    if (i === 0 && r % 100 === 0) kept.push(a);\n"
+          "  }\n"
+          "  return 1;\n"
+          "};\n", f);
+    fclose(f);
+
+    init_js();
+    ASSERT_TRUE(js_initialized);
+    ASSERT_EQ(hl_js_load_app(&js, path), 0);
+    ASSERT_TRUE(js.malloc_state != NULL);
+
+    size_t base = js.malloc_state->malloc_size;
+    for (int r = 1; r <= 2000; r++) {
+        char code[64];
+        snprintf(code, sizeof(code), "handle(%d)", r);
+        ASSERT_EQ(eval_int(code), 1);
+        hl_js_request_end(&js);
+        /* Collected at the boundary, well before the mid-handler backstop */
+        ASSERT_LT(js.malloc_state->malloc_size,
+                  base + HL_JS_GC_THRESHOLD + 1024 * 1024);
+    }
+    ASSERT_EQ(eval_int("kept.length"), 20);
+    ASSERT_EQ(eval_int("kept[19].self === kept[19] ? 1 : 0"), 1);
+    ASSERT_GT(js.base.gc_stats.runs, (uint64_t)0);
+    ASSERT_GT(js.base.gc_stats.bytes_freed, (uint64_t)0);
+    ASSERT_GE(js.base.gc_stats.total_ns, js.base.gc_stats.max_ns);
+
+    cleanup_js();
+    unlink(path);
+    rmdir(dir);
+}
+
 /* ── Console polyfill test ──────────────────────────────────────────── */
 
 UTEST(js_runtime, console_exists)
@@ -481,6 +573,157 @@ UTEST(js_runtime, free_after_modules_no_gc_leak)
     cleanup_js();
 }
 
+/* ── Precompiled bytecode tests ────────────────────────────────────── */
+
+static int bc_dummy_init(JSContext *ctx, JSModuleDef *m)
+{
+    (void)ctx;
+    (void)m;
+    return 0;
+}
+
+static JSModuleDef *bc_dummy_loader(JSContext *ctx, const char *name,
+                                    void *opaque)
+{
+    (void)opaque;
+    return JS_NewCModule(ctx, name, bc_dummy_init);
+}
+
+/* Compile `src` as module `name` in a scratch runtime (as hull build
+ * does). Returns a malloc'd buffer (caller frees) or NULL. */
+static unsigned char *compile_module(const char *src, const char *name,
+                                     unsigned int *out_len)
+{
+    JSRuntime *rt = JS_NewRuntime();
+    JSContext *ctx = JS_NewContext(rt);
+    JS_SetModuleLoaderFunc(rt, NULL, bc_dummy_loader, NULL);
+
+    unsigned char *out = NULL;
+    JSValue mod = JS_Eval(ctx, src, strlen(src), name,
+                          JS_EVAL_TYPE_MODULE | JS_EVAL_FLAG_COMPILE_ONLY);
+    if (!JS_IsException(mod)) {
+        size_t len = 0;
+        uint8_t *bc = JS_WriteObject(ctx, &len, mod, JS_WRITE_OBJ_BYTECODE);
+        if (bc) {
+            out = malloc(len);
+            if (out) {
+                memcpy(out, bc, len);
+                *out_len = (unsigned int)len;
+            }
+            js_free(ctx, bc);
+        }
+    }
+    JS_FreeValue(ctx, mod);
+    JS_FreeContext(ctx);
+    JS_FreeRuntime(rt);
+    return out;
+}
+
+static HlVfs bc_app_vfs;
+
+static void init_js_with_app(const HlEntry *entries)
+{
+    init_js();
+    hl_vfs_init(&bc_app_vfs, entries, NULL);
+    js.base.app_vfs = &bc_app_vfs;
+}
+
+/* Evaluate `code` as the app entry module (absolute name, like hull serve) */
+static void eval_entry(const char *code)
+{
+    JSValue val = JS_Eval(js.ctx, code, strlen(code), "/srv/app/app.js",
+                          JS_EVAL_TYPE_MODULE);
+    if (JS_IsException(val))
+        hl_js_dump_error(&js);
+    JS_FreeValue(js.ctx, val);
+    hl_js_run_jobs(&js);
+}
+
+UTEST(js_bytecode, stdlib_has_bytecode)
+{
+    extern const HlEntry hl_stdlib_entries[];
+    HlVfs vfs;
+    hl_vfs_init(&vfs, hl_stdlib_entries, NULL);
+    ASSERT_NE(hl_vfs_find_suffixed(&vfs, "hull:cookie", HL_JS_BYTECODE_SUFFIX),
+              NULL);
+}
+
+UTEST(js_bytecode, app_bytecode_preferred)
+{
+    /* Source and bytecode deliberately differ so we can tell which ran */
+    unsigned int bc_len = 0;
+    unsigned char *bc = compile_module("export const v = 2;", "./lib.js",
+                                       &bc_len);
+    ASSERT_NE(bc, NULL);
+
+    const char *lib_src = "export const v = 1;";
+    const HlEntry entries[] = {
+        { "./lib.js",  (const unsigned char *)lib_src, (unsigned int)strlen(lib_src) },
+        { "./lib.jsc", bc, bc_len },
+        { 0, 0, 0 }
+    };
+    init_js_with_app(entries);
+    ASSERT_TRUE(js_initialized);
+
+    eval_entry("import { v } from './lib.js';\n"
+               "globalThis.__test_v = v;\n");
+    ASSERT_EQ(eval_int("globalThis.__test_v"), 2);
+
+    cleanup_js();
+    free(bc);
+}
+
+UTEST(js_bytecode, canonical_names_share_instance)
+{
+    /* "./sub/a.js" imports "./lib.js" → "./sub/./lib.js" must resolve to
+     * the same "./sub/lib.js" instance the entry module imported. */
+    const char *a_src = "import { o } from './lib.js'; export const a = o;";
+    const char *lib_src = "export const o = {};";
+    unsigned int a_len = 0, lib_len = 0;
+    unsigned char *a_bc = compile_module(a_src, "./sub/a.js", &a_len);
+    unsigned char *lib_bc = compile_module(lib_src, "./sub/lib.js", &lib_len);
+    ASSERT_NE(a_bc, NULL);
+    ASSERT_NE(lib_bc, NULL);
+
+    const HlEntry entries[] = {
+        { "./sub/a.js",    (const unsigned char *)a_src, (unsigned int)strlen(a_src) },
+        { "./sub/a.jsc",   a_bc, a_len },
+        { "./sub/lib.js",  (const unsigned char *)lib_src, (unsigned int)strlen(lib_src) },
+        { "./sub/lib.jsc", lib_bc, lib_len },
+        { 0, 0, 0 }
+    };
+    init_js_with_app(entries);
+    ASSERT_TRUE(js_initialized);
+
+    eval_entry("import { o } from './sub/lib.js';\n"
+               "import { a } from './sub/a.js';\n"
+               "globalThis.__test_same = (a === o) ? 1 : 0;\n");
+    ASSERT_EQ(eval_int("globalThis.__test_same"), 1);
+
+    cleanup_js();
+    free(a_bc);
+    free(lib_bc);
+}
+
+UTEST(js_bytecode, corrupt_bytecode_falls_back_to_source)
+{
+    static const unsigned char bogus[] = { 0x02, 0xff, 0xff, 0xff };
+    const char *lib_src = "export const v = 1;";
+    const HlEntry entries[] = {
+        { "./lib.js",  (const unsigned char *)lib_src, (unsigned int)strlen(lib_src) },
+        { "./lib.jsc", bogus, sizeof(bogus) },
+        { 0, 0, 0 }
+    };
+    init_js_with_app(entries);
+    ASSERT_TRUE(js_initialized);
+
+    eval_entry("import { v } from './lib.js';\n"
+               "globalThis.__test_v = v;\n");
+    ASSERT_EQ(eval_int("globalThis.__test_v"), 1);
+
+    cleanup_js();
+}
+
 /* ── Crypto tests ──────────────────────────────────────────────────── */
 
 UTEST(js_cap, crypto_sha256)
@@ -508,6 +751,35 @@ UTEST(js_cap, crypto_sha256)
     cleanup_js_caps();
 }
 
+UTEST(js_cap, crypto_sha256_many)
+{
+    init_js_with_caps();
+    ASSERT_TRUE(js_initialized);
+
+    const char *code =
+        "import { crypto } from 'hull:crypto';\n"
+        "const h = crypto.sha256Many(['hello', '', 'hello']);\n"
+        "globalThis.__test_ok = h.length === 3 && h[0] === h[2] &&\n"
+        "    h[1] === crypto.sha256('') ? 1 : 0;\n"
+        "globalThis.__test_hash = h[0];\n";
+
+    JSValue val = JS_Eval(js.ctx, code, strlen(code), "<test>",
+                          JS_EVAL_TYPE_MODULE);
+    if (JS_IsException(val))
+        hl_js_dump_error(&js);
+    JS_FreeValue(js.ctx, val);
+    hl_js_run_jobs(&js);
+
+    ASSERT_EQ(eval_int("globalThis.__test_ok"), 1);
+    char *hash = eval_str("globalThis.__test_hash");
+    ASSERT_NE(hash, NULL);
+    ASSERT_STREQ(hash,
+        "2cf24dba5fb0a30e26e83b2ac5b9e29e1b161e5c1fa7425e73043362938b9824");
+    free(hash);
+
+    cleanup_js_caps();
+}
+
 UTEST(js_cap, crypto_random)
 {
     init_js_with_caps();
@@ -804,6 +1076,40 @@ UTEST(js_cap, db_parameterized_query)
     cleanup_js_caps();
 }
 
+UTEST(js_cap, db_each)
+{
+    init_js_with_caps();
+    ASSERT_TRUE(js_initialized);
+
+    const char *code =
+        "import { db } from 'hull:db';\n"
+        "db.exec('CREATE TABLE t4 (id INTEGER PRIMARY KEY, val INTEGER)');\n"
+        "for (let i = 1; i <= 5; i++) db.exec('INSERT INTO t4 (val) VALUES (?)', [i]);\n"
+        "let sum = 0, inner = 0;\n"
+        "const n = db.each('SELECT val FROM t4 WHERE val > ? ORDER BY id', [1], (row) => {\n"
+        "    sum = sum * 10 + row.val;\n"
+        "    inner += db.query('SELECT val FROM t4').length;\n"
+        "});\n"
+        "const stopped = db.each('SELECT val FROM t4', (row) => row.val < 3);\n"
+        "let threw = 0;\n"
+        "try { db.each('SELECT val FROM t4', () => { throw new Error('boom'); }); }\n"
+        "catch (e) { threw = e.message === 'boom' ? 1 : 0; }\n"
+        "globalThis.__test_db_each = (n === 4 && sum === 2345 && inner === 20\n"
+        "                             && stopped === 3 && threw) ? 1 : 0;\n";
+
+    JSValue val = JS_Eval(js.ctx, code, strlen(code), "<test>",
+                          JS_EVAL_TYPE_MODULE);
+    if (JS_IsException(val))
+        hl_js_dump_error(&js);
+    JS_FreeValue(js.ctx, val);
+    hl_js_run_jobs(&js);
+
+    int result = eval_int("globalThis.__test_db_each");
+    ASSERT_EQ(result, 1);
+
+    cleanup_js_caps();
+}
+
 UTEST(js_cap, db_not_available_without_config)
 {
     /* Use default init (no db) — hull:db module should not be registered */
@@ -983,6 +1289,7 @@ UTEST(js_cap, manifest_extract_js)
         "  fs: { read: ['/tmp', '/data'], write: ['/uploads'] },\n"
         "  env: ['PORT', 'DATABASE_URL'],\n"
         "  hosts: ['api.stripe.com', 'api.sendgrid.com'],\n"
+        "  access_log: true,\n"
         "});\n";
 
     JSValue val = JS_Eval(js.ctx, code, strlen(code), "<test>",
@@ -1012,6 +1319,7 @@ UTEST(js_cap, manifest_extract_js)
     ASSERT_EQ(manifest.hosts_count, 2);
     ASSERT_STREQ(manifest.hosts[0], "api.stripe.com");
     ASSERT_STREQ(manifest.hosts[1], "api.sendgrid.com");
+    ASSERT_EQ(manifest.access_log, 1);
 
     hl_manifest_free_js_strings(js.ctx, &manifest);
     cleanup_js();
@@ -1282,6 +1590,200 @@ UTEST(js_middleware, order_preserved)
     cleanup_js();
 }
 
+/* ── Background jobs ───────────────────────────────────────────────── */
+
+UTEST(js_runtime, background_jobs)
+{
+    init_js();
+    ASSERT_TRUE(js_initialized);
+
+    const char *code =
+        "import { app } from 'hull:app';\n"
+        "globalThis.hits = 0; globalThis.bad = 0;\n"
+        "app.every('30s', () => { globalThis.hits++; }, { name: 'tick', jitter: 0.5 });\n"
+        "app.at('0 3 * * *', async () => { throw new Error('boom'); });\n"
+        "try { app.every('10ms', () => {}); } catch (e) { globalThis.bad++; }\n"
+        "try { app.every(60); } catch (e) { globalThis.bad++; }\n"
+        "try { app.at('61 * * * *', () => {}); } catch (e) { globalThis.bad++; }\n";
+
+    JSValue val = JS_Eval(js.ctx, code, strlen(code), "<test>",
+                          JS_EVAL_TYPE_MODULE);
+    if (JS_IsException(val))
+        hl_js_dump_error(&js);
+    JS_FreeValue(js.ctx, val);
+    hl_js_run_jobs(&js);
+    ASSERT_EQ(eval_int("globalThis.bad"), 3);
+
+    HlJobDef jobs[4];
+    ASSERT_EQ(hl_js_extract_jobs(&js, jobs, 4), 2);
+    ASSERT_STREQ(jobs[0].name, "tick");
+    ASSERT_EQ(jobs[0].every_ms, 30000);
+    ASSERT_EQ(jobs[0].jitter_ms, 500);
+    ASSERT_STREQ(jobs[1].name, "at 0 3 * * *");
+    ASSERT_EQ(jobs[1].every_ms, 0);
+
+    /* A rejected promise counts as a failed run */
+    ASSERT_EQ(hl_js_run_job(&js, jobs[0].handler_id), 0);
+    ASSERT_EQ(hl_js_run_job(&js, jobs[1].handler_id), -1);
+    ASSERT_EQ(eval_int("globalThis.hits"), 1);
+
+    cleanup_js();
+}
+
+UTEST(js_runtime, outbox_bridge)
+{
+    init_js();
+    ASSERT_TRUE(js_initialized);
+
+    const char *code =
+        "import { _outbox } from 'hull:_outbox';\n"
+        "globalThis.ob = _outbox;\n"
+        "_outbox.wake();\n";
+    JSValue val = JS_Eval(js.ctx, code, strlen(code), "<test>",
+                          JS_EVAL_TYPE_MODULE);
+    if (JS_IsException(val))
+        hl_js_dump_error(&js);
+    JS_FreeValue(js.ctx, val);
+    hl_js_run_jobs(&js);
+
+    /* Without --outbox-workers flush() keeps every kind */
+    ASSERT_EQ(eval_int("globalThis.ob.native() === false ? 1 : 0"), 1);
+
+    int marker;
+    js.base.outbox = (HlOutbox *)&marker;   /* only native() looks at it */
+    ASSERT_EQ(eval_int("globalThis.ob.native() === true ? 1 : 0"), 1);
+    js.base.outbox = NULL;
+
+    cleanup_js();
+}
+
+UTEST(js_runtime, upload_routes)
+{
+    init_js();
+    ASSERT_TRUE(js_initialized);
+
+    const char *code =
+        "import { app } from 'hull:app';\n"
+        "app.post('/stream', (req, res) => {\n"
+        "    res.text(req.upload.mode + ' ' + req.upload.size + ' ' + req.ctx.n\n"
+        "             + ' ' + (req.body === null));\n"
+        "}, { body: 'stream', maxBody: '1m',\n"
+        "     onChunk: (req, chunk) => { req.ctx.n = (req.ctx.n || 0) + chunk.byteLength; } });\n"
+        "const bad = [{ body: 'disk' }, { body: 'stream' }, { onChunk: () => {} },\n"
+        "             { maxBody: 'lots' }, 'spool'];\n"
+        "globalThis.rejected = 0;\n"
+        "for (const opts of bad) {\n"
+        "    try { app.post('/x', () => {}, opts); } catch (e) { globalThis.rejected++; }\n"
+        "}\n";
+    JSValue val = JS_Eval(js.ctx, code, strlen(code), "<test>",
+                          JS_EVAL_TYPE_MODULE);
+    if (JS_IsException(val))
+        hl_js_dump_error(&js);
+    JS_FreeValue(js.ctx, val);
+    hl_js_run_jobs(&js);
+
+    ASSERT_EQ(eval_int("globalThis.rejected"), 5);
+    ASSERT_EQ(eval_int("globalThis.__hull_route_defs.length"), 1);
+    ASSERT_EQ(eval_int("globalThis.__hull_route_defs[0].max_body"), 1024 * 1024);
+
+    KlAllocator alloc = kl_allocator_default();
+    KlRouter router;
+    kl_router_init(&router, &alloc);
+    ASSERT_EQ(hl_js_wire_routes(&js, &router), 0);
+
+    /* 40000 bytes reach the handler in three chunks, never as req.body */
+    static char body[40000];
+    memset(body, 'x', sizeof(body));
+    HlTestResult result;
+    ASSERT_EQ(hl_cap_test_dispatch(&router, "POST", "/stream", body,
+                                   sizeof(body), NULL, NULL, 0, &result), 0);
+    ASSERT_EQ(result.status, 200);
+    ASSERT_STREQ(result.body, "stream 40000 40000 true");
+    free((void *)result.body);
+
+    kl_router_free(&router);
+    cleanup_js();
+}
+
+/* ── Hot reload ─────────────────────────────────────────────────────── */
+
+static void write_app_js(const char *path, const char *src)
+{
+    FILE *f = fopen(path, "w");
+    if (f) {
+        fputs(src, f);
+        fclose(f);
+    }
+}
+
+UTEST(js_reload, swaps_runtime_in_place)
+{
+    char dir[] = "/tmp/hull_test_XXXXXX";
+    ASSERT_NE(mkdtemp(dir), NULL);
+    char path[1024];
+    snprintf(path, sizeof(path), "%s/app.js", dir);
+    write_app_js(path,
+        "import { app } from 'hull:app';\n"
+        "app.get('/a', (req, res) => {});\n"
+        "app.use('*', '/*', (req, res) => 0);\n");
+
+    init_js();
+    ASSERT_TRUE(js_initialized);
+    js.base.vt = &hl_js_vtable;
+    ASSERT_EQ(hl_js_load_app(&js, path), 0);
+
+    KlServer server;
+    KlConfig kcfg = { .port = 0, .max_connections = 1, .alloc = NULL };
+    kl_server_init(&server, &kcfg);
+    ASSERT_EQ(hl_js_wire_routes_server(&js, &server, NULL), 0);
+
+    HlJSConfig cfg = HL_JS_CONFIG_DEFAULT;
+    HlManifest m;
+    memset(&m, 0, sizeof(m));
+    js.base.vt->extract_manifest(&js.base, &m);
+    HlReload r = {
+        .rt = &js.base, .rt_size = sizeof(HlJS), .rt_cfg = &cfg,
+        .entry_point = path, .manifest = &m,
+    };
+
+    /* Route 0 is GET /a, route 1 the middleware */
+    HlJSRoute *mw = (HlJSRoute *)js.routes[1];
+    KlRequest req = {0};
+    KlResponse res = {0};
+    ASSERT_EQ(hl_js_dispatch_middleware(mw->js, mw->handler_id, &req, &res), 0);
+
+    /* A new route needs a restart; the old runtime keeps serving */
+    write_app_js(path,
+        "import { app } from 'hull:app';\n"
+        "app.get('/a', (req, res) => {});\n"
+        "app.get('/b', (req, res) => {});\n"
+        "app.use('*', '/*', (req, res) => 0);\n");
+    ASSERT_EQ(hl_reload_run(&r), 1);
+    ASSERT_TRUE(r.rt == &js.base);
+    ASSERT_TRUE(mw->js == &js);
+
+    /* Same routes, new middleware body */
+    write_app_js(path,
+        "import { app } from 'hull:app';\n"
+        "app.get('/a', (req, res) => {});\n"
+        "app.use('*', '/*', (req, res) => 1);\n");
+    ASSERT_EQ(hl_reload_run(&r), 0);
+
+    HlJS *cur = (HlJS *)r.rt;
+    ASSERT_TRUE(cur != &js);
+    ASSERT_TRUE(cur->routes[1] == mw);      /* Keel's context survives */
+    ASSERT_TRUE(mw->js == cur);             /* ... now pointing at v2 */
+    ASSERT_EQ(hl_js_dispatch_middleware(mw->js, mw->handler_id, &req, &res), 1);
+
+    cur->base.vt->free_manifest_strings(&cur->base, &m);
+    hl_js_free(cur);
+    free(cur);
+    js_initialized = 0;                     /* destroyed by the reload */
+    kl_server_free(&server);
+    unlink(path);
+    rmdir(dir);
+}
+
 /* ── HMAC-SHA256 / base64url tests ─────────────────────────────────── */
 
 UTEST(js_cap, crypto_hmac_sha256)
@@ -12,6 +12,9 @@
 #include "hull/vfs.h"
 #include "hull/cap/db.h"
 #include "hull/cap/env.h"
+#include "hull/cap/sched.h"
+#include "hull/manifest.h"
+#include "hull/reload.h"
 
 #include "lua.h"
 #include "lualib.h"
@@ -342,6 +345,149 @@ UTEST(lua_runtime, gc_runs)
     cleanup_lua();
 }
 
+/* ── Request-boundary GC ────────────────────────────────────────────── */
+
+/* A handler that leaves 50 tables of garbage per request and lets one
+ * object escape into a global every 100 requests, next to a long-lived
+ * cache the collector has to keep marking */
+static const char *gc_app_src =
+    "cache = {}\n"
+    "for i = 1, 20000 do cache[i] = { id = i, name = 'n' .. i } end\n"
+    "kept = {}\n"
+    "function handle(r)\n"
+    "  local t = {}\n"
+    "  for i = 1, 50 do t[i] = { id = i, s = 'x' .. (r * i) } end\n"
+    "  if r % 100 == 0 then kept[#kept + 1] = t[1] end\n"
+    "end\n";
+
+static int write_gc_app(char *dir, char *path, size_t path_size)
+{
+    if (!mkdtemp(dir))
+        return -1;
+    snprintf(path, path_size, "%s/app.lua", dir);
+    FILE *f = fopen(path, "w");
+    if (!f)
+        return -1;
+    fputs(gc_app_src, f);
+    fclose(f);
+    return 0;
+}
+
+/* Run `reqs` requests through handle() the way the Keel bridge does */
+static int run_gc_requests(HlLua *lua, int reqs)
+{
+    for (int r = 1; r <= reqs; r++) {
+        lua_getglobal(lua->L, "handle");
+        lua_pushinteger(lua->L, r);
+        if (lua_pcall(lua->L, 1, 0, 0) != LUA_OK)
+            return -1;
+        hl_lua_request_end(lua);
+    }
+    return 0;
+}
+
+UTEST(lua_runtime, gc_request_mode)
+{
+    char dir[] = "/tmp/hull_test_XXXXXX";
+    char path[1024];
+    ASSERT_EQ(write_gc_app(dir, path, sizeof(path)), 0);
+
+    init_lua();
+    ASSERT_TRUE(lua_initialized);
+    ASSERT_EQ(hl_lua_load_app(&lua_rt, path), 0);
+
+    /* load_app switched the collector to generational mode */
+    ASSERT_EQ(lua_gc(lua_rt.L, LUA_GCGEN, 0, 0), LUA_GCGEN);
+
+    int base_kb = lua_gc(lua_rt.L, LUA_GCCOUNT, 0);
+    ASSERT_EQ(run_gc_requests(&lua_rt, 5000), 0);
+
+    /* One young collection per request, all accounted */
+    ASSERT_EQ(lua_rt.base.gc_stats.runs, (uint64_t)5000);
+    ASSERT_GT(lua_rt.base.gc_stats.bytes_freed, (uint64_t)0);
+    ASSERT_GE(lua_rt.base.gc_stats.total_ns, lua_rt.base.gc_stats.max_ns);
+
+    /* Escaped objects were promoted, not collected */
+    ASSERT_EQ(eval_int("#kept"), 50);
+    ASSERT_EQ(eval_int("kept[50].id"), 1);
+
+    /* Request garbage did not pile up between collections */
+    ASSERT_LT(lua_gc(lua_rt.L, LUA_GCCOUNT, 0), base_kb + 256);
+
+    cleanup_lua();
+    unlink(path);
+    rmdir(dir);
+}
+
+UTEST(lua_runtime, gc_incremental_paced_at_boundaries)
+{
+    char dir[] = "/tmp/hull_test_XXXXXX";
+    char path[1024];
+    ASSERT_EQ(write_gc_app(dir, path, sizeof(path)), 0);
+
+    extern const HlEntry hl_stdlib_entries[];
+    hl_vfs_init(&platform_vfs, hl_stdlib_entries, NULL);
+    HlLuaConfig cfg = HL_LUA_CONFIG_DEFAULT;
+    cfg.gc_mode = HL_GC_INCREMENTAL;
+    cfg.gc_budget_us = 200;
+    HlLua lua;
+    memset(&lua, 0, sizeof(lua));
+    lua.base.platform_vfs = &platform_vfs;
+    ASSERT_EQ(hl_lua_init(&lua, &cfg), 0);
+    ASSERT_EQ(hl_lua_load_app(&lua, path), 0);
+
+    size_t heap0 = lua.mem_used;
+    ASSERT_EQ(run_gc_requests(&lua, 5000), 0);
+
+    /* Cycles ran in many short boundary slices and kept the heap near
+     * the HL_LUA_GC_PAUSE trigger, far below Lua's own backstop */
+    const HlGcStats *gs = &lua.base.gc_stats;
+    ASSERT_GT(gs->runs, (uint64_t)10);
+    ASSERT_GT(gs->bytes_freed, (uint64_t)0);
+    ASSERT_LT(lua.mem_used, heap0 / 100 * HL_LUA_GC_PAUSE * 2);
+
+    hl_lua_free(&lua);
+    unlink(path);
+    rmdir(dir);
+}
+
+/* Both modes time every boundary collection; request mode also keeps
+ * the heap flat. Latency per mode is in make perf (lua_gc_*). */
+UTEST(lua_runtime, gc_pauses_recorded)
+{
+    char dir[] = "/tmp/hull_test_XXXXXX";
+    char path[1024];
+    ASSERT_EQ(write_gc_app(dir, path, sizeof(path)), 0);
+
+    extern const HlEntry hl_stdlib_entries[];
+    hl_vfs_init(&platform_vfs, hl_stdlib_entries, NULL);
+
+    const int modes[] = { HL_GC_REQUEST, HL_GC_INCREMENTAL };
+    for (int m = 0; m < 2; m++) {
+        HlLuaConfig cfg = HL_LUA_CONFIG_DEFAULT;
+        cfg.gc_mode = modes[m];
+        HlLua lua;
+        memset(&lua, 0, sizeof(lua));
+        lua.base.platform_vfs = &platform_vfs;
+        ASSERT_EQ(hl_lua_init(&lua, &cfg), 0);
+        ASSERT_EQ(hl_lua_load_app(&lua, path), 0);
+
+        int base_kb = lua_gc(lua.L, LUA_GCCOUNT, 0);
+        ASSERT_EQ(run_gc_requests(&lua, 2000), 0);
+
+        const HlGcStats *gs = &lua.base.gc_stats;
+        ASSERT_GT(gs->runs, (uint64_t)0);
+        ASSERT_GT(gs->max_ns, (uint64_t)0);
+        ASSERT_GE(gs->total_ns, gs->max_ns);
+        if (modes[m] == HL_GC_REQUEST)
+            ASSERT_LT(lua_gc(lua.L, LUA_GCCOUNT, 0), base_kb + 256);
+        hl_lua_free(&lua);
+    }
+
+    unlink(path);
+    rmdir(dir);
+}
+
 /* ── Print exists test ──────────────────────────────────────────────── */
 
 UTEST(lua_runtime, print_exists)
@@ -424,6 +570,114 @@ UTEST(lua_runtime, require_vendor_json)
     cleanup_lua();
 }
 
+/* ── Precompiled bytecode tests ────────────────────────────────────── */
+
+typedef struct {
+    unsigned char buf[4096];
+    size_t len;
+} DumpBuf;
+
+static int dump_writer(lua_State *L, const void *p, size_t sz, void *ud)
+{
+    (void)L;
+    DumpBuf *d = (DumpBuf *)ud;
+    if (d->len + sz > sizeof(d->buf))
+        return 1;
+    memcpy(d->buf + d->len, p, sz);
+    d->len += sz;
+    return 0;
+}
+
+/* Compile `src` to bytecode in a scratch state. Returns 0 on success. */
+static int compile_chunk(const char *src, const char *name, DumpBuf *out)
+{
+    lua_State *L = luaL_newstate();
+    if (!L)
+        return -1;
+    out->len = 0;
+    int rc = -1;
+    if (luaL_loadbuffer(L, src, strlen(src), name) == LUA_OK &&
+        lua_dump(L, dump_writer, out, 0) == 0)
+        rc = 0;
+    lua_close(L);
+    return rc;
+}
+
+/* Init lua with a one-module app VFS and return __hull_modules[name]() */
+static int run_embedded_module(const HlEntry *entries, const char *name)
+{
+    static HlVfs app_vfs;
+    extern const HlEntry hl_stdlib_entries[];
+    hl_vfs_init(&platform_vfs, hl_stdlib_entries, NULL);
+    hl_vfs_init(&app_vfs, entries, NULL);
+    if (lua_initialized)
+        hl_lua_free(&lua_rt);
+    HlLuaConfig cfg = HL_LUA_CONFIG_DEFAULT;
+    memset(&lua_rt, 0, sizeof(lua_rt));
+    lua_rt.base.platform_vfs = &platform_vfs;
+    lua_rt.base.app_vfs = &app_vfs;
+    lua_initialized = (hl_lua_init(&lua_rt, &cfg) == 0);
+    if (!lua_initialized)
+        return -9999;
+
+    lua_getfield(lua_rt.L, LUA_REGISTRYINDEX, "__hull_modules");
+    lua_getfield(lua_rt.L, -1, name);
+    int result = -9999;
+    if (lua_isfunction(lua_rt.L, -1) &&
+        lua_pcall(lua_rt.L, 0, 1, 0) == LUA_OK)
+        result = (int)lua_tointeger(lua_rt.L, -1);
+    lua_settop(lua_rt.L, 0);
+    return result;
+}
+
+UTEST(lua_bytecode, stdlib_has_bytecode)
+{
+    extern const HlEntry hl_stdlib_entries[];
+    HlVfs vfs;
+    hl_vfs_init(&vfs, hl_stdlib_entries, NULL);
+
+    const HlEntry *bc = hl_vfs_find_suffixed(&vfs, "hull.json",
+                                             HL_LUA_BYTECODE_SUFFIX);
+    ASSERT_NE(bc, NULL);
+    ASSERT_GT(bc->len, 4u);
+    ASSERT_EQ(memcmp(bc->data, LUA_SIGNATURE, 4), 0);
+}
+
+UTEST(lua_bytecode, app_bytecode_preferred)
+{
+    /* Source and bytecode deliberately differ so we can tell which ran */
+    static DumpBuf bc;
+    ASSERT_EQ(compile_chunk("return 2", "./mod", &bc), 0);
+
+    const HlEntry entries[] = {
+        { "./mod",      (const unsigned char *)"return 1", 8 },
+        { "./mod.luac", bc.buf, (unsigned int)bc.len },
+        { 0, 0, 0 }
+    };
+    ASSERT_EQ(run_embedded_module(entries, "./mod"), 2);
+
+    /* The companion is not registered as a module of its own */
+    lua_getfield(lua_rt.L, LUA_REGISTRYINDEX, "__hull_modules");
+    lua_getfield(lua_rt.L, -1, "./mod.luac");
+    ASSERT_TRUE(lua_isnil(lua_rt.L, -1));
+    lua_settop(lua_rt.L, 0);
+
+    cleanup_lua();
+}
+
+UTEST(lua_bytecode, corrupt_bytecode_falls_back_to_source)
+{
+    static const unsigned char bogus[] = "\x1bLua\x01garbage";
+    const HlEntry entries[] = {
+        { "./mod",      (const unsigned char *)"return 1", 8 },
+        { "./mod.luac", bogus, sizeof(bogus) - 1 },
+        { 0, 0, 0 }
+    };
+    ASSERT_EQ(run_embedded_module(entries, "./mod"), 1);
+
+    cleanup_lua();
+}
+
 UTEST(lua_runtime, require_nonexistent_errors)
 {
     init_lua();
@@ -928,6 +1182,26 @@ UTEST(lua_cap, crypto_sha256)
     cleanup_lua_caps();
 }
 
+UTEST(lua_cap, crypto_sha256_many)
+{
+    init_lua_with_caps();
+    ASSERT_TRUE(lua_initialized);
+
+    char *hash = eval_str(
+        "(function() "
+        "  local h = crypto.sha256_many({'hello', '', 'hello'}) "
+        "  assert(#h == 3 and h[1] == h[3]) "
+        "  assert(h[2] == crypto.sha256('')) "
+        "  return h[1] "
+        "end)()");
+    ASSERT_NE(hash, NULL);
+    ASSERT_STREQ(hash,
+        "2cf24dba5fb0a30e26e83b2ac5b9e29e1b161e5c1fa7425e73043362938b9824");
+    free(hash);
+
+    cleanup_lua_caps();
+}
+
 UTEST(lua_cap, crypto_random)
 {
     init_lua_with_caps();
@@ -1115,6 +1389,48 @@ UTEST(lua_cap, db_parameterized_query)
     cleanup_lua_caps();
 }
 
+UTEST(lua_cap, db_each)
+{
+    init_lua_with_caps();
+    ASSERT_TRUE(lua_initialized);
+
+    /* Rows arrive in order; a query inside the callback is fine */
+    int result = eval_int(
+        "(function() "
+        "  db.exec('CREATE TABLE t4 (id INTEGER PRIMARY KEY, val INTEGER)') "
+        "  for i = 1, 5 do db.exec('INSERT INTO t4 (val) VALUES (?)', {i}) end "
+        "  local sum, inner = 0, 0 "
+        "  local n = db.each('SELECT val FROM t4 WHERE val > ? ORDER BY id', "
+        "                    {1}, function(row) "
+        "    sum = sum * 10 + row.val "
+        "    inner = inner + #db.query('SELECT val FROM t4') "
+        "  end) "
+        "  return (n == 4 and sum == 2345 and inner == 20) and 1 or 0 "
+        "end)()");
+    ASSERT_EQ(result, 1);
+
+    /* Returning false stops early */
+    result = eval_int(
+        "(function() "
+        "  return db.each('SELECT val FROM t4', function(row) "
+        "    return row.val < 3 "
+        "  end) "
+        "end)()");
+    ASSERT_EQ(result, 3);
+
+    /* An error in the callback propagates */
+    result = eval_int(
+        "(function() "
+        "  local ok, err = pcall(db.each, 'SELECT val FROM t4', function() "
+        "    error('boom') "
+        "  end) "
+        "  return (not ok and tostring(err):find('boom')) and 1 or 0 "
+        "end)()");
+    ASSERT_EQ(result, 1);
+
+    cleanup_lua_caps();
+}
+
 UTEST(lua_cap, db_not_available_without_config)
 {
     init_lua();
@@ -1244,6 +1560,23 @@ UTEST(lua_runtime, manifest_basic)
     ASSERT_EQ(m.hosts_count, 2);
     ASSERT_STREQ(m.hosts[0], "api.stripe.com");
     ASSERT_STREQ(m.hosts[1], "api.sendgrid.com");
+    ASSERT_EQ(m.access_log, 0);
+
+    cleanup_lua();
+}
+
+UTEST(lua_runtime, manifest_access_log)
+{
+    init_lua();
+    ASSERT_TRUE(lua_initialized);
+
+    int rc = luaL_dostring(lua_rt.L, "app.manifest({ access_log = true })\n");
+    ASSERT_EQ(rc, LUA_OK);
+
+    HlManifest m;
+    rc = hl_manifest_extract(lua_rt.L, &m);
+    ASSERT_EQ(rc, 0);
+    ASSERT_EQ(m.access_log, 1);
 
     cleanup_lua();
 }
@@ -1467,6 +1800,168 @@ UTEST(lua_middleware, order_preserved)
     cleanup_lua();
 }
 
+/* ── Hot reload ─────────────────────────────────────────────────────── */
+
+static const char reload_app_v1[] =
+    "app.get('/a', function(req, res) res:text('a') end)\n"
+    "app.use('*', '/*', function(req, res) return 0 end)\n";
+
+static void write_app(const char *path, const char *src)
+{
+    FILE *f = fopen(path, "w");
+    if (f) {
+        fputs(src, f);
+        fclose(f);
+    }
+}
+
+/* Load v1 into *lua, wire it into server, prepare r for reloading it */
+static int reload_setup(char *dir, char *path, size_t path_size, HlLua *lua,
+                        const HlLuaConfig *cfg, KlServer *server,
+                        HlManifest *m, HlReload *r)
+{
+    extern const HlEntry hl_stdlib_entries[];
+    if (!mkdtemp(dir))
+        return -1;
+    snprintf(path, path_size, "%s/app.lua", dir);
+    write_app(path, reload_app_v1);
+
+    hl_vfs_init(&platform_vfs, hl_stdlib_entries, NULL);
+    memset(lua, 0, sizeof(*lua));
+    lua->base.vt = &hl_lua_vtable;
+    lua->base.platform_vfs = &platform_vfs;
+    if (hl_lua_init(lua, cfg) != 0 || hl_lua_load_app(lua, path) != 0)
+        return -1;
+
+    KlConfig kcfg = { .port = 0, .max_connections = 1, .alloc = NULL };
+    kl_server_init(server, &kcfg);
+    if (hl_lua_wire_routes_server(lua, server, NULL) != 0)
+        return -1;
+
+    memset(m, 0, sizeof(*m));
+    hl_manifest_extract(lua->L, m);
+    memset(r, 0, sizeof(*r));
+    r->rt = &lua->base;
+    r->rt_size = sizeof(HlLua);
+    r->rt_cfg = cfg;
+    r->entry_point = path;
+    r->manifest = m;
+    return 0;
+}
+
+static void reload_teardown(char *dir, char *path, KlServer *server, HlReload *r)
+{
+    hl_lua_free((HlLua *)r->rt);
+    if (r->owned)
+        free(r->rt);
+    kl_server_free(server);
+    unlink(path);
+    rmdir(dir);
+}
+
+UTEST(lua_reload, swaps_runtime_in_place)
+{
+    char dir[] = "/tmp/hull_test_XXXXXX", path[1024];
+    HlLuaConfig cfg = HL_LUA_CONFIG_DEFAULT;
+    HlLua lua;
+    KlServer server;
+    HlManifest m;
+    HlReload r;
+    ASSERT_EQ(reload_setup(dir, path, sizeof(path), &lua, &cfg, &server, &m, &r), 0);
+
+    /* Route 0 is GET /a, route 1 the middleware */
+    HlLuaRoute *mw = (HlLuaRoute *)lua.routes[1];
+    KlRequest req = {0};
+    KlResponse res = {0};
+    ASSERT_EQ(hl_lua_dispatch_middleware(mw->lua, mw->handler_id, &req, &res), 0);
+
+    /* Same routes, new middleware body */
+    write_app(path,
+        "app.get('/a', function(req, res) res:text('b') end)\n"
+        "app.use('*', '/*', function(req, res) return 1 end)\n");
+    struct timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    ASSERT_EQ(hl_reload_run(&r), 0);
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+
+    HlLua *cur = (HlLua *)r.rt;
+    ASSERT_TRUE(cur != &lua);
+    ASSERT_EQ(r.count, (uint64_t)1);
+    ASSERT_EQ(cur->route_count, (size_t)2);
+    ASSERT_TRUE(cur->routes[1] == mw);      /* Keel's context survives */
+    ASSERT_TRUE(mw->lua == cur);            /* ... now pointing at v2 */
+    ASSERT_TRUE(lua.L == NULL);             /* v1 state closed */
+    ASSERT_EQ(hl_lua_dispatch_middleware(mw->lua, mw->handler_id, &req, &res), 1);
+
+    printf("  reload %.2f ms\n", (double)(t1.tv_sec - t0.tv_sec) * 1e3 +
+                                 (double)(t1.tv_nsec - t0.tv_nsec) / 1e6);
+    reload_teardown(dir, path, &server, &r);
+}
+
+UTEST(lua_reload, route_change_needs_restart)
+{
+    char dir[] = "/tmp/hull_test_XXXXXX", path[1024];
+    HlLuaConfig cfg = HL_LUA_CONFIG_DEFAULT;
+    HlLua lua;
+    KlServer server;
+    HlManifest m;
+    HlReload r;
+    ASSERT_EQ(reload_setup(dir, path, sizeof(path), &lua, &cfg, &server, &m, &r), 0);
+
+    write_app(path, "app.get('/a', function(req, res) end)\n"
+                    "app.get('/b', function(req, res) end)\n"
+                    "app.use('*', '/*', function(req, res) return 0 end)\n");
+    ASSERT_EQ(hl_reload_run(&r), 1);
+
+    /* Pattern changed in place */
+    write_app(path, "app.get('/a/:id', function(req, res) end)\n"
+                    "app.use('*', '/*', function(req, res) return 0 end)\n");
+    ASSERT_EQ(hl_reload_run(&r), 1);
+
+    ASSERT_TRUE(r.rt == &lua.base);
+    ASSERT_TRUE(((HlLuaRoute *)lua.routes[0])->lua == &lua);
+    reload_teardown(dir, path, &server, &r);
+}
+
+UTEST(lua_reload, manifest_change_needs_restart)
+{
+    char dir[] = "/tmp/hull_test_XXXXXX", path[1024];
+    HlLuaConfig cfg = HL_LUA_CONFIG_DEFAULT;
+    HlLua lua;
+    KlServer server;
+    HlManifest m;
+    HlReload r;
+    ASSERT_EQ(reload_setup(dir, path, sizeof(path), &lua, &cfg, &server, &m, &r), 0);
+
+    char src[512];
+    snprintf(src, sizeof(src), "app.manifest({ env = {'HOME'} })\n%s", reload_app_v1);
+    write_app(path, src);
+    ASSERT_EQ(hl_reload_run(&r), 1);
+    ASSERT_TRUE(r.rt == &lua.base);
+    reload_teardown(dir, path, &server, &r);
+}
+
+UTEST(lua_reload, load_error_keeps_previous)
+{
+    char dir[] = "/tmp/hull_test_XXXXXX", path[1024];
+    HlLuaConfig cfg = HL_LUA_CONFIG_DEFAULT;
+    HlLua lua;
+    KlServer server;
+    HlManifest m;
+    HlReload r;
+    ASSERT_EQ(reload_setup(dir, path, sizeof(path), &lua, &cfg, &server, &m, &r), 0);
+
+    write_app(path, "app.get('/a', function(req, res)\n");   /* syntax error */
+    ASSERT_EQ(hl_reload_run(&r), -1);
+    ASSERT_TRUE(r.rt == &lua.base);
+    ASSERT_TRUE(lua.L != NULL);
+
+    /* Fixed on the next save */
+    write_app(path, reload_app_v1);
+    ASSERT_EQ(hl_reload_run(&r), 0);
+    reload_teardown(dir, path, &server, &r);
+}
+
 UTEST(lua_runtime, manifest_get_manifest)
 {
     init_lua();
@@ -1491,6 +1986,109 @@ UTEST(lua_runtime, manifest_get_manifest)
     cleanup_lua();
 }
 
+UTEST(lua_runtime, background_jobs)
+{
+    init_lua();
+    ASSERT_TRUE(lua_initialized);
+
+    const char *code =
+        "hits = 0\n"
+        "app.every('30s', function() hits = hits + 1 end, { name = 'tick', jitter = 0.5 })\n"
+        "app.at('0 3 * * *', function() error('boom') end)\n"
+        "assert(not pcall(app.every, '10ms', function() end))\n"
+        "assert(not pcall(app.every, 60))\n"
+        "assert(not pcall(app.at, '61 * * * *', function() end))\n";
+    ASSERT_EQ(luaL_dostring(lua_rt.L, code), LUA_OK);
+
+    HlJobDef jobs[4];
+    ASSERT_EQ(hl_lua_extract_jobs(&lua_rt, jobs, 4), 2);
+    ASSERT_STREQ(jobs[0].name, "tick");
+    ASSERT_EQ(jobs[0].every_ms, 30000);
+    ASSERT_EQ(jobs[0].jitter_ms, 500);
+    ASSERT_STREQ(jobs[1].name, "at 0 3 * * *");
+    ASSERT_EQ(jobs[1].every_ms, 0);
+
+    ASSERT_EQ(hl_lua_run_job(&lua_rt, jobs[0].handler_id), 0);
+    ASSERT_EQ(hl_lua_run_job(&lua_rt, jobs[1].handler_id), -1);
+    lua_getglobal(lua_rt.L, "hits");
+    ASSERT_EQ(lua_tointeger(lua_rt.L, -1), 1);
+    lua_pop(lua_rt.L, 1);
+
+    cleanup_lua();
+}
+
+UTEST(lua_runtime, outbox_bridge)
+{
+    init_lua();
+    ASSERT_TRUE(lua_initialized);
+
+    /* Without --outbox-workers flush() keeps every kind */
+    ASSERT_EQ(luaL_dostring(lua_rt.L,
+        "assert(_outbox.native() == false)\n"
+        "_outbox.wake()\n"), LUA_OK);
+
+    int marker;
+    lua_rt.base.outbox = (HlOutbox *)&marker;   /* only native() looks at it */
+    ASSERT_EQ(luaL_dostring(lua_rt.L, "assert(_outbox.native() == true)"), LUA_OK);
+    lua_rt.base.outbox = NULL;
+
+    cleanup_lua();
+}
+
+UTEST(lua_runtime, upload_route_options)
+{
+    init_lua();
+    ASSERT_TRUE(lua_initialized);
+
+    const char *code =
+        "app.post('/stream', function(req, res) end,\n"
+        "         { body = 'stream', max_body = '2m',\n"
+        "           on_chunk = function(req, chunk) end })\n"
+        "app.post('/spool', function(req, res) end,\n"
+        "         { body = 'spool', dir = 'data/uploads' })\n"
+        "assert(not pcall(app.post, '/x', function() end, { body = 'disk' }))\n"
+        "assert(not pcall(app.post, '/x', function() end, { body = 'stream' }))\n"
+        "assert(not pcall(app.post, '/x', function() end,\n"
+        "                 { on_chunk = function() end }))\n"
+        "assert(not pcall(app.post, '/x', function() end, { max_body = 'lots' }))\n"
+        "assert(not pcall(app.post, '/x', function() end, 'spool'))\n";
+    ASSERT_EQ(luaL_dostring(lua_rt.L, code), LUA_OK);
+
+    lua_getfield(lua_rt.L, LUA_REGISTRYINDEX, "__hull_route_defs");
+    ASSERT_EQ((int)luaL_len(lua_rt.L, -1), 2);
+    lua_rawgeti(lua_rt.L, -1, 1);
+    lua_getfield(lua_rt.L, -1, "max_body");
+    ASSERT_EQ(lua_tointeger(lua_rt.L, -1), 2 * 1024 * 1024);
+    lua_getfield(lua_rt.L, -2, "chunk_id");
+    ASSERT_TRUE(lua_isinteger(lua_rt.L, -1));
+    lua_pop(lua_rt.L, 4);
+
+    /* The spool directory must be covered by manifest fs.write */
+    KlServer server;
+    KlConfig cfg = { .port = 0, .max_connections = 1, .alloc = NULL };
+    kl_server_init(&server, &cfg);
+    wiring_alloc_count_lua = 0;
+    ASSERT_EQ(hl_lua_wire_routes_server(&lua_rt, &server, tracking_alloc_lua), -1);
+    for (int i = 0; i < wiring_alloc_count_lua; i++)
+        free(wiring_allocs_lua[i]);
+    kl_server_free(&server);
+
+    HlManifest m;
+    memset(&m, 0, sizeof(m));
+    m.fs_write[0] = "data/";
+    m.fs_write_count = 1;
+    lua_rt.base.manifest = &m;
+    kl_server_init(&server, &cfg);
+    wiring_alloc_count_lua = 0;
+    ASSERT_EQ(hl_lua_wire_routes_server(&lua_rt, &server, tracking_alloc_lua), 0);
+    for (int i = 0; i < wiring_alloc_count_lua; i++)
+        free(wiring_allocs_lua[i]);
+    kl_server_free(&server);
+    lua_rt.base.manifest = NULL;
+
+    cleanup_lua();
+}
+
 /* ── HMAC-SHA256 / base64url tests ─────────────────────────────────── */
 
 UTEST(lua_cap, crypto_hmac_sha256)
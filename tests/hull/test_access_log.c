@@ -0,0 +1,227 @@
+/*
+ * test_access_log.c — Tests for the native access log
+ *
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#include "utest.h"
+#include "hull/access_log.h"
+#include "hull/limits.h"
+#include "hull/log_sink.h"
+
+#include <keel/allocator.h>
+#include <keel/request.h>
+#include <keel/response.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+static KlRequest make_request(const char *method, const char *path)
+{
+    KlRequest req;
+    memset(&req, 0, sizeof(req));
+    req.method = method;
+    req.method_len = strlen(method);
+    req.path = path;
+    req.path_len = strlen(path);
+    return req;
+}
+
+static int has_header(const KlResponse *res, const char *name)
+{
+    size_t n = strlen(name);
+    for (size_t i = 0; res->hdr_buf && i + n <= res->hdr_len; i++)
+        if (memcmp(res->hdr_buf + i, name, n) == 0)
+            return 1;
+    return 0;
+}
+
+/* Run emit() with the sink writing to a temp file; returns its contents */
+static char *capture(HlLogFormat format, void (*emit)(void))
+{
+    char path[] = "/tmp/hull_access_XXXXXX";
+    int fd = mkstemp(path);
+    if (fd < 0)
+        return NULL;
+    unlink(path);
+
+    hl_log_sink_set_format(format);
+    if (hl_log_sink_start(fd, HL_LOG_BLOCK) != 0) {
+        close(fd);
+        return NULL;
+    }
+    emit();
+    hl_log_sink_stop();
+    hl_log_sink_set_format(HL_LOG_TEXT);
+
+    off_t size = lseek(fd, 0, SEEK_END);
+    char *buf = malloc((size_t)size + 1);
+    if (buf && pread(fd, buf, (size_t)size, 0) != (ssize_t)size) {
+        free(buf);
+        buf = NULL;
+    }
+    if (buf)
+        buf[size] = '\0';
+    close(fd);
+    return buf;
+}
+
+/* One request through middleware and finish, as the trampolines do */
+static void emit_request(void)
+{
+    KlAllocator alloc = kl_allocator_default();
+    KlRequest req = make_request("POST", "/tasks/7");
+    KlResponse res;
+    memset(&res, 0, sizeof(res));
+    kl_response_init(&res, &alloc);
+
+    hl_access_log_enabled = 1;
+    hl_access_log_middleware(&req, &res, NULL);
+    kl_response_status(&res, 201);
+    kl_response_body(&res, "{\"id\":7}", 8);
+    hl_access_log_finish(&req, res.status, res.body_len);
+    hl_access_log_enabled = 0;
+
+    kl_response_free(&res);
+}
+
+/* ── Enable flag ───────────────────────────────────────────────────── */
+
+UTEST(access_log, disabled_is_noop)
+{
+    KlAllocator alloc = kl_allocator_default();
+    KlRequest req = make_request("GET", "/");
+    KlResponse res;
+    memset(&res, 0, sizeof(res));
+    kl_response_init(&res, &alloc);
+
+    hl_access_log_enabled = 0;
+    uint64_t before = hl_access_log_count();
+    ASSERT_EQ(hl_access_log_middleware(&req, &res, NULL), 0);
+    hl_access_log_finish(&req, 200, 0);
+    ASSERT_EQ(hl_access_log_count(), before);
+    ASSERT_FALSE(has_header(&res, "X-Request-ID"));
+
+    kl_response_free(&res);
+}
+
+UTEST(access_log, middleware_sets_request_id)
+{
+    KlAllocator alloc = kl_allocator_default();
+    KlRequest req = make_request("GET", "/");
+    KlResponse res;
+    memset(&res, 0, sizeof(res));
+    kl_response_init(&res, &alloc);
+
+    hl_access_log_enabled = 1;
+    ASSERT_EQ(hl_access_log_middleware(&req, &res, NULL), 0);
+    ASSERT_TRUE(has_header(&res, "X-Request-ID"));
+    hl_access_log_enabled = 0;
+
+    kl_response_free(&res);
+}
+
+/* ── Line format ───────────────────────────────────────────────────── */
+
+UTEST(access_log, logfmt_line)
+{
+    char *out = capture(HL_LOG_LOGFMT, emit_request);
+    ASSERT_TRUE(out != NULL);
+    ASSERT_NE(strstr(out, " level=info msg=access req_id="), NULL);
+    ASSERT_NE(strstr(out, " method=POST path=/tasks/7 status=201 bytes=8 dur_us="),
+              NULL);
+    ASSERT_EQ(out[strlen(out) - 1], '\n');
+    free(out);
+}
+
+UTEST(access_log, json_line)
+{
+    char *out = capture(HL_LOG_JSON, emit_request);
+    ASSERT_TRUE(out != NULL);
+    ASSERT_NE(strstr(out, "\"msg\":\"access\",\"req_id\":\""), NULL);
+    ASSERT_NE(strstr(out, "\"method\":\"POST\",\"path\":\"/tasks/7\","
+                          "\"status\":201,\"bytes\":8,\"dur_us\":"), NULL);
+    ASSERT_EQ(strcmp(out + strlen(out) - 2, "}\n"), 0);
+    free(out);
+}
+
+static void emit_odd_path(void)
+{
+    /* Quotes and spaces must not break the line apart */
+    KlRequest req = make_request("GET", "/a b\"c");
+    hl_access_log_enabled = 1;
+    hl_access_log_finish(&req, 404, 0);
+    hl_access_log_enabled = 0;
+}
+
+UTEST(access_log, path_is_escaped)
+{
+    char *out = capture(HL_LOG_LOGFMT, emit_odd_path);
+    ASSERT_TRUE(out != NULL);
+    ASSERT_NE(strstr(out, " path=\"/a b\\\"c\" status=404 bytes=0"), NULL);
+    free(out);
+
+    out = capture(HL_LOG_JSON, emit_odd_path);
+    ASSERT_TRUE(out != NULL);
+    ASSERT_NE(strstr(out, "\"path\":\"/a b\\\"c\",\"status\":404"), NULL);
+    free(out);
+}
+
+static void emit_long_path(void)
+{
+    static char path[HL_LOG_LINE_MAX * 2];
+    memset(path, 'x', sizeof(path) - 1);
+    path[0] = '/';
+    KlRequest req = make_request("GET", path);
+    hl_access_log_enabled = 1;
+    hl_access_log_finish(&req, 200, 1);
+    hl_access_log_enabled = 0;
+}
+
+UTEST(access_log, long_path_keeps_fields)
+{
+    char *out = capture(HL_LOG_JSON, emit_long_path);
+    ASSERT_TRUE(out != NULL);
+    ASSERT_LE(strlen(out), (size_t)HL_LOG_LINE_MAX);
+    ASSERT_NE(strstr(out, "\",\"status\":200,\"bytes\":1,\"dur_us\":"), NULL);
+    free(out);
+}
+
+/* ── Benchmark ─────────────────────────────────────────────────────── */
+
+UTEST(access_log, per_request_cost)
+{
+    enum { REQS = 200000 };
+
+    FILE *devnull = fopen("/dev/null", "w");
+    ASSERT_TRUE(devnull != NULL);
+    ASSERT_EQ(hl_log_sink_start(fileno(devnull), HL_LOG_BLOCK), 0);
+
+    KlAllocator alloc = kl_allocator_default();
+    KlRequest req = make_request("GET", "/tasks/42");
+    hl_access_log_enabled = 1;
+
+    struct timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (int i = 0; i < REQS; i++) {
+        KlResponse res;
+        memset(&res, 0, sizeof(res));
+        kl_response_init(&res, &alloc);
+        hl_access_log_middleware(&req, &res, NULL);
+        hl_access_log_finish(&req, 200, 128);
+        kl_response_free(&res);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+
+    hl_access_log_enabled = 0;
+    hl_log_sink_stop();
+    fclose(devnull);
+
+    double ns = ((double)(t1.tv_sec - t0.tv_sec) * 1e9 +
+                 (double)(t1.tv_nsec - t0.tv_nsec)) / REQS;
+    printf("  access log %.0f ns/request\n", ns);
+}
+
+UTEST_MAIN();
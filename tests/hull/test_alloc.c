@@ -0,0 +1,280 @@
+/*
+ * test_alloc.c — Tests for the tracking allocator and its size-class pool
+ *
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#include "utest.h"
+#include "hull/alloc.h"
+#include "hull/limits.h"
+
+#include "lua.h"
+#include "lualib.h"
+#include "lauxlib.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+/* Both backends must behave identically from the caller's side */
+static void init_backend(HlAllocator *a, size_t limit, int pool)
+{
+    hl_alloc_init(a, limit);
+    if (pool)
+        hl_alloc_use_pool(a);
+}
+
+/* ── Accounting ────────────────────────────────────────────────────── */
+
+static int check_accounting(int pool)
+{
+    HlAllocator a;
+    init_backend(&a, 0, pool);
+
+    void *small = hl_alloc_malloc(&a, 24);
+    void *mid   = hl_alloc_malloc(&a, 700);
+    void *large = hl_alloc_malloc(&a, 5000);
+    if (!small || !mid || !large)
+        return 0;
+    if (hl_alloc_used(&a) != 24 + 700 + 5000)
+        return 0;
+
+    memset(small, 0xAA, 24);
+    memset(mid, 0xBB, 700);
+    memset(large, 0xCC, 5000);
+
+    hl_alloc_free(&a, mid, 700);
+    if (hl_alloc_used(&a) != 24 + 5000)
+        return 0;
+    hl_alloc_free(&a, small, 24);
+    hl_alloc_free(&a, large, 5000);
+    int ok = hl_alloc_used(&a) == 0 && hl_alloc_peak(&a) == 24 + 700 + 5000;
+    hl_alloc_destroy(&a);
+    return ok;
+}
+
+UTEST(alloc, accounting_libc)
+{
+    ASSERT_TRUE(check_accounting(0));
+}
+
+UTEST(alloc, accounting_pool)
+{
+    ASSERT_TRUE(check_accounting(1));
+}
+
+static int check_limit(int pool)
+{
+    HlAllocator a;
+    init_backend(&a, 1000, pool);
+
+    void *p = hl_alloc_malloc(&a, 600);
+    if (!p)
+        return 0;
+    /* Over the limit: refused before touching the backend */
+    if (hl_alloc_malloc(&a, 500) != NULL)
+        return 0;
+    if (hl_alloc_realloc(&a, p, 600, 1100) != NULL)
+        return 0;
+    p = hl_alloc_realloc(&a, p, 600, 1000);
+    if (!p || hl_alloc_used(&a) != 1000)
+        return 0;
+    hl_alloc_free(&a, p, 1000);
+    int ok = hl_alloc_used(&a) == 0;
+    hl_alloc_destroy(&a);
+    return ok;
+}
+
+UTEST(alloc, limit_libc)
+{
+    ASSERT_TRUE(check_limit(0));
+}
+
+UTEST(alloc, limit_pool)
+{
+    ASSERT_TRUE(check_limit(1));
+}
+
+/* ── Pool behaviour ────────────────────────────────────────────────── */
+
+UTEST(alloc, pool_backend_selection)
+{
+    HlAllocator a;
+    hl_alloc_init(&a, 0);
+    ASSERT_STREQ(hl_alloc_backend(&a), "libc");
+    ASSERT_EQ(hl_alloc_pool_reserved(&a), (size_t)0);
+
+    ASSERT_EQ(hl_alloc_use_pool(&a), 0);
+    ASSERT_STREQ(hl_alloc_backend(&a), "pool");
+
+    void *p = hl_alloc_malloc(&a, 32);
+    ASSERT_TRUE(p != NULL);
+    ASSERT_EQ(hl_alloc_pool_reserved(&a), (size_t)HL_POOL_CHUNK_SIZE);
+    hl_alloc_free(&a, p, 32);
+
+    hl_alloc_destroy(&a);
+    ASSERT_STREQ(hl_alloc_backend(&a), "libc");
+    hl_alloc_destroy(&a); /* idempotent */
+}
+
+UTEST(alloc, pool_reuses_freed_blocks)
+{
+    HlAllocator a;
+    hl_alloc_init(&a, 0);
+    ASSERT_EQ(hl_alloc_use_pool(&a), 0);
+
+    void *p = hl_alloc_malloc(&a, 40);
+    hl_alloc_free(&a, p, 40);
+    /* Same class (48): LIFO free list hands the block straight back */
+    void *q = hl_alloc_malloc(&a, 33);
+    ASSERT_TRUE(p == q);
+    hl_alloc_free(&a, q, 33);
+
+    hl_alloc_destroy(&a);
+}
+
+UTEST(alloc, pool_realloc_across_classes)
+{
+    HlAllocator a;
+    hl_alloc_init(&a, 0);
+    ASSERT_EQ(hl_alloc_use_pool(&a), 0);
+
+    unsigned char *p = hl_alloc_malloc(&a, 10);
+    ASSERT_TRUE(p != NULL);
+    for (int i = 0; i < 10; i++)
+        p[i] = (unsigned char)i;
+
+    /* Grows in place while the class still fits */
+    unsigned char *q = hl_alloc_realloc(&a, p, 10, 16);
+    ASSERT_TRUE(q == p);
+
+    /* Small -> larger class -> large (malloc) -> back to small */
+    size_t sizes[] = { 200, 1024, 1025, 9000, 100 };
+    size_t old = 16;
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+        q = hl_alloc_realloc(&a, q, old, sizes[s]);
+        ASSERT_TRUE(q != NULL);
+        for (int i = 0; i < 10; i++)
+            ASSERT_EQ(q[i], (unsigned char)i);
+        memset(q + 10, 0x5A, sizes[s] - 10);
+        old = sizes[s];
+        ASSERT_EQ(hl_alloc_used(&a), old);
+    }
+
+    hl_alloc_free(&a, q, old);
+    ASSERT_EQ(hl_alloc_used(&a), (size_t)0);
+    hl_alloc_destroy(&a);
+}
+
+UTEST(alloc, pool_free_ignores_size_for_ownership)
+{
+    HlAllocator a;
+    hl_alloc_init(&a, 0);
+    ASSERT_EQ(hl_alloc_use_pool(&a), 0);
+
+    /* A pooled block freed with a "large" size and a malloc'd block freed
+     * with a "small" size must each go back to the right place. */
+    void *small = hl_alloc_malloc(&a, 64);
+    void *large = hl_alloc_malloc(&a, 4096);
+    ASSERT_TRUE(small && large);
+    hl_alloc_free(&a, small, 4096);
+    hl_alloc_free(&a, large, 64);
+
+    hl_alloc_destroy(&a);
+}
+
+UTEST(alloc, pool_many_slabs)
+{
+    enum { N = 20000 };
+    static void *ptrs[N];
+    HlAllocator a;
+    hl_alloc_init(&a, 0);
+    ASSERT_EQ(hl_alloc_use_pool(&a), 0);
+
+    for (int i = 0; i < N; i++) {
+        size_t sz = 16 + (size_t)(i * 37) % HL_POOL_MAX_SIZE;
+        ptrs[i] = hl_alloc_malloc(&a, sz);
+        ASSERT_TRUE(ptrs[i] != NULL);
+        memset(ptrs[i], i & 0xFF, sz);
+    }
+    ASSERT_TRUE(hl_alloc_pool_reserved(&a) > (size_t)64 * HL_POOL_CHUNK_SIZE);
+    for (int i = 0; i < N; i++) {
+        size_t sz = 16 + (size_t)(i * 37) % HL_POOL_MAX_SIZE;
+        ASSERT_EQ(((unsigned char *)ptrs[i])[sz - 1], (unsigned char)(i & 0xFF));
+        hl_alloc_free(&a, ptrs[i], sz);
+    }
+    ASSERT_EQ(hl_alloc_used(&a), (size_t)0);
+
+    hl_alloc_destroy(&a);
+}
+
+/* ── Lua churn ─────────────────────────────────────────────────────── */
+
+/*
+ * Same routing as the Lua runtime's allocator: free with the real size,
+ * malloc for new blocks (osize is a type hint then), realloc otherwise.
+ */
+static void *lua_alloc(void *ud, void *ptr, size_t osize, size_t nsize)
+{
+    HlAllocator *a = ud;
+    if (nsize == 0) {
+        hl_alloc_free(a, ptr, osize);
+        return NULL;
+    }
+    if (!ptr)
+        return hl_alloc_malloc(a, nsize);
+    return hl_alloc_realloc(a, ptr, osize, nsize);
+}
+
+/* A request-shaped workload: short strings, small tables, JSON-ish
+ * string building, all garbage by the end of each "request". */
+static const char *churn_src =
+    "local reqs = ...\n"
+    "local sink = 0\n"
+    "for r = 1, reqs do\n"
+    "  local headers = {}\n"
+    "  for i = 1, 12 do headers['x-h' .. i] = 'value-' .. (r * i) end\n"
+    "  local rows = {}\n"
+    "  for i = 1, 20 do\n"
+    "    rows[i] = { id = i, name = 'user' .. i, email = 'u' .. i .. '@x.io' }\n"
+    "  end\n"
+    "  local parts = {}\n"
+    "  for i, row in ipairs(rows) do\n"
+    "    parts[#parts + 1] = string.format('{\"id\":%d,\"name\":\"%s\"}',\n"
+    "                                      row.id, row.name)\n"
+    "  end\n"
+    "  sink = sink + #table.concat(parts, ',')\n"
+    "end\n"
+    "return sink\n";
+
+/* One Lua state on the given backend; 0 when it runs and frees everything */
+static int run_churn(int pool, int reqs)
+{
+    HlAllocator a;
+    hl_alloc_init(&a, 0);
+    if (pool)
+        hl_alloc_use_pool(&a);
+
+    lua_State *L = lua_newstate(lua_alloc, &a);
+    if (!L)
+        return -1;
+    luaL_openlibs(L);
+    int rc = luaL_loadstring(L, churn_src);
+    if (rc == LUA_OK) {
+        lua_pushinteger(L, reqs);
+        rc = lua_pcall(L, 1, 1, 0);
+    }
+
+    lua_close(L);
+    int leaked = hl_alloc_used(&a) != 0;
+    hl_alloc_destroy(&a);
+    return (rc != LUA_OK || leaked) ? -1 : 0;
+}
+
+UTEST(alloc, lua_churn_no_leak)
+{
+    ASSERT_EQ(run_churn(0, 50), 0);
+    ASSERT_EQ(run_churn(1, 50), 0);
+}
+
+UTEST_MAIN();
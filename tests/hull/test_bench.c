@@ -0,0 +1,414 @@
+/*
+ * test_bench.c — Tests for the hull bench request mix and runners
+ *
+ * The loopback tests run against a minimal HTTP/1.1 server on a thread
+ * in this process.
+ *
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#include "utest.h"
+#include "hull/bench.h"
+
+#include <sh_json.h>
+#include <sh_arena.h>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+static int parse(HlBenchScript *s, const char *json)
+{
+    char err[256];
+    return hl_bench_script_parse(s, json, strlen(json), err, sizeof(err));
+}
+
+/* ── Test server ───────────────────────────────────────────────────── */
+
+typedef struct {
+    int listen_fd;
+    int port;
+    int accepted;
+    pthread_mutex_t lock;
+    pthread_t thread;
+} TestServer;
+
+static void reply(int fd, const char *text)
+{
+    size_t len = strlen(text);
+    while (len > 0) {
+        ssize_t n = send(fd, text, len, MSG_NOSIGNAL);
+        if (n <= 0)
+            return;
+        text += n;
+        len -= (size_t)n;
+    }
+}
+
+/* Serve requests on one connection until the client or /close ends it */
+static void *serve_conn(void *arg)
+{
+    int fd = (int)(intptr_t)arg;
+    char buf[8192];
+    size_t len = 0;
+    buf[0] = '\0';
+
+    for (;;) {
+        char *end = NULL;
+        while (!(end = strstr(buf, "\r\n\r\n"))) {
+            ssize_t n = recv(fd, buf + len, sizeof(buf) - 1 - len, 0);
+            if (n <= 0)
+                goto done;
+            len += (size_t)n;
+            buf[len] = '\0';
+        }
+
+        /* Skip the request body */
+        size_t used = (size_t)(end + 4 - buf);
+        const char *cl = strstr(buf, "Content-Length: ");
+        if (cl && cl < end)
+            used += (size_t)atoi(cl + 16);
+        while (len < used) {
+            ssize_t n = recv(fd, buf + len, sizeof(buf) - 1 - len, 0);
+            if (n <= 0)
+                goto done;
+            len += (size_t)n;
+            buf[len] = '\0';
+        }
+
+        int close_after = 0;
+        if (strncmp(buf, "GET /ok ", 8) == 0 || strncmp(buf, "POST /ok ", 9) == 0) {
+            reply(fd, "HTTP/1.1 200 OK\r\nContent-Length: 2\r\n\r\nok");
+        } else if (strncmp(buf, "GET /chunked ", 13) == 0) {
+            reply(fd, "HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\n"
+                      "3\r\nabc\r\n2\r\nde\r\n0\r\n\r\n");
+        } else if (strncmp(buf, "GET /close ", 11) == 0) {
+            reply(fd, "HTTP/1.1 200 OK\r\nConnection: close\r\n"
+                      "Content-Length: 3\r\n\r\nbye");
+            close_after = 1;
+        } else {
+            reply(fd, "HTTP/1.1 404 Not Found\r\nContent-Length: 0\r\n\r\n");
+        }
+        if (close_after)
+            break;
+
+        memmove(buf, buf + used, len - used);
+        len -= used;
+        buf[len] = '\0';
+    }
+done:
+    close(fd);
+    return NULL;
+}
+
+static void *serve(void *arg)
+{
+    TestServer *srv = arg;
+    for (;;) {
+        int c = accept(srv->listen_fd, NULL, NULL);
+        if (c < 0)
+            return NULL;
+        pthread_mutex_lock(&srv->lock);
+        srv->accepted++;
+        pthread_mutex_unlock(&srv->lock);
+        pthread_t t;
+        if (pthread_create(&t, NULL, serve_conn, (void *)(intptr_t)c) == 0)
+            pthread_detach(t);
+        else
+            close(c);
+    }
+}
+
+static int server_start(TestServer *srv)
+{
+    memset(srv, 0, sizeof(*srv));
+    pthread_mutex_init(&srv->lock, NULL);
+    srv->listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (srv->listen_fd < 0)
+        return -1;
+    struct sockaddr_in sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sin_family = AF_INET;
+    sa.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t sl = sizeof(sa);
+    if (bind(srv->listen_fd, (struct sockaddr *)&sa, sizeof(sa)) != 0 ||
+        listen(srv->listen_fd, 64) != 0 ||
+        getsockname(srv->listen_fd, (struct sockaddr *)&sa, &sl) != 0)
+        return -1;
+    srv->port = ntohs(sa.sin_port);
+    return pthread_create(&srv->thread, NULL, serve, srv);
+}
+
+static void server_stop(TestServer *srv)
+{
+    shutdown(srv->listen_fd, SHUT_RDWR);
+    close(srv->listen_fd);
+    pthread_join(srv->thread, NULL);
+    pthread_mutex_destroy(&srv->lock);
+}
+
+/* ── Script ────────────────────────────────────────────────────────── */
+
+UTEST(bench, script_parse)
+{
+    HlBenchScript s;
+    ASSERT_EQ(parse(&s,
+        "{\"requests\": ["
+        "  {\"path\": \"/items/{{rand:10}}\", \"weight\": 3},"
+        "  {\"method\": \"POST\", \"path\": \"/items\","
+        "   \"headers\": {\"Content-Type\": \"application/json\"},"
+        "   \"body\": \"{\\\"n\\\":{{seq}}}\"}]}"), 0);
+
+    ASSERT_EQ(s.count, 2);
+    ASSERT_EQ(s.total_weight, 4u);
+    ASSERT_STREQ(s.reqs[0].method, "GET");
+    ASSERT_TRUE(s.reqs[0].body == NULL);
+    ASSERT_STREQ(s.reqs[1].method, "POST");
+    ASSERT_EQ(s.reqs[1].weight, 1u);
+    ASSERT_EQ(s.reqs[1].num_headers, 1);
+    ASSERT_STREQ(s.reqs[1].header_names[0], "Content-Type");
+    ASSERT_STREQ(s.reqs[1].body, "{\"n\":{{seq}}}");
+
+    hl_bench_script_free(&s);
+}
+
+UTEST(bench, script_errors)
+{
+    HlBenchScript s;
+    ASSERT_EQ(parse(&s, "{"), -1);
+    ASSERT_EQ(parse(&s, "{\"requests\": []}"), -1);
+    ASSERT_EQ(parse(&s, "[{\"method\": \"GET\"}]"), -1);
+    ASSERT_EQ(parse(&s, "[{\"path\": \"relative\"}]"), -1);
+    ASSERT_EQ(parse(&s, "[{\"path\": \"/\", \"weight\": 0}]"), -1);
+    ASSERT_EQ(parse(&s, "[{\"path\": \"/\", \"body\": 5}]"), -1);
+    ASSERT_EQ(parse(&s, "[{\"path\": \"/\", \"headers\": {\"X\": 1}}]"), -1);
+
+    /* The bare array form is accepted */
+    ASSERT_EQ(parse(&s, "[{\"path\": \"/\"}]"), 0);
+    hl_bench_script_free(&s);
+}
+
+/* ── Expansion ─────────────────────────────────────────────────────── */
+
+UTEST(bench, expand)
+{
+    uint64_t rng = 7;
+    char buf[64];
+
+    ASSERT_EQ(hl_bench_expand("/u/{{seq}}/c{{conn}}", 42, 3, &rng,
+                              buf, sizeof(buf)), 8);
+    ASSERT_STREQ(buf, "/u/42/c3");
+
+    for (int i = 0; i < 100; i++) {
+        ASSERT_GT(hl_bench_expand("{{rand:10}}", 0, 0, &rng, buf, sizeof(buf)), 0);
+        ASSERT_LT(atoi(buf), 10);
+    }
+
+    /* Anything else is literal */
+    ASSERT_GT(hl_bench_expand("{{name}} {{rand:x}} {{", 0, 0, &rng,
+                              buf, sizeof(buf)), 0);
+    ASSERT_STREQ(buf, "{{name}} {{rand:x}} {{");
+
+    ASSERT_EQ(hl_bench_expand("/{{seq}}", 123456, 0, &rng, buf, 6), -1);
+}
+
+UTEST(bench, pick_is_weighted_and_seeded)
+{
+    HlBenchScript s;
+    ASSERT_EQ(parse(&s, "[{\"path\": \"/a\", \"weight\": 9},"
+                        " {\"path\": \"/b\", \"weight\": 1}]"), 0);
+
+    uint64_t r1 = 99, r2 = 99;
+    int counts[2] = { 0, 0 };
+    for (int i = 0; i < 10000; i++) {
+        int a = hl_bench_pick(&s, &r1);
+        ASSERT_EQ(a, hl_bench_pick(&s, &r2));
+        counts[a]++;
+    }
+    ASSERT_GT(counts[0], 8700);
+    ASSERT_LT(counts[0], 9300);
+
+    hl_bench_script_free(&s);
+}
+
+UTEST(bench, format_http)
+{
+    HlBenchScript s;
+    ASSERT_EQ(parse(&s, "[{\"method\": \"POST\", \"path\": \"/p/{{seq}}\","
+                        " \"headers\": {\"X-Id\": \"{{seq}}\"},"
+                        " \"body\": \"n={{seq}}\"}]"), 0);
+
+    static HlBenchPrepared req;
+    uint64_t rng = 1;
+    ASSERT_EQ(hl_bench_prepare(&s, 5, 0, &rng, &req), 0);
+    ASSERT_STREQ(req.path, "/p/5");
+    ASSERT_EQ(req.body_len, (size_t)3);
+
+    char out[512];
+    int n = hl_bench_format_http(&req, "127.0.0.1", 8080, out, sizeof(out));
+    ASSERT_GT(n, 0);
+    out[n] = '\0';
+    ASSERT_STREQ(out,
+        "POST /p/5 HTTP/1.1\r\nHost: 127.0.0.1:8080\r\nX-Id: 5\r\n"
+        "Content-Type: application/octet-stream\r\nContent-Length: 3\r\n"
+        "\r\nn=5");
+
+    ASSERT_EQ(hl_bench_format_http(&req, "127.0.0.1", 8080, out, 40), -1);
+    hl_bench_script_free(&s);
+}
+
+/* ── In-process ────────────────────────────────────────────────────── */
+
+static int fake_dispatch(void *ctx, const HlBenchPrepared *req, size_t *bytes)
+{
+    (*(int *)ctx)++;
+    *bytes += 10;
+    return strcmp(req->path, "/missing") == 0 ? 404 : 200;
+}
+
+UTEST(bench, inprocess_counts)
+{
+    HlBenchScript s;
+    ASSERT_EQ(parse(&s, "[{\"path\": \"/ok\"}, {\"path\": \"/missing\"}]"), 0);
+
+    HlBenchStats st;
+    ASSERT_EQ(hl_bench_stats_init(&st, s.count), 0);
+    HlBenchConfig cfg = { .requests = 500, .warmup = 20, .seed = 3 };
+    int calls = 0;
+    ASSERT_EQ(hl_bench_run_inprocess(&s, &cfg, fake_dispatch, &calls, &st), 0);
+
+    ASSERT_EQ(calls, 520);
+    ASSERT_EQ(st.requests, (uint64_t)500);
+    ASSERT_EQ(st.errors, (uint64_t)0);
+    ASSERT_EQ(st.bytes, (uint64_t)5000);
+    ASSERT_EQ(st.status[2] + st.status[4], (uint64_t)500);
+    ASSERT_EQ(st.count_by_entry[0], st.status[2]);
+    ASSERT_EQ(st.latency.total, (uint64_t)500);
+    ASSERT_GT(st.elapsed_ns, (int64_t)0);
+
+    hl_bench_stats_free(&st);
+    hl_bench_script_free(&s);
+}
+
+/* ── Loopback ──────────────────────────────────────────────────────── */
+
+UTEST(bench, loopback_keep_alive)
+{
+    TestServer srv;
+    ASSERT_EQ(server_start(&srv), 0);
+
+    HlBenchScript s;
+    ASSERT_EQ(parse(&s, "[{\"path\": \"/ok\"}, {\"path\": \"/chunked\"},"
+                        " {\"method\": \"POST\", \"path\": \"/ok\","
+                        "  \"body\": \"x={{rand}}\"}]"), 0);
+    HlBenchStats st;
+    ASSERT_EQ(hl_bench_stats_init(&st, s.count), 0);
+    HlBenchConfig cfg = { .requests = 400, .warmup = 10,
+                          .connections = 4, .seed = 1 };
+    char err[128] = "";
+    ASSERT_EQ(hl_bench_run_loopback(&s, &cfg, "127.0.0.1", srv.port, &st,
+                                    err, sizeof(err)), 0);
+
+    ASSERT_EQ(st.requests, (uint64_t)400);
+    ASSERT_EQ(st.errors, (uint64_t)0);
+    ASSERT_EQ(st.status[2], (uint64_t)400);
+    ASSERT_GT(st.count_by_entry[1], (uint64_t)0);
+    /* One socket per connection, reused for every request */
+    ASSERT_EQ(srv.accepted, 4);
+
+    hl_bench_stats_free(&st);
+    hl_bench_script_free(&s);
+    server_stop(&srv);
+}
+
+UTEST(bench, loopback_reconnects_on_close)
+{
+    TestServer srv;
+    ASSERT_EQ(server_start(&srv), 0);
+
+    HlBenchScript s;
+    ASSERT_EQ(parse(&s, "[{\"path\": \"/ok\"}, {\"path\": \"/close\"},"
+                        " {\"path\": \"/missing\"}]"), 0);
+    HlBenchStats st;
+    ASSERT_EQ(hl_bench_stats_init(&st, s.count), 0);
+    HlBenchConfig cfg = { .requests = 300, .connections = 2, .seed = 5 };
+    char err[128] = "";
+    ASSERT_EQ(hl_bench_run_loopback(&s, &cfg, "127.0.0.1", srv.port, &st,
+                                    err, sizeof(err)), 0);
+
+    ASSERT_EQ(st.requests, (uint64_t)300);
+    ASSERT_EQ(st.errors, (uint64_t)0);
+    ASSERT_EQ(st.status[2] + st.status[4], (uint64_t)300);
+    ASSERT_GT(srv.accepted, 2);
+
+    hl_bench_stats_free(&st);
+    hl_bench_script_free(&s);
+    server_stop(&srv);
+}
+
+UTEST(bench, loopback_refused)
+{
+    /* A port nothing listens on */
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sin_family = AF_INET;
+    sa.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t sl = sizeof(sa);
+    ASSERT_EQ(bind(fd, (struct sockaddr *)&sa, sizeof(sa)), 0);
+    ASSERT_EQ(getsockname(fd, (struct sockaddr *)&sa, &sl), 0);
+    close(fd);
+
+    HlBenchScript s;
+    hl_bench_script_single(&s, "GET", "/");
+    HlBenchStats st;
+    ASSERT_EQ(hl_bench_stats_init(&st, s.count), 0);
+    HlBenchConfig cfg = { .requests = 10, .connections = 2, .seed = 1 };
+    char err[128] = "";
+    ASSERT_EQ(hl_bench_run_loopback(&s, &cfg, "127.0.0.1", ntohs(sa.sin_port),
+                                    &st, err, sizeof(err)), -1);
+    ASSERT_TRUE(strstr(err, "cannot connect") != NULL);
+
+    hl_bench_stats_free(&st);
+}
+
+/* ── Report ────────────────────────────────────────────────────────── */
+
+UTEST(bench, report_json)
+{
+    HlBenchScript s;
+    ASSERT_EQ(parse(&s, "[{\"path\": \"/ok\"}]"), 0);
+    HlBenchStats st;
+    ASSERT_EQ(hl_bench_stats_init(&st, s.count), 0);
+    HlBenchConfig cfg = { .requests = 50, .seed = 1 };
+    int calls = 0;
+    ASSERT_EQ(hl_bench_run_inprocess(&s, &cfg, fake_dispatch, &calls, &st), 0);
+
+    char buf[4096] = "";
+    FILE *f = tmpfile();
+    ASSERT_TRUE(f != NULL);
+    ASSERT_EQ(hl_bench_report(f, &s, &st, "inprocess", "app", 1), 0);
+    rewind(f);
+    size_t n = fread(buf, 1, sizeof(buf) - 1, f);
+    fclose(f);
+
+    SHArena *arena = sh_arena_create(16384);
+    ShJsonValue *root;
+    ASSERT_TRUE(sh_json_parse(buf, n, arena, &root) == SH_JSON_OK);
+    ASSERT_STREQ(sh_json_as_string(sh_json_get(root, "mode"), ""), "inprocess");
+    ASSERT_EQ(sh_json_as_int(sh_json_get(root, "requests"), 0), 50);
+    ASSERT_EQ(sh_json_as_int(sh_json_get_path(root, "status.2xx"), 0), 50);
+    ASSERT_TRUE(sh_json_get_path(root, "latency_us.p99_9") != NULL);
+    ASSERT_EQ((int)sh_json_array_len(sh_json_get(root, "mix")), 1);
+    sh_arena_free(arena);
+
+    hl_bench_stats_free(&st);
+    hl_bench_script_free(&s);
+}
+
+UTEST_MAIN();
@@ -0,0 +1,102 @@
+/*
+ * test_hdr.c — Tests for the log-linear latency histogram
+ *
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#include "utest.h"
+#include "hull/hdr.h"
+
+#include <stdlib.h>
+
+static HlHdr *new_hdr(void)
+{
+    HlHdr *h = malloc(sizeof(*h));
+    if (h)
+        hl_hdr_init(h);
+    return h;
+}
+
+/* Within the documented 1/128 relative error */
+static int close_to(uint64_t got, uint64_t want)
+{
+    uint64_t diff = got > want ? got - want : want - got;
+    return diff * 128 <= want;
+}
+
+UTEST(hdr, empty)
+{
+    HlHdr *h = new_hdr();
+    ASSERT_TRUE(h != NULL);
+    ASSERT_EQ(hl_hdr_percentile(h, 50.0), (uint64_t)0);
+    ASSERT_EQ(hl_hdr_mean(h), 0.0);
+    free(h);
+}
+
+UTEST(hdr, small_values_exact)
+{
+    HlHdr *h = new_hdr();
+    ASSERT_TRUE(h != NULL);
+    for (uint64_t v = 1; v <= 100; v++)
+        hl_hdr_record(h, v);
+
+    ASSERT_EQ(h->total, (uint64_t)100);
+    ASSERT_EQ(hl_hdr_percentile(h, 0.0), (uint64_t)1);
+    ASSERT_EQ(hl_hdr_percentile(h, 50.0), (uint64_t)50);
+    ASSERT_EQ(hl_hdr_percentile(h, 99.0), (uint64_t)99);
+    ASSERT_EQ(hl_hdr_percentile(h, 100.0), (uint64_t)100);
+    ASSERT_EQ(hl_hdr_mean(h), 50.5);
+    free(h);
+}
+
+UTEST(hdr, large_values_bounded_error)
+{
+    HlHdr *h = new_hdr();
+    ASSERT_TRUE(h != NULL);
+    /* 8 samples, 1 µs .. 10 s in ns */
+    for (uint64_t v = 1000; v <= 10000000000ULL; v *= 10)
+        hl_hdr_record(h, v + 12345);
+
+    ASSERT_TRUE(close_to(hl_hdr_percentile(h, 25.0), 10000 + 12345));
+    ASSERT_TRUE(close_to(hl_hdr_percentile(h, 50.0), 1000000 + 12345));
+    ASSERT_TRUE(close_to(hl_hdr_percentile(h, 75.0), 100000000ULL + 12345));
+    ASSERT_EQ(hl_hdr_percentile(h, 100.0), 10000000000ULL + 12345);
+
+    hl_hdr_record(h, UINT64_MAX);
+    ASSERT_EQ(hl_hdr_percentile(h, 100.0), UINT64_MAX);
+    free(h);
+}
+
+UTEST(hdr, tail_percentile)
+{
+    HlHdr *h = new_hdr();
+    ASSERT_TRUE(h != NULL);
+    for (int i = 0; i < 999; i++)
+        hl_hdr_record(h, 100000);
+    hl_hdr_record(h, 50000000);
+
+    ASSERT_TRUE(close_to(hl_hdr_percentile(h, 99.9), 100000));
+    ASSERT_TRUE(close_to(hl_hdr_percentile(h, 99.95), 50000000));
+    free(h);
+}
+
+UTEST(hdr, merge)
+{
+    HlHdr *a = new_hdr();
+    HlHdr *b = new_hdr();
+    ASSERT_TRUE(a != NULL && b != NULL);
+    for (uint64_t v = 1; v <= 50; v++)
+        hl_hdr_record(a, v);
+    for (uint64_t v = 51; v <= 100; v++)
+        hl_hdr_record(b, v);
+
+    hl_hdr_merge(a, b);
+    ASSERT_EQ(a->total, (uint64_t)100);
+    ASSERT_EQ(a->min, (uint64_t)1);
+    ASSERT_EQ(a->max, (uint64_t)100);
+    ASSERT_EQ(hl_hdr_percentile(a, 75.0), (uint64_t)75);
+    free(a);
+    free(b);
+}
+
+UTEST_MAIN();
@@ -0,0 +1,185 @@
+/*
+ * test_log_sink.c — Tests for the buffered log backend
+ *
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#include "utest.h"
+#include "hull/log_sink.h"
+#include "hull/limits.h"
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+static void setup_log(void)
+{
+    static int done;
+    if (!done) {
+        log_set_quiet(true);
+        log_add_callback(hl_log_sink_callback, NULL, LOG_TRACE);
+        done = 1;
+    }
+    hl_log_sink_set_format(HL_LOG_TEXT);
+}
+
+/* Run lines through a started sink into a temp file; returns its contents */
+static char *capture(HlLogFormat format, void (*emit)(void))
+{
+    char path[] = "/tmp/hull_log_XXXXXX";
+    int fd = mkstemp(path);
+    if (fd < 0)
+        return NULL;
+    unlink(path);
+
+    setup_log();
+    hl_log_sink_set_format(format);
+    if (hl_log_sink_start(fd, HL_LOG_BLOCK) != 0) {
+        close(fd);
+        return NULL;
+    }
+    emit();
+    hl_log_sink_stop();
+    hl_log_sink_set_format(HL_LOG_TEXT);
+
+    off_t size = lseek(fd, 0, SEEK_END);
+    char *buf = malloc((size_t)size + 1);
+    if (buf && pread(fd, buf, (size_t)size, 0) != (ssize_t)size) {
+        free(buf);
+        buf = NULL;
+    }
+    if (buf)
+        buf[size] = '\0';
+    close(fd);
+    return buf;
+}
+
+static void emit_two(void)
+{
+    log_info("hello %d", 42);
+    log_warn("say \"hi\"\nbye");
+}
+
+/* ── Formats ─────────────────────────────────────────────────────── */
+
+UTEST(log_sink, text_format)
+{
+    char *out = capture(HL_LOG_TEXT, emit_two);
+    ASSERT_TRUE(out != NULL);
+    /* "HH:MM:SS INFO  hello 42\n" */
+    ASSERT_EQ(out[2], ':');
+    ASSERT_EQ(strncmp(out + 8, " INFO  hello 42\n", 16), 0);
+    ASSERT_NE(strstr(out, " WARN  say \"hi\"\nbye\n"), NULL);
+    free(out);
+}
+
+UTEST(log_sink, json_format)
+{
+    char *out = capture(HL_LOG_JSON, emit_two);
+    ASSERT_TRUE(out != NULL);
+    ASSERT_EQ(strncmp(out, "{\"ts\":\"", 7), 0);
+    ASSERT_NE(strstr(out, "Z\",\"level\":\"info\",\"msg\":\"hello 42\"}\n"), NULL);
+    ASSERT_NE(strstr(out, "\"level\":\"warn\",\"msg\":\"say \\\"hi\\\"\\nbye\"}\n"),
+              NULL);
+    free(out);
+}
+
+UTEST(log_sink, logfmt_format)
+{
+    char *out = capture(HL_LOG_LOGFMT, emit_two);
+    ASSERT_TRUE(out != NULL);
+    ASSERT_EQ(strncmp(out, "ts=", 3), 0);
+    ASSERT_NE(strstr(out, " level=info msg=\"hello 42\"\n"), NULL);
+    ASSERT_NE(strstr(out, " level=warn msg=\"say \\\"hi\\\"\\nbye\"\n"), NULL);
+    free(out);
+}
+
+static void emit_long(void)
+{
+    char big[HL_LOG_LINE_MAX * 2];
+    memset(big, '"', sizeof(big) - 1);
+    big[sizeof(big) - 1] = '\0';
+    log_info("%s", big);
+}
+
+UTEST(log_sink, long_line_stays_wellformed)
+{
+    char *out = capture(HL_LOG_JSON, emit_long);
+    ASSERT_TRUE(out != NULL);
+    size_t len = strlen(out);
+    ASSERT_LE(len, (size_t)HL_LOG_LINE_MAX);
+    ASSERT_EQ(strcmp(out + len - 3, "\"}\n"), 0);
+    /* Never cut inside an escape: the quote before the close is escaped */
+    ASSERT_EQ(strcmp(out + len - 5, "\\\"\"}\n"), 0);
+    free(out);
+}
+
+UTEST(log_sink, many_lines_in_order)
+{
+    char path[] = "/tmp/hull_log_XXXXXX";
+    int fd = mkstemp(path);
+    ASSERT_NE(fd, -1);
+    unlink(path);
+
+    setup_log();
+    ASSERT_EQ(hl_log_sink_start(fd, HL_LOG_BLOCK), 0);
+    ASSERT_EQ(hl_log_sink_start(fd, HL_LOG_BLOCK), -1);
+    for (int i = 0; i < 20000; i++)
+        log_info("line %d", i);
+    hl_log_sink_stop();
+    hl_log_sink_stop(); /* idempotent */
+    ASSERT_EQ(hl_log_sink_dropped(), (uint64_t)0);
+
+    /* Block policy loses nothing and keeps order */
+    FILE *f = fdopen(fd, "r");
+    ASSERT_TRUE(f != NULL);
+    rewind(f);
+    char line[256];
+    int expect = 0;
+    while (fgets(line, sizeof(line), f)) {
+        int got = -1;
+        const char *p = strstr(line, "line ");
+        ASSERT_TRUE(p != NULL);
+        got = atoi(p + 5);
+        ASSERT_EQ(got, expect);
+        expect++;
+    }
+    ASSERT_EQ(expect, 20000);
+    fclose(f);
+}
+
+/* ── Backpressure ────────────────────────────────────────────────── */
+
+static void *drain_pipe(void *arg)
+{
+    int fd = *(int *)arg;
+    char buf[4096];
+    while (read(fd, buf, sizeof(buf)) > 0)
+        ;
+    return NULL;
+}
+
+UTEST(log_sink, drop_policy_never_blocks)
+{
+    int pfd[2];
+    ASSERT_EQ(pipe(pfd), 0);
+
+    setup_log();
+    /* Nobody reads the pipe yet: the flusher stalls in write() */
+    ASSERT_EQ(hl_log_sink_start(pfd[1], HL_LOG_DROP), 0);
+    for (int i = 0; i < 50000; i++)
+        log_info("filler line %d with some padding to make it longer", i);
+    uint64_t dropped = hl_log_sink_dropped();
+    ASSERT_GT(dropped, (uint64_t)0);
+
+    pthread_t reader;
+    ASSERT_EQ(pthread_create(&reader, NULL, drain_pipe, &pfd[0]), 0);
+    hl_log_sink_stop();
+    close(pfd[1]);
+    pthread_join(reader, NULL);
+    close(pfd[0]);
+}
+
+UTEST_MAIN();
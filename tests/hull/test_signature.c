@@ -8,6 +8,7 @@
 #include "hull/signature.h"
 #include "hull/vfs.h"
 #include "hull/cap/crypto.h"
+#include "hull/limits.h"
 
 #include <stdio.h>
 #include <string.h>
@@ -587,6 +588,93 @@ UTEST(hl_sig, canary_detection)
     ASSERT_EQ(memcmp(found_integrity, expected_integrity, 32), 0);
 }
 
+/* ── Batched verification ─────────────────────────────────────────── */
+
+/* Enough files to cross an HL_SIG_HASH_BATCH boundary on the fs path */
+enum { BATCH_FILES = HL_SIG_HASH_BATCH + 3 };
+
+static char batch_names[BATCH_FILES + 1][32];
+static char batch_hashes[BATCH_FILES + 1][65];
+static char batch_vfs_names[BATCH_FILES + 1][40];
+static unsigned char batch_bodies[BATCH_FILES][64];
+
+UTEST(hl_sig, verify_files_batched)
+{
+    char dir[512];
+    snprintf(dir, sizeof(dir), "%s/batch", test_dir);
+    ASSERT_EQ(mkdir(dir, 0755), 0);
+
+    /* One extra slot: a ".lua" alias resolving to the same VFS entry
+     * as the last file, plus room for an unsigned extra file. */
+    HlEntry entries[BATCH_FILES + 2];
+    HlSigFileEntry sig_entries[BATCH_FILES + 1];
+    memset(entries, 0, sizeof(entries));
+
+    for (int i = 0; i < BATCH_FILES; i++) {
+        size_t len = 1 + (size_t)i % sizeof(batch_bodies[i]);
+        for (size_t j = 0; j < len; j++)
+            batch_bodies[i][j] = (unsigned char)(i + j * 31);
+
+        snprintf(batch_names[i], sizeof(batch_names[i]), "f%04d", i);
+        char path[600];
+        snprintf(path, sizeof(path), "%s/%s", dir, batch_names[i]);
+        FILE *f = fopen(path, "wb");
+        ASSERT_TRUE(f != NULL);
+        fwrite(batch_bodies[i], 1, len, f);
+        fclose(f);
+
+        uint8_t hash[32];
+        hl_cap_crypto_sha256(batch_bodies[i], len, hash);
+        hex_encode(hash, 32, batch_hashes[i]);
+        sig_entries[i].name = batch_names[i];
+        sig_entries[i].hash_hex = batch_hashes[i];
+
+        snprintf(batch_vfs_names[i], sizeof(batch_vfs_names[i]),
+                 "./%s", batch_names[i]);
+        entries[i].name = batch_vfs_names[i];
+        entries[i].data = batch_bodies[i];
+        entries[i].len = (unsigned int)len;
+    }
+
+    /* "fNNNN.lua" falls back to "./fNNNN" — two signature entries, one
+     * VFS entry; both must be hashed and the entry counted as seen. */
+    int last = BATCH_FILES - 1;
+    snprintf(batch_names[BATCH_FILES], sizeof(batch_names[BATCH_FILES]),
+             "%s.lua", batch_names[last]);
+    memcpy(batch_hashes[BATCH_FILES], batch_hashes[last], 65);
+    sig_entries[BATCH_FILES].name = batch_names[BATCH_FILES];
+    sig_entries[BATCH_FILES].hash_hex = batch_hashes[BATCH_FILES];
+
+    HlSignature sig;
+    memset(&sig, 0, sizeof(sig));
+    sig.entries = sig_entries;
+    sig.entry_count = BATCH_FILES + 1;
+
+    HlVfs vfs;
+    hl_vfs_init(&vfs, entries, NULL);
+    ASSERT_EQ(hl_sig_verify_files_embedded(&sig, &vfs), 0);
+
+    /* The alias has no file of its own on disk */
+    sig.entry_count = BATCH_FILES;
+    ASSERT_EQ(hl_sig_verify_files_fs(&sig, dir), 0);
+
+    /* A mismatch in the last (partial) batch must still be caught */
+    batch_hashes[last][0] ^= 1;
+    ASSERT_EQ(hl_sig_verify_files_fs(&sig, dir), -1);
+    sig.entry_count = BATCH_FILES + 1;
+    ASSERT_EQ(hl_sig_verify_files_embedded(&sig, &vfs), -1);
+    batch_hashes[last][0] ^= 1;
+
+    /* An embedded module the signature does not cover is rejected */
+    snprintf(batch_vfs_names[BATCH_FILES], sizeof(batch_vfs_names[0]),
+             "./zz_extra");
+    entries[BATCH_FILES].name = batch_vfs_names[BATCH_FILES];
+    entries[BATCH_FILES].data = batch_bodies[0];
+    entries[BATCH_FILES].len = 1;
+    hl_vfs_init(&vfs, entries, NULL);
+    ASSERT_EQ(hl_sig_verify_files_embedded(&sig, &vfs), -1);
+}
+
 /* ── Cleanup ──────────────────────────────────────────────────────── */
 
 /* Portable recursive delete (no shell dependency) */
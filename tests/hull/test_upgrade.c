@@ -0,0 +1,184 @@
+/*
+ * test_upgrade.c — Tests for the SIGUSR2 listening-socket handoff
+ *
+ * The test binary plays both sides: the test process arms the helper,
+ * and the helper re-executes this binary with --as-new <mode> as the
+ * "new" server.
+ *
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#include "utest.h"
+#include "hull/upgrade.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+static const char *self_path;
+static volatile sig_atomic_t got_term;
+
+static void on_term(int sig)
+{
+    (void)sig;
+    got_term = 1;
+}
+
+/* Listening socket on an ephemeral loopback port */
+static int listen_any(int *port)
+{
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0)
+        return -1;
+    struct sockaddr_in sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sin_family = AF_INET;
+    sa.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t len = sizeof(sa);
+    if (bind(fd, (struct sockaddr *)&sa, sizeof(sa)) != 0 ||
+        listen(fd, 16) != 0 ||
+        getsockname(fd, (struct sockaddr *)&sa, &len) != 0) {
+        close(fd);
+        return -1;
+    }
+    *port = ntohs(sa.sin_port);
+    return fd;
+}
+
+/* Wait up to ms for the helper's SIGTERM */
+static int wait_term(int ms)
+{
+    for (int i = 0; i < ms / 10 && !got_term; i++) {
+        struct timespec ts = { 0, 10 * 1000000L };
+        nanosleep(&ts, NULL);
+    }
+    return got_term;
+}
+
+/* Arm with argv = self --as-new mode, send SIGUSR2, wait for the outcome */
+static int upgrade_to(const char *mode, int listen_fd, int timeout_ms,
+                      int wait_ms)
+{
+    char *args[] = { (char *)self_path, "--as-new", (char *)mode, NULL };
+    struct sigaction sa, old;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = on_term;
+    sigemptyset(&sa.sa_mask);
+    sigaction(SIGTERM, &sa, &old);
+
+    got_term = 0;
+    int rc = -1;
+    if (hl_upgrade_arm(args, &listen_fd, 1, timeout_ms) == 0) {
+        kill(getpid(), SIGUSR2);
+        rc = wait_term(wait_ms);
+        hl_upgrade_disarm();
+    }
+    sigaction(SIGTERM, &old, NULL);
+    return rc;
+}
+
+/* ── New process side ──────────────────────────────────────────────── */
+
+static int run_as_new(const char *mode)
+{
+    if (strcmp(mode, "fail") == 0)
+        return 3;                       /* e.g. a migration failed */
+    if (strcmp(mode, "hang") == 0) {
+        sleep(30);                      /* killed by the helper */
+        return 4;
+    }
+
+    int fds[HL_UPGRADE_MAX_FDS];
+    if (hl_upgrade_receive(fds, HL_UPGRADE_MAX_FDS) != 1)
+        return 2;
+    hl_upgrade_ready();
+
+    int c = accept(fds[0], NULL, NULL);
+    if (c < 0)
+        return 5;
+    ssize_t n = write(c, "new\n", 4);
+    close(c);
+    return n == 4 ? 0 : 6;
+}
+
+/* ── Handoff ───────────────────────────────────────────────────────── */
+
+UTEST(upgrade, new_process_takes_over_socket)
+{
+    int port;
+    int fd = listen_any(&port);
+    ASSERT_GE(fd, 0);
+
+    ASSERT_EQ(upgrade_to("serve", fd, 5000, 5000), 1);
+
+    /* Same port, answered by the new process */
+    int c = socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sin_family = AF_INET;
+    sa.sin_port = htons((uint16_t)port);
+    sa.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    ASSERT_EQ(connect(c, (struct sockaddr *)&sa, sizeof(sa)), 0);
+    char buf[8] = {0};
+    ASSERT_EQ(read(c, buf, sizeof(buf) - 1), 4);
+    ASSERT_STREQ(buf, "new\n");
+
+    close(c);
+    close(fd);
+}
+
+UTEST(upgrade, failed_start_keeps_old)
+{
+    int port;
+    int fd = listen_any(&port);
+    ASSERT_GE(fd, 0);
+
+    ASSERT_EQ(upgrade_to("fail", fd, 5000, 1000), 0);
+
+    close(fd);
+}
+
+UTEST(upgrade, ready_timeout_keeps_old)
+{
+    int port;
+    int fd = listen_any(&port);
+    ASSERT_GE(fd, 0);
+
+    ASSERT_EQ(upgrade_to("hang", fd, 200, 1000), 0);
+
+    close(fd);
+}
+
+/* ── Receive ───────────────────────────────────────────────────────── */
+
+UTEST(upgrade, not_an_upgrade)
+{
+    unsetenv(HL_UPGRADE_ENV);
+    int fds[HL_UPGRADE_MAX_FDS];
+    ASSERT_EQ(hl_upgrade_receive(fds, HL_UPGRADE_MAX_FDS), 0);
+    hl_upgrade_ready();     /* no-op */
+}
+
+UTEST(upgrade, bad_channel)
+{
+    int fds[HL_UPGRADE_MAX_FDS];
+    setenv(HL_UPGRADE_ENV, "abc", 1);
+    ASSERT_EQ(hl_upgrade_receive(fds, HL_UPGRADE_MAX_FDS), -1);
+    ASSERT_TRUE(getenv(HL_UPGRADE_ENV) == NULL);
+}
+
+UTEST_STATE();
+
+int main(int argc, const char *const argv[])
+{
+    if (argc == 3 && strcmp(argv[1], "--as-new") == 0)
+        return run_as_new(argv[2]);
+    self_path = argv[0];
+    return utest_main(argc, argv);
+}
@@ -28,6 +28,14 @@ static const HlEntry empty_entries[] = {
     { 0, 0, 0 }
 };
 
+/* Source entries with precompiled companions ("<name>.luac") */
+static const HlEntry bytecode_entries[] = {
+    { "./app",            (const unsigned char *)"app_code",  8 },
+    { "./app.luac",       (const unsigned char *)"\x1bLua",   4 },
+    { "./routes",         (const unsigned char *)"routes",    6 },
+    { 0, 0, 0 }
+};
+
 /* ── hl_vfs_init ──────────────────────────────────────────────────── */
 
 UTEST(vfs, init_counts_entries)
@@ -97,6 +105,40 @@ UTEST(vfs, find_empty_vfs)
     ASSERT_EQ(hl_vfs_find(&vfs, "./app"), NULL);
 }
 
+/* ── hl_vfs_find_suffixed ─────────────────────────────────────────── */
+
+UTEST(vfs, find_suffixed_found)
+{
+    HlVfs vfs;
+    hl_vfs_init(&vfs, bytecode_entries, NULL);
+
+    const HlEntry *e = hl_vfs_find_suffixed(&vfs, "./app", ".luac");
+    ASSERT_NE(e, NULL);
+    ASSERT_STREQ(e->name, "./app.luac");
+    ASSERT_EQ(e->len, 4u);
+}
+
+UTEST(vfs, find_suffixed_missing_companion)
+{
+    HlVfs vfs;
+    hl_vfs_init(&vfs, bytecode_entries, NULL);
+
+    ASSERT_EQ(hl_vfs_find_suffixed(&vfs, "./routes", ".luac"), NULL);
+    ASSERT_EQ(hl_vfs_find_suffixed(&vfs, NULL, ".luac"), NULL);
+    ASSERT_EQ(hl_vfs_find_suffixed(&vfs, "./app", NULL), NULL);
+}
+
+UTEST(vfs, find_suffixed_name_too_long)
+{
+    HlVfs vfs;
+    hl_vfs_init(&vfs, bytecode_entries, NULL);
+
+    char name[2048];
+    memset(name, 'a', sizeof(name) - 1);
+    name[sizeof(name) - 1] = '\0';
+    ASSERT_EQ(hl_vfs_find_suffixed(&vfs, name, ".luac"), NULL);
+}
+
 /* ── hl_vfs_prefix ────────────────────────────────────────────────── */
 
 UTEST(vfs, prefix_multiple_matches)
@@ -0,0 +1,155 @@
+/*
+ * test_watch.c — Tests for the hull dev file watcher
+ *
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#include "utest.h"
+#include "hull/watch.h"
+
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static void write_file(const char *dir, const char *name, const char *text)
+{
+    char path[PATH_MAX];
+    snprintf(path, sizeof(path), "%s/%s", dir, name);
+    FILE *f = fopen(path, "w");
+    if (f) {
+        fputs(text, f);
+        fclose(f);
+    }
+}
+
+static void make_dir(const char *dir, const char *name)
+{
+    char path[PATH_MAX];
+    snprintf(path, sizeof(path), "%s/%s", dir, name);
+    mkdir(path, 0755);
+}
+
+static void remove_tree(const char *dir)
+{
+    char cmd[PATH_MAX + 16];
+    snprintf(cmd, sizeof(cmd), "rm -rf '%s'", dir);
+    if (system(cmd) != 0)
+        fprintf(stderr, "cleanup of %s failed\n", dir);
+}
+
+/* Temp app dir with app.lua and one migration, watched by w */
+static int setup(char *dir, size_t dir_size, HlWatch *w)
+{
+    snprintf(dir, dir_size, "/tmp/hull_watch_XXXXXX");
+    if (!mkdtemp(dir))
+        return -1;
+    write_file(dir, "app.lua", "-- app\n");
+    make_dir(dir, "migrations");
+    write_file(dir, "migrations/001_init.sql", "CREATE TABLE t (x);\n");
+    return hl_watch_open(w, dir);
+}
+
+static void teardown(const char *dir, HlWatch *w)
+{
+    hl_watch_close(w);
+    remove_tree(dir);
+}
+
+/* ── Backend ───────────────────────────────────────────────────────── */
+
+UTEST(watch, uses_kernel_events)
+{
+    char dir[64];
+    HlWatch w;
+    ASSERT_EQ(setup(dir, sizeof(dir), &w), 0);
+
+#if defined(__linux__)
+    ASSERT_STREQ(w.backend, "inotify");
+#elif defined(__APPLE__) || defined(__FreeBSD__) || defined(__OpenBSD__)
+    ASSERT_STREQ(w.backend, "kqueue");
+#endif
+    ASSERT_EQ(hl_watch_wait(&w, 50, 10), HL_WATCH_NONE);
+
+    teardown(dir, &w);
+}
+
+/* ── Classification ────────────────────────────────────────────────── */
+
+UTEST(watch, code_change)
+{
+    char dir[64];
+    HlWatch w;
+    ASSERT_EQ(setup(dir, sizeof(dir), &w), 0);
+
+    write_file(dir, "app.lua", "-- edited\n");
+    ASSERT_EQ(hl_watch_wait(&w, 2000, 50), HL_WATCH_CODE);
+
+    teardown(dir, &w);
+}
+
+UTEST(watch, migration_needs_restart)
+{
+    char dir[64];
+    HlWatch w;
+    ASSERT_EQ(setup(dir, sizeof(dir), &w), 0);
+
+    write_file(dir, "migrations/002_more.sql", "CREATE TABLE u (y);\n");
+    ASSERT_EQ(hl_watch_wait(&w, 2000, 50), HL_WATCH_RESTART);
+
+    teardown(dir, &w);
+}
+
+UTEST(watch, ignores_other_files)
+{
+    char dir[64];
+    HlWatch w;
+    ASSERT_EQ(setup(dir, sizeof(dir), &w), 0);
+
+    write_file(dir, "notes.txt", "todo\n");
+    make_dir(dir, "node_modules");
+    write_file(dir, "node_modules/x.js", "//\n");
+    make_dir(dir, ".git");
+    write_file(dir, ".git/hook.lua", "--\n");
+    ASSERT_EQ(hl_watch_wait(&w, 300, 50), HL_WATCH_NONE);
+
+    teardown(dir, &w);
+}
+
+UTEST(watch, new_directory_is_watched)
+{
+    char dir[64];
+    HlWatch w;
+    ASSERT_EQ(setup(dir, sizeof(dir), &w), 0);
+
+    make_dir(dir, "lib");
+    ASSERT_EQ(hl_watch_wait(&w, 300, 50), HL_WATCH_NONE);
+
+    write_file(dir, "lib/util.lua", "return {}\n");
+    ASSERT_EQ(hl_watch_wait(&w, 2000, 50), HL_WATCH_CODE);
+
+    teardown(dir, &w);
+}
+
+/* ── Debounce ──────────────────────────────────────────────────────── */
+
+UTEST(watch, burst_reported_once)
+{
+    char dir[64];
+    HlWatch w;
+    ASSERT_EQ(setup(dir, sizeof(dir), &w), 0);
+
+    for (int i = 0; i < 20; i++)
+        write_file(dir, "app.lua", "-- save\n");
+    write_file(dir, "migrations/003_late.sql", "--\n");
+
+    /* One report for the whole burst, at its strongest kind */
+    ASSERT_EQ(hl_watch_wait(&w, 2000, 100), HL_WATCH_RESTART);
+    ASSERT_EQ(hl_watch_wait(&w, 200, 50), HL_WATCH_NONE);
+
+    teardown(dir, &w);
+}
+
+UTEST_MAIN();
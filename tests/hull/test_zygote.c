@@ -0,0 +1,137 @@
+/*
+ * test_zygote.c — Tests for fork-from-warm zygote helpers
+ *
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#include "utest.h"
+#include "hull/zygote.h"
+
+#include <signal.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+typedef struct {
+    int  value;
+    char tag[16];
+} Result;
+
+/* State set up in the parent before forking — the "warm" heap */
+static int warm_counter;
+
+static int child_reads_warm_state(void *ctx, void *result, size_t size)
+{
+    (void)ctx;
+    (void)size;
+    Result *r = result;
+    r->value = warm_counter;
+    strcpy(r->tag, "warm");
+    return 0;
+}
+
+static int child_mutates_state(void *ctx, void *result, size_t size)
+{
+    (void)result;
+    (void)size;
+    int *p = ctx;
+    *p = 999;
+    warm_counter = 999;
+    return 0;
+}
+
+static int child_exit_code(void *ctx, void *result, size_t size)
+{
+    (void)result;
+    (void)size;
+    return *(int *)ctx;
+}
+
+static int child_crashes(void *ctx, void *result, size_t size)
+{
+    (void)ctx;
+    (void)result;
+    (void)size;
+    raise(SIGKILL);
+    return 0;
+}
+
+static int child_exits_early(void *ctx, void *result, size_t size)
+{
+    (void)ctx;
+    (void)result;
+    (void)size;
+    _exit(0);
+}
+
+static int child_pid(void *ctx, void *result, size_t size)
+{
+    (void)ctx;
+    (void)size;
+    *(pid_t *)result = getpid();
+    return 0;
+}
+
+/* ── hl_zygote_run ────────────────────────────────────────────────── */
+
+UTEST(zygote, child_sees_warm_state)
+{
+    warm_counter = 42;
+    Result r;
+    memset(&r, 0, sizeof(r));
+    int rc = hl_zygote_run(child_reads_warm_state, NULL, &r, sizeof(r));
+    ASSERT_EQ(rc, 0);
+    ASSERT_EQ(r.value, 42);
+    ASSERT_STREQ(r.tag, "warm");
+}
+
+UTEST(zygote, child_mutations_do_not_leak)
+{
+    warm_counter = 7;
+    int local = 7;
+    int rc = hl_zygote_run(child_mutates_state, &local, NULL, 0);
+    ASSERT_EQ(rc, 0);
+    ASSERT_EQ(local, 7);
+    ASSERT_EQ(warm_counter, 7);
+}
+
+UTEST(zygote, exit_status_propagates)
+{
+    int code = 3;
+    ASSERT_EQ(hl_zygote_run(child_exit_code, &code, NULL, 0), 3);
+    code = 0;
+    ASSERT_EQ(hl_zygote_run(child_exit_code, &code, NULL, 0), 0);
+}
+
+UTEST(zygote, killed_child_reports_error)
+{
+    Result r;
+    int rc = hl_zygote_run(child_crashes, NULL, &r, sizeof(r));
+    ASSERT_EQ(rc, -1);
+}
+
+UTEST(zygote, short_result_reports_error)
+{
+    Result r;
+    int rc = hl_zygote_run(child_exits_early, NULL, &r, sizeof(r));
+    ASSERT_EQ(rc, -1);
+}
+
+/* ── hl_zygote_spawn / hl_zygote_wait ─────────────────────────────── */
+
+UTEST(zygote, concurrent_children)
+{
+    HlZygoteChild kids[4];
+    for (int i = 0; i < 4; i++)
+        ASSERT_EQ(hl_zygote_spawn(&kids[i], child_pid, NULL, sizeof(pid_t)), 0);
+
+    for (int i = 0; i < 4; i++) {
+        pid_t expected = kids[i].pid;
+        pid_t got = 0;
+        ASSERT_EQ(hl_zygote_wait(&kids[i], &got, sizeof(got)), 0);
+        ASSERT_EQ(got, expected);
+        ASSERT_NE(got, getpid());
+    }
+}
+
+UTEST_MAIN();